@@ -31,6 +31,8 @@
 
 #include "itti_msg.hpp"
 
+#include <functional>
+
 class itti_async_shell_cmd : public itti_msg {
  public:
   itti_async_shell_cmd(
@@ -41,19 +43,23 @@ class itti_async_shell_cmd : public itti_msg {
         system_command(system_cmd),
         is_abort_on_error(is_abort_on_error),
         src_file(src_file),
-        src_line(src_line) {}
+        src_line(src_line),
+        job() {}
   itti_async_shell_cmd(const itti_async_shell_cmd& i)
       : itti_msg(i),
         system_command(i.system_command),
         is_abort_on_error(i.is_abort_on_error),
         src_file(i.src_file),
-        src_line(i.src_line) {}
+        src_line(i.src_line),
+        job(i.job) {}
   const char* get_msg_name() { return typeid(itti_msg_ping).name(); };
   std::string system_command;
   bool is_abort_on_error;
   // debug
   std::string src_file;
   int src_line;
+  // Run instead of system_command if set, system_command describes it
+  std::function<int()> job;
 };
 
 #endif /* FILE_ITTI_ASYNC_SHELL_CMD_SEEN */
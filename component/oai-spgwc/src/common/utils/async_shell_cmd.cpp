@@ -67,7 +67,9 @@ void async_cmd_task(void* args_p) {
       case ASYNC_SHELL_CMD:
         if (itti_async_shell_cmd* to =
                 dynamic_cast<itti_async_shell_cmd*>(msg)) {
-          int rc = system((const char*) to->system_command.c_str());
+          int rc = (to->job) ?
+                       to->job() :
+                       system((const char*) to->system_command.c_str());
 
           if (rc) {
             Logger::async_cmd().error(
@@ -137,3 +139,22 @@ int async_shell_cmd::run_command(
   }
   return RETURNok;
 }
+
+//------------------------------------------------------------------------------
+int async_shell_cmd::run_job(
+    const task_id_t sender_itti_task, const bool is_abort_on_error,
+    const char* src_file, const int src_line, const std::string& job_name,
+    const std::function<int()>& job) {
+  std::shared_ptr<itti_async_shell_cmd> msg =
+      std::make_shared<itti_async_shell_cmd>(
+          sender_itti_task, TASK_ASYNC_SHELL_CMD, job_name, is_abort_on_error,
+          src_file, src_line);
+  msg->job = job;
+  int ret  = itti_inst->send_msg(msg);
+  if (RETURNok != ret) {
+    Logger::async_cmd().error(
+        "Could not send ITTI message to task TASK_ASYNC_SHELL_CMD");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
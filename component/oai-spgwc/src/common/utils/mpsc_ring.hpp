@@ -0,0 +1,119 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file mpsc_ring.hpp
+  \brief Bounded lock-free queue, many producers and a single consumer
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_MPSC_RING_HPP_SEEN
+#define FILE_MPSC_RING_HPP_SEEN
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace util {
+
+// Array of cells with a sequence number each (D. Vyukov's bounded queue).
+// A producer claims a cell by moving tail_ forward with a CAS, fills it, then
+// publishes it by its sequence number. The consumer owns head_ and needs no
+// atomic read-modify-write. The size is rounded up to a power of 2.
+template <class T>
+class mpsc_ring {
+ private:
+  typedef struct cell_s {
+    std::atomic<uint64_t> seq;
+    T value;
+  } cell_t;
+
+  const uint64_t mask_;
+  std::unique_ptr<cell_t[]> cells_;
+  alignas(64) std::atomic<uint64_t> tail_;
+  alignas(64) uint64_t head_;
+
+  static uint64_t ceil_pow2(const std::size_t n) {
+    uint64_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+ public:
+  explicit mpsc_ring(const std::size_t size)
+      : mask_(ceil_pow2(size) - 1),
+        cells_(new cell_t[mask_ + 1]),
+        tail_(0),
+        head_(0) {
+    for (uint64_t i = 0; i <= mask_; i++) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  mpsc_ring(const mpsc_ring&) = delete;
+  void operator=(const mpsc_ring&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Any thread. Return false if the ring is full, v is then left untouched.
+  bool push(T&& v) {
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell_t& c          = cells_[pos & mask_];
+      const uint64_t seq = c.seq.load(std::memory_order_acquire);
+      const int64_t dif  = (int64_t)(seq - pos);
+      if (dif == 0) {
+        if (tail_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          c.value = std::move(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Consumer thread only. A cell claimed but not published yet stops the
+  // consumer, the cells behind it are seen once it is published.
+  bool pop(T& v) {
+    cell_t& c = cells_[head_ & mask_];
+    if (c.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+    v = std::move(c.value);
+    c.seq.store(head_ + mask_ + 1, std::memory_order_release);
+    head_++;
+    return true;
+  }
+
+  // Consumer thread only
+  bool empty() const {
+    return cells_[head_ & mask_].seq.load(std::memory_order_acquire) !=
+           head_ + 1;
+  }
+};
+
+}  // namespace util
+#endif /* FILE_MPSC_RING_HPP_SEEN */
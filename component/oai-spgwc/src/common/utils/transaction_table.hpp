@@ -0,0 +1,300 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file transaction_table.hpp
+  \brief Pending procedures of a PFCP or GTPv2-C stack, with their
+         retransmission and cleanup timers
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_TRANSACTION_TABLE_HPP_SEEN
+#define FILE_TRANSACTION_TABLE_HPP_SEEN
+
+#include "timing_wheel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Procedures are keyed by sequence number and spread over shards, each shard
+// has its lock, its hash tables and its timing wheel, so that the UDP
+// receive threads and the ITTI task of a stack only contend on a same shard.
+// The transaction ids given to the applications are indexed in shards of
+// their own. A shard lock is never held while another one is taken.
+// One thread per table moves the wheels forward every tick, retransmits the
+// requests not answered (T1/T3) and gives up after max_retries, then deletes
+// the procedures whose lifetime expired. The callbacks are called from this
+// thread without any lock held.
+// PROC must have a uint8_t retry_count member.
+template <class PROC>
+class transaction_table {
+ public:
+  typedef std::function<void(const PROC&)> callback_t;
+
+ private:
+#define TRANSACTION_TABLE_TICK_MS 10
+#define TRANSACTION_TABLE_DEFAULT_SHARDS 16
+
+  typedef struct entry_s {
+    PROC proc;
+    uint64_t trxn_id;
+    uint64_t retry_timer;
+    uint64_t cleanup_timer;
+  } entry_t;
+
+  typedef struct shard_s {
+    std::mutex m;
+    std::unordered_map<uint32_t, entry_t> procs;
+    timing_wheel wheel;
+  } shard_t;
+
+  typedef struct trxn_shard_s {
+    std::mutex m;
+    std::unordered_map<uint64_t, uint32_t> seq_nums;
+  } trxn_shard_t;
+
+  // Cookies of the timers
+#define TRANSACTION_TABLE_RETRY_TIMER 0
+#define TRANSACTION_TABLE_CLEANUP_TIMER 1
+
+  const std::size_t mask_;
+  std::unique_ptr<shard_t[]> shards_;
+  std::unique_ptr<trxn_shard_t[]> trxn_shards_;
+  uint32_t retry_ticks_;
+  uint8_t max_retries_;
+  callback_t retransmit_;
+  callback_t give_up_;
+  const std::chrono::steady_clock::time_point epoch_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+
+  shard_t& shard(const uint32_t seq_num) {
+    return shards_[seq_num & mask_];
+  }
+  trxn_shard_t& trxn_shard(const uint64_t trxn_id) {
+    return trxn_shards_[(trxn_id ^ (trxn_id >> 32)) & mask_];
+  }
+
+  uint64_t now_ticks() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - epoch_)
+               .count() /
+           TRANSACTION_TABLE_TICK_MS;
+  }
+  static uint64_t ms_to_ticks(const uint32_t ms) {
+    return (ms + TRANSACTION_TABLE_TICK_MS - 1) / TRANSACTION_TABLE_TICK_MS;
+  }
+
+  void erase_trxn_id(const uint64_t trxn_id) {
+    trxn_shard_t& t = trxn_shard(trxn_id);
+    std::unique_lock<std::mutex> lt(t.m);
+    t.seq_nums.erase(trxn_id);
+  }
+
+  void expire(shard_t& s, const uint64_t now) {
+    std::vector<uint64_t> expired              = {};
+    std::vector<std::pair<bool, PROC>> to_call = {};
+    std::vector<uint64_t> to_forget            = {};
+    {
+      std::unique_lock<std::mutex> ls(s.m);
+      s.wheel.advance(now, expired);
+      for (auto cookie : expired) {
+        auto it = s.procs.find((uint32_t)(cookie >> 1));
+        if (it == s.procs.end()) continue;
+        entry_t& e = it->second;
+        if ((cookie & 1) == TRANSACTION_TABLE_CLEANUP_TIMER) {
+          s.wheel.stop(e.retry_timer);
+          to_forget.push_back(e.trxn_id);
+          s.procs.erase(it);
+        } else if (e.proc.retry_count < max_retries_) {
+          e.proc.retry_count++;
+          e.retry_timer = s.wheel.start(
+              s.wheel.now() + retry_ticks_,
+              (cookie & ~1ULL) | TRANSACTION_TABLE_RETRY_TIMER);
+          to_call.push_back(std::make_pair(true, e.proc));
+        } else {
+          e.retry_timer = timing_wheel::null_timer;
+          to_call.push_back(std::make_pair(false, e.proc));
+        }
+      }
+    }
+    for (auto trxn_id : to_forget) {
+      erase_trxn_id(trxn_id);
+    }
+    for (auto& c : to_call) {
+      if (c.first) {
+        retransmit_(c.second);
+      } else {
+        give_up_(c.second);
+      }
+    }
+  }
+
+  void run() {
+    uint64_t tick = now_ticks();
+    while (running_.load(std::memory_order_acquire)) {
+      tick++;
+      std::this_thread::sleep_until(
+          epoch_ + std::chrono::milliseconds(tick * TRANSACTION_TABLE_TICK_MS));
+      const uint64_t now = now_ticks();
+      for (std::size_t i = 0; i <= mask_; i++) {
+        expire(shards_[i], now);
+      }
+      tick = std::max(tick, now);
+    }
+  }
+
+ public:
+  // num_shards is rounded up to a power of 2
+  explicit transaction_table(
+      const std::size_t num_shards = TRANSACTION_TABLE_DEFAULT_SHARDS)
+      : mask_(ceil_pow2(num_shards) - 1),
+        shards_(new shard_t[mask_ + 1]),
+        trxn_shards_(new trxn_shard_t[mask_ + 1]),
+        retry_ticks_(0),
+        max_retries_(0),
+        retransmit_(),
+        give_up_(),
+        epoch_(std::chrono::steady_clock::now()),
+        running_(false),
+        thread_() {}
+
+  transaction_table(const transaction_table&) = delete;
+  void operator=(const transaction_table&) = delete;
+
+  ~transaction_table() {
+    running_.store(false, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+  }
+
+  static std::size_t ceil_pow2(const std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  // thread_init is run first by the timer thread (affinity, priority)
+  void start(
+      const uint32_t retry_ms, const uint8_t max_retries,
+      const callback_t& retransmit, const callback_t& give_up,
+      const std::function<void()>& thread_init) {
+    retry_ticks_ = ms_to_ticks(retry_ms);
+    max_retries_ = max_retries;
+    retransmit_  = retransmit;
+    give_up_     = give_up;
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread([this, thread_init]() {
+      thread_init();
+      run();
+    });
+  }
+
+  // A request sent is retransmitted until answered (retry), a request
+  // received is not (no retry). Return false if seq_num is already pending.
+  bool insert(
+      const uint32_t seq_num, const uint64_t trxn_id, const PROC& proc,
+      const bool retry, const uint32_t lifetime_ms) {
+    shard_t& s = shard(seq_num);
+    {
+      std::unique_lock<std::mutex> ls(s.m);
+      auto r = s.procs.emplace(seq_num, entry_t{proc, trxn_id, 0, 0});
+      if (not r.second) return false;
+      entry_t& e = r.first->second;
+      // The timer thread may lag behind, it catches up later
+      const uint64_t now = std::max(now_ticks(), s.wheel.now());
+      const uint64_t key = ((uint64_t) seq_num) << 1;
+      e.cleanup_timer    = s.wheel.start(
+          now + ms_to_ticks(lifetime_ms),
+          key | TRANSACTION_TABLE_CLEANUP_TIMER);
+      if (retry) {
+        e.retry_timer = s.wheel.start(
+            now + retry_ticks_, key | TRANSACTION_TABLE_RETRY_TIMER);
+      }
+    }
+    trxn_shard_t& t = trxn_shard(trxn_id);
+    std::unique_lock<std::mutex> lt(t.m);
+    t.seq_nums[trxn_id] = seq_num;
+    return true;
+  }
+
+  // Run f(PROC&, bool& stop_retry) under the shard lock, return false if
+  // seq_num is not pending
+  template <class F>
+  bool update(const uint32_t seq_num, F f) {
+    shard_t& s = shard(seq_num);
+    std::unique_lock<std::mutex> ls(s.m);
+    auto it = s.procs.find(seq_num);
+    if (it == s.procs.end()) return false;
+    entry_t& e      = it->second;
+    bool stop_retry = false;
+    f(e.proc, stop_retry);
+    if ((stop_retry) && (e.retry_timer != timing_wheel::null_timer)) {
+      s.wheel.stop(e.retry_timer);
+      e.retry_timer = timing_wheel::null_timer;
+    }
+    return true;
+  }
+
+  bool find_seq_num(const uint64_t trxn_id, uint32_t& seq_num) {
+    trxn_shard_t& t = trxn_shard(trxn_id);
+    std::unique_lock<std::mutex> lt(t.m);
+    auto it = t.seq_nums.find(trxn_id);
+    if (it == t.seq_nums.end()) return false;
+    seq_num = it->second;
+    return true;
+  }
+
+  // Forget the transaction, its procedure and its timers
+  void erase(const uint64_t trxn_id, const uint32_t seq_num) {
+    shard_t& s = shard(seq_num);
+    {
+      std::unique_lock<std::mutex> ls(s.m);
+      auto it = s.procs.find(seq_num);
+      if ((it != s.procs.end()) && (it->second.trxn_id == trxn_id)) {
+        s.wheel.stop(it->second.retry_timer);
+        s.wheel.stop(it->second.cleanup_timer);
+        s.procs.erase(it);
+      }
+    }
+    erase_trxn_id(trxn_id);
+  }
+
+  std::size_t size() {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i <= mask_; i++) {
+      std::unique_lock<std::mutex> ls(shards_[i].m);
+      n += shards_[i].procs.size();
+    }
+    return n;
+  }
+};
+
+}  // namespace util
+#endif /* FILE_TRANSACTION_TABLE_HPP_SEEN */
@@ -74,6 +74,18 @@ const char* interface_type2char[40] = {"S1_U_ENODEB_GTP_U",
                                        "S11_MME_GTP_U",
                                        "S11_SGW_GTP_U"};
 
+//------------------------------------------------------------------------------
+// Do not leak the IE if its value is malformed
+template <class T>
+static T* load_ie(T* ie, std::istream& is) {
+  try {
+    ie->load_from(is);
+  } catch (...) {
+    delete ie;
+    throw;
+  }
+  return ie;
+}
 //------------------------------------------------------------------------------
 gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
   gtpv2c_tlv tlv;
@@ -82,102 +94,83 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
     switch (tlv.type) {
       case GTP_IE_IMSI: {
         gtpv2c_imsi_ie* ie = new gtpv2c_imsi_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_CAUSE: {
         gtpv2c_cause_ie* ie = new gtpv2c_cause_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_RECOVERY_RESTART_COUNTER: {
         gtpv2c_recovery_ie* ie = new gtpv2c_recovery_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_ACCESS_POINT_NAME: {
         gtpv2c_access_point_name_ie* ie = new gtpv2c_access_point_name_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_AGGREGATE_MAXIMUM_BIT_RATE: {
         gtpv2c_aggregate_maximum_bit_rate_ie* ie =
             new gtpv2c_aggregate_maximum_bit_rate_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_EPS_BEARER_ID: {
         gtpv2c_eps_bearer_id_ie* ie = new gtpv2c_eps_bearer_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_IP_ADDRESS: {
         gtpv2c_ip_address_ie* ie = new gtpv2c_ip_address_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_MOBILE_EQUIPMENT_IDENTITY: {
         gtpv2c_mei_ie* ie = new gtpv2c_mei_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_MSISDN: {
         gtpv2c_msisdn_ie* ie = new gtpv2c_msisdn_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_INDICATION: {
         gtpv2c_indication_ie* ie = new gtpv2c_indication_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_PROTOCOL_CONFIGURATION_OPTIONS: {
         gtpv2c_pco_ie* ie = new gtpv2c_pco_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_PDN_ADDRESS_ALLOCATION: {
         gtpv2c_paa_ie* ie = new gtpv2c_paa_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_BEARER_QUALITY_OF_SERVICE: {
         gtpv2c_bearer_qos_ie* ie = new gtpv2c_bearer_qos_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_FLOW_QUALITY_OF_SERVICE: {
         gtpv2c_flow_qos_ie* ie = new gtpv2c_flow_qos_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_RAT_TYPE: {
         gtpv2c_rat_type_ie* ie = new gtpv2c_rat_type_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_SERVING_NETWORK: {
         gtpv2c_serving_network_ie* ie = new gtpv2c_serving_network_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_EPS_BEARER_LEVEL_TRAFFIC_FLOW_TEMPLATE: {
         gtpv2c_bearer_tft_ie* ie = new gtpv2c_bearer_tft_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_TRAFFIC_AGGREGATE_DESCRIPTION:
       case GTP_IE_USER_LOCATION_INFORMATION: {
         gtpv2c_user_location_information_ie* ie =
             new gtpv2c_user_location_information_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_FULLY_QUALIFIED_TUNNEL_ENDPOINT_IDENTIFIER: {
         gtpv2c_fully_qualified_teid_ie* ie =
             new gtpv2c_fully_qualified_teid_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_TMSI:
       // case GTP_IE_GLOBAL_CN_ID:
@@ -185,30 +178,25 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
       // case GTP_IE_S1U_DATA_FORWARDING_INFO:
       case GTP_IE_DELAY_VALUE: {
         gtpv2c_delay_value_ie* ie = new gtpv2c_delay_value_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_BEARER_CONTEXT: {
         gtpv2c_bearer_context_ie* ie = new gtpv2c_bearer_context_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_CHARGING_ID: {
         gtpv2c_charging_id_ie* ie = new gtpv2c_charging_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_CHARGING_CHARACTERISTICS:
       // case GTP_IE_TRACE_INFORMATION:
       case GTP_IE_BEARER_FLAGS: {
         gtpv2c_bearer_flags_ie* ie = new gtpv2c_bearer_flags_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case GTP_IE_PDN_TYPE: {
         gtpv2c_pdn_type_ie* ie = new gtpv2c_pdn_type_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_PROCEDURE_TRANSACTION_ID:
       // case GTP_IE_MM_CONTEXT_GSM_KEY_AND_TRIPLETS:
@@ -224,8 +212,7 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
       // case GTP_IE_HOP_COUNTER:
       case GTP_IE_UE_TIME_ZONE: {
         gtpv2c_ue_time_zone_ie* ie = new gtpv2c_ue_time_zone_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_TRACE_REFERENCE:
       // case GTP_IE_COMPLETE_REQUEST_MESSAGE:
@@ -240,28 +227,24 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
       // case GTP_IE_PORT_NUMBER:
       case GTP_IE_APN_RESTRICTION: {
         gtpv2c_apn_restriction_ie* ie = new gtpv2c_apn_restriction_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       }
 
       case GTP_IE_SELECTION_MODE: {
         gtpv2c_selection_mode_ie* ie = new gtpv2c_selection_mode_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_SOURCE_IDENTIFICATION:
       // case GTP_IE_CHANGE_REPORTING_ACTION:
       case GTP_IE_FQ_CSID: {
         gtpv2c_fq_csid_ie* ie = new gtpv2c_fq_csid_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_CHANNEL_NEEDED:
       // case GTP_IE_EMLPP_PRIORITY:
       case GTP_IE_NODE_TYPE: {
         gtpv2c_node_type_ie* ie = new gtpv2c_node_type_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_FULLY_QUALIFIED_DOMAIN_NAME:
       // case GTP_IE_TRANSACTION_IDENTIFIER:
@@ -281,8 +264,7 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
       // case GTP_IE_LOCAL_DISTINGUISHED_NAME:
       case GTP_IE_NODE_FEATURES: {
         gtpv2c_node_features_ie* ie = new gtpv2c_node_features_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_MBMS_TIME_TO_DATA_TRANSFER:
       // case GTP_IE_THROTTLING:
@@ -326,8 +308,7 @@ gtpv2c_ie* gtpv2c_ie::new_gtpv2c_ie_from_stream(std::istream& is) {
       case GTP_IE_CIOT_OPTIMIZATIONS_SUPPORT_INDICATION: {
         gtpv2c_ciot_optimizations_support_indication_ie* ie =
             new gtpv2c_ciot_optimizations_support_indication_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       // case GTP_IE_SCEF_PDN_CONNECTION:
       // case GTP_IE_HEADER_COMPRESSION_CONFIGURATION:
@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "3gpp_29.274.h"
+#include "gtpv2c_codec.hpp"
 #include "logger.hpp"
 #include "msg_gtpv2c.hpp"
 #include "serializable.hpp"
@@ -95,10 +96,21 @@ class gtpv2c_tlv : public stream_serializable {
   }
 };
 //------------------------------------------------------------------------------
+class gtpv2c_ie;
+typedef std::vector<
+    std::shared_ptr<gtpv2c_ie>,
+    gtpv2c_arena_allocator<std::shared_ptr<gtpv2c_ie>>>
+    gtpv2c_ies_t;
+//------------------------------------------------------------------------------
 class gtpv2c_ie : public stream_serializable {
  public:
   gtpv2c_tlv tlv;
 
+  static void* operator new(std::size_t size) {
+    return gtpv2c_arena::allocate(size);
+  }
+  static void operator delete(void* p) { gtpv2c_arena::deallocate(p); }
+
   gtpv2c_ie() : tlv() {}
   explicit gtpv2c_ie(const gtpv2c_tlv& t) : tlv(t) {}
   explicit gtpv2c_ie(const uint8_t tlv_type) : tlv() { tlv.type = tlv_type; }
@@ -117,21 +129,36 @@ class gtpv2c_ie : public stream_serializable {
   };
 
   static gtpv2c_ie* new_gtpv2c_ie_from_stream(std::istream& is);
+
+  // The control block goes with the IE, in the arena if any
+  static std::shared_ptr<gtpv2c_ie> share(gtpv2c_ie* ie) {
+    return std::shared_ptr<gtpv2c_ie>(
+        ie, std::default_delete<gtpv2c_ie>(),
+        gtpv2c_arena_allocator<gtpv2c_ie>());
+  }
 };
 //------------------------------------------------------------------------------
 class gtpv2c_grouped_ie : public gtpv2c_ie {
+ private:
+  // Embedded IEs not decoded yet, they stay in the received buffer until
+  // load_ies(). Only set when the TLIV structure of the buffer was checked.
+  const char* raw_ies;
+
  public:
-  std::vector<std::shared_ptr<gtpv2c_ie>> ies;
+  gtpv2c_ies_t ies;
 
-  gtpv2c_grouped_ie() : gtpv2c_ie(), ies() {}
-  gtpv2c_grouped_ie(const gtpv2c_grouped_ie& g) : gtpv2c_ie(g), ies(g.ies) {}
+  gtpv2c_grouped_ie() : gtpv2c_ie(), raw_ies(nullptr), ies() {}
+  gtpv2c_grouped_ie(const gtpv2c_grouped_ie& g)
+      : gtpv2c_ie(g), raw_ies(g.raw_ies), ies(g.ies) {}
 
-  explicit gtpv2c_grouped_ie(const gtpv2c_tlv& t) : gtpv2c_ie(t), ies() {}
+  explicit gtpv2c_grouped_ie(const gtpv2c_tlv& t)
+      : gtpv2c_ie(t), raw_ies(nullptr), ies() {}
   explicit gtpv2c_grouped_ie(const uint8_t tlv_type)
-      : gtpv2c_ie(tlv_type), ies() {}
+      : gtpv2c_ie(tlv_type), raw_ies(nullptr), ies() {}
 
   gtpv2c_grouped_ie& operator=(gtpv2c_grouped_ie other) {
     this->gtpv2c_ie::operator=(other);
+    std::swap(raw_ies, other.raw_ies);
     std::swap(ies, other.ies);
     return *this;
   }
@@ -143,30 +170,59 @@ class gtpv2c_grouped_ie : public gtpv2c_ie {
   }
 
   void add_ie(std::shared_ptr<gtpv2c_ie> ie) {
+    load_ies();
     ies.push_back(ie);
     tlv.length += (gtpv2c_tlv::tlv_ie_length + ie.get()->tlv.get_length());
   }
 
   virtual void dump_to(std::ostream& os) {
     tlv.dump_to(os);
-    for (auto sie : ies) {
+    if (raw_ies) {
+      os.write(raw_ies, tlv.get_length());
+      return;
+    }
+    for (auto& sie : ies) {
       sie.get()->dump_to(os);
     }
   };
 
   virtual void load_from(std::istream& is) {
     // tlv.load_from(is);
+    span_istreambuf* sb = dynamic_cast<span_istreambuf*>(is.rdbuf());
+    if ((sb) && (sb->checked())) {
+      const char* position = sb->position();
+      if (not sb->skip(tlv.get_length())) {
+        throw gtpc_tlv_bad_length_exception(tlv.get_type(), tlv.get_length());
+      }
+      raw_ies = position;
+      return;
+    }
+    load_ies(is);
+  };
+
+  // Decode the embedded IEs if load_from() left them in the received buffer,
+  // the buffer must still be there
+  void load_ies() {
+    if (not raw_ies) return;
+    std::istream& is = thread_istream(raw_ies, tlv.get_length(), false);
+    gtpv2c_arena::scope arena_scope;
+    raw_ies = nullptr;
+    load_ies(is);
+  }
+
+ private:
+  void load_ies(std::istream& is) {
     int32_t remaining_size = tlv.get_length();
     while (remaining_size > 0) {
       gtpv2c_ie* ie = new_gtpv2c_ie_from_stream(is);
       if (ie) {
         remaining_size -= (ie->tlv.get_length() + gtpv2c_tlv::tlv_ie_length);
-        ies.push_back(std::shared_ptr<gtpv2c_ie>(ie));  // do not use add_ie()
+        ies.push_back(share(ie));  // do not use add_ie()
       } else {
         throw gtpc_tlv_bad_length_exception(tlv.get_type(), tlv.get_length());
       }
     }
-  };
+  }
 };
 //------------------------------------------------------------------------------
 class gtpv2c_msg_header : public stream_serializable {
@@ -302,7 +358,7 @@ class gtpv2c_msg : public gtpv2c_msg_header {
  public:
   uint16_t remote_port;
 
-  std::vector<std::shared_ptr<gtpv2c_ie>> ies;
+  gtpv2c_ies_t ies;
 
   gtpv2c_msg() : gtpv2c_msg_header(), remote_port(0), ies() {}
 
@@ -345,94 +401,94 @@ class gtpv2c_msg : public gtpv2c_msg_header {
   }
 
   void to_core_type(gtpv2c_echo_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_echo_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_create_session_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_create_session_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_create_bearer_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_create_bearer_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_modify_bearer_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_modify_bearer_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_delete_session_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_delete_session_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_release_access_bearers_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_release_access_bearers_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_delete_bearer_command& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_delete_bearer_failure_indication& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_downlink_data_notification& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_downlink_data_notification_acknowledge& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
   void to_core_type(gtpv2c_downlink_data_notification_failure_indication& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s, i.get()->tlv.u1.bf.instance);
     }
   }
 
   void dump_to(std::ostream& os) {
     gtpv2c_msg_header::dump_to(os);
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->dump_to(os);
     }
   }
@@ -449,19 +505,44 @@ class gtpv2c_msg : public gtpv2c_msg_header {
       ie = gtpv2c_ie::new_gtpv2c_ie_from_stream(is);
       if (ie) {
         ies_length += (gtpv2c_tlv::tlv_ie_length + ie->tlv.get_length());
-        ies.push_back(std::shared_ptr<gtpv2c_ie>(ie));
+        ies.push_back(gtpv2c_ie::share(ie));
         // std::cout << std::dec << " ies length  = " << ies_length << " IE
         // length = " << ie->tlv.get_length() << std::endl;
       }
     } while ((ie) && (ies_length < check_msg_length));
 
-    if (ies_length != check_msg_length) {
+    // The IE lengths may add up while the datagram was cut inside an IE value
+    if ((ies_length != check_msg_length) || (is.fail())) {
       // std::cout << " check_msg_length  = " << check_msg_length << "
       // ies_length  = " << ies_length << std::endl;
       throw gtpc_msg_bad_length_exception(
           get_message_type(), get_message_length());
     }
   }
+
+  // Decode a received message in place, the IEs come from the arena. The
+  // lengths are checked in one pass first, then grouped IEs are only decoded
+  // when to_core_type() needs them: the message must not outlive the buffer.
+  void load_from(const char* buffer, const std::size_t size) {
+    const std::size_t length = check_tliv(buffer, size);
+    if (not length) {
+      throw gtpc_msg_bad_length_exception(
+          (size > 1) ? (uint8_t) buffer[1] : 0, size);
+    }
+    std::istream& is = thread_istream(buffer, length, true);
+    gtpv2c_arena::scope arena_scope;
+    load_from(is);
+  }
+  // Encode in a buffer supplied by the caller, the length is known from the
+  // IEs added. Return the length of the message, 0 if it does not fit.
+  std::size_t dump_to(char* buffer, const std::size_t size) {
+    if ((std::size_t) get_message_length() + 4 > size) {
+      return 0;
+    }
+    std::ostream& os = thread_ostream(buffer, size);
+    dump_to(os);
+    return (os.good()) ? static_cast<span_ostreambuf*>(os.rdbuf())->size() : 0;
+  }
 };
 
 inline void ipv6_address_dump_to(
@@ -1761,7 +1842,8 @@ class gtpv2c_bearer_context_ie : public gtpv2c_grouped_ie {
         };
   //--------
   void to_core_type(bearer_context& c) {
-    for (auto sie : ies) {
+    load_ies();
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c, sie.get()->tlv.get_instance());
     }
   }
@@ -56,19 +56,31 @@ gtpv2c_stack::gtpv2c_stack(
     const util::thread_sched_params& sched_params)
     : udp_s(udp_server(ip_address.c_str(), port_num)),
       udp_s_allocated(ip_address.c_str(), 0),
-      m_seq_num() {
+      transactions() {
   timespec ts;
   clock_gettime(CLOCK_REALTIME, &ts);
-  seq_num = (uint32_t) ts.tv_nsec & 0x7FFFFFFF;
+  seq_num.store((uint32_t) ts.tv_nsec & 0x7FFFFFFF);
 
   Logger::gtpv2_c().info(
       "gtpv2c_stack created listening to %s:%d initial seq num %d",
-      ip_address.c_str(), port_num, seq_num);
+      ip_address.c_str(), port_num, seq_num.load());
 
-  gtpc_tx_id2seq_num   = {};
-  proc_cleanup_timers  = {};
-  msg_out_retry_timers = {};
-  pending_procedures   = {};
+  transactions.start(
+      GTPV2C_T3_RESPONSE_MS, GTPV2C_N3_REQUESTS,
+      [this](const gtpv2c_procedure& p) {
+        Logger::gtpv2_c().trace(
+            "Retry %d Sending msg type %d, seq %d", p.retry_count,
+            p.retry_msg->get_message_type(),
+            p.retry_msg->get_sequence_number());
+        send_msg(udp_s, *p.retry_msg.get(), p.remote_endpoint);
+      },
+      [this](const gtpv2c_procedure& p) {
+        // abort procedure
+        notify_ul_error(
+            p.remote_endpoint, p.local_teid,
+            cause_value_e::REMOTE_PEER_NOT_RESPONDING, p.gtpc_tx_id);
+      },
+      [sched_params]() { sched_params.apply(TASK_NONE, Logger::gtpv2_c()); });
 
   id              = 0;
   restart_counter = 0;
@@ -77,12 +89,7 @@ gtpv2c_stack::gtpv2c_stack(
 }
 //------------------------------------------------------------------------------
 uint32_t gtpv2c_stack::get_next_seq_num() {
-  std::unique_lock lock(m_seq_num);
-  seq_num++;
-  if (seq_num & 0x80000000) {
-    seq_num = 0;
-  }
-  return seq_num;
+  return (seq_num.fetch_add(1, std::memory_order_relaxed) + 1) & 0x7FFFFFFF;
 }
 //------------------------------------------------------------------------------
 void gtpv2c_stack::handle_receive(
@@ -205,166 +212,88 @@ bool gtpv2c_stack::check_triggered_message_type(
   }
 }
 //------------------------------------------------------------------------------
-void gtpv2c_stack::start_msg_retry_timer(
-    gtpv2c_procedure& p, uint32_t time_out_milli_seconds,
-    const task_id_t& task_id, const uint32_t& seq_num) {
-  if (!p.retry_timer_id) {
-    p.retry_timer_id = itti_inst->timer_setup(
-        time_out_milli_seconds / 1000, time_out_milli_seconds % 1000, task_id);
-    msg_out_retry_timers.insert(
-        std::pair<timer_id_t, uint32_t>(p.retry_timer_id, seq_num));
-#if TRACE_IS_ON
-    Logger::gtpv2_c().trace(
-        "Started Msg retry timer %d, proc " PROC_ID_FMT ", seq %d",
-        p.retry_timer_id, p.gtpc_tx_id, seq_num);
-#endif
-  } else {
-    Logger::gtpv2_c().error(
-        "Try to overwrite Msg retry timer %d, proc " PROC_ID_FMT ", seq %d!",
-        p.retry_timer_id, p.gtpc_tx_id, seq_num);
-  }
-}
-//------------------------------------------------------------------------------
-void gtpv2c_stack::stop_msg_retry_timer(gtpv2c_procedure& p) {
-  if (p.retry_timer_id) {
-    itti_inst->timer_remove(p.retry_timer_id);
-    msg_out_retry_timers.erase(p.retry_timer_id);
-#if TRACE_IS_ON
-    Logger::gtpv2_c().trace(
-        "Stopped Msg retry timer %d, proc " PROC_ID_FMT ", seq %d",
-        p.retry_timer_id, p.gtpc_tx_id, p.retry_msg->get_sequence_number());
-#endif
-    p.retry_timer_id = 0;
-  }
-}
-//------------------------------------------------------------------------------
-void gtpv2c_stack::stop_msg_retry_timer(timer_id_t& t) {
-  itti_inst->timer_remove(t);
-  msg_out_retry_timers.erase(t);
-#if TRACE_IS_ON
-  Logger::gtpv2_c().trace("Stopped Msg retry timer %d", t);
-#endif
-}
-//------------------------------------------------------------------------------
-void gtpv2c_stack::start_proc_cleanup_timer(
-    gtpv2c_procedure& p, uint32_t time_out_milli_seconds,
-    const task_id_t& task_id, const uint32_t& seq_num) {
-  if (!p.proc_cleanup_timer_id) {
-    p.proc_cleanup_timer_id = itti_inst->timer_setup(
-        time_out_milli_seconds / 1000, time_out_milli_seconds % 1000, task_id);
-    proc_cleanup_timers.insert(
-        std::pair<timer_id_t, uint32_t>(p.proc_cleanup_timer_id, seq_num));
-#if TRACE_IS_ON
-    Logger::gtpv2_c().trace(
-        "Started proc cleanup timer %d, proc " PROC_ID_FMT " t-out %" PRIu32
-        " ms",
-        p.proc_cleanup_timer_id, p.gtpc_tx_id, time_out_milli_seconds);
-#endif
-  } else {
-    Logger::gtpv2_c().error(
-        "Try to overwrite proc cleanup timer %d, proc " PROC_ID_FMT
-        " t-out %" PRIu32 " ms",
-        p.proc_cleanup_timer_id, p.gtpc_tx_id, time_out_milli_seconds);
-  }
-}
-//------------------------------------------------------------------------------
-void gtpv2c_stack::stop_proc_cleanup_timer(gtpv2c_procedure& p) {
-  itti_inst->timer_remove(p.proc_cleanup_timer_id);
-#if TRACE_IS_ON
-  Logger::gtpv2_c().trace(
-      "Stopped proc cleanup timer %d, proc " PROC_ID_FMT "",
-      p.proc_cleanup_timer_id, p.gtpc_tx_id);
-#endif
-  msg_out_retry_timers.erase(p.proc_cleanup_timer_id);
-  p.proc_cleanup_timer_id = 0;
-}
-//------------------------------------------------------------------------------
 void gtpv2c_stack::handle_receive_message_cb(
     const gtpv2c_msg& msg, const endpoint& r_endpoint, const task_id_t& task_id,
     bool& error, uint64_t& gtpc_tx_id) {
   gtpc_tx_id = 0;
   error      = true;
-  std::map<uint32_t, gtpv2c_procedure>::iterator it;
-  it = pending_procedures.find(msg.get_sequence_number());
-  if (it == pending_procedures.end()) {
-    if (gtpv2c_stack::check_initial_message_type(msg.get_message_type())) {
-      gtpv2c_procedure proc = {};
-      proc.gtpc_tx_id       = generate_gtpc_tx_id();
-      proc.initial_msg_type = msg.get_message_type();
-      // TODO later 13.3 Detection and handling of requests which have timed out
-      // at the originating entity if (msg_has_timestamp()) {
-      // start_proc_cleanup_timer(proc, (N3+1) x T3, task_id,
-      // msg.get_sequence_number()); } else
-      start_proc_cleanup_timer(
-          proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-      pending_procedures.insert(std::pair<uint32_t, gtpv2c_procedure>(
-          msg.get_sequence_number(), proc));
-      gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-          proc.gtpc_tx_id, msg.get_sequence_number()));
-      error      = false;
-      gtpc_tx_id = proc.gtpc_tx_id;
+  if (transactions.update(
+          msg.get_sequence_number(),
+          [&](gtpv2c_procedure& p, bool& stop_retry) {
+            uint8_t check_initial_msg_type = p.triggered_msg_type;
+            if (!p.triggered_msg_type) {
+              check_initial_msg_type = p.initial_msg_type;
+            }
+            if (gtpv2c_stack::check_triggered_message_type(
+                    check_initial_msg_type, msg.get_message_type())) {
+              if (!p.triggered_msg_type) {
+                p.triggered_msg_type = msg.get_message_type();
+              }
+              error      = false;
+              gtpc_tx_id = p.gtpc_tx_id;
+              stop_retry = true;
+            }
+          })) {
+    if (!error) {
       Logger::gtpv2_c().info(
-          "Received Initial GTPV2-C msg type %d, seq %d, proc " PROC_ID_FMT "",
-          msg.get_message_type(), msg.get_sequence_number(), proc.gtpc_tx_id);
+          "Received Triggered GTPV2-C msg type %d, seq %d, proc " PROC_ID_FMT
+          "",
+          msg.get_message_type(), msg.get_sequence_number(), gtpc_tx_id);
     } else {
       Logger::gtpv2_c().info(
-          "Failed to check Initial message type, Silently discarding GTPV2-C "
+          "Failed to check Triggered message type, Silently discarding GTPV2-C "
           "msg type %d, seq %d",
           msg.get_message_type(), msg.get_sequence_number());
-      error = true;
-    }
-    return;
-  } else {
-    //    Logger::gtpv2_c().info( "gtpv2c_procedure retry_timer_id        %d",
-    //    it->second.retry_timer_id); Logger::gtpv2_c().info( "gtpv2c_procedure
-    //    proc_cleanup_timer_id %d", it->second.proc_cleanup_timer_id);
-    //    Logger::gtpv2_c().info( "gtpv2c_procedure gtpc_tx_id            %ld",
-    //    it->second.gtpc_tx_id); Logger::gtpv2_c().info( "gtpv2c_procedure
-    //    initial_msg_type      %d", it->second.initial_msg_type);
-    //    Logger::gtpv2_c().info( "gtpv2c_procedure triggered_msg_type    %d",
-    //    it->second.triggered_msg_type); Logger::gtpv2_c().info(
-    //    "gtpv2c_procedure retry_count           %d", it->second.retry_count);
-
-    uint8_t check_initial_msg_type = it->second.triggered_msg_type;
-    if (!it->second.triggered_msg_type) {
-      check_initial_msg_type = it->second.initial_msg_type;
     }
-    if (gtpv2c_stack::check_triggered_message_type(
-            check_initial_msg_type, msg.get_message_type())) {
-      if (!it->second.triggered_msg_type) {
-        it->second.triggered_msg_type = msg.get_message_type();
-      }
+  } else if (gtpv2c_stack::check_initial_message_type(msg.get_message_type())) {
+    gtpv2c_procedure proc = {};
+    proc.gtpc_tx_id       = generate_gtpc_tx_id();
+    proc.initial_msg_type = msg.get_message_type();
+    // TODO later 13.3 Detection and handling of requests which have timed out
+    // at the originating entity if (msg_has_timestamp()) lifetime is
+    // (N3+1) x T3
+    if (transactions.insert(
+            msg.get_sequence_number(), proc.gtpc_tx_id, proc, false,
+            GTPV2C_PROC_TIME_OUT_MS)) {
       error      = false;
-      gtpc_tx_id = it->second.gtpc_tx_id;
-      if (it->second.retry_timer_id) {
-        stop_msg_retry_timer(it->second);
-      }
+      gtpc_tx_id = proc.gtpc_tx_id;
       Logger::gtpv2_c().info(
-          "Received Triggered GTPV2-C msg type %d, seq %d, proc " PROC_ID_FMT
-          "",
-          msg.get_message_type(), msg.get_sequence_number(), gtpc_tx_id);
+          "Received Initial GTPV2-C msg type %d, seq %d, proc " PROC_ID_FMT "",
+          msg.get_message_type(), msg.get_sequence_number(), proc.gtpc_tx_id);
     } else {
+      // Another receive thread registered it meanwhile, a retransmission
       Logger::gtpv2_c().info(
-          "Failed to check Triggered message type, Silently discarding GTPV2-C "
-          "msg type %d, seq %d",
+          "Duplicate Initial GTPV2-C msg type %d, seq %d, discarded",
           msg.get_message_type(), msg.get_sequence_number());
-      error = true;
     }
+  } else {
+    Logger::gtpv2_c().info(
+        "Failed to check Initial message type, Silently discarding GTPV2-C "
+        "msg type %d, seq %d",
+        msg.get_message_type(), msg.get_sequence_number());
   }
 }
 
+//------------------------------------------------------------------------------
+void gtpv2c_stack::send_msg(
+    udp_server& udp_s, gtpv2c_msg& msg, const endpoint& dest) {
+  // sendto() copies the message, one buffer per sending thread is enough
+  static thread_local char buffer[GTPV2C_MSG_MAX_SIZE];
+  const std::size_t length = msg.dump_to(buffer, sizeof(buffer));
+  if (not length) {
+    Logger::gtpv2_c().error(
+        "GTPV2-C msg type %d length %d too long, discarded!",
+        msg.get_message_type(), msg.get_message_length());
+    return;
+  }
+  udp_s.async_send_to(buffer, length, dest);
+}
 //------------------------------------------------------------------------------
 uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const gtpv2c_echo_request& gtp_ies,
     const task_id_t& task_id, const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  // std::cout << string_to_hex(oss.str()) << std::endl;
-  // std::cout << std::hex << "msg length 0x" << msg.get_message_length() <<
-  // "msg seqnum 0x" << msg.get_sequence_number() << std::endl;
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, proc " PROC_ID_FMT " ", gtp_ies.get_msg_name(),
@@ -374,17 +303,11 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.gtpc_tx_id       = gtp_tx_id;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
@@ -392,15 +315,9 @@ uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const teid_t r_teid, const teid_t l_teid,
     const gtpv2c_create_session_request& gtp_ies, const task_id_t& task_id,
     const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_teid(r_teid);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  // std::cout << string_to_hex(oss.str()) << std::endl;
-  // std::cout << std::hex << "msg length 0x" << msg.get_message_length() <<
-  // "msg seqnum 0x" << msg.get_sequence_number() << std::endl;
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
@@ -412,17 +329,11 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.local_teid       = l_teid;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
@@ -430,12 +341,9 @@ uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const teid_t r_teid, const teid_t l_teid,
     const gtpv2c_delete_session_request& gtp_ies, const task_id_t& task_id,
     const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_teid(r_teid);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
@@ -447,17 +355,11 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.local_teid       = l_teid;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
@@ -465,12 +367,9 @@ uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const teid_t r_teid, const teid_t l_teid,
     const gtpv2c_modify_bearer_request& gtp_ies, const task_id_t& task_id,
     const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_teid(r_teid);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
@@ -482,17 +381,11 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.local_teid       = l_teid;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
@@ -500,12 +393,9 @@ uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const teid_t r_teid, const teid_t l_teid,
     const gtpv2c_release_access_bearers_request& gtp_ies,
     const task_id_t& task_id, const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_teid(r_teid);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
@@ -517,17 +407,11 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.local_teid       = l_teid;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
@@ -535,12 +419,9 @@ uint32_t gtpv2c_stack::send_initial_message(
     const endpoint& dest, const teid_t r_teid, const teid_t l_teid,
     const gtpv2c_downlink_data_notification& gtp_ies, const task_id_t& task_id,
     const uint64_t gtp_tx_id) {
-  std::ostringstream oss(std::ostringstream::binary);
   gtpv2c_msg msg(gtp_ies);
   msg.set_teid(r_teid);
   msg.set_sequence_number(get_next_seq_num());
-  msg.dump_to(oss);
-  std::string bstream = oss.str();
 
   Logger::gtpv2_c().trace(
       "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
@@ -552,46 +433,30 @@ uint32_t gtpv2c_stack::send_initial_message(
   proc.local_teid       = l_teid;
   proc.retry_msg        = std::make_shared<gtpv2c_msg>(msg);
   proc.remote_endpoint  = dest;
-  start_msg_retry_timer(
-      proc, GTPV2C_T3_RESPONSE_MS, task_id, msg.get_sequence_number());
-  start_proc_cleanup_timer(
-      proc, GTPV2C_PROC_TIME_OUT_MS, task_id, msg.get_sequence_number());
-  pending_procedures.insert(
-      std::pair<uint32_t, gtpv2c_procedure>(msg.get_sequence_number(), proc));
-  gtpc_tx_id2seq_num.insert(std::pair<uint64_t, uint32_t>(
-      proc.gtpc_tx_id, msg.get_sequence_number()));
+  transactions.insert(
+      msg.get_sequence_number(), proc.gtpc_tx_id, proc, true,
+      GTPV2C_PROC_TIME_OUT_MS);
 
-  udp_s_allocated.async_send_to(
-      reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+  send_msg(udp_s_allocated, msg, dest);
   return msg.get_sequence_number();
 }
 //------------------------------------------------------------------------------
 void gtpv2c_stack::send_triggered_message(
     const endpoint& dest, const gtpv2c_echo_response& gtp_ies,
     const uint64_t gtp_tx_id, const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(), dest);
+    send_msg(udp_s, msg, dest);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -604,31 +469,20 @@ void gtpv2c_stack::send_triggered_message(
     const endpoint& r_endpoint, const teid_t r_teid,
     const gtpv2c_create_session_response& gtp_ies, const uint64_t gtp_tx_id,
     const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
     msg.set_teid(r_teid);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-        r_endpoint);
+    send_msg(udp_s, msg, r_endpoint);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -641,31 +495,20 @@ void gtpv2c_stack::send_triggered_message(
     const endpoint& r_endpoint, const teid_t r_teid,
     const gtpv2c_delete_session_response& gtp_ies, const uint64_t gtp_tx_id,
     const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
     msg.set_teid(r_teid);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-        r_endpoint);
+    send_msg(udp_s, msg, r_endpoint);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -678,31 +521,20 @@ void gtpv2c_stack::send_triggered_message(
     const endpoint& r_endpoint, const teid_t r_teid,
     const gtpv2c_modify_bearer_response& gtp_ies, const uint64_t gtp_tx_id,
     const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
     msg.set_teid(r_teid);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-        r_endpoint);
+    send_msg(udp_s, msg, r_endpoint);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -715,31 +547,20 @@ void gtpv2c_stack::send_triggered_message(
     const endpoint& r_endpoint, const teid_t r_teid,
     const gtpv2c_release_access_bearers_response& gtp_ies,
     const uint64_t gtp_tx_id, const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
     msg.set_teid(r_teid);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-        r_endpoint);
+    send_msg(udp_s, msg, r_endpoint);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -752,31 +573,20 @@ void gtpv2c_stack::send_triggered_message(
     const endpoint& r_endpoint, const teid_t r_teid,
     const gtpv2c_downlink_data_notification_acknowledge& gtp_ies,
     const uint64_t gtp_tx_id, const gtpv2c_transaction_action& a) {
-  std::map<uint64_t, uint32_t>::iterator it;
-  it = gtpc_tx_id2seq_num.find(gtp_tx_id);
-  if (it != gtpc_tx_id2seq_num.end()) {
-    std::ostringstream oss(std::ostringstream::binary);
+  uint32_t seq = 0;
+  if (transactions.find_seq_num(gtp_tx_id, seq)) {
+    gtpv2c_arena::scope arena_scope;
     gtpv2c_msg msg(gtp_ies);
     msg.set_teid(r_teid);
-    msg.set_sequence_number(it->second);
-    msg.dump_to(oss);
-    std::string bstream = oss.str();
+    msg.set_sequence_number(seq);
     Logger::gtpv2_c().trace(
         "Sending %s, seq %d, teid " TEID_FMT ", proc " PROC_ID_FMT "",
         gtp_ies.get_msg_name(), msg.get_sequence_number(), msg.get_teid(),
         gtp_tx_id);
-    udp_s.async_send_to(
-        reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-        r_endpoint);
+    send_msg(udp_s, msg, r_endpoint);
 
     if (a == DELETE_TX) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      if (it_proc != pending_procedures.end()) {
-        stop_proc_cleanup_timer(it_proc->second);
-        pending_procedures.erase(it_proc);
-      }
-      gtpc_tx_id2seq_num.erase(it);
+      transactions.erase(gtp_tx_id, seq);
     }
   } else {
     Logger::gtpv2_c().error(
@@ -788,62 +598,7 @@ void gtpv2c_stack::send_triggered_message(
 //------------------------------------------------------------------------------
 void gtpv2c_stack::time_out_event(
     const uint32_t timer_id, const task_id_t& task_id, bool& handled) {
+  // T3 and the procedure cleanup are run by the transaction table, the stack
+  // starts no ITTI timer
   handled = false;
-  std::map<timer_id_t, uint32_t>::iterator it =
-      msg_out_retry_timers.find(timer_id);
-  if (it != msg_out_retry_timers.end()) {
-    std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-        pending_procedures.find(it->second);
-    msg_out_retry_timers.erase(it);
-    handled = true;
-    if (it_proc != pending_procedures.end()) {
-      if (it_proc->second.retry_count < GTPV2C_N3_REQUESTS) {
-        it_proc->second.retry_count++;
-        it_proc->second.retry_timer_id = 0;
-        start_msg_retry_timer(
-            it_proc->second, GTPV2C_T3_RESPONSE_MS, task_id,
-            it_proc->second.retry_msg->get_sequence_number());
-        // send again message
-        Logger::gtpv2_c().trace(
-            "Retry %d Sending msg type %d, seq %d", it_proc->second.retry_count,
-            it_proc->second.retry_msg->get_message_type(),
-            it_proc->second.retry_msg->get_sequence_number());
-        std::ostringstream oss(std::ostringstream::binary);
-        it_proc->second.retry_msg->dump_to(oss);
-        std::string bstream = oss.str();
-        udp_s.async_send_to(
-            reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
-            it_proc->second.remote_endpoint);
-      } else {
-        // abort procedure
-        notify_ul_error(
-            it_proc->second.remote_endpoint, it_proc->second.local_teid,
-            cause_value_e::REMOTE_PEER_NOT_RESPONDING,
-            it_proc->second.gtpc_tx_id);
-        handled                               = true;
-        it_proc->second.proc_cleanup_timer_id = 0;
-        Logger::gtpv2_c().trace(
-            "Delete proc " PROC_ID_FMT " Retry %d seq %d timer id %u",
-            it_proc->second.gtpc_tx_id, it_proc->second.retry_count,
-            it_proc->first, timer_id);
-        pending_procedures.erase(it_proc);
-      }
-    }
-  } else {
-    it = proc_cleanup_timers.find(timer_id);
-    if (it != proc_cleanup_timers.end()) {
-      std::map<uint32_t, gtpv2c_procedure>::iterator it_proc =
-          pending_procedures.find(it->second);
-      proc_cleanup_timers.erase(it);
-      handled = true;
-      if (it_proc != pending_procedures.end()) {
-        it_proc->second.proc_cleanup_timer_id = 0;
-        Logger::gtpv2_c().trace(
-            "Delete proc " PROC_ID_FMT " Retry %d seq %d timer id %u",
-            it_proc->second.gtpc_tx_id, it_proc->second.retry_count,
-            it_proc->first, timer_id);
-        pending_procedures.erase(it_proc);
-      }
-    }
-  }
 }
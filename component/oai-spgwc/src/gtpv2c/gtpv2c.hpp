@@ -31,11 +31,12 @@
 #include "3gpp_29.274.hpp"
 #include "endpoint.hpp"
 #include "itti.hpp"
+#include "transaction_table.hpp"
 #include "udp.hpp"
 #include "uint_generator.hpp"
 
+#include <atomic>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -51,8 +52,6 @@ class gtpv2c_procedure {
   std::shared_ptr<gtpv2c_msg> retry_msg;
   endpoint remote_endpoint;
   teid_t local_teid;  // for peer not responding
-  timer_id_t retry_timer_id;
-  timer_id_t proc_cleanup_timer_id;
   uint64_t gtpc_tx_id;
   uint8_t initial_msg_type;    // sent or received
   uint8_t triggered_msg_type;  // sent or received
@@ -67,8 +66,6 @@ class gtpv2c_procedure {
       : retry_msg(),
         remote_endpoint(),
         local_teid(0),
-        retry_timer_id(0),
-        proc_cleanup_timer_id(0),
         gtpc_tx_id(0),
         initial_msg_type(0),
         triggered_msg_type(0),
@@ -78,8 +75,6 @@ class gtpv2c_procedure {
       : retry_msg(p.retry_msg),
         remote_endpoint(p.remote_endpoint),
         local_teid(p.local_teid),
-        retry_timer_id(p.retry_timer_id),
-        proc_cleanup_timer_id(p.proc_cleanup_timer_id),
         gtpc_tx_id(p.gtpc_tx_id),
         initial_msg_type(p.initial_msg_type),
         triggered_msg_type(p.triggered_msg_type),
@@ -93,21 +88,20 @@ class gtpv2c_stack : public udp_application {
 #define GTPV2C_N3_REQUESTS 3
 #define GTPV2C_PROC_TIME_OUT_MS                                                \
   ((GTPV2C_T3_RESPONSE_MS) * (GTPV2C_N3_REQUESTS + 1) + 1000)
+// Header and IEs, the message length field is 16 bits
+#define GTPV2C_MSG_MAX_SIZE (4 + 65535)
 
  protected:
   uint32_t id;
   udp_server udp_s;
   udp_server udp_s_allocated;
 
-  // seems no need for atomic
-  uint32_t seq_num;
-  std::mutex m_seq_num;
+  // Taken by the ITTI tasks and the UDP receive threads
+  std::atomic<uint32_t> seq_num;
   uint32_t restart_counter;
 
-  std::map<uint64_t, uint32_t> gtpc_tx_id2seq_num;
-  std::map<timer_id_t, uint32_t> proc_cleanup_timers;
-  std::map<timer_id_t, uint32_t> msg_out_retry_timers;
-  std::map<uint32_t, gtpv2c_procedure> pending_procedures;
+  // Pending procedures by sequence number, their T3 and cleanup timers
+  util::transaction_table<gtpv2c_procedure> transactions;
 
   static const char* msg_type2cstr[256];
 
@@ -120,16 +114,9 @@ class gtpv2c_stack : public udp_application {
   static bool check_initial_message_type(const uint8_t initial);
   static bool check_triggered_message_type(
       const uint8_t initial, const uint8_t triggered);
-  void start_proc_cleanup_timer(
-      gtpv2c_procedure& p, uint32_t time_out_milli_seconds,
-      const task_id_t& task_id, const uint32_t& seq_num);
-  void start_msg_retry_timer(
-      gtpv2c_procedure& p, uint32_t time_out_milli_seconds,
-      const task_id_t& task_id, const uint32_t& seq_num);
-  void stop_msg_retry_timer(gtpv2c_procedure& p);
-  void stop_msg_retry_timer(timer_id_t& t);
-  void stop_proc_cleanup_timer(gtpv2c_procedure& p);
   void notify_ul_error(const gtpv2c_procedure& p, const cause_value_e cause);
+  // Encode msg without intermediate string and send it
+  void send_msg(udp_server& udp_s, gtpv2c_msg& msg, const endpoint& dest);
 
  public:
   static const uint8_t version = 2;
@@ -0,0 +1,163 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpv2c_codec.cpp
+  \brief
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "gtpv2c_codec.hpp"
+#include "3gpp_29.274.h"
+
+#include <memory>
+#include <new>
+
+using namespace gtpv2c;
+
+// Bearer contexts do not nest deeper
+#define GTPV2C_MAX_IE_NESTING 4
+
+thread_local gtpv2c_arena* gtpv2c_arena::current_ = nullptr;
+
+//------------------------------------------------------------------------------
+gtpv2c_arena::gtpv2c_arena()
+    : buffer_(new char[GTPV2C_ARENA_SIZE]), used_(0), live_(1) {}
+//------------------------------------------------------------------------------
+gtpv2c_arena::~gtpv2c_arena() {
+  delete[] buffer_;
+}
+//------------------------------------------------------------------------------
+void gtpv2c_arena::release() noexcept {
+  if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+//------------------------------------------------------------------------------
+gtpv2c_arena& gtpv2c_arena::get_thread_instance() {
+  // Released when the thread exits, blocks still referring to the arena, e.g.
+  // a message passed to another thread, keep it until they are released
+  static thread_local std::unique_ptr<gtpv2c_arena, void (*)(gtpv2c_arena*)>
+      arena(new gtpv2c_arena(), [](gtpv2c_arena* a) { a->release(); });
+  return *arena;
+}
+//------------------------------------------------------------------------------
+void* gtpv2c_arena::allocate(const std::size_t size) {
+  const std::size_t total =
+      sizeof(block_header_t) + ((size + alignof(block_header_t) - 1) &
+                                ~(alignof(block_header_t) - 1));
+  block_header_t* h = nullptr;
+  gtpv2c_arena* a     = current_;
+  if (a) {
+    if (a->live_.load(std::memory_order_acquire) == 1) {
+      a->used_ = 0;
+    }
+    if (a->used_ + total <= GTPV2C_ARENA_SIZE) {
+      h = reinterpret_cast<block_header_t*>(a->buffer_ + a->used_);
+      a->used_ += total;
+      a->live_.fetch_add(1, std::memory_order_relaxed);
+      h->arena = a;
+      return h + 1;
+    }
+  }
+  h        = static_cast<block_header_t*>(::operator new(total));
+  h->arena = nullptr;
+  return h + 1;
+}
+//------------------------------------------------------------------------------
+void gtpv2c_arena::deallocate(void* p) noexcept {
+  if (not p) return;
+  block_header_t* h = static_cast<block_header_t*>(p) - 1;
+  if (h->arena) {
+    h->arena->release();
+  } else {
+    ::operator delete(h);
+  }
+}
+//------------------------------------------------------------------------------
+gtpv2c_arena::scope::scope() : previous_(current_) {
+  current_ = &get_thread_instance();
+}
+//------------------------------------------------------------------------------
+gtpv2c_arena::scope::~scope() {
+  current_ = previous_;
+}
+
+//------------------------------------------------------------------------------
+std::istream& gtpv2c::thread_istream(
+    const char* buffer, const std::size_t size, const bool checked) {
+  static thread_local span_istreambuf sb;
+  static thread_local std::istream is(&sb);
+  sb.reset(buffer, size, checked);
+  is.clear();
+  return is;
+}
+//------------------------------------------------------------------------------
+std::ostream& gtpv2c::thread_ostream(char* buffer, const std::size_t size) {
+  static thread_local span_ostreambuf sb;
+  static thread_local std::ostream os(&sb);
+  sb.reset(buffer, size);
+  os.clear();
+  return os;
+}
+//------------------------------------------------------------------------------
+static bool is_grouped_ie(const uint8_t type) {
+  switch (type) {
+    case GTP_IE_BEARER_CONTEXT:
+    case GTP_IE_PDN_CONNECTION:
+    case GTP_IE_OVERLOAD_CONTROL_INFORMATION:
+    case GTP_IE_LOAD_CONTROL_INFORMATION:
+    case GTP_IE_REMOTE_UE_CONTEXT:
+    case GTP_IE_SCEF_PDN_CONNECTION:
+      return true;
+    default:
+      return false;
+  }
+}
+//------------------------------------------------------------------------------
+static bool check_ies(const uint8_t* p, std::size_t length, const int depth) {
+  while (length) {
+    if (length < 4) return false;
+    const std::size_t ie_length = (((std::size_t) p[1]) << 8) | p[2];
+    if (ie_length > length - 4) return false;
+    if (is_grouped_ie(p[0])) {
+      if ((depth >= GTPV2C_MAX_IE_NESTING) ||
+          (not check_ies(p + 4, ie_length, depth + 1))) {
+        return false;
+      }
+    }
+    p += 4 + ie_length;
+    length -= 4 + ie_length;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+std::size_t gtpv2c::check_tliv(const char* buffer, const std::size_t size) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(buffer);
+  if (size < 8) return 0;
+  // Message length excludes the first 4 octets, TEID present if T flag
+  const std::size_t length     = 4 + ((((std::size_t) p[2]) << 8) | p[3]);
+  const std::size_t header_len = (p[0] & 0x08) ? 12 : 8;
+  if ((length < header_len) || (length > size)) return 0;
+  if (not check_ies(p + header_len, length - header_len, 0)) return 0;
+  return length;
+}
@@ -0,0 +1,172 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpv2c_codec.hpp
+  \brief Memory and buffers of the GTPv2-C message codec
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+#ifndef FILE_GTPV2C_CODEC_HPP_SEEN
+#define FILE_GTPV2C_CODEC_HPP_SEEN
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+
+namespace gtpv2c {
+
+// The IE objects of a received message live for the duration of
+// handle_receive(), they are taken from a per thread arena instead of the heap.
+#define GTPV2C_ARENA_SIZE (128 * 1024)
+
+class gtpv2c_arena {
+ private:
+  // Prepended to every block, arena or heap, so that a block can be released
+  // by any thread without knowing where it comes from
+  typedef struct alignas(16) block_header_s {
+    gtpv2c_arena* arena;
+  } block_header_t;
+
+  char* buffer_;
+  // Only touched by the thread owning the arena
+  std::size_t used_;
+  // Blocks not released yet plus one held by the owning thread until it
+  // exits. The arena restarts from its beginning once only the thread holds
+  // it, and is freed by the last release.
+  std::atomic<std::size_t> live_;
+
+  // Arena of this thread if a scope is alive, else nullptr (heap)
+  static thread_local gtpv2c_arena* current_;
+
+  gtpv2c_arena();
+  ~gtpv2c_arena();
+  void release() noexcept;
+  static gtpv2c_arena& get_thread_instance();
+
+ public:
+  gtpv2c_arena(const gtpv2c_arena&) = delete;
+  void operator=(const gtpv2c_arena&) = delete;
+
+  // Fall back on the heap if no scope is alive or if the arena is full
+  static void* allocate(const std::size_t size);
+  static void deallocate(void* p) noexcept;
+
+  // While a scope is alive, the IEs created by this thread and their
+  // containers are taken from its arena. They may outlive the scope.
+  class scope {
+   private:
+    gtpv2c_arena* previous_;
+
+   public:
+    scope();
+    ~scope();
+    scope(const scope&) = delete;
+    void operator=(const scope&) = delete;
+  };
+};
+
+// For the containers of IEs and the control blocks of their shared_ptr
+template <class T>
+class gtpv2c_arena_allocator {
+ public:
+  typedef T value_type;
+
+  gtpv2c_arena_allocator() noexcept {}
+  template <class U>
+  gtpv2c_arena_allocator(const gtpv2c_arena_allocator<U>&) noexcept {}
+
+  T* allocate(const std::size_t n) {
+    return static_cast<T*>(gtpv2c_arena::allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, const std::size_t) noexcept {
+    gtpv2c_arena::deallocate(p);
+  }
+};
+template <class T, class U>
+bool operator==(
+    const gtpv2c_arena_allocator<T>&, const gtpv2c_arena_allocator<U>&) {
+  return true;
+}
+template <class T, class U>
+bool operator!=(
+    const gtpv2c_arena_allocator<T>&, const gtpv2c_arena_allocator<U>&) {
+  return false;
+}
+
+// Read a received message in place
+class span_istreambuf : public std::streambuf {
+ private:
+  // The TLIV structure of the buffer has been checked, see check_tliv()
+  bool checked_;
+
+ public:
+  span_istreambuf() : checked_(false) {}
+  span_istreambuf(
+      const char* buffer, const std::size_t size, const bool checked = false) {
+    reset(buffer, size, checked);
+  }
+  void reset(const char* buffer, const std::size_t size, const bool checked) {
+    char* b = const_cast<char*>(buffer);
+    setg(b, b, b + size);
+    checked_ = checked;
+  }
+  bool checked() const { return checked_; }
+  const char* position() const { return gptr(); }
+  // Return false if less than n bytes are left
+  bool skip(const std::size_t n) {
+    if ((std::size_t)(egptr() - gptr()) < n) return false;
+    gbump(n);
+    return true;
+  }
+};
+
+// Write a message in a buffer supplied by the caller, the stream goes bad
+// instead of growing the buffer
+class span_ostreambuf : public std::streambuf {
+ public:
+  span_ostreambuf() {}
+  span_ostreambuf(char* buffer, const std::size_t size) { reset(buffer, size); }
+  void reset(char* buffer, const std::size_t size) {
+    setp(buffer, buffer + size);
+  }
+  std::size_t size() const { return pptr() - pbase(); }
+};
+
+// Building a stream (locale) costs as much as decoding a small message, the
+// codec reuses one input and one output stream per thread. A thread reads or
+// writes one message at a time.
+std::istream& thread_istream(
+    const char* buffer, const std::size_t size, const bool checked);
+std::ostream& thread_ostream(char* buffer, const std::size_t size);
+
+// Single pass over the header and the IEs of a received datagram, IEs
+// embedded in grouped IEs included, before anything is decoded. Return the
+// length of the first message (a piggybacked message may follow), 0 if a
+// length is not consistent.
+std::size_t check_tliv(const char* buffer, const std::size_t size);
+
+}  // namespace gtpv2c
+
+#endif /* FILE_GTPV2C_CODEC_HPP_SEEN */
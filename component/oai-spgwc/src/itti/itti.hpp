@@ -35,10 +35,14 @@
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <set>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "itti_msg.hpp"
+#include "mpsc_ring.hpp"
 #include "thread_sched.hpp"
+#include "timing_wheel.hpp"
 
 typedef volatile enum task_state_s {
   TASK_STATE_NOT_CONFIGURED,
@@ -51,62 +55,96 @@ typedef volatile enum task_state_s {
 typedef uint32_t timer_id_t;
 #define ITTI_INVALID_TIMER_ID (timer_id_t) 0
 
+// Resolution of the ITTI timers, counted on the monotonic clock
+#define ITTI_TIMER_TICK_MS 1
+
+// A task may be served by several threads, its shards, each one with its own
+// mailbox. A message goes to the shard given by the key the task computes
+// for it, modulo the number of shards, so that the messages sharing a key
+// are received in order by a same thread.
+#define ITTI_MAX_TASK_SHARDS 64
+typedef uint64_t (*itti_shard_key_t)(const itti_msg& msg);
+
 class itti_timer {
  public:
   itti_timer(
-      const timer_id_t id, const task_id_t task_id, const uint32_t interval_sec,
-      const uint32_t interval_us, uint64_t arg1_user, uint64_t arg2_user)
-      : id(id), task_id(task_id), arg1_user(arg1_user), arg2_user(arg2_user) {
-    time_out = std::chrono::system_clock::now() +
-               std::chrono::seconds(interval_sec) +
-               std::chrono::microseconds(interval_us);
-  }
-  itti_timer(
-      const timer_id_t id, const task_id_t task_id,
-      const std::chrono::system_clock::time_point time_out, uint64_t arg1_user,
-      uint64_t arg2_user)
+      const timer_id_t id, const task_id_t task_id, const unsigned int shard,
+      uint64_t arg1_user, uint64_t arg2_user)
       : id(id),
         task_id(task_id),
-        time_out(time_out),
+        shard(shard),
         arg1_user(arg1_user),
-        arg2_user(arg2_user) {}
+        arg2_user(arg2_user),
+        wheel_timer(util::timing_wheel::null_timer) {}
   itti_timer(const itti_timer& t)
       : id(t.id),
         task_id(t.task_id),
-        time_out(t.time_out),
+        shard(t.shard),
         arg1_user(t.arg1_user),
-        arg2_user(t.arg2_user) {}
-  // itti_timer(itti_timer&& t) noexcept : id(std::move(t.id)),
-  // task_id(std::move(t.task_id)) , time_out(std::move(t.time_out)) {}
-
-  bool operator<(const itti_timer& t) const { return time_out < t.time_out; }
+        arg2_user(t.arg2_user),
+        wheel_timer(t.wheel_timer) {}
   ~itti_timer() {}
   timer_id_t id;
   task_id_t task_id;
-  std::chrono::system_clock::time_point time_out;
+  // Shard of the task which set up the timer, the time-out goes back to it
+  unsigned int shard;
   uint64_t arg1_user;
   uint64_t arg2_user;
+  // Handle in itti_mw::timer_wheel
+  uint64_t wheel_timer;
 };
 
-//------------------------------------------------------------------------------
-struct timer_comparator {
-  bool operator()(const itti_timer& left, const itti_timer& right) const {
-    return (left.time_out < right.time_out);
-  }
-};
+// Messages sent to a task and not received yet. Beyond the ring, they wait in
+// an overflow queue so that a sender is never blocked.
+#define ITTI_MAILBOX_SIZE 4096
+// Messages taken from the mailbox per wake up of a task
+#define ITTI_RECEIVE_BATCH 32
+
+typedef struct itti_mail_s {
+  std::shared_ptr<itti_msg> msg;
+  // steady_clock, for the latency gauge
+  uint64_t sent_ns;
+} itti_mail_t;
+
+typedef struct itti_task_gauges_s {
+  // Messages sent and not received yet
+  uint64_t depth;
+  uint64_t max_depth;
+  uint64_t received;
+  uint64_t wake_ups;
+  // Messages which did not fit in the ring
+  uint64_t overflowed;
+  // Time spent in the mailbox
+  uint64_t mean_latency_ns;
+  uint64_t max_latency_ns;
+} itti_task_gauges_t;
 
 class itti_task_ctxt {
  public:
-  explicit itti_task_ctxt(const task_id_t task_id)
+  itti_task_ctxt(const task_id_t task_id, const unsigned int shard)
       : task_id(task_id),
+        shard(shard),
         m_state(),
         task_state(TASK_STATE_STARTING),
-        msg_queue(),
-        m_queue(),
-        c_queue() {}
+        mailbox(ITTI_MAILBOX_SIZE),
+        sleeping(0),
+        overflow_size(0),
+        overflow(),
+        m_overflow(),
+        batch_next(0),
+        batch_count(0),
+        sent(0),
+        received(0),
+        wake_ups(0),
+        overflowed(0),
+        max_depth(0),
+        latency_sum_ns(0),
+        max_latency_ns(0) {}
   ~itti_task_ctxt() {}
 
   const task_id_t task_id;
+  // 0 if the task is not sharded
+  const unsigned int shard;
   /*
    * pthread associated with the thread
    */
@@ -118,37 +156,84 @@ class itti_task_ctxt {
   std::mutex m_state;
   volatile task_state_t task_state;
 
-  std::queue<std::shared_ptr<itti_msg>> msg_queue;
-  std::mutex m_queue;
-  std::condition_variable c_queue;
+  util::mpsc_ring<itti_mail_t> mailbox;
+  // Futex word, 1 while the task is parked or about to be
+  std::atomic<uint32_t> sleeping;
+  std::atomic<uint64_t> overflow_size;
+  std::queue<itti_mail_t> overflow;
+  std::mutex m_overflow;
+
+  // Received by the task and not handed out yet, only touched by the task
+  std::shared_ptr<itti_msg> batch[ITTI_RECEIVE_BATCH];
+  unsigned int batch_next;
+  unsigned int batch_count;
+
+  // Gauges, sent is incremented by the senders, the others by the task
+  std::atomic<uint64_t> sent;
+  std::atomic<uint64_t> received;
+  std::atomic<uint64_t> wake_ups;
+  std::atomic<uint64_t> overflowed;
+  std::atomic<uint64_t> max_depth;
+  std::atomic<uint64_t> latency_sum_ns;
+  std::atomic<uint64_t> max_latency_ns;
 };
 
 class itti_mw {
  private:
   itti_task_ctxt* itti_task_ctxts[TASK_MAX];
+  // Every started task has at least one shard, the first one is also in
+  // itti_task_ctxts. A key is only given for the tasks with several shards.
+  std::vector<itti_task_ctxt*> task_shards[TASK_MAX];
+  itti_shard_key_t shard_keys[TASK_MAX];
+  // Sharded task served by the calling thread, TASK_NONE if none
+  static thread_local task_id_t current_task;
+  static thread_local unsigned int current_shard;
 
   /*
    * Current message number. Incremented every call to send_msg_to_task
    */
   unsigned long msg_number;
-  timer_id_t timer_id;
-  std::mutex m_timer_id;
+  std::atomic<timer_id_t> timer_id;
   std::thread timer_thread;
 
   std::atomic<int> created_tasks;
   std::atomic<int> ready_tasks;
 
-  std::set<itti_timer, timer_comparator> timers;
-  itti_timer current_timer;
+  // Running timers by id, their expiry in ticks of ITTI_TIMER_TICK_MS
+  // since timer_epoch
+  std::unordered_map<timer_id_t, itti_timer> timers;
+  util::timing_wheel timer_wheel;
+  const std::chrono::steady_clock::time_point timer_epoch;
+  // Tick the timer thread sleeps until, UINT64_MAX if no timer is running
+  uint64_t timer_wake_up;
   std::mutex m_timers;
   std::condition_variable c_timers;
 
-  std::mutex m_timeout;
-  std::condition_variable c_timeout;
-
   bool terminate;
 
   static void timer_manager_task(const util::thread_sched_params& sched_params);
+  uint64_t timer_now() const;
+  // Deliver the time-outs of a task, with their shard, with a single wake up
+  // per shard
+  void send_timeout_msgs(
+      const task_id_t task_id,
+      std::vector<std::pair<unsigned int, std::shared_ptr<itti_msg>>>& msgs);
+
+  // Shard a message is sent to, nullptr if the task is not started
+  itti_task_ctxt* destination_ctxt(const itti_msg& message) const;
+  // Shard of task_id served by the calling thread
+  itti_task_ctxt* receiving_ctxt(const task_id_t task_id) const;
+  void wait_task_started(itti_task_ctxt* ctxt) const;
+
+  static uint64_t steady_ns();
+  // Enqueue without waking up the task
+  static void post_msg(
+      itti_task_ctxt* ctxt, std::shared_ptr<itti_msg> message,
+      const uint64_t now_ns);
+  static void wake_up(itti_task_ctxt* ctxt);
+  // Called by the task: fill its batch from the mailbox, park if it is empty
+  // and block is set
+  static bool fill_batch(itti_task_ctxt* ctxt, const bool block);
 
  public:
   itti_mw();
@@ -180,6 +265,16 @@ class itti_mw {
    **/
   std::shared_ptr<itti_msg> receive_msg(task_id_t task_id);
 
+  /** \brief Retrieves up to max_msgs messages in the queue associated to
+   * task_id, blocks till at least one message arrives.
+   \param task_id Task ID of the receiving task
+   \param msgs Messages received, appended
+   @returns the number of messages appended
+   **/
+  std::size_t receive_msgs(
+      task_id_t task_id, std::vector<std::shared_ptr<itti_msg>>& msgs,
+      const std::size_t max_msgs = ITTI_RECEIVE_BATCH);
+
   /** \brief Try to retrieves a message in the queue associated to task_id.
    \param task_id Task ID of the receiving task
    \param received_msg Pointer to the allocated message
@@ -195,6 +290,28 @@ class itti_mw {
   int create_task(
       const task_id_t task_id, void (*start_routine)(void*), void* args_p);
 
+  /** \brief Start num_shards threads serving the task, each one running
+   * start_routine, the messages are dispatched to them by shard_key
+   * \param task_id task to start
+   * \param start_routine entry point for every shard of the task
+   * \param args_p Optional argument to pass to the start routine
+   * \param num_shards number of threads, up to ITTI_MAX_TASK_SHARDS
+   * \param shard_key key of a message sent to the task
+   * @returns -1 on failure, 0 otherwise
+   **/
+  int create_task_shards(
+      const task_id_t task_id, void (*start_routine)(void*), void* args_p,
+      const unsigned int num_shards, itti_shard_key_t shard_key);
+
+  /** \brief Number of threads serving a started task, 0 if not started
+   **/
+  unsigned int get_num_shards(const task_id_t task_id) const;
+
+  /** \brief Shard of task_id served by the calling thread, 0 if the calling
+   * thread does not serve this task
+   **/
+  unsigned int get_current_shard(const task_id_t task_id) const;
+
   /** \brief Notify ITTI of a started thread
    * \param task_id of started task
    * \param start_routine entry point for the task
@@ -242,6 +359,16 @@ class itti_mw {
    **/
   int timer_remove(timer_id_t timer_id);
 
+  /** \brief Gauges of the mailbox of a task, summed over its shards
+   *  @returns -1 if the task is not started, 0 otherwise
+   **/
+  int get_task_gauges(task_id_t task_id, itti_task_gauges_t& gauges) const;
+
+  /** \brief Gauges of the started tasks, Prometheus text exposition format
+   *  \param prefix prefix of the metric names, e.g. "spgwu"
+   **/
+  std::string to_prometheus(const std::string& prefix) const;
+
   static void signal_handler(int signum);
 };
 
@@ -36,6 +36,11 @@
 #include "pgwc_sxab.hpp"
 #include "string.hpp"
 
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
 #include <stdexcept>
 
 using namespace pgwc;
@@ -55,21 +60,22 @@ int pgw_app::apply_config(const pgw_config& cfg) {
   Logger::pgwc_app().info("Apply config...");
 
   for (int ia = 0; ia < cfg.num_apn; ia++) {
-    if (cfg.apn[ia].pool_id_iv4 >= 0) {
-      int pool_id = cfg.apn[ia].pool_id_iv4;
-      int range   = be32toh(cfg.ue_pool_range_high[pool_id].s_addr) -
+    for (auto pool_id : cfg.apn[ia].pool_ids_iv4) {
+      int range = be32toh(cfg.ue_pool_range_high[pool_id].s_addr) -
                   be32toh(cfg.ue_pool_range_low[pool_id].s_addr);
       paa_dynamic::get_instance().add_pool(
           cfg.apn[ia].apn_label, pool_id, cfg.ue_pool_range_low[pool_id],
           range);
     }
-    if (cfg.apn[ia].pool_id_iv6 >= 0) {
-      int pool_id = cfg.apn[ia].pool_id_iv6;
+    for (auto pool_id : cfg.apn[ia].pool_ids_iv6) {
       paa_dynamic::get_instance().add_pool(
           cfg.apn[ia].apn_label, pool_id, cfg.paa_pool6_prefix[pool_id],
           cfg.paa_pool6_prefix_len[pool_id]);
     }
   }
+  if (cfg.ue_pool_snapshot_file.size()) {
+    paa_dynamic::get_instance().load_ipv4_snapshot(cfg.ue_pool_snapshot_file);
+  }
 
   Logger::pgwc_app().info("Applied config");
   return RETURNok;
@@ -77,56 +83,114 @@ int pgw_app::apply_config(const pgw_config& cfg) {
 
 //------------------------------------------------------------------------------
 teid_t pgw_app::generate_s5s8_cp_teid() {
-  std::unique_lock<std::mutex> ls(m_s5s8_cp_teid_generator);
-  teid_t teid = ++teid_s5s8_cp_generator;
-  while ((is_s5s8c_teid_exist(teid)) || (teid == UNASSIGNED_TEID)) {
-    teid = ++teid_s5s8_cp_generator;
-  }
-  s5s8cplteid.insert(teid);
+  const unsigned int shard = itti_inst->get_current_shard(TASK_PGWC_APP);
+  pgw_app_shard& s         = shards[shard];
+  std::unique_lock<std::mutex> ls(s.m_s5s8_cp_teid_generator);
+  teid_t teid = s.teid_s5s8_cp_generator;
+  do {
+    const teid_t next = teid + num_shards;
+    // Wraps around on the first TEID of the shard
+    teid = (next < teid) ? shard : next;
+  } while ((s.s5s8cplteid.count(teid)) || (teid == UNASSIGNED_TEID));
+  s.teid_s5s8_cp_generator = teid;
+  s.s5s8cplteid.insert(teid);
   ls.unlock();
   return teid;
 }
 
 //------------------------------------------------------------------------------
 bool pgw_app::is_s5s8c_teid_exist(const teid_t& teid_s5s8_cp) const {
-  return bool{s5s8cplteid.count(teid_s5s8_cp) > 0};
+  pgw_app_shard& s = teid_shard(teid_s5s8_cp);
+  std::unique_lock<std::mutex> ls(s.m_s5s8_cp_teid_generator);
+  return bool{s.s5s8cplteid.count(teid_s5s8_cp) > 0};
 }
 
 //------------------------------------------------------------------------------
 void pgw_app::free_s5s8c_teid(const teid_t& teid_s5s8_cp) {
-  s5s8cplteid.erase(teid_s5s8_cp);  // can return value of erase
+  pgw_app_shard& s = teid_shard(teid_s5s8_cp);
+  std::unique_lock<std::mutex> ls(s.m_s5s8_cp_teid_generator);
+  s.s5s8cplteid.erase(teid_s5s8_cp);  // can return value of erase
+}
+
+//------------------------------------------------------------------------------
+uint64_t pgw_app::imsi64_shard_key(const imsi64_t& imsi64) {
+  // The IMSIs of a network are often consecutive, spread them
+  return (imsi64 * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+//------------------------------------------------------------------------------
+uint64_t pgw_app::shard_key(const itti_msg& msg) {
+  switch (msg.msg_type) {
+    case S5S8_CREATE_SESSION_REQUEST: {
+      const itti_s5s8_create_session_request& m =
+          static_cast<const itti_s5s8_create_session_request&>(msg);
+      imsi_t imsi = {};
+      if (m.gtp_ies.get(imsi)) {
+        return imsi64_shard_key(imsi.to_imsi64());
+      }
+      return m.teid;
+    }
+    case S5S8_DELETE_SESSION_REQUEST:
+    case S5S8_MODIFY_BEARER_REQUEST:
+    case S5S8_RELEASE_ACCESS_BEARERS_REQUEST:
+    case S5S8_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE:
+      return static_cast<const itti_s5s8_msg&>(msg).teid;
+    case SXAB_SESSION_ESTABLISHMENT_RESPONSE:
+    case SXAB_SESSION_MODIFICATION_RESPONSE:
+    case SXAB_SESSION_DELETION_RESPONSE:
+    case SXAB_SESSION_REPORT_REQUEST:
+      return (teid_t) static_cast<const itti_sxab_msg&>(msg).seid;
+    default:
+      return 0;
+  }
+}
+//------------------------------------------------------------------------------
+pgw_app_shard& pgw_app::imsi64_shard(const imsi64_t& imsi64) const {
+  return shards[imsi64_shard_key(imsi64) % num_shards];
+}
+//------------------------------------------------------------------------------
+pgw_app_shard& pgw_app::teid_shard(const teid_t& teid) const {
+  return shards[teid % num_shards];
+}
+//------------------------------------------------------------------------------
+pgw_app_shard& pgw_app::seid_shard(const seid_t& seid) const {
+  return shards[((teid_t) seid) % num_shards];
 }
 
 //------------------------------------------------------------------------------
 bool pgw_app::is_imsi64_2_pgw_context(const imsi64_t& imsi64) const {
-  std::shared_lock lock(m_imsi2pgw_context);
-  return bool{imsi2pgw_context.count(imsi64) > 0};
+  pgw_app_shard& s = imsi64_shard(imsi64);
+  std::shared_lock lock(s.m_imsi2pgw_context);
+  return bool{s.imsi2pgw_context.count(imsi64) > 0};
 }
 //------------------------------------------------------------------------------
 std::shared_ptr<pgw_context> pgw_app::imsi64_2_pgw_context(
     const imsi64_t& imsi64) const {
-  std::shared_lock lock(m_imsi2pgw_context);
-  return imsi2pgw_context.at(imsi64);
+  pgw_app_shard& s = imsi64_shard(imsi64);
+  std::shared_lock lock(s.m_imsi2pgw_context);
+  return s.imsi2pgw_context.at(imsi64);
 }
 //------------------------------------------------------------------------------
 void pgw_app::set_imsi64_2_pgw_context(
     const imsi64_t& imsi64, std::shared_ptr<pgw_context> pc) {
-  std::unique_lock lock(m_imsi2pgw_context);
-  imsi2pgw_context[imsi64] = pc;
+  pgw_app_shard& s = imsi64_shard(imsi64);
+  std::unique_lock lock(s.m_imsi2pgw_context);
+  s.imsi2pgw_context[imsi64] = pc;
 }
 //------------------------------------------------------------------------------
 void pgw_app::set_seid_2_pgw_context(
     const seid_t& seid, std::shared_ptr<pgw_context>& pc) {
-  std::unique_lock lock(m_seid2pgw_context);
-  seid2pgw_context[seid] = pc;
+  pgw_app_shard& s = seid_shard(seid);
+  std::unique_lock lock(s.m_seid2pgw_context);
+  s.seid2pgw_context[seid] = pc;
 }
 //------------------------------------------------------------------------------
 bool pgw_app::seid_2_pgw_context(
     const seid_t& seid, std::shared_ptr<pgw_context>& pc) const {
-  std::shared_lock lock(m_seid2pgw_context);
+  pgw_app_shard& s = seid_shard(seid);
+  std::shared_lock lock(s.m_seid2pgw_context);
   std::map<seid_t, std::shared_ptr<pgw_context>>::const_iterator it =
-      seid2pgw_context.find(seid);
-  if (it != seid2pgw_context.end()) {
+      s.seid2pgw_context.find(seid);
+  if (it != s.seid2pgw_context.end()) {
     pc = it->second;
     return true;
   }
@@ -152,21 +216,27 @@ fteid_t pgw_app::generate_s5s8_cp_fteid(const struct in_addr ipv4_address) {
 }
 //------------------------------------------------------------------------------
 void pgw_app::free_s5s8_cp_fteid(const fteid_t& fteid) {
-  std::unique_lock lock(m_s5s8lteid2pgw_context);
-  s5s8lteid2pgw_context.erase(fteid.teid_gre_key);
+  pgw_app_shard& s = teid_shard(fteid.teid_gre_key);
+  std::unique_lock lock(s.m_s5s8lteid2pgw_context);
+  s.s5s8lteid2pgw_context.erase(fteid.teid_gre_key);
+  lock.unlock();
   free_s5s8c_teid(fteid.teid_gre_key);
 }
 //------------------------------------------------------------------------------
 bool pgw_app::is_s5s8cpgw_fteid_2_pgw_context(
     const fteid_t& ls5s8_fteid) const {
-  std::shared_lock lock(m_s5s8lteid2pgw_context);
-  return bool{s5s8lteid2pgw_context.count(ls5s8_fteid.teid_gre_key) > 0};
+  pgw_app_shard& s = teid_shard(ls5s8_fteid.teid_gre_key);
+  std::shared_lock lock(s.m_s5s8lteid2pgw_context);
+  return bool{s.s5s8lteid2pgw_context.count(ls5s8_fteid.teid_gre_key) > 0};
 }
 //------------------------------------------------------------------------------
 std::shared_ptr<pgw_context> pgw_app::s5s8cpgw_fteid_2_pgw_context(
     fteid_t& ls5s8_fteid) {
-  if (is_s5s8cpgw_fteid_2_pgw_context(ls5s8_fteid)) {
-    return s5s8lteid2pgw_context.at(ls5s8_fteid.teid_gre_key);
+  pgw_app_shard& s = teid_shard(ls5s8_fteid.teid_gre_key);
+  std::shared_lock lock(s.m_s5s8lteid2pgw_context);
+  auto it = s.s5s8lteid2pgw_context.find(ls5s8_fteid.teid_gre_key);
+  if (it != s.s5s8lteid2pgw_context.end()) {
+    return it->second;
   } else {
     return std::shared_ptr<pgw_context>(nullptr);
   }
@@ -174,22 +244,69 @@ std::shared_ptr<pgw_context> pgw_app::s5s8cpgw_fteid_2_pgw_context(
 //------------------------------------------------------------------------------
 void pgw_app::set_s5s8cpgw_fteid_2_pgw_context(
     fteid_t& ls5s8_fteid, std::shared_ptr<pgw_context> spc) {
-  std::unique_lock lock(m_s5s8lteid2pgw_context);
-  s5s8lteid2pgw_context[ls5s8_fteid.teid_gre_key] = spc;
+  pgw_app_shard& s = teid_shard(ls5s8_fteid.teid_gre_key);
+  std::unique_lock lock(s.m_s5s8lteid2pgw_context);
+  s.s5s8lteid2pgw_context[ls5s8_fteid.teid_gre_key] = spc;
 }
 
 //------------------------------------------------------------------------------
 void pgw_app::delete_pgw_context(std::shared_ptr<pgw_context> spc) {
-  imsi64_t imsi64 = spc.get()->imsi.to_imsi64();
-  std::unique_lock lock(m_imsi2pgw_context);
-  imsi2pgw_context.erase(imsi64);
+  imsi64_t imsi64  = spc.get()->imsi.to_imsi64();
+  pgw_app_shard& s = imsi64_shard(imsi64);
+  std::unique_lock lock(s.m_imsi2pgw_context);
+  s.imsi2pgw_context.erase(imsi64);
 }
 //------------------------------------------------------------------------------
 void pgw_app::restore_sx_sessions(const seid_t& seid) const {
-  std::shared_lock lock(m_seid2pgw_context);
+  std::shared_lock lock(seid_shard(seid).m_seid2pgw_context);
   // TODO
 }
 
+//------------------------------------------------------------------------------
+void pgw_app::start_timer_stats() {
+  timer_stats_id = itti_inst->timer_setup(
+      pgw_cfg.stats_interval_sec, 0, TASK_PGWC_APP,
+      TASK_PGWC_APP_TIMEOUT_STATS);
+}
+//------------------------------------------------------------------------------
+// Written to a temporary file first, then renamed, so that a scraper never
+// reads a partial file
+static bool write_stats_file(const std::string& path, const std::string& text) {
+  const std::string tmp_path = path + ".tmp";
+  std::ofstream ofs(tmp_path, std::ios::out | std::ios::trunc);
+  if (not ofs) {
+    Logger::pgwc_app().error(
+        "Could not open %s (%s)", tmp_path.c_str(), strerror(errno));
+    return false;
+  }
+  ofs << text;
+  ofs.close();
+  if (not ofs) {
+    Logger::pgwc_app().error("Could not write %s", tmp_path.c_str());
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+    Logger::pgwc_app().error(
+        "Could not rename %s (%s)", tmp_path.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+void pgw_app::time_out_stats(const timer_id_t timer_id) {
+  // Formatted here, the file is written by the async command task
+  const std::string text = itti_inst->to_prometheus("spgwc");
+  const std::string path = pgw_cfg.stats_file;
+  async_shell_cmd_inst->run_job(
+      TASK_PGWC_APP, false, __FILE__, __LINE__, "write " + path,
+      [text, path]() {
+        return write_stats_file(path, text) ? RETURNok : RETURNerror;
+      });
+  start_timer_stats();
+}
+
 //------------------------------------------------------------------------------
 void pgw_app_task(void*) {
   const task_id_t task_id = TASK_PGWC_APP;
@@ -260,7 +377,14 @@ void pgw_app_task(void*) {
 
       case TIME_OUT:
         if (itti_msg_timeout* to = dynamic_cast<itti_msg_timeout*>(msg)) {
-          Logger::pgwc_app().info("TIME-OUT event timer id %d", to->timer_id);
+          switch (to->arg1_user) {
+            case TASK_PGWC_APP_TIMEOUT_STATS:
+              pgw_app_inst->time_out_stats(to->timer_id);
+              break;
+            default:
+              Logger::pgwc_app().info(
+                  "TIME-OUT event timer id %d", to->timer_id);
+          }
         }
         break;
       case TERMINATE:
@@ -279,24 +403,28 @@ void pgw_app_task(void*) {
 
 //------------------------------------------------------------------------------
 pgw_app::pgw_app(const std::string& config_file)
-    : m_s5s8_cp_teid_generator(),
-      m_imsi2pgw_context(),
-      m_s5s8lteid2pgw_context(),
-      m_seid2pgw_context() {
+    : num_shards(pgw_cfg.itti.pgw_app_shards),
+      shards(new pgw_app_shard[pgw_cfg.itti.pgw_app_shards]) {
   Logger::pgwc_app().startup("Starting...");
 
-  teid_s5s8_cp_generator = 0;
-  imsi2pgw_context       = {};
-  s5s8lteid2pgw_context  = {};
-  s5s8cplteid            = {};
+  for (unsigned int i = 0; i < num_shards; i++) {
+    shards[i].teid_s5s8_cp_generator = i;
+  }
 
   apply_config(pgw_cfg);
 
-  if (itti_inst->create_task(TASK_PGWC_APP, pgw_app_task, nullptr)) {
+  if (itti_inst->create_task_shards(
+          TASK_PGWC_APP, pgw_app_task, nullptr, num_shards,
+          pgw_app::shard_key)) {
     Logger::pgwc_app().error("Cannot create task TASK_PGWC_APP");
     throw std::runtime_error("Cannot create task TASK_PGWC_APP");
   }
 
+  timer_stats_id = ITTI_INVALID_TIMER_ID;
+  if (pgw_cfg.stats_file.size()) {
+    start_timer_stats();
+  }
+
   try {
     pgw_s5s8_inst  = new pgw_s5s8();
     pgwc_sxab_inst = new pgwc_sxab();
@@ -307,6 +435,14 @@ pgw_app::pgw_app(const std::string& config_file)
 
   Logger::pgwc_app().startup("Started");
 }
+
+//------------------------------------------------------------------------------
+pgw_app::~pgw_app() {
+  if (pgw_cfg.ue_pool_snapshot_file.size()) {
+    paa_dynamic::get_instance().save_ipv4_snapshot(
+        pgw_cfg.ue_pool_snapshot_file);
+  }
+}
 //------------------------------------------------------------------------------
 void pgw_app::send_create_session_response_cause(
     const uint64_t gtpc_tx_id, const teid_t teid, const endpoint& r_endpoint,
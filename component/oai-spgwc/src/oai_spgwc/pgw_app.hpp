@@ -28,13 +28,19 @@
 #ifndef FILE_PGW_APP_HPP_SEEN
 #define FILE_PGW_APP_HPP_SEEN
 
+// arg1_user of the timers of TASK_PGWC_APP
+#define TASK_PGWC_APP_TIMEOUT_STATS (0)
+
 #include "3gpp_29.274.h"
+#include "itti.hpp"
 #include "itti_msg_s5s8.hpp"
 #include "itti_msg_sxab.hpp"
 #include "pgw_context.hpp"
 #include "pgw_pco.hpp"
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <shared_mutex>
 #include <string>
@@ -46,11 +52,26 @@ namespace pgwc {
 // zzz;
 class pgw_config;  // same namespace
 
-class pgw_app {
- private:
-  std::thread::id thread_id;
-  std::thread thread;
-  // teid generators (linear)
+// Contexts of the UEs served by a shard of TASK_PGWC_APP. A shard allocates
+// the S5S8 TEIDs congruent to its index modulo the number of shards, and so
+// are the SEIDs built on them: the messages of a UE, routed by IMSI, TEID or
+// SEID, are all handled by the thread of its shard.
+class pgw_app_shard {
+ public:
+  pgw_app_shard()
+      : teid_s5s8_cp_generator(0),
+        imsi2pgw_context(),
+        s5s8lteid2pgw_context(),
+        seid2pgw_context(),
+        s5s8cplteid(),
+        m_s5s8_cp_teid_generator(),
+        m_imsi2pgw_context(),
+        m_s5s8lteid2pgw_context(),
+        m_seid2pgw_context() {}
+  pgw_app_shard(pgw_app_shard const&) = delete;
+  void operator=(pgw_app_shard const&) = delete;
+
+  // teid generator (linear, stepping by the number of shards)
   teid_t teid_s5s8_cp_generator;
 
   std::map<imsi64_t, std::shared_ptr<pgw_context>> imsi2pgw_context;
@@ -64,9 +85,24 @@ class pgw_app {
   mutable std::shared_mutex m_imsi2pgw_context;
   mutable std::shared_mutex m_s5s8lteid2pgw_context;
   mutable std::shared_mutex m_seid2pgw_context;
+};
+
+class pgw_app {
+ private:
+  std::thread::id thread_id;
+  std::thread thread;
+
+  unsigned int num_shards;
+  std::unique_ptr<pgw_app_shard[]> shards;
+  timer_id_t timer_stats_id;
 
   int apply_config(const pgw_config& cfg);
 
+  pgw_app_shard& imsi64_shard(const imsi64_t& imsi64) const;
+  pgw_app_shard& teid_shard(const teid_t& teid) const;
+  // The SEIDs are built on the S5S8 TEIDs
+  pgw_app_shard& seid_shard(const seid_t& seid) const;
+
   teid_t generate_s5s8_cp_teid();
   void free_s5s8c_teid(const teid_t& teid_s5s8_cp);
   bool is_s5s8c_teid_exist(const teid_t& teid_s5s8_cp) const;
@@ -98,9 +134,14 @@ class pgw_app {
 
  public:
   explicit pgw_app(const std::string& config_file);
+  ~pgw_app();
   pgw_app(pgw_app const&) = delete;
   void operator=(pgw_app const&) = delete;
 
+  // Key of the messages sent to TASK_PGWC_APP, see itti_shard_key_t
+  static uint64_t shard_key(const itti_msg& msg);
+  static uint64_t imsi64_shard_key(const imsi64_t& imsi64);
+
   void send_create_session_response_cause(
       const uint64_t gtpc_tx_id, const teid_t teid, const endpoint& r_endpoint,
       const cause_t& cause) const;
@@ -164,6 +205,10 @@ class pgw_app {
   void handle_itti_msg(itti_sxab_association_setup_request& m);
 
   void restore_sx_sessions(const seid_t& seid) const;
+
+  // Periodic write of the ITTI task gauges to pgw_cfg.stats_file
+  void start_timer_stats();
+  void time_out_stats(const timer_id_t timer_id);
 };
 }  // namespace pgwc
 #include "pgw_config.hpp"
@@ -31,6 +31,7 @@
 #include "common_defs.h"
 #include "epc.h"
 #include "if.hpp"
+#include "itti.hpp"
 #include "logger.hpp"
 #include "pgw_app.hpp"
 #include "string.hpp"
@@ -184,6 +185,15 @@ int pgw_config::load_itti(const Setting& itti_cfg, itti_cfg_t& cfg) {
         "%s : %s, using defaults", nfex.what(), nfex.getPath());
   }
 
+  itti_cfg.lookupValue(PGW_CONFIG_STRING_PGW_APP_SHARDS, cfg.pgw_app_shards);
+  if ((cfg.pgw_app_shards < 1) ||
+      (cfg.pgw_app_shards > ITTI_MAX_TASK_SHARDS)) {
+    Logger::pgwc_app().error(
+        PGW_CONFIG_STRING_PGW_APP_SHARDS " %u out of [1..%d], using %d",
+        cfg.pgw_app_shards, ITTI_MAX_TASK_SHARDS, PGW_DEFAULT_APP_SHARDS);
+    cfg.pgw_app_shards = PGW_DEFAULT_APP_SHARDS;
+  }
+
   return RETURNok;
 }
 
@@ -240,6 +250,23 @@ int pgw_config::load_interface(const Setting& if_cfg, interface_cfg_t& cfg) {
   return RETURNok;
 }
 
+//------------------------------------------------------------------------------
+void pgw_config::load_pool_ids(
+    const Setting& apn_cfg, const char* name, std::vector<int>& ids) {
+  ids.clear();
+  if (not apn_cfg.exists(name)) return;
+  const Setting& pool_cfg = apn_cfg[name];
+  if (pool_cfg.isAggregate()) {
+    for (int i = 0; i < pool_cfg.getLength(); i++) {
+      const int id = pool_cfg[i];
+      if (id >= 0) ids.push_back(id);
+    }
+  } else {
+    const int id = pool_cfg;
+    if (id >= 0) ids.push_back(id);
+  }
+}
+
 //------------------------------------------------------------------------------
 int pgw_config::load(const string& config_file) {
   Config cfg;
@@ -285,6 +312,17 @@ int pgw_config::load(const string& config_file) {
         "%s : %s, using defaults", nfex.what(), nfex.getPath());
   }
 
+  pgw_cfg.lookupValue(PGW_CONFIG_STRING_STATS_FILE, stats_file);
+  unsigned int stats_interval = 0;
+  if (pgw_cfg.lookupValue(PGW_CONFIG_STRING_STATS_INTERVAL, stats_interval)) {
+    if (stats_interval == 0) {
+      Logger::pgwc_app().error(
+          "%s must be > 0", PGW_CONFIG_STRING_STATS_INTERVAL);
+      return RETURNerror;
+    }
+    stats_interval_sec = stats_interval;
+  }
+
   try {
     const Setting& itti_cfg = pgw_cfg[PGW_CONFIG_STRING_ITTI_TASKS];
     load_itti(itti_cfg, itti);
@@ -422,6 +460,9 @@ int pgw_config::load(const string& config_file) {
       num_paa6_pool += 1;
     }
 
+    pool_cfg.lookupValue(
+        PGW_CONFIG_STRING_IPV4_SNAPSHOT_FILE, ue_pool_snapshot_file);
+
     const Setting& apn_list_cfg = pgw_cfg[PGW_CONFIG_STRING_APN_LIST];
     count                       = apn_list_cfg.getLength();
     int apn_idx                 = 0;
@@ -446,19 +487,36 @@ int pgw_config::load(const string& config_file) {
             astring.c_str());
         throw("Error PDN_TYPE in config file");
       }
-      apn_cfg.lookupValue(
-          PGW_CONFIG_STRING_IPV4_POOL, apn[apn_idx].pool_id_iv4);
-      apn_cfg.lookupValue(
-          PGW_CONFIG_STRING_IPV6_POOL, apn[apn_idx].pool_id_iv6);
+      load_pool_ids(
+          apn_cfg, PGW_CONFIG_STRING_IPV4_POOL, apn[apn_idx].pool_ids_iv4);
+      load_pool_ids(
+          apn_cfg, PGW_CONFIG_STRING_IPV6_POOL, apn[apn_idx].pool_ids_iv6);
+
+      for (auto id : apn[apn_idx].pool_ids_iv4) {
+        if (id >= num_ue_pool) {
+          Logger::pgwc_app().error(
+              "Unknown " PGW_CONFIG_STRING_IPV4_POOL " %d in %d'th APN", id,
+              i + 1);
+          throw("Unknown " PGW_CONFIG_STRING_IPV4_POOL " in APN");
+        }
+      }
+      for (auto id : apn[apn_idx].pool_ids_iv6) {
+        if (id >= num_paa6_pool) {
+          Logger::pgwc_app().error(
+              "Unknown " PGW_CONFIG_STRING_IPV6_POOL " %d in %d'th APN", id,
+              i + 1);
+          throw("Unknown " PGW_CONFIG_STRING_IPV6_POOL " in APN");
+        }
+      }
 
-      if ((0 <= apn[apn_idx].pool_id_iv4) &&
+      if ((apn[apn_idx].pool_ids_iv4.size()) &&
           (apn[apn_idx].pdn_type.pdn_type == PDN_TYPE_E_IPV6)) {
         Logger::pgwc_app().error(
             "PDN_TYPE versus pool identifier %d 'th APN in config file\n",
             i + 1);
         throw("PDN_TYPE versus pool identifier APN");
       }
-      if ((0 <= apn[apn_idx].pool_id_iv6) &&
+      if ((apn[apn_idx].pool_ids_iv6.size()) &&
           (apn[apn_idx].pdn_type.pdn_type == PDN_TYPE_E_IPV4)) {
         Logger::pgwc_app().error(
             "PDN_TYPE versus pool identifier %d 'th APN in config file\n",
@@ -466,8 +524,8 @@ int pgw_config::load(const string& config_file) {
         throw("PDN_TYPE versus pool identifier APN");
       }
 
-      if (((0 <= apn[apn_idx].pool_id_iv4) ||
-           (0 <= apn[apn_idx].pool_id_iv6)) &&
+      if (((apn[apn_idx].pool_ids_iv4.size()) ||
+           (apn[apn_idx].pool_ids_iv6.size())) &&
           (not boost::iequals(apn[apn_idx].apn, "none"))) {
         bool doublon = false;
         for (int j = 0; j < apn_idx; j++) {
@@ -562,6 +620,11 @@ void pgw_config::display() {
   Logger::pgwc_app().info("Configuration PGW-C:");
   Logger::pgwc_app().info("- Instance ..............: %d\n", instance);
   Logger::pgwc_app().info("- PID dir ...............: %s\n", pid_dir.c_str());
+  if (stats_file.size()) {
+    Logger::pgwc_app().info(
+        "- Statistics ............: %s every %u s", stats_file.c_str(),
+        stats_interval_sec);
+  }
 
   Logger::pgwc_app().info("- S5S8-C Networking:");
   Logger::pgwc_app().info(
@@ -626,6 +689,7 @@ void pgw_config::display() {
       "    Scheduling policy : %d", itti.pgw_app_sched_params.sched_policy);
   Logger::pgwc_app().info(
       "    Scheduling prio  .: %d", itti.pgw_app_sched_params.sched_priority);
+  Logger::pgwc_app().info("    Shards............: %u", itti.pgw_app_shards);
   Logger::pgwc_app().info("- ITTI ASYNC_CMD task Threading:");
   Logger::pgwc_app().info(
       "    CPU id............: %d", itti.async_cmd_sched_params.cpu_id);
@@ -635,12 +699,16 @@ void pgw_config::display() {
       "    Scheduling prio  .: %d", itti.async_cmd_sched_params.sched_priority);
   Logger::pgwc_app().info("- " PGW_CONFIG_STRING_IP_ADDRESS_POOL ":");
   for (int i = 0; i < num_ue_pool; i++) {
-    std::string range_low(inet_ntoa(ue_pool_range_low[apn[i].pool_id_iv4]));
-    std::string range_high(inet_ntoa(ue_pool_range_high[apn[i].pool_id_iv4]));
+    std::string range_low(inet_ntoa(ue_pool_range_low[i]));
+    std::string range_high(inet_ntoa(ue_pool_range_high[i]));
     Logger::pgwc_app().info(
         "    IPv4 pool %d ..........: %s - %s", i, range_low.c_str(),
         range_high.c_str());
   }
+  if (ue_pool_snapshot_file.size()) {
+    Logger::pgwc_app().info(
+        "    IPv4 snapshot ........: %s", ue_pool_snapshot_file.c_str());
+  }
   char str_addr6[INET6_ADDRSTRLEN];
   for (int i = 0; i < num_paa6_pool; i++) {
     if (inet_ntop(
@@ -672,16 +740,16 @@ void pgw_config::display() {
     Logger::pgwc_app().info(
         "        " PGW_CONFIG_STRING_PDN_TYPE ":  %s",
         apn[i].pdn_type.toString().c_str());
-    if (apn[i].pool_id_iv4 >= 0) {
-      std::string range_low(inet_ntoa(ue_pool_range_low[apn[i].pool_id_iv4]));
-      std::string range_high(inet_ntoa(ue_pool_range_high[apn[i].pool_id_iv4]));
+    for (auto id : apn[i].pool_ids_iv4) {
+      std::string range_low(inet_ntoa(ue_pool_range_low[id]));
+      std::string range_high(inet_ntoa(ue_pool_range_high[id]));
       Logger::pgwc_app().info(
-          "        " PGW_CONFIG_STRING_IPV4_POOL ":  %d ( %s - %s)",
-          apn[i].pool_id_iv4, range_low.c_str(), range_high.c_str());
+          "        " PGW_CONFIG_STRING_IPV4_POOL ":  %d ( %s - %s)", id,
+          range_low.c_str(), range_high.c_str());
     }
-    if (apn[i].pool_id_iv6 >= 0) {
+    for (auto id : apn[i].pool_ids_iv6) {
       Logger::pgwc_app().info(
-          "        " PGW_CONFIG_STRING_IPV6_POOL ":  %d", apn[i].pool_id_iv6);
+          "        " PGW_CONFIG_STRING_IPV6_POOL ":  %d", id);
     }
   }
   Logger::pgwc_app().info("- PCEF support (in development)");
@@ -46,6 +46,8 @@
 #define PGW_CONFIG_STRING_PGW_CONFIG "P-GW"
 #define PGW_CONFIG_STRING_PID_DIRECTORY "PID_DIRECTORY"
 #define PGW_CONFIG_STRING_INSTANCE "INSTANCE"
+#define PGW_CONFIG_STRING_STATS_FILE "STATS_FILE"
+#define PGW_CONFIG_STRING_STATS_INTERVAL "STATS_INTERVAL"
 #define PGW_CONFIG_STRING_INTERFACES "INTERFACES"
 #define PGW_CONFIG_STRING_INTERFACE_NAME "INTERFACE_NAME"
 #define PGW_CONFIG_STRING_IPV4_ADDRESS "IPV4_ADDRESS"
@@ -67,6 +69,7 @@
 #define PGW_CONFIG_STRING_IPV6_ADDRESS_LIST "IPV6_LIST"
 #define PGW_CONFIG_STRING_RANGE "RANGE"
 #define PGW_CONFIG_STRING_PREFIX "PREFIX"
+#define PGW_CONFIG_STRING_IPV4_SNAPSHOT_FILE "IPV4_SNAPSHOT_FILE"
 #define PGW_CONFIG_STRING_IPV4_ADDRESS_RANGE_DELIMITER "-"
 #define PGW_CONFIG_STRING_IPV6_ADDRESS_PREFIX_DELIMITER "/"
 #define PGW_CONFIG_STRING_DEFAULT_DNS_IPV4_ADDRESS "DEFAULT_DNS_IPV4_ADDRESS"
@@ -124,6 +127,9 @@
 #define PGW_CONFIG_STRING_SX_SCHED_PARAMS "SX_SCHED_PARAMS"
 #define PGW_CONFIG_STRING_PGW_APP_SCHED_PARAMS "PGW_APP_SCHED_PARAMS"
 #define PGW_CONFIG_STRING_ASYNC_CMD_SCHED_PARAMS "ASYNC_CMD_SCHED_PARAMS"
+#define PGW_CONFIG_STRING_PGW_APP_SHARDS "PGW_APP_SHARDS"
+// Threads processing the sessions
+#define PGW_DEFAULT_APP_SHARDS 4
 
 #define PGW_MAX_ALLOCATED_PDN_ADDRESSES 1024
 
@@ -145,12 +151,17 @@ typedef struct itti_cfg_s {
   util::thread_sched_params s5s8_sched_params;
   util::thread_sched_params pgw_app_sched_params;
   util::thread_sched_params async_cmd_sched_params;
+  unsigned int pgw_app_shards;
 } itti_cfg_t;
 
 class pgw_config {
  private:
   int load_itti(const libconfig::Setting& itti_cfg, itti_cfg_t& cfg);
   int load_interface(const libconfig::Setting& if_cfg, interface_cfg_t& cfg);
+  // A pool id or a list of pool ids
+  void load_pool_ids(
+      const libconfig::Setting& apn_cfg, const char* name,
+      std::vector<int>& ids);
   int load_thread_sched_params(
       const libconfig::Setting& thread_sched_params_cfg,
       util::thread_sched_params& cfg);
@@ -160,6 +171,9 @@ class pgw_config {
   std::mutex m_rw_lock;
   std::string pid_dir;
   unsigned int instance = 0;
+  // ITTI task gauges in Prometheus text format, empty if not written
+  std::string stats_file;
+  unsigned int stats_interval_sec;
 
   interface_cfg_t s5s8_cp;
   interface_cfg_t sx;
@@ -175,8 +189,9 @@ class pgw_config {
   struct {
     std::string apn;
     std::string apn_label;
-    int pool_id_iv4;
-    int pool_id_iv6;
+    // Spill over to the next pool when a pool is full
+    std::vector<int> pool_ids_iv4;
+    std::vector<int> pool_ids_iv6;
     pdn_type_t pdn_type;
   } apn[PGW_NUM_APN_MAX];
 
@@ -192,6 +207,8 @@ class pgw_config {
   // The problem here is that OpenFlow do not deal with ip ranges but with
   // netmasks
   std::vector<struct in_addr> ue_pool_excluded[PGW_NUM_UE_POOL_MAX];
+  // Addresses in use saved at exit, held back at restart, empty if not used
+  std::string ue_pool_snapshot_file;
 
   int num_paa6_pool;
   struct in6_addr paa_pool6_prefix[PGW_NUM_UE_POOL_MAX];
@@ -212,6 +229,8 @@ class pgw_config {
         num_apn(0),
         pid_dir(),
         instance(0),
+        stats_file(),
+        stats_interval_sec(10),
         s5s8_cp(),
         sx(),
         itti() {
@@ -234,6 +253,7 @@ class pgw_config {
       paa_pool6_prefix_len[i] = {};
       ue_pool_excluded[i]     = {};
     }
+    ue_pool_snapshot_file = {};
     force_push_pco = true;
     // Do not change this value unless you know what you are doing
     ue_mtu = 1358;
@@ -243,6 +263,7 @@ class pgw_config {
     itti.s5s8_sched_params.sched_priority       = 84;
     itti.pgw_app_sched_params.sched_priority    = 84;
     itti.async_cmd_sched_params.sched_priority  = 84;
+    itti.pgw_app_shards                         = PGW_DEFAULT_APP_SHARDS;
 
     s5s8_cp.thread_rd_sched_params.sched_priority = 90;
     s5s8_cp.port                                  = gtpv2c::default_port;
@@ -186,6 +186,9 @@ void pgw_pdn_connection::deallocate_ressources(const std::string& apn) {
   if (ipv4) {
     paa_dynamic::get_instance().release_paa(apn, ipv4_address);
   }
+  if (ipv6) {
+    paa_dynamic::get_instance().release_paa(apn, ipv6_address);
+  }
   pgw_app_inst->free_s5s8_cp_fteid(pgw_fteid_s5_s8_cp);
   clear();
 }
@@ -636,7 +639,17 @@ void pgw_context::handle_itti_msg(
           }
           // Static IP address allocation
         } else if ((paa_res) && (paa.is_ip_assigned())) {
-          set_paa = true;
+          // Held by another UE: rejected, the address is not released
+          if (paa_dynamic::get_instance().reserve_paa(
+                  sa->apn_in_use, paa.ipv4_address)) {
+            set_paa = true;
+          } else {
+            Logger::pgwc_app().warn(
+                "Static IPv4 address %s already allocated",
+                conv::toString(paa.ipv4_address).c_str());
+            cause.cause_value = REQUEST_REJECTED;
+            cause.pce         = 1;
+          }
         }
       } else {
         // TODO allocation via DHCP
@@ -673,7 +686,16 @@ void pgw_context::handle_itti_msg(
           cause.pce         = 1;
         }
       } else if ((paa_res) && (paa.is_ip_assigned())) {
-        set_paa = true;
+        if (paa_dynamic::get_instance().reserve_paa(
+                sa->apn_in_use, paa.ipv4_address)) {
+          set_paa = true;
+        } else {
+          Logger::pgwc_app().warn(
+              "Static IPv4 address %s already allocated",
+              conv::toString(paa.ipv4_address).c_str());
+          cause.cause_value = REQUEST_REJECTED;
+          cause.pce         = 1;
+        }
       }
     } break;
 
@@ -738,12 +760,22 @@ void pgw_context::handle_itti_msg(
     if (s5s8->gtp_ies.get(free_paa)) {
       switch (sp->pdn_type.pdn_type) {
         case PDN_TYPE_E_IPV4:
+          paa_dynamic::get_instance().release_paa(
+              sa->apn_in_use, free_paa.ipv4_address);
+          break;
+
         case PDN_TYPE_E_IPV4V6:
           paa_dynamic::get_instance().release_paa(
               sa->apn_in_use, free_paa.ipv4_address);
+          paa_dynamic::get_instance().release_paa(
+              sa->apn_in_use, free_paa.ipv6_address);
           break;
 
         case PDN_TYPE_E_IPV6:
+          paa_dynamic::get_instance().release_paa(
+              sa->apn_in_use, free_paa.ipv6_address);
+          break;
+
         case PDN_TYPE_E_NON_IP:
         default:;
       }
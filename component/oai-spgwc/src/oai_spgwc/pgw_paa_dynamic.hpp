@@ -31,111 +31,297 @@
 
 #include "logger.hpp"
 
-#include <bitset>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <deque>
+#include <fstream>
 #include <map>
+#include <mutex>
+#include <string.h>
+#include <unordered_set>
+#include <vector>
 
+// Every UE gets its own /64 prefix (TS 23.401 5.3.1.2.2), allocated from
+// the prefix of the pool. The interface identifier is left to the UE.
 class ipv6_pool {
  public:
   struct in6_addr prefix;
   int prefix_len;
 
-  ipv6_pool() : prefix(), prefix_len(0) {}
+ protected:
+  // /64 prefixes of the pool are numbered from 0
+  uint64_t num;
+  uint64_t next;
+  std::vector<uint64_t> released;
+  std::unordered_set<uint64_t> allocated;
+
+  uint64_t first_prefix64() const {
+    uint64_t p = 0;
+    memcpy(&p, prefix.s6_addr, sizeof(p));
+    return be64toh(p);
+  }
 
-  ipv6_pool(const struct in6_addr prfix, const int prfix_len) {
-    prefix     = prfix;
-    prefix_len = prfix_len;
+  bool index_of(const struct in6_addr& a, uint64_t& index) const {
+    uint64_t p = 0;
+    memcpy(&p, a.s6_addr, sizeof(p));
+    p = be64toh(p);
+    if ((p < first_prefix64()) || (p - first_prefix64() >= num)) {
+      return false;
+    }
+    index = p - first_prefix64();
+    return true;
   }
 
-  ipv6_pool(const ipv6_pool& p) : prefix(p.prefix), prefix_len(p.prefix_len) {}
+ public:
+  ipv6_pool()
+      : prefix(), prefix_len(0), num(0), next(0), released(), allocated() {}
+
+  ipv6_pool(const struct in6_addr prfix, const int prfix_len)
+      : prefix(prfix),
+        prefix_len(prfix_len),
+        num(0),
+        next(0),
+        released(),
+        allocated() {
+    if ((prefix_len > 0) && (prefix_len <= 64)) {
+      num = (prefix_len == 64) ? 1 : (uint64_t) 1 << (64 - prefix_len);
+      // Keep the prefix bits only
+      uint64_t p = first_prefix64() & ~(num - 1);
+      p          = htobe64(p);
+      memcpy(prefix.s6_addr, &p, sizeof(p));
+      memset(&prefix.s6_addr[8], 0, 8);
+    } else {
+      Logger::pgwc_app().error(
+          "IPv6 pool prefix length %d: a /64 prefix must be allocated to each "
+          "UE, pool not used",
+          prefix_len);
+    }
+  }
 
-  bool alloc_address(struct in6_addr& allocated) {
-    allocated = prefix;
+  ipv6_pool(const ipv6_pool& p)
+      : prefix(p.prefix),
+        prefix_len(p.prefix_len),
+        num(p.num),
+        next(p.next),
+        released(p.released),
+        allocated(p.allocated) {}
+
+  bool alloc_address(struct in6_addr& allocated_prefix) {
+    uint64_t index = 0;
+    if (released.size()) {
+      index = released.back();
+      released.pop_back();
+    } else if (next < num) {
+      index = next++;
+    } else {
+      return false;
+    }
+    allocated.insert(index);
+    uint64_t p = htobe64(first_prefix64() + index);
+    memset(&allocated_prefix, 0, sizeof(allocated_prefix));
+    memcpy(allocated_prefix.s6_addr, &p, sizeof(p));
     return true;
   }
 
-  void free_address(const struct in_addr& allocated) {}
+  bool free_address(const struct in6_addr& allocated_prefix) {
+    uint64_t index = 0;
+    if ((index_of(allocated_prefix, index)) && (allocated.erase(index))) {
+      released.push_back(index);
+      return true;
+    }
+    return false;
+  }
 };
 
+// Hierarchical bitmap of the free addresses: a bit of level l+1 is set if the
+// word of level l it stands for has a free address, so that a free address
+// is found with one find-first-set per level.
+// A released address is held back in a FIFO (reuse delay) before it is
+// allocated again, a stale route or session of its previous user would hit
+// the next one. The held addresses are still allocated when no other is free.
 class ipv4_pool {
  protected:
+#define IPV4_POOL_REUSE_DELAY_MAX 1024
   struct in_addr start;
-  int num;
-  std::map<int, uint32_t> alloc;
-
-  bool alloc_free_bit(int& bit_pos) {
-    bit_pos = 0;
-    for (int i = 0; i < alloc.size(); ++i) {
-      if (alloc[i] != std::numeric_limits<uint32_t>::max()) {
-        std::bitset<32> bs(alloc[i]);
-        int word_bit_pos = 0;
-        while (bs[word_bit_pos]) {
-          bit_pos++;
-          word_bit_pos++;
-        }
-        bs.set(word_bit_pos);
-        alloc[i] = bs.to_ulong();
+  uint32_t num;
+  // levels[0] has a bit per address, set if free
+  std::vector<std::vector<uint64_t>> levels;
+  // Bit per address, set if held back
+  std::vector<uint64_t> held;
+  // Held addresses, oldest first. An address reserved while held is left
+  // in the FIFO and skipped when popped.
+  std::deque<uint32_t> held_fifo;
+  uint32_t num_held;
+  uint32_t reuse_delay;
+
+  static bool test_bit(const std::vector<uint64_t>& bits, const uint32_t pos) {
+    return (bits[pos >> 6] >> (pos & 63)) & 1;
+  }
+
+  void set_free(uint32_t pos) {
+    for (auto& level : levels) {
+      const uint64_t word = level[pos >> 6];
+      level[pos >> 6]     = word | ((uint64_t) 1 << (pos & 63));
+      if (word) break;
+      pos >>= 6;
+    }
+  }
+
+  void clear_free(uint32_t pos) {
+    for (auto& level : levels) {
+      level[pos >> 6] &= ~((uint64_t) 1 << (pos & 63));
+      if (level[pos >> 6]) break;
+      pos >>= 6;
+    }
+  }
+
+  bool find_free(uint32_t& pos) const {
+    if (not levels.back()[0]) return false;
+    pos = 0;
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+      pos = (pos << 6) + __builtin_ctzll((*it)[pos]);
+    }
+    return true;
+  }
+
+  void hold(const uint32_t pos) {
+    held[pos >> 6] |= (uint64_t) 1 << (pos & 63);
+    held_fifo.push_back(pos);
+    num_held++;
+  }
+
+  void unhold(const uint32_t pos) {
+    held[pos >> 6] &= ~((uint64_t) 1 << (pos & 63));
+    num_held--;
+  }
+
+  // Take the oldest held address out of the FIFO
+  bool pop_held(uint32_t& pos) {
+    while (held_fifo.size()) {
+      pos = held_fifo.front();
+      held_fifo.pop_front();
+      if (test_bit(held, pos)) {
+        unhold(pos);
         return true;
       }
-      bit_pos += 32;
     }
     return false;
   }
 
-  bool free_bit(const int bit_pos) {
-    if (bit_pos < num) {
-      int bit_pos32    = bit_pos >> 5;
-      int word_bit_pos = bit_pos & 0x0000001F;
-      std::bitset<32> bs(alloc[bit_pos32]);
-      bs.reset(word_bit_pos);
-      alloc[bit_pos32] = bs.to_ulong();
-      return true;
-    }
-    return false;
+  bool offset_of(const struct in_addr& a, uint32_t& pos) const {
+    pos = be32toh(a.s_addr) - be32toh(start.s_addr);
+    return pos < num;
+  }
+
+  struct in_addr address_of(const uint32_t pos) const {
+    struct in_addr a;
+    a.s_addr = htobe32(be32toh(start.s_addr) + pos);
+    return a;
   }
 
  public:
-  ipv4_pool() : num(0), alloc() { start.s_addr = 0; };
+  ipv4_pool()
+      : num(0),
+        levels(1, std::vector<uint64_t>(1, 0)),
+        held(),
+        held_fifo(),
+        num_held(0),
+        reuse_delay(0) {
+    start.s_addr = 0;
+  }
 
-  ipv4_pool(const struct in_addr first, const uint32_t range) : alloc() {
+  ipv4_pool(const struct in_addr first, const uint32_t range)
+      : num(range),
+        levels(),
+        held((range + 63) >> 6, 0),
+        held_fifo(),
+        num_held(0),
+        reuse_delay(
+            std::min((uint32_t) IPV4_POOL_REUSE_DELAY_MAX, range >> 4)) {
     start.s_addr = first.s_addr;
-    num          = range;
-    int range32  = range >> 5;
-    int i        = 0;
-    for (i = 0; i < range32; ++i) {
-      alloc[i] = 0;
+    uint32_t n   = range;
+    do {
+      levels.push_back(std::vector<uint64_t>((n + 63) >> 6, 0));
+      n = (n + 63) >> 6;
+    } while (n > 1);
+    for (uint32_t pos = 0; pos < range; pos++) {
+      set_free(pos);
     }
-    if (range & 0x0000001F) {
-      alloc[i] = std::numeric_limits<uint32_t>::max() << (range & 0x0000001F);
-    }
-  };
+  }
 
-  ipv4_pool(const ipv4_pool& p) : num(p.num), alloc(p.alloc) {
-    start.s_addr = p.start.s_addr;
-  };
+  ipv4_pool(const ipv4_pool& p) = default;
 
   bool alloc_address(struct in_addr& allocated) {
-    int bit_pos = 0;
-    if (alloc_free_bit(bit_pos)) {
-      allocated.s_addr = be32toh(start.s_addr) + bit_pos;  // overflow
-      allocated.s_addr = htobe32(allocated.s_addr);
+    uint32_t pos = 0;
+    if (find_free(pos)) {
+      clear_free(pos);
+    } else if (not pop_held(pos)) {
+      allocated.s_addr = 0;
+      return false;
+    }
+    allocated = address_of(pos);
+    return true;
+  }
+
+  // Static address, return false if not in the pool or already allocated
+  bool reserve_address(const struct in_addr& address) {
+    uint32_t pos = 0;
+    if (not offset_of(address, pos)) return false;
+    if (test_bit(levels[0], pos)) {
+      clear_free(pos);
+      return true;
+    }
+    if (test_bit(held, pos)) {
+      unhold(pos);
       return true;
     }
-    allocated.s_addr = 0;
     return false;
   }
 
   bool free_address(const struct in_addr& allocated) {
-    if (in_pool(allocated)) {
-      int bit_pos = be32toh(allocated.s_addr) - be32toh(start.s_addr);
-      return free_bit(bit_pos);
+    uint32_t pos = 0;
+    if ((not offset_of(allocated, pos)) || (test_bit(levels[0], pos)) ||
+        (test_bit(held, pos))) {
+      return false;
     }
-    return false;
+    hold(pos);
+    while (num_held > reuse_delay) {
+      if (pop_held(pos)) set_free(pos);
+    }
+    return true;
   }
 
   bool in_pool(const struct in_addr& a) const {
-    int addr_start = be32toh(start.s_addr);
-    int addr       = be32toh(a.s_addr);
-    return ((addr - addr_start) < num);
+    uint32_t pos = 0;
+    return offset_of(a, pos);
+  }
+
+  // Addresses not free: the held ones, oldest first, then the allocated ones
+  void snapshot(std::vector<struct in_addr>& addresses) const {
+    std::vector<uint64_t> to_go = held;
+    for (auto pos : held_fifo) {
+      if (test_bit(to_go, pos)) {
+        to_go[pos >> 6] &= ~((uint64_t) 1 << (pos & 63));
+        addresses.push_back(address_of(pos));
+      }
+    }
+    for (uint32_t pos = 0; pos < num; pos++) {
+      if ((not test_bit(levels[0], pos)) && (not test_bit(held, pos))) {
+        addresses.push_back(address_of(pos));
+      }
+    }
+  }
+
+  // The addresses of a snapshot are held back, in the order of the snapshot:
+  // the sessions were lost, the UEs may still use them for a while
+  bool restore(const struct in_addr& address) {
+    uint32_t pos = 0;
+    if ((offset_of(address, pos)) && (test_bit(levels[0], pos))) {
+      clear_free(pos);
+      hold(pos);
+      return true;
+    }
+    return false;
   }
 };
 
@@ -146,10 +332,23 @@ class apn_dynamic_pools {
 
   apn_dynamic_pools() : ipv4_pool_ids(), ipv6_pool_ids() {}
 
-  void add_ipv4_pool_id(const uint32_t id) { ipv4_pool_ids.push_back(id); }
-  void add_ipv6_pool_id(const uint32_t id) { ipv6_pool_ids.push_back(id); }
+  // The pools are used in the order they are added, the next one when the
+  // previous one is full
+  void add_ipv4_pool_id(const uint32_t id) {
+    if (std::find(ipv4_pool_ids.begin(), ipv4_pool_ids.end(), id) ==
+        ipv4_pool_ids.end()) {
+      ipv4_pool_ids.push_back(id);
+    }
+  }
+  void add_ipv6_pool_id(const uint32_t id) {
+    if (std::find(ipv6_pool_ids.begin(), ipv6_pool_ids.end(), id) ==
+        ipv6_pool_ids.end()) {
+      ipv6_pool_ids.push_back(id);
+    }
+  }
 };
 
+// Shared by the shards of TASK_PGWC_APP
 class paa_dynamic {
  private:
   std::map<int32_t, ipv4_pool> ipv4_pools;
@@ -157,7 +356,9 @@ class paa_dynamic {
 
   std::map<std::string, apn_dynamic_pools> apns;
 
-  paa_dynamic() : ipv4_pools(), ipv6_pools(), apns(){};
+  std::mutex m_pools;
+
+  paa_dynamic() : ipv4_pools(), ipv6_pools(), apns(), m_pools(){};
 
  public:
   static paa_dynamic& get_instance() {
@@ -172,16 +373,13 @@ class paa_dynamic {
       const std::string& apn_label, const int pool_id,
       const struct in_addr& first, const int range) {
     if (pool_id >= 0) {
+      std::unique_lock<std::mutex> l(m_pools);
       uint32_t uint32pool_id = uint32_t(pool_id);
       if (!ipv4_pools.count(uint32pool_id)) {
-        ipv4_pool pool(first, range);
-        ipv4_pools[uint32pool_id] = pool;
-      }
-      if (!apns.count(apn_label)) {
-        apn_dynamic_pools adp = {};
-        adp.add_ipv4_pool_id(uint32pool_id);
-        apns[apn_label] = adp;
+        ipv4_pools.emplace(uint32pool_id, ipv4_pool(first, range));
       }
+      // An IPv4v6 APN has an IPv4 and an IPv6 pool
+      apns[apn_label].add_ipv4_pool_id(uint32pool_id);
     }
   }
 
@@ -189,20 +387,18 @@ class paa_dynamic {
       const std::string& apn_label, const int pool_id,
       const struct in6_addr& prefix, const int prefix_len) {
     if (pool_id >= 0) {
+      std::unique_lock<std::mutex> l(m_pools);
       uint32_t uint32pool_id = uint32_t(pool_id);
       if (!ipv6_pools.count(uint32pool_id)) {
         ipv6_pool pool(prefix, prefix_len);
         ipv6_pools[uint32pool_id] = pool;
       }
-      if (!apns.count(apn_label)) {
-        apn_dynamic_pools adp = {};
-        adp.add_ipv6_pool_id(uint32pool_id);
-        apns[apn_label] = adp;
-      }
+      apns[apn_label].add_ipv6_pool_id(uint32pool_id);
     }
   }
 
   bool get_free_paa(const std::string& apn_label, paa_t& paa) {
+    std::unique_lock<std::mutex> l(m_pools);
     if (apns.count(apn_label)) {
       apn_dynamic_pools& apn_pool = apns[apn_label];
       if (paa.pdn_type.pdn_type == PDN_TYPE_E_IPV4) {
@@ -223,6 +419,7 @@ class paa_dynamic {
              it4 != apn_pool.ipv4_pool_ids.end(); ++it4) {
           if (ipv4_pools[*it4].alloc_address(paa.ipv4_address)) {
             success = true;
+            break;
           }
         }
         if (success) {
@@ -230,6 +427,7 @@ class paa_dynamic {
                    apn_pool.ipv6_pool_ids.begin();
                it6 != apn_pool.ipv6_pool_ids.end(); ++it6) {
             if (ipv6_pools[*it6].alloc_address(paa.ipv6_address)) {
+              paa.ipv6_prefix_length = 64;
               return true;
             }
           }
@@ -244,6 +442,7 @@ class paa_dynamic {
                  apn_pool.ipv6_pool_ids.begin();
              it6 != apn_pool.ipv6_pool_ids.end(); ++it6) {
           if (ipv6_pools[*it6].alloc_address(paa.ipv6_address)) {
+            paa.ipv6_prefix_length = 64;
             return true;
           }
         }
@@ -256,7 +455,69 @@ class paa_dynamic {
     return false;
   }
 
+  // Static IPv4 address given by the HSS: taken out of the pools of the APN
+  // if it belongs to one of them. Return false if it is already allocated.
+  bool reserve_paa(
+      const std::string& apn_label, const struct in_addr& ipv4_address) {
+    std::unique_lock<std::mutex> l(m_pools);
+    if (apns.count(apn_label)) {
+      for (auto id : apns[apn_label].ipv4_pool_ids) {
+        if (ipv4_pools[id].in_pool(ipv4_address)) {
+          return ipv4_pools[id].reserve_address(ipv4_address);
+        }
+      }
+    }
+    return true;
+  }
+
+  // One line "pool_id address" per IPv4 address in use or held back
+  bool save_ipv4_snapshot(const std::string& file_name) {
+    std::unique_lock<std::mutex> l(m_pools);
+    std::ofstream ofs(file_name, std::ofstream::trunc);
+    if (not ofs) {
+      Logger::pgwc_app().error(
+          "Could not write IPv4 pools snapshot %s", file_name.c_str());
+      return false;
+    }
+    std::vector<struct in_addr> addresses = {};
+    for (auto& it : ipv4_pools) {
+      addresses.clear();
+      it.second.snapshot(addresses);
+      for (auto& a : addresses) {
+        ofs << it.first << " " << inet_ntoa(a) << std::endl;
+      }
+    }
+    return bool(ofs);
+  }
+
+  // The pools must have been added
+  bool load_ipv4_snapshot(const std::string& file_name) {
+    std::unique_lock<std::mutex> l(m_pools);
+    std::ifstream ifs(file_name);
+    if (not ifs) {
+      Logger::pgwc_app().info(
+          "No IPv4 pools snapshot %s, pools empty", file_name.c_str());
+      return false;
+    }
+    int32_t pool_id         = 0;
+    std::string address     = {};
+    unsigned int num_loaded = 0;
+    while (ifs >> pool_id >> address) {
+      struct in_addr a = {};
+      if ((ipv4_pools.count(pool_id)) &&
+          (inet_pton(AF_INET, address.c_str(), &a) == 1) &&
+          (ipv4_pools[pool_id].restore(a))) {
+        num_loaded++;
+      }
+    }
+    Logger::pgwc_app().info(
+        "Loaded %u IPv4 addresses from snapshot %s, held back", num_loaded,
+        file_name.c_str());
+    return true;
+  }
+
   bool release_paa(const std::string& apn_label, const paa_t& paa) {
+    std::unique_lock<std::mutex> l(m_pools);
     if (apns.count(apn_label)) {
       apn_dynamic_pools& apn_pool = apns[apn_label];
       if (paa.pdn_type.pdn_type == PDN_TYPE_E_IPV4) {
@@ -269,17 +530,28 @@ class paa_dynamic {
         }
         return false;
       } else if (paa.pdn_type.pdn_type == PDN_TYPE_E_IPV4V6) {
-        bool success                              = false;
-        std::vector<uint32_t>::const_iterator it4 = {};
-        for (it4 = apn_pool.ipv4_pool_ids.begin();
-             it4 != apn_pool.ipv4_pool_ids.end(); ++it4) {
-          if (ipv4_pools[*it4].free_address(paa.ipv4_address)) {
+        bool success4 = false;
+        bool success6 = false;
+        for (std::vector<uint32_t>::const_iterator it4 =
+                 apn_pool.ipv4_pool_ids.begin();
+             (it4 != apn_pool.ipv4_pool_ids.end()) && (not success4); ++it4) {
+          success4 = ipv4_pools[*it4].free_address(paa.ipv4_address);
+        }
+        for (std::vector<uint32_t>::const_iterator it6 =
+                 apn_pool.ipv6_pool_ids.begin();
+             (it6 != apn_pool.ipv6_pool_ids.end()) && (not success6); ++it6) {
+          success6 = ipv6_pools[*it6].free_address(paa.ipv6_address);
+        }
+        return (success4 && success6);
+      } else if (paa.pdn_type.pdn_type == PDN_TYPE_E_IPV6) {
+        for (std::vector<uint32_t>::const_iterator it6 =
+                 apn_pool.ipv6_pool_ids.begin();
+             it6 != apn_pool.ipv6_pool_ids.end(); ++it6) {
+          if (ipv6_pools[*it6].free_address(paa.ipv6_address)) {
             return true;
           }
         }
         return false;
-      } else if (paa.pdn_type.pdn_type == PDN_TYPE_E_IPV6) {
-        return true;
       }
     }
     Logger::pgwc_app().warn(
@@ -289,6 +561,7 @@ class paa_dynamic {
 
   bool release_paa(
       const std::string& apn_label, const struct in_addr& ipv4_address) {
+    std::unique_lock<std::mutex> l(m_pools);
     if (apns.count(apn_label)) {
       apn_dynamic_pools& apn_pool = apns[apn_label];
       for (std::vector<uint32_t>::const_iterator it4 =
@@ -303,6 +576,24 @@ class paa_dynamic {
         "Could not release PAA for APN %s", apn_label.c_str());
     return false;
   }
+
+  bool release_paa(
+      const std::string& apn_label, const struct in6_addr& ipv6_prefix) {
+    std::unique_lock<std::mutex> l(m_pools);
+    if (apns.count(apn_label)) {
+      apn_dynamic_pools& apn_pool = apns[apn_label];
+      for (std::vector<uint32_t>::const_iterator it6 =
+               apn_pool.ipv6_pool_ids.begin();
+           it6 != apn_pool.ipv6_pool_ids.end(); ++it6) {
+        if (ipv6_pools[*it6].free_address(ipv6_prefix)) {
+          return true;
+        }
+      }
+    }
+    Logger::pgwc_app().warn(
+        "Could not release IPv6 PAA for APN %s", apn_label.c_str());
+    return false;
+  }
 };
 
 #endif /* FILE_PGW_PAA_DYNAMIC_HPP_SEEN */
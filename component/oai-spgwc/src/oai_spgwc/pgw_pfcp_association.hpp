@@ -34,6 +34,7 @@
 #include <folly/AtomicHashMap.h>
 #include <folly/AtomicLinkedList.h>
 #include <mutex>
+#include <set>
 #include <vector>
 
 namespace pgwc {
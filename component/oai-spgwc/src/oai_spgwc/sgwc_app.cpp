@@ -58,34 +58,99 @@ extern sgwc_config sgwc_cfg;
 
 void sgwc_app_task(void*);
 
+//------------------------------------------------------------------------------
+teid_t sgwc_app::next_shard_teid(
+    const teid_t teid, const unsigned int shard) const {
+  const teid_t next = teid + num_shards;
+  // Wraps around on the first TEID of the shard
+  return (next < teid) ? shard : next;
+}
 //------------------------------------------------------------------------------
 teid_t sgwc_app::generate_s11_cp_teid() {
-  teid_t loop_detect_teid = teid_s11_cp;
-  teid_t teid             = ++teid_s11_cp;
-  while ((is_s11c_teid_exist(teid)) || (teid == UNASSIGNED_TEID)) {
-    teid = ++teid_s11_cp;
+  const unsigned int shard = itti_inst->get_current_shard(TASK_SGWC_APP);
+  sgwc_app_shard& s        = shards[shard];
+  std::unique_lock lock(s.m_contexts);
+  teid_t loop_detect_teid = s.teid_s11_cp;
+  teid_t teid             = next_shard_teid(s.teid_s11_cp, shard);
+  while ((s.s11lteid2sgw_eps_bearer_context.count(teid)) ||
+         (teid == UNASSIGNED_TEID)) {
+    teid = next_shard_teid(teid, shard);
     if (loop_detect_teid == teid) return UNASSIGNED_TEID;
   }
+  s.teid_s11_cp = teid;
   return teid;
 }
 //------------------------------------------------------------------------------
 teid_t sgwc_app::generate_s5s8_cp_teid() {
-  teid_t loop_detect_teid = teid_s5s8_cp;
-  teid_t teid             = ++teid_s5s8_cp;
-  while ((is_s5s8c_teid_exist(teid)) || (teid == UNASSIGNED_TEID)) {
-    teid = ++teid_s5s8_cp;
+  const unsigned int shard = itti_inst->get_current_shard(TASK_SGWC_APP);
+  sgwc_app_shard& s        = shards[shard];
+  std::unique_lock lock(s.m_contexts);
+  teid_t loop_detect_teid = s.teid_s5s8_cp;
+  teid_t teid             = next_shard_teid(s.teid_s5s8_cp, shard);
+  while ((s.s5s8lteid2sgw_contexts.count(teid)) || (teid == UNASSIGNED_TEID)) {
+    teid = next_shard_teid(teid, shard);
     if (loop_detect_teid == teid) return UNASSIGNED_TEID;
   }
+  s.teid_s5s8_cp = teid;
   return teid;
 }
 
+//------------------------------------------------------------------------------
+uint64_t sgwc_app::imsi64_shard_key(const imsi64_t& imsi64) {
+  // The IMSIs of a network are often consecutive, spread them
+  return (imsi64 * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+//------------------------------------------------------------------------------
+uint64_t sgwc_app::shard_key(const itti_msg& msg) {
+  switch (msg.msg_type) {
+    case S11_CREATE_SESSION_REQUEST: {
+      const itti_s11_create_session_request& m =
+          static_cast<const itti_s11_create_session_request&>(msg);
+      imsi_t imsi = {};
+      if (m.gtp_ies.get(imsi)) {
+        return imsi64_shard_key(imsi.to_imsi64());
+      }
+      return m.teid;
+    }
+    case S11_DELETE_SESSION_REQUEST:
+    case S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE:
+    case S11_MODIFY_BEARER_REQUEST:
+    case S11_RELEASE_ACCESS_BEARERS_REQUEST:
+      return static_cast<const itti_s11_msg&>(msg).teid;
+    case S11_REMOTE_PEER_NOT_RESPONDING:
+      return static_cast<const itti_s11_msg&>(msg).l_teid;
+    case S5S8_CREATE_SESSION_RESPONSE:
+    case S5S8_DELETE_SESSION_RESPONSE:
+    case S5S8_DOWNLINK_DATA_NOTIFICATION:
+    case S5S8_MODIFY_BEARER_RESPONSE:
+    case S5S8_RELEASE_ACCESS_BEARERS_RESPONSE:
+      return static_cast<const itti_s5s8_msg&>(msg).teid;
+    case S5S8_REMOTE_PEER_NOT_RESPONDING:
+      return static_cast<const itti_s5s8_msg&>(msg).l_teid;
+    default:
+      return 0;
+  }
+}
+//------------------------------------------------------------------------------
+sgwc_app_shard& sgwc_app::imsi64_shard(const imsi64_t& imsi64) const {
+  return shards[imsi64_shard_key(imsi64) % num_shards];
+}
+//------------------------------------------------------------------------------
+sgwc_app_shard& sgwc_app::teid_shard(const teid_t& teid) const {
+  return shards[teid % num_shards];
+}
+
 //------------------------------------------------------------------------------
 bool sgwc_app::is_s11c_teid_exist(const teid_t& teid_s11_cp) const {
-  return bool{s11lteid2sgw_eps_bearer_context.count(teid_s11_cp) > 0};
+  sgwc_app_shard& s = teid_shard(teid_s11_cp);
+  std::shared_lock lock(s.m_contexts);
+  return bool{s.s11lteid2sgw_eps_bearer_context.count(teid_s11_cp) > 0};
 }
 //------------------------------------------------------------------------------
 bool sgwc_app::is_s5s8c_teid_exist(const teid_t& teid_s5s8_cp) const {
-  return bool{s5s8lteid2sgw_contexts.count(teid_s5s8_cp) > 0};
+  sgwc_app_shard& s = teid_shard(teid_s5s8_cp);
+  std::shared_lock lock(s.m_contexts);
+  return bool{s.s5s8lteid2sgw_contexts.count(teid_s5s8_cp) > 0};
 }
 //------------------------------------------------------------------------------
 fteid_t sgwc_app::generate_s11_cp_fteid(const struct in_addr ipv4_address) {
@@ -111,55 +176,75 @@ fteid_t sgwc_app::generate_s5s8_cp_fteid(const struct in_addr ipv4_address) {
 }
 //------------------------------------------------------------------------------
 bool sgwc_app::is_s5s8sgw_teid_2_sgw_contexts(const teid_t& sgw_teid) const {
-  return bool{s5s8lteid2sgw_contexts.count(sgw_teid) > 0};
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::shared_lock lock(s.m_contexts);
+  return bool{s.s5s8lteid2sgw_contexts.count(sgw_teid) > 0};
 }
 //------------------------------------------------------------------------------
 bool sgwc_app::is_s11sgw_teid_2_sgw_eps_bearer_context(
     const teid_t& sgw_teid) const {
-  return bool{s11lteid2sgw_eps_bearer_context.count(sgw_teid) > 0};
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::shared_lock lock(s.m_contexts);
+  return bool{s.s11lteid2sgw_eps_bearer_context.count(sgw_teid) > 0};
 }
 //------------------------------------------------------------------------------
 std::pair<
     std::shared_ptr<sgw_eps_bearer_context>,
     std::shared_ptr<sgw_pdn_connection>>
 sgwc_app::s5s8sgw_teid_2_sgw_contexts(const teid_t& sgw_teid) const {
-  return s5s8lteid2sgw_contexts.at(sgw_teid);
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::shared_lock lock(s.m_contexts);
+  return s.s5s8lteid2sgw_contexts.at(sgw_teid);
 }
 //------------------------------------------------------------------------------
 shared_ptr<sgw_eps_bearer_context>
 sgwc_app::s11sgw_teid_2_sgw_eps_bearer_context(const teid_t& sgw_teid) const {
-  return s11lteid2sgw_eps_bearer_context.at(sgw_teid);
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::shared_lock lock(s.m_contexts);
+  return s.s11lteid2sgw_eps_bearer_context.at(sgw_teid);
 }
 //------------------------------------------------------------------------------
 void sgwc_app::set_s5s8sgw_teid_2_sgw_contexts(
     const teid_t& sgw_teid, shared_ptr<sgw_eps_bearer_context> sebc,
     std::shared_ptr<sgw_pdn_connection> spc) {
-  s5s8lteid2sgw_contexts[sgw_teid] = std::make_pair(sebc, spc);
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::unique_lock lock(s.m_contexts);
+  s.s5s8lteid2sgw_contexts[sgw_teid] = std::make_pair(sebc, spc);
 }
 //------------------------------------------------------------------------------
 void sgwc_app::delete_s5s8sgw_teid_2_sgw_contexts(const teid_t& sgw_teid) {
-  s5s8lteid2sgw_contexts.erase(sgw_teid);
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::unique_lock lock(s.m_contexts);
+  s.s5s8lteid2sgw_contexts.erase(sgw_teid);
 }
 
 //------------------------------------------------------------------------------
 void sgwc_app::set_s11sgw_teid_2_sgw_eps_bearer_context(
     const teid_t& sgw_teid, shared_ptr<sgw_eps_bearer_context> sebc) {
-  s11lteid2sgw_eps_bearer_context[sgw_teid] = sebc;
+  sgwc_app_shard& s = teid_shard(sgw_teid);
+  std::unique_lock lock(s.m_contexts);
+  s.s11lteid2sgw_eps_bearer_context[sgw_teid] = sebc;
 }
 //------------------------------------------------------------------------------
 bool sgwc_app::is_imsi64_2_sgw_eps_bearer_context(
     const imsi64_t& imsi64) const {
-  return bool{imsi2sgw_eps_bearer_context.count(imsi64) > 0};
+  sgwc_app_shard& s = imsi64_shard(imsi64);
+  std::shared_lock lock(s.m_contexts);
+  return bool{s.imsi2sgw_eps_bearer_context.count(imsi64) > 0};
 }
 //------------------------------------------------------------------------------
 shared_ptr<sgw_eps_bearer_context> sgwc_app::imsi64_2_sgw_eps_bearer_context(
     const imsi64_t& imsi64) const {
-  return imsi2sgw_eps_bearer_context.at(imsi64);
+  sgwc_app_shard& s = imsi64_shard(imsi64);
+  std::shared_lock lock(s.m_contexts);
+  return s.imsi2sgw_eps_bearer_context.at(imsi64);
 }
 //------------------------------------------------------------------------------
 void sgwc_app::set_imsi64_2_sgw_eps_bearer_context(
     const imsi64_t& imsi64, shared_ptr<sgw_eps_bearer_context> sebc) {
-  imsi2sgw_eps_bearer_context[imsi64] = sebc;
+  sgwc_app_shard& s = imsi64_shard(imsi64);
+  std::unique_lock lock(s.m_contexts);
+  s.imsi2sgw_eps_bearer_context[imsi64] = sebc;
 }
 //------------------------------------------------------------------------------
 void sgwc_app::delete_sgw_eps_bearer_context(
@@ -168,9 +253,17 @@ void sgwc_app::delete_sgw_eps_bearer_context(
     imsi64_t imsi64 = sebc->imsi.to_imsi64();
     Logger::sgwc_app().debug(
         "Delete SGW EPS BEARER CONTEXT IMSI " IMSI_64_FMT " ", imsi64);
-    imsi2sgw_eps_bearer_context.erase(imsi64);
-    s11lteid2sgw_eps_bearer_context.erase(
-        sebc->sgw_fteid_s11_s4_cp.teid_gre_key);
+    {
+      sgwc_app_shard& s = imsi64_shard(imsi64);
+      std::unique_lock lock(s.m_contexts);
+      s.imsi2sgw_eps_bearer_context.erase(imsi64);
+    }
+    {
+      const teid_t teid = sebc->sgw_fteid_s11_s4_cp.teid_gre_key;
+      sgwc_app_shard& s = teid_shard(teid);
+      std::unique_lock lock(s.m_contexts);
+      s.s11lteid2sgw_eps_bearer_context.erase(teid);
+    }
     sebc->release();
   }
 }
@@ -298,15 +391,15 @@ void sgwc_app_task(void* args_p) {
 
 //------------------------------------------------------------------------------
 sgwc_app::sgwc_app(const std::string& config_file)
-    : s11lteid2sgw_eps_bearer_context() {
+    : num_shards(sgwc_cfg.itti.sgw_app_shards),
+      shards(new sgwc_app_shard[sgwc_cfg.itti.sgw_app_shards]) {
   Logger::sgwc_app().startup("Starting...");
   sgwc_cfg.execute();
 
-  teid_s11_cp                     = 0;
-  teid_s5s8_cp                    = 0;
-  imsi2sgw_eps_bearer_context     = {};
-  s11lteid2sgw_eps_bearer_context = {};
-  s5s8lteid2sgw_contexts          = {};
+  for (unsigned int i = 0; i < num_shards; i++) {
+    shards[i].teid_s11_cp  = i;
+    shards[i].teid_s5s8_cp = i;
+  }
 
   try {
     sgw_s5s8_inst = new sgw_s5s8();
@@ -320,7 +413,9 @@ sgwc_app::sgwc_app(const std::string& config_file)
     throw;
   }
 
-  if (itti_inst->create_task(TASK_SGWC_APP, sgwc_app_task, nullptr)) {
+  if (itti_inst->create_task_shards(
+          TASK_SGWC_APP, sgwc_app_task, nullptr, num_shards,
+          sgwc_app::shard_key)) {
     Logger::sgwc_app().error("Cannot create task TASK_SGWC_APP");
     throw std::runtime_error("Cannot create task TASK_SGWC_APP");
   }
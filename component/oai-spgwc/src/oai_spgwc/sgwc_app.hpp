@@ -34,24 +34,34 @@
 #include "itti_msg_s5s8.hpp"
 #include "sgwc_eps_bearer_context.hpp"
 
-#include <boost/atomic.hpp>
-
 #include <map>
 #include <memory>
 #include <set>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 
 namespace sgwc {
 
-class sgwc_app {
- private:
-  std::thread::id thread_id;
-  std::thread thread;
-
-  // teid generators (linear)
-  boost::atomic<teid_t> teid_s11_cp;
-  boost::atomic<teid_t> teid_s5s8_cp;
+// Contexts of the UEs served by a shard of TASK_SGWC_APP. A shard allocates
+// the S11 and S5S8 TEIDs congruent to its index modulo the number of shards:
+// the messages of a UE, routed by IMSI or TEID, are all handled by the thread
+// of its shard.
+class sgwc_app_shard {
+ public:
+  sgwc_app_shard()
+      : teid_s11_cp(0),
+        teid_s5s8_cp(0),
+        imsi2sgw_eps_bearer_context(),
+        s11lteid2sgw_eps_bearer_context(),
+        s5s8lteid2sgw_contexts(),
+        m_contexts() {}
+  sgwc_app_shard(sgwc_app_shard const&) = delete;
+  void operator=(sgwc_app_shard const&) = delete;
+
+  // teid generators (linear, stepping by the number of shards)
+  teid_t teid_s11_cp;
+  teid_t teid_s5s8_cp;
   /* There shall be only one pair of TEID-C per UE over the S11 and the S4
      interfaces. The same tunnel shall be shared for the control messages
      related to the same UE operation. A TEID-C on the S11/S4 interface shall be
@@ -67,6 +77,23 @@ class sgwc_app {
                   std::shared_ptr<sgw_pdn_connection>>>
       s5s8lteid2sgw_contexts;
 
+  // Generators and collections
+  mutable std::shared_mutex m_contexts;
+};
+
+class sgwc_app {
+ private:
+  std::thread::id thread_id;
+  std::thread thread;
+
+  unsigned int num_shards;
+  std::unique_ptr<sgwc_app_shard[]> shards;
+
+  sgwc_app_shard& imsi64_shard(const imsi64_t& imsi64) const;
+  sgwc_app_shard& teid_shard(const teid_t& teid) const;
+  // Next TEID of a generator of the shard
+  teid_t next_shard_teid(const teid_t teid, const unsigned int shard) const;
+
   teid_t generate_s11_cp_teid();
   bool is_s11c_teid_exist(const teid_t& teid_s11_cp) const;
 
@@ -110,6 +137,10 @@ class sgwc_app {
   sgwc_app(sgwc_app const&) = delete;
   void operator=(sgwc_app const&) = delete;
 
+  // Key of the messages sent to TASK_SGWC_APP, see itti_shard_key_t
+  static uint64_t shard_key(const itti_msg& msg);
+  static uint64_t imsi64_shard_key(const imsi64_t& imsi64);
+
   void send_create_session_response_cause(
       const uint64_t gtpc_tx_id, const teid_t teid, const endpoint& r_endpoint,
       const cause_t& cause) const;
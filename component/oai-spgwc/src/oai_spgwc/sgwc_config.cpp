@@ -30,6 +30,7 @@
 #include "async_shell_cmd.hpp"
 #include "common_defs.h"
 #include "if.hpp"
+#include "itti.hpp"
 #include "logger.hpp"
 #include "string.hpp"
 
@@ -168,6 +169,15 @@ int sgwc_config::load_itti(const Setting& itti_cfg, itti_cfg_t& cfg) {
         "%s : %s, using defaults", nfex.what(), nfex.getPath());
   }
 
+  itti_cfg.lookupValue(SGWC_CONFIG_STRING_SGW_APP_SHARDS, cfg.sgw_app_shards);
+  if ((cfg.sgw_app_shards < 1) ||
+      (cfg.sgw_app_shards > ITTI_MAX_TASK_SHARDS)) {
+    Logger::sgwc_app().error(
+        SGWC_CONFIG_STRING_SGW_APP_SHARDS " %u out of [1..%d], using %d",
+        cfg.sgw_app_shards, ITTI_MAX_TASK_SHARDS, SGWC_DEFAULT_APP_SHARDS);
+    cfg.sgw_app_shards = SGWC_DEFAULT_APP_SHARDS;
+  }
+
   return RETURNok;
 }
 //------------------------------------------------------------------------------
@@ -358,6 +368,7 @@ void sgwc_config::display() {
       "    Scheduling policy : %d", itti.sgw_app_sched_params.sched_policy);
   Logger::sgwc_app().info(
       "    Scheduling prio  .: %d", itti.sgw_app_sched_params.sched_priority);
+  Logger::sgwc_app().info("    Shards............: %u", itti.sgw_app_shards);
   Logger::sgwc_app().info("- ITTI ASYNC_CMD task Threading:");
   Logger::sgwc_app().info(
       "    CPU id............: %d", itti.async_cmd_sched_params.cpu_id);
@@ -57,6 +57,9 @@ namespace sgwc {
 #define SGWC_CONFIG_STRING_SX_SCHED_PARAMS "SX_SCHED_PARAMS"
 #define SGWC_CONFIG_STRING_SGW_APP_SCHED_PARAMS "SGW_APP_SCHED_PARAMS"
 #define SGWC_CONFIG_STRING_ASYNC_CMD_SCHED_PARAMS "ASYNC_CMD_SCHED_PARAMS"
+#define SGWC_CONFIG_STRING_SGW_APP_SHARDS "SGW_APP_SHARDS"
+// Threads processing the sessions
+#define SGWC_DEFAULT_APP_SHARDS 4
 
 #define SGWC_CONFIG_STRING_SCHED_PARAMS "SCHED_PARAMS"
 #define SGWC_CONFIG_STRING_THREAD_RD_CPU_ID "CPU_ID"
@@ -83,6 +86,7 @@ typedef struct itti_cfg_s {
   // util::thread_sched_params sx_sched_params;
   util::thread_sched_params sgw_app_sched_params;
   util::thread_sched_params async_cmd_sched_params;
+  unsigned int sgw_app_shards;
 } itti_cfg_t;
 
 class sgwc_config {
@@ -111,6 +115,7 @@ class sgwc_config {
     itti.s5s8_sched_params.sched_priority       = 84;
     itti.sgw_app_sched_params.sched_priority    = 84;
     itti.async_cmd_sched_params.sched_priority  = 84;
+    itti.sgw_app_shards                         = SGWC_DEFAULT_APP_SHARDS;
 
     s11_cp.thread_rd_sched_params.sched_priority = 95;
     s11_cp.port                                  = gtpv2c::default_port;
@@ -408,12 +408,10 @@ void sgw_s5s8::handle_receive(
     const endpoint& remote_endpoint) {
   // Logger::sgwc_s5s8().info( "handle_receive(%d bytes)", bytes_transferred);
   // std::cout << string_to_hex(recv_buffer, bytes_transferred) << std::endl;
-  std::istringstream iss(std::istringstream::binary);
-  iss.rdbuf()->pubsetbuf(recv_buffer, bytes_transferred);
   gtpv2c_msg msg  = {};
   msg.remote_port = remote_endpoint.port();
   try {
-    msg.load_from(iss);
+    msg.load_from(recv_buffer, bytes_transferred);
     handle_receive_gtpv2c_msg(msg, remote_endpoint);
   } catch (gtpc_exception& e) {
     Logger::sgwc_s5s8().info("handle_receive exception %s", e.what());
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_gtpv2c_codec.cpp
+  \brief GTPv2-C ns/msg and heap allocations per message over an S11 corpus
+  (create session request with 2 bearer contexts, modify bearer request,
+  delete session request), string stream decoding into heap IEs and string
+  stream encoding (as the S11 stack did) against in place decoding with lazy
+  grouped IEs and encoding into the send buffer
+  Usage: bench_gtpv2c_codec [messages, default 1000000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "gtpv2c_test_msgs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace gtpv2c;
+
+// Larger than any of the messages
+#define BENCH_BUFFER_SIZE 4096
+
+// Every heap allocation of the process, the benchmark is single threaded
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (not p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { free(p); }
+
+typedef struct bench_result_s {
+  double ns_per_msg;
+  double allocs_per_msg;
+} bench_result_t;
+
+//------------------------------------------------------------------------------
+template <class F>
+static bench_result_t run(const uint64_t num_msgs, F one_msg) {
+  uint64_t checksum     = 0;
+  const uint64_t allocs = allocations.load();
+  const auto from       = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; n < num_msgs; n++) checksum += one_msg(n);
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+  if (checksum == 0) std::cout << "(empty messages)" << std::endl;
+  return {seconds * 1e9 / num_msgs,
+          (double) (allocations.load() - allocs) / num_msgs};
+}
+//------------------------------------------------------------------------------
+static void print(
+    const char* what, const bench_result_t& before,
+    const bench_result_t& after) {
+  std::cout << "  " << what << before.ns_per_msg << " -> " << after.ns_per_msg
+            << " ns/msg, " << before.allocs_per_msg << " -> "
+            << after.allocs_per_msg << " allocs/msg" << std::endl;
+}
+//------------------------------------------------------------------------------
+// As the S11 task of the SGW-C
+static std::size_t to_core_type(gtpv2c_msg& msg) {
+  switch (msg.get_message_type()) {
+    case GTP_CREATE_SESSION_REQUEST: {
+      gtpv2c_create_session_request csr = {};
+      msg.to_core_type(csr);
+      return csr.bearer_contexts_to_be_created.size();
+    }
+    case GTP_MODIFY_BEARER_REQUEST: {
+      gtpv2c_modify_bearer_request mbr = {};
+      msg.to_core_type(mbr);
+      return mbr.bearer_contexts_to_be_modified.size();
+    }
+    case GTP_DELETE_SESSION_REQUEST: {
+      gtpv2c_delete_session_request dsr = {};
+      msg.to_core_type(dsr);
+      return dsr.linked_eps_bearer_id.ebi;
+    }
+    default:
+      return 0;
+  }
+}
+//------------------------------------------------------------------------------
+template <class CORE>
+static std::string encode(const CORE& ies) {
+  gtpv2c_msg msg(ies);
+  msg.set_teid(0x00000101);
+  std::ostringstream oss(std::ostringstream::binary);
+  msg.dump_to(oss);
+  return oss.str();
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_msgs =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+  gtpv2c_create_session_request csr = {};
+  build_create_session_request(csr);
+  gtpv2c_modify_bearer_request mbr = {};
+  build_modify_bearer_request(mbr);
+  gtpv2c_delete_session_request dsr = {};
+  build_delete_session_request(dsr);
+  const std::vector<std::string> corpus = {
+      encode(csr), encode(mbr), encode(dsr)};
+
+  auto stream_decode = [](const std::string& bytes, gtpv2c_msg& msg) {
+    std::istringstream iss(std::istringstream::binary);
+    iss.rdbuf()->pubsetbuf(const_cast<char*>(bytes.data()), bytes.size());
+    msg.load_from(iss);
+  };
+
+  const bench_result_t decode_before = run(num_msgs, [&](const uint64_t n) {
+    gtpv2c_msg msg = {};
+    stream_decode(corpus[n % corpus.size()], msg);
+    return msg.ies.size();
+  });
+  const bench_result_t decode_after = run(num_msgs, [&](const uint64_t n) {
+    const std::string& bytes = corpus[n % corpus.size()];
+    gtpv2c_msg msg           = {};
+    msg.load_from(bytes.data(), bytes.size());
+    return msg.ies.size();
+  });
+
+  const bench_result_t core_before = run(num_msgs, [&](const uint64_t n) {
+    gtpv2c_msg msg = {};
+    stream_decode(corpus[n % corpus.size()], msg);
+    return to_core_type(msg);
+  });
+  const bench_result_t core_after = run(num_msgs, [&](const uint64_t n) {
+    const std::string& bytes = corpus[n % corpus.size()];
+    gtpv2c_msg msg           = {};
+    msg.load_from(bytes.data(), bytes.size());
+    return to_core_type(msg);
+  });
+
+  gtpv2c_create_session_response csp = {};
+  build_create_session_response(csp);
+  const bench_result_t encode_before = run(num_msgs, [&](const uint64_t n) {
+    gtpv2c_msg msg(csp);
+    msg.set_teid(0x00000001);
+    msg.set_sequence_number(n);
+    std::ostringstream oss(std::ostringstream::binary);
+    msg.dump_to(oss);
+    std::string bstream = oss.str();
+    return bstream.length();
+  });
+  const bench_result_t encode_after = run(num_msgs, [&](const uint64_t n) {
+    gtpv2c_arena::scope arena_scope;
+    gtpv2c_msg msg(csp);
+    msg.set_teid(0x00000001);
+    msg.set_sequence_number(n);
+    char send_buffer[BENCH_BUFFER_SIZE];
+    return msg.dump_to(send_buffer, sizeof(send_buffer));
+  });
+
+  std::cout << "S11 corpus of " << corpus[0].size() << ", "
+            << corpus[1].size() << " and " << corpus[2].size()
+            << " bytes, " << num_msgs << " messages, before -> after:"
+            << std::endl;
+  print("decode                          ", decode_before, decode_after);
+  print("decode + to_core_type           ", core_before, core_after);
+  print("encode create session response  ", encode_before, encode_after);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_ipv4_pool.cpp
+  \brief UE IPv4 pool allocation and release at 90% utilization: a random
+  session is released and a new one gets an address, as in steady state
+  attach/detach
+  Usage: bench_ipv4_pool [alloc+free pairs, default 10000000]
+  [pool size, default 1048576]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "3gpp_29.274.h"
+#include "pgw_paa_dynamic.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define BENCH_UTILIZATION_PERCENT 90
+
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_ops =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10000000;
+  const uint32_t range = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 1 << 20;
+  struct in_addr first;
+  first.s_addr = htobe32(0x0C000000);
+  ipv4_pool pool(first, range);
+
+  std::vector<struct in_addr> sessions(
+      (uint64_t) range * BENCH_UTILIZATION_PERCENT / 100);
+  auto from = std::chrono::steady_clock::now();
+  for (auto& a : sessions) {
+    if (not pool.alloc_address(a)) {
+      std::cout << "Pool full while filling" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  const double fill_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+
+  std::mt19937 rng(range);
+  uint64_t checksum = 0;
+  from              = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; n < num_ops; n++) {
+    struct in_addr& a = sessions[rng() % sessions.size()];
+    if ((not pool.free_address(a)) || (not pool.alloc_address(a))) {
+      std::cout << "Allocation failed at " << BENCH_UTILIZATION_PERCENT
+                << "% utilization" << std::endl;
+      return EXIT_FAILURE;
+    }
+    checksum += a.s_addr;
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+
+  std::cout << range << " addresses, " << sessions.size()
+            << " allocated: fill " << (fill_s * 1e9 / sessions.size())
+            << " ns/address, alloc+free " << (seconds * 1e9 / num_ops)
+            << " ns (" << (num_ops / seconds / 1e6) << " M/s)"
+            << " (checksum " << checksum << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,440 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_session_setup.cpp
+  \brief Session setups per second of the SGW-C and PGW-C apps on 1, 2, 4 ...
+  ITTI shards each. An S11 task plays the MME: Create Session Request routed
+  by IMSI, S5/S8 Create Session Request and Response between the apps, Create
+  Session Response, then Modify Bearer Request routed by the SGW-C TEID. The
+  apps keep their contexts in per shard maps, allocate TEIDs congruent to
+  their shard and UE addresses from the shared PAA pools, as sgwc_app and
+  pgw_app do. Messages handled on another shard than the one of their UE, or
+  not finding their context, fail the benchmark. The Sx leg to the SPGW-U is
+  left out. Each shard count runs in its own process, with its own ITTI.
+  Usage: bench_session_setup [setups, default 200000] [max shards, default 8]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "3gpp_29.274.h"
+#include "gtpv2c_test_msgs.hpp"
+#include "itti.hpp"
+#include "itti_msg_s11.hpp"
+#include "itti_msg_s5s8.hpp"
+#include "logger.hpp"
+#include "pgw_paa_dynamic.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+
+// Create Session Requests in flight
+#define BENCH_WINDOW 1024
+#define BENCH_APN "oai.ipv4"
+
+itti_mw* itti_inst = nullptr;
+
+// Context of a UE in an app, on the shard of its IMSI
+struct bench_context {
+  imsi64_t imsi64;
+  unsigned int shard;
+  teid_t mme_teid;
+  gtpv2c::gtpv2c_create_session_request csr;
+  paa_t paa;
+  fteid_t enb_fteid;
+};
+
+struct bench_app_shard {
+  std::shared_mutex m_contexts;
+  teid_t teid;
+  std::map<imsi64_t, std::shared_ptr<bench_context>> imsi2context;
+  std::map<teid_t, std::shared_ptr<bench_context>> lteid2context;
+};
+
+// Per shard maps and TEIDs of sgwc_app and pgw_app
+class bench_app {
+ public:
+  const task_id_t task_id;
+  unsigned int num_shards;
+  std::unique_ptr<bench_app_shard[]> shards;
+
+  explicit bench_app(const task_id_t task_id)
+      : task_id(task_id), num_shards(0), shards() {}
+
+  void init(const unsigned int n) {
+    num_shards = n;
+    shards.reset(new bench_app_shard[n]);
+    for (unsigned int i = 0; i < n; i++) shards[i].teid = i;
+  }
+
+  unsigned int current_shard() const {
+    return itti_inst->get_current_shard(task_id);
+  }
+
+  // As sgwc_app::generate_s11_cp_teid()
+  teid_t generate_teid() {
+    const unsigned int shard = current_shard();
+    bench_app_shard& s       = shards[shard];
+    std::unique_lock lock(s.m_contexts);
+    teid_t teid = s.teid;
+    do {
+      const teid_t next = teid + num_shards;
+      teid              = (next < teid) ? shard : next;
+    } while ((s.lteid2context.count(teid)) || (teid == UNASSIGNED_TEID));
+    s.teid = teid;
+    return teid;
+  }
+
+  void set_context(
+      const teid_t teid, const std::shared_ptr<bench_context>& c) {
+    bench_app_shard& s = shards[current_shard()];
+    std::unique_lock lock(s.m_contexts);
+    s.imsi2context[c->imsi64] = c;
+    s.lteid2context[teid]     = c;
+  }
+
+  std::shared_ptr<bench_context> teid_2_context(const teid_t teid) const {
+    bench_app_shard& s = shards[teid % num_shards];
+    std::shared_lock lock(s.m_contexts);
+    auto it = s.lteid2context.find(teid);
+    return (it == s.lteid2context.end()) ? nullptr : it->second;
+  }
+};
+
+static bench_app sgwc(TASK_SGWC_APP);
+static bench_app pgwc(TASK_PGWC_APP);
+// Messages handled on a wrong shard, or not finding their context
+static std::atomic<uint64_t> errors(0);
+
+// Owned by the S11 task
+static uint64_t num_setups  = 0;
+static uint64_t setups_sent = 0;
+static uint64_t setups_done = 0;
+static std::chrono::steady_clock::time_point from;
+static double seconds = 0;
+static std::promise<void> all_done;
+static gtpv2c::gtpv2c_create_session_request csr_template;
+
+//------------------------------------------------------------------------------
+static uint64_t imsi64_shard_key(const imsi64_t& imsi64) {
+  return (imsi64 * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+//------------------------------------------------------------------------------
+// sgwc_app::shard_key() and pgw_app::shard_key() for the messages used here
+static uint64_t shard_key(const itti_msg& msg) {
+  switch (msg.msg_type) {
+    case S11_CREATE_SESSION_REQUEST: {
+      imsi_t imsi = {};
+      static_cast<const itti_s11_create_session_request&>(msg).gtp_ies.get(
+          imsi);
+      return imsi64_shard_key(imsi.to_imsi64());
+    }
+    case S5S8_CREATE_SESSION_REQUEST: {
+      imsi_t imsi = {};
+      static_cast<const itti_s5s8_create_session_request&>(msg).gtp_ies.get(
+          imsi);
+      return imsi64_shard_key(imsi.to_imsi64());
+    }
+    case S11_MODIFY_BEARER_REQUEST:
+      return static_cast<const itti_s11_msg&>(msg).teid;
+    case S5S8_CREATE_SESSION_RESPONSE:
+      return static_cast<const itti_s5s8_msg&>(msg).teid;
+    default:
+      return 0;
+  }
+}
+//------------------------------------------------------------------------------
+static void check_shard(
+    const bench_app& app, const std::shared_ptr<bench_context>& c) {
+  if ((not c) || (c->shard != app.current_shard())) errors++;
+}
+//------------------------------------------------------------------------------
+static void send_create_session_request() {
+  auto csr = std::make_shared<itti_s11_create_session_request>(
+      TASK_SGWC_S11, TASK_SGWC_APP);
+  csr->gtp_ies = csr_template;
+  imsi_t imsi  = {};
+  csr->gtp_ies.get(imsi);
+  // The last digits of the IMSI, BCD, low digit first
+  uint64_t msin = setups_sent;
+  for (int d = 14; d >= 9; d--) {
+    const uint8_t digit = msin % 10;
+    msin /= 10;
+    uint8_t& b = imsi.u1.b[d / 2];
+    b          = (d % 2) ? ((b & 0x0f) | (digit << 4)) : ((b & 0xf0) | digit);
+  }
+  csr->gtp_ies.set(imsi);
+  csr->gtp_ies.set_sender_fteid_for_cp(
+      test_fteid(S11_MME_GTP_C, setups_sent + 1, "192.168.247.1"));
+  csr->gtpc_tx_id = setups_sent;
+  setups_sent++;
+  itti_inst->send_msg(csr);
+}
+//------------------------------------------------------------------------------
+// SGW-C: context on the IMSI shard, then S5/S8 to the PGW-C
+static void sgwc_handle(itti_s11_create_session_request& m) {
+  auto c      = std::make_shared<bench_context>();
+  imsi_t imsi = {};
+  m.gtp_ies.get(imsi);
+  c->imsi64   = imsi.to_imsi64();
+  c->shard    = sgwc.current_shard();
+  c->csr      = m.gtp_ies;
+  fteid_t mme = {};
+  m.gtp_ies.get_sender_fteid_for_cp(mme);
+  c->mme_teid = mme.teid_gre_key;
+  if (imsi64_shard_key(c->imsi64) % sgwc.num_shards != c->shard) errors++;
+  const teid_t s11_teid  = sgwc.generate_teid();
+  const teid_t s5s8_teid = sgwc.generate_teid();
+  sgwc.set_context(s11_teid, c);
+  sgwc.set_context(s5s8_teid, c);
+
+  auto s5 = std::make_shared<itti_s5s8_create_session_request>(
+      TASK_SGWC_APP, TASK_PGWC_APP);
+  s5->gtp_ies = m.gtp_ies;
+  s5->gtp_ies.set_sender_fteid_for_cp(
+      test_fteid(S5_S8_SGW_GTP_C, s5s8_teid, "192.168.248.1"));
+  s5->gtpc_tx_id = s11_teid;
+  itti_inst->send_msg(s5);
+}
+//------------------------------------------------------------------------------
+// PGW-C: context on the IMSI shard, UE address from the shared pools
+static void pgwc_handle(itti_s5s8_create_session_request& m) {
+  auto c      = std::make_shared<bench_context>();
+  imsi_t imsi = {};
+  m.gtp_ies.get(imsi);
+  c->imsi64 = imsi.to_imsi64();
+  c->shard  = pgwc.current_shard();
+  c->csr    = m.gtp_ies;
+  if (imsi64_shard_key(c->imsi64) % pgwc.num_shards != c->shard) errors++;
+  c->paa.pdn_type = PDN_TYPE_E_IPV4;
+  if (not paa_dynamic::get_instance().get_free_paa(BENCH_APN, c->paa)) {
+    errors++;
+  }
+  const teid_t teid = pgwc.generate_teid();
+  pgwc.set_context(teid, c);
+
+  fteid_t sgw = {};
+  m.gtp_ies.get_sender_fteid_for_cp(sgw);
+  auto r = std::make_shared<itti_s5s8_create_session_response>(
+      TASK_PGWC_APP, TASK_SGWC_APP);
+  build_create_session_response(r->gtp_ies);
+  r->gtp_ies.set_sender_fteid_for_cp(
+      test_fteid(S5_S8_PGW_GTP_C, teid, "192.168.248.159"));
+  r->gtp_ies.set(c->paa);
+  r->teid       = sgw.teid_gre_key;
+  r->gtpc_tx_id = m.gtpc_tx_id;
+  itti_inst->send_msg(r);
+}
+//------------------------------------------------------------------------------
+// SGW-C: back on the shard of the S5/S8 TEID, answer the MME
+static void sgwc_handle(itti_s5s8_create_session_response& m) {
+  std::shared_ptr<bench_context> c = sgwc.teid_2_context(m.teid);
+  check_shard(sgwc, c);
+  if (not c) return;
+  paa_t paa = {};
+  m.gtp_ies.get(paa);
+  c->paa = paa;
+
+  auto r = std::make_shared<itti_s11_create_session_response>(
+      TASK_SGWC_APP, TASK_SGWC_S11);
+  build_create_session_response(r->gtp_ies);
+  r->gtp_ies.set_sender_fteid_for_cp(test_fteid(
+      S11_S4_SGW_GTP_C, (teid_t) m.gtpc_tx_id, "192.168.247.2"));
+  r->gtp_ies.set(paa);
+  r->teid = c->mme_teid;
+  itti_inst->send_msg(r);
+}
+//------------------------------------------------------------------------------
+// SGW-C: on the shard of the S11 TEID
+static void sgwc_handle(itti_s11_modify_bearer_request& m) {
+  std::shared_ptr<bench_context> c = sgwc.teid_2_context(m.teid);
+  check_shard(sgwc, c);
+  if (not c) return;
+  c->enb_fteid =
+      test_fteid(S1_U_ENODEB_GTP_U, 0xA0000001, "192.168.248.120");
+
+  auto r = std::make_shared<itti_s11_modify_bearer_response>(
+      TASK_SGWC_APP, TASK_SGWC_S11);
+  cause_t cause     = {};
+  cause.cause_value = REQUEST_ACCEPTED;
+  r->gtp_ies.set(cause);
+  r->teid = c->mme_teid;
+  itti_inst->send_msg(r);
+}
+//------------------------------------------------------------------------------
+static void app_task(void* args_p) {
+  const task_id_t task_id = ((bench_app*) args_p)->task_id;
+  itti_inst->notify_task_ready(task_id);
+  do {
+    std::shared_ptr<itti_msg> shared_msg = itti_inst->receive_msg(task_id);
+    auto* msg                            = shared_msg.get();
+    switch (msg->msg_type) {
+      case S11_CREATE_SESSION_REQUEST:
+        sgwc_handle(static_cast<itti_s11_create_session_request&>(*msg));
+        break;
+      case S11_MODIFY_BEARER_REQUEST:
+        sgwc_handle(static_cast<itti_s11_modify_bearer_request&>(*msg));
+        break;
+      case S5S8_CREATE_SESSION_REQUEST:
+        pgwc_handle(static_cast<itti_s5s8_create_session_request&>(*msg));
+        break;
+      case S5S8_CREATE_SESSION_RESPONSE:
+        sgwc_handle(static_cast<itti_s5s8_create_session_response&>(*msg));
+        break;
+      case TERMINATE:
+        return;
+      default:
+        errors++;
+    }
+  } while (true);
+}
+//------------------------------------------------------------------------------
+// The MME: a window of Create Session Requests, Modify Bearer Request once
+// a session is created, next Create Session Request once it is modified
+static void s11_task(void* args_p) {
+  const task_id_t task_id = TASK_SGWC_S11;
+  itti_inst->notify_task_ready(task_id);
+  from                  = std::chrono::steady_clock::now();
+  const uint64_t window = std::min((uint64_t) BENCH_WINDOW, num_setups);
+  for (uint64_t n = 0; n < window; n++) send_create_session_request();
+  do {
+    std::shared_ptr<itti_msg> shared_msg = itti_inst->receive_msg(task_id);
+    auto* msg                            = shared_msg.get();
+    switch (msg->msg_type) {
+      case S11_CREATE_SESSION_RESPONSE: {
+        auto& m     = static_cast<itti_s11_create_session_response&>(*msg);
+        fteid_t sgw = {};
+        m.gtp_ies.get_sender_fteid_for_cp(sgw);
+        auto mbr = std::make_shared<itti_s11_modify_bearer_request>(
+            TASK_SGWC_S11, TASK_SGWC_APP);
+        build_modify_bearer_request(mbr->gtp_ies);
+        mbr->teid = sgw.teid_gre_key;
+        itti_inst->send_msg(mbr);
+      } break;
+      case S11_MODIFY_BEARER_RESPONSE:
+        setups_done++;
+        if (setups_sent < num_setups) {
+          send_create_session_request();
+        } else if (setups_done == num_setups) {
+          seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - from)
+                        .count();
+          all_done.set_value();
+        }
+        break;
+      case TERMINATE:
+        return;
+      default:
+        errors++;
+    }
+  } while (true);
+}
+//------------------------------------------------------------------------------
+// In a child process: ns per setup, 0 on error
+static double run(const unsigned int num_shards) {
+  Logger::init("bench_session_setup", false, false);
+  itti_inst = new itti_mw();
+  // The timer thread is not used, not pinned
+  util::thread_sched_params sched_params = {};
+  sched_params.cpu_id                    = -1;
+  sched_params.sched_policy              = SCHED_OTHER;
+  sched_params.sched_priority            = 0;
+  itti_inst->start(sched_params);
+  struct in_addr first;
+  first.s_addr = htobe32(0x0C000000);
+  paa_dynamic::get_instance().add_pool(BENCH_APN, 0, first, 1 << 22);
+  build_create_session_request(csr_template);
+  sgwc.init(num_shards);
+  pgwc.init(num_shards);
+  std::future<void> done = all_done.get_future();
+  // The S11 task starts sending once the apps are ready
+  if ((itti_inst->create_task_shards(
+          TASK_SGWC_APP, app_task, &sgwc, num_shards, shard_key)) ||
+      (itti_inst->create_task_shards(
+          TASK_PGWC_APP, app_task, &pgwc, num_shards, shard_key)) ||
+      (itti_inst->create_task(TASK_SGWC_S11, s11_task, nullptr))) {
+    return 0;
+  }
+  done.wait();
+  itti_inst->send_terminate_msg(TASK_NONE);
+  itti_inst->wait_tasks_end();
+  if (errors) {
+    std::cout << errors << " message(s) on a wrong shard or without context"
+              << std::endl;
+    return 0;
+  }
+  return seconds * 1e9 / num_setups;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  num_setups = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 200000;
+  const unsigned int max_shards =
+      (argc > 2) ? strtoul(argv[2], nullptr, 10) : 8;
+  if ((num_setups < BENCH_WINDOW) || (max_shards == 0) ||
+      (max_shards > ITTI_MAX_TASK_SHARDS)) {
+    std::cout << "At least " << BENCH_WINDOW << " setups, 1 to "
+              << ITTI_MAX_TASK_SHARDS << " shards" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << num_setups << " setups, " << std::thread::hardware_concurrency()
+            << " CPU(s)" << std::endl;
+
+  double ns_1_shard = 0;
+  for (unsigned int num_shards = 1; num_shards <= max_shards;
+       num_shards *= 2) {
+    int fds[2];
+    if (pipe(fds)) return EXIT_FAILURE;
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      const double ns = run(num_shards);
+      std::cout.flush();
+      if (write(fds[1], &ns, sizeof(ns)) != sizeof(ns)) _exit(EXIT_FAILURE);
+      // Without the destructors of the ITTI, its threads are gone
+      _exit(0);
+    }
+    close(fds[1]);
+    double ns = 0;
+    if ((pid < 0) || (read(fds[0], &ns, sizeof(ns)) != sizeof(ns))) ns = 0;
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (ns == 0) {
+      std::cout << num_shards << " shard(s): failed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (num_shards == 1) ns_1_shard = ns;
+    std::cout << num_shards << " shard(s): " << ns << " ns/setup ("
+              << (1e9 / ns) << " setups/s), x" << (ns_1_shard / ns)
+              << std::endl;
+  }
+  return 0;
+}
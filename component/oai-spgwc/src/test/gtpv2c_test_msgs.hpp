@@ -0,0 +1,171 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpv2c_test_msgs.hpp
+  \brief S11 messages of an attach and a detach as an MME sends them, and the
+  SGW-C answer to the attach, for the GTPv2-C codec test and benchmark
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_GTPV2C_TEST_MSGS_HPP_SEEN
+#define FILE_GTPV2C_TEST_MSGS_HPP_SEEN
+
+#include "3gpp_29.274.hpp"
+#include "msg_gtpv2c.hpp"
+
+#include <arpa/inet.h>
+
+//------------------------------------------------------------------------------
+inline fteid_t test_fteid(
+    const interface_type_e interface_type, const uint32_t teid,
+    const char* ipv4) {
+  fteid_t fteid        = {};
+  fteid.v4             = 1;
+  fteid.interface_type = interface_type;
+  fteid.teid_gre_key   = teid;
+  inet_pton(AF_INET, ipv4, &fteid.ipv4_address);
+  return fteid;
+}
+//------------------------------------------------------------------------------
+// IMSI 208950000000001, MCC 208 MNC 95, default bearer and a dedicated one
+inline void build_create_session_request(
+    gtpv2c::gtpv2c_create_session_request& csr) {
+  imsi_t imsi        = {};
+  const char* digits = "208950000000001";
+  imsi.num_digits    = 15;
+  for (int i = 0; i < IMSI_BCD8_SIZE; i++) {
+    const uint8_t low  = digits[2 * i] - '0';
+    const uint8_t high = (2 * i + 1 < 15) ? digits[2 * i + 1] - '0' : 0x0f;
+    imsi.u1.b[i]       = low | (high << 4);
+  }
+  csr.set(imsi);
+
+  uli_t uli                                 = {};
+  uli.user_location_information_ie_hdr.tai  = 1;
+  uli.user_location_information_ie_hdr.ecgi = 1;
+  uli.tai1.mcc_digit_1                      = 2;
+  uli.tai1.mcc_digit_2                      = 0;
+  uli.tai1.mcc_digit_3                      = 8;
+  uli.tai1.mnc_digit_1                      = 9;
+  uli.tai1.mnc_digit_2                      = 5;
+  uli.tai1.mnc_digit_3                      = 0x0f;
+  uli.tai1.tracking_area_code               = 1;
+  uli.ecgi1.mcc_digit_1                     = 2;
+  uli.ecgi1.mcc_digit_2                     = 0;
+  uli.ecgi1.mcc_digit_3                     = 8;
+  uli.ecgi1.mnc_digit_1                     = 9;
+  uli.ecgi1.mnc_digit_2                     = 5;
+  uli.ecgi1.mnc_digit_3                     = 0x0f;
+  uli.ecgi1.e_utran_cell_identifier[2]      = 0x01;
+  csr.set(uli);
+
+  serving_network_t serving_network = {};
+  serving_network.mcc_digit_1       = 2;
+  serving_network.mcc_digit_2       = 0;
+  serving_network.mcc_digit_3       = 8;
+  serving_network.mnc_digit_1       = 9;
+  serving_network.mnc_digit_2       = 5;
+  serving_network.mnc_digit_3       = 0x0f;
+  csr.set(serving_network);
+  rat_type_t rat_type(RAT_TYPE_E_EUTRAN_WB_EUTRAN);
+  csr.set(rat_type);
+
+  csr.set_sender_fteid_for_cp(
+      test_fteid(S11_MME_GTP_C, 0x00000001, "192.168.247.1"));
+  csr.set_pgw_s5s8_address_for_cp(
+      test_fteid(S5_S8_PGW_GTP_C, 0, "192.168.248.159"));
+
+  apn_t apn             = {};
+  apn.access_point_name = "oai.ipv4";
+  csr.set(apn);
+  selection_mode_t selection_mode = {};
+  selection_mode.selec_mode =
+      SELECTION_MODE_E_MS_OR_NETWORK_PROVIDED_APN_SUBSCRIPTION_VERIFIED;
+  csr.set(selection_mode);
+  pdn_type_t pdn_type(PDN_TYPE_E_IPV4);
+  csr.set(pdn_type);
+  paa_t paa    = {};
+  paa.pdn_type = pdn_type;
+  csr.set(paa);
+  ambr_t ambr = {};
+  ambr.br_ul  = 50000;
+  ambr.br_dl  = 100000;
+  csr.set(ambr);
+
+  for (uint8_t ebi = 5; ebi <= 6; ebi++) {
+    gtpv2c::bearer_context_to_be_created_within_create_session_request b = {};
+    b.set(ebi_t(ebi));
+    bearer_qos_t bearer_qos = {};
+    bearer_qos.label_qci    = (ebi == 5) ? 9 : 1;
+    bearer_qos.pl           = 15;
+    bearer_qos.pvi          = PRE_EMPTION_VULNERABILITY_DISABLED;
+    bearer_qos.pci          = PRE_EMPTION_CAPABILITY_DISABLED;
+    if (ebi == 6) {
+      bearer_qos.maximum_bit_rate_for_uplink     = 128;
+      bearer_qos.maximum_bit_rate_for_downlink   = 128;
+      bearer_qos.guaranted_bit_rate_for_uplink   = 64;
+      bearer_qos.guaranted_bit_rate_for_downlink = 64;
+    }
+    b.set(bearer_qos);
+    csr.add_bearer_context_to_be_created(b);
+  }
+}
+//------------------------------------------------------------------------------
+// After the initial context setup: S1-U eNB F-TEID of the default bearer
+inline void build_modify_bearer_request(
+    gtpv2c::gtpv2c_modify_bearer_request& mbr) {
+  gtpv2c::bearer_context_to_be_modified_within_modify_bearer_request b = {};
+  b.set(ebi_t(5));
+  b.set_s1_u_enb_fteid(
+      test_fteid(S1_U_ENODEB_GTP_U, 0xA0000001, "192.168.248.120"));
+  mbr.add_bearer_context_to_be_modified(b);
+}
+//------------------------------------------------------------------------------
+inline void build_delete_session_request(
+    gtpv2c::gtpv2c_delete_session_request& dsr) {
+  dsr.set(ebi_t(5));
+}
+//------------------------------------------------------------------------------
+// Accepted, UE address and the S1-U SGW F-TEID of the default bearer
+inline void build_create_session_response(
+    gtpv2c::gtpv2c_create_session_response& csr) {
+  cause_t cause     = {};
+  cause.cause_value = REQUEST_ACCEPTED;
+  csr.set(cause);
+  csr.set_sender_fteid_for_cp(
+      test_fteid(S11_S4_SGW_GTP_C, 0x00000101, "192.168.247.2"));
+  paa_t paa    = {};
+  paa.pdn_type = PDN_TYPE_E_IPV4;
+  inet_pton(AF_INET, "12.1.1.2", &paa.ipv4_address);
+  csr.set(paa);
+  apn_restriction_t apn_restriction      = {};
+  apn_restriction.restriction_type_value = 0;
+  csr.set(apn_restriction);
+  gtpv2c::bearer_context_created_within_create_session_response b = {};
+  b.set(ebi_t(5));
+  b.set(cause);
+  b.set_s1_u_sgw_fteid(
+      test_fteid(S1_U_SGW_GTP_U, 0x01000101, "192.168.248.159"));
+  csr.add_bearer_context_created(b);
+}
+
+#endif /* FILE_GTPV2C_TEST_MSGS_HPP_SEEN */
@@ -0,0 +1,306 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_gtpv2c_codec.cpp
+  \brief GTPv2-C codec round trip: a message decoded in place, with its
+  grouped IEs left in the buffer until needed, has the same IEs as one decoded
+  from a string stream, and encoding into a send buffer gives the bytes of the
+  string stream encoding. Malformed lengths are rejected before decoding.
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "gtpv2c_test_msgs.hpp"
+#include "logger.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace gtpv2c;
+
+static int failures = 0;
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+// Encoding before the send buffer
+static std::string stream_encode(gtpv2c_msg& msg) {
+  std::ostringstream oss(std::ostringstream::binary);
+  msg.dump_to(oss);
+  return oss.str();
+}
+//------------------------------------------------------------------------------
+// Decoding before the in place decoding: string stream over the received
+// buffer, IEs from the heap, grouped IEs decoded at once
+static void stream_decode(const std::string& bytes, gtpv2c_msg& msg) {
+  std::istringstream iss(bytes);
+  msg.load_from(iss);
+}
+//------------------------------------------------------------------------------
+static std::string ie_bytes(const std::shared_ptr<gtpv2c_ie>& ie) {
+  std::ostringstream oss(std::ostringstream::binary);
+  ie->dump_to(oss);
+  return oss.str();
+}
+//------------------------------------------------------------------------------
+// Grouped IEs are compared once the embedded IEs of both are decoded
+static bool same_ies(const gtpv2c_ies_t& a, const gtpv2c_ies_t& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if ((a[i]->tlv.get_type() != b[i]->tlv.get_type()) ||
+        (a[i]->tlv.get_length() != b[i]->tlv.get_length()) ||
+        (a[i]->tlv.get_instance() != b[i]->tlv.get_instance()) ||
+        (ie_bytes(a[i]) != ie_bytes(b[i]))) {
+      return false;
+    }
+    gtpv2c_grouped_ie* ga = dynamic_cast<gtpv2c_grouped_ie*>(a[i].get());
+    gtpv2c_grouped_ie* gb = dynamic_cast<gtpv2c_grouped_ie*>(b[i].get());
+    if ((ga == nullptr) != (gb == nullptr)) return false;
+    if (ga) {
+      ga->load_ies();
+      gb->load_ies();
+      if ((ga->ies.empty()) || (not same_ies(ga->ies, gb->ies))) return false;
+    }
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+static bool same_msg(gtpv2c_msg& a, gtpv2c_msg& b) {
+  return (a.get_message_type() == b.get_message_type()) &&
+         (a.get_message_length() == b.get_message_length()) &&
+         (a.has_teid() == b.has_teid()) && (a.get_teid() == b.get_teid()) &&
+         (a.get_sequence_number() == b.get_sequence_number()) &&
+         (same_ies(a.ies, b.ies));
+}
+//------------------------------------------------------------------------------
+// Number of grouped IEs still in the received buffer
+static int lazy_grouped_ies(gtpv2c_msg& msg) {
+  int lazy = 0;
+  for (auto& i : msg.ies) {
+    gtpv2c_grouped_ie* g = dynamic_cast<gtpv2c_grouped_ie*>(i.get());
+    // Decoded ones have their embedded IEs, none is empty in the corpus
+    if ((g) && (g->ies.empty())) lazy++;
+  }
+  return lazy;
+}
+//------------------------------------------------------------------------------
+// Encoded both ways, decoded both ways, then the core type of each decoded
+// message is encoded again
+template <class CORE>
+static void test_round_trip(
+    const std::string& name, const CORE& ies, const int grouped) {
+  gtpv2c_msg msg(ies);
+  msg.set_teid(0x00000101);
+  msg.set_sequence_number(0x123456);
+  const std::string bytes = stream_encode(msg);
+  check(
+      bytes.size() == msg.get_message_length() + 4u,
+      name + ", length precomputed");
+
+  char buffer[4096];
+  const std::size_t size = msg.dump_to(buffer, sizeof(buffer));
+  check(
+      (size == bytes.size()) && (std::string(buffer, size) == bytes),
+      name + ", send buffer encoding");
+  check(
+      msg.dump_to(buffer, bytes.size() - 1) == 0,
+      name + ", send buffer too small");
+
+  gtpv2c_msg from_stream = {};
+  stream_decode(bytes, from_stream);
+  check(lazy_grouped_ies(from_stream) == 0, name + ", stream decoded");
+  gtpv2c_msg in_place = {};
+  in_place.load_from(bytes.data(), bytes.size());
+  check(lazy_grouped_ies(in_place) == grouped, name + ", grouped IEs left");
+  check(stream_encode(in_place) == bytes, name + ", lazy re-encoded");
+
+  CORE core_from_stream = {};
+  from_stream.to_core_type(core_from_stream);
+  CORE core_in_place = {};
+  in_place.to_core_type(core_in_place);
+  check(lazy_grouped_ies(in_place) == 0, name + ", decoded by to_core_type");
+  check(same_msg(from_stream, in_place), name + ", same IEs");
+  check(stream_encode(in_place) == bytes, name + ", decoded re-encoded");
+
+  gtpv2c_msg again_from_stream(core_from_stream);
+  gtpv2c_msg again_in_place(core_in_place);
+  for (auto m : {&again_from_stream, &again_in_place}) {
+    m->set_teid(0x00000101);
+    m->set_sequence_number(0x123456);
+  }
+  check(
+      stream_encode(again_from_stream) == bytes,
+      name + ", core type from stream decoding re-encoded");
+  check(
+      stream_encode(again_in_place) == bytes,
+      name + ", core type from in place decoding re-encoded");
+}
+//------------------------------------------------------------------------------
+static std::string create_session_request_bytes() {
+  gtpv2c_create_session_request csr = {};
+  build_create_session_request(csr);
+  gtpv2c_msg msg(csr);
+  msg.set_teid(0);
+  return stream_encode(msg);
+}
+//------------------------------------------------------------------------------
+// A delete session request piggybacked: only the first message is decoded
+static void test_piggybacked() {
+  const std::string first = create_session_request_bytes();
+  gtpv2c_delete_session_request dsr = {};
+  build_delete_session_request(dsr);
+  gtpv2c_msg next(dsr);
+  next.set_teid(0x00000101);
+  const std::string both = first + stream_encode(next);
+  check(check_tliv(both.data(), both.size()) == first.size(), "piggybacked");
+  gtpv2c_msg msg = {};
+  msg.load_from(both.data(), both.size());
+  check(stream_encode(msg) == first, "piggybacked, first message decoded");
+}
+//------------------------------------------------------------------------------
+// Arena IEs outlive the scope and the decoding thread, a full arena falls back
+// on the heap. The received buffer must outlive the message.
+static void test_arena_lifetime() {
+  const std::string bytes = create_session_request_bytes();
+
+  gtpv2c_msg first = {};
+  first.load_from(bytes.data(), bytes.size());
+  for (int i = 0; i < 1000; i++) {
+    gtpv2c_msg next = {};
+    next.load_from(bytes.data(), bytes.size());
+    gtpv2c_create_session_request csr = {};
+    next.to_core_type(csr);
+  }
+  check(stream_encode(first) == bytes, "arena, kept while others decoded");
+
+  // Decoded by a thread, released by another one, as an ITTI message
+  gtpv2c_msg* moved = new gtpv2c_msg();
+  std::thread decoder([&bytes, moved]() {
+    moved->load_from(bytes.data(), bytes.size());
+    gtpv2c_create_session_request csr = {};
+    moved->to_core_type(csr);
+  });
+  decoder.join();
+  check(stream_encode(*moved) == bytes, "arena, decoder thread gone");
+  std::thread releaser([moved]() { delete moved; });
+  releaser.join();
+
+  std::vector<gtpv2c_msg> many(GTPV2C_ARENA_SIZE / bytes.size() + 10);
+  for (auto& m : many) {
+    m.load_from(bytes.data(), bytes.size());
+    gtpv2c_create_session_request csr = {};
+    m.to_core_type(csr);
+  }
+  bool all_same = true;
+  for (auto& m : many) all_same &= (stream_encode(m) == bytes);
+  check(all_same, "arena, full, heap fallback");
+}
+//------------------------------------------------------------------------------
+static bool in_place_rejected(const std::string& bytes) {
+  try {
+    gtpv2c_msg m = {};
+    m.load_from(bytes.data(), bytes.size());
+  } catch (std::exception& e) {
+    return true;
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+static bool stream_rejected(const std::string& bytes) {
+  try {
+    gtpv2c_msg m = {};
+    stream_decode(bytes, m);
+  } catch (std::exception& e) {
+    return true;
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+// Offset of the first bearer context IE
+static std::size_t first_bearer_context(const std::string& bytes) {
+  std::size_t offset = 12;
+  while (offset + 4 <= bytes.size()) {
+    if ((uint8_t) bytes[offset] == GTP_IE_BEARER_CONTEXT) return offset;
+    offset += 4 + ((((uint8_t) bytes[offset + 1]) << 8) |
+                   (uint8_t) bytes[offset + 2]);
+  }
+  return 0;
+}
+//------------------------------------------------------------------------------
+static void test_malformed() {
+  const std::string bytes = create_session_request_bytes();
+
+  // Cut inside the last IE, and a header only
+  for (const std::size_t cut : {bytes.size() - 3, (std::size_t) 12}) {
+    const std::string cut_bytes = bytes.substr(0, cut);
+    check(
+        in_place_rejected(cut_bytes),
+        "malformed, rejected cut at " + std::to_string(cut));
+    check(
+        stream_rejected(cut_bytes),
+        "malformed, stream rejected cut at " + std::to_string(cut));
+  }
+
+  // Bearer context longer than the message
+  const std::size_t bc = first_bearer_context(bytes);
+  check(bc != 0, "malformed, bearer context found");
+  std::string grouped_too_long = bytes;
+  grouped_too_long[bc + 2]     = (char) 0xff;
+  check(in_place_rejected(grouped_too_long), "malformed, grouped IE length");
+
+  // EBI inside the bearer context longer than the bearer context
+  std::string inner_too_long = bytes;
+  inner_too_long[bc + 4 + 2] = (char) 0xf0;
+  check(in_place_rejected(inner_too_long), "malformed, embedded IE length");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  // Malformed messages are logged, no sink
+  Logger::init("test_gtpv2c_codec", false, false);
+  gtpv2c_create_session_request csr = {};
+  build_create_session_request(csr);
+  test_round_trip("create session request", csr, 2);
+  gtpv2c_modify_bearer_request mbr = {};
+  build_modify_bearer_request(mbr);
+  test_round_trip("modify bearer request", mbr, 1);
+  gtpv2c_delete_session_request dsr = {};
+  build_delete_session_request(dsr);
+  test_round_trip("delete session request", dsr, 0);
+  gtpv2c_create_session_response csp = {};
+  build_create_session_response(csp);
+  test_round_trip("create session response", csp, 1);
+  test_piggybacked();
+  test_arena_lifetime();
+  test_malformed();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_gtpv2c_codec passed" << std::endl;
+  return 0;
+}
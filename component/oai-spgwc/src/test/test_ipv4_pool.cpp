@@ -0,0 +1,225 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_ipv4_pool.cpp
+  \brief UE IPv4 pool: hierarchical bitmap at the word and level boundaries,
+  reuse delay of the released addresses and static addresses conflicting
+  with the dynamic ones
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "3gpp_29.274.h"
+#include "pgw_paa_dynamic.hpp"
+
+#include <iostream>
+#include <set>
+#include <string>
+
+static int failures = 0;
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+static struct in_addr ipv4(const uint32_t hbo) {
+  struct in_addr a;
+  a.s_addr = htobe32(hbo);
+  return a;
+}
+
+// Gives the test access to the bitmap levels of the pool
+class test_ipv4_pool : public ipv4_pool {
+ public:
+  test_ipv4_pool(const struct in_addr first, const uint32_t range)
+      : ipv4_pool(first, range) {}
+
+  size_t num_levels() const { return levels.size(); }
+  uint32_t delay() const { return reuse_delay; }
+
+  // A bit of level l+1 is set if and only if its word of level l is not 0
+  bool levels_consistent() const {
+    for (size_t l = 0; l + 1 < levels.size(); l++) {
+      for (uint32_t w = 0; w < levels[l].size(); w++) {
+        if (test_bit(levels[l + 1], w) != (levels[l][w] != 0)) return false;
+      }
+    }
+    return levels.back().size() == 1;
+  }
+};
+
+#define TEST_POOL_START 0x0A000000
+
+//------------------------------------------------------------------------------
+// Sizes around a word (64) and a level (64^2, 64^3): the addresses are
+// allocated lowest first, all of them, then the pool is full. Released in
+// descending order, the ones out of the reuse delay are allocated again
+// lowest first by the bitmap, then the held ones, oldest first.
+static void test_boundaries(const uint32_t range, const size_t num_levels) {
+  const std::string name = "range " + std::to_string(range) + ", ";
+  test_ipv4_pool pool(ipv4(TEST_POOL_START), range);
+  check(pool.num_levels() == num_levels, name + "levels");
+  check(pool.levels_consistent(), name + "levels consistent at start");
+
+  struct in_addr a = {};
+  bool in_order    = true;
+  for (uint32_t pos = 0; pos < range; pos++) {
+    in_order &= (pool.alloc_address(a)) &&
+                (be32toh(a.s_addr) == TEST_POOL_START + pos);
+  }
+  check(in_order, name + "allocated lowest first");
+  check(not pool.alloc_address(a), name + "full");
+  check(a.s_addr == 0, name + "no address when full");
+  check(pool.levels_consistent(), name + "levels consistent when full");
+
+  for (uint32_t pos = range; pos-- > 0;) {
+    if (not pool.free_address(ipv4(TEST_POOL_START + pos))) {
+      check(false, name + "free " + std::to_string(pos));
+    }
+  }
+  check(
+      not pool.free_address(ipv4(TEST_POOL_START + range - 1)),
+      name + "double free");
+  check(pool.levels_consistent(), name + "levels consistent when released");
+
+  const uint32_t held = pool.delay();
+  in_order            = true;
+  for (uint32_t pos = held; pos < range; pos++) {
+    in_order &= (pool.alloc_address(a)) &&
+                (be32toh(a.s_addr) == TEST_POOL_START + pos);
+  }
+  check(in_order, name + "free addresses allocated lowest first");
+  for (uint32_t pos = held; pos-- > 0;) {
+    in_order &= (pool.alloc_address(a)) &&
+                (be32toh(a.s_addr) == TEST_POOL_START + pos);
+  }
+  check(in_order, name + "held addresses allocated oldest first");
+  check(not pool.alloc_address(a), name + "full again");
+  check(pool.levels_consistent(), name + "levels consistent when full again");
+
+  // One address at each word boundary released while the pool is full
+  const uint32_t boundaries[] = {0,      63,     64,     4095,
+                                 4096,   262143, 262144, range - 1};
+  std::set<uint32_t> released = {};
+  for (auto pos : boundaries) {
+    if ((pos < range) && (released.insert(pos).second)) {
+      pool.free_address(ipv4(TEST_POOL_START + pos));
+    }
+  }
+  check(pool.levels_consistent(), name + "levels consistent, boundaries");
+  std::set<uint32_t> allocated = {};
+  // Bounded, a broken bitmap may give the same address again and again
+  for (uint32_t n = 0; (n <= range) && (pool.alloc_address(a)); n++) {
+    allocated.insert(be32toh(a.s_addr) - TEST_POOL_START);
+  }
+  check(allocated == released, name + "boundary addresses allocated again");
+  check(pool.levels_consistent(), name + "levels consistent at end");
+}
+//------------------------------------------------------------------------------
+static void test_static_addresses() {
+  test_ipv4_pool pool(ipv4(TEST_POOL_START), 256);
+  const struct in_addr first = ipv4(TEST_POOL_START);
+  check(pool.in_pool(first), "static, first address in pool");
+  check(not pool.in_pool(ipv4(TEST_POOL_START + 256)), "static, after pool");
+  check(not pool.in_pool(ipv4(TEST_POOL_START - 1)), "static, before pool");
+  check(
+      not pool.reserve_address(ipv4(TEST_POOL_START + 256)),
+      "static, address out of the pool refused");
+
+  // Static address: never allocated dynamically, no double reservation
+  check(pool.reserve_address(first), "static, reserved");
+  check(not pool.reserve_address(first), "static, reserved twice");
+  struct in_addr a = {};
+  check(pool.alloc_address(a), "static, dynamic allocation");
+  check(be32toh(a.s_addr) == TEST_POOL_START + 1, "static, next address");
+  check(
+      not pool.reserve_address(a), "static, dynamically allocated refused");
+
+  // Released then reserved while held back: not allocated from the FIFO
+  const struct in_addr released = a;
+  check(pool.free_address(released), "static, dynamic address released");
+  check(pool.reserve_address(released), "static, held address reserved");
+  bool conflict = false;
+  uint32_t n    = 0;
+  for (; (n <= 256) && (pool.alloc_address(a)); n++) {
+    conflict |= (a.s_addr == first.s_addr) || (a.s_addr == released.s_addr);
+  }
+  check(not conflict, "static, reserved addresses not allocated");
+  check(n == 254, "static, the other addresses allocated");
+
+  // Released by the session, the static address is held as any other
+  check(pool.free_address(released), "static, released");
+  check(not pool.free_address(released), "static, released twice");
+  check(pool.alloc_address(a), "static, allocated once held back");
+  check(a.s_addr == released.s_addr, "static, only the held one left");
+}
+//------------------------------------------------------------------------------
+static void test_snapshot_restore() {
+  test_ipv4_pool pool(ipv4(TEST_POOL_START), 1024);
+  struct in_addr a = {};
+  for (int i = 0; i < 10; i++) pool.alloc_address(a);
+  pool.free_address(ipv4(TEST_POOL_START + 3));
+  std::vector<struct in_addr> addresses = {};
+  pool.snapshot(addresses);
+  check(addresses.size() == 10, "snapshot, held and allocated addresses");
+  check(
+      be32toh(addresses[0].s_addr) == TEST_POOL_START + 3,
+      "snapshot, held address first");
+
+  // Restored addresses are held back, given last and oldest first
+  test_ipv4_pool restored(ipv4(TEST_POOL_START), 1024);
+  for (const auto& r : addresses) {
+    check(restored.restore(r), "restore, address held back");
+  }
+  check(not restored.restore(addresses[0]), "restore, twice");
+  bool conflict = false;
+  for (int i = 0; i < 1024 - 10; i++) {
+    conflict |= (not restored.alloc_address(a));
+    for (const auto& r : addresses) conflict |= (a.s_addr == r.s_addr);
+  }
+  check(not conflict, "restore, free addresses allocated first");
+  check(
+      (restored.alloc_address(a)) && (a.s_addr == addresses[0].s_addr),
+      "restore, then the oldest held address");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  test_boundaries(1, 1);
+  test_boundaries(63, 1);
+  test_boundaries(64, 1);
+  test_boundaries(65, 2);
+  test_boundaries(4096, 2);
+  test_boundaries(4097, 3);
+  test_boundaries(262144, 3);
+  test_boundaries(262145, 4);
+  test_static_addresses();
+  test_snapshot_restore();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_ipv4_pool passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,219 @@
+#!/bin/bash
+#/*
+# * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+# * contributor license agreements.  See the NOTICE file distributed with
+# * this work for additional information regarding copyright ownership.
+# * The OpenAirInterface Software Alliance licenses this file to You under
+# * the OAI Public License, Version 1.1  (the "License"); you may not use this file
+# * except in compliance with the License.
+# * You may obtain a copy of the License at
+# *
+# *      http://www.openairinterface.org/?page_id=698
+# *
+# * Unless required by applicable law or agreed to in writing, software
+# * distributed under the License is distributed on an "AS IS" BASIS,
+# * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# * See the License for the specific language governing permissions and
+# * limitations under the License.
+# *-------------------------------------------------------------------------------
+# * For more information about the OpenAirInterface (OAI) Software Alliance:
+# *      contact@openairinterface.org
+# */
+
+# End-to-end benchmark of the SPGW-U, on a single host.
+# spgwu_loadgen emulates the SPGW-C on Sx, the eNBs on S1-U and a server on
+# SGi, each side lives in its own network namespace:
+#
+#   lg-enb  (Sx + S1-U)  enb <--> s1u   lg-spgwu   sgi <--> srv  (SGi)  lg-sgi
+#   10.101.0.1 (eNB), 10.101.0.10 (SPGW-C)   10.101.0.2 | 10.103.0.2   10.103.0.1
+#
+# The results are appended to a CSV file labelled with the current commit, so
+# that the runs of several commits can be compared.
+
+function usage {
+    echo "SPGW-U end-to-end benchmark"
+    echo ""
+    echo "   Requirement: root, spgwu and spgwu_loadgen built (build_spgwu --loadgen)"
+    echo ""
+    echo "Usage:"
+    echo "------"
+    echo "    runLoadgenBenchmark.sh [OPTIONS] [-- LOADGEN_OPTIONS]"
+    echo ""
+    echo "Options:"
+    echo "--------"
+    echo "    --build-dir ####    Build directory of the SPGW-U (default build/spgw_u/build)"
+    echo "    --sessions ####     PFCP sessions (default 1000)"
+    echo "    --ul-rate ####      UL packets per second (default 100000)"
+    echo "    --dl-rate ####      DL packets per second (default 100000)"
+    echo "    --size ####         Size of the UE IP packets (default 512)"
+    echo "    --duration ####     Seconds measured (default 10)"
+    echo "    --s1u-threads ####  S1-U threads of the SPGW-U (default 1)"
+    echo "    --sgi-threads ####  SGi threads of the SPGW-U (default 1)"
+    echo "    --csv ####          Results file (default loadgen_results.csv)"
+    echo "    --keep              Keep the namespaces and the logs at the end"
+    echo "    --help OR -h        Print this help message."
+    echo ""
+    echo "    LOADGEN_OPTIONS are given as is to spgwu_loadgen (spgwu_loadgen --help)"
+    echo ""
+}
+
+SCRIPT_DIR=$(dirname $(readlink -f $0))
+TOP_DIR=$(dirname $SCRIPT_DIR)
+BUILD_DIR=$TOP_DIR/build/spgw_u/build
+SESSIONS=1000
+UL_RATE=100000
+DL_RATE=100000
+SIZE=512
+DURATION=10
+S1U_THREADS=1
+SGI_THREADS=1
+CSV_FILE=loadgen_results.csv
+KEEP=0
+UE_NETWORK=12.1.0.0/16
+WORK_DIR=/tmp/spgwu_loadgen.$$
+
+while [ $# -gt 0 ]
+do
+    case "$1" in
+        --build-dir) BUILD_DIR=$2; shift 2;;
+        --sessions) SESSIONS=$2; shift 2;;
+        --ul-rate) UL_RATE=$2; shift 2;;
+        --dl-rate) DL_RATE=$2; shift 2;;
+        --size) SIZE=$2; shift 2;;
+        --duration) DURATION=$2; shift 2;;
+        --s1u-threads) S1U_THREADS=$2; shift 2;;
+        --sgi-threads) SGI_THREADS=$2; shift 2;;
+        --csv) CSV_FILE=$2; shift 2;;
+        --keep) KEEP=1; shift;;
+        -h | --help) usage; exit 0;;
+        --) shift; break;;
+        *)
+            echo "Syntax Error: unknown option $1"
+            echo ""
+            usage
+            exit 1
+            ;;
+    esac
+done
+
+SPGWU=$BUILD_DIR/spgwu
+LOADGEN=$BUILD_DIR/spgwu_loadgen/spgwu_loadgen
+for EXE in $SPGWU $LOADGEN
+do
+    if [ ! -x $EXE ]
+    then
+        echo "$EXE not found, build it first (build_spgwu --loadgen)"
+        exit 1
+    fi
+done
+if [ $(id -u) -ne 0 ]
+then
+    echo "Must be run as root (network namespaces)"
+    exit 1
+fi
+
+LABEL=$(cd $TOP_DIR && git rev-parse --short HEAD 2> /dev/null)
+if [ -z "$LABEL" ]
+then
+    LABEL=unknown
+fi
+SPGWU_PID=0
+
+function teardown {
+    if [ $SPGWU_PID -ne 0 ]
+    then
+        kill $SPGWU_PID 2> /dev/null
+        wait $SPGWU_PID 2> /dev/null
+    fi
+    if [ $KEEP -eq 0 ]
+    then
+        for NS in lg-enb lg-spgwu lg-sgi
+        do
+            ip netns del $NS 2> /dev/null
+        done
+        rm -Rf $WORK_DIR
+    else
+        echo "Namespaces lg-enb lg-spgwu lg-sgi and $WORK_DIR kept"
+    fi
+}
+trap teardown EXIT
+
+function setup {
+    set -e
+    for NS in lg-enb lg-spgwu lg-sgi
+    do
+        ip netns del $NS 2> /dev/null || true
+        ip netns add $NS
+        ip -n $NS link set lo up
+        ip netns exec $NS sysctl -qw net.ipv4.conf.all.rp_filter=0
+        ip netns exec $NS sysctl -qw net.ipv4.conf.default.rp_filter=0
+    done
+
+    # S1-U and Sx
+    ip link add enb netns lg-enb type veth peer name s1u netns lg-spgwu
+    ip -n lg-enb addr add 10.101.0.1/24 dev enb
+    ip -n lg-enb addr add 10.101.0.10/24 dev enb
+    ip -n lg-spgwu addr add 10.101.0.2/24 dev s1u
+
+    # SGi, the UE pool is routed by the server to the SPGW-U. The SPGW-U
+    # puts the UE pool on its TUN and enables forwarding, its kernel routes
+    # between the TUN and the sgi veth.
+    ip link add srv netns lg-sgi type veth peer name sgi netns lg-spgwu
+    ip -n lg-sgi addr add 10.103.0.1/24 dev srv
+    ip -n lg-spgwu addr add 10.103.0.2/24 dev sgi
+    for LINK in lg-enb:enb lg-spgwu:s1u lg-spgwu:sgi lg-sgi:srv
+    do
+        ip -n ${LINK%%:*} link set ${LINK##*:} up
+    done
+    ip -n lg-spgwu route add default via 10.103.0.1 dev sgi
+    ip -n lg-sgi route add $UE_NETWORK via 10.103.0.2 dev srv
+    set +e
+}
+
+function generate_config {
+    mkdir -p $WORK_DIR
+    sed -e "s#@PID_DIRECTORY@#$WORK_DIR#" \
+        -e "s#@SGW_INTERFACE_NAME_FOR_S1U_S12_S4_UP@#s1u#" \
+        -e "s#@SGW_INTERFACE_NAME_FOR_SX@#s1u#" \
+        -e "s#@PGW_INTERFACE_NAME_FOR_SGI@#sgi#" \
+        -e "s#@THREAD_S1U_PRIO@#84#" \
+        -e "s#@THREAD_SX_PRIO@#84#" \
+        -e "s#@THREAD_SGI_PRIO@#84#" \
+        -e "s#@S1U_THREADS@#$S1U_THREADS#" \
+        -e "s#@SX_THREADS@#1#" \
+        -e "s#@SGI_THREADS@#$SGI_THREADS#" \
+        -e "s#@NETWORK_UE_NAT_OPTION@#no#" \
+        -e "s#@NETWORK_UE_IP@#$UE_NETWORK#" \
+        -e "s#@SPGWC0_IP_ADDRESS@#10.101.0.10#" \
+        -e "s#@BYPASS_UL_PFCP_RULES@#no#" \
+        -e "s#\#MAX_PFCP_SESSIONS *= *[0-9]*;#MAX_PFCP_SESSIONS = $SESSIONS;#" \
+        $TOP_DIR/etc/spgw_u.conf > $WORK_DIR/spgw_u.conf
+}
+
+setup
+if [ $? -ne 0 ]
+then
+    echo "Network namespaces setup failed"
+    exit 1
+fi
+generate_config
+
+ip netns exec lg-spgwu $SPGWU -c $WORK_DIR/spgw_u.conf -o > $WORK_DIR/spgwu.log 2>&1 &
+SPGWU_PID=$!
+
+# The SPGW-U sets up the association, spgwu_loadgen waits for it
+ip netns exec lg-enb $LOADGEN \
+    --sx-netns lg-enb --s1u-netns lg-enb --sgi-netns lg-sgi \
+    --cp-addr 10.101.0.10 --enb-addr 10.101.0.1 --sgi-addr 10.103.0.1 \
+    --ue-network $UE_NETWORK --sessions $SESSIONS \
+    --ul-rate $UL_RATE --dl-rate $DL_RATE --size $SIZE --duration $DURATION \
+    --csv $CSV_FILE --label $LABEL "$@"
+RET=$?
+
+if ! kill -0 $SPGWU_PID 2> /dev/null
+then
+    echo "The SPGW-U exited during the benchmark, see its log:"
+    tail -n 20 $WORK_DIR/spgwu.log
+    RET=1
+fi
+exit $RET
@@ -1140,6 +1140,9 @@ typedef struct packet_rate_s {
 #define OUTER_HEADER_REMOVAL_GTPU_UDP_IPV6 1
 #define OUTER_HEADER_REMOVAL_UDP_IPV4 2
 #define OUTER_HEADER_REMOVAL_UDP_IPV6 3
+#define OUTER_HEADER_REMOVAL_IPV4 4
+#define OUTER_HEADER_REMOVAL_IPV6 5
+#define OUTER_HEADER_REMOVAL_GTPU_UDP_IP 6
 typedef struct outer_header_removal_s {
   uint8_t outer_header_removal_description;
 } outer_header_removal_t;
@@ -33,6 +33,7 @@
 
 #include "itti_msg.hpp"
 #include "thread_sched.hpp"
+#include <functional>
 #include <string>
 #include <thread>
 
@@ -52,6 +53,12 @@ class async_shell_cmd {
   int run_command(
       const task_id_t sender_itti_task, const bool is_abort_on_error,
       const char* src_file, const int src_line, const std::string& cmd_str);
+  // Blocking work kept off the calling task (e.g. file writes), job returns
+  // RETURNok or RETURNerror, job_name is logged if it fails
+  int run_job(
+      const task_id_t sender_itti_task, const bool is_abort_on_error,
+      const char* src_file, const int src_line, const std::string& job_name,
+      const std::function<int()>& job);
 };
 
 }  // namespace util
@@ -0,0 +1,232 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file fixed_hash_table.hpp
+  \brief Preallocated open addressing hash table, one writer, lock-free
+         readers
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_FIXED_HASH_TABLE_HPP_SEEN
+#define FILE_FIXED_HASH_TABLE_HPP_SEEN
+
+#include "qsbr.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace util {
+
+// Maps uint64_t keys (TEIDs, IPv4 addresses, IPv6 /64 prefixes) to T*, the
+// two greatest values are reserved. Linear probing in an array allocated
+// once, sized for max_entries at a load factor of 1/2.
+// - One writer thread: set(), erase().
+// - Any number of reader threads: find(), no lock, no write to shared memory.
+// Erased slots become tombstones and are reused by next insertions. When
+// tombstones make the probe sequences too long, the writer rehashes the live
+// entries in a fresh array, publishes it with one atomic store and retires
+// the previous one through util::qsbr, so readers must be util::qsbr readers.
+// The table never frees the T objects, erased and replaced values are given
+// back to the caller.
+template <class T>
+class fixed_hash_table {
+ private:
+#define FIXED_HASH_TABLE_EMPTY_KEY UINT64_MAX
+#define FIXED_HASH_TABLE_TOMBSTONE_KEY (UINT64_MAX - 1)
+#define FIXED_HASH_TABLE_MIN_CAPACITY 64
+
+  typedef struct slot_s {
+    std::atomic<uint64_t> key;
+    std::atomic<T*> value;
+  } slot_t;
+
+  class slots {
+   public:
+    const std::size_t mask;
+    std::unique_ptr<slot_t[]> slot;
+
+    explicit slots(const std::size_t capacity)
+        : mask(capacity - 1), slot(new slot_t[capacity]) {
+      for (std::size_t i = 0; i < capacity; i++) {
+        slot[i].key.store(
+            FIXED_HASH_TABLE_EMPTY_KEY, std::memory_order_relaxed);
+        slot[i].value.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  std::atomic<slots*> slots_;
+  // Writer side
+  std::size_t max_entries_;
+  std::size_t size_;
+  std::size_t tombstones_;
+  uint64_t compactions_;
+
+  static std::size_t hash(const uint64_t key) {
+    // Fibonacci hashing, TEIDs and UE addresses are often consecutive
+    return (std::size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+  }
+
+  // Writer side, slot holding key or nullptr
+  slot_t* lookup(slots* t, const uint64_t key) const {
+    std::size_t i = hash(key) & t->mask;
+    for (std::size_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+      uint64_t k = t->slot[i].key.load(std::memory_order_relaxed);
+      if (k == key) return &t->slot[i];
+      if (k == FIXED_HASH_TABLE_EMPTY_KEY) return nullptr;
+    }
+    return nullptr;
+  }
+
+  // Keep the probe sequences short: at most 3/4 of the slots not empty
+  bool too_many_tombstones(const slots* t) const {
+    return (tombstones_) && (4 * (size_ + tombstones_) > 3 * (t->mask + 1));
+  }
+
+  void compact() {
+    slots* old = slots_.load(std::memory_order_relaxed);
+    slots* t   = new slots(old->mask + 1);
+    for (std::size_t i = 0; i <= old->mask; i++) {
+      uint64_t k = old->slot[i].key.load(std::memory_order_relaxed);
+      if ((k == FIXED_HASH_TABLE_EMPTY_KEY) ||
+          (k == FIXED_HASH_TABLE_TOMBSTONE_KEY)) {
+        continue;
+      }
+      std::size_t j = hash(k) & t->mask;
+      while (t->slot[j].key.load(std::memory_order_relaxed) !=
+             FIXED_HASH_TABLE_EMPTY_KEY) {
+        j = (j + 1) & t->mask;
+      }
+      t->slot[j].value.store(
+          old->slot[i].value.load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      t->slot[j].key.store(k, std::memory_order_relaxed);
+    }
+    slots_.store(t, std::memory_order_release);
+    tombstones_ = 0;
+    compactions_++;
+    util::qsbr::get_instance().retire(old);
+  }
+
+ public:
+  explicit fixed_hash_table(const std::size_t max_entries)
+      : slots_(nullptr),
+        max_entries_(max_entries),
+        size_(0),
+        tombstones_(0),
+        compactions_(0) {
+    std::size_t capacity = FIXED_HASH_TABLE_MIN_CAPACITY;
+    while (capacity < 2 * max_entries) capacity <<= 1;
+    slots_.store(new slots(capacity));
+  }
+  fixed_hash_table(fixed_hash_table const&) = delete;
+  void operator=(fixed_hash_table const&) = delete;
+
+  ~fixed_hash_table() { delete slots_.load(); }
+
+  // Reader side
+  T* find(const uint64_t key) const {
+    const slots* t = slots_.load(std::memory_order_acquire);
+    std::size_t i  = hash(key) & t->mask;
+    for (std::size_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+      const slot_t& s = t->slot[i];
+      uint64_t k      = s.key.load(std::memory_order_acquire);
+      if (k == key) {
+        T* value = s.value.load(std::memory_order_acquire);
+        // The slot may have been erased and reused for another key meanwhile
+        if (s.key.load(std::memory_order_acquire) == key) return value;
+        return nullptr;
+      }
+      if (k == FIXED_HASH_TABLE_EMPTY_KEY) return nullptr;
+    }
+    return nullptr;
+  }
+
+  // Writer side. Inserts or replaces, the replaced value is returned in
+  // old_value. Returns false if the table is full or the key is reserved.
+  bool set(const uint64_t key, T* const value, T*& old_value) {
+    slots* t          = slots_.load(std::memory_order_relaxed);
+    slot_t* free_slot = nullptr;
+    std::size_t i     = hash(key) & t->mask;
+    old_value         = nullptr;
+    if (key >= FIXED_HASH_TABLE_TOMBSTONE_KEY) {
+      return false;
+    }
+    for (std::size_t n = 0; n <= t->mask; n++, i = (i + 1) & t->mask) {
+      slot_t& s  = t->slot[i];
+      uint64_t k = s.key.load(std::memory_order_relaxed);
+      if (k == key) {
+        old_value = s.value.exchange(value, std::memory_order_acq_rel);
+        return true;
+      }
+      if (k == FIXED_HASH_TABLE_TOMBSTONE_KEY) {
+        if (not free_slot) free_slot = &s;
+      } else if (k == FIXED_HASH_TABLE_EMPTY_KEY) {
+        if (not free_slot) free_slot = &s;
+        break;
+      }
+    }
+    if ((not free_slot) || (size_ >= max_entries_)) {
+      return false;
+    }
+    if (free_slot->key.load(std::memory_order_relaxed) ==
+        FIXED_HASH_TABLE_TOMBSTONE_KEY) {
+      tombstones_--;
+    }
+    // Value visible before the key
+    free_slot->value.store(value, std::memory_order_release);
+    free_slot->key.store(key, std::memory_order_release);
+    size_++;
+    if (too_many_tombstones(t)) {
+      compact();
+    }
+    return true;
+  }
+
+  // Writer side, returns the erased value or nullptr
+  T* erase(const uint64_t key) {
+    slots* t  = slots_.load(std::memory_order_relaxed);
+    slot_t* s = lookup(t, key);
+    if (not s) return nullptr;
+    T* value = s->value.exchange(nullptr, std::memory_order_acq_rel);
+    s->key.store(FIXED_HASH_TABLE_TOMBSTONE_KEY, std::memory_order_release);
+    size_--;
+    tombstones_++;
+    if (too_many_tombstones(t)) {
+      compact();
+    }
+    return value;
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const {
+    return slots_.load(std::memory_order_relaxed)->mask + 1;
+  }
+  std::size_t max_entries() const { return max_entries_; }
+  std::size_t tombstones() const { return tombstones_; }
+  uint64_t compactions() const { return compactions_; }
+};
+
+}  // namespace util
+
+#endif /* FILE_FIXED_HASH_TABLE_HPP_SEEN */
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file latency_histogram.hpp
+  \brief Log-linear histogram of latencies, constant time record
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_LATENCY_HISTOGRAM_HPP_SEEN
+#define FILE_LATENCY_HISTOGRAM_HPP_SEEN
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace util {
+
+// Values below 2^LATENCY_HISTOGRAM_SUB_BITS have a bucket each, above, every
+// power of 2 is split in 2^LATENCY_HISTOGRAM_SUB_BITS buckets: a value is
+// known within 1/32 of itself (about 3%) whatever its unit (TSC ticks, ns).
+// record() is a few instructions with no allocation. Not thread safe, each
+// thread records in its own histogram, the histograms are merged to be read.
+class latency_histogram {
+ public:
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS                                              \
+  ((64 - LATENCY_HISTOGRAM_SUB_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+ private:
+  uint64_t counts_[LATENCY_HISTOGRAM_BUCKETS];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+
+ public:
+  latency_histogram() { clear(); }
+
+  static uint32_t bucket(const uint64_t v) {
+    if (v < LATENCY_HISTOGRAM_SUB_BUCKETS) return (uint32_t) v;
+    const int shift = 63 - __builtin_clzll(v) - LATENCY_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << LATENCY_HISTOGRAM_SUB_BITS) +
+           ((v >> shift) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+  }
+  // Lowest and highest values of a bucket
+  static uint64_t bucket_low(const uint32_t b) {
+    if (b < 2 * LATENCY_HISTOGRAM_SUB_BUCKETS) return b;
+    const int shift = (b >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+    return ((uint64_t)(LATENCY_HISTOGRAM_SUB_BUCKETS |
+                       (b & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1))))
+           << shift;
+  }
+  static uint64_t bucket_high(const uint32_t b) {
+    if (b < 2 * LATENCY_HISTOGRAM_SUB_BUCKETS) return b;
+    const int shift = (b >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+    return bucket_low(b) + (1ULL << shift) - 1;
+  }
+
+  void record(const uint64_t v) {
+    counts_[bucket(v)]++;
+    count_++;
+    sum_ += v;
+    if (v > max_) max_ = v;
+  }
+
+  void merge(const latency_histogram& h) {
+    for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+      counts_[b] += h.counts_[b];
+    }
+    count_ += h.count_;
+    sum_ += h.sum_;
+    max_ = std::max(max_, h.max_);
+  }
+
+  // Buckets counted elsewhere, e.g. copied from the relaxed atomics of a
+  // packet worker
+  void merge(const uint64_t* counts, const uint64_t sum, const uint64_t max) {
+    for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+      counts_[b] += counts[b];
+      count_ += counts[b];
+    }
+    sum_ += sum;
+    max_ = std::max(max_, max);
+  }
+
+  void clear() {
+    memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_   = 0;
+    max_   = 0;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t sum() const { return sum_; }
+  uint64_t max() const { return max_; }
+  uint64_t count(const uint32_t b) const { return counts_[b]; }
+  double mean() const { return count_ ? (double) sum_ / count_ : 0; }
+
+  // Highest value of the bucket holding the percentile p (0 to 100), so that
+  // at least p% of the values are known to be lower or equal, 0 if empty
+  uint64_t percentile(const double p) const {
+    if (not count_) return 0;
+    uint64_t rank = (uint64_t)((p / 100.0) * count_ + 0.5);
+    rank          = std::min(std::max(rank, (uint64_t) 1), count_);
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+      seen += counts_[b];
+      if (seen >= rank) return std::min(bucket_high(b), max_);
+    }
+    return max_;
+  }
+};
+
+}  // namespace util
+
+#endif /* FILE_LATENCY_HISTOGRAM_HPP_SEEN */
@@ -0,0 +1,234 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file packet_pool.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "packet_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// From linux/mempolicy.h, no dependency on libnuma
+#define PACKET_POOL_MPOL_PREFERRED 1
+
+//------------------------------------------------------------------------------
+util::packet_pool::packet_pool()
+    : num_nodes_(0),
+      headroom_(PACKET_POOL_DEFAULT_HEADROOM),
+      tailroom_(PACKET_POOL_DEFAULT_TAILROOM),
+      slot_size_(0) {
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    caches_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+//------------------------------------------------------------------------------
+int util::packet_pool::detect_num_nodes() {
+  // e.g. "0" or "0-1", the highest node is last
+  std::ifstream f("/sys/devices/system/node/online");
+  std::string online;
+  if (not std::getline(f, online)) return 1;
+  const std::size_t pos = online.find_last_of(",-");
+  const int last =
+      std::atoi(online.c_str() + ((pos == std::string::npos) ? 0 : pos + 1));
+  return std::min(std::max(last + 1, 1), PACKET_POOL_MAX_NODES);
+}
+//------------------------------------------------------------------------------
+int util::packet_pool::current_node() {
+  unsigned int cpu  = 0;
+  unsigned int node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) < 0) return 0;
+  return (int) node;
+}
+//------------------------------------------------------------------------------
+util::packet_pool::node_pool_t& util::packet_pool::local_node() {
+  const int node = current_node();
+  return *nodes_[(node < num_nodes_) ? node : 0];
+}
+//------------------------------------------------------------------------------
+bool util::packet_pool::map_node(
+    const int node, const bool bind, const uint64_t buffers,
+    const bool hugepages) {
+  node_pool_t& n   = *nodes_[node];
+  std::size_t size = buffers * slot_size_;
+  size = (size + PACKET_POOL_HUGEPAGE_SIZE - 1) &
+         ~((std::size_t) PACKET_POOL_HUGEPAGE_SIZE - 1);
+  void* p = MAP_FAILED;
+  if (hugepages) {
+    // Fails if not enough hugepages are reserved
+    p = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+  n.hugepages = (p != MAP_FAILED);
+  if (p == MAP_FAILED) {
+    p = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+        0);
+    if (p == MAP_FAILED) return false;
+    // Transparent hugepages, if enabled
+    madvise(p, size, MADV_HUGEPAGE);
+  }
+  if (bind) {
+    // Before the pages are touched, the node is preferred, not required
+    unsigned long mask = 1UL << node;
+    syscall(
+        SYS_mbind, p, size, PACKET_POOL_MPOL_PREFERRED, &mask,
+        sizeof(mask) * 8, 0);
+  }
+  n.base    = (char*) p;
+  n.size    = size;
+  n.buffers = buffers;
+  n.free.reserve(buffers);
+  // Popped from the back, the lowest addresses go first
+  for (uint64_t i = buffers; i > 0; i--) {
+    packet_buf_t* buf =
+        reinterpret_cast<packet_buf_t*>(n.base + (i - 1) * slot_size_);
+    buf->data_off = headroom_;
+    buf->len      = 0;
+    buf->refcnt   = 0;
+    buf->node     = node;
+    n.free.push_back(buf);
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+bool util::packet_pool::init(
+    const uint64_t buffers_per_node, const uint16_t headroom,
+    const uint16_t tailroom, const bool hugepages) {
+  if ((initialized()) || (buffers_per_node == 0)) return false;
+  headroom_  = headroom;
+  tailroom_  = tailroom;
+  slot_size_ = sizeof(packet_buf_t) + headroom + PACKET_POOL_DATA_ROOM +
+               tailroom + PACKET_POOL_CACHE_LINE_SIZE - 1;
+  slot_size_ &= ~((std::size_t) PACKET_POOL_CACHE_LINE_SIZE - 1);
+
+  const int num_nodes = detect_num_nodes();
+  for (int i = 0; i < num_nodes; i++) {
+    nodes_[i] = std::unique_ptr<node_pool_t>(new node_pool_t());
+    if (not map_node(i, num_nodes > 1, buffers_per_node, hugepages)) {
+      for (int j = 0; j < i; j++) {
+        munmap(nodes_[j]->base, nodes_[j]->size);
+        nodes_[j].reset();
+      }
+      nodes_[i].reset();
+      return false;
+    }
+  }
+  num_nodes_ = num_nodes;
+  return true;
+}
+//------------------------------------------------------------------------------
+util::packet_pool::cache_t* util::packet_pool::create_cache(const int id) {
+  // Allocated by the worker, on its node
+  cache_t* c     = new cache_t();
+  const int node = current_node();
+  c->node        = (node < num_nodes_) ? node : 0;
+  caches_[id].store(c, std::memory_order_release);
+  return c;
+}
+//------------------------------------------------------------------------------
+bool util::packet_pool::refill(cache_t& c) {
+  node_pool_t& n = *nodes_[c.node];
+  std::unique_lock<std::mutex> l(n.m);
+  const std::size_t burst =
+      std::min(n.free.size(), (std::size_t) PACKET_POOL_CACHE_BURST);
+  if (burst == 0) return false;
+  uint32_t count = c.count.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < burst; i++) {
+    c.bufs[count++] = n.free.back();
+    n.free.pop_back();
+  }
+  c.count.store(count, std::memory_order_relaxed);
+  return true;
+}
+//------------------------------------------------------------------------------
+void util::packet_pool::flush(cache_t& c) {
+  // The oldest buffers of the cache, the most recent ones stay
+  uint32_t count = c.count.load(std::memory_order_relaxed);
+  {
+    node_pool_t& n = *nodes_[c.node];
+    std::unique_lock<std::mutex> l(n.m);
+    n.free.insert(n.free.end(), c.bufs, c.bufs + PACKET_POOL_CACHE_BURST);
+  }
+  count -= PACKET_POOL_CACHE_BURST;
+  memmove(
+      c.bufs, c.bufs + PACKET_POOL_CACHE_BURST, count * sizeof(c.bufs[0]));
+  c.count.store(count, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+util::packet_buf_t* util::packet_pool::alloc_from_node(node_pool_t& n) {
+  packet_buf_t* buf = nullptr;
+  {
+    std::unique_lock<std::mutex> l(n.m);
+    if (n.free.size()) {
+      buf = n.free.back();
+      n.free.pop_back();
+    }
+  }
+  if (not buf) {
+    n.exhausted.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  n.allocs.fetch_add(1, std::memory_order_relaxed);
+  init_buf(buf);
+  return buf;
+}
+//------------------------------------------------------------------------------
+void util::packet_pool::release_to_node(packet_buf_t* buf) {
+  node_pool_t& n = *nodes_[buf->node];
+  std::unique_lock<std::mutex> l(n.m);
+  n.free.push_back(buf);
+}
+//------------------------------------------------------------------------------
+void util::packet_pool::get_counters(
+    std::vector<packet_pool_counters_t>& counters) const {
+  for (int i = 0; i < num_nodes_; i++) {
+    node_pool_t& n            = *nodes_[i];
+    packet_pool_counters_t nc = {};
+    nc.node                   = i;
+    nc.hugepages              = n.hugepages;
+    nc.buffers                = n.buffers;
+    {
+      std::unique_lock<std::mutex> l(n.m);
+      nc.free = n.free.size();
+    }
+    nc.allocs    = n.allocs.load(std::memory_order_relaxed);
+    nc.exhausted = n.exhausted.load(std::memory_order_relaxed);
+    for (int w = 0; w < QSBR_MAX_READERS; w++) {
+      const cache_t* c = caches_[w].load(std::memory_order_acquire);
+      if ((not c) || (c->node != i)) continue;
+      nc.free += c->count.load(std::memory_order_relaxed);
+      nc.allocs += c->allocs.load(std::memory_order_relaxed);
+      nc.cache_hits += c->cache_hits.load(std::memory_order_relaxed);
+    }
+    counters.push_back(nc);
+  }
+}
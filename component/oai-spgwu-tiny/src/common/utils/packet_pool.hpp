@@ -0,0 +1,228 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file packet_pool.hpp
+  \brief Packet buffers shared by the S1-U and SGi packet workers, on
+         hugepages, local to the NUMA node of the worker
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PACKET_POOL_HPP_SEEN
+#define FILE_PACKET_POOL_HPP_SEEN
+
+#include "qsbr.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace util {
+
+#define PACKET_POOL_CACHE_LINE_SIZE 64
+#define PACKET_POOL_HUGEPAGE_SIZE (2 << 20)
+#define PACKET_POOL_MAX_NODES 8
+// Largest packet read in a buffer
+#define PACKET_POOL_DATA_ROOM 2048
+// Outer IPv6, UDP and GTP-U headers with one extension header
+#define PACKET_POOL_MIN_HEADROOM 64
+#define PACKET_POOL_DEFAULT_HEADROOM 128
+#define PACKET_POOL_DEFAULT_TAILROOM 64
+// Per NUMA node
+#define PACKET_POOL_DEFAULT_BUFFERS 16384
+// Buffers moved at once between a worker cache and its node
+#define PACKET_POOL_CACHE_BURST 32
+#define PACKET_POOL_CACHE_SIZE (2 * PACKET_POOL_CACHE_BURST)
+
+// Descriptor of a buffer, at the start of its slot, followed by the
+// headroom, the data room and the tailroom:
+// | descriptor | headroom | data room (packet at data()) | tailroom |
+// A buffer is used by one thread at a time, the worker that read the packet
+// in it and the TX batches that queued it hold a reference each.
+typedef struct alignas(PACKET_POOL_CACHE_LINE_SIZE) packet_buf_s {
+  // From head() to the first byte of the packet
+  uint32_t data_off;
+  uint32_t len;
+  uint16_t refcnt;
+  // NUMA node of the memory of the buffer
+  uint16_t node;
+
+  char* head() { return reinterpret_cast<char*>(this) + sizeof(*this); }
+  char* data() { return head() + data_off; }
+} packet_buf_t;
+
+typedef struct packet_pool_counters_s {
+  int node;
+  bool hugepages;
+  uint64_t buffers;
+  // In the node and in the caches of its workers
+  uint64_t free;
+  uint64_t allocs;
+  // Allocations served by the cache of a worker, without locking the node
+  uint64_t cache_hits;
+  // Allocations failed, no buffer left on the node
+  uint64_t exhausted;
+} packet_pool_counters_t;
+
+// One pool of buffers per NUMA node, mapped on hugepages if some are
+// reserved (vm.nr_hugepages), on normal pages otherwise, bound to its node.
+// A thread allocates on the node of the CPU it runs on, packet workers are
+// expected to be pinned. The packet workers are the threads registered in
+// util::qsbr, each one has a cache of buffers refilled from, and flushed
+// to, the free list of its node by bursts; the other threads use the free
+// list of their node directly.
+class packet_pool {
+ private:
+  typedef struct node_pool_s {
+    char* base;
+    std::size_t size;
+    bool hugepages;
+    uint64_t buffers;
+    std::mutex m;
+    // LIFO, recently released buffers are still in the CPU caches
+    std::vector<packet_buf_t*> free;
+    // Threads that are not packet workers
+    std::atomic<uint64_t> allocs;
+    std::atomic<uint64_t> exhausted;
+  } node_pool_t;
+
+  // Written by its worker only, with plain loads and stores
+  typedef struct alignas(PACKET_POOL_CACHE_LINE_SIZE) cache_s {
+    int node;
+    std::atomic<uint32_t> count;
+    std::atomic<uint64_t> allocs;
+    std::atomic<uint64_t> cache_hits;
+    packet_buf_t* bufs[PACKET_POOL_CACHE_SIZE];
+  } cache_t;
+
+  int num_nodes_;
+  uint16_t headroom_;
+  uint16_t tailroom_;
+  std::size_t slot_size_;
+  std::unique_ptr<node_pool_t> nodes_[PACKET_POOL_MAX_NODES];
+  std::atomic<cache_t*> caches_[QSBR_MAX_READERS];
+
+  // Never freed, buffers may still be queued by the workers at exit
+  packet_pool();
+
+  static int detect_num_nodes();
+  static int current_node();
+  bool map_node(
+      const int node, const bool bind, const uint64_t buffers,
+      const bool hugepages);
+  node_pool_t& local_node();
+
+  cache_t* create_cache(const int id);
+  cache_t* cache() {
+    const int id = util::qsbr::reader_id();
+    if (id < 0) return nullptr;
+    cache_t* c = caches_[id].load(std::memory_order_relaxed);
+    return (c) ? c : create_cache(id);
+  }
+  // Move a burst from the node of the cache, false if the node is empty
+  bool refill(cache_t& c);
+  void flush(cache_t& c);
+  packet_buf_t* alloc_from_node(node_pool_t& n);
+  void release_to_node(packet_buf_t* buf);
+
+  static inline void add(std::atomic<uint64_t>& c, const uint64_t n) {
+    c.store(
+        c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  void init_buf(packet_buf_t* buf) const {
+    buf->data_off = headroom_;
+    buf->len      = 0;
+    buf->refcnt   = 1;
+  }
+
+ public:
+  static packet_pool& get_instance() {
+    static packet_pool instance;
+    return instance;
+  }
+  packet_pool(packet_pool const&) = delete;
+  void operator=(packet_pool const&) = delete;
+
+  // Before any allocation, once. Return false if the memory of a node could
+  // not be mapped, the pool is then not usable.
+  bool init(
+      const uint64_t buffers_per_node, const uint16_t headroom,
+      const uint16_t tailroom, const bool hugepages);
+  bool initialized() const { return num_nodes_ > 0; }
+  int num_nodes() const { return num_nodes_; }
+  uint16_t headroom() const { return headroom_; }
+  uint16_t tailroom() const { return tailroom_; }
+  static std::size_t data_room() { return PACKET_POOL_DATA_ROOM; }
+
+  // A buffer with one reference, the packet goes at data(), nullptr if the
+  // pool is exhausted or not initialized
+  packet_buf_t* alloc() {
+    if (not initialized()) return nullptr;
+    cache_t* c = cache();
+    if (not c) return alloc_from_node(local_node());
+    uint32_t count = c->count.load(std::memory_order_relaxed);
+    add(c->allocs, 1);
+    if (count) {
+      add(c->cache_hits, 1);
+    } else if (refill(*c)) {
+      count = c->count.load(std::memory_order_relaxed);
+    } else {
+      nodes_[c->node]->exhausted.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    packet_buf_t* buf = c->bufs[--count];
+    c->count.store(count, std::memory_order_relaxed);
+    init_buf(buf);
+    return buf;
+  }
+
+  // One more reference, e.g. a TX batch that sends the buffer later
+  static void hold(packet_buf_t* buf) { buf->refcnt++; }
+
+  // The buffer goes back to the pool with its last reference
+  void release(packet_buf_t* buf) {
+    if (--buf->refcnt) return;
+    cache_t* c = cache();
+    if ((not c) || (c->node != buf->node)) {
+      release_to_node(buf);
+      return;
+    }
+    uint32_t count = c->count.load(std::memory_order_relaxed);
+    if (count == PACKET_POOL_CACHE_SIZE) {
+      flush(*c);
+      count = c->count.load(std::memory_order_relaxed);
+    }
+    c->bufs[count] = buf;
+    c->count.store(count + 1, std::memory_order_relaxed);
+  }
+
+  // Any thread, one entry per node
+  void get_counters(std::vector<packet_pool_counters_t>& counters) const;
+};
+
+}  // namespace util
+
+#endif /* FILE_PACKET_POOL_HPP_SEEN */
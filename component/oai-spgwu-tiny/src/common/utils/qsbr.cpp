@@ -0,0 +1,120 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file qsbr.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "qsbr.hpp"
+
+#include <thread>
+
+thread_local int util::qsbr::reader_id_ = -1;
+
+//------------------------------------------------------------------------------
+util::qsbr::qsbr()
+    : global_epoch_(1), num_reader_ids_(0), m_retired_(), retired_() {
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    readers_[i].epoch.store(QSBR_OFFLINE);
+    readers_[i].used.store(false);
+  }
+}
+//------------------------------------------------------------------------------
+bool util::qsbr::register_thread() {
+  if (reader_id_ >= 0) return true;
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    bool expected = false;
+    if (readers_[i].used.compare_exchange_strong(expected, true)) {
+      reader_id_ = i;
+      int n      = num_reader_ids_.load(std::memory_order_relaxed);
+      while ((n <= i) && (not num_reader_ids_.compare_exchange_weak(
+                              n, i + 1, std::memory_order_release))) {
+      }
+      thread_online();
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+void util::qsbr::unregister_thread() {
+  if (reader_id_ >= 0) {
+    readers_[reader_id_].epoch.store(QSBR_OFFLINE, std::memory_order_release);
+    readers_[reader_id_].used.store(false, std::memory_order_release);
+    reader_id_ = -1;
+  }
+}
+//------------------------------------------------------------------------------
+uint64_t util::qsbr::min_reader_epoch() const {
+  uint64_t min_epoch = UINT64_MAX;
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    uint64_t epoch = readers_[i].epoch.load(std::memory_order_seq_cst);
+    if ((epoch != QSBR_OFFLINE) && (epoch < min_epoch)) {
+      min_epoch = epoch;
+    }
+  }
+  return min_epoch;
+}
+//------------------------------------------------------------------------------
+void util::qsbr::retire(std::function<void()> deleter) {
+  // Readers that announce this epoch or a later one did it after the object
+  // was unlinked
+  uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+  std::unique_lock<std::mutex> l(m_retired_);
+  retired_.push_back(std::make_pair(epoch, std::move(deleter)));
+}
+//------------------------------------------------------------------------------
+std::size_t util::qsbr::reclaim() {
+  std::deque<std::function<void()>> ready = {};
+  {
+    std::unique_lock<std::mutex> l(m_retired_);
+    if (retired_.empty()) return 0;
+    uint64_t min_epoch = min_reader_epoch();
+    // Retired in increasing epoch order
+    while ((not retired_.empty()) && (retired_.front().first <= min_epoch)) {
+      ready.push_back(std::move(retired_.front().second));
+      retired_.pop_front();
+    }
+  }
+  for (auto& deleter : ready) {
+    deleter();
+  }
+  return ready.size();
+}
+//------------------------------------------------------------------------------
+void util::qsbr::synchronize() {
+  uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+  for (int i = 0; i < num_reader_ids(); i++) {
+    if (i == reader_id_) continue;
+    uint64_t e = readers_[i].epoch.load(std::memory_order_seq_cst);
+    while ((e != QSBR_OFFLINE) && (e < epoch)) {
+      std::this_thread::yield();
+      e = readers_[i].epoch.load(std::memory_order_seq_cst);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+std::size_t util::qsbr::pending() {
+  std::unique_lock<std::mutex> l(m_retired_);
+  return retired_.size();
+}
@@ -0,0 +1,144 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file qsbr.hpp
+  \brief Quiescent state based reclamation of the data shared with the
+         packet workers
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_QSBR_HPP_SEEN
+#define FILE_QSBR_HPP_SEEN
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace util {
+
+#define QSBR_MAX_READERS 128
+#define QSBR_CACHE_LINE_SIZE 64
+
+// Readers (packet workers) never lock nor write shared state, they only
+// announce from time to time that they do not hold any reference on shared
+// objects (quiescent state) or that they will not read them for a while
+// (offline, e.g. blocked in a system call).
+// The writer unlinks an object with one atomic store, then retires it, the
+// object is freed once every online reader has announced a quiescent state.
+//
+// Reader:                           Writer:
+//   qsbr.register_thread();           publish new version (atomic store)
+//   loop {                            qsbr.retire(old_version);
+//     qsbr.thread_offline();          ...
+//     wait for packets;               qsbr.reclaim();
+//     qsbr.thread_online();
+//     switch packets;
+//     qsbr.quiescent_state();
+//   }
+class qsbr {
+ private:
+  // Epoch 0 means offline or slot not used
+#define QSBR_OFFLINE 0
+
+  struct alignas(QSBR_CACHE_LINE_SIZE) reader_slot_t {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> used;
+  };
+
+  alignas(QSBR_CACHE_LINE_SIZE) std::atomic<uint64_t> global_epoch_;
+  reader_slot_t readers_[QSBR_MAX_READERS];
+  // Highest reader id ever registered + 1
+  std::atomic<int> num_reader_ids_;
+
+  // Writer side
+  std::mutex m_retired_;
+  std::deque<std::pair<uint64_t, std::function<void()>>> retired_;
+
+  static thread_local int reader_id_;
+
+  qsbr();
+  uint64_t min_reader_epoch() const;
+
+ public:
+  static qsbr& get_instance() {
+    static qsbr instance;
+    return instance;
+  }
+
+  qsbr(qsbr const&) = delete;
+  void operator=(qsbr const&) = delete;
+
+  // Reader side, calling threads are readers and are online when registered
+  bool register_thread();
+  void unregister_thread();
+  // Id of the calling reader, -1 if not registered, lets readers own per
+  // thread data (e.g. counters) indexed in [0, num_reader_ids())
+  static int reader_id() { return reader_id_; }
+  int num_reader_ids() const {
+    return num_reader_ids_.load(std::memory_order_acquire);
+  }
+
+  void quiescent_state() {
+    if (reader_id_ >= 0) {
+      readers_[reader_id_].epoch.store(
+          global_epoch_.load(std::memory_order_acquire),
+          std::memory_order_release);
+    }
+  }
+  void thread_offline() {
+    if (reader_id_ >= 0) {
+      readers_[reader_id_].epoch.store(
+          QSBR_OFFLINE, std::memory_order_release);
+    }
+  }
+  void thread_online() {
+    if (reader_id_ >= 0) {
+      // The writer must see us online before we read any shared pointer
+      readers_[reader_id_].epoch.store(
+          global_epoch_.load(std::memory_order_acquire),
+          std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  // Writer side, the object must already be unreachable for readers that
+  // will come later
+  void retire(std::function<void()> deleter);
+  template <class T>
+  void retire(T* object) {
+    retire([object]() { delete object; });
+  }
+  // Free the objects no reader can still reference, returns their number
+  std::size_t reclaim();
+  // Wait until every other online reader has gone through a quiescent state:
+  // none still references what was unlinked before the call
+  void synchronize();
+  // Objects retired and not yet freed
+  std::size_t pending();
+};
+
+}  // namespace util
+
+#endif /* FILE_QSBR_HPP_SEEN */
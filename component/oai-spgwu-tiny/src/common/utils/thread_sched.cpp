@@ -32,6 +32,7 @@ void util::thread_sched_params::apply(
     const int task_id, _Logger& logger) const {
   if (cpu_id >= 0) {
     cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
     CPU_SET(cpu_id, &cpuset);
     if (int rc = pthread_setaffinity_np(
             pthread_self(), sizeof(cpu_set_t), &cpuset)) {
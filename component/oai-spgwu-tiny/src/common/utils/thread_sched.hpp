@@ -39,11 +39,18 @@ class thread_sched_params {
       : cpu_id(0),
         sched_policy(SCHED_FIFO),
         sched_priority(84),
-        thread_pool_size(1) {}
+        thread_pool_size(1),
+        io_batch_size(1),
+        io_flush_deadline_us(0) {}
   int cpu_id;
   int sched_policy;
   int sched_priority;
   unsigned int thread_pool_size;
+  // Max number of datagrams per recvmmsg/sendmmsg call, 1 disables batching
+  unsigned int io_batch_size;
+  // Max time an outgoing datagram may wait in a TX batch before being flushed,
+  // 0: flushed when full or at the end of the receive burst
+  unsigned int io_flush_deadline_us;
   void apply(const int task_id, _Logger& logger) const;
 };
 
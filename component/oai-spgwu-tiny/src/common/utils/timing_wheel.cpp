@@ -0,0 +1,166 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file timing_wheel.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "timing_wheel.hpp"
+
+using namespace util;
+
+//------------------------------------------------------------------------------
+timing_wheel::timing_wheel(const uint64_t now)
+    : now_(now),
+      size_(0),
+      nodes_(),
+      free_(TIMING_WHEEL_NIL),
+      slots_(TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS, TIMING_WHEEL_NIL) {}
+//------------------------------------------------------------------------------
+void timing_wheel::link(const uint32_t n) {
+  node_t& node         = nodes_[n];
+  const uint64_t delta = node.expiry - now_;
+  int level            = 0;
+  uint64_t expiry      = node.expiry;
+  while ((level < TIMING_WHEEL_LEVELS - 1) &&
+         (delta >> (TIMING_WHEEL_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  if (delta >> (TIMING_WHEEL_SLOT_BITS * TIMING_WHEEL_LEVELS)) {
+    // Beyond the wheel, parked in the farthest slot, linked again from there
+    expiry = now_ + (1ULL << (TIMING_WHEEL_SLOT_BITS * TIMING_WHEEL_LEVELS)) -
+             1;
+  }
+  const uint32_t slot =
+      level * TIMING_WHEEL_SLOTS +
+      ((expiry >> (TIMING_WHEEL_SLOT_BITS * level)) & (TIMING_WHEEL_SLOTS - 1));
+  node.slot = slot;
+  node.prev = TIMING_WHEEL_NIL;
+  node.next = slots_[slot];
+  if (node.next != TIMING_WHEEL_NIL) {
+    nodes_[node.next].prev = n;
+  }
+  slots_[slot] = n;
+}
+//------------------------------------------------------------------------------
+void timing_wheel::unlink(const uint32_t n) {
+  node_t& node = nodes_[n];
+  if (node.prev != TIMING_WHEEL_NIL) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    slots_[node.slot] = node.next;
+  }
+  if (node.next != TIMING_WHEEL_NIL) {
+    nodes_[node.next].prev = node.prev;
+  }
+}
+//------------------------------------------------------------------------------
+void timing_wheel::release(const uint32_t n) {
+  node_t& node = nodes_[n];
+  node.generation++;
+  if (not node.generation) node.generation = 1;
+  node.slot = TIMING_WHEEL_NIL;
+  node.next = free_;
+  free_     = n;
+  size_--;
+}
+//------------------------------------------------------------------------------
+uint64_t timing_wheel::start(const uint64_t expiry, const uint64_t cookie) {
+  uint32_t n = free_;
+  if (n != TIMING_WHEEL_NIL) {
+    free_ = nodes_[n].next;
+  } else {
+    n               = nodes_.size();
+    node_t node     = {};
+    node.generation = 1;
+    nodes_.push_back(node);
+  }
+  node_t& node = nodes_[n];
+  node.expiry  = (expiry > now_) ? expiry : now_ + 1;
+  node.cookie  = cookie;
+  link(n);
+  size_++;
+  return (((uint64_t) node.generation) << 32) | n;
+}
+//------------------------------------------------------------------------------
+bool timing_wheel::stop(const uint64_t timer) {
+  const uint32_t n          = (uint32_t) timer;
+  const uint32_t generation = (uint32_t)(timer >> 32);
+  if ((n >= nodes_.size()) || (nodes_[n].generation != generation) ||
+      (nodes_[n].slot == TIMING_WHEEL_NIL)) {
+    return false;
+  }
+  unlink(n);
+  release(n);
+  return true;
+}
+//------------------------------------------------------------------------------
+void timing_wheel::cascade(const int level) {
+  const uint32_t slot =
+      level * TIMING_WHEEL_SLOTS +
+      ((now_ >> (TIMING_WHEEL_SLOT_BITS * level)) & (TIMING_WHEEL_SLOTS - 1));
+  uint32_t n   = slots_[slot];
+  slots_[slot] = TIMING_WHEEL_NIL;
+  while (n != TIMING_WHEEL_NIL) {
+    const uint32_t next = nodes_[n].next;
+    link(n);
+    n = next;
+  }
+}
+//------------------------------------------------------------------------------
+void timing_wheel::advance(const uint64_t now, std::vector<uint64_t>& expired) {
+  while (now_ < now) {
+    if (not size_) {
+      now_ = now;
+      return;
+    }
+    now_++;
+    for (int level = 1; level < TIMING_WHEEL_LEVELS; level++) {
+      if ((now_ >> (TIMING_WHEEL_SLOT_BITS * (level - 1))) &
+          (TIMING_WHEEL_SLOTS - 1)) {
+        break;
+      }
+      cascade(level);
+    }
+    const uint32_t slot = now_ & (TIMING_WHEEL_SLOTS - 1);
+    uint32_t n          = slots_[slot];
+    slots_[slot]        = TIMING_WHEEL_NIL;
+    while (n != TIMING_WHEEL_NIL) {
+      const uint32_t next = nodes_[n].next;
+      expired.push_back(nodes_[n].cookie);
+      release(n);
+      n = next;
+    }
+  }
+}
+//------------------------------------------------------------------------------
+uint64_t timing_wheel::next_expiry() const {
+  if (not size_) return UINT64_MAX;
+  // The level 0 slots up to the next cascade only hold timers expiring on
+  // this turn of the wheel
+  const uint64_t cascade = (now_ | (TIMING_WHEEL_SLOTS - 1)) + 1;
+  for (uint64_t t = now_ + 1; t < cascade; t++) {
+    if (slots_[t & (TIMING_WHEEL_SLOTS - 1)] != TIMING_WHEEL_NIL) return t;
+  }
+  return cascade;
+}
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file timing_wheel.hpp
+  \brief Hierarchical timing wheel, O(1) start and stop of a timer
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_TIMING_WHEEL_HPP_SEEN
+#define FILE_TIMING_WHEEL_HPP_SEEN
+
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+// Time is counted in ticks, the caller chooses the tick duration and moves
+// the wheel forward with advance(). 4 levels of 256 slots cover 2^32 ticks,
+// a timer is moved down one level each time its slot of an upper level comes
+// due. Timers are nodes of a pool indexed by their handle, a stale handle
+// (timer expired or stopped) is detected by a generation number.
+// Not thread safe, the owner serializes the calls.
+class timing_wheel {
+ public:
+  // Never returned by start()
+  static const uint64_t null_timer = 0;
+
+ private:
+#define TIMING_WHEEL_LEVELS 4
+#define TIMING_WHEEL_SLOT_BITS 8
+#define TIMING_WHEEL_SLOTS (1 << TIMING_WHEEL_SLOT_BITS)
+#define TIMING_WHEEL_NIL UINT32_MAX
+
+  typedef struct node_s {
+    uint64_t expiry;
+    uint64_t cookie;
+    uint32_t prev;
+    uint32_t next;
+    // Incremented when the node is released, 0 never used
+    uint32_t generation;
+    // Slot the node is linked in, TIMING_WHEEL_NIL if free
+    uint32_t slot;
+  } node_t;
+
+  uint64_t now_;
+  std::size_t size_;
+  std::vector<node_t> nodes_;
+  uint32_t free_;
+  std::vector<uint32_t> slots_;
+
+  void link(const uint32_t n);
+  void unlink(const uint32_t n);
+  void release(const uint32_t n);
+  // Move the timers of a slot of an upper level down
+  void cascade(const int level);
+
+ public:
+  explicit timing_wheel(const uint64_t now = 0);
+  timing_wheel(const timing_wheel&) = delete;
+  void operator=(const timing_wheel&) = delete;
+
+  uint64_t now() const { return now_; }
+  std::size_t size() const { return size_; }
+
+  // The timer expires during the first advance() reaching expiry, at the next
+  // one if expiry is not in the future. The cookie is given back on expiry.
+  uint64_t start(const uint64_t expiry, const uint64_t cookie);
+  // Return false if the timer already expired or was stopped
+  bool stop(const uint64_t timer);
+
+  // Append the cookies of the timers expired up to now, tick after tick
+  void advance(const uint64_t now, std::vector<uint64_t>& expired);
+  // Tick of the next expiry, or of the next cascade if it comes first (the
+  // timers of the upper levels are only known to expire later),
+  // UINT64_MAX if no timer is running. At most 256 slots are looked at.
+  uint64_t next_expiry() const;
+};
+
+}  // namespace util
+#endif /* FILE_TIMING_WHEEL_HPP_SEEN */
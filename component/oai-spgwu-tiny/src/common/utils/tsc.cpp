@@ -0,0 +1,53 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file tsc.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "tsc.hpp"
+
+#include <thread>
+
+#define TSC_CALIBRATION_MILLISECONDS 10
+
+//------------------------------------------------------------------------------
+uint64_t util::tsc::calibrate() {
+#if defined(__aarch64__)
+  uint64_t freq;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+  if (freq) return freq;
+#elif !defined(__x86_64__) && !defined(__i386__)
+  return 1000000000;
+#endif
+  const auto t0     = std::chrono::steady_clock::now();
+  const uint64_t c0 = now();
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(TSC_CALIBRATION_MILLISECONDS));
+  const auto t1     = std::chrono::steady_clock::now();
+  const uint64_t c1 = now();
+  const uint64_t ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+  if (not ns) return 1000000000;
+  return (uint64_t)((c1 - c0) * 1000000000.0 / ns);
+}
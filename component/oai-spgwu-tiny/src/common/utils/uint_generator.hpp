@@ -28,96 +28,208 @@
 #ifndef FILE_UINT_GENERATOR_HPP_SEEN
 #define FILE_UINT_GENERATOR_HPP_SEEN
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <set>
+#include <unordered_set>
 
 namespace util {
 
+// Ids of a small space owned by a context (PDR, FAR ids of a session)
 template<class UINT>
 class uint_generator {
  private:
   UINT uid_generator;
+  std::unordered_set<UINT> uid_generated;
   std::mutex m_uid_generator;
 
-  std::set<UINT> uid_generated;
-  std::mutex m_uid_generated;
-
  public:
-  uint_generator() : m_uid_generator(), m_uid_generated() {
-    uid_generator = 0;
-    uid_generated = {};
-  };
+  uint_generator() : uid_generator(0), uid_generated(), m_uid_generator(){};
 
   uint_generator(uint_generator const&) = delete;
   void operator=(uint_generator const&) = delete;
 
   UINT get_uid() {
-    std::unique_lock<std::mutex> lr(m_uid_generator);
+    std::unique_lock<std::mutex> l(m_uid_generator);
     UINT uid = ++uid_generator;
-    while (true) {
-      // may happen race conditions here
-      std::unique_lock<std::mutex> ld(m_uid_generated);
-      if (uid_generated.count(uid) == 0) {
-        uid_generated.insert(uid);
-        ld.unlock();
-        lr.unlock();
-        return uid;
-      }
+    while (not uid_generated.insert(uid).second) {
       uid = ++uid_generator;
     }
+    return uid;
   }
 
   void free_uid(UINT uid) {
-    std::unique_lock<std::mutex> l(m_uid_generated);
+    std::unique_lock<std::mutex> l(m_uid_generator);
     uid_generated.erase(uid);
-    l.unlock();
   }
 };
 
+// Ids of a space that never wraps around (64 bit SEIDs, transaction ids):
+// a thread takes a block of ids from a shared counter and hands them out
+// without any synchronization until the block is used up. 0 is never given,
+// free_uid() has nothing to do.
 template<class UINT>
-class uint_uid_generator {
+class uint_block_generator {
  private:
-  UINT uid_generator;
-  std::mutex m_uid_generator;
+#define UINT_GENERATOR_BLOCK_SIZE 1024
+  typedef struct block_s {
+    // Generator the block comes from
+    uint64_t owner;
+    UINT next;
+    UINT end;
+  } block_t;
+
+  const uint64_t owner;
+  std::atomic<UINT> next_block;
+
+  static uint64_t new_owner() {
+    static std::atomic<uint64_t> owners(0);
+    return ++owners;
+  }
+  // Block of the generator last used by the thread, a thread switching
+  // between generators drops the rest of its block
+  static block_t& thread_block() {
+    static thread_local block_t block = {0, 0, 0};
+    return block;
+  }
 
-  std::set<UINT> uid_generated;
-  std::mutex m_uid_generated;
+ public:
+  uint_block_generator() : owner(new_owner()), next_block(1){};
+
+  uint_block_generator(uint_block_generator const&) = delete;
+  void operator=(uint_block_generator const&) = delete;
 
-  uint_uid_generator() : m_uid_generator(), m_uid_generated() {
-    uid_generator = 0;
-    uid_generated = {};
-  };
+  UINT get_uid() {
+    block_t& b = thread_block();
+    if ((b.owner != owner) || (b.next == b.end)) {
+      b.owner = owner;
+      b.next  = next_block.fetch_add(
+          UINT_GENERATOR_BLOCK_SIZE, std::memory_order_relaxed);
+      b.end = b.next + UINT_GENERATOR_BLOCK_SIZE;
+    }
+    return b.next++;
+  }
+
+  // The ids up to uid are not given any more (ids restored from a previous
+  // run), the blocks already taken by the threads are not affected
+  void reserve_uid(UINT uid) {
+    UINT next = next_block.load(std::memory_order_relaxed);
+    while ((next <= uid) && (not next_block.compare_exchange_weak(
+                                 next, uid + 1, std::memory_order_relaxed))) {
+    }
+  }
+
+  void free_uid(UINT uid) {}
+};
+
+// Ids of a bounded space (TEIDs): 2^id_bits ids, prefixed by a node id in the
+// upper bits so that several instances give disjoint ranges. The space is
+// split in shards, a thread takes the ids of its own shard in turn with an
+// atomic cursor and claims them in a bitmap, it moves on to the next shard
+// if its shard is full. A freed id is given again only once the cursor went
+// round its shard. 0 is never given, get_uid() returns 0 if no id is free.
+template<class UINT>
+class uint_bitmap_generator {
+ private:
+#define UINT_GENERATOR_SHARDS 16
+  typedef struct alignas(64) shard_s {
+    std::atomic<uint64_t> cursor;
+  } shard_t;
+
+  const unsigned int id_bits;
+  const UINT node_id;
+  const uint64_t shard_size;
+  std::unique_ptr<std::atomic<uint64_t>[]> bits;
+  shard_t shards[UINT_GENERATOR_SHARDS];
+
+  static unsigned int thread_shard() {
+    static std::atomic<unsigned int> threads(0);
+    static thread_local unsigned int shard =
+        threads.fetch_add(1) % UINT_GENERATOR_SHARDS;
+    return shard;
+  }
 
  public:
-  static uint_uid_generator& get_instance() {
-    static uint_uid_generator instance;
-    return instance;
+  // id_bits >= 10, node_id must fit in the bits of UINT above id_bits
+  uint_bitmap_generator(const unsigned int num_id_bits, const UINT node)
+      : id_bits(num_id_bits),
+        node_id(node),
+        shard_size(((uint64_t) 1 << num_id_bits) / UINT_GENERATOR_SHARDS),
+        bits(new std::atomic<uint64_t>[((uint64_t) 1 << num_id_bits) >> 6]()) {
+    for (auto& s : shards) {
+      s.cursor = 0;
+    }
   }
 
-  uint_uid_generator(uint_uid_generator const&) = delete;
-  void operator=(uint_uid_generator const&) = delete;
+  uint_bitmap_generator(uint_bitmap_generator const&) = delete;
+  void operator=(uint_bitmap_generator const&) = delete;
 
   UINT get_uid() {
-    std::unique_lock<std::mutex> lr(m_uid_generator);
-    UINT uid = ++uid_generator;
-    while (true) {
-      // may happen race conditions here
-      std::unique_lock<std::mutex> ld(m_uid_generated);
-      if (uid_generated.count(uid) == 0) {
-        uid_generated.insert(uid);
-        lr.unlock();
-        ld.unlock();
-        return uid;
+    const unsigned int first = thread_shard();
+    for (unsigned int i = 0; i < UINT_GENERATOR_SHARDS; i++) {
+      const unsigned int s = (first + i) % UINT_GENERATOR_SHARDS;
+      for (uint64_t n = 0; n < shard_size; n++) {
+        const uint64_t id =
+            s * shard_size + (shards[s].cursor.fetch_add(
+                                  1, std::memory_order_relaxed) %
+                              shard_size);
+        std::atomic<uint64_t>& word = bits[id >> 6];
+        if (word.load(std::memory_order_relaxed) == ~(uint64_t) 0) {
+          // Skip the rest of a word in use
+          const uint64_t skip = 63 - (id & 63);
+          shards[s].cursor.fetch_add(skip, std::memory_order_relaxed);
+          n += skip;
+          continue;
+        }
+        const uint64_t mask = (uint64_t) 1 << (id & 63);
+        if ((id) && (not(word.fetch_or(mask, std::memory_order_acquire) &
+                         mask))) {
+          return (UINT)(((uint64_t) node_id << id_bits) | id);
+        }
       }
-      uid = ++uid_generator;
     }
+    return 0;
+  }
+
+  // Claim a given id (ids restored from a previous run), false if the id is
+  // not of this node or is already given
+  bool reserve_uid(UINT uid) {
+    if (((uint64_t) uid >> id_bits) != node_id) return false;
+    const uint64_t id = (uint64_t) uid & (((uint64_t) 1 << id_bits) - 1);
+    if (not id) return false;
+    const uint64_t mask = (uint64_t) 1 << (id & 63);
+    return not(bits[id >> 6].fetch_or(mask, std::memory_order_acquire) & mask);
   }
 
   void free_uid(UINT uid) {
-    std::unique_lock<std::mutex> l(m_uid_generated);
-    uid_generated.erase(uid);
-    l.unlock();
+    if (((uint64_t) uid >> id_bits) != node_id) return;
+    const uint64_t id = (uint64_t) uid & (((uint64_t) 1 << id_bits) - 1);
+    bits[id >> 6].fetch_and(
+        ~((uint64_t) 1 << (id & 63)), std::memory_order_release);
+  }
+};
+
+// Transaction ids of the PFCP and GTPv2-C stacks
+template<class UINT>
+class uint_uid_generator {
+ private:
+  uint_block_generator<UINT> generator;
+
+  uint_uid_generator() : generator(){};
+
+ public:
+  static uint_uid_generator& get_instance() {
+    static uint_uid_generator instance;
+    return instance;
   }
+
+  uint_uid_generator(uint_uid_generator const&) = delete;
+  void operator=(uint_uid_generator const&) = delete;
+
+  UINT get_uid() { return generator.get_uid(); }
+
+  void free_uid(UINT uid) { generator.free_uid(uid); }
 };
 
 }  // namespace util
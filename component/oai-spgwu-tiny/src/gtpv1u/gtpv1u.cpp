@@ -75,7 +75,7 @@ gtpu_l4_stack::gtpu_l4_stack(
   srand(time(NULL));
   seq_num         = rand() & 0x7FFFFFFF;
   restart_counter = 0;
-  udp_s.start_receive(this, sched_params);
+  udp_s.start_receive(this, sched_params, teid_offset_in_header, true);
 }
 //------------------------------------------------------------------------------
 gtpu_l4_stack::gtpu_l4_stack(
@@ -90,7 +90,7 @@ gtpu_l4_stack::gtpu_l4_stack(
   srand(time(NULL));
   seq_num         = rand() & 0x7FFFFFFF;
   restart_counter = 0;
-  udp_s.start_receive(this, sched_params);
+  udp_s.start_receive(this, sched_params, teid_offset_in_header, true);
 }
 //------------------------------------------------------------------------------
 gtpu_l4_stack::gtpu_l4_stack(
@@ -104,9 +104,41 @@ gtpu_l4_stack::gtpu_l4_stack(
   srand(time(NULL));
   seq_num         = rand() & 0x7FFFFFFF;
   restart_counter = 0;
-  udp_s.start_receive(this, sched_params);
+  udp_s.start_receive(this, sched_params, teid_offset_in_header, true);
+}
+//------------------------------------------------------------------------------
+gtpu_l4_stack::gtpu_l4_stack(
+    const struct in_addr& address, const uint16_t port_num,
+    const util::thread_sched_params& sched_params,
+    const packet_io_backend_t io_backend, const std::string& if_name)
+    : udp_s(udp_server(address, port_num)) {
+  Logger::gtpv1_u().info(
+      "gtpu_l4_stack created listening to %s:%d (%s on %s)",
+      conv::toString(address).c_str(), port_num,
+      packet_io_backend_to_string(io_backend), if_name.c_str());
+
+  id = 0;
+  srand(time(NULL));
+  seq_num         = rand() & 0x7FFFFFFF;
+  restart_counter = 0;
+  if (io_backend == PACKET_IO_BACKEND_TPACKET_V3) {
+    udp_s.start_receive_packet_ring(this, if_name, sched_params);
+  } else {
+    udp_s.start_receive(this, sched_params, teid_offset_in_header, true);
+  }
 }
 
+//------------------------------------------------------------------------------
+void gtpu_l4_stack::start_ipv6(
+    const struct in6_addr& address, const uint16_t port_num,
+    const util::thread_sched_params& sched_params) {
+  udp_s6 = std::unique_ptr<udp_server>(new udp_server(address, port_num));
+  Logger::gtpv1_u().info(
+      "gtpu_l4_stack also listening to %s:%d",
+      conv::toString(address).c_str(), port_num);
+  udp_s6->start_receive(
+      this, sched_params, teid_offset_in_header, true);
+}
 //------------------------------------------------------------------------------
 uint32_t gtpu_l4_stack::get_next_seq_num() {
   seq_num++;
@@ -160,7 +192,7 @@ void gtpu_l4_stack::handle_receive_message_cb(
 //------------------------------------------------------------------------------
 void gtpu_l4_stack::send_g_pdu(
     const struct sockaddr_in& peer_addr, const teid_t teid, const char* payload,
-    const ssize_t payload_len) {
+    const ssize_t payload_len, util::packet_buf_t* const pbuf) {
   struct gtpuhdr* gtpuhdr = reinterpret_cast<struct gtpuhdr*>(
       reinterpret_cast<uintptr_t>(payload) -
       (uintptr_t) sizeof(struct gtpuhdr));
@@ -173,14 +205,15 @@ void gtpu_l4_stack::send_g_pdu(
   gtpuhdr->message_type   = GTPU_G_PDU;
   gtpuhdr->message_length = htobe16(payload_len);
   gtpuhdr->teid           = htobe32(teid);
-  udp_s.async_send_to(
+  udp_s.batch_send_to(
       reinterpret_cast<const char*>(gtpuhdr),
-      payload_len + sizeof(struct gtpuhdr), peer_addr);
+      payload_len + sizeof(struct gtpuhdr), peer_addr, pbuf);
 }
 //------------------------------------------------------------------------------
 void gtpu_l4_stack::send_g_pdu(
     const struct sockaddr_in6& peer_addr, const teid_t teid,
-    const char* payload, const ssize_t payload_len) {
+    const char* payload, const ssize_t payload_len,
+    util::packet_buf_t* const pbuf) {
   struct gtpuhdr* gtpuhdr = reinterpret_cast<struct gtpuhdr*>(
       reinterpret_cast<uintptr_t>(payload) -
       (uintptr_t) sizeof(struct gtpuhdr));
@@ -193,9 +226,11 @@ void gtpu_l4_stack::send_g_pdu(
   gtpuhdr->message_type   = GTPU_G_PDU;
   gtpuhdr->message_length = htobe16(payload_len);
   gtpuhdr->teid           = htobe32(teid);
-  udp_s.async_send_to(
+
+  udp_server& udp = (udp_s6) ? *udp_s6 : udp_s;
+  udp.batch_send_to(
       reinterpret_cast<const char*>(gtpuhdr),
-      payload_len + sizeof(struct gtpuhdr), peer_addr);
+      payload_len + sizeof(struct gtpuhdr), peer_addr, pbuf);
 }
 //------------------------------------------------------------------------------
 void gtpu_l4_stack::send_response(const gtpv1u_echo_response& gtp_ies) {
@@ -212,7 +247,8 @@ void gtpu_l4_stack::send_response(const gtpv1u_echo_response& gtp_ies) {
   msg.dump_to(oss);
   std::string bstream = oss.str();
 
-  udp_s.async_send_to(
+  udp_server& udp = get_udp_server(gtp_ies.r_endpoint);
+  udp.async_send_to(
       reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
       gtp_ies.r_endpoint);
 }
@@ -231,7 +267,8 @@ void gtpu_l4_stack::send_indication(const gtpv1u_error_indication& gtp_ies) {
   msg.dump_to(oss);
   std::string bstream = oss.str();
 
-  udp_s.async_send_to(
+  udp_server& udp = get_udp_server(gtp_ies.r_endpoint);
+  udp.async_send_to(
       reinterpret_cast<const char*>(bstream.c_str()), bstream.length(),
       gtp_ies.r_endpoint);
 }
@@ -47,6 +47,8 @@
 namespace gtpv1u {
 
 static const uint16_t default_port = 2152;
+// Receive shards are selected on the TEID, 4 bytes in the GTP-U header
+static const int teid_offset_in_header = 4;
 
 class gtpu_l4_stack : public udp_application {
 #define GTPV1U_T3_RESPONSE_MS 1000
@@ -57,6 +59,8 @@ class gtpu_l4_stack : public udp_application {
  protected:
   uint32_t id;
   udp_server udp_s;
+  // Optional second endpoint when udp_s is IPv4, for IPv6 GTP-U peers
+  std::unique_ptr<udp_server> udp_s6;
 
   // seems no need for std::atomic_uint32_t
   uint32_t seq_num;
@@ -68,6 +72,11 @@ class gtpu_l4_stack : public udp_application {
 
   uint32_t get_next_seq_num();
 
+  udp_server& get_udp_server(const endpoint& r_endpoint) {
+    if ((udp_s6) && (r_endpoint.family() == AF_INET6)) return *udp_s6;
+    return udp_s;
+  };
+
  public:
   static const uint8_t version = 1;
   gtpu_l4_stack(
@@ -79,6 +88,15 @@ class gtpu_l4_stack : public udp_application {
   gtpu_l4_stack(
       char* ip_address, const uint16_t port_num,
       const util::thread_sched_params& sched_params);
+  // Receive through the selected packet I/O backend bound to if_name
+  gtpu_l4_stack(
+      const struct in_addr& address, const uint16_t port_num,
+      const util::thread_sched_params& sched_params,
+      const packet_io_backend_t io_backend, const std::string& if_name);
+  // Also listen to and send from an IPv6 address
+  void start_ipv6(
+      const struct in6_addr& address, const uint16_t port_num,
+      const util::thread_sched_params& sched_params);
   virtual void handle_receive(
       char* recv_buffer, const std::size_t bytes_transferred,
       const endpoint& r_endpoint);
@@ -87,16 +105,45 @@ class gtpu_l4_stack : public udp_application {
       const socklen_t& r_endpoint_addr_len, const task_id_t& task_id,
       bool& error, uint64_t& gtpc_tx_id);
 
+  // The GTP-U header is written in front of payload. If payload is in pbuf,
+  // the G-PDU is batched without copy, see udp_server::batch_send_to().
   void send_g_pdu(
       const struct sockaddr_in& peer_addr, const teid_t teid,
-      const char* payload, const ssize_t payload_len);
+      const char* payload, const ssize_t payload_len,
+      util::packet_buf_t* const pbuf = nullptr);
   void send_g_pdu(
       const struct sockaddr_in6& peer_addr, const teid_t teid,
-      const char* payload, const ssize_t payload_len);
+      const char* payload, const ssize_t payload_len,
+      util::packet_buf_t* const pbuf = nullptr);
+
+  // Send the G-PDUs batched by send_g_pdu() in the calling thread
+  void flush_g_pdus() {
+    udp_s.flush_send_batch();
+    if (udp_s6) udp_s6->flush_send_batch();
+  };
+  void get_io_counters(udp_io_counters_t& counters) const {
+    udp_s.get_io_counters(counters);
+    if (udp_s6) {
+      udp_io_counters_t c6 = {};
+      udp_s6->get_io_counters(c6);
+      counters.rx_syscalls += c6.rx_syscalls;
+      counters.rx_packets += c6.rx_packets;
+      counters.tx_syscalls += c6.tx_syscalls;
+      counters.tx_packets += c6.tx_packets;
+      counters.tx_dropped += c6.tx_dropped;
+    }
+  };
+  // Of the first endpoint (udp_s)
+  void get_receive_sockets(std::vector<int>& sockets) const {
+    udp_s.get_receive_sockets(sockets);
+  };
 
   void send_response(const gtpv1u_echo_response& gtp_ies);
   void send_indication(const gtpv1u_error_indication& gtp_ies);
-  void stop() { udp_s.stop(); };
+  void stop() {
+    udp_s.stop();
+    if (udp_s6) udp_s6->stop();
+  };
 };
 }  // namespace gtpv1u
 
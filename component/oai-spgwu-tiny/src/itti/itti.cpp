@@ -29,71 +29,206 @@
 #include "common_defs.h"
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
 #include <signal.h>
 #include <time.h>
+#include <inttypes.h>
 #include <algorithm>
 #include <csignal>
 
 extern itti_mw* itti_inst;
 
-static itti_timer null_timer(
-    ITTI_INVALID_TIMER_ID, TASK_NONE, 0xFFFFFFFF, 0xFFFFFFFF, 0, 0);
+thread_local task_id_t itti_mw::current_task     = TASK_NONE;
+thread_local unsigned int itti_mw::current_shard = 0;
 
 //------------------------------------------------------------------------------
 void itti_mw::timer_manager_task(
     const util::thread_sched_params& sched_params) {
   Logger::itti().info("Starting timer_manager_task");
   sched_params.apply(TASK_ITTI_TIMER, Logger::itti());
-  while (true) {
-    if (itti_inst->terminate) return;
-    {
-      std::unique_lock<std::mutex> lx(itti_inst->m_timers);
-      while (itti_inst->timers.empty()) {
-        itti_inst->c_timers.wait(lx);
+  std::vector<uint64_t> expired = {};
+  std::vector<std::pair<unsigned int, std::shared_ptr<itti_msg>>>
+      msgs[TASK_MAX];
+  std::unique_lock<std::mutex> lx(itti_inst->m_timers);
+  while (not itti_inst->terminate) {
+    expired.clear();
+    itti_inst->timer_wheel.advance(itti_inst->timer_now(), expired);
+    if (expired.size()) {
+      for (auto id : expired) {
+        auto it = itti_inst->timers.find((timer_id_t) id);
+        if (it == itti_inst->timers.end()) continue;
+        const itti_timer& t = it->second;
+        msgs[t.task_id].push_back(std::make_pair(
+            t.shard, std::make_shared<itti_msg_timeout>(
+                         TASK_ITTI_TIMER, t.task_id, t.id, t.arg1_user,
+                         t.arg2_user)));
+        itti_inst->timers.erase(it);
       }
-      std::set<itti_timer>::iterator it = itti_inst->timers.begin();
-      itti_inst->current_timer          = std::ref(*it);
-      itti_inst->timers.erase(it);
       lx.unlock();
-
-      // check time-out
-      if (itti_inst->current_timer.time_out >
-          std::chrono::system_clock::now()) {
-        std::unique_lock<std::mutex> lto(itti_inst->m_timeout);
-        auto diff = itti_inst->current_timer.time_out -
-                    std::chrono::system_clock::now();
-        auto rc = itti_inst->c_timeout.wait_for(lto, diff);
-        lto.unlock();
-        if (std::cv_status::timeout == rc) {
-          // signal time-out
-          itti_msg_timeout mto(
-              TASK_ITTI_TIMER, itti_inst->current_timer.task_id,
-              itti_inst->current_timer.id, itti_inst->current_timer.arg1_user,
-              itti_inst->current_timer.arg2_user);
-          std::shared_ptr<itti_msg_timeout> msgsh =
-              std::make_shared<itti_msg_timeout>(mto);
-          int ret = itti_inst->send_msg(msgsh);
-        } else {
-          // other timer required ?
-          itti_inst->m_timers.lock();
-          if (itti_inst->current_timer.id != ITTI_INVALID_TIMER_ID) {
-            itti_inst->timers.insert(itti_inst->current_timer);
-          }
-          itti_inst->current_timer = null_timer;
-          itti_inst->m_timers.unlock();
-          // cout << "cv.wait released by other triggered timer end" << endl;
+      for (int t = TASK_FIRST; t < TASK_MAX; t++) {
+        if (msgs[t].size()) {
+          itti_inst->send_timeout_msgs((task_id_t) t, msgs[t]);
+          msgs[t].clear();
         }
-      } else {
-        // signal time-out
-        itti_msg_timeout mto(
-            TASK_ITTI_TIMER, itti_inst->current_timer.task_id,
-            itti_inst->current_timer.id, itti_inst->current_timer.arg1_user,
-            itti_inst->current_timer.arg2_user);
-        std::shared_ptr<itti_msg_timeout> msgsh =
-            std::make_shared<itti_msg_timeout>(mto);
-        itti_inst->send_msg(msgsh);
+      }
+      lx.lock();
+      // Timers may have been set up meanwhile
+      continue;
+    }
+    itti_inst->timer_wake_up = itti_inst->timer_wheel.next_expiry();
+    if (itti_inst->timer_wake_up == UINT64_MAX) {
+      itti_inst->c_timers.wait(lx);
+    } else {
+      itti_inst->c_timers.wait_until(
+          lx, itti_inst->timer_epoch +
+                  std::chrono::milliseconds(
+                      itti_inst->timer_wake_up * ITTI_TIMER_TICK_MS));
+    }
+  }
+}
+//------------------------------------------------------------------------------
+uint64_t itti_mw::timer_now() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - timer_epoch)
+             .count() /
+         ITTI_TIMER_TICK_MS;
+}
+//------------------------------------------------------------------------------
+void itti_mw::send_timeout_msgs(
+    const task_id_t task_id,
+    std::vector<std::pair<unsigned int, std::shared_ptr<itti_msg>>>& msgs) {
+  const std::vector<itti_task_ctxt*>& shards = task_shards[task_id];
+  const uint64_t now_ns                      = steady_ns();
+  std::size_t not_sent                       = 0;
+  for (auto& msg : msgs) {
+    if ((msg.first < shards.size()) &&
+        (shards[msg.first]->task_state == TASK_STATE_READY)) {
+      post_msg(shards[msg.first], msg.second, now_ns);
+    } else {
+      not_sent++;
+    }
+  }
+  for (auto ctxt : shards) {
+    wake_up(ctxt);
+  }
+  if (not_sent) {
+    Logger::itti().warn(
+        "%zu time-out messages can not be sent to %d, task not ready!",
+        not_sent, task_id);
+  }
+}
+//------------------------------------------------------------------------------
+itti_task_ctxt* itti_mw::destination_ctxt(const itti_msg& message) const {
+  const std::vector<itti_task_ctxt*>& shards =
+      task_shards[message.destination];
+  if (shards.size() > 1) {
+    return shards[shard_keys[message.destination](message) % shards.size()];
+  }
+  return itti_task_ctxts[message.destination];
+}
+//------------------------------------------------------------------------------
+itti_task_ctxt* itti_mw::receiving_ctxt(const task_id_t task_id) const {
+  if (current_task == task_id) {
+    return task_shards[task_id][current_shard];
+  }
+  return itti_task_ctxts[task_id];
+}
+//------------------------------------------------------------------------------
+void itti_mw::wait_task_started(itti_task_ctxt* ctxt) const {
+  while ((ctxt->task_state != TASK_STATE_READY) &&
+         (ctxt->task_state != TASK_STATE_ENDED))
+    usleep(1000);
+}
+//------------------------------------------------------------------------------
+uint64_t itti_mw::steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+//------------------------------------------------------------------------------
+void itti_mw::post_msg(
+    itti_task_ctxt* ctxt, std::shared_ptr<itti_msg> message,
+    const uint64_t now_ns) {
+  itti_mail_t mail = {std::move(message), now_ns};
+  ctxt->sent.fetch_add(1, std::memory_order_relaxed);
+  // Once a message overflowed, the next ones follow it until the task took
+  // them all, so that the messages of a sender stay in order
+  if ((ctxt->overflow_size.load(std::memory_order_acquire)) ||
+      (not ctxt->mailbox.push(std::move(mail)))) {
+    std::unique_lock<std::mutex> l(ctxt->m_overflow);
+    ctxt->overflow.push(std::move(mail));
+    ctxt->overflow_size.fetch_add(1, std::memory_order_release);
+    ctxt->overflowed.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+//------------------------------------------------------------------------------
+void itti_mw::wake_up(itti_task_ctxt* ctxt) {
+  // Pairs with the fence of fill_batch(): either the task sees the message
+  // before parking or the sender sees the task parked
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if ((ctxt->sleeping.load(std::memory_order_relaxed)) &&
+      (ctxt->sleeping.exchange(0, std::memory_order_relaxed))) {
+    syscall(
+        SYS_futex, &ctxt->sleeping, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr,
+        0);
+  }
+}
+//------------------------------------------------------------------------------
+bool itti_mw::fill_batch(itti_task_ctxt* ctxt, const bool block) {
+  itti_mail_t mail = {};
+  for (;;) {
+    const uint64_t now_ns = steady_ns();
+    const uint64_t depth  = ctxt->sent.load(std::memory_order_relaxed) -
+                           ctxt->received.load(std::memory_order_relaxed);
+    uint64_t latency_sum  = 0;
+    uint64_t latency_max  = 0;
+    unsigned int n        = 0;
+    while ((n < ITTI_RECEIVE_BATCH) && (ctxt->mailbox.pop(mail))) {
+      const uint64_t latency = now_ns - mail.sent_ns;
+      latency_sum += latency;
+      latency_max      = std::max(latency_max, latency);
+      ctxt->batch[n++] = std::move(mail.msg);
+    }
+    // The ring is empty, the overflow is older than what comes next in it
+    if ((n < ITTI_RECEIVE_BATCH) &&
+        (ctxt->overflow_size.load(std::memory_order_acquire))) {
+      std::unique_lock<std::mutex> l(ctxt->m_overflow);
+      while ((n < ITTI_RECEIVE_BATCH) && (not ctxt->overflow.empty())) {
+        itti_mail_t& m         = ctxt->overflow.front();
+        const uint64_t latency = now_ns - m.sent_ns;
+        latency_sum += latency;
+        latency_max      = std::max(latency_max, latency);
+        ctxt->batch[n++] = std::move(m.msg);
+        ctxt->overflow.pop();
+        ctxt->overflow_size.fetch_sub(1, std::memory_order_release);
       }
     }
+    if (n) {
+      ctxt->batch_next  = 0;
+      ctxt->batch_count = n;
+      ctxt->received.fetch_add(n, std::memory_order_relaxed);
+      ctxt->wake_ups.fetch_add(1, std::memory_order_relaxed);
+      ctxt->latency_sum_ns.fetch_add(latency_sum, std::memory_order_relaxed);
+      if (latency_max > ctxt->max_latency_ns.load(std::memory_order_relaxed)) {
+        ctxt->max_latency_ns.store(latency_max, std::memory_order_relaxed);
+      }
+      if (depth > ctxt->max_depth.load(std::memory_order_relaxed)) {
+        ctxt->max_depth.store(depth, std::memory_order_relaxed);
+      }
+      return true;
+    }
+    if (not block) return false;
+    ctxt->sleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if ((ctxt->mailbox.empty()) &&
+        (not ctxt->overflow_size.load(std::memory_order_relaxed))) {
+      syscall(
+          SYS_futex, &ctxt->sleeping, FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr,
+          0);
+    }
+    ctxt->sleeping.store(0, std::memory_order_relaxed);
   }
 }
 //------------------------------------------------------------------------------
@@ -102,12 +237,14 @@ itti_mw::itti_mw()
       msg_number(0),
       created_tasks(0),
       ready_tasks(0),
+      timers(),
+      timer_wheel(),
+      timer_epoch(std::chrono::steady_clock::now()),
+      timer_wake_up(UINT64_MAX),
       m_timers(),
-      current_timer(null_timer),
-      m_timeout(),
-      m_timer_id(),
       terminate(false) {
   std::fill(itti_task_ctxts, itti_task_ctxts + TASK_MAX, nullptr);
+  std::fill(shard_keys, shard_keys + TASK_MAX, nullptr);
 }
 
 //------------------------------------------------------------------------------
@@ -115,12 +252,15 @@ itti_mw::~itti_mw() {
   std::cout << "~itti()" << std::endl;
   timer_thread.detach();
   // wake up thread timer if necessary
-  std::unique_lock<std::mutex> l2(m_timeout);
-  c_timeout.notify_one();
+  {
+    std::unique_lock<std::mutex> l(m_timers);
+    terminate = true;
+    c_timers.notify_one();
+  }
 
   for (int t = TASK_FIRST; t < TASK_MAX; t++) {
-    if (itti_task_ctxts[t]) {
-      delete itti_task_ctxts[t];
+    for (auto ctxt : task_shards[t]) {
+      delete ctxt;
     }
   }
   std::cout << "~itti() Done!" << std::endl;
@@ -151,7 +291,8 @@ int itti_mw::create_task(
   }
   if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
     if (itti_task_ctxts[task_id] == nullptr) {
-      itti_task_ctxts[task_id] = new itti_task_ctxt(task_id);
+      task_shards[task_id].push_back(new itti_task_ctxt(task_id, 0));
+      itti_task_ctxts[task_id] = task_shards[task_id][0];
       {
         std::unique_lock<std::mutex> lk(itti_task_ctxts[task_id]->m_state);
         if (itti_task_ctxts[task_id]->task_state == TASK_STATE_NOT_CONFIGURED) {
@@ -161,9 +302,7 @@ int itti_mw::create_task(
         lk.unlock();
       }
       itti_task_ctxts[task_id]->thread = std::thread(start_routine, args_p);
-      while ((itti_task_ctxts[task_id]->task_state != TASK_STATE_READY) &&
-             (itti_task_ctxts[task_id]->task_state != TASK_STATE_ENDED))
-        usleep(1000);
+      wait_task_started(itti_task_ctxts[task_id]);
       return 0;
     } else {
       Logger::itti().error("Try to start an already started task %d", task_id);
@@ -174,19 +313,73 @@ int itti_mw::create_task(
   return RETURNerror;
 }
 
+//------------------------------------------------------------------------------
+int itti_mw::create_task_shards(
+    const task_id_t task_id, void (*start_routine)(void*), void* args_p,
+    const unsigned int num_shards, itti_shard_key_t shard_key) {
+  if ((nullptr == start_routine) || (nullptr == shard_key)) {
+    Logger::itti().error("Null start routine or key for task %d", task_id);
+    return RETURNerror;
+  }
+  if ((0 == num_shards) || (ITTI_MAX_TASK_SHARDS < num_shards)) {
+    Logger::itti().error(
+        "Bad number of shards %u for task %d", num_shards, task_id);
+    return RETURNerror;
+  }
+  if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
+    if (itti_task_ctxts[task_id] == nullptr) {
+      for (unsigned int s = 0; s < num_shards; s++) {
+        task_shards[task_id].push_back(new itti_task_ctxt(task_id, s));
+      }
+      // Set before the task can be found by the senders
+      shard_keys[task_id]      = shard_key;
+      itti_task_ctxts[task_id] = task_shards[task_id][0];
+      created_tasks++;
+      for (auto ctxt : task_shards[task_id]) {
+        ctxt->thread = std::thread([ctxt, start_routine, args_p]() {
+          current_task  = ctxt->task_id;
+          current_shard = ctxt->shard;
+          start_routine(args_p);
+        });
+      }
+      for (auto ctxt : task_shards[task_id]) {
+        wait_task_started(ctxt);
+      }
+      return 0;
+    } else {
+      Logger::itti().error("Try to start an already started task %d", task_id);
+    }
+  } else {
+    Logger::itti().error("Bad task id %d", task_id);
+  }
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+unsigned int itti_mw::get_num_shards(const task_id_t task_id) const {
+  if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
+    return task_shards[task_id].size();
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+unsigned int itti_mw::get_current_shard(const task_id_t task_id) const {
+  return (current_task == task_id) ? current_shard : 0;
+}
+
 //------------------------------------------------------------------------------
 int itti_mw::notify_task_ready(const task_id_t task_id) {
-  if (itti_task_ctxts[task_id]) {
-    itti_task_ctxts[task_id]->m_state.lock();
-    if (itti_task_ctxts[task_id]->task_state == TASK_STATE_STARTING) {
-      itti_task_ctxts[task_id]->task_state = TASK_STATE_READY;
-      itti_task_ctxts[task_id]->m_state.unlock();
+  itti_task_ctxt* ctxt = receiving_ctxt(task_id);
+  if (ctxt) {
+    ctxt->m_state.lock();
+    if (ctxt->task_state == TASK_STATE_STARTING) {
+      ctxt->task_state = TASK_STATE_READY;
+      ctxt->m_state.unlock();
       return RETURNok;
     }
-    itti_task_ctxts[task_id]->m_state.unlock();
-    Logger::itti().error(
-        "Notify task ready, bad state %d",
-        itti_task_ctxts[task_id]->task_state);
+    ctxt->m_state.unlock();
+    Logger::itti().error("Notify task ready, bad state %d", ctxt->task_state);
   } else {
     Logger::itti().error("Notify task ready, task not starting %d", task_id);
   }
@@ -197,18 +390,13 @@ int itti_mw::notify_task_ready(const task_id_t task_id) {
 int itti_mw::send_msg(std::shared_ptr<itti_msg> message) {
   if ((TASK_FIRST <= message->destination) &&
       (TASK_MAX > message->destination)) {
-    if (itti_task_ctxts[message->destination]) {
-      if (itti_task_ctxts[message->destination]->task_state ==
-          TASK_STATE_READY) {
-        std::unique_lock<std::mutex> l(
-            itti_task_ctxts[message->destination]->m_queue);
-        // res =
-        itti_task_ctxts[message->destination]->msg_queue.push(message);
-        itti_task_ctxts[message->destination]->c_queue.notify_one();
+    itti_task_ctxt* ctxt = destination_ctxt(*message);
+    if (ctxt) {
+      if (ctxt->task_state == TASK_STATE_READY) {
+        post_msg(ctxt, message, steady_ns());
+        wake_up(ctxt);
         return RETURNok;
-      } else if (
-          itti_task_ctxts[message->destination]->task_state ==
-          TASK_STATE_ENDED) {
+      } else if (ctxt->task_state == TASK_STATE_ENDED) {
         Logger::itti().warn(
             "Unicast message number %lu can not be sent from %d to %d, ended "
             "destination task!",
@@ -230,13 +418,13 @@ int itti_mw::send_msg(std::shared_ptr<itti_msg> message) {
 //------------------------------------------------------------------------------
 int itti_mw::send_broadcast_msg(std::shared_ptr<itti_msg> message) {
   if (TASK_ALL == message->destination) {
+    const uint64_t now_ns = steady_ns();
     for (int t = TASK_FIRST; t < TASK_MAX; t++) {
-      if (itti_task_ctxts[t]) {
-        if (itti_task_ctxts[t]->task_state == TASK_STATE_READY) {
-          std::unique_lock<std::mutex> l(itti_task_ctxts[t]->m_queue);
-          itti_task_ctxts[t]->msg_queue.push(message);
-          itti_task_ctxts[t]->c_queue.notify_one();
-        } else if (itti_task_ctxts[t]->task_state == TASK_STATE_ENDED) {
+      for (auto ctxt : task_shards[t]) {
+        if (ctxt->task_state == TASK_STATE_READY) {
+          post_msg(ctxt, message, now_ns);
+          wake_up(ctxt);
+        } else if (ctxt->task_state == TASK_STATE_ENDED) {
           Logger::itti().warn(
               "Broadcast message number %lu can not be sent from %d to %d, "
               "ended destination task!",
@@ -245,8 +433,7 @@ int itti_mw::send_broadcast_msg(std::shared_ptr<itti_msg> message) {
           Logger::itti().warn(
               "Broadcast message number %lu can not be sent from %d to %d, "
               "unknown state %d !",
-              message->msg_num, message->origin, t,
-              itti_task_ctxts[t]->task_state);
+              message->msg_num, message->origin, t, ctxt->task_state);
         }
       }
     }
@@ -268,48 +455,151 @@ int itti_mw::send_terminate_msg(task_id_t src_task_id) {
 //------------------------------------------------------------------------------
 std::shared_ptr<itti_msg> itti_mw::receive_msg(task_id_t task_id) {
   if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
-    if (itti_task_ctxts[task_id]) {
-      std::unique_lock<std::mutex> lk(itti_task_ctxts[task_id]->m_queue);
-      while (itti_task_ctxts[task_id]->msg_queue.empty()) {
-        itti_task_ctxts[task_id]->c_queue.wait(lk);
+    itti_task_ctxt* ctxt = receiving_ctxt(task_id);
+    if (ctxt) {
+      if (ctxt->batch_next == ctxt->batch_count) {
+        fill_batch(ctxt, true);
       }
-      std::shared_ptr<itti_msg> msg =
-          itti_task_ctxts[task_id]->msg_queue.front();
-      itti_task_ctxts[task_id]->msg_queue.pop();
-      return msg;
+      return std::move(ctxt->batch[ctxt->batch_next++]);
     }
   }
   Logger::itti().warn("received message failed, bad task id");
   return nullptr;
 }
 
+//------------------------------------------------------------------------------
+std::size_t itti_mw::receive_msgs(
+    task_id_t task_id, std::vector<std::shared_ptr<itti_msg>>& msgs,
+    const std::size_t max_msgs) {
+  if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
+    itti_task_ctxt* ctxt = receiving_ctxt(task_id);
+    if (ctxt) {
+      if (ctxt->batch_next == ctxt->batch_count) {
+        fill_batch(ctxt, true);
+      }
+      std::size_t n = 0;
+      while ((n < max_msgs) && (ctxt->batch_next < ctxt->batch_count)) {
+        msgs.push_back(std::move(ctxt->batch[ctxt->batch_next++]));
+        n++;
+      }
+      return n;
+    }
+  }
+  Logger::itti().warn("received messages failed, bad task id");
+  return 0;
+}
+
 //------------------------------------------------------------------------------
 std::shared_ptr<itti_msg> itti_mw::poll_msg(task_id_t task_id) {
   if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id)) {
-    if (itti_task_ctxts[task_id]) {
-      std::lock_guard<std::mutex> lk(itti_task_ctxts[task_id]->m_queue);
-      if (!itti_task_ctxts[task_id]->msg_queue.empty()) {
-        std::shared_ptr<itti_msg> msg =
-            itti_task_ctxts[task_id]->msg_queue.front();
-        itti_task_ctxts[task_id]->msg_queue.pop();
-        return msg;
+    itti_task_ctxt* ctxt = receiving_ctxt(task_id);
+    if (ctxt) {
+      if ((ctxt->batch_next < ctxt->batch_count) ||
+          (fill_batch(ctxt, false))) {
+        return std::move(ctxt->batch[ctxt->batch_next++]);
       }
     }
   }
   return nullptr;
 }
 
+//------------------------------------------------------------------------------
+int itti_mw::get_task_gauges(
+    task_id_t task_id, itti_task_gauges_t& gauges) const {
+  if ((TASK_FIRST <= task_id) && (TASK_MAX > task_id) &&
+      (itti_task_ctxts[task_id])) {
+    uint64_t sent   = 0;
+    uint64_t sum_ns = 0;
+    gauges          = {};
+    for (const itti_task_ctxt* ctxt : task_shards[task_id]) {
+      sent += ctxt->sent.load(std::memory_order_relaxed);
+      sum_ns += ctxt->latency_sum_ns.load(std::memory_order_relaxed);
+      gauges.received += ctxt->received.load(std::memory_order_relaxed);
+      gauges.wake_ups += ctxt->wake_ups.load(std::memory_order_relaxed);
+      gauges.overflowed += ctxt->overflowed.load(std::memory_order_relaxed);
+      gauges.max_depth = std::max(
+          gauges.max_depth, ctxt->max_depth.load(std::memory_order_relaxed));
+      gauges.max_latency_ns = std::max(
+          gauges.max_latency_ns,
+          ctxt->max_latency_ns.load(std::memory_order_relaxed));
+    }
+    gauges.depth           = sent - gauges.received;
+    gauges.mean_latency_ns = (gauges.received) ? sum_ns / gauges.received : 0;
+    return RETURNok;
+  }
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+std::string itti_mw::to_prometheus(const std::string& prefix) const {
+  // One line per started task and family, labelled with the task id
+  const struct {
+    const char* name;
+    const char* type;
+    const char* help;
+    uint64_t itti_task_gauges_t::*value;
+    double scale;
+  } families[] = {
+      {"itti_queue_depth", "gauge", "Messages sent to the task, not received",
+       &itti_task_gauges_t::depth, 1},
+      {"itti_queue_max_depth", "gauge", "Deepest mailbox of a task shard",
+       &itti_task_gauges_t::max_depth, 1},
+      {"itti_received_total", "counter", "Messages received by the task",
+       &itti_task_gauges_t::received, 1},
+      {"itti_wake_ups_total", "counter", "Wake ups of the task threads",
+       &itti_task_gauges_t::wake_ups, 1},
+      {"itti_overflowed_total", "counter",
+       "Messages which did not fit in the mailbox ring",
+       &itti_task_gauges_t::overflowed, 1},
+      {"itti_latency_mean_seconds", "gauge",
+       "Mean time spent by a message in the mailbox",
+       &itti_task_gauges_t::mean_latency_ns, 1e-9},
+      {"itti_latency_max_seconds", "gauge",
+       "Longest time spent by a message in the mailbox",
+       &itti_task_gauges_t::max_latency_ns, 1e-9}};
+  itti_task_gauges_t gauges[TASK_MAX] = {};
+  bool started[TASK_MAX]              = {};
+  for (int task_idx = TASK_FIRST; task_idx < TASK_MAX; task_idx++) {
+    started[task_idx] =
+        (RETURNok == get_task_gauges((task_id_t) task_idx, gauges[task_idx]));
+  }
+  std::string text = {};
+  for (const auto& f : families) {
+    const std::string name = prefix + "_" + f.name;
+    text += fmt::format(
+        "# HELP {} {}\n# TYPE {} {}\n", name, f.help, name, f.type);
+    for (int task_idx = TASK_FIRST; task_idx < TASK_MAX; task_idx++) {
+      if (started[task_idx]) {
+        text += fmt::format(
+            "{}{{task=\"{}\"}} {}\n", name, task_idx,
+            (double) (gauges[task_idx].*f.value) * f.scale);
+      }
+    }
+  }
+  return text;
+}
+
 //------------------------------------------------------------------------------
 void itti_mw::wait_tasks_end(void) {
   Logger::itti().info("Waiting ITTI tasks closed");
   for (int task_idx = TASK_FIRST; task_idx < TASK_MAX; task_idx++) {
     if (itti_task_ctxts[task_idx]) {
-      if (itti_task_ctxts[task_idx]->thread.joinable()) {
-        itti_task_ctxts[task_idx]->thread.join();
-        itti_task_ctxts[task_idx]->m_state.lock();
-        itti_task_ctxts[task_idx]->task_state = TASK_STATE_ENDED;
-        itti_task_ctxts[task_idx]->m_state.unlock();
+      for (auto ctxt : task_shards[task_idx]) {
+        if (ctxt->thread.joinable()) {
+          ctxt->thread.join();
+          ctxt->m_state.lock();
+          ctxt->task_state = TASK_STATE_ENDED;
+          ctxt->m_state.unlock();
+        }
       }
+      itti_task_gauges_t g = {};
+      get_task_gauges((task_id_t) task_idx, g);
+      Logger::itti().info(
+          "Task %d (%zu shards) received %" PRIu64 " msgs in %" PRIu64
+          " wake ups, max depth %" PRIu64 ", overflowed %" PRIu64
+          ", latency mean %" PRIu64 " ns max %" PRIu64 " ns",
+          task_idx, task_shards[task_idx].size(), g.received, g.wake_ups,
+          g.max_depth, g.overflowed, g.mean_latency_ns, g.max_latency_ns);
     }
   }
   Logger::itti().info("All ITTI tasks closed");
@@ -322,17 +612,26 @@ timer_id_t itti_mw::timer_setup(
   // Not sending to task timer
   if ((TASK_FIRST < task_id) && (TASK_MAX > task_id)) {
     itti_timer t(
-        increment_timer_id(), task_id, interval_sec, interval_us, arg1_user,
+        increment_timer_id(), task_id, get_current_shard(task_id), arg1_user,
         arg2_user);
-    timer_id_t id = t.id;
+    // Never fires early: the ticks are rounded up
+    const uint64_t delay_us =
+        (uint64_t) interval_sec * 1000000 + (uint64_t) interval_us;
+    const uint64_t expiry =
+        (std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - timer_epoch)
+             .count() +
+         delay_us + ITTI_TIMER_TICK_MS * 1000 - 1) /
+        (ITTI_TIMER_TICK_MS * 1000);
     std::unique_lock<std::mutex> l(m_timers);
-    timers.insert(t);
-    c_timers.notify_one();
-
+    t.wheel_timer = timer_wheel.start(expiry, t.id);
+    timers.insert(std::make_pair(t.id, t));
     // wake up thread timer if necessary
-    std::unique_lock<std::mutex> l2(m_timeout);
-    c_timeout.notify_one();
-    return id;
+    if (expiry < timer_wake_up) {
+      timer_wake_up = expiry;
+      c_timers.notify_one();
+    }
+    return t.id;
   }
   return ITTI_INVALID_TIMER_ID;
 }
@@ -340,23 +639,11 @@ timer_id_t itti_mw::timer_setup(
 //------------------------------------------------------------------------------
 int itti_mw::timer_remove(timer_id_t timer_id) {
   std::lock_guard<std::mutex> lk(m_timers);
-  if (current_timer.id == timer_id) {
-    // cout << "timer_remove() current_timer.id == timer_id" << endl;
-    current_timer = null_timer;
-    c_timers.notify_one();
-    // wake up thread timer if necessary
-    std::unique_lock<std::mutex> l2(m_timeout);
-    c_timeout.notify_one();
+  auto it = timers.find(timer_id);
+  if (it != timers.end()) {
+    timer_wheel.stop(it->second.wheel_timer);
+    timers.erase(it);
     return RETURNok;
-  } else {
-    std::set<itti_timer>::iterator it = itti_inst->timers.begin();
-    while (it != itti_inst->timers.end()) {
-      if (it->id == timer_id) {
-        itti_inst->timers.erase(it);
-        return RETURNok;
-      }
-      ++it;
-    }
   }
   Logger::itti().trace("Removing timer 0x%lx: Not found", timer_id);
   return RETURNerror;
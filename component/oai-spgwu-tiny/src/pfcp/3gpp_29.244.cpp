@@ -32,6 +32,18 @@
 
 using namespace pfcp;
 
+//------------------------------------------------------------------------------
+// Do not leak the IE if its value is malformed
+template <class T>
+static T* load_ie(T* ie, std::istream& is) {
+  try {
+    ie->load_from(is);
+  } catch (...) {
+    delete ie;
+    throw;
+  }
+  return ie;
+}
 //------------------------------------------------------------------------------
 pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
   pfcp_tlv tlv;
@@ -40,196 +52,159 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
     switch (tlv.type) {
       case PFCP_IE_CREATE_PDR: {
         pfcp_create_pdr_ie* ie = new pfcp_create_pdr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_PDI: {
         pfcp_pdi_ie* ie = new pfcp_pdi_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CREATE_FAR: {
         pfcp_create_far_ie* ie = new pfcp_create_far_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_FORWARDING_PARAMETERS: {
         pfcp_forwarding_parameters_ie* ie =
             new pfcp_forwarding_parameters_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_DUPLICATING_PARAMETERS: {
         pfcp_duplicating_parameters_ie* ie =
             new pfcp_duplicating_parameters_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CREATE_URR: {
         pfcp_create_urr_ie* ie = new pfcp_create_urr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CREATE_QER: {
         pfcp_create_qer_ie* ie = new pfcp_create_qer_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CREATED_PDR: {
         pfcp_created_pdr_ie* ie = new pfcp_created_pdr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_PDR: {
         pfcp_update_pdr_ie* ie = new pfcp_update_pdr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_FAR: {
         pfcp_update_far_ie* ie = new pfcp_update_far_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_FORWARDING_PARAMETERS: {
         pfcp_update_forwarding_parameters_ie* ie =
             new pfcp_update_forwarding_parameters_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_REPORT_RESPONSE: {
         pfcp_update_bar_within_pfcp_session_report_response_ie* ie =
             new pfcp_update_bar_within_pfcp_session_report_response_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_URR: {
         pfcp_update_urr_ie* ie = new pfcp_update_urr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UPDATE_QER: {
         pfcp_update_qer_ie* ie = new pfcp_update_qer_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_REMOVE_PDR: {
         pfcp_remove_pdr_ie* ie = new pfcp_remove_pdr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_REMOVE_FAR: {
         pfcp_remove_far_ie* ie = new pfcp_remove_far_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_REMOVE_URR: {
         pfcp_remove_urr_ie* ie = new pfcp_remove_urr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_REMOVE_QER: {
         pfcp_remove_qer_ie* ie = new pfcp_remove_qer_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CAUSE: {
         pfcp_cause_ie* ie = new pfcp_cause_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_SOURCE_INTERFACE: {
         pfcp_source_interface_ie* ie = new pfcp_source_interface_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_F_TEID: {
         pfcp_fteid_ie* ie = new pfcp_fteid_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_NETWORK_INSTANCE: {
         pfcp_network_instance_ie* ie = new pfcp_network_instance_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_SDF_FILTER: {
         pfcp_sdf_filter_ie* ie = new pfcp_sdf_filter_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_APPLICATION_ID: {
         pfcp_application_id_ie* ie = new pfcp_application_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_GATE_STATUS: {
         pfcp_gate_status_ie* ie = new pfcp_gate_status_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_MBR: {
         pfcp_mbr_ie* ie = new pfcp_mbr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_GBR: {
         pfcp_gbr_ie* ie = new pfcp_gbr_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_QER_CORRELATION_ID: {
         pfcp_qer_correlation_id_ie* ie = new pfcp_qer_correlation_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_PRECEDENCE: {
         pfcp_precedence_ie* ie = new pfcp_precedence_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_TRANSPORT_LEVEL_MARKING: {
         pfcp_transport_level_marking_ie* ie =
             new pfcp_transport_level_marking_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_VOLUME_THRESHOLD: {
         pfcp_volume_threshold_ie* ie = new pfcp_volume_threshold_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_TIME_THRESHOLD: {
         pfcp_time_threshold_ie* ie = new pfcp_time_threshold_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_MONITORING_TIME: {
         pfcp_monitoring_time_ie* ie = new pfcp_monitoring_time_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_SUBSEQUENT_VOLUME_THRESHOLD: {
         pfcp_subsequent_volume_threshold_ie* ie =
             new pfcp_subsequent_volume_threshold_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_SUBSEQUENT_TIME_THRESHOLD: {
         pfcp_subsequent_time_threshold_ie* ie =
             new pfcp_subsequent_time_threshold_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_INACTIVITY_DETECTION_TIME: {
         pfcp_inactivity_detection_time_ie* ie =
             new pfcp_inactivity_detection_time_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_REPORTING_TRIGGERS: {
         pfcp_reporting_triggers_ie* ie = new pfcp_reporting_triggers_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_REDIRECT_INFORMATION: {
         //        pfcp_redirect_information_ie *ie = new
@@ -239,35 +214,29 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_REPORT_TYPE: {
         pfcp_report_type_ie* ie = new pfcp_report_type_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_OFFENDING_IE: {
         pfcp_offending_ie_ie* ie = new pfcp_offending_ie_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_FORWARDING_POLICY: {
         pfcp_forwarding_policy_ie* ie = new pfcp_forwarding_policy_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_DESTINATION_INTERFACE: {
         pfcp_destination_interface_ie* ie =
             new pfcp_destination_interface_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_UP_FUNCTION_FEATURES: {
         pfcp_up_function_features_ie* ie =
             new pfcp_up_function_features_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_APPLY_ACTION: {
         pfcp_apply_action_ie* ie = new pfcp_apply_action_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_DOWNLINK_DATA_SERVICE_INFORMATION: {
         //        pfcp_downlink_data_service_information_ie *ie = new
@@ -276,13 +245,11 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY: {
-        //        pfcp_downlink_data_notification_delay_ie *ie = new
-        //        pfcp_downlink_data_notification_delay_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
+      case PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY: {
+        pfcp_downlink_data_notification_delay_ie* ie =
+            new pfcp_downlink_data_notification_delay_ie(tlv);
+        return load_ie(ie, is);
+      } break;
         //    case PFCP_IE_DL_BUFFERING_DURATION: {
         //        pfcp_dl_buffering_duration_ie *ie = new
         //        pfcp_dl_buffering_duration_ie(tlv); ie->load_from(is); return
@@ -337,13 +304,11 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_PACKET_DETECTION_RULE_ID: {
         pfcp_pdr_id_ie* ie = new pfcp_pdr_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_F_SEID: {
         pfcp_f_seid_ie* ie = new pfcp_f_seid_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_APPLICATION_IDS_PFDS: {
         //        pfcp_application_ids_pfds_ie *ie = new
@@ -359,8 +324,7 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_NODE_ID: {
         pfcp_node_id_ie* ie = new pfcp_node_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_PFD_CONTENTS: {
         //        pfcp_pfd_contents_ie *ie = new pfcp_pfd_contents_ie(tlv);
@@ -368,39 +332,34 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_MEASUREMENT_METHOD: {
-        //        pfcp_measurement_method_ie *ie = new
-        //        pfcp_measurement_method_ie(tlv); ie->load_from(is); return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_USAGE_REPORT_TRIGGER: {
-        //        pfcp_usage_report_trigger_ie *ie = new
-        //        pfcp_usage_report_trigger_ie(tlv); ie->load_from(is); return
-        //        ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_MEASUREMENT_PERIOD: {
-        //        pfcp_measurement_period_ie *ie = new
-        //        pfcp_measurement_period_ie(tlv); ie->load_from(is); return ie;
-        //      }
-        //      break;
+      case PFCP_IE_MEASUREMENT_METHOD: {
+        pfcp_measurement_method_ie* ie = new pfcp_measurement_method_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_USAGE_REPORT_TRIGGER: {
+        pfcp_usage_report_trigger_ie* ie =
+            new pfcp_usage_report_trigger_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_MEASUREMENT_PERIOD: {
+        pfcp_measurement_period_ie* ie = new pfcp_measurement_period_ie(tlv);
+        return load_ie(ie, is);
+      } break;
         //    case PFCP_IE_FQ_CSID: {
         //        pfcp_fq_csid_ie *ie = new pfcp_fq_csid_ie(tlv);
         //        ie->load_from(is);
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_VOLUME_MEASUREMENT: {
-        //        pfcp_volume_measurement_ie *ie = new
-        //        pfcp_volume_measurement_ie(tlv); ie->load_from(is); return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_DURATION_MEASUREMENT: {
-        //        pfcp_duration_measurement_ie *ie = new
-        //        pfcp_duration_measurement_ie(tlv); ie->load_from(is); return
-        //        ie;
-        //      }
-        //      break;
+      case PFCP_IE_VOLUME_MEASUREMENT: {
+        pfcp_volume_measurement_ie* ie = new pfcp_volume_measurement_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_DURATION_MEASUREMENT: {
+        pfcp_duration_measurement_ie* ie =
+            new pfcp_duration_measurement_ie(tlv);
+        return load_ie(ie, is);
+      } break;
         //    case PFCP_IE_APPLICATION_DETECTION_INFORMATION: {
         //        pfcp_application_detection_information_ie *ie = new
         //        pfcp_application_detection_information_ie(tlv);
@@ -443,18 +402,14 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_START_TIME: {
-        //        pfcp_start_time_ie *ie = new pfcp_start_time_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_END_TIME: {
-        //        pfcp_end_time_ie *ie = new pfcp_end_time_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
+      case PFCP_IE_START_TIME: {
+        pfcp_start_time_ie* ie = new pfcp_start_time_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_END_TIME: {
+        pfcp_end_time_ie* ie = new pfcp_end_time_ie(tlv);
+        return load_ie(ie, is);
+      } break;
         //    case PFCP_IE_QUERY_URR: {
         //        pfcp_query_urr_ie *ie = new pfcp_query_urr_ie(tlv);
         //        ie->load_from(is);
@@ -469,25 +424,19 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE: {
-        //        pfcp_usage_report_within_session_deletion_response_ie *ie =
-        //        new
-        //        pfcp_usage_report_within_session_deletion_response_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST: {
-        //        pfcp_usage_report_within_session_report_request_ie *ie = new
-        //        pfcp_usage_report_within_session_report_request_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
+      case PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE: {
+        pfcp_usage_report_within_session_deletion_response_ie* ie =
+            new pfcp_usage_report_within_session_deletion_response_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST: {
+        pfcp_usage_report_within_session_report_request_ie* ie =
+            new pfcp_usage_report_within_session_report_request_ie(tlv);
+        return load_ie(ie, is);
+      } break;
       case PFCP_IE_URR_ID: {
         pfcp_urr_id_ie* ie = new pfcp_urr_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_LINKED_URR_ID: {
         //        pfcp_linked_urr_id_ie *ie = new pfcp_linked_urr_id_ie(tlv);
@@ -498,46 +447,35 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
       case PFCP_IE_DOWNLINK_DATA_REPORT: {
         pfcp_downlink_data_report_ie* ie =
             new pfcp_downlink_data_report_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_OUTER_HEADER_CREATION: {
         pfcp_outer_header_creation_ie* ie =
             new pfcp_outer_header_creation_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_CREATE_BAR: {
+        pfcp_create_bar_ie* ie = new pfcp_create_bar_ie(tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST: {
+        pfcp_update_bar_within_pfcp_session_modification_request_ie* ie =
+            new pfcp_update_bar_within_pfcp_session_modification_request_ie(
+                tlv);
+        return load_ie(ie, is);
+      } break;
+      case PFCP_IE_REMOVE_BAR: {
+        pfcp_remove_bar_ie* ie = new pfcp_remove_bar_ie(tlv);
+        return load_ie(ie, is);
       } break;
-        //    case PFCP_IE_CREATE_BAR: {
-        //        pfcp_create_bar_ie *ie = new pfcp_create_bar_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST:
-        //    {
-        //        pfcp_update_bar_within_session_modification_request_ie *ie =
-        //        new
-        //        pfcp_update_bar_within_session_modification_request_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
-        //    case PFCP_IE_REMOVE_BAR: {
-        //        pfcp_remove_bar_ie *ie = new pfcp_remove_bar_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
       case PFCP_IE_BAR_ID: {
         pfcp_bar_id_ie* ie = new pfcp_bar_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_CP_FUNCTION_FEATURES: {
         pfcp_cp_function_features_ie* ie =
             new pfcp_cp_function_features_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_USAGE_INFORMATION: {
         //        pfcp_usage_information_ie *ie = new
@@ -557,8 +495,7 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_UE_IP_ADDRESS: {
         pfcp_ue_ip_address_ie* ie = new pfcp_ue_ip_address_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_PACKET_RATE: {
         //        pfcp_packet_rate_ie *ie = new pfcp_packet_rate_ie(tlv);
@@ -569,13 +506,11 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
       case PFCP_IE_OUTER_HEADER_REMOVAL: {
         pfcp_outer_header_removal_ie* ie =
             new pfcp_outer_header_removal_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_RECOVERY_TIME_STAMP: {
         pfcp_recovery_time_stamp_ie* ie = new pfcp_recovery_time_stamp_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_DL_FLOW_LEVEL_MARKING: {
         //        pfcp_dl_flow_level_marking_ie *ie = new
@@ -617,12 +552,10 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        pfcp_remote_gtp_u_peer_ie(tlv); ie->load_from(is); return ie;
         //      }
         //      break;
-        //    case PFCP_IE_UR_SEQN: {
-        //        pfcp_ur_seqn_ie *ie = new pfcp_ur_seqn_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
+      case PFCP_IE_UR_SEQN: {
+        pfcp_ur_seqn_ie* ie = new pfcp_ur_seqn_ie(tlv);
+        return load_ie(ie, is);
+      } break;
         //    case PFCP_IE_UPDATE_DUPLICATING_PARAMETERS: {
         //        pfcp_update_duplicating_parameters_ie *ie = new
         //        pfcp_update_duplicating_parameters_ie(tlv); ie->load_from(is);
@@ -632,24 +565,20 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
       case PFCP_IE_ACTIVATE_PREDEFINED_RULES: {
         pfcp_activate_predefined_rules_ie* ie =
             new pfcp_activate_predefined_rules_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_DEACTIVATE_PREDEFINED_RULES: {
         pfcp_deactivate_predefined_rules_ie* ie =
             new pfcp_deactivate_predefined_rules_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_FAR_ID: {
         pfcp_far_id_ie* ie = new pfcp_far_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_QER_ID: {
         pfcp_qer_id_ie* ie = new pfcp_qer_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_OCI_FLAGS: {
         //        pfcp_oci_flags_ie *ie = new pfcp_oci_flags_ie(tlv);
@@ -678,8 +607,7 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_FAILED_RULE_ID: {
         pfcp_failed_rule_id_ie* ie = new pfcp_failed_rule_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_TIME_QUOTA_MECHANISM: {
         //        pfcp_time_quota_mechanism_ie *ie = new
@@ -690,14 +618,12 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
       case PFCP_IE_USER_PLANE_IP_RESOURCE_INFORMATION: {
         pfcp_user_plane_ip_resource_information_ie* ie =
             new pfcp_user_plane_ip_resource_information_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
       case PFCP_IE_USER_PLANE_INACTIVITY_TIMER: {
         pfcp_user_plane_inactivity_timer_ie* ie =
             new pfcp_user_plane_inactivity_timer_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_AGGREGATED_URRS: {
         //        pfcp_aggregated_urrs_ie *ie = new
@@ -735,8 +661,7 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //      break;
       case PFCP_IE_QFI: {
         pfcp_qfi_ie* ie = new pfcp_qfi_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_QUERY_URR_REFERENCE: {
         //        pfcp_query_urr_reference_ie *ie = new
@@ -828,17 +753,14 @@ pfcp_ie* pfcp_ie::new_pfcp_ie_from_stream(std::istream& is) {
         //        return ie;
         //      }
         //      break;
-        //    case PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT: {
-        //        pfcp_suggested_buffering_packets_count_ie *ie = new
-        //        pfcp_suggested_buffering_packets_count_ie(tlv);
-        //        ie->load_from(is);
-        //        return ie;
-        //      }
-        //      break;
+      case PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT: {
+        pfcp_suggested_buffering_packets_count_ie* ie =
+            new pfcp_suggested_buffering_packets_count_ie(tlv);
+        return load_ie(ie, is);
+      } break;
       case PFCP_IE_USER_ID: {
         pfcp_user_id_ie* ie = new pfcp_user_id_ie(tlv);
-        ie->load_from(is);
-        return ie;
+        return load_ie(ie, is);
       } break;
         //    case PFCP_IE_ETHERNET_PDU_SESSION_INFORMATION: {
         //        pfcp_ethernet_pdu_session_information_ie *ie = new
@@ -1108,8 +1030,11 @@ pfcp_msg::pfcp_msg(const pfcp_session_establishment_request& pfcp_ies)
     std::shared_ptr<pfcp_create_qer_ie> sie(new pfcp_create_qer_ie(it));
     add_ie(sie);
   }
-  //  if (pfcp_ies.create_bar.first) {std::shared_ptr<pfcp_create_bar_ie>
-  //  sie(new pfcp_create_bar_ie(pfcp_ies.create_bar.second)); add_ie(sie);}
+  if (pfcp_ies.create_bar.first) {
+    std::shared_ptr<pfcp_create_bar_ie> sie(
+        new pfcp_create_bar_ie(pfcp_ies.create_bar.second));
+    add_ie(sie);
+  }
   if (pfcp_ies.create_traffic_endpoint.first) {
     std::shared_ptr<pfcp_create_traffic_endpoint_ie> sie(
         new pfcp_create_traffic_endpoint_ie(
@@ -1215,9 +1140,12 @@ pfcp_msg::pfcp_msg(const pfcp_session_modification_request& pfcp_ies)
     std::shared_ptr<pfcp_remove_qer_ie> sie(new pfcp_remove_qer_ie(it));
     add_ie(sie);
   }
-  // if (pfcp_ies.remove_bar.first) {std::shared_ptr<pfcp_remove_bar_ie> sie(new
-  // pfcp_remove_bar_ie(pfcp_ies.remove_bar.second)); add_ie(sie);} if
-  // (pfcp_ies.remove_traffic_endpoint.first)
+  if (pfcp_ies.remove_bar.first) {
+    std::shared_ptr<pfcp_remove_bar_ie> sie(
+        new pfcp_remove_bar_ie(pfcp_ies.remove_bar.second));
+    add_ie(sie);
+  }
+  // if (pfcp_ies.remove_traffic_endpoint.first)
   // {std::shared_ptr<pfcp_remove_traffic_endpoint_ie> sie(new
   // pfcp_remove_traffic_endpoint_ie(pfcp_ies.remove_traffic_endpoint.second));
   // add_ie(sie);}
@@ -1237,8 +1165,11 @@ pfcp_msg::pfcp_msg(const pfcp_session_modification_request& pfcp_ies)
     std::shared_ptr<pfcp_create_qer_ie> sie(new pfcp_create_qer_ie(it));
     add_ie(sie);
   }
-  // if (pfcp_ies.create_bar.first) {std::shared_ptr<pfcp_create_bar_ie> sie(new
-  // pfcp_create_bar_ie(pfcp_ies.create_bar.second)); add_ie(sie);}
+  if (pfcp_ies.create_bar.first) {
+    std::shared_ptr<pfcp_create_bar_ie> sie(
+        new pfcp_create_bar_ie(pfcp_ies.create_bar.second));
+    add_ie(sie);
+  }
   if (pfcp_ies.create_traffic_endpoint.first) {
     std::shared_ptr<pfcp_create_traffic_endpoint_ie> sie(
         new pfcp_create_traffic_endpoint_ie(
@@ -1261,9 +1192,13 @@ pfcp_msg::pfcp_msg(const pfcp_session_modification_request& pfcp_ies)
     std::shared_ptr<pfcp_update_qer_ie> sie(new pfcp_update_qer_ie(it));
     add_ie(sie);
   }
-  //  if (pfcp_ies.update_bar.first) {std::shared_ptr<pfcp_update_bar_ie>
-  //  sie(new pfcp_update_bar_ie(pfcp_ies.update_bar.second)); add_ie(sie);} if
-  //  (pfcp_ies.update_traffic_endpoint.first)
+  if (pfcp_ies.update_bar.first) {
+    std::shared_ptr<pfcp_update_bar_within_pfcp_session_modification_request_ie>
+        sie(new pfcp_update_bar_within_pfcp_session_modification_request_ie(
+            pfcp_ies.update_bar.second));
+    add_ie(sie);
+  }
+  //  if (pfcp_ies.update_traffic_endpoint.first)
   //  {std::shared_ptr<pfcp_update_traffic_endpoint_ie> sie(new
   //  pfcp_update_traffic_endpoint_ie(pfcp_ies.update_traffic_endpoint.second));
   //  add_ie(sie);} if (pfcp_ies.pfcpsmreq_flags.first)
@@ -1371,11 +1306,12 @@ pfcp_msg::pfcp_msg(const pfcp_session_deletion_response& pfcp_ies)
   // add_ie(sie);} if (pfcp_ies.overload_control_information.first)
   // {std::shared_ptr<pfcp_overload_control_information_ie> sie(new
   // pfcp_overload_control_information_ie(pfcp_ies.overload_control_information.second));
-  // add_ie(sie);} if (pfcp_ies.usage_report_information.first)
-  // {std::shared_ptr<pfcp_usage_report_within_session_deletion_response_ie>
-  // sie(new
-  // pfcp_usage_report_within_session_deletion_response_ie(pfcp_ies.additional_usage_reports_information.second));
   // add_ie(sie);}
+  for (auto it : pfcp_ies.usage_reports) {
+    std::shared_ptr<pfcp_usage_report_within_session_deletion_response_ie>
+        sie(new pfcp_usage_report_within_session_deletion_response_ie(it));
+    add_ie(sie);
+  }
 }
 //------------------------------------------------------------------------------
 pfcp_msg::pfcp_msg(const pfcp_session_report_request& pfcp_ies)
@@ -1393,8 +1329,12 @@ pfcp_msg::pfcp_msg(const pfcp_session_report_request& pfcp_ies)
         new pfcp_downlink_data_report_ie(pfcp_ies.downlink_data_report.second));
     add_ie(sie);
   }
-  // TODO std::pair<bool, pfcp::usage_report_within_pfcp_session_report_request>
-  // usage_report;
+  if (pfcp_ies.usage_report.first) {
+    std::shared_ptr<pfcp_usage_report_within_session_report_request_ie> sie(
+        new pfcp_usage_report_within_session_report_request_ie(
+            pfcp_ies.usage_report.second));
+    add_ie(sie);
+  }
   // TODO std::pair<bool, pfcp::error_indication_report>
   // error_indication_report;
   // TODO std::pair<bool, pfcp::load_control_information>
@@ -32,6 +32,7 @@
 #include "3gpp_29.244.h"
 #include "logger.hpp"
 #include "msg_pfcp.hpp"
+#include "pfcp_codec.hpp"
 #include "serializable.hpp"
 
 #include <arpa/inet.h>
@@ -101,10 +102,23 @@ class pfcp_tlv : public stream_serializable {
   }
 };
 //------------------------------------------------------------------------------
+class pfcp_ie;
+typedef std::vector<
+    std::shared_ptr<pfcp_ie>,
+    pfcp_arena_allocator<std::shared_ptr<pfcp_ie>>>
+    pfcp_ies_t;
+//------------------------------------------------------------------------------
 class pfcp_ie : public stream_serializable {
  public:
   pfcp_tlv tlv;
 
+  // IEs are taken from the arena of the thread while a pfcp_arena::scope is
+  // alive, e.g. when decoding
+  static void* operator new(std::size_t size) {
+    return pfcp_arena::allocate(size);
+  }
+  static void operator delete(void* p) { pfcp_arena::deallocate(p); }
+
   pfcp_ie() : tlv() {}
   explicit pfcp_ie(const pfcp_tlv& t) : tlv(t) {}
   explicit pfcp_ie(const uint8_t tlv_type) : tlv() { tlv.type = tlv_type; }
@@ -123,11 +137,17 @@ class pfcp_ie : public stream_serializable {
   };
 
   static pfcp_ie* new_pfcp_ie_from_stream(std::istream& is);
+
+  // Control block of the shared_ptr also taken from the arena
+  static std::shared_ptr<pfcp_ie> share(pfcp_ie* ie) {
+    return std::shared_ptr<pfcp_ie>(
+        ie, std::default_delete<pfcp_ie>(), pfcp_arena_allocator<pfcp_ie>());
+  }
 };
 //------------------------------------------------------------------------------
 class pfcp_grouped_ie : public pfcp_ie {
  public:
-  std::vector<std::shared_ptr<pfcp_ie>> ies;
+  pfcp_ies_t ies;
 
   pfcp_grouped_ie() : pfcp_ie(), ies() {}
   pfcp_grouped_ie(const pfcp_grouped_ie& g) : pfcp_ie(g), ies(g.ies) {}
@@ -148,7 +168,7 @@ class pfcp_grouped_ie : public pfcp_ie {
 
   virtual void dump_to(std::ostream& os) {
     tlv.dump_to(os);
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->dump_to(os);
     }
   };
@@ -160,7 +180,7 @@ class pfcp_grouped_ie : public pfcp_ie {
       pfcp_ie* ie = new_pfcp_ie_from_stream(is);
       if (ie) {
         remaining_size -= (ie->tlv.get_length() + pfcp_tlv::tlv_ie_length);
-        ies.push_back(std::shared_ptr<pfcp_ie>(ie));  // do not use add_ie()
+        ies.push_back(share(ie));  // do not use add_ie()
       } else {
         throw pfcp_tlv_bad_length_exception(
             tlv.get_type(), tlv.get_length(), __FILE__, __LINE__);
@@ -291,7 +311,7 @@ class pfcp_msg : public pfcp_msg_header {
  public:
   uint16_t remote_port;
 
-  std::vector<std::shared_ptr<pfcp_ie>> ies;
+  pfcp_ies_t ies;
 
   pfcp_msg() : pfcp_msg_header(), remote_port(0) { ies = {}; }
 
@@ -338,114 +358,114 @@ class pfcp_msg : public pfcp_msg_header {
   }
 
   void to_core_type(pfcp_heartbeat_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_heartbeat_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_pfd_management_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_pfd_management_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_setup_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_setup_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_update_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_update_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_release_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_association_release_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_version_not_supported_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_node_report_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_node_report_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_establishment_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_establishment_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_modification_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_modification_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_deletion_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_deletion_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_report_request& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
   void to_core_type(pfcp_session_report_response& s) {
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->to_core_type(s);
     }
   }
 
   void dump_to(std::ostream& os) {
     pfcp_msg_header::dump_to(os);
-    for (auto i : ies) {
+    for (auto& i : ies) {
       i.get()->dump_to(os);
     }
   }
@@ -462,13 +482,14 @@ class pfcp_msg : public pfcp_msg_header {
       ie = pfcp_ie::new_pfcp_ie_from_stream(is);
       if (ie) {
         ies_length += (pfcp_tlv::tlv_ie_length + ie->tlv.get_length());
-        ies.push_back(std::shared_ptr<pfcp_ie>(ie));
+        ies.push_back(pfcp_ie::share(ie));
         // std::cout << std::dec << " ies length  = " << ies_length << " IE
         // length = " << ie->tlv.get_length() << std::endl;
       }
     } while ((ie) && (ies_length < check_msg_length));
 
-    if (ies_length != check_msg_length) {
+    // The IE lengths may add up while the datagram was cut inside an IE value
+    if ((ies_length != check_msg_length) || (is.fail())) {
       // std::cout << " check_msg_length  = " << check_msg_length << "
       // ies_length  = " << ies_length << std::endl;
       throw pfcp_msg_bad_length_exception(
@@ -476,6 +497,25 @@ class pfcp_msg : public pfcp_msg_header {
           check_msg_length, __FILE__, __LINE__);
     }
   }
+
+  // Decode a received message in place, the IEs come from the arena
+  void load_from(const char* buffer, const std::size_t size) {
+    span_istreambuf sb(buffer, size);
+    std::istream is(&sb);
+    pfcp_arena::scope arena_scope;
+    load_from(is);
+  }
+  // Encode in a buffer supplied by the caller, the length is known from the
+  // IEs added. Return the length of the message, 0 if it does not fit.
+  std::size_t dump_to(char* buffer, const std::size_t size) {
+    if ((std::size_t) get_message_length() + 4 > size) {
+      return 0;
+    }
+    span_ostreambuf sb(buffer, size);
+    std::ostream os(&sb);
+    dump_to(os);
+    return (os.good()) ? sb.size() : 0;
+  }
 };
 
 inline void ipv6_address_dump_to(
@@ -1234,7 +1274,7 @@ class pfcp_qer_correlation_id_ie : public pfcp_ie {
   //--------
   void load_from(std::istream& is) {
     // tlv.load_from(is);
-    if (tlv.get_length() != 1) {
+    if (tlv.get_length() != sizeof(qer_correlation_id)) {
       throw pfcp_tlv_bad_length_exception(
           tlv.type, tlv.get_length(), __FILE__, __LINE__);
     }
@@ -1458,18 +1498,19 @@ class pfcp_volume_threshold_ie : public pfcp_ie {
       throw pfcp_tlv_bad_length_exception(
           tlv.type, tlv.get_length(), __FILE__, __LINE__);
     }
+    is.read(reinterpret_cast<char*>(&u1.b), sizeof(u1.b));
     if (u1.bf.tovol) {
       is.read(reinterpret_cast<char*>(&total_volume), sizeof(total_volume));
       total_volume = be64toh(total_volume);
     }
     if (u1.bf.ulvol) {
       is.read(reinterpret_cast<char*>(&uplink_volume), sizeof(uplink_volume));
-      total_volume = be64toh(uplink_volume);
+      uplink_volume = be64toh(uplink_volume);
     }
     if (u1.bf.dlvol) {
       is.read(
           reinterpret_cast<char*>(&downlink_volume), sizeof(downlink_volume));
-      total_volume = be64toh(downlink_volume);
+      downlink_volume = be64toh(downlink_volume);
     }
   }
   //--------
@@ -1690,18 +1731,19 @@ class pfcp_subsequent_volume_threshold_ie : public pfcp_ie {
       throw pfcp_tlv_bad_length_exception(
           tlv.type, tlv.get_length(), __FILE__, __LINE__);
     }
+    is.read(reinterpret_cast<char*>(&u1.b), sizeof(u1.b));
     if (u1.bf.tovol) {
       is.read(reinterpret_cast<char*>(&total_volume), sizeof(total_volume));
       total_volume = be64toh(total_volume);
     }
     if (u1.bf.ulvol) {
       is.read(reinterpret_cast<char*>(&uplink_volume), sizeof(uplink_volume));
-      total_volume = be64toh(uplink_volume);
+      uplink_volume = be64toh(uplink_volume);
     }
     if (u1.bf.dlvol) {
       is.read(
           reinterpret_cast<char*>(&downlink_volume), sizeof(downlink_volume));
-      total_volume = be64toh(downlink_volume);
+      downlink_volume = be64toh(downlink_volume);
     }
   }
   //--------
@@ -2410,55 +2452,57 @@ class pfcp_apply_action_ie : public pfcp_ie {
 //      s.set(downlink_data_service_information);
 //  }
 //};
-////-------------------------------------
-//// IE DOWNLINK_DATA_NOTIFICATION_DELAY
-// class pfcp_downlink_data_notification_delay_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_downlink_data_notification_delay_ie(const
-//  pfcp::downlink_data_notification_delay_t& b) :
-//  pfcp_ie(PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_downlink_data_notification_delay_ie() :
-//  pfcp_ie(PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_downlink_data_notification_delay_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::downlink_data_notification_delay_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::downlink_data_notification_delay_t
-//      downlink_data_notification_delay = {};
-//      to_core_type(downlink_data_notification_delay);
-//      s.set(downlink_data_notification_delay);
-//  }
-//};
+//-------------------------------------
+// IE DOWNLINK_DATA_NOTIFICATION_DELAY
+class pfcp_downlink_data_notification_delay_ie : public pfcp_ie {
+ public:
+  uint8_t delay;
+
+  //--------
+  explicit pfcp_downlink_data_notification_delay_ie(
+      const pfcp::downlink_data_notification_delay_t& b)
+      : pfcp_ie(PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY) {
+    delay = b.delay;
+    tlv.set_length(1);
+  }
+  //--------
+  pfcp_downlink_data_notification_delay_ie()
+      : pfcp_ie(PFCP_IE_DOWNLINK_DATA_NOTIFICATION_DELAY) {
+    delay = 0;
+    tlv.set_length(1);
+  }
+  //--------
+  explicit pfcp_downlink_data_notification_delay_ie(const pfcp_tlv& t)
+      : pfcp_ie(t) {
+    delay = 0;
+  };
+  //--------
+  void to_core_type(pfcp::downlink_data_notification_delay_t& b) {
+    b.delay = delay;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    os.write(reinterpret_cast<const char*>(&delay), sizeof(delay));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() < 1) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&delay), sizeof(delay));
+    // Spare octets
+    is.ignore(tlv.get_length() - 1);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::downlink_data_notification_delay_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 ////-------------------------------------
 //// IE DL_BUFFERING_DURATION
 // class pfcp_dl_buffering_duration_ie : public pfcp_ie {
@@ -3283,29 +3327,253 @@ class pfcp_node_id_ie : public pfcp_ie {
 //      s.set(pfd_contents);
 //  }
 //};
+//-------------------------------------
+// IE MEASUREMENT_METHOD
+class pfcp_measurement_method_ie : public pfcp_ie {
+ public:
+  union {
+    struct {
+      uint8_t durat : 1;
+      uint8_t volum : 1;
+      uint8_t event : 1;
+      uint8_t spare : 5;
+    } bf;
+    uint8_t b;
+  } u1;
+
+  //--------
+  explicit pfcp_measurement_method_ie(const pfcp::measurement_method_t& b)
+      : pfcp_ie(PFCP_IE_MEASUREMENT_METHOD) {
+    u1.b        = 0;
+    u1.bf.durat = b.durat;
+    u1.bf.volum = b.volum;
+    u1.bf.event = b.event;
+    tlv.set_length(1);
+  }
+  //--------
+  pfcp_measurement_method_ie() : pfcp_ie(PFCP_IE_MEASUREMENT_METHOD) {
+    u1.b = 0;
+    tlv.set_length(1);
+  }
+  //--------
+  explicit pfcp_measurement_method_ie(const pfcp_tlv& t) : pfcp_ie(t) {
+    u1.b = 0;
+  };
+  //--------
+  void to_core_type(pfcp::measurement_method_t& b) {
+    b       = {};
+    b.durat = u1.bf.durat;
+    b.volum = u1.bf.volum;
+    b.event = u1.bf.event;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.set_length(1);
+    tlv.dump_to(os);
+    os.write(reinterpret_cast<const char*>(&u1.b), sizeof(u1.b));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != 1) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&u1.b), sizeof(u1.b));
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::measurement_method_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
+//-------------------------------------
+// IE USAGE_REPORT_TRIGGER
+class pfcp_usage_report_trigger_ie : public pfcp_ie {
+ public:
+  union {
+    struct {
+      uint8_t perio : 1;
+      uint8_t volth : 1;
+      uint8_t timth : 1;
+      uint8_t quhti : 1;
+      uint8_t start : 1;
+      uint8_t stop : 1;
+      uint8_t droth : 1;
+      uint8_t immer : 1;
+    } bf;
+    uint8_t b;
+  } u1;
+  union {
+    struct {
+      uint8_t volqu : 1;
+      uint8_t timqu : 1;
+      uint8_t liusa : 1;
+      uint8_t termr : 1;
+      uint8_t monit : 1;
+      uint8_t envcl : 1;
+      uint8_t macar : 1;
+      uint8_t eveth : 1;
+    } bf;
+    uint8_t b;
+  } u2;
+
+  //--------
+  explicit pfcp_usage_report_trigger_ie(const pfcp::usage_report_trigger_t& b)
+      : pfcp_ie(PFCP_IE_USAGE_REPORT_TRIGGER) {
+    u1.b = 0;
+    u2.b = 0;
+    tlv.set_length(2);
+    u1.bf.perio = b.perio;
+    u1.bf.volth = b.volth;
+    u1.bf.timth = b.timth;
+    u1.bf.quhti = b.quhti;
+    u1.bf.start = b.start;
+    u1.bf.stop  = b.stop;
+    u1.bf.droth = b.droth;
+    u1.bf.immer = b.immer;
+
+    u2.bf.volqu = b.volqu;
+    u2.bf.timqu = b.timqu;
+    u2.bf.liusa = b.liusa;
+    u2.bf.termr = b.termr;
+    u2.bf.monit = b.monit;
+    u2.bf.envcl = b.envcl;
+    u2.bf.macar = b.macar;
+    u2.bf.eveth = b.eveth;
+  }
+  //--------
+  pfcp_usage_report_trigger_ie() : pfcp_ie(PFCP_IE_USAGE_REPORT_TRIGGER) {
+    u1.b = 0;
+    u2.b = 0;
+    tlv.set_length(2);
+  }
+  //--------
+  explicit pfcp_usage_report_trigger_ie(const pfcp_tlv& t) : pfcp_ie(t) {
+    u1.b = 0;
+    u2.b = 0;
+  };
+  //--------
+  void to_core_type(pfcp::usage_report_trigger_t& b) {
+    b       = {};
+    b.perio = u1.bf.perio;
+    b.volth = u1.bf.volth;
+    b.timth = u1.bf.timth;
+    b.quhti = u1.bf.quhti;
+    b.start = u1.bf.start;
+    b.stop  = u1.bf.stop;
+    b.droth = u1.bf.droth;
+    b.immer = u1.bf.immer;
+
+    b.volqu = u2.bf.volqu;
+    b.timqu = u2.bf.timqu;
+    b.liusa = u2.bf.liusa;
+    b.termr = u2.bf.termr;
+    b.monit = u2.bf.monit;
+    b.envcl = u2.bf.envcl;
+    b.macar = u2.bf.macar;
+    b.eveth = u2.bf.eveth;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.set_length(2);
+    tlv.dump_to(os);
+    os.write(reinterpret_cast<const char*>(&u1.b), sizeof(u1.b));
+    os.write(reinterpret_cast<const char*>(&u2.b), sizeof(u2.b));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() < 2) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&u1.b), sizeof(u1.b));
+    is.read(reinterpret_cast<char*>(&u2.b), sizeof(u2.b));
+    // Octets added by later releases
+    is.ignore(tlv.get_length() - 2);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::usage_report_trigger_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
+//-------------------------------------
+// IE MEASUREMENT_PERIOD
+class pfcp_measurement_period_ie : public pfcp_ie {
+ public:
+  uint32_t measurement_period;
+
+  //--------
+  explicit pfcp_measurement_period_ie(const pfcp::measurement_period_t& b)
+      : pfcp_ie(PFCP_IE_MEASUREMENT_PERIOD) {
+    measurement_period = b.measurement_period;
+    tlv.set_length(sizeof(measurement_period));
+  }
+  //--------
+  pfcp_measurement_period_ie()
+      : pfcp_ie(PFCP_IE_MEASUREMENT_PERIOD), measurement_period(0) {
+    tlv.set_length(sizeof(measurement_period));
+  }
+  //--------
+  explicit pfcp_measurement_period_ie(const pfcp_tlv& t)
+      : pfcp_ie(t), measurement_period(0){};
+  //--------
+  void to_core_type(pfcp::measurement_period_t& b) {
+    b.measurement_period = measurement_period;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    auto be_measurement_period = htobe32(measurement_period);
+    os.write(
+        reinterpret_cast<const char*>(&be_measurement_period),
+        sizeof(be_measurement_period));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != sizeof(measurement_period)) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(
+        reinterpret_cast<char*>(&measurement_period),
+        sizeof(measurement_period));
+    measurement_period = be32toh(measurement_period);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::measurement_period_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 ////-------------------------------------
-//// IE MEASUREMENT_METHOD
-// class pfcp_measurement_method_ie : public pfcp_ie {
+//// IE FQ_CSID
+// class pfcp_fq_csid_ie : public pfcp_ie {
 // public:
 //  uint8_t todo;
 //
 //  //--------
-//  pfcp_measurement_method_ie(const pfcp::measurement_method_t& b) :
-//  pfcp_ie(PFCP_IE_MEASUREMENT_METHOD){
+//  pfcp_fq_csid_ie(const pfcp::fq_csid_t& b) : pfcp_ie(PFCP_IE_FQ_CSID){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_measurement_method_ie() : pfcp_ie(PFCP_IE_MEASUREMENT_METHOD){
+//  pfcp_fq_csid_ie() : pfcp_ie(PFCP_IE_FQ_CSID){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_measurement_method_ie(const pfcp_tlv& t) : pfcp_ie(t) {
+//  pfcp_fq_csid_ie(const pfcp_tlv& t) : pfcp_ie(t) {
 //    todo = 0;
 //  };
 //  //--------
-//  void to_core_type(pfcp::measurement_method_t& b) {
+//  void to_core_type(pfcp::fq_csid_t& b) {
 //    b.todo = todo;
 //  }
 //  //--------
@@ -3324,240 +3592,181 @@ class pfcp_node_id_ie : public pfcp_ie {
 //  }
 //  //--------
 //  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::measurement_method_t measurement_method = {};
-//      to_core_type(measurement_method);
-//      s.set(measurement_method);
-//  }
-//};
-////-------------------------------------
-//// IE USAGE_REPORT_TRIGGER
-// class pfcp_usage_report_trigger_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_usage_report_trigger_ie(const pfcp::usage_report_trigger_t& b) :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_TRIGGER){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_usage_report_trigger_ie() : pfcp_ie(PFCP_IE_USAGE_REPORT_TRIGGER){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_usage_report_trigger_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::usage_report_trigger_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::usage_report_trigger_t usage_report_trigger = {};
-//      to_core_type(usage_report_trigger);
-//      s.set(usage_report_trigger);
-//  }
-//};
-////-------------------------------------
-//// IE MEASUREMENT_PERIOD
-// class pfcp_measurement_period_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_measurement_period_ie(const pfcp::measurement_period_t& b) :
-//  pfcp_ie(PFCP_IE_MEASUREMENT_PERIOD){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_measurement_period_ie() : pfcp_ie(PFCP_IE_MEASUREMENT_PERIOD){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_measurement_period_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::measurement_period_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::measurement_period_t measurement_period = {};
-//      to_core_type(measurement_period);
-//      s.set(measurement_period);
-//  }
-//};
-////-------------------------------------
-//// IE FQ_CSID
-// class pfcp_fq_csid_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_fq_csid_ie(const pfcp::fq_csid_t& b) : pfcp_ie(PFCP_IE_FQ_CSID){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_fq_csid_ie() : pfcp_ie(PFCP_IE_FQ_CSID){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_fq_csid_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::fq_csid_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::fq_csid_t fq_csid = {};
-//      to_core_type(fq_csid);
-//      s.set(fq_csid);
-//  }
-//};
-////-------------------------------------
-//// IE VOLUME_MEASUREMENT
-// class pfcp_volume_measurement_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_volume_measurement_ie(const pfcp::volume_measurement_t& b) :
-//  pfcp_ie(PFCP_IE_VOLUME_MEASUREMENT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_volume_measurement_ie() : pfcp_ie(PFCP_IE_VOLUME_MEASUREMENT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_volume_measurement_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::volume_measurement_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::volume_measurement_t volume_measurement = {};
-//      to_core_type(volume_measurement);
-//      s.set(volume_measurement);
-//  }
-//};
-////-------------------------------------
-//// IE DURATION_MEASUREMENT
-// class pfcp_duration_measurement_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_duration_measurement_ie(const pfcp::duration_measurement_t& b) :
-//  pfcp_ie(PFCP_IE_DURATION_MEASUREMENT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_duration_measurement_ie() : pfcp_ie(PFCP_IE_DURATION_MEASUREMENT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_duration_measurement_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::duration_measurement_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::duration_measurement_t duration_measurement = {};
-//      to_core_type(duration_measurement);
-//      s.set(duration_measurement);
+//      pfcp::fq_csid_t fq_csid = {};
+//      to_core_type(fq_csid);
+//      s.set(fq_csid);
 //  }
 //};
+//-------------------------------------
+// IE VOLUME_MEASUREMENT
+class pfcp_volume_measurement_ie : public pfcp_ie {
+ public:
+  union {
+    struct {
+      uint8_t tovol : 1;
+      uint8_t ulvol : 1;
+      uint8_t dlvol : 1;
+      uint8_t spare : 5;
+    } bf;
+    uint8_t b;
+  } u1;
+  uint64_t total_volume;
+  uint64_t uplink_volume;
+  uint64_t downlink_volume;
+  //--------
+  explicit pfcp_volume_measurement_ie(const pfcp::volume_measurement_t& b)
+      : pfcp_ie(PFCP_IE_VOLUME_MEASUREMENT) {
+    tlv.set_length(1);
+    u1.b            = 0;
+    u1.bf.tovol     = b.tovol;
+    u1.bf.ulvol     = b.ulvol;
+    u1.bf.dlvol     = b.dlvol;
+    total_volume    = (u1.bf.tovol) ? b.total_volume : 0;
+    uplink_volume   = (u1.bf.ulvol) ? b.uplink_volume : 0;
+    downlink_volume = (u1.bf.dlvol) ? b.downlink_volume : 0;
+  }
+  //--------
+  pfcp_volume_measurement_ie() : pfcp_ie(PFCP_IE_VOLUME_MEASUREMENT) {
+    tlv.set_length(1);
+    u1.b            = 0;
+    total_volume    = 0;
+    uplink_volume   = 0;
+    downlink_volume = 0;
+  }
+  //--------
+  explicit pfcp_volume_measurement_ie(const pfcp_tlv& t) : pfcp_ie(t) {
+    u1.b            = 0;
+    total_volume    = 0;
+    uplink_volume   = 0;
+    downlink_volume = 0;
+  };
+  //--------
+  void to_core_type(pfcp::volume_measurement_t& b) {
+    b                 = {};
+    b.tovol           = u1.bf.tovol;
+    b.ulvol           = u1.bf.ulvol;
+    b.dlvol           = u1.bf.dlvol;
+    b.total_volume    = total_volume;
+    b.uplink_volume   = uplink_volume;
+    b.downlink_volume = downlink_volume;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.set_length(1);
+    if (u1.bf.tovol) {
+      tlv.add_length(sizeof(total_volume));
+    }
+    if (u1.bf.ulvol) {
+      tlv.add_length(sizeof(uplink_volume));
+    }
+    if (u1.bf.dlvol) {
+      tlv.add_length(sizeof(downlink_volume));
+    }
+
+    tlv.dump_to(os);
+    os.write(reinterpret_cast<const char*>(&u1.b), sizeof(u1.b));
+    if (u1.bf.tovol) {
+      auto be_total_volume = htobe64(total_volume);
+      os.write(
+          reinterpret_cast<const char*>(&be_total_volume),
+          sizeof(be_total_volume));
+    }
+    if (u1.bf.ulvol) {
+      auto be_uplink_volume = htobe64(uplink_volume);
+      os.write(
+          reinterpret_cast<const char*>(&be_uplink_volume),
+          sizeof(be_uplink_volume));
+    }
+    if (u1.bf.dlvol) {
+      auto be_downlink_volume = htobe64(downlink_volume);
+      os.write(
+          reinterpret_cast<const char*>(&be_downlink_volume),
+          sizeof(be_downlink_volume));
+    }
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() < 1) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&u1.b), sizeof(u1.b));
+    uint16_t length = 1 + sizeof(uint64_t) * (u1.bf.tovol + u1.bf.ulvol +
+                                              u1.bf.dlvol);
+    if (tlv.get_length() < length) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    if (u1.bf.tovol) {
+      is.read(reinterpret_cast<char*>(&total_volume), sizeof(total_volume));
+      total_volume = be64toh(total_volume);
+    }
+    if (u1.bf.ulvol) {
+      is.read(reinterpret_cast<char*>(&uplink_volume), sizeof(uplink_volume));
+      uplink_volume = be64toh(uplink_volume);
+    }
+    if (u1.bf.dlvol) {
+      is.read(
+          reinterpret_cast<char*>(&downlink_volume), sizeof(downlink_volume));
+      downlink_volume = be64toh(downlink_volume);
+    }
+    // Packet counts of later releases
+    is.ignore(tlv.get_length() - length);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::volume_measurement_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
+//-------------------------------------
+// IE DURATION_MEASUREMENT
+class pfcp_duration_measurement_ie : public pfcp_ie {
+ public:
+  uint32_t duration;
+
+  //--------
+  explicit pfcp_duration_measurement_ie(const pfcp::duration_measurement_t& b)
+      : pfcp_ie(PFCP_IE_DURATION_MEASUREMENT) {
+    duration = b.duration;
+    tlv.set_length(sizeof(duration));
+  }
+  //--------
+  pfcp_duration_measurement_ie()
+      : pfcp_ie(PFCP_IE_DURATION_MEASUREMENT), duration(0) {
+    tlv.set_length(sizeof(duration));
+  }
+  //--------
+  explicit pfcp_duration_measurement_ie(const pfcp_tlv& t)
+      : pfcp_ie(t), duration(0){};
+  //--------
+  void to_core_type(pfcp::duration_measurement_t& b) { b.duration = duration; }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    auto be_duration = htobe32(duration);
+    os.write(
+        reinterpret_cast<const char*>(&be_duration), sizeof(be_duration));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != sizeof(duration)) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&duration), sizeof(duration));
+    duration = be32toh(duration);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::duration_measurement_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 ////-------------------------------------
 //// IE APPLICATION_DETECTION_INFORMATION
 // class pfcp_application_detection_information_ie : public pfcp_ie {
@@ -3885,221 +4094,116 @@ class pfcp_node_id_ie : public pfcp_ie {
 //      s.set(time_quota);
 //  }
 //};
+//-------------------------------------
+// IE START_TIME
+class pfcp_start_time_ie : public pfcp_ie {
+ public:
+  uint32_t start_time;
+
+  //--------
+  explicit pfcp_start_time_ie(const pfcp::start_time_t& b)
+      : pfcp_ie(PFCP_IE_START_TIME) {
+    start_time = b.start_time;
+    tlv.set_length(sizeof(start_time));
+  }
+  //--------
+  pfcp_start_time_ie() : pfcp_ie(PFCP_IE_START_TIME), start_time(0) {
+    tlv.set_length(sizeof(start_time));
+  }
+  //--------
+  explicit pfcp_start_time_ie(const pfcp_tlv& t) : pfcp_ie(t), start_time(0){};
+  //--------
+  void to_core_type(pfcp::start_time_t& b) { b.start_time = start_time; }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    auto be_start_time = htobe32(start_time);
+    os.write(
+        reinterpret_cast<const char*>(&be_start_time), sizeof(be_start_time));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != sizeof(start_time)) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&start_time), sizeof(start_time));
+    start_time = be32toh(start_time);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::start_time_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
+//-------------------------------------
+// IE END_TIME
+class pfcp_end_time_ie : public pfcp_ie {
+ public:
+  uint32_t end_time;
+
+  //--------
+  explicit pfcp_end_time_ie(const pfcp::end_time_t& b)
+      : pfcp_ie(PFCP_IE_END_TIME) {
+    end_time = b.end_time;
+    tlv.set_length(sizeof(end_time));
+  }
+  //--------
+  pfcp_end_time_ie() : pfcp_ie(PFCP_IE_END_TIME), end_time(0) {
+    tlv.set_length(sizeof(end_time));
+  }
+  //--------
+  explicit pfcp_end_time_ie(const pfcp_tlv& t) : pfcp_ie(t), end_time(0){};
+  //--------
+  void to_core_type(pfcp::end_time_t& b) { b.end_time = end_time; }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    auto be_end_time = htobe32(end_time);
+    os.write(
+        reinterpret_cast<const char*>(&be_end_time), sizeof(be_end_time));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != sizeof(end_time)) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&end_time), sizeof(end_time));
+    end_time = be32toh(end_time);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::end_time_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 ////-------------------------------------
-//// IE START_TIME
-// class pfcp_start_time_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_start_time_ie(const pfcp::start_time_t& b) :
-//  pfcp_ie(PFCP_IE_START_TIME){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_start_time_ie() : pfcp_ie(PFCP_IE_START_TIME){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_start_time_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::start_time_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::start_time_t start_time = {};
-//      to_core_type(start_time);
-//      s.set(start_time);
-//  }
-//};
-////-------------------------------------
-//// IE END_TIME
-// class pfcp_end_time_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_end_time_ie(const pfcp::end_time_t& b) : pfcp_ie(PFCP_IE_END_TIME){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_end_time_ie() : pfcp_ie(PFCP_IE_END_TIME){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_end_time_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::end_time_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::end_time_t end_time = {};
-//      to_core_type(end_time);
-//      s.set(end_time);
-//  }
-//};
-////-------------------------------------
-//// IE QUERY_URR
-// class pfcp_query_urr_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_query_urr_ie(const pfcp::query_urr& b) : pfcp_ie(PFCP_IE_QUERY_URR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_query_urr_ie() : pfcp_ie(PFCP_IE_QUERY_URR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_query_urr_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::query_urr& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::query_urr query_urr = {};
-//      to_core_type(query_urr);
-//      s.set(query_urr);
-//  }
-//};
-////-------------------------------------
-//// IE USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE
-// class pfcp_usage_report_within_session_modification_response_ie : public
-// pfcp_ie { public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_usage_report_within_session_modification_response_ie(const
-//  pfcp::usage_report_within_pfcp_session_modification_response& b) :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_usage_report_within_session_modification_response_ie() :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_usage_report_within_session_modification_response_ie(const pfcp_tlv& t)
-//  : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void
-//  to_core_type(pfcp::usage_report_within_pfcp_session_modification_response&
-//  b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::usage_report_within_pfcp_session_modification_response
-//      usage_report_within_session_modification_response = {};
-//      to_core_type(usage_report_within_session_modification_response);
-//      s.set(usage_report_within_session_modification_response);
-//  }
-//};
-////-------------------------------------
-//// IE USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE
-// class pfcp_usage_report_within_session_deletion_response_ie : public pfcp_ie
-// { public:
+//// IE QUERY_URR
+// class pfcp_query_urr_ie : public pfcp_ie {
+// public:
 //  uint8_t todo;
 //
 //  //--------
-//  pfcp_usage_report_within_session_deletion_response_ie(const
-//  pfcp::usage_report_within_pfcp_session_deletion_response& b) :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE){
+//  pfcp_query_urr_ie(const pfcp::query_urr& b) : pfcp_ie(PFCP_IE_QUERY_URR){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_usage_report_within_session_deletion_response_ie() :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE){
+//  pfcp_query_urr_ie() : pfcp_ie(PFCP_IE_QUERY_URR){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_usage_report_within_session_deletion_response_ie(const pfcp_tlv& t) :
-//  pfcp_ie(t) {
+//  pfcp_query_urr_ie(const pfcp_tlv& t) : pfcp_ie(t) {
 //    todo = 0;
 //  };
 //  //--------
-//  void to_core_type(pfcp::usage_report_within_pfcp_session_deletion_response&
-//  b) {
+//  void to_core_type(pfcp::query_urr& b) {
 //    b.todo = todo;
 //  }
 //  //--------
@@ -4118,39 +4222,39 @@ class pfcp_node_id_ie : public pfcp_ie {
 //  }
 //  //--------
 //  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::usage_report_within_pfcp_session_deletion_response
-//      usage_report_within_session_deletion_response = {};
-//      to_core_type(usage_report_within_session_deletion_response);
-//      s.set(usage_report_within_session_deletion_response);
+//      pfcp::query_urr query_urr = {};
+//      to_core_type(query_urr);
+//      s.set(query_urr);
 //  }
 //};
 ////-------------------------------------
-//// IE USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST
-// class pfcp_usage_report_within_session_report_request_ie : public pfcp_ie {
-// public:
+//// IE USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE
+// class pfcp_usage_report_within_session_modification_response_ie : public
+// pfcp_ie { public:
 //  uint8_t todo;
 //
 //  //--------
-//  pfcp_usage_report_within_session_report_request_ie(const
-//  pfcp::usage_report_within_pfcp_session_report_request& b) :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST){
+//  pfcp_usage_report_within_session_modification_response_ie(const
+//  pfcp::usage_report_within_pfcp_session_modification_response& b) :
+//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_usage_report_within_session_report_request_ie() :
-//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST){
+//  pfcp_usage_report_within_session_modification_response_ie() :
+//  pfcp_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_MODIFICATION_RESPONSE){
 //    todo = 0;
 //    tlv.set_length(1);
 //  }
 //  //--------
-//  pfcp_usage_report_within_session_report_request_ie(const pfcp_tlv& t) :
-//  pfcp_ie(t) {
+//  pfcp_usage_report_within_session_modification_response_ie(const pfcp_tlv& t)
+//  : pfcp_ie(t) {
 //    todo = 0;
 //  };
 //  //--------
-//  void to_core_type(pfcp::usage_report_within_pfcp_session_report_request& b)
-//  {
+//  void
+//  to_core_type(pfcp::usage_report_within_pfcp_session_modification_response&
+//  b) {
 //    b.todo = todo;
 //  }
 //  //--------
@@ -4169,10 +4273,10 @@ class pfcp_node_id_ie : public pfcp_ie {
 //  }
 //  //--------
 //  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::usage_report_within_pfcp_session_report_request
-//      usage_report_within_session_report_request = {};
-//      to_core_type(usage_report_within_session_report_request);
-//      s.set(usage_report_within_session_report_request);
+//      pfcp::usage_report_within_pfcp_session_modification_response
+//      usage_report_within_session_modification_response = {};
+//      to_core_type(usage_report_within_session_modification_response);
+//      s.set(usage_report_within_session_modification_response);
 //  }
 //};
 //-------------------------------------
@@ -4199,7 +4303,7 @@ class pfcp_urr_id_ie : public pfcp_ie {
   void dump_to(std::ostream& os) {
     tlv.dump_to(os);
     auto be_urr_id = htobe32(urr_id);
-    os.write(reinterpret_cast<const char*>(&urr_id), sizeof(urr_id));
+    os.write(reinterpret_cast<const char*>(&be_urr_id), sizeof(be_urr_id));
   }
   //--------
   void load_from(std::istream& is) {
@@ -4289,7 +4393,7 @@ class pfcp_downlink_data_report_ie : public pfcp_grouped_ie {
       : pfcp_grouped_ie(t){};
   //--------
   void to_core_type(pfcp::downlink_data_report& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -4435,126 +4539,6 @@ class pfcp_outer_header_creation_ie : public pfcp_ie {
     s.set(outer_header_creation);
   }
 };
-////-------------------------------------
-//// IE CREATE_BAR
-// class pfcp_create_bar_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_create_bar_ie(const pfcp::create_bar& b) : pfcp_ie(PFCP_IE_CREATE_BAR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_create_bar_ie() : pfcp_ie(PFCP_IE_CREATE_BAR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_create_bar_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::create_bar& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::create_bar create_bar = {};
-//      to_core_type(create_bar);
-//      s.set(create_bar);
-//  }
-//};
-////-------------------------------------
-//// IE UPDATE_BAR_WITHIN_SESSION_MODIFICATION_REQUEST
-// class pfcp_update_bar_within_session_modification_request_ie : public
-// pfcp_grouped_ie { public:
-//
-//  //--------
-//  pfcp_update_bar_within_session_modification_request_ie(const
-//  pfcp::update_bar_within_pfcp_session_modification_request& b) :
-//  pfcp_grouped_ie(PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST){
-//    tlv.set_length(0);
-//  }
-//  //--------
-//  pfcp_update_bar_within_session_modification_request_ie() :
-//  pfcp_grouped_ie(PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST){
-//  }
-//  //--------
-//  void to_core_type(pfcp::update_bar_within_pfcp_session_modification_request&
-//  c) {
-//    for (auto sie : ies) {
-//      sie.get()->to_core_type(c);
-//    }
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//    pfcp::update_bar_within_pfcp_session_modification_request i = {};
-//    to_core_type(i);
-//    s.set(i);
-//  }
-//};
-//
-//-------------------------------------
-// IE REMOVE_BAR
-// class pfcp_remove_bar_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_remove_bar_ie(const pfcp::remove_bar& b) : pfcp_ie(PFCP_IE_REMOVE_BAR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_remove_bar_ie() : pfcp_ie(PFCP_IE_REMOVE_BAR){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_remove_bar_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::remove_bar& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::remove_bar remove_bar = {};
-//      to_core_type(remove_bar);
-//      s.set(remove_bar);
-//  }
-//};
 //-------------------------------------
 // IE BAR_ID
 class pfcp_bar_id_ie : public pfcp_ie {
@@ -5402,51 +5386,50 @@ class pfcp_node_report_type_ie : public pfcp_ie {
 //      s.set(v);
 //  }
 //};
-////-------------------------------------
-//// IE UR_SEQN
-// class pfcp_ur_seqn_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_ur_seqn_ie(const pfcp::ur_seqn_t& b) : pfcp_ie(PFCP_IE_UR_SEQN){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_ur_seqn_ie() : pfcp_ie(PFCP_IE_UR_SEQN){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_ur_seqn_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::ur_seqn_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::ur_seqn_t ur_seqn = {};
-//      to_core_type(ur_seqn);
-//      s.set(ur_seqn);
-//  }
-//};
+//-------------------------------------
+// IE UR_SEQN
+class pfcp_ur_seqn_ie : public pfcp_ie {
+ public:
+  uint32_t ur_seqn;
+
+  //--------
+  explicit pfcp_ur_seqn_ie(const pfcp::ur_seqn_t& b)
+      : pfcp_ie(PFCP_IE_UR_SEQN) {
+    ur_seqn = b.ur_seqn;
+    tlv.set_length(sizeof(ur_seqn));
+  }
+  //--------
+  pfcp_ur_seqn_ie() : pfcp_ie(PFCP_IE_UR_SEQN), ur_seqn(0) {
+    tlv.set_length(sizeof(ur_seqn));
+  }
+  //--------
+  explicit pfcp_ur_seqn_ie(const pfcp_tlv& t) : pfcp_ie(t), ur_seqn(0){};
+  //--------
+  void to_core_type(pfcp::ur_seqn_t& b) { b.ur_seqn = ur_seqn; }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    auto be_ur_seqn = htobe32(ur_seqn);
+    os.write(
+        reinterpret_cast<const char*>(&be_ur_seqn), sizeof(be_ur_seqn));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != sizeof(ur_seqn)) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(reinterpret_cast<char*>(&ur_seqn), sizeof(ur_seqn));
+    ur_seqn = be32toh(ur_seqn);
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::ur_seqn_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 ////-------------------------------------
 //// IE UPDATE_DUPLICATING_PARAMETERS
 // class pfcp_update_duplicating_parameters_ie : public pfcp_ie {
@@ -7266,55 +7249,59 @@ class pfcp_qfi_ie : public pfcp_ie {
 //      s.set(ethernet_filter_properties);
 //  }
 //};
-////-------------------------------------
-//// IE SUGGESTED_BUFFERING_PACKETS_COUNT
-// class pfcp_suggested_buffering_packets_count_ie : public pfcp_ie {
-// public:
-//  uint8_t todo;
-//
-//  //--------
-//  pfcp_suggested_buffering_packets_count_ie(const
-//  pfcp::suggested_buffering_packets_count_t& b) :
-//  pfcp_ie(PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_suggested_buffering_packets_count_ie() :
-//  pfcp_ie(PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT){
-//    todo = 0;
-//    tlv.set_length(1);
-//  }
-//  //--------
-//  pfcp_suggested_buffering_packets_count_ie(const pfcp_tlv& t) : pfcp_ie(t) {
-//    todo = 0;
-//  };
-//  //--------
-//  void to_core_type(pfcp::suggested_buffering_packets_count_t& b) {
-//    b.todo = todo;
-//  }
-//  //--------
-//  void dump_to(std::ostream& os) {
-//    tlv.dump_to(os);
-//    os.write(reinterpret_cast<const char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void load_from(std::istream& is) {
-//    //tlv.load_from(is);
-//    if (tlv.get_length() != 1) {
-//      throw pfcp_tlv_bad_length_exception(tlv.type, tlv.get_length(),
-//      __FILE__, __LINE__);
-//    }
-//    is.read(reinterpret_cast<char*>(&todo), sizeof(todo));
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//      pfcp::suggested_buffering_packets_count_t
-//      suggested_buffering_packets_count = {};
-//      to_core_type(suggested_buffering_packets_count);
-//      s.set(suggested_buffering_packets_count);
-//  }
-//};
+//-------------------------------------
+// IE SUGGESTED_BUFFERING_PACKETS_COUNT
+class pfcp_suggested_buffering_packets_count_ie : public pfcp_ie {
+ public:
+  uint8_t packets_count_value;
+
+  //--------
+  explicit pfcp_suggested_buffering_packets_count_ie(
+      const pfcp::suggested_buffering_packets_count_t& b)
+      : pfcp_ie(PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT) {
+    packets_count_value = b.packets_count_value;
+    tlv.set_length(1);
+  }
+  //--------
+  pfcp_suggested_buffering_packets_count_ie()
+      : pfcp_ie(PFCP_IE_SUGGESTED_BUFFERING_PACKETS_COUNT) {
+    packets_count_value = 0;
+    tlv.set_length(1);
+  }
+  //--------
+  explicit pfcp_suggested_buffering_packets_count_ie(const pfcp_tlv& t)
+      : pfcp_ie(t) {
+    packets_count_value = 0;
+  };
+  //--------
+  void to_core_type(pfcp::suggested_buffering_packets_count_t& b) {
+    b.packets_count_value = packets_count_value;
+  }
+  //--------
+  void dump_to(std::ostream& os) {
+    tlv.dump_to(os);
+    os.write(
+        reinterpret_cast<const char*>(&packets_count_value),
+        sizeof(packets_count_value));
+  }
+  //--------
+  void load_from(std::istream& is) {
+    // tlv.load_from(is);
+    if (tlv.get_length() != 1) {
+      throw pfcp_tlv_bad_length_exception(
+          tlv.type, tlv.get_length(), __FILE__, __LINE__);
+    }
+    is.read(
+        reinterpret_cast<char*>(&packets_count_value),
+        sizeof(packets_count_value));
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::suggested_buffering_packets_count_t v = {};
+    to_core_type(v);
+    s.set(v);
+  }
+};
 //-------------------------------------
 // IE USER_ID
 class pfcp_user_id_ie : public pfcp_ie {
@@ -8230,7 +8217,7 @@ class pfcp_pdi_ie : public pfcp_grouped_ie {
   explicit pfcp_pdi_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::pdi& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8296,7 +8283,7 @@ class pfcp_forwarding_parameters_ie : public pfcp_grouped_ie {
       : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::forwarding_parameters& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8324,7 +8311,7 @@ class pfcp_duplicating_parameters_ie : public pfcp_grouped_ie {
       : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::duplicating_parameters& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8370,8 +8357,8 @@ class pfcp_create_pdr_ie : public pfcp_grouped_ie {
       std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
       add_ie(sie);
     }
-    if (b.qer_id.first) {
-      std::shared_ptr<pfcp_qer_id_ie> sie(new pfcp_qer_id_ie(b.qer_id.second));
+    for (auto qer_id : b.qer_ids) {
+      std::shared_ptr<pfcp_qer_id_ie> sie(new pfcp_qer_id_ie(qer_id));
       add_ie(sie);
     }
     if (b.activate_predefined_rules.first) {
@@ -8387,7 +8374,7 @@ class pfcp_create_pdr_ie : public pfcp_grouped_ie {
   explicit pfcp_create_pdr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::create_pdr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8436,7 +8423,7 @@ class pfcp_create_far_ie : public pfcp_grouped_ie {
   explicit pfcp_create_far_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::create_far& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8455,14 +8442,44 @@ class pfcp_create_urr_ie : public pfcp_grouped_ie {
   explicit pfcp_create_urr_ie(const pfcp::create_urr& b)
       : pfcp_grouped_ie(PFCP_IE_CREATE_URR) {
     tlv.set_length(0);
+    if (b.urr_id.first) {
+      std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
+      add_ie(sie);
+    }
+    if (b.measurement_method.first) {
+      std::shared_ptr<pfcp_measurement_method_ie> sie(
+          new pfcp_measurement_method_ie(b.measurement_method.second));
+      add_ie(sie);
+    }
+    if (b.reporting_triggers.first) {
+      std::shared_ptr<pfcp_reporting_triggers_ie> sie(
+          new pfcp_reporting_triggers_ie(b.reporting_triggers.second));
+      add_ie(sie);
+    }
+    if (b.measurement_period.first) {
+      std::shared_ptr<pfcp_measurement_period_ie> sie(
+          new pfcp_measurement_period_ie(b.measurement_period.second));
+      add_ie(sie);
+    }
+    if (b.volume_threshold.first) {
+      std::shared_ptr<pfcp_volume_threshold_ie> sie(
+          new pfcp_volume_threshold_ie(b.volume_threshold.second));
+      add_ie(sie);
+    }
+    if (b.time_threshold.first) {
+      std::shared_ptr<pfcp_time_threshold_ie> sie(
+          new pfcp_time_threshold_ie(b.time_threshold.second));
+      add_ie(sie);
+    }
+    // TODO quotas, subsequent thresholds, linked URRs
   }
   //--------
   pfcp_create_urr_ie() : pfcp_grouped_ie(PFCP_IE_CREATE_URR) {}
   //--------
   explicit pfcp_create_urr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
-  void to_core_type(pfcp::duplicating_parameters& c) {
-    for (auto sie : ies) {
+  void to_core_type(pfcp::create_urr& c) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8481,6 +8498,32 @@ class pfcp_create_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_create_qer_ie(const pfcp::create_qer& b)
       : pfcp_grouped_ie(PFCP_IE_CREATE_QER) {
     tlv.set_length(0);
+    if (b.qer_id.first) {
+      std::shared_ptr<pfcp_qer_id_ie> sie(new pfcp_qer_id_ie(b.qer_id.second));
+      add_ie(sie);
+    }
+    if (b.qer_correlation_id.first) {
+      std::shared_ptr<pfcp_qer_correlation_id_ie> sie(
+          new pfcp_qer_correlation_id_ie(b.qer_correlation_id.second));
+      add_ie(sie);
+    }
+    if (b.gate_status.first) {
+      std::shared_ptr<pfcp_gate_status_ie> sie(
+          new pfcp_gate_status_ie(b.gate_status.second));
+      add_ie(sie);
+    }
+    if (b.maximum_bitrate.first) {
+      std::shared_ptr<pfcp_mbr_ie> sie(
+          new pfcp_mbr_ie(b.maximum_bitrate.second));
+      add_ie(sie);
+    }
+    if (b.guaranteed_bitrate.first) {
+      std::shared_ptr<pfcp_gbr_ie> sie(
+          new pfcp_gbr_ie(b.guaranteed_bitrate.second));
+      add_ie(sie);
+    }
+    // TODO packet_rate, dl_flow_level_marking, qos_flow_identifier,
+    // reflective_qos
   }
   //--------
   pfcp_create_qer_ie() : pfcp_grouped_ie(PFCP_IE_CREATE_QER) {}
@@ -8488,7 +8531,7 @@ class pfcp_create_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_create_qer_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::create_qer& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8523,7 +8566,7 @@ class pfcp_created_pdr_ie : public pfcp_grouped_ie {
   explicit pfcp_created_pdr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::created_pdr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8549,7 +8592,7 @@ class pfcp_update_pdr_ie : public pfcp_grouped_ie {
   explicit pfcp_update_pdr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_pdr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8614,7 +8657,7 @@ class pfcp_update_forwarding_parameters_ie : public pfcp_grouped_ie {
       : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_forwarding_parameters& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8662,7 +8705,7 @@ class pfcp_update_far_ie : public pfcp_grouped_ie {
   explicit pfcp_update_far_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_far& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8695,7 +8738,7 @@ class pfcp_update_bar_within_pfcp_session_report_response_ie
       : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_bar_within_pfcp_session_report_response& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8707,6 +8750,231 @@ class pfcp_update_bar_within_pfcp_session_report_response_ie
   }
 };
 //-------------------------------------
+// IE CREATE_BAR
+class pfcp_create_bar_ie : public pfcp_grouped_ie {
+ public:
+  //--------
+  explicit pfcp_create_bar_ie(const pfcp::create_bar& b)
+      : pfcp_grouped_ie(PFCP_IE_CREATE_BAR) {
+    tlv.set_length(0);
+    if (b.bar_id.first) {
+      std::shared_ptr<pfcp_bar_id_ie> sie(new pfcp_bar_id_ie(b.bar_id.second));
+      add_ie(sie);
+    }
+    if (b.downlink_data_notification_delay.first) {
+      std::shared_ptr<pfcp_downlink_data_notification_delay_ie> sie(
+          new pfcp_downlink_data_notification_delay_ie(
+              b.downlink_data_notification_delay.second));
+      add_ie(sie);
+    }
+    if (b.suggested_buffering_packets_count.first) {
+      std::shared_ptr<pfcp_suggested_buffering_packets_count_ie> sie(
+          new pfcp_suggested_buffering_packets_count_ie(
+              b.suggested_buffering_packets_count.second));
+      add_ie(sie);
+    }
+  }
+  //--------
+  pfcp_create_bar_ie() : pfcp_grouped_ie(PFCP_IE_CREATE_BAR) {}
+  //--------
+  explicit pfcp_create_bar_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
+  //--------
+  void to_core_type(pfcp::create_bar& c) {
+    for (auto& sie : ies) {
+      sie.get()->to_core_type(c);
+    }
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::create_bar i = {};
+    to_core_type(i);
+    s.set(i);
+  }
+};
+//-------------------------------------
+// IE UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST
+class pfcp_update_bar_within_pfcp_session_modification_request_ie
+    : public pfcp_grouped_ie {
+ public:
+  //--------
+  explicit pfcp_update_bar_within_pfcp_session_modification_request_ie(
+      const pfcp::update_bar_within_pfcp_session_modification_request& b)
+      : pfcp_grouped_ie(
+            PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST) {
+    tlv.set_length(0);
+    if (b.bar_id.first) {
+      std::shared_ptr<pfcp_bar_id_ie> sie(new pfcp_bar_id_ie(b.bar_id.second));
+      add_ie(sie);
+    }
+    if (b.downlink_data_notification_delay.first) {
+      std::shared_ptr<pfcp_downlink_data_notification_delay_ie> sie(
+          new pfcp_downlink_data_notification_delay_ie(
+              b.downlink_data_notification_delay.second));
+      add_ie(sie);
+    }
+    if (b.suggested_buffering_packets_count.first) {
+      std::shared_ptr<pfcp_suggested_buffering_packets_count_ie> sie(
+          new pfcp_suggested_buffering_packets_count_ie(
+              b.suggested_buffering_packets_count.second));
+      add_ie(sie);
+    }
+  }
+  //--------
+  pfcp_update_bar_within_pfcp_session_modification_request_ie()
+      : pfcp_grouped_ie(
+            PFCP_IE_UPDATE_BAR_WITHIN_PFCP_SESSION_MODIFICATION_REQUEST) {}
+  //--------
+  explicit pfcp_update_bar_within_pfcp_session_modification_request_ie(
+      const pfcp_tlv& t)
+      : pfcp_grouped_ie(t) {}
+  //--------
+  void to_core_type(
+      pfcp::update_bar_within_pfcp_session_modification_request& c) {
+    for (auto& sie : ies) {
+      sie.get()->to_core_type(c);
+    }
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::update_bar_within_pfcp_session_modification_request i = {};
+    to_core_type(i);
+    s.set(i);
+  }
+};
+//-------------------------------------
+// IE USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE
+class pfcp_usage_report_within_session_deletion_response_ie
+    : public pfcp_grouped_ie {
+ public:
+  //--------
+  explicit pfcp_usage_report_within_session_deletion_response_ie(
+      const pfcp::usage_report_within_pfcp_session_deletion_response& b)
+      : pfcp_grouped_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE) {
+    tlv.set_length(0);
+    if (b.urr_id.first) {
+      std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
+      add_ie(sie);
+    }
+    if (b.ur_seqn.first) {
+      std::shared_ptr<pfcp_ur_seqn_ie> sie(
+          new pfcp_ur_seqn_ie(b.ur_seqn.second));
+      add_ie(sie);
+    }
+    if (b.usage_report_trigger.first) {
+      std::shared_ptr<pfcp_usage_report_trigger_ie> sie(
+          new pfcp_usage_report_trigger_ie(b.usage_report_trigger.second));
+      add_ie(sie);
+    }
+    if (b.start_time.first) {
+      std::shared_ptr<pfcp_start_time_ie> sie(
+          new pfcp_start_time_ie(b.start_time.second));
+      add_ie(sie);
+    }
+    if (b.end_time.first) {
+      std::shared_ptr<pfcp_end_time_ie> sie(
+          new pfcp_end_time_ie(b.end_time.second));
+      add_ie(sie);
+    }
+    if (b.volume_measurement.first) {
+      std::shared_ptr<pfcp_volume_measurement_ie> sie(
+          new pfcp_volume_measurement_ie(b.volume_measurement.second));
+      add_ie(sie);
+    }
+    if (b.duration_measurement.first) {
+      std::shared_ptr<pfcp_duration_measurement_ie> sie(
+          new pfcp_duration_measurement_ie(b.duration_measurement.second));
+      add_ie(sie);
+    }
+    // TODO time of first/last packet, usage information
+  }
+  //--------
+  pfcp_usage_report_within_session_deletion_response_ie()
+      : pfcp_grouped_ie(
+            PFCP_IE_USAGE_REPORT_WITHIN_SESSION_DELETION_RESPONSE) {}
+  //--------
+  explicit pfcp_usage_report_within_session_deletion_response_ie(
+      const pfcp_tlv& t)
+      : pfcp_grouped_ie(t) {}
+  //--------
+  void to_core_type(
+      pfcp::usage_report_within_pfcp_session_deletion_response& c) {
+    for (auto& sie : ies) {
+      sie.get()->to_core_type(c);
+    }
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::usage_report_within_pfcp_session_deletion_response i = {};
+    to_core_type(i);
+    s.set(i);
+  }
+};
+//-------------------------------------
+// IE USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST
+class pfcp_usage_report_within_session_report_request_ie
+    : public pfcp_grouped_ie {
+ public:
+  //--------
+  explicit pfcp_usage_report_within_session_report_request_ie(
+      const pfcp::usage_report_within_pfcp_session_report_request& b)
+      : pfcp_grouped_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST) {
+    tlv.set_length(0);
+    if (b.urr_id.first) {
+      std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
+      add_ie(sie);
+    }
+    if (b.ur_seqn.first) {
+      std::shared_ptr<pfcp_ur_seqn_ie> sie(
+          new pfcp_ur_seqn_ie(b.ur_seqn.second));
+      add_ie(sie);
+    }
+    if (b.usage_report_trigger.first) {
+      std::shared_ptr<pfcp_usage_report_trigger_ie> sie(
+          new pfcp_usage_report_trigger_ie(b.usage_report_trigger.second));
+      add_ie(sie);
+    }
+    if (b.start_time.first) {
+      std::shared_ptr<pfcp_start_time_ie> sie(
+          new pfcp_start_time_ie(b.start_time.second));
+      add_ie(sie);
+    }
+    if (b.end_time.first) {
+      std::shared_ptr<pfcp_end_time_ie> sie(
+          new pfcp_end_time_ie(b.end_time.second));
+      add_ie(sie);
+    }
+    if (b.volume_measurement.first) {
+      std::shared_ptr<pfcp_volume_measurement_ie> sie(
+          new pfcp_volume_measurement_ie(b.volume_measurement.second));
+      add_ie(sie);
+    }
+    if (b.duration_measurement.first) {
+      std::shared_ptr<pfcp_duration_measurement_ie> sie(
+          new pfcp_duration_measurement_ie(b.duration_measurement.second));
+      add_ie(sie);
+    }
+    // TODO time of first/last packet, usage information
+  }
+  //--------
+  pfcp_usage_report_within_session_report_request_ie()
+      : pfcp_grouped_ie(PFCP_IE_USAGE_REPORT_WITHIN_SESSION_REPORT_REQUEST) {}
+  //--------
+  explicit pfcp_usage_report_within_session_report_request_ie(const pfcp_tlv& t)
+      : pfcp_grouped_ie(t) {}
+  //--------
+  void to_core_type(pfcp::usage_report_within_pfcp_session_report_request& c) {
+    for (auto& sie : ies) {
+      sie.get()->to_core_type(c);
+    }
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::usage_report_within_pfcp_session_report_request i = {};
+    to_core_type(i);
+    s.set(i);
+  }
+};
+//-------------------------------------
 // IE UPDATE_URR
 class pfcp_update_urr_ie : public pfcp_grouped_ie {
  public:
@@ -8714,6 +8982,36 @@ class pfcp_update_urr_ie : public pfcp_grouped_ie {
   explicit pfcp_update_urr_ie(const pfcp::update_urr& b)
       : pfcp_grouped_ie(PFCP_IE_UPDATE_URR) {
     tlv.set_length(0);
+    if (b.urr_id.first) {
+      std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
+      add_ie(sie);
+    }
+    if (b.measurement_method.first) {
+      std::shared_ptr<pfcp_measurement_method_ie> sie(
+          new pfcp_measurement_method_ie(b.measurement_method.second));
+      add_ie(sie);
+    }
+    if (b.reporting_triggers.first) {
+      std::shared_ptr<pfcp_reporting_triggers_ie> sie(
+          new pfcp_reporting_triggers_ie(b.reporting_triggers.second));
+      add_ie(sie);
+    }
+    if (b.measurement_period.first) {
+      std::shared_ptr<pfcp_measurement_period_ie> sie(
+          new pfcp_measurement_period_ie(b.measurement_period.second));
+      add_ie(sie);
+    }
+    if (b.volume_threshold.first) {
+      std::shared_ptr<pfcp_volume_threshold_ie> sie(
+          new pfcp_volume_threshold_ie(b.volume_threshold.second));
+      add_ie(sie);
+    }
+    if (b.time_threshold.first) {
+      std::shared_ptr<pfcp_time_threshold_ie> sie(
+          new pfcp_time_threshold_ie(b.time_threshold.second));
+      add_ie(sie);
+    }
+    // TODO quotas, subsequent thresholds, linked URRs
   }
   //--------
   pfcp_update_urr_ie() : pfcp_grouped_ie(PFCP_IE_UPDATE_URR) {}
@@ -8721,7 +9019,7 @@ class pfcp_update_urr_ie : public pfcp_grouped_ie {
   explicit pfcp_update_urr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_urr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8740,6 +9038,32 @@ class pfcp_update_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_update_qer_ie(const pfcp::update_qer& b)
       : pfcp_grouped_ie(PFCP_IE_UPDATE_QER) {
     tlv.set_length(0);
+    if (b.qer_id.first) {
+      std::shared_ptr<pfcp_qer_id_ie> sie(new pfcp_qer_id_ie(b.qer_id.second));
+      add_ie(sie);
+    }
+    if (b.qer_correlation_id.first) {
+      std::shared_ptr<pfcp_qer_correlation_id_ie> sie(
+          new pfcp_qer_correlation_id_ie(b.qer_correlation_id.second));
+      add_ie(sie);
+    }
+    if (b.gate_status.first) {
+      std::shared_ptr<pfcp_gate_status_ie> sie(
+          new pfcp_gate_status_ie(b.gate_status.second));
+      add_ie(sie);
+    }
+    if (b.maximum_bitrate.first) {
+      std::shared_ptr<pfcp_mbr_ie> sie(
+          new pfcp_mbr_ie(b.maximum_bitrate.second));
+      add_ie(sie);
+    }
+    if (b.guaranteed_bitrate.first) {
+      std::shared_ptr<pfcp_gbr_ie> sie(
+          new pfcp_gbr_ie(b.guaranteed_bitrate.second));
+      add_ie(sie);
+    }
+    // TODO packet_rate, dl_flow_level_marking, qos_flow_identifier,
+    // reflective_qos
   }
   //--------
   pfcp_update_qer_ie() : pfcp_grouped_ie(PFCP_IE_UPDATE_QER) {}
@@ -8747,7 +9071,7 @@ class pfcp_update_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_update_qer_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::update_qer& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8776,7 +9100,7 @@ class pfcp_update_qer_ie : public pfcp_grouped_ie {
 //  }
 //  //--------
 //  void to_core_type(pfcp::update_bar& c) {
-//    for (auto sie : ies) {
+//    for (auto& sie : ies) {
 //      sie.get()->to_core_type(c);
 //    }
 //  }
@@ -8806,7 +9130,7 @@ class pfcp_remove_pdr_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_pdr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::remove_pdr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8836,7 +9160,7 @@ class pfcp_remove_far_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_far_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::remove_far& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8855,6 +9179,10 @@ class pfcp_remove_urr_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_urr_ie(const pfcp::remove_urr& b)
       : pfcp_grouped_ie(PFCP_IE_REMOVE_URR) {
     tlv.set_length(0);
+    if (b.urr_id.first) {
+      std::shared_ptr<pfcp_urr_id_ie> sie(new pfcp_urr_id_ie(b.urr_id.second));
+      add_ie(sie);
+    }
   }
   //--------
   pfcp_remove_urr_ie() : pfcp_grouped_ie(PFCP_IE_REMOVE_URR) {}
@@ -8862,7 +9190,7 @@ class pfcp_remove_urr_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_urr_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::remove_urr& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8881,6 +9209,10 @@ class pfcp_remove_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_qer_ie(const pfcp::remove_qer& b)
       : pfcp_grouped_ie(PFCP_IE_REMOVE_QER) {
     tlv.set_length(0);
+    if (b.qer_id.first) {
+      std::shared_ptr<pfcp_qer_id_ie> sie(new pfcp_qer_id_ie(b.qer_id.second));
+      add_ie(sie);
+    }
   }
   //--------
   pfcp_remove_qer_ie() : pfcp_grouped_ie(PFCP_IE_REMOVE_QER) {}
@@ -8888,7 +9220,7 @@ class pfcp_remove_qer_ie : public pfcp_grouped_ie {
   explicit pfcp_remove_qer_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::remove_qer& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
@@ -8900,35 +9232,36 @@ class pfcp_remove_qer_ie : public pfcp_grouped_ie {
   }
 };
 
-////-------------------------------------
-//// IE REMOVE_BAR
-// class pfcp_remove_bar_ie : public pfcp_grouped_ie {
-// public:
-//
-//  //--------
-//  pfcp_remove_bar_ie(const pfcp::remove_bar& b) :
-//  pfcp_grouped_ie(PFCP_IE_REMOVE_BAR){
-//    tlv.set_length(0);
-//  }
-//  //--------
-//  pfcp_remove_bar_ie() : pfcp_grouped_ie(PFCP_IE_REMOVE_BAR){
-//  }
-//  //--------
-//  pfcp_remove_bar_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t){
-//  }
-//  //--------
-//  void to_core_type(pfcp::remove_bar& c) {
-//    for (auto sie : ies) {
-//      sie.get()->to_core_type(c);
-//    }
-//  }
-//  //--------
-//  void to_core_type(pfcp_ies_container& s) {
-//    pfcp::remove_bar i = {};
-//    to_core_type(i);
-//    s.set(i);
-//  }
-//};
+//-------------------------------------
+// IE REMOVE_BAR
+class pfcp_remove_bar_ie : public pfcp_grouped_ie {
+ public:
+  //--------
+  explicit pfcp_remove_bar_ie(const pfcp::remove_bar& b)
+      : pfcp_grouped_ie(PFCP_IE_REMOVE_BAR) {
+    tlv.set_length(0);
+    if (b.bar_id.first) {
+      std::shared_ptr<pfcp_bar_id_ie> sie(new pfcp_bar_id_ie(b.bar_id.second));
+      add_ie(sie);
+    }
+  }
+  //--------
+  pfcp_remove_bar_ie() : pfcp_grouped_ie(PFCP_IE_REMOVE_BAR) {}
+  //--------
+  explicit pfcp_remove_bar_ie(const pfcp_tlv& t) : pfcp_grouped_ie(t) {}
+  //--------
+  void to_core_type(pfcp::remove_bar& c) {
+    for (auto& sie : ies) {
+      sie.get()->to_core_type(c);
+    }
+  }
+  //--------
+  void to_core_type(pfcp_ies_container& s) {
+    pfcp::remove_bar i = {};
+    to_core_type(i);
+    s.set(i);
+  }
+};
 
 //-------------------------------------
 // IE CREATE_TRAFFIC_ENDPOINT
@@ -8948,7 +9281,7 @@ class pfcp_create_traffic_endpoint_ie : public pfcp_grouped_ie {
       : pfcp_grouped_ie(t) {}
   //--------
   void to_core_type(pfcp::create_traffic_endpoint& c) {
-    for (auto sie : ies) {
+    for (auto& sie : ies) {
       sie.get()->to_core_type(c);
     }
   }
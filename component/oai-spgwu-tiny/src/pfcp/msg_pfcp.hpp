@@ -1870,7 +1870,8 @@ class create_pdr : public pfcp::pfcp_ies_container {
   std::pair<bool, pfcp::outer_header_removal_t> outer_header_removal;
   std::pair<bool, pfcp::far_id_t> far_id;
   std::pair<bool, pfcp::urr_id_t> urr_id;
-  std::pair<bool, pfcp::qer_id_t> qer_id;
+  // A PDR may refer to several QERs, e.g. its bearer MBR and the APN-AMBR
+  std::vector<pfcp::qer_id_t> qer_ids;
   std::pair<bool, pfcp::activate_predefined_rules_t> activate_predefined_rules;
 
   create_pdr()
@@ -1880,7 +1881,7 @@ class create_pdr : public pfcp::pfcp_ies_container {
         outer_header_removal(),
         far_id(),
         urr_id(),
-        qer_id(),
+        qer_ids(),
         activate_predefined_rules() {}
 
   create_pdr(const create_pdr& c)
@@ -1890,7 +1891,7 @@ class create_pdr : public pfcp::pfcp_ies_container {
         outer_header_removal(c.outer_header_removal),
         far_id(c.far_id),
         urr_id(c.urr_id),
-        qer_id(c.qer_id),
+        qer_ids(c.qer_ids),
         activate_predefined_rules(c.activate_predefined_rules) {}
 
   // virtual ~create_pdr() {};
@@ -1918,10 +1919,7 @@ class create_pdr : public pfcp::pfcp_ies_container {
     urr_id.first  = true;
     urr_id.second = v;
   }
-  void set(const pfcp::qer_id_t& v) {
-    qer_id.first  = true;
-    qer_id.second = v;
-  }
+  void set(const pfcp::qer_id_t& v) { qer_ids.push_back(v); }
   void set(const pfcp::activate_predefined_rules_t& v) {
     activate_predefined_rules.first  = true;
     activate_predefined_rules.second = v;
@@ -1969,9 +1967,10 @@ class create_pdr : public pfcp::pfcp_ies_container {
     }
     return false;
   }
+  // First QER ID
   bool get(pfcp::qer_id_t& v) const {
-    if (qer_id.first) {
-      v = qer_id.second;
+    if (qer_ids.size()) {
+      v = qer_ids[0];
       return true;
     }
     return false;
@@ -3486,7 +3485,8 @@ class update_pdr : public pfcp::pfcp_ies_container {
   std::pair<bool, pfcp::pdi> pdi;
   std::pair<bool, pfcp::far_id_t> far_id;
   std::pair<bool, pfcp::urr_id_t> urr_id;
-  std::pair<bool, pfcp::qer_id_t> qer_id;
+  // A PDR may refer to several QERs, e.g. its bearer MBR and the APN-AMBR
+  std::vector<pfcp::qer_id_t> qer_ids;
   std::vector<pfcp::activate_predefined_rules_t> activate_predefined_rules;
   std::vector<pfcp::deactivate_predefined_rules_t> deactivate_predefined_rules;
 
@@ -3497,7 +3497,7 @@ class update_pdr : public pfcp::pfcp_ies_container {
         pdi(),
         far_id(),
         urr_id(),
-        qer_id(),
+        qer_ids(),
         activate_predefined_rules(),
         deactivate_predefined_rules() {}
 
@@ -3508,7 +3508,7 @@ class update_pdr : public pfcp::pfcp_ies_container {
         pdi(u.pdi),
         far_id(u.far_id),
         urr_id(u.urr_id),
-        qer_id(u.qer_id),
+        qer_ids(u.qer_ids),
         activate_predefined_rules(u.activate_predefined_rules),
         deactivate_predefined_rules(u.deactivate_predefined_rules) {}
 
@@ -3534,10 +3534,7 @@ class update_pdr : public pfcp::pfcp_ies_container {
     urr_id.first  = true;
     urr_id.second = v;
   }
-  void set(const pfcp::qer_id_t& v) {
-    qer_id.first  = true;
-    qer_id.second = v;
-  }
+  void set(const pfcp::qer_id_t& v) { qer_ids.push_back(v); }
   void set(const pfcp::activate_predefined_rules_t& v) {
     activate_predefined_rules.push_back(v);
   }
@@ -3584,9 +3581,10 @@ class update_pdr : public pfcp::pfcp_ies_container {
     }
     return false;
   }
+  // First QER ID
   bool get(pfcp::qer_id_t& v) const {
-    if (qer_id.first) {
-      v = qer_id.second;
+    if (qer_ids.size()) {
+      v = qer_ids[0];
       return true;
     }
     return false;
@@ -7121,11 +7119,16 @@ class pfcp_session_deletion_response : public pfcp_ies_container {
 
   std::pair<bool, pfcp::cause_t> cause;
   std::pair<bool, pfcp::offending_ie_t> offending_ie;
+  std::vector<pfcp::usage_report_within_pfcp_session_deletion_response>
+      usage_reports;
 
-  pfcp_session_deletion_response() : cause(), offending_ie() {}
+  pfcp_session_deletion_response()
+      : cause(), offending_ie(), usage_reports() {}
 
   pfcp_session_deletion_response(const pfcp_session_deletion_response& i)
-      : cause(i.cause), offending_ie(i.offending_ie) {}
+      : cause(i.cause),
+        offending_ie(i.offending_ie),
+        usage_reports(i.usage_reports) {}
 
   const char* get_msg_name() const { return "PFCP_SESSION_DELETION_RESPONSE"; };
 
@@ -7152,6 +7155,9 @@ class pfcp_session_deletion_response : public pfcp_ies_container {
     offending_ie.first  = true;
     offending_ie.second = v;
   }
+  void set(const pfcp::usage_report_within_pfcp_session_deletion_response& v) {
+    usage_reports.push_back(v);
+  }
 };
 //------------------------------------------------------------------------------
 class pfcp_session_report_request : public pfcp_ies_container {
@@ -31,11 +31,12 @@
 #include "3gpp_29.274.h"
 #include "3gpp_29.244.hpp"
 #include "itti.hpp"
+#include "transaction_table.hpp"
 #include "udp.hpp"
 #include "uint_generator.hpp"
 
+#include <atomic>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -50,8 +51,6 @@ class pfcp_procedure {
  public:
   std::shared_ptr<pfcp_msg> retry_msg;
   endpoint remote_endpoint;
-  timer_id_t retry_timer_id;
-  timer_id_t proc_cleanup_timer_id;
   uint64_t trxn_id;
   uint8_t initial_msg_type;    // sent or received
   uint8_t triggered_msg_type;  // sent or received
@@ -60,8 +59,6 @@ class pfcp_procedure {
   pfcp_procedure()
       : retry_msg(),
         remote_endpoint(),
-        retry_timer_id(0),
-        proc_cleanup_timer_id(0),
         trxn_id(0),
         initial_msg_type(0),
         triggered_msg_type(0),
@@ -70,8 +67,6 @@ class pfcp_procedure {
   pfcp_procedure(const pfcp_procedure& p)
       : retry_msg(p.retry_msg),
         remote_endpoint(p.remote_endpoint),
-        retry_timer_id(p.retry_timer_id),
-        proc_cleanup_timer_id(p.proc_cleanup_timer_id),
         trxn_id(p.trxn_id),
         initial_msg_type(p.initial_msg_type),
         triggered_msg_type(p.triggered_msg_type),
@@ -85,20 +80,20 @@ class pfcp_l4_stack : public udp_application {
 #define PFCP_N1_REQUESTS 3
 #define PFCP_PROC_TIME_OUT_MS                                                  \
   ((PFCP_T1_RESPONSE_MS) * (PFCP_N1_REQUESTS + 1 + 1))
+// Header and IEs, the message length field is 16 bits
+#define PFCP_MSG_MAX_SIZE (4 + 65535)
 
  protected:
   uint32_t id;
   udp_server udp_s_8805;
   udp_server udp_s_allocated;
 
-  // seems no need for std::atomic_uint32_t
-  uint32_t seq_num;
+  // Taken by the ITTI tasks and the UDP receive threads
+  std::atomic<uint32_t> seq_num;
   uint32_t restart_counter;
 
-  std::map<uint64_t, uint32_t> trxn_id2seq_num;
-  std::map<timer_id_t, uint32_t> proc_cleanup_timers;
-  std::map<timer_id_t, uint32_t> msg_out_retry_timers;
-  std::map<uint32_t, pfcp_procedure> pending_procedures;
+  // Pending procedures by sequence number, their T1 and cleanup timers
+  util::transaction_table<pfcp_procedure> transactions;
 
   static const char* msg_type2cstr[256];
 
@@ -111,16 +106,9 @@ class pfcp_l4_stack : public udp_application {
   static bool check_request_type(const uint8_t initial);
   static bool check_response_type(
       const uint8_t initial, const uint8_t triggered);
-  void start_proc_cleanup_timer(
-      pfcp_procedure& p, uint32_t time_out_milli_seconds,
-      const task_id_t& task_id, const uint32_t& seq_num);
-  void start_msg_retry_timer(
-      pfcp_procedure& p, uint32_t time_out_milli_seconds,
-      const task_id_t& task_id, const uint32_t& seq_num);
-  void stop_msg_retry_timer(pfcp_procedure& p);
-  void stop_msg_retry_timer(timer_id_t& t);
-  void stop_proc_cleanup_timer(pfcp_procedure& p);
   void notify_ul_error(const pfcp_procedure& p, const ::cause_value_e cause);
+  // Encode msg without intermediate string and send it
+  void send_msg(udp_server& udp_s, pfcp_msg& msg, const endpoint& dest);
 
  public:
   static const uint8_t version = 2;
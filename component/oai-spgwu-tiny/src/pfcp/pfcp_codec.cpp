@@ -0,0 +1,99 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_codec.cpp
+  \brief
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_codec.hpp"
+
+#include <memory>
+#include <new>
+
+using namespace pfcp;
+
+thread_local pfcp_arena* pfcp_arena::current_ = nullptr;
+
+//------------------------------------------------------------------------------
+pfcp_arena::pfcp_arena()
+    : buffer_(new char[PFCP_ARENA_SIZE]), used_(0), live_(1) {}
+//------------------------------------------------------------------------------
+pfcp_arena::~pfcp_arena() {
+  delete[] buffer_;
+}
+//------------------------------------------------------------------------------
+void pfcp_arena::release() noexcept {
+  if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+//------------------------------------------------------------------------------
+pfcp_arena& pfcp_arena::get_thread_instance() {
+  // Released when the thread exits, blocks still referring to the arena, e.g.
+  // a message passed to another thread, keep it until they are released
+  static thread_local std::unique_ptr<pfcp_arena, void (*)(pfcp_arena*)>
+      arena(new pfcp_arena(), [](pfcp_arena* a) { a->release(); });
+  return *arena;
+}
+//------------------------------------------------------------------------------
+void* pfcp_arena::allocate(const std::size_t size) {
+  const std::size_t total =
+      sizeof(block_header_t) + ((size + alignof(block_header_t) - 1) &
+                                ~(alignof(block_header_t) - 1));
+  block_header_t* h = nullptr;
+  pfcp_arena* a     = current_;
+  if (a) {
+    if (a->live_.load(std::memory_order_acquire) == 1) {
+      a->used_ = 0;
+    }
+    if (a->used_ + total <= PFCP_ARENA_SIZE) {
+      h = reinterpret_cast<block_header_t*>(a->buffer_ + a->used_);
+      a->used_ += total;
+      a->live_.fetch_add(1, std::memory_order_relaxed);
+      h->arena = a;
+      return h + 1;
+    }
+  }
+  h        = static_cast<block_header_t*>(::operator new(total));
+  h->arena = nullptr;
+  return h + 1;
+}
+//------------------------------------------------------------------------------
+void pfcp_arena::deallocate(void* p) noexcept {
+  if (not p) return;
+  block_header_t* h = static_cast<block_header_t*>(p) - 1;
+  if (h->arena) {
+    h->arena->release();
+  } else {
+    ::operator delete(h);
+  }
+}
+//------------------------------------------------------------------------------
+pfcp_arena::scope::scope() : previous_(current_) {
+  current_ = &get_thread_instance();
+}
+//------------------------------------------------------------------------------
+pfcp_arena::scope::~scope() {
+  current_ = previous_;
+}
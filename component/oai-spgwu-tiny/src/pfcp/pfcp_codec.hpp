@@ -0,0 +1,138 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_codec.hpp
+  \brief Memory and buffers of the PFCP message codec
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+#ifndef FILE_PFCP_CODEC_HPP_SEEN
+#define FILE_PFCP_CODEC_HPP_SEEN
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+
+namespace pfcp {
+
+// A decoded session establishment request is a tree of a few hundred IE
+// objects living for the duration of handle_receive(), they are taken from a
+// per thread arena instead of the heap.
+#define PFCP_ARENA_SIZE (256 * 1024)
+
+class pfcp_arena {
+ private:
+  // Prepended to every block, arena or heap, so that a block can be released
+  // by any thread without knowing where it comes from
+  typedef struct alignas(16) block_header_s {
+    pfcp_arena* arena;
+  } block_header_t;
+
+  char* buffer_;
+  // Only touched by the thread owning the arena
+  std::size_t used_;
+  // Blocks not released yet plus one held by the owning thread until it
+  // exits. The arena restarts from its beginning once only the thread holds
+  // it, and is freed by the last release.
+  std::atomic<std::size_t> live_;
+
+  // Arena of this thread if a scope is alive, else nullptr (heap)
+  static thread_local pfcp_arena* current_;
+
+  pfcp_arena();
+  ~pfcp_arena();
+  void release() noexcept;
+  static pfcp_arena& get_thread_instance();
+
+ public:
+  pfcp_arena(const pfcp_arena&) = delete;
+  void operator=(const pfcp_arena&) = delete;
+
+  // Fall back on the heap if no scope is alive or if the arena is full
+  static void* allocate(const std::size_t size);
+  static void deallocate(void* p) noexcept;
+
+  // While a scope is alive, the IEs created by this thread and their
+  // containers are taken from its arena. They may outlive the scope.
+  class scope {
+   private:
+    pfcp_arena* previous_;
+
+   public:
+    scope();
+    ~scope();
+    scope(const scope&) = delete;
+    void operator=(const scope&) = delete;
+  };
+};
+
+// For the containers of IEs and the control blocks of their shared_ptr
+template <class T>
+class pfcp_arena_allocator {
+ public:
+  typedef T value_type;
+
+  pfcp_arena_allocator() noexcept {}
+  template <class U>
+  pfcp_arena_allocator(const pfcp_arena_allocator<U>&) noexcept {}
+
+  T* allocate(const std::size_t n) {
+    return static_cast<T*>(pfcp_arena::allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, const std::size_t) noexcept {
+    pfcp_arena::deallocate(p);
+  }
+};
+template <class T, class U>
+bool operator==(
+    const pfcp_arena_allocator<T>&, const pfcp_arena_allocator<U>&) {
+  return true;
+}
+template <class T, class U>
+bool operator!=(
+    const pfcp_arena_allocator<T>&, const pfcp_arena_allocator<U>&) {
+  return false;
+}
+
+// Read a received message in place
+class span_istreambuf : public std::streambuf {
+ public:
+  span_istreambuf(const char* buffer, const std::size_t size) {
+    char* b = const_cast<char*>(buffer);
+    setg(b, b, b + size);
+  }
+};
+
+// Write a message in a buffer supplied by the caller, the stream goes bad
+// instead of growing the buffer
+class span_ostreambuf : public std::streambuf {
+ public:
+  span_ostreambuf(char* buffer, const std::size_t size) {
+    setp(buffer, buffer + size);
+  }
+  std::size_t size() const { return pptr() - pbase(); }
+};
+
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_CODEC_HPP_SEEN */
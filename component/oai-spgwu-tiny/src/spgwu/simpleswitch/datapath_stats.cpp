@@ -0,0 +1,230 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file datapath_stats.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "datapath_stats.hpp"
+#include "logger.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace spgwu;
+
+thread_local uint64_t datapath_stats::read_tsc_ = 0;
+
+static const char* const direction_names[DATAPATH_DIRECTIONS] = {"ul", "dl"};
+static const char* const drop_names[DATAPATH_DROP_REASONS]    = {
+    "unknown_teid", "unknown_ue_ip", "pdr_miss",  "far_drop",
+    "qer",          "queue_full",    "malformed", "no_outer_header"};
+// Reported quantiles of the latency summaries
+static const double latency_quantiles[] = {0.5, 0.99, 0.999};
+
+//------------------------------------------------------------------------------
+datapath_stats::datapath_stats() : others_() {
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    workers_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+//------------------------------------------------------------------------------
+datapath_worker_stats_t* datapath_stats::create_worker(const int id) {
+  // Zeroed, never freed: a reader id is not reused by another thread while
+  // the process runs
+  datapath_worker_stats_t* w = new datapath_worker_stats_t();
+  workers_[id].store(w, std::memory_order_release);
+  Logger::pfcp_switch().info("Packet worker %d counters allocated", id);
+  return w;
+}
+//------------------------------------------------------------------------------
+void datapath_stats::read_latency(
+    const int dir, util::latency_histogram& latency) const {
+  std::unique_ptr<uint64_t[]> buckets(new uint64_t[LATENCY_HISTOGRAM_BUCKETS]);
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    const datapath_worker_stats_t* w =
+        workers_[i].load(std::memory_order_acquire);
+    if (not w) continue;
+    const datapath_latency_t& l = w->latency[dir];
+    for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+      buckets[b] = l.buckets[b].load(std::memory_order_relaxed);
+    }
+    latency.merge(
+        buckets.get(), l.sum.load(std::memory_order_relaxed),
+        l.max.load(std::memory_order_relaxed));
+  }
+}
+//------------------------------------------------------------------------------
+void datapath_stats::read_forwarded(
+    uint64_t packets[DATAPATH_DIRECTIONS],
+    uint64_t bytes[DATAPATH_DIRECTIONS]) const {
+  for (int d = 0; d < DATAPATH_DIRECTIONS; d++) {
+    packets[d] = others_.tx_packets[d].load(std::memory_order_relaxed);
+    bytes[d]   = others_.tx_bytes[d].load(std::memory_order_relaxed);
+  }
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    const datapath_worker_stats_t* w =
+        workers_[i].load(std::memory_order_acquire);
+    if (not w) continue;
+    for (int d = 0; d < DATAPATH_DIRECTIONS; d++) {
+      packets[d] += w->counters.tx_packets[d].load(std::memory_order_relaxed);
+      bytes[d] += w->counters.tx_bytes[d].load(std::memory_order_relaxed);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+static void append_family(
+    std::string& text, const std::string& family, const char* type,
+    const char* help) {
+  text += fmt::format(
+      "# HELP {} {}\n# TYPE {} {}\n", family, help, family, type);
+}
+//------------------------------------------------------------------------------
+std::string datapath_stats::to_prometheus(
+    const std::vector<datapath_metric_t>& metrics) const {
+  // Counters of each worker, "other" for the threads that are not workers
+  std::vector<std::pair<std::string, const datapath_counters_t*>> slots = {};
+  for (int i = 0; i < QSBR_MAX_READERS; i++) {
+    const datapath_worker_stats_t* w =
+        workers_[i].load(std::memory_order_acquire);
+    if (w) slots.push_back(std::make_pair(std::to_string(i), &w->counters));
+  }
+  slots.push_back(std::make_pair(std::string("other"), &others_));
+
+  typedef std::atomic<uint64_t> per_direction_t[DATAPATH_DIRECTIONS];
+  struct {
+    const char* family;
+    const char* help;
+    per_direction_t datapath_counters_t::*values;
+  } const per_direction[] = {
+      {"spgwu_datapath_rx_packets_total", "Packets read",
+       &datapath_counters_t::rx_packets},
+      {"spgwu_datapath_rx_bytes_total", "IP bytes read",
+       &datapath_counters_t::rx_bytes},
+      {"spgwu_datapath_tx_packets_total", "Packets forwarded",
+       &datapath_counters_t::tx_packets},
+      {"spgwu_datapath_tx_bytes_total", "IP bytes forwarded",
+       &datapath_counters_t::tx_bytes},
+  };
+
+  std::string text = {};
+  for (const auto& f : per_direction) {
+    append_family(text, f.family, "counter", f.help);
+    for (const auto& s : slots) {
+      for (int d = 0; d < DATAPATH_DIRECTIONS; d++) {
+        text += fmt::format(
+            "{}{{worker=\"{}\",direction=\"{}\"}} {}\n", f.family, s.first,
+            direction_names[d],
+            (s.second->*f.values)[d].load(std::memory_order_relaxed));
+      }
+    }
+  }
+  append_family(
+      text, "spgwu_datapath_drops_total", "counter", "Packets dropped");
+  for (const auto& s : slots) {
+    for (int r = 0; r < DATAPATH_DROP_REASONS; r++) {
+      text += fmt::format(
+          "spgwu_datapath_drops_total{{worker=\"{}\",reason=\"{}\"}} {}\n",
+          s.first, drop_names[r],
+          s.second->drops[r].load(std::memory_order_relaxed));
+    }
+  }
+
+  const double hz = (double) util::tsc::hz();
+  append_family(
+      text, "spgwu_datapath_latency_seconds", "summary",
+      "Read to forward latency of the packet workers");
+  util::latency_histogram latency[DATAPATH_DIRECTIONS];
+  for (int d = 0; d < DATAPATH_DIRECTIONS; d++) {
+    read_latency(d, latency[d]);
+    for (auto q : latency_quantiles) {
+      text += fmt::format(
+          "spgwu_datapath_latency_seconds{{direction=\"{}\",quantile=\"{}\"}} "
+          "{:.9f}\n",
+          direction_names[d], q, latency[d].percentile(q * 100) / hz);
+    }
+    text += fmt::format(
+        "spgwu_datapath_latency_seconds_sum{{direction=\"{}\"}} {:.9f}\n",
+        direction_names[d], latency[d].sum() / hz);
+    text += fmt::format(
+        "spgwu_datapath_latency_seconds_count{{direction=\"{}\"}} {}\n",
+        direction_names[d], latency[d].count());
+  }
+  append_family(
+      text, "spgwu_datapath_latency_max_seconds", "gauge",
+      "Highest read to forward latency since the start");
+  for (int d = 0; d < DATAPATH_DIRECTIONS; d++) {
+    text += fmt::format(
+        "spgwu_datapath_latency_max_seconds{{direction=\"{}\"}} {:.9f}\n",
+        direction_names[d], latency[d].max() / hz);
+  }
+
+  const std::string* family = nullptr;
+  for (const auto& m : metrics) {
+    if ((not family) || (*family != m.family)) {
+      append_family(text, m.family, m.type, m.help);
+      family = &m.family;
+    }
+    if (m.labels.empty()) {
+      text += fmt::format("{} {}\n", m.family, m.value);
+    } else {
+      text += fmt::format("{}{{{}}} {}\n", m.family, m.labels, m.value);
+    }
+  }
+  return text;
+}
+//------------------------------------------------------------------------------
+bool datapath_stats::write_file(
+    const std::string& path, const std::string& text) {
+  const std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    Logger::pfcp_switch().error(
+        "Could not open %s (%s)", tmp_path.c_str(), strerror(errno));
+    return false;
+  }
+  std::size_t written = 0;
+  while (written < text.size()) {
+    ssize_t n = write(fd, text.data() + written, text.size() - written);
+    if ((n < 0) && (errno == EINTR)) continue;
+    if (n <= 0) {
+      Logger::pfcp_switch().error(
+          "Could not write %s (%s)", tmp_path.c_str(), strerror(errno));
+      close(fd);
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    written += n;
+  }
+  close(fd);
+  if (rename(tmp_path.c_str(), path.c_str()) < 0) {
+    Logger::pfcp_switch().error(
+        "Could not rename %s (%s)", tmp_path.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
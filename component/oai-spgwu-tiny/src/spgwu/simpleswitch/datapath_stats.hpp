@@ -0,0 +1,207 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file datapath_stats.hpp
+  \brief Always-on counters and latency histograms of the packet workers
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_DATAPATH_STATS_HPP_SEEN
+#define FILE_DATAPATH_STATS_HPP_SEEN
+
+#include "latency_histogram.hpp"
+#include "qsbr.hpp"
+#include "tsc.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spgwu {
+
+#define DATAPATH_STATS_CACHE_LINE_SIZE 64
+
+// Directions, UL: read on S1-U, forwarded to the TUN; DL: read on SGi,
+// forwarded to S1-U
+#define DATAPATH_UL 0
+#define DATAPATH_DL 1
+#define DATAPATH_DIRECTIONS 2
+
+typedef enum datapath_drop_e {
+  // G-PDU on a TEID of no session
+  DATAPATH_DROP_UNKNOWN_TEID = 0,
+  // SGi packet to an address of no session
+  DATAPATH_DROP_UNKNOWN_UE_IP,
+  // Session found, none of its PDRs matches
+  DATAPATH_DROP_PDR_MISS,
+  // The FAR of the matching PDR drops
+  DATAPATH_DROP_FAR_DROP,
+  // Gate closed or MBR exceeded
+  DATAPATH_DROP_QER,
+  // TUN queue full (write failed)
+  DATAPATH_DROP_QUEUE_FULL,
+  // Neither IPv4 nor IPv6
+  DATAPATH_DROP_MALFORMED,
+  // FAR forwards to access without a GTP-U outer header
+  DATAPATH_DROP_NO_OUTER_HEADER,
+  DATAPATH_DROP_REASONS
+} datapath_drop_t;
+
+// Written by one packet worker only, with plain loads and stores
+typedef struct alignas(DATAPATH_STATS_CACHE_LINE_SIZE) datapath_counters_s {
+  std::atomic<uint64_t> rx_packets[DATAPATH_DIRECTIONS];
+  std::atomic<uint64_t> rx_bytes[DATAPATH_DIRECTIONS];
+  std::atomic<uint64_t> tx_packets[DATAPATH_DIRECTIONS];
+  std::atomic<uint64_t> tx_bytes[DATAPATH_DIRECTIONS];
+  std::atomic<uint64_t> drops[DATAPATH_DROP_REASONS];
+} datapath_counters_t;
+
+// Read to forward latency of one direction, in TSC ticks, the buckets are
+// those of util::latency_histogram
+typedef struct datapath_latency_s {
+  std::atomic<uint64_t> buckets[LATENCY_HISTOGRAM_BUCKETS];
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> max;
+} datapath_latency_t;
+
+typedef struct datapath_worker_stats_s {
+  datapath_counters_t counters;
+  datapath_latency_t latency[DATAPATH_DIRECTIONS];
+} datapath_worker_stats_t;
+
+// A value of the control path exported with the packet path statistics
+typedef struct datapath_metric_s {
+  std::string family;
+  // Prometheus labels, e.g. table="ue_ipv4", may be empty
+  std::string labels;
+  // "counter" or "gauge"
+  const char* type;
+  const char* help;
+  double value;
+} datapath_metric_t;
+
+// The packet workers are the threads registered in util::qsbr, each one
+// counts in its own slot, allocated by the worker on its first packet. Other
+// threads share one slot with atomic additions and have no latency samples.
+// The latency of a packet goes from its read (received()) to its hand-off to
+// the TUN or to the S1-U TX batch (forwarded()), both time stamped with the
+// TSC. Any thread can read the statistics while the workers run.
+class datapath_stats {
+ private:
+  std::atomic<datapath_worker_stats_t*> workers_[QSBR_MAX_READERS];
+  datapath_counters_t others_;
+
+  // Read time stamp of the packet being switched by the calling thread
+  static thread_local uint64_t read_tsc_;
+
+  datapath_stats();
+  datapath_worker_stats_t* create_worker(const int id);
+
+  datapath_worker_stats_t* worker() {
+    const int id = util::qsbr::reader_id();
+    if (id < 0) return nullptr;
+    datapath_worker_stats_t* w = workers_[id].load(std::memory_order_relaxed);
+    return (w) ? w : create_worker(id);
+  }
+
+  static inline void add(std::atomic<uint64_t>& c, const uint64_t n) {
+    c.store(
+        c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+ public:
+  static datapath_stats& get_instance() {
+    static datapath_stats instance;
+    return instance;
+  }
+  datapath_stats(datapath_stats const&) = delete;
+  void operator=(datapath_stats const&) = delete;
+
+  // Packet workers: a packet was read on S1-U (UL) or SGi (DL), its
+  // switching starts
+  void received(const int dir, const std::size_t num_bytes) {
+    read_tsc_                  = util::tsc::now();
+    datapath_worker_stats_t* w = worker();
+    if (w) {
+      add(w->counters.rx_packets[dir], 1);
+      add(w->counters.rx_bytes[dir], num_bytes);
+    } else {
+      others_.rx_packets[dir].fetch_add(1, std::memory_order_relaxed);
+      others_.rx_bytes[dir].fetch_add(num_bytes, std::memory_order_relaxed);
+    }
+  }
+
+  // Packet workers: the packet was handed to the TUN (UL) or to the S1-U TX
+  // batch (DL)
+  void forwarded(const int dir, const std::size_t num_bytes) {
+    datapath_worker_stats_t* w = worker();
+    if (not w) {
+      others_.tx_packets[dir].fetch_add(1, std::memory_order_relaxed);
+      others_.tx_bytes[dir].fetch_add(num_bytes, std::memory_order_relaxed);
+      return;
+    }
+    add(w->counters.tx_packets[dir], 1);
+    add(w->counters.tx_bytes[dir], num_bytes);
+    if (read_tsc_) {
+      const uint64_t ticks  = util::tsc::now() - read_tsc_;
+      datapath_latency_t& l = w->latency[dir];
+      add(l.buckets[util::latency_histogram::bucket(ticks)], 1);
+      add(l.sum, ticks);
+      if (ticks > l.max.load(std::memory_order_relaxed)) {
+        l.max.store(ticks, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void dropped(const datapath_drop_t reason) {
+    datapath_worker_stats_t* w = worker();
+    if (w) {
+      add(w->counters.drops[reason], 1);
+    } else {
+      others_.drops[reason].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Any thread: read to forward latency of all the workers, in TSC ticks
+  void read_latency(const int dir, util::latency_histogram& latency) const;
+  // Any thread: packets and IP bytes forwarded by all the threads, per
+  // direction
+  void read_forwarded(
+      uint64_t packets[DATAPATH_DIRECTIONS],
+      uint64_t bytes[DATAPATH_DIRECTIONS]) const;
+
+  // Any thread: the counters of each worker and the latency of each
+  // direction, followed by the metrics of the control path, in the
+  // Prometheus text exposition format
+  std::string to_prometheus(
+      const std::vector<datapath_metric_t>& metrics) const;
+  // Written to a temporary file first, then renamed, so that a scraper never
+  // reads a partial file
+  static bool write_file(const std::string& path, const std::string& text);
+};
+
+}  // namespace spgwu
+
+#endif /* FILE_DATAPATH_STATS_HPP_SEEN */
@@ -0,0 +1,289 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+
+/*! \file gtp_mod_kernel.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "gtp_mod_kernel.hpp"
+#include "logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <inttypes.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if ENABLE_LIBGTPNL
+extern "C" {
+#include <libgtpnl/gtp.h>
+#include <libgtpnl/gtpnl.h>
+}
+#include <libmnl/libmnl.h>
+#endif
+
+using namespace spgwu;
+
+//------------------------------------------------------------------------------
+static uint64_t read_device_counter(
+    const std::string& devname, const char* const counter) {
+  std::ifstream f(
+      fmt::format("/sys/class/net/{}/statistics/{}", devname, counter));
+  uint64_t value = 0;
+  f >> value;
+  return value;
+}
+//------------------------------------------------------------------------------
+gtp_mod_kernel::gtp_mod_kernel()
+    : enabled_(false),
+      devnames_(),
+      ifindexes_(),
+      fd0s_(),
+      genl_(nullptr),
+      genl_id_(-1),
+      rtnl_(nullptr),
+      rtnl_seq_(0),
+      tunnels_(0),
+      tunnels_added_(0),
+      tunnels_deleted_(0),
+      failures_(0) {}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::init(const std::vector<int>& s1u_sockets) {
+#if ENABLE_LIBGTPNL
+  for (std::size_t i = 0; i < s1u_sockets.size(); i++) {
+    const std::string devname =
+        fmt::format("{}{}", GTP_MOD_KERNEL_DEVNAME, i);
+    // Left by a previous run
+    gtp_dev_destroy(devname.c_str());
+    const int fd0 = socket(AF_INET, SOCK_DGRAM, 0);
+    if ((fd0 < 0) ||
+        (gtp_dev_create(-1, devname.c_str(), fd0, s1u_sockets[i]) < 0)) {
+      Logger::pfcp_switch().error(
+          "Cannot create GTP device %s (%s)", devname.c_str(),
+          strerror(errno));
+      if (fd0 >= 0) close(fd0);
+      stop();
+      return false;
+    }
+    fd0s_.push_back(fd0);
+    devnames_.push_back(devname);
+    ifindexes_.push_back(if_nametoindex(devname.c_str()));
+    // The UL packets of all the devices come from UEs routed to the first one
+    const std::string cmd =
+        fmt::format("/sbin/sysctl -w net.ipv4.conf.{}.rp_filter=0", devname);
+    if (system(cmd.c_str()) != 0) {
+      Logger::pfcp_switch().warn(
+          "Cannot disable rp_filter on GTP device %s, GTP kernel offload not "
+          "used",
+          devname.c_str());
+      stop();
+      return false;
+    }
+  }
+  if (devnames_.empty()) return false;
+
+  genl_ = genl_socket_open();
+  if (not genl_) {
+    Logger::pfcp_switch().error("Cannot open the genetlink socket");
+    stop();
+    return false;
+  }
+  genl_id_ = genl_lookup_family(genl_, "gtp");
+  if (genl_id_ < 0) {
+    Logger::pfcp_switch().error("Cannot find the gtp genetlink family");
+    stop();
+    return false;
+  }
+  rtnl_ = mnl_socket_open(NETLINK_ROUTE);
+  if ((not rtnl_) || (mnl_socket_bind(rtnl_, 0, MNL_SOCKET_AUTOPID) < 0)) {
+    Logger::pfcp_switch().error(
+        "Cannot open the rtnetlink socket (%s)", strerror(errno));
+    stop();
+    return false;
+  }
+  enabled_ = true;
+  Logger::pfcp_switch().info(
+      "GTP kernel offload: %zu gtp devices on the S1-U sockets",
+      devnames_.size());
+  return true;
+#else
+  Logger::pfcp_switch().error(
+      "GTP kernel offload needs a build with ENABLE_LIBGTPNL");
+  return false;
+#endif
+}
+//------------------------------------------------------------------------------
+void gtp_mod_kernel::stop() {
+#if ENABLE_LIBGTPNL
+  // The tunnels and the routes of a device go with it
+  for (const auto& devname : devnames_) {
+    gtp_dev_destroy(devname.c_str());
+  }
+  if (genl_) mnl_socket_close(genl_);
+  if (rtnl_) mnl_socket_close(rtnl_);
+#endif
+  for (auto fd0 : fd0s_) {
+    close(fd0);
+  }
+  devnames_.clear();
+  ifindexes_.clear();
+  fd0s_.clear();
+  genl_    = nullptr;
+  rtnl_    = nullptr;
+  enabled_ = false;
+  tunnels_ = 0;
+}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::add_tunnel(
+    const std::size_t i, const pfcp::kernel_gtp_tunnel_t& t) {
+#if ENABLE_LIBGTPNL
+  struct gtp_tunnel* gt = gtp_tunnel_alloc();
+  if (not gt) return false;
+  struct in_addr ue_ipv4  = t.ue_ipv4;
+  struct in_addr enb_ipv4 = t.enb_ipv4;
+  gtp_tunnel_set_ifidx(gt, ifindexes_[i]);
+  gtp_tunnel_set_version(gt, 1);
+  gtp_tunnel_set_ms_ip4(gt, &ue_ipv4);
+  gtp_tunnel_set_sgsn_ip4(gt, &enb_ipv4);
+  gtp_tunnel_set_i_tei(gt, t.i_tei);
+  gtp_tunnel_set_o_tei(gt, t.o_tei);
+  const int rc = gtp_add_tunnel(genl_id_, genl_, gt);
+  gtp_tunnel_free(gt);
+  return (rc >= 0);
+#else
+  return false;
+#endif
+}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::del_tunnel(
+    const std::size_t i, const pfcp::kernel_gtp_tunnel_t& t) {
+#if ENABLE_LIBGTPNL
+  struct gtp_tunnel* gt = gtp_tunnel_alloc();
+  if (not gt) return false;
+  // The module looks the tunnel up by its TEID
+  gtp_tunnel_set_ifidx(gt, ifindexes_[i]);
+  gtp_tunnel_set_version(gt, 1);
+  gtp_tunnel_set_i_tei(gt, t.i_tei);
+  gtp_tunnel_set_o_tei(gt, t.o_tei);
+  const int rc = gtp_del_tunnel(genl_id_, genl_, gt);
+  gtp_tunnel_free(gt);
+  return (rc >= 0);
+#else
+  return false;
+#endif
+}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::route(const uint16_t type, const struct in_addr& ue_ipv4) {
+#if ENABLE_LIBGTPNL
+  char buf[MNL_SOCKET_BUFFER_SIZE];
+  struct nlmsghdr* nlh = mnl_nlmsg_put_header(buf);
+  nlh->nlmsg_type      = type;
+  nlh->nlmsg_flags     = NLM_F_REQUEST | NLM_F_ACK;
+  nlh->nlmsg_seq       = ++rtnl_seq_;
+  struct rtmsg* rtm    = (struct rtmsg*) mnl_nlmsg_put_extra_header(
+      nlh, sizeof(struct rtmsg));
+  rtm->rtm_family  = AF_INET;
+  rtm->rtm_dst_len = 32;
+  rtm->rtm_table   = RT_TABLE_MAIN;
+  rtm->rtm_type    = RTN_UNICAST;
+  if (type == RTM_NEWROUTE) {
+    nlh->nlmsg_flags |= NLM_F_CREATE | NLM_F_REPLACE;
+    rtm->rtm_protocol = RTPROT_STATIC;
+    rtm->rtm_scope    = RT_SCOPE_LINK;
+  } else {
+    rtm->rtm_scope = RT_SCOPE_NOWHERE;
+  }
+  mnl_attr_put_u32(nlh, RTA_DST, ue_ipv4.s_addr);
+  mnl_attr_put_u32(nlh, RTA_OIF, ifindexes_[0]);
+  if (mnl_socket_sendto(rtnl_, nlh, nlh->nlmsg_len) < 0) return false;
+  const ssize_t n = mnl_socket_recvfrom(rtnl_, buf, sizeof(buf));
+  return (n >= 0) && (mnl_cb_run(
+                          buf, n, rtnl_seq_, mnl_socket_get_portid(rtnl_),
+                          nullptr, nullptr) >= 0);
+#else
+  return false;
+#endif
+}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::add(const pfcp::kernel_gtp_tunnel_t& tunnel) {
+  if (not enabled_) return false;
+  std::size_t i = 0;
+  while ((i < ifindexes_.size()) && (add_tunnel(i, tunnel))) {
+    i++;
+  }
+  // The DL route last, once every device knows the tunnel
+  if ((i == ifindexes_.size()) && (route(RTM_NEWROUTE, tunnel.ue_ipv4))) {
+    tunnels_++;
+    tunnels_added_++;
+    return true;
+  }
+  const int err = errno;
+  while (i > 0) {
+    del_tunnel(--i, tunnel);
+  }
+  failures_++;
+  Logger::pfcp_switch().warn(
+      "Cannot add GTP tunnel TEID 0x%" PRIx32 " to the gtp module (%s)",
+      tunnel.i_tei, strerror(err));
+  return false;
+}
+//------------------------------------------------------------------------------
+bool gtp_mod_kernel::del(const pfcp::kernel_gtp_tunnel_t& tunnel) {
+  if (not enabled_) return false;
+  // The DL route first, the DL packets go back to the TUN while the tunnel
+  // still encapsulates the ones already routed
+  bool deleted = route(RTM_DELROUTE, tunnel.ue_ipv4);
+  for (std::size_t i = 0; i < ifindexes_.size(); i++) {
+    deleted = del_tunnel(i, tunnel) && deleted;
+  }
+  if (deleted) {
+    tunnels_--;
+    tunnels_deleted_++;
+  } else {
+    failures_++;
+    Logger::pfcp_switch().warn(
+        "Cannot delete GTP tunnel TEID 0x%" PRIx32 " from the gtp module (%s)",
+        tunnel.i_tei, strerror(errno));
+  }
+  return deleted;
+}
+//------------------------------------------------------------------------------
+void gtp_mod_kernel::get_counters(gtp_mod_kernel_counters_t& counters) const {
+  counters                 = {};
+  counters.tunnels         = tunnels_;
+  counters.tunnels_added   = tunnels_added_;
+  counters.tunnels_deleted = tunnels_deleted_;
+  counters.failures        = failures_;
+  for (const auto& devname : devnames_) {
+    counters.rx_packets += read_device_counter(devname, "rx_packets");
+    counters.rx_bytes += read_device_counter(devname, "rx_bytes");
+    counters.tx_packets += read_device_counter(devname, "tx_packets");
+    counters.tx_bytes += read_device_counter(devname, "tx_bytes");
+  }
+}
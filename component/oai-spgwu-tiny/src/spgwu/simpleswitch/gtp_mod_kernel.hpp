@@ -0,0 +1,119 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+
+/*! \file gtp_mod_kernel.hpp
+  \brief Default bearers switched by the Linux gtp module, set with libgtpnl
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_GTP_MOD_KERNEL_HPP_SEEN
+#define FILE_GTP_MOD_KERNEL_HPP_SEEN
+
+#include "pfcp_session.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct mnl_socket;
+
+namespace spgwu {
+
+typedef struct gtp_mod_kernel_counters_s {
+  // Tunnels installed, one per session
+  uint64_t tunnels;
+  uint64_t tunnels_added;
+  uint64_t tunnels_deleted;
+  // Tunnels the module refused, their sessions stay in the packet workers
+  uint64_t failures;
+  // Of the gtp devices: UL packets decapsulated (rx), DL packets
+  // encapsulated (tx)
+  uint64_t rx_packets;
+  uint64_t rx_bytes;
+  uint64_t tx_packets;
+  uint64_t tx_bytes;
+} gtp_mod_kernel_counters_t;
+
+// A gtp device is bound to each S1-U receive socket: the G-PDUs of a TEID
+// known by the module are decapsulated by the kernel and routed to SGi, the
+// other datagrams (unknown TEIDs, echo, error indication) still reach the
+// socket. The DL packets of a tunnel are routed to the first gtp device by
+// a /32 route to the UE address, more specific than the route of the UE pool
+// to the TUN. A tunnel is added to every device since the kernel spreads the
+// G-PDUs over the SO_REUSEPORT sockets.
+// The fast path entries of a session stay published while it is in the
+// module: a tunnel deleted, its packets are switched by the packet workers
+// again. The devices are left behind if the SPGW-U is killed, they are
+// replaced at the next start. Only used by the control path.
+class gtp_mod_kernel {
+ private:
+#define GTP_MOD_KERNEL_DEVNAME "gtpu"
+  bool enabled_;
+  // Names and interface indexes of the gtp devices, the first one sends the
+  // DL packets
+  std::vector<std::string> devnames_;
+  std::vector<unsigned int> ifindexes_;
+  // The devices also take a GTPv0 socket, left unbound
+  std::vector<int> fd0s_;
+  struct mnl_socket* genl_;
+  int genl_id_;
+  struct mnl_socket* rtnl_;
+  uint32_t rtnl_seq_;
+
+  uint64_t tunnels_;
+  uint64_t tunnels_added_;
+  uint64_t tunnels_deleted_;
+  uint64_t failures_;
+
+  // Return false if the tunnel could not be added to device i or deleted
+  // from it
+  bool add_tunnel(const std::size_t i, const pfcp::kernel_gtp_tunnel_t& t);
+  bool del_tunnel(const std::size_t i, const pfcp::kernel_gtp_tunnel_t& t);
+  // Add (RTM_NEWROUTE) or delete (RTM_DELROUTE) the /32 route to a UE
+  bool route(const uint16_t type, const struct in_addr& ue_ipv4);
+
+ public:
+  gtp_mod_kernel();
+  gtp_mod_kernel(gtp_mod_kernel const&) = delete;
+  void operator=(gtp_mod_kernel const&) = delete;
+  ~gtp_mod_kernel() { stop(); }
+
+  // Create the gtp devices on the S1-U sockets, return false (and leave the
+  // module unused) if the module or libgtpnl is not available
+  bool init(const std::vector<int>& s1u_sockets);
+  // Remove the devices, their tunnels and routes with them
+  void stop();
+  bool enabled() const { return enabled_; }
+
+  // The packets of the tunnel are switched by the kernel once added, by the
+  // packet workers again once deleted
+  bool add(const pfcp::kernel_gtp_tunnel_t& tunnel);
+  bool del(const pfcp::kernel_gtp_tunnel_t& tunnel);
+
+  void get_counters(gtp_mod_kernel_counters_t& counters) const;
+};
+
+}  // namespace spgwu
+
+#endif /* FILE_GTP_MOD_KERNEL_HPP_SEEN */
@@ -0,0 +1,297 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_dl_buffer.cpp
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_dl_buffer.hpp"
+#include "spgwu_s1u.hpp"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace pfcp;
+using namespace spgwu;
+
+extern spgwu_s1u* spgwu_s1u_inst;
+
+// Packets sent per TX flush when a buffer is released
+#define PFCP_DL_BUFFER_DRAIN_BURST 64
+
+//------------------------------------------------------------------------------
+dl_buffer_pool::dl_buffer_pool()
+    : lock_(),
+      slabs_(),
+      free_(nullptr),
+      oldest_(nullptr),
+      newest_(nullptr),
+      max_slots_(0),
+      num_slots_(0),
+      num_free_(0),
+      counters_() {}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::set_max_size(const std::size_t max_bytes) {
+  std::unique_lock<std::mutex> lock(lock_);
+  max_slots_ = max_bytes / sizeof(dl_buffer_slot_t);
+}
+//------------------------------------------------------------------------------
+std::size_t dl_buffer_pool::get_max_slots() const {
+  std::unique_lock<std::mutex> lock(lock_);
+  return max_slots_;
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::get_counters(dl_buffer_counters_t& counters) const {
+  std::unique_lock<std::mutex> lock(lock_);
+  counters = counters_;
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::get_occupancy(
+    std::size_t& used_slots, std::size_t& max_slots) const {
+  std::unique_lock<std::mutex> lock(lock_);
+  used_slots = num_slots_ - num_free_;
+  max_slots  = max_slots_;
+}
+//------------------------------------------------------------------------------
+dl_buffer_slot_t* dl_buffer_pool::get_slot() {
+  if ((not free_) && (num_slots_ < max_slots_)) {
+    std::size_t n = std::min(
+        (std::size_t) PFCP_DL_BUFFER_SLAB_SLOTS, max_slots_ - num_slots_);
+    std::unique_ptr<dl_buffer_slot_t[]> slab(new dl_buffer_slot_t[n]);
+    for (std::size_t i = 0; i < n; i++) {
+      slab[i].next = free_;
+      free_        = &slab[i];
+    }
+    slabs_.push_back(std::move(slab));
+    num_slots_ += n;
+    num_free_ += n;
+  }
+  dl_buffer_slot_t* slot = nullptr;
+  if (free_) {
+    slot  = free_;
+    free_ = slot->next;
+    num_free_--;
+  } else if (oldest_) {
+    // Pool exhausted, the oldest packet of all is the head of its buffer
+    dl_packet_buffer* owner = oldest_->owner;
+    slot                    = pop(*owner);
+    counters_.evicted++;
+  } else {
+    // All the slots are being sent
+    return nullptr;
+  }
+  return slot;
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::put_slot(dl_buffer_slot_t* slot) {
+  slot->owner = nullptr;
+  slot->next  = free_;
+  free_       = slot;
+  num_free_++;
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::push(dl_packet_buffer& b, dl_buffer_slot_t* slot) {
+  slot->owner = &b;
+  slot->next  = nullptr;
+  if (b.tail) {
+    b.tail->next = slot;
+  } else {
+    b.head = slot;
+  }
+  b.tail = slot;
+  b.count++;
+
+  slot->age_next = nullptr;
+  slot->age_prev = newest_;
+  if (newest_) {
+    newest_->age_next = slot;
+  } else {
+    oldest_ = slot;
+  }
+  newest_ = slot;
+}
+//------------------------------------------------------------------------------
+dl_buffer_slot_t* dl_buffer_pool::pop(dl_packet_buffer& b) {
+  dl_buffer_slot_t* slot = b.head;
+  if (not slot) return nullptr;
+  b.head = slot->next;
+  if (not b.head) b.tail = nullptr;
+  b.count--;
+
+  if (slot->age_prev) {
+    slot->age_prev->age_next = slot->age_next;
+  } else {
+    oldest_ = slot->age_next;
+  }
+  if (slot->age_next) {
+    slot->age_next->age_prev = slot->age_prev;
+  } else {
+    newest_ = slot->age_prev;
+  }
+  slot->next     = nullptr;
+  slot->age_prev = nullptr;
+  slot->age_next = nullptr;
+  return slot;
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::discard(dl_packet_buffer& b) {
+  while (dl_buffer_slot_t* slot = pop(b)) {
+    put_slot(slot);
+    counters_.dropped++;
+  }
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::forward(
+    const pfcp::fast_path_action_t& action, dl_buffer_slot_t* slot) const {
+  forward(action, &slot->data[PFCP_DL_BUFFER_HEADROOM], slot->num_bytes);
+}
+//------------------------------------------------------------------------------
+void dl_buffer_pool::forward(
+    const pfcp::fast_path_action_t& action, const char* const ip_packet,
+    const std::size_t num_bytes) const {
+  if (action.outer_header_creation_description ==
+      OUTER_HEADER_CREATION_GTPU_UDP_IPV4) {
+    spgwu_s1u_inst->send_g_pdu(
+        action.peer_ipv4, action.peer_port, action.teid, ip_packet, num_bytes);
+  } else {
+    spgwu_s1u_inst->send_g_pdu(
+        action.peer_ipv6, action.peer_port, action.teid, ip_packet, num_bytes);
+  }
+}
+
+//------------------------------------------------------------------------------
+dl_packet_buffer::~dl_packet_buffer() {
+  dl_buffer_pool& pool = dl_buffer_pool::get_instance();
+  std::unique_lock<std::mutex> lock(pool.lock_);
+  pool.discard(*this);
+}
+//------------------------------------------------------------------------------
+uint32_t dl_packet_buffer::size() const {
+  std::unique_lock<std::mutex> lock(dl_buffer_pool::get_instance().lock_);
+  return count;
+}
+//------------------------------------------------------------------------------
+void dl_packet_buffer::enqueue(
+    const char* const ip_packet, const std::size_t num_bytes) {
+  dl_buffer_pool& pool = dl_buffer_pool::get_instance();
+  std::unique_lock<std::mutex> lock(pool.lock_);
+  switch (state) {
+    case DL_BUFFER_FORWARD: {
+      // Sent by a worker still switching with the previous fast path entry
+      pfcp::fast_path_action_t a = action;
+      pool.counters_.forwarded++;
+      lock.unlock();
+      pool.forward(a, ip_packet, num_bytes);
+    } break;
+
+    case DL_BUFFER_HOLD:
+    case DL_BUFFER_DRAIN: {
+      if ((num_bytes > PFCP_DL_BUFFER_MAX_PACKET_SIZE) || (not max_packets)) {
+        pool.counters_.dropped++;
+        return;
+      }
+      if (count >= max_packets) {
+        pool.put_slot(pool.pop(*this));
+        pool.counters_.dropped_buffer_full++;
+      }
+      dl_buffer_slot_t* slot = pool.get_slot();
+      if (not slot) {
+        pool.counters_.dropped++;
+        return;
+      }
+      memcpy(&slot->data[PFCP_DL_BUFFER_HEADROOM], ip_packet, num_bytes);
+      slot->num_bytes = num_bytes;
+      pool.push(*this, slot);
+      pool.counters_.buffered++;
+    } break;
+
+    case DL_BUFFER_IDLE:
+    default:
+      // The control path did not ask for buffering (yet)
+      pool.counters_.dropped++;
+  }
+}
+//------------------------------------------------------------------------------
+void dl_packet_buffer::hold(const uint32_t max) {
+  dl_buffer_pool& pool = dl_buffer_pool::get_instance();
+  std::unique_lock<std::mutex> lock(pool.lock_);
+  state       = DL_BUFFER_HOLD;
+  max_packets = max;
+  while (count > max_packets) {
+    pool.put_slot(pool.pop(*this));
+    pool.counters_.dropped_buffer_full++;
+  }
+}
+//------------------------------------------------------------------------------
+void dl_packet_buffer::release(const pfcp::fast_path_action_t& new_action) {
+  dl_buffer_pool& pool = dl_buffer_pool::get_instance();
+  const bool to_access =
+      (new_action.forw) &&
+      (new_action.destination_interface == INTERFACE_VALUE_ACCESS) &&
+      ((new_action.outer_header_creation_description ==
+        OUTER_HEADER_CREATION_GTPU_UDP_IPV4) ||
+       (new_action.outer_header_creation_description ==
+        OUTER_HEADER_CREATION_GTPU_UDP_IPV6));
+  {
+    std::unique_lock<std::mutex> lock(pool.lock_);
+    if (state == DL_BUFFER_IDLE) {
+      return;
+    }
+    if (not to_access) {
+      pool.discard(*this);
+      state = DL_BUFFER_IDLE;
+      return;
+    }
+    action = new_action;
+    state  = DL_BUFFER_DRAIN;
+  }
+
+  // Send in bursts without holding the lock, packets arriving meanwhile are
+  // queued behind, so that the order is kept
+  std::vector<dl_buffer_slot_t*> burst;
+  burst.reserve(PFCP_DL_BUFFER_DRAIN_BURST);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(pool.lock_);
+      for (auto slot : burst) {
+        pool.put_slot(slot);
+      }
+      pool.counters_.forwarded += burst.size();
+      burst.clear();
+      while (burst.size() < PFCP_DL_BUFFER_DRAIN_BURST) {
+        dl_buffer_slot_t* slot = pool.pop(*this);
+        if (not slot) break;
+        // Not reachable by the eviction anymore
+        burst.push_back(slot);
+      }
+      if (burst.empty()) {
+        state = DL_BUFFER_FORWARD;
+        break;
+      }
+    }
+    for (auto slot : burst) {
+      pool.forward(action, slot);
+    }
+    spgwu_s1u_inst->flush_g_pdus();
+  }
+}
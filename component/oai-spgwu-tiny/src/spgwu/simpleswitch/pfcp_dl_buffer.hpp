@@ -0,0 +1,171 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_dl_buffer.hpp
+   \brief Buffering of the DL packets of idle UEs (FAR apply action BUFF)
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_DL_BUFFER_HPP_SEEN
+#define FILE_PFCP_DL_BUFFER_HPP_SEEN
+
+#include "pfcp_fast_path.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pfcp {
+
+// Buffered packets keep room in front of them for the GTP-U header that
+// send_g_pdu() writes in place
+#define PFCP_DL_BUFFER_HEADROOM 64
+#define PFCP_DL_BUFFER_SLOT_SIZE 2048
+#define PFCP_DL_BUFFER_MAX_PACKET_SIZE \
+  (PFCP_DL_BUFFER_SLOT_SIZE - PFCP_DL_BUFFER_HEADROOM)
+// Slots are allocated by slabs, when buffering is first needed
+#define PFCP_DL_BUFFER_SLAB_SLOTS 256
+
+class dl_packet_buffer;
+
+typedef struct dl_buffer_slot_s {
+  // Next packet of the owner buffer, or next free slot
+  struct dl_buffer_slot_s* next;
+  // All the buffered packets, oldest first, for the global eviction
+  struct dl_buffer_slot_s* age_prev;
+  struct dl_buffer_slot_s* age_next;
+  dl_packet_buffer* owner;
+  uint16_t num_bytes;
+  char data[PFCP_DL_BUFFER_SLOT_SIZE];
+} dl_buffer_slot_t;
+
+typedef struct dl_buffer_counters_s {
+  uint64_t buffered;
+  uint64_t forwarded;
+  // Oldest packet of a full buffer
+  uint64_t dropped_buffer_full;
+  // Oldest packet of all when the pool is exhausted
+  uint64_t evicted;
+  // Too big, or discarded when the FAR does not forward anymore
+  uint64_t dropped;
+} dl_buffer_counters_t;
+
+// Bounded FIFO of the DL packets of one PDR whose FAR buffers. Slots come
+// from dl_buffer_pool, everything is protected by the pool lock.
+//  - hold(): the FAR buffers, packets are queued, when the buffer is full
+//    its oldest packet is dropped.
+//  - release(): the FAR forwards, the queued packets are sent in order as
+//    one burst, packets still coming from stale fast path entries are sent
+//    right away. If the FAR does not forward to the access side, the queued
+//    packets are discarded.
+class dl_packet_buffer {
+ private:
+  friend class dl_buffer_pool;
+
+  enum state_e {
+    DL_BUFFER_IDLE,
+    DL_BUFFER_HOLD,
+    // Queued packets are being sent, new ones are queued behind them
+    DL_BUFFER_DRAIN,
+    DL_BUFFER_FORWARD
+  };
+
+  state_e state;
+  dl_buffer_slot_t* head;
+  dl_buffer_slot_t* tail;
+  uint32_t count;
+  uint32_t max_packets;
+  // Valid in DL_BUFFER_DRAIN and DL_BUFFER_FORWARD states
+  pfcp::fast_path_action_t action;
+
+ public:
+  dl_packet_buffer()
+      : state(DL_BUFFER_IDLE),
+        head(nullptr),
+        tail(nullptr),
+        count(0),
+        max_packets(0),
+        action() {}
+  dl_packet_buffer(const dl_packet_buffer&) = delete;
+  void operator=(const dl_packet_buffer&) = delete;
+  ~dl_packet_buffer();
+
+  // Packet workers
+  void enqueue(const char* const ip_packet, const std::size_t num_bytes);
+
+  // Control path
+  void hold(const uint32_t max_packets);
+  void release(const pfcp::fast_path_action_t& action);
+  uint32_t size() const;
+};
+
+// Shared slab pool of the buffered packets, bounded by a global size. When
+// it is exhausted the oldest buffered packet, whatever its buffer, is evicted.
+class dl_buffer_pool {
+ private:
+  friend class dl_packet_buffer;
+
+  mutable std::mutex lock_;
+  std::vector<std::unique_ptr<dl_buffer_slot_t[]>> slabs_;
+  dl_buffer_slot_t* free_;
+  dl_buffer_slot_t* oldest_;
+  dl_buffer_slot_t* newest_;
+  std::size_t max_slots_;
+  std::size_t num_slots_;
+  std::size_t num_free_;
+  dl_buffer_counters_t counters_;
+
+  dl_buffer_pool();
+
+  // Lock held by the callers
+  dl_buffer_slot_t* get_slot();
+  void put_slot(dl_buffer_slot_t* slot);
+  dl_buffer_slot_t* pop(dl_packet_buffer& b);
+  void push(dl_packet_buffer& b, dl_buffer_slot_t* slot);
+  void discard(dl_packet_buffer& b);
+  void forward(
+      const pfcp::fast_path_action_t& action, dl_buffer_slot_t* slot) const;
+  void forward(
+      const pfcp::fast_path_action_t& action, const char* const ip_packet,
+      const std::size_t num_bytes) const;
+
+ public:
+  static dl_buffer_pool& get_instance() {
+    static dl_buffer_pool instance;
+    return instance;
+  }
+  dl_buffer_pool(dl_buffer_pool const&) = delete;
+  void operator=(dl_buffer_pool const&) = delete;
+
+  // Global cap, slots already allocated are kept
+  void set_max_size(const std::size_t max_bytes);
+  std::size_t get_max_slots() const;
+  void get_counters(dl_buffer_counters_t& counters) const;
+  // Slots holding a packet (buffered or being sent) and the global cap
+  void get_occupancy(std::size_t& used_slots, std::size_t& max_slots) const;
+};
+
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_DL_BUFFER_HPP_SEEN */
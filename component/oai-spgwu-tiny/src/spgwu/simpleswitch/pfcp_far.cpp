@@ -26,86 +26,66 @@
 */
 
 #include "pfcp_far.hpp"
-#include "pfcp_switch.hpp"
 #include "spgwu_config.hpp"
-#include "spgwu_s1u.hpp"
 
 using namespace pfcp;
 using namespace spgwu;
 
-extern pfcp_switch* pfcp_switch_inst;
-extern spgwu_s1u* spgwu_s1u_inst;
 extern spgwu_config spgwu_cfg;
 
 //------------------------------------------------------------------------------
-void pfcp_far::apply_forwarding_rules(
-    struct iphdr* const iph, const std::size_t num_bytes, bool& nocp,
-    bool& buff) {
-  // TODO dupl
-  // TODO nocp
-  // TODO buff
-  // Logger::pfcp_switch().info( "pfcp_far::apply_forwarding_rules FAR id %4x ",
-  // far_id.far_id);
-  if (apply_action.forw) {
-    if (forwarding_parameters.first) {
-      if (forwarding_parameters.second.destination_interface.first) {
-        if (forwarding_parameters.second.destination_interface.second
-                .interface_value == INTERFACE_VALUE_ACCESS) {
-          if (forwarding_parameters.second.outer_header_creation.first) {
-            switch (forwarding_parameters.second.outer_header_creation.second
-                        .outer_header_creation_description) {
-              case OUTER_HEADER_CREATION_GTPU_UDP_IPV4:
-                spgwu_s1u_inst->send_g_pdu(
-                    forwarding_parameters.second.outer_header_creation.second
-                        .ipv4_address,
-                    spgwu_cfg.s1_up.port,
-                    forwarding_parameters.second.outer_header_creation.second
-                        .teid,
-                    reinterpret_cast<const char*>(iph), num_bytes);
-
-                break;
-              case OUTER_HEADER_CREATION_GTPU_UDP_IPV6:
-                spgwu_s1u_inst->send_g_pdu(
-                    forwarding_parameters.second.outer_header_creation.second
-                        .ipv6_address,
-                    spgwu_cfg.s1_up.port,
-                    forwarding_parameters.second.outer_header_creation.second
-                        .teid,
-                    reinterpret_cast<const char*>(iph), num_bytes);
-                break;
-              case OUTER_HEADER_CREATION_UDP_IPV4:  // TODO
-              case OUTER_HEADER_CREATION_UDP_IPV6:  // TODO
-              default:;
-            }
-          }
-        } else if (
-            forwarding_parameters.second.destination_interface.second
-                .interface_value == INTERFACE_VALUE_CORE) {
-          if (pfcp_switch_inst->no_internal_loop(iph, num_bytes)) {
-            pfcp_switch_inst->send_to_core(
-                reinterpret_cast<char* const>(iph), num_bytes);
-          }
-        } else {
-        }
-      } else {
-        // Mandatory IE
-      }
-    } else {
-      // Mandatory if FW set in apply action
-    }
-  } else if (apply_action.drop) {
-    // DONE !
-  } else if (apply_action.buff) {
-    buff = true;
+void pfcp_far::compile(pfcp::fast_path_action_t& action) const {
+  action        = {};
+  action.far_id = far_id.far_id;
+  action.forw   = apply_action.forw;
+  action.drop   = apply_action.drop;
+  action.buff   = apply_action.buff;
+  action.nocp   = apply_action.nocp;
+  if (not forwarding_parameters.first) {
+    // Mandatory if FW set in apply action
+    action.forw = false;
+    return;
+  }
+  const pfcp::forwarding_parameters& fp = forwarding_parameters.second;
+  if (fp.destination_interface.first) {
+    action.destination_interface =
+        fp.destination_interface.second.interface_value;
+  } else {
+    // Mandatory IE
+    action.forw = false;
+  }
+  if (fp.outer_header_creation.first) {
+    const pfcp::outer_header_creation_t& ohc = fp.outer_header_creation.second;
+    action.outer_header_creation_description =
+        ohc.outer_header_creation_description;
+    action.teid      = ohc.teid;
+    action.peer_ipv4 = ohc.ipv4_address;
+    action.peer_ipv6 = ohc.ipv6_address;
+    action.peer_port = spgwu_cfg.s1_up.port;
   }
+}
 
-  if (apply_action.nocp) {
-    nocp = true;
+//------------------------------------------------------------------------------
+bool pfcp_far::supported(
+    const std::pair<bool, pfcp::outer_header_creation_t>& ohc) {
+  if (not ohc.first) {
+    return true;
   }
+  const uint16_t description = ohc.second.outer_header_creation_description;
+  return (description == OUTER_HEADER_CREATION_GTPU_UDP_IPV4) ||
+         (description == OUTER_HEADER_CREATION_GTPU_UDP_IPV6);
 }
 
 //------------------------------------------------------------------------------
 bool pfcp_far::update(const pfcp::update_far& update, uint8_t& cause_value) {
+  // Checked before anything changes, a refused update leaves the FAR as is
+  if (((update.apply_action.first) && (update.apply_action.second.dupl)) ||
+      ((update.update_forwarding_parameters.first) &&
+       (not supported(update.update_forwarding_parameters.second
+                          .outer_header_creation)))) {
+    cause_value = pfcp::CAUSE_VALUE_SERVICE_NOT_SUPPORTED;
+    return false;
+  }
   update.get(apply_action);
   if (update.update_forwarding_parameters.first) {
     forwarding_parameters.second.update(
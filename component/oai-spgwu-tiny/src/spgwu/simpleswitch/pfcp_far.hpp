@@ -31,6 +31,7 @@
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include "msg_pfcp.hpp"
+#include "pfcp_fast_path.hpp"
 
 namespace pfcp {
 
@@ -112,9 +113,12 @@ class pfcp_far {
 
   bool update(const pfcp::update_far& update, uint8_t& cause_value);
 
-  void apply_forwarding_rules(
-      struct iphdr* const iph, const std::size_t num_bytes, bool& nocp,
-      bool& buff);
+  // Outer headers the packet workers can build (GTP-U over IPv4 or IPv6)
+  static bool supported(
+      const std::pair<bool, pfcp::outer_header_creation_t>& ohc);
+
+  // Flatten this FAR for the packet path
+  void compile(pfcp::fast_path_action_t& action) const;
 };
 }  // namespace pfcp
 
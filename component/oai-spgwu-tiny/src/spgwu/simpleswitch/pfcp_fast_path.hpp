@@ -0,0 +1,160 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_fast_path.hpp
+   \brief Flat, immutable form of the PFCP rules read by the packet path
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_FAST_PATH_HPP_SEEN
+#define FILE_PFCP_FAST_PATH_HPP_SEEN
+
+#include "3gpp_29.244.h"
+#include "pfcp_sdf_filter.hpp"
+
+#include <algorithm>
+#include <endian.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <memory>
+#include <netinet/in.h>
+#include <string.h>
+#include <vector>
+
+namespace pfcp {
+
+class pfcp_pdr;
+class pfcp_qer;
+class pfcp_urr;
+
+// Key of the DL switching table for IPv6: the UE /64 prefix, host byte order
+inline uint64_t fast_path_ipv6_prefix_key(const struct in6_addr& addr) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, addr.s6_addr, sizeof(prefix));
+  return be64toh(prefix);
+}
+
+// FAR of a rule, only what is needed to forward a packet
+typedef struct fast_path_action_s {
+  uint32_t far_id;
+  bool forw;
+  bool drop;
+  bool buff;
+  bool nocp;
+  uint8_t destination_interface;
+  // 0 if no outer header has to be created
+  uint16_t outer_header_creation_description;
+  teid_t teid;
+  struct in_addr peer_ipv4;
+  struct in6_addr peer_ipv6;
+  uint16_t peer_port;
+} fast_path_action_t;
+
+// QERs enforced per rule, e.g. the bearer MBR and the APN-AMBR
+#define PFCP_FAST_PATH_MAX_QERS 4
+
+// PDR with its FAR inlined
+typedef struct fast_path_rule_s {
+  uint32_t precedence;
+  uint16_t pdr_id;
+  // UE IPv4 address (network byte order) of the PDI: source address of UL
+  // packets, destination address of DL packets
+  bool match_ue_ipv4;
+  struct in_addr ue_ipv4;
+  // UE IPv6 /64 prefix of the PDI, same as above
+  bool match_ue_ipv6_prefix;
+  struct in6_addr ue_ipv6_prefix;
+  // Only dereferenced on the exception paths (buffering, CP notification)
+  pfcp_pdr* pdr;
+  // Enforced in order, a packet dropped by one QER is dropped
+  pfcp_qer* qers[PFCP_FAST_PATH_MAX_QERS];
+  uint8_t num_qers;
+  // Usage counted on the packet path, nullptr if the PDR has no URR
+  pfcp_urr* urr;
+  // UL rule (packets from the access side), usage direction of the URR
+  bool uplink;
+  fast_path_action_t action;
+} fast_path_rule_t;
+
+// All the rules of one session reachable by one key (UL S1-U TEID, DL UE
+// IPv4 address or DL UE IPv6 /64 prefix), sorted by precedence (lowest value
+// first). An entry is never modified once published, the control path
+// compiles a new one and swaps it.
+class fast_path_entry {
+ public:
+  uint64_t up_seid;
+  pfcp::fseid_t cp_fseid;
+  std::vector<fast_path_rule_t> rules;
+  // UE IP address and SDF filter of each rule, classifies to a rule index
+  sdf_classifier classifier;
+  // Keep alive the PDRs the rules point to, not touched by the packet path
+  std::vector<std::shared_ptr<pfcp_pdr>> pdrs;
+  // Same for the QERs and the URRs
+  std::vector<std::shared_ptr<pfcp_qer>> qers;
+  std::vector<std::shared_ptr<pfcp_urr>> urrs;
+
+  fast_path_entry()
+      : up_seid(0),
+        cp_fseid(),
+        rules(),
+        classifier(),
+        pdrs(),
+        qers(),
+        urrs() {}
+  fast_path_entry(const fast_path_entry&) = delete;
+  void operator=(const fast_path_entry&) = delete;
+
+  void sort_rules() {
+    std::stable_sort(
+        rules.begin(), rules.end(),
+        [](const fast_path_rule_t& a, const fast_path_rule_t& b) {
+          return a.precedence < b.precedence;
+        });
+  }
+
+  // First rule matching an IPv4 packet, nullptr if none
+  const fast_path_rule_t* classify(
+      const struct iphdr* const iph, const std::size_t num_bytes,
+      const bool uplink) const {
+    sdf_flow_key_t key;
+    if (not sdf_flow_key_from_ipv4(iph, num_bytes, uplink, key)) {
+      return nullptr;
+    }
+    const int index = classifier.classify(key);
+    return (index < 0) ? nullptr : &rules[index];
+  }
+  // First rule matching an IPv6 packet, nullptr if none
+  const fast_path_rule_t* classify(
+      const struct ipv6hdr* const ip6h, const std::size_t num_bytes,
+      const bool uplink) const {
+    sdf_flow_key6_t key;
+    if (not sdf_flow_key_from_ipv6(ip6h, num_bytes, uplink, key)) {
+      return nullptr;
+    }
+    const int index = classifier.classify(key);
+    return (index < 0) ? nullptr : &rules[index];
+  }
+};
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_FAST_PATH_HPP_SEEN */
@@ -34,98 +34,112 @@ using namespace pfcp;
 extern spgwu::spgwu_sx* spgwu_sx_inst;
 
 //------------------------------------------------------------------------------
-bool pfcp_pdr::look_up_pack_in_access(
-    struct iphdr* const iph, const std::size_t num_bytes,
-    const endpoint& r_endpoint, const uint32_t tunnel_id) {
-  // implicit packet arrives from ACCESS interface
-  if (outer_header_removal.first) {
-    if (outer_header_removal.second.outer_header_removal_description !=
-        OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4) {
-      return false;
-    }
-  } else {
-    // IPV4/UDP/GTP header already removed
+bool pfcp_pdr::compile(pfcp::fast_path_rule_t& rule, const bool access) const {
+  if (not pdi.first) {
+    // Mandatory IE
     return false;
   }
-  if (pdi.first) {
-    if (pdi.second.source_interface.first) {
-      if (pdi.second.source_interface.second.interface_value !=
-          INTERFACE_VALUE_ACCESS) {
-        return false;
-      }
-    }
-    // local_fteid should be fine since pdr created for this fteid
-    if (pdi.second.local_fteid.first) {
-      if (pdi.second.local_fteid.second.teid != tunnel_id) {
-        return false;
-      }
+  rule            = {};
+  rule.precedence = (precedence.first) ? precedence.second.precedence : 0;
+  rule.pdr_id     = pdr_id.rule_id;
+  rule.pdr        = const_cast<pfcp_pdr*>(this);
+  rule.uplink     = access;
+  if (access) {
+    // Implicit packet arrives from ACCESS interface, the TEID is the key of
+    // the entry the rule is stored in, whatever the S1-U transport
+    if (not outer_header_removal.first) {
+      return false;
     }
-    if (pdi.second.ue_ip_address.first) {
-      if (!pdi.second.ue_ip_address.second.v4) {
-        return false;
-      }
-      if (pdi.second.ue_ip_address.second.ipv4_address.s_addr != iph->saddr) {
+    switch (outer_header_removal.second.outer_header_removal_description) {
+      case OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4:
+      case OUTER_HEADER_REMOVAL_GTPU_UDP_IPV6:
+      case OUTER_HEADER_REMOVAL_GTPU_UDP_IP:
+        break;
+      default:
         return false;
-      }
     }
-    // SDF filter
-    if (pdi.second.sdf_filter.first) {
-      // TODO (create ss_pdi_t with ss_sdf_filter_t with optimized flow
-      // description matching )
-      return true;
+    if ((pdi.second.source_interface.first) &&
+        (pdi.second.source_interface.second.interface_value !=
+         INTERFACE_VALUE_ACCESS)) {
+      return false;
     }
-    return true;  // No SDF filter actually
   } else {
-    // Mandatory IE
-    return false;
-  }
-}
-//------------------------------------------------------------------------------
-bool pfcp_pdr::look_up_pack_in_core(
-    struct iphdr* const iph, const std::size_t num_bytes) {
-  // implicit packet arrives from CORE interface
-  if (outer_header_removal.first) {
-    // TODO ... when necessary (split U)
-    // Logger::pfcp_switch().info( "look_up_pack_in_core failed PDR id %4x,
-    // cause outer_header_removal present ", pdr_id.rule_id);
-    return false;
+    // Implicit packet arrives from CORE interface
+    if (outer_header_removal.first) {
+      // TODO ... when necessary (split U)
+      return false;
+    }
   }
-  // if (pdi.second.source_interface.second.interface_value !=
-  // INTERFACE_VALUE_CORE) {
-  //  return false;
-  //}
   if (pdi.second.ue_ip_address.first) {
-    if (!pdi.second.ue_ip_address.second.v4) {
-      // Logger::pfcp_switch().info( "look_up_pack_in_core failed PDR id %4x,
-      // cause ue_ip_address not present ", pdr_id.rule_id);
+    const pfcp::ue_ip_address_t& ue_ip = pdi.second.ue_ip_address.second;
+    if ((not ue_ip.v4) && (not ue_ip.v6)) {
       return false;
     }
-    if (pdi.second.ue_ip_address.second.ipv4_address.s_addr != iph->daddr) {
-      // Logger::pfcp_switch().info( "look_up_pack_in_core failed PDR id %4x,
-      // cause PDR ue_ip_address %8X do not match IP dest %8X of packet ",
-      //    pdr_id.rule_id, pdi.second.ue_ip_address.second.ipv4_address.s_addr,
-      //    iph->daddr);
-      return false;
+    if (ue_ip.v4) {
+      rule.match_ue_ipv4 = true;
+      rule.ue_ipv4       = ue_ip.ipv4_address;
+    }
+    if (ue_ip.v6) {
+      // The UE builds its addresses from the /64 prefix it was given
+      rule.match_ue_ipv6_prefix        = true;
+      rule.ue_ipv6_prefix              = ue_ip.ipv6_address;
+      rule.ue_ipv6_prefix.s6_addr32[2] = 0;
+      rule.ue_ipv6_prefix.s6_addr32[3] = 0;
     }
   }
-  // SDF filters TODO vector
-  // if (pdi.second.sdf_filter.first) {
-  // TODO (create ss_pdi_t with ss_sdf_filter_t with optimized flow description
-  // matching )
   return true;
-  //}
-  // return false;
+}
+
+//------------------------------------------------------------------------------
+bool pfcp_pdr::compile_sdf_filter(
+    const pfcp::pdi& pdi, std::pair<bool, pfcp::sdf_filter_rule>& sdf_rule,
+    std::string& error) {
+  sdf_rule = {};
+  if (not pdi.sdf_filter.first) {
+    return true;
+  }
+  // Not matched by the classifier: the PDR would capture more than requested
+  if ((pdi.sdf_filter.second.ttc) || (pdi.sdf_filter.second.spi) ||
+      (pdi.sdf_filter.second.fl)) {
+    error = "ToS/traffic class, SPI and flow label are not supported";
+    return false;
+  }
+  if (not pdi.sdf_filter.second.fd) {
+    return true;
+  }
+  if (not sdf_rule.second.parse(
+          pdi.sdf_filter.second.flow_description, error)) {
+    return false;
+  }
+  sdf_rule.first = true;
+  return true;
 }
 
 //------------------------------------------------------------------------------
 bool pfcp_pdr::update(const pfcp::update_pdr& update, uint8_t& cause_value) {
+  pfcp::pdi new_pdi = {};
+  if (update.get(new_pdi)) {
+    // Check it before applying anything
+    std::pair<bool, pfcp::sdf_filter_rule> new_sdf_rule = {};
+    std::string error                                  = {};
+    if (not compile_sdf_filter(new_pdi, new_sdf_rule, error)) {
+      Logger::spgwu_sx().info(
+          "PDR id %4x: bad SDF filter flow description \"%s\", %s",
+          pdr_id.rule_id, new_pdi.sdf_filter.second.flow_description.c_str(),
+          error.c_str());
+      cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+      return false;
+    }
+    pdi.first  = true;
+    pdi.second = new_pdi;
+    sdf_rule   = new_sdf_rule;
+  }
   if (update.get(outer_header_removal.second))
     outer_header_removal.first = true;
   if (update.get(precedence.second)) precedence.first = true;
-  if (update.get(pdi.second)) pdi.first = true;
   if (update.get(far_id.second)) far_id.first = true;
   if (update.get(urr_id.second)) urr_id.first = true;
-  if (update.get(qer_id.second)) qer_id.first = true;
+  if (update.qer_ids.size()) qer_ids = update.qer_ids;
   // TODO activate_predefined_rules
   // TODO deactivate_predefined_rules
   return true;
@@ -134,27 +148,14 @@ bool pfcp_pdr::update(const pfcp::update_pdr& update, uint8_t& cause_value) {
 //------------------------------------------------------------------------------
 void pfcp_pdr::buffering_requested(
     const char* buffer, const std::size_t num_bytes) {
-  Logger::spgwu_sx().warn("TODO pfcp_pdr::buffering_requested()");
-  /*
-    // TODO find smarter solution
-    char filename[] = "/tmp/buff_pdrzzzxxxyyy.XXXXXX";
-    int fd = mkstemp(filename);
-
-    if (fd == -1) return 1;
-    write(fd, buffer, num_bytes);
-
-    close(fd);
-    unlink(filename);
-    num_packets++
-   */
+  dl_buffer.enqueue(buffer, num_bytes);
 }
 
 //------------------------------------------------------------------------------
-void pfcp_pdr::notify_cp_requested(
-    std::shared_ptr<pfcp::pfcp_session> session) {
-  if (not notified_cp) {
+void pfcp_pdr::notify_cp_requested(const pfcp::fseid_t& cp_fseid) {
+  // May be called concurrently by several packet workers
+  if (not notified_cp.exchange(true)) {
     Logger::spgwu_sx().trace("notify_cp_requested()");
-    notified_cp = true;
 
     pfcp::pfcp_session_report_request h;
 
@@ -167,6 +168,6 @@ void pfcp_pdr::notify_cp_requested(
     h.set(report);
     h.set(dl_data_report);
 
-    spgwu_sx_inst->send_sx_msg(session->cp_fseid, h);
+    spgwu_sx_inst->send_sx_msg(cp_fseid, h);
   }
 }
@@ -32,7 +32,13 @@
 #include <linux/ipv6.h>
 #include "endpoint.hpp"
 #include "msg_pfcp.hpp"
+#include "pfcp_dl_buffer.hpp"
+#include "pfcp_fast_path.hpp"
+#include "pfcp_sdf_filter.hpp"
+#include <atomic>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace pfcp {
 
@@ -48,10 +54,14 @@ class pfcp_pdr {
   std::pair<bool, pfcp::outer_header_removal_t> outer_header_removal;
   std::pair<bool, pfcp::far_id_t> far_id;
   std::pair<bool, pfcp::urr_id_t> urr_id;
-  std::pair<bool, pfcp::qer_id_t> qer_id;
+  std::vector<pfcp::qer_id_t> qer_ids;
   std::pair<bool, pfcp::activate_predefined_rules_t> activate_predefined_rules;
+  // Flow description of the PDI SDF filter, parsed
+  std::pair<bool, pfcp::sdf_filter_rule> sdf_rule;
 
-  bool notified_cp;
+  std::atomic<bool> notified_cp;
+  // DL packets held while the FAR buffers
+  pfcp::dl_packet_buffer dl_buffer;
 
   explicit pfcp_pdr(uint64_t lseid)
       : lock(),
@@ -62,9 +72,11 @@ class pfcp_pdr {
         outer_header_removal(),
         far_id(),
         urr_id(),
-        qer_id(),
+        qer_ids(),
         activate_predefined_rules(),
-        notified_cp(false) {}
+        sdf_rule(),
+        notified_cp(false),
+        dl_buffer() {}
 
   explicit pfcp_pdr(const pfcp::create_pdr& c)
       : lock(),
@@ -75,9 +87,11 @@ class pfcp_pdr {
         outer_header_removal(c.outer_header_removal),
         far_id(c.far_id),
         urr_id(c.urr_id),
-        qer_id(c.qer_id),
+        qer_ids(c.qer_ids),
         activate_predefined_rules(c.activate_predefined_rules),
-        notified_cp(false) {}
+        sdf_rule(),
+        notified_cp(false),
+        dl_buffer() {}
 
   pfcp_pdr(const pfcp_pdr& c)
       : lock(),
@@ -86,9 +100,11 @@ class pfcp_pdr {
         outer_header_removal(c.outer_header_removal),
         far_id(c.far_id),
         urr_id(c.urr_id),
-        qer_id(c.qer_id),
+        qer_ids(c.qer_ids),
         activate_predefined_rules(c.activate_predefined_rules),
-        notified_cp(c.notified_cp) {
+        sdf_rule(c.sdf_rule),
+        notified_cp(c.notified_cp.load()),
+        dl_buffer() {
     local_seid = c.local_seid;
     pdr_id     = c.pdr_id;
   }
@@ -116,10 +132,7 @@ class pfcp_pdr {
     urr_id.first  = true;
     urr_id.second = v;
   }
-  void set(const pfcp::qer_id_t& v) {
-    qer_id.first  = true;
-    qer_id.second = v;
-  }
+  void set(const pfcp::qer_id_t& v) { qer_ids.push_back(v); }
   void set(const pfcp::activate_predefined_rules_t& v) {
     activate_predefined_rules.first  = true;
     activate_predefined_rules.second = v;
@@ -169,8 +182,8 @@ class pfcp_pdr {
     return false;
   }
   bool get(pfcp::qer_id_t& v) const {
-    if (qer_id.first) {
-      v = qer_id.second;
+    if (qer_ids.size()) {
+      v = qer_ids[0];
       return true;
     }
     return false;
@@ -185,14 +198,22 @@ class pfcp_pdr {
 
   bool update(const pfcp::update_pdr& update, uint8_t& cause_value);
 
-  bool look_up_pack_in_access(
-      struct iphdr* const iph, const std::size_t num_bytes,
-      const endpoint& r_endpoint, const uint32_t tunnel_id);
-  bool look_up_pack_in_core(
-      struct iphdr* const iph, const std::size_t num_bytes);
+  // Parse the flow description of the SDF filter of a PDI, sdf_rule.first is
+  // false if there is no flow description
+  static bool compile_sdf_filter(
+      const pfcp::pdi& pdi, std::pair<bool, pfcp::sdf_filter_rule>& sdf_rule,
+      std::string& error);
+  bool compile_sdf_filter(std::string& error) {
+    return compile_sdf_filter(pdi.second, sdf_rule, error);
+  }
 
   void buffering_requested(const char* buffer, const std::size_t num_bytes);
-  void notify_cp_requested(std::shared_ptr<pfcp::pfcp_session> session);
+  void notify_cp_requested(const pfcp::fseid_t& cp_fseid);
+
+  // Flatten this PDR for the packet path, returns false if the PDR can never
+  // match a packet coming from the access side (access true) or from the core
+  // side (access false)
+  bool compile(pfcp::fast_path_rule_t& rule, const bool access) const;
 
   // For sorting in collections
   bool operator<(const pfcp_pdr& rhs) const {
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_qer.cpp
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_qer.hpp"
+
+using namespace pfcp;
+
+//------------------------------------------------------------------------------
+void qer_bucket::set_rate(const uint64_t kbps) {
+  if (not kbps) {
+    ticks_per_byte_.store(0, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t bytes_per_second = kbps * 1000 / 8;
+  uint64_t credit = bytes_per_second * PFCP_QER_CREDIT_MICROSECONDS / 1000000;
+  credit          = std::min(
+      std::max(credit, (uint64_t) PFCP_QER_MIN_CREDIT_BYTES),
+      (uint64_t) PFCP_QER_MAX_CREDIT_BYTES);
+  const uint64_t ticks_per_byte =
+      std::max((uint64_t)(((double) util::tsc::hz() * 65536.0) /
+                          (double) bytes_per_second),
+               (uint64_t) 1);
+  // At least one credit must fit in the burst
+  const uint64_t tolerance = std::max(
+      util::tsc::hz() / 1000 * PFCP_QER_BURST_MILLISECONDS,
+      (credit * ticks_per_byte) >> 16);
+  credit_bytes_.store(credit, std::memory_order_relaxed);
+  tolerance_.store(tolerance, std::memory_order_relaxed);
+  ticks_per_byte_.store(ticks_per_byte, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+pfcp_qer::pfcp_qer(const pfcp::create_qer& c)
+    : num_workers_(util::qsbr::get_instance().num_reader_ids()),
+      workers_(new qer_worker_slot_t[num_workers_]),
+      others_(),
+      qer_id(c.qer_id.second),
+      qer_correlation_id(c.qer_correlation_id),
+      gate_status(c.gate_status.second),
+      maximum_bitrate(c.maximum_bitrate),
+      guaranteed_bitrate(c.guaranteed_bitrate) {
+  for (std::size_t i = 0; i < num_workers_; i++) {
+    qer_worker_slot_t& s = workers_[i];
+    for (int d = 0; d < 2; d++) {
+      s.mbr_credit[d].store(0, std::memory_order_relaxed);
+      s.gbr_credit[d].store(0, std::memory_order_relaxed);
+    }
+    s.dropped_gate.store(0, std::memory_order_relaxed);
+    s.dropped_mbr.store(0, std::memory_order_relaxed);
+    s.marked.store(0, std::memory_order_relaxed);
+  }
+  others_.dropped_gate.store(0, std::memory_order_relaxed);
+  others_.dropped_mbr.store(0, std::memory_order_relaxed);
+  others_.marked.store(0, std::memory_order_relaxed);
+  apply_rates();
+}
+//------------------------------------------------------------------------------
+void pfcp_qer::apply_rates() {
+  gate_open_[1].store(gate_status.ul_gate == OPEN, std::memory_order_relaxed);
+  gate_open_[0].store(gate_status.dl_gate == OPEN, std::memory_order_relaxed);
+  mbr_[1].set_rate(
+      (maximum_bitrate.first) ? maximum_bitrate.second.ul_mbr : 0);
+  mbr_[0].set_rate(
+      (maximum_bitrate.first) ? maximum_bitrate.second.dl_mbr : 0);
+  gbr_[1].set_rate(
+      (guaranteed_bitrate.first) ? guaranteed_bitrate.second.ul_gbr : 0);
+  gbr_[0].set_rate(
+      (guaranteed_bitrate.first) ? guaranteed_bitrate.second.dl_gbr : 0);
+}
+//------------------------------------------------------------------------------
+bool pfcp_qer::update(const pfcp::update_qer& update, uint8_t& cause_value) {
+  if (update.qer_correlation_id.first) {
+    qer_correlation_id = update.qer_correlation_id;
+  }
+  if (update.gate_status.first) {
+    gate_status = update.gate_status.second;
+  }
+  if (update.maximum_bitrate.first) {
+    maximum_bitrate = update.maximum_bitrate;
+  }
+  if (update.guaranteed_bitrate.first) {
+    guaranteed_bitrate = update.guaranteed_bitrate;
+  }
+  apply_rates();
+  return true;
+}
+//------------------------------------------------------------------------------
+void pfcp_qer::get_counters(qer_counters_t& counters) const {
+  counters.dropped_gate = others_.dropped_gate.load(std::memory_order_relaxed);
+  counters.dropped_mbr  = others_.dropped_mbr.load(std::memory_order_relaxed);
+  counters.marked       = others_.marked.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < num_workers_; i++) {
+    const qer_worker_slot_t& s = workers_[i];
+    counters.dropped_gate += s.dropped_gate.load(std::memory_order_relaxed);
+    counters.dropped_mbr += s.dropped_mbr.load(std::memory_order_relaxed);
+    counters.marked += s.marked.load(std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,219 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_qer.hpp
+   \brief QoS Enforcement Rules, gating and MBR policing on the packet path
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_QER_HPP_SEEN
+#define FILE_PFCP_QER_HPP_SEEN
+
+#include "msg_pfcp.hpp"
+#include "qsbr.hpp"
+#include "tsc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace pfcp {
+
+#define PFCP_QER_CACHE_LINE_SIZE 64
+// Traffic may exceed the bit rate by bursts of this duration
+#define PFCP_QER_BURST_MILLISECONDS 20
+// Bytes a packet worker takes at once from a bucket: this duration of
+// traffic at the bit rate, bounded
+#define PFCP_QER_CREDIT_MICROSECONDS 500
+#define PFCP_QER_MIN_CREDIT_BYTES 2048
+#define PFCP_QER_MAX_CREDIT_BYTES 65536
+
+typedef struct qer_counters_s {
+  // Gate closed
+  uint64_t dropped_gate;
+  // Above the MBR
+  uint64_t dropped_mbr;
+  // Forwarded above the GBR
+  uint64_t marked;
+} qer_counters_t;
+
+// Token bucket of one direction, shaped as a GCRA (virtual scheduling): the
+// theoretical arrival time of the next byte is the only shared state, it is
+// advanced with one compare and swap, time is counted in TSC ticks.
+class qer_bucket {
+ private:
+  // TSC ticks per byte, 16.16 fixed point, 0 if no limit
+  std::atomic<uint64_t> ticks_per_byte_;
+  // Burst tolerance, TSC ticks
+  std::atomic<uint64_t> tolerance_;
+  // Credit taken at once by the packet workers, bytes
+  std::atomic<uint64_t> credit_bytes_;
+  alignas(PFCP_QER_CACHE_LINE_SIZE) std::atomic<uint64_t> tat_;
+
+ public:
+  qer_bucket()
+      : ticks_per_byte_(0), tolerance_(0), credit_bytes_(0), tat_(0) {}
+  qer_bucket(const qer_bucket&) = delete;
+  void operator=(const qer_bucket&) = delete;
+
+  // Control path, 0 kbps means no limit
+  void set_rate(const uint64_t kbps);
+
+  bool unlimited() const {
+    return not ticks_per_byte_.load(std::memory_order_relaxed);
+  }
+  uint64_t credit_bytes() const {
+    return credit_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Packet workers
+  bool take(const uint64_t num_bytes, const uint64_t now) {
+    const uint64_t cost =
+        (num_bytes * ticks_per_byte_.load(std::memory_order_relaxed)) >> 16;
+    const uint64_t tolerance = tolerance_.load(std::memory_order_relaxed);
+    uint64_t tat             = tat_.load(std::memory_order_relaxed);
+    uint64_t start           = 0;
+    do {
+      start = std::max(tat, now);
+      if (start - now > tolerance) {
+        return false;
+      }
+    } while (not tat_.compare_exchange_weak(
+        tat, start + cost, std::memory_order_relaxed));
+    return true;
+  }
+};
+
+// Credits and counters of one packet worker, only this worker writes them
+typedef struct alignas(PFCP_QER_CACHE_LINE_SIZE) qer_worker_slot_s {
+  // Bytes left from the credit taken from the buckets, index 1 is uplink
+  std::atomic<uint64_t> mbr_credit[2];
+  std::atomic<uint64_t> gbr_credit[2];
+  std::atomic<uint64_t> dropped_gate;
+  std::atomic<uint64_t> dropped_mbr;
+  std::atomic<uint64_t> marked;
+} qer_worker_slot_t;
+
+class pfcp_qer {
+ private:
+  // Index 1 is uplink
+  std::atomic<bool> gate_open_[2];
+  qer_bucket mbr_[2];
+  qer_bucket gbr_[2];
+
+  // One slot per packet worker registered in util::qsbr when the QER was
+  // created, other threads do not keep credit and share others_
+  std::size_t num_workers_;
+  std::unique_ptr<qer_worker_slot_t[]> workers_;
+  qer_worker_slot_t others_;
+
+  static inline void add(std::atomic<uint64_t>& c, const uint64_t n) {
+    c.store(
+        c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  // Most packets only consume the credit of their worker, the shared bucket
+  // is touched once per credit
+  static inline bool conform(
+      qer_bucket& bucket, std::atomic<uint64_t>* credit,
+      const uint64_t num_bytes) {
+    if (bucket.unlimited()) {
+      return true;
+    }
+    if (not credit) {
+      return bucket.take(num_bytes, util::tsc::now());
+    }
+    const uint64_t c = credit->load(std::memory_order_relaxed);
+    if (c >= num_bytes) {
+      credit->store(c - num_bytes, std::memory_order_relaxed);
+      return true;
+    }
+    const uint64_t now   = util::tsc::now();
+    const uint64_t chunk = std::max(bucket.credit_bytes(), num_bytes);
+    if (bucket.take(chunk, now)) {
+      credit->store(c + chunk - num_bytes, std::memory_order_relaxed);
+      return true;
+    }
+    if (bucket.take(num_bytes - c, now)) {
+      credit->store(0, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void apply_rates();
+
+ public:
+  pfcp::qer_id_t qer_id;
+  std::pair<bool, pfcp::qer_correlation_id_t> qer_correlation_id;
+  pfcp::gate_status_t gate_status;
+  std::pair<bool, pfcp::mbr_t> maximum_bitrate;
+  std::pair<bool, pfcp::gbr_t> guaranteed_bitrate;
+
+  explicit pfcp_qer(const pfcp::create_qer& c);
+  pfcp_qer(const pfcp_qer&) = delete;
+  void operator=(const pfcp_qer&) = delete;
+
+  bool update(const pfcp::update_qer& update, uint8_t& cause_value);
+
+  // Packet workers: false if the packet must be dropped
+  bool enforce(const bool uplink, const std::size_t num_bytes) {
+    const int id = util::qsbr::reader_id();
+    const bool own = (id >= 0) && ((std::size_t) id < num_workers_);
+    qer_worker_slot_t& slot = (own) ? workers_[id] : others_;
+    if (not gate_open_[uplink].load(std::memory_order_relaxed)) {
+      if (own) {
+        add(slot.dropped_gate, 1);
+      } else {
+        slot.dropped_gate.fetch_add(1, std::memory_order_relaxed);
+      }
+      return false;
+    }
+    if (not conform(
+            mbr_[uplink], (own) ? &slot.mbr_credit[uplink] : nullptr,
+            num_bytes)) {
+      if (own) {
+        add(slot.dropped_mbr, 1);
+      } else {
+        slot.dropped_mbr.fetch_add(1, std::memory_order_relaxed);
+      }
+      return false;
+    }
+    if (not conform(
+            gbr_[uplink], (own) ? &slot.gbr_credit[uplink] : nullptr,
+            num_bytes)) {
+      if (own) {
+        add(slot.marked, 1);
+      } else {
+        slot.marked.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    return true;
+  }
+
+  // Control path: sum of all the workers since the creation
+  void get_counters(qer_counters_t& counters) const;
+};
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_QER_HPP_SEEN */
@@ -0,0 +1,548 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_sdf_filter.cpp
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_sdf_filter.hpp"
+
+#include <arpa/inet.h>
+#include <climits>
+#include <sstream>
+#include <string.h>
+
+using namespace pfcp;
+
+namespace {
+//------------------------------------------------------------------------------
+void ipv6_prefix_mask(const int prefix_len, struct in6_addr& mask) {
+  for (int i = 0; i < 16; i++) {
+    int bits        = std::min(8, std::max(0, prefix_len - 8 * i));
+    mask.s6_addr[i] = (uint8_t)(0xFF00 >> bits);
+  }
+}
+//------------------------------------------------------------------------------
+bool ipv6_masked_equal(
+    const struct in6_addr& a, const struct in6_addr& mask,
+    const struct in6_addr& masked) {
+  return ((a.s6_addr32[0] & mask.s6_addr32[0]) == masked.s6_addr32[0]) &&
+         ((a.s6_addr32[1] & mask.s6_addr32[1]) == masked.s6_addr32[1]) &&
+         ((a.s6_addr32[2] & mask.s6_addr32[2]) == masked.s6_addr32[2]) &&
+         ((a.s6_addr32[3] & mask.s6_addr32[3]) == masked.s6_addr32[3]);
+}
+//------------------------------------------------------------------------------
+bool parse_proto(const std::string& s, bool& any_proto, uint8_t& proto) {
+  static const std::unordered_map<std::string, uint8_t> names = {
+      {"icmp", IPPROTO_ICMP}, {"tcp", IPPROTO_TCP},   {"udp", IPPROTO_UDP},
+      {"gre", IPPROTO_GRE},   {"esp", IPPROTO_ESP},   {"ah", IPPROTO_AH},
+      {"sctp", IPPROTO_SCTP}, {"ipv6-icmp", IPPROTO_ICMPV6}};
+  any_proto = false;
+  if (s == "ip") {
+    any_proto = true;
+    return true;
+  }
+  auto it = names.find(s);
+  if (it != names.end()) {
+    proto = it->second;
+    return true;
+  }
+  char* end           = nullptr;
+  unsigned long value = strtoul(s.c_str(), &end, 10);
+  if (s.empty() || (*end != '\0') || (value > 255)) return false;
+  proto = (uint8_t) value;
+  return true;
+}
+//------------------------------------------------------------------------------
+// "any", "assigned", IPv4 or IPv6 address with optional prefix length
+bool parse_address(
+    const std::string& s, int& family, struct in_addr& ipv4,
+    struct in_addr& ipv4_mask, struct in6_addr& ipv6,
+    struct in6_addr& ipv6_mask) {
+  if ((s == "any") || (s == "assigned")) {
+    return true;
+  }
+  std::string addr  = s;
+  int prefix_len    = -1;
+  std::size_t slash = s.find('/');
+  if (slash != std::string::npos) {
+    addr       = s.substr(0, slash);
+    char* end  = nullptr;
+    prefix_len = strtol(s.c_str() + slash + 1, &end, 10);
+    if ((*end != '\0') || (prefix_len < 0)) return false;
+  }
+  if (addr.find(':') != std::string::npos) {
+    if ((family == AF_INET) || (prefix_len > 128)) return false;
+    if (inet_pton(AF_INET6, addr.c_str(), &ipv6) != 1) return false;
+    if (prefix_len < 0) prefix_len = 128;
+    ipv6_prefix_mask(prefix_len, ipv6_mask);
+    for (int i = 0; i < 4; i++) {
+      ipv6.s6_addr32[i] &= ipv6_mask.s6_addr32[i];
+    }
+    family = AF_INET6;
+  } else {
+    if ((family == AF_INET6) || (prefix_len > 32)) return false;
+    if (inet_pton(AF_INET, addr.c_str(), &ipv4) != 1) return false;
+    if (prefix_len < 0) prefix_len = 32;
+    ipv4_mask.s_addr =
+        (prefix_len) ? htobe32(0xFFFFFFFF << (32 - prefix_len)) : 0;
+    ipv4.s_addr &= ipv4_mask.s_addr;
+    family = AF_INET;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// "80", "1024-2047", "80,443,8000-8080"
+bool parse_ports(const std::string& s, std::vector<sdf_port_range_t>& ports) {
+  std::istringstream iss(s);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    sdf_port_range_t range = {};
+    char* end              = nullptr;
+    unsigned long low      = strtoul(item.c_str(), &end, 10);
+    unsigned long high     = low;
+    if (*end == '-') {
+      high = strtoul(end + 1, &end, 10);
+    }
+    if (item.empty() || (*end != '\0') || (low > high) || (high > 65535)) {
+      return false;
+    }
+    range.low  = low;
+    range.high = high;
+    ports.push_back(range);
+  }
+  return not ports.empty();
+}
+//------------------------------------------------------------------------------
+bool is_port_list(const std::string& s) {
+  return (not s.empty()) &&
+         (s.find_first_not_of("0123456789,-") == std::string::npos);
+}
+//------------------------------------------------------------------------------
+bool in_ranges(
+    const std::vector<sdf_port_range_t>& ranges, const uint16_t port) {
+  for (const auto& r : ranges) {
+    if ((port >= r.low) && (port <= r.high)) return true;
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+// Exact ports of ranges, (0, true) for any port; false if too many ports
+bool expand_ports(
+    const std::vector<sdf_port_range_t>& ranges, const std::size_t max,
+    std::vector<std::pair<uint16_t, bool>>& ports) {
+  if (ranges.empty()) {
+    ports.push_back(std::make_pair(0, true));
+    return true;
+  }
+  for (const auto& r : ranges) {
+    if (ports.size() + (r.high - r.low + 1) > max) return false;
+    for (uint32_t p = r.low; p <= r.high; p++) {
+      ports.push_back(std::make_pair((uint16_t) p, false));
+    }
+  }
+  return true;
+}
+}  // namespace
+
+//------------------------------------------------------------------------------
+bool pfcp::sdf_flow_key_from_ipv4(
+    const struct iphdr* const iph, const std::size_t num_bytes,
+    const bool uplink, sdf_flow_key_t& key) {
+  if (num_bytes < sizeof(struct iphdr)) return false;
+  const std::size_t ihl = iph->ihl << 2;
+  if ((ihl < sizeof(struct iphdr)) || (num_bytes < ihl)) return false;
+
+  key.proto       = iph->protocol;
+  key.has_ports   = false;
+  key.ue_port     = 0;
+  key.remote_port = 0;
+  if (uplink) {
+    key.ue_ipv4.s_addr     = iph->saddr;
+    key.remote_ipv4.s_addr = iph->daddr;
+  } else {
+    key.ue_ipv4.s_addr     = iph->daddr;
+    key.remote_ipv4.s_addr = iph->saddr;
+  }
+  // Ports are only in the first fragment (null fragment offset)
+  if (((be16toh(iph->frag_off) & 0x1FFF) == 0) &&
+      ((key.proto == IPPROTO_TCP) || (key.proto == IPPROTO_UDP) ||
+       (key.proto == IPPROTO_SCTP)) &&
+      (num_bytes >= ihl + 2 * sizeof(uint16_t))) {
+    uint16_t ports[2] = {};
+    memcpy(ports, (const uint8_t*) iph + ihl, sizeof(ports));
+    key.has_ports = true;
+    if (uplink) {
+      key.ue_port     = be16toh(ports[0]);
+      key.remote_port = be16toh(ports[1]);
+    } else {
+      key.remote_port = be16toh(ports[0]);
+      key.ue_port     = be16toh(ports[1]);
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool pfcp::sdf_flow_key_from_ipv6(
+    const struct ipv6hdr* const ip6h, const std::size_t num_bytes,
+    const bool uplink, sdf_flow_key6_t& key) {
+#define SDF_MAX_IPV6_EXTENSION_HEADERS 8
+  if (num_bytes < sizeof(struct ipv6hdr)) return false;
+  if (uplink) {
+    key.ue_ipv6     = ip6h->saddr;
+    key.remote_ipv6 = ip6h->daddr;
+  } else {
+    key.ue_ipv6     = ip6h->daddr;
+    key.remote_ipv6 = ip6h->saddr;
+  }
+  key.has_ports   = false;
+  key.ue_port     = 0;
+  key.remote_port = 0;
+
+  const uint8_t* p    = (const uint8_t*) ip6h;
+  std::size_t offset  = sizeof(struct ipv6hdr);
+  uint8_t next_header = ip6h->nexthdr;
+  bool first_fragment = true;
+  for (int n = 0; n < SDF_MAX_IPV6_EXTENSION_HEADERS; n++) {
+    if ((next_header != IPPROTO_HOPOPTS) && (next_header != IPPROTO_ROUTING) &&
+        (next_header != IPPROTO_DSTOPTS) && (next_header != IPPROTO_FRAGMENT) &&
+        (next_header != IPPROTO_AH)) {
+      break;
+    }
+    if (num_bytes < offset + 8) return false;
+    std::size_t length = 0;
+    if (next_header == IPPROTO_FRAGMENT) {
+      uint16_t frag_off = 0;
+      memcpy(&frag_off, p + offset + 2, sizeof(frag_off));
+      first_fragment = ((be16toh(frag_off) & 0xFFF8) == 0);
+      length         = 8;
+    } else if (next_header == IPPROTO_AH) {
+      length = (p[offset + 1] + 2) << 2;
+    } else {
+      length = (p[offset + 1] + 1) << 3;
+    }
+    next_header = p[offset];
+    offset += length;
+  }
+  key.proto = next_header;
+  if ((first_fragment) &&
+      ((key.proto == IPPROTO_TCP) || (key.proto == IPPROTO_UDP) ||
+       (key.proto == IPPROTO_SCTP)) &&
+      (num_bytes >= offset + 2 * sizeof(uint16_t))) {
+    uint16_t ports[2] = {};
+    memcpy(ports, p + offset, sizeof(ports));
+    key.has_ports = true;
+    if (uplink) {
+      key.ue_port     = be16toh(ports[0]);
+      key.remote_port = be16toh(ports[1]);
+    } else {
+      key.remote_port = be16toh(ports[0]);
+      key.ue_port     = be16toh(ports[1]);
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool sdf_filter_rule::parse(
+    const std::string& flow_description, std::string& error) {
+  std::istringstream iss(flow_description);
+  std::vector<std::string> tokens = {};
+  std::string token;
+  while (iss >> token) tokens.push_back(token);
+
+  *this    = sdf_filter_rule();
+  size_t i = 0;
+  if ((tokens.size() < 7) || (tokens[0] != "permit")) {
+    error = "only \"permit <dir> <proto> from <addr> to <addr>\" supported";
+    return false;
+  }
+  if ((tokens[1] != "out") && (tokens[1] != "in")) {
+    error = "bad direction " + tokens[1];
+    return false;
+  }
+  if (not parse_proto(tokens[2], any_proto, proto)) {
+    error = "bad protocol " + tokens[2];
+    return false;
+  }
+  if (tokens[3] != "from") {
+    error = "\"from\" expected";
+    return false;
+  }
+  i = 4;
+  // Remote side
+  if (not parse_address(
+          tokens[i], family, remote_ipv4, remote_ipv4_mask, remote_ipv6,
+          remote_ipv6_mask)) {
+    error = "bad source address " + tokens[i];
+    return false;
+  }
+  i++;
+  if ((i < tokens.size()) && is_port_list(tokens[i])) {
+    if (not parse_ports(tokens[i], remote_ports)) {
+      error = "bad source ports " + tokens[i];
+      return false;
+    }
+    i++;
+  }
+  if ((i >= tokens.size()) || (tokens[i] != "to")) {
+    error = "\"to\" expected";
+    return false;
+  }
+  i++;
+  // UE side
+  if ((i >= tokens.size()) ||
+      (not parse_address(
+          tokens[i], family, ue_ipv4, ue_ipv4_mask, ue_ipv6, ue_ipv6_mask))) {
+    error = "bad destination address";
+    return false;
+  }
+  i++;
+  if ((i < tokens.size()) && is_port_list(tokens[i])) {
+    if (not parse_ports(tokens[i], ue_ports)) {
+      error = "bad destination ports " + tokens[i];
+      return false;
+    }
+    i++;
+  }
+  // Options (frag, established, ...) are not used by the PCRF/SMF
+  return true;
+}
+//------------------------------------------------------------------------------
+bool sdf_filter_rule::match(const sdf_flow_key_t& key) const {
+  if (family == AF_INET6) return false;
+  if ((not any_proto) && (proto != key.proto)) return false;
+  if ((key.remote_ipv4.s_addr & remote_ipv4_mask.s_addr) !=
+      remote_ipv4.s_addr) {
+    return false;
+  }
+  if ((key.ue_ipv4.s_addr & ue_ipv4_mask.s_addr) != ue_ipv4.s_addr) {
+    return false;
+  }
+  if (not remote_ports.empty()) {
+    if ((not key.has_ports) || (not in_ranges(remote_ports, key.remote_port)))
+      return false;
+  }
+  if (not ue_ports.empty()) {
+    if ((not key.has_ports) || (not in_ranges(ue_ports, key.ue_port)))
+      return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+bool sdf_filter_rule::match(const sdf_flow_key6_t& key) const {
+  if (family == AF_INET) return false;
+  if ((not any_proto) && (proto != key.proto)) return false;
+  if (not ipv6_masked_equal(key.remote_ipv6, remote_ipv6_mask, remote_ipv6)) {
+    return false;
+  }
+  if (not ipv6_masked_equal(key.ue_ipv6, ue_ipv6_mask, ue_ipv6)) {
+    return false;
+  }
+  if (not remote_ports.empty()) {
+    if ((not key.has_ports) || (not in_ranges(remote_ports, key.remote_port)))
+      return false;
+  }
+  if (not ue_ports.empty()) {
+    if ((not key.has_ports) || (not in_ranges(ue_ports, key.ue_port)))
+      return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+void sdf_filter_rule::set_ue_ipv4_if_any(const struct in_addr& addr) {
+  if ((family != AF_INET6) && (ue_ipv4_mask.s_addr == 0)) {
+    ue_ipv4.s_addr      = addr.s_addr;
+    ue_ipv4_mask.s_addr = 0xFFFFFFFF;
+    family              = AF_INET;
+  }
+}
+//------------------------------------------------------------------------------
+void sdf_filter_rule::set_ue_ipv6_prefix_if_any(
+    const struct in6_addr& prefix, const int prefix_len) {
+  if ((family != AF_INET) &&
+      ((ue_ipv6_mask.s6_addr32[0] | ue_ipv6_mask.s6_addr32[1] |
+        ue_ipv6_mask.s6_addr32[2] | ue_ipv6_mask.s6_addr32[3]) == 0)) {
+    ipv6_prefix_mask(prefix_len, ue_ipv6_mask);
+    for (int i = 0; i < 4; i++) {
+      ue_ipv6.s6_addr32[i] = prefix.s6_addr32[i] & ue_ipv6_mask.s6_addr32[i];
+    }
+    family = AF_INET6;
+  }
+}
+//------------------------------------------------------------------------------
+std::string sdf_filter_rule::to_string() const {
+  std::string s = (any_proto) ? "ip" : std::to_string(proto);
+  char buf[INET6_ADDRSTRLEN];
+  if (family == AF_INET6) {
+    s.append(" from ");
+    s.append(inet_ntop(AF_INET6, &remote_ipv6, buf, sizeof(buf)));
+    s.append(" to ");
+    s.append(inet_ntop(AF_INET6, &ue_ipv6, buf, sizeof(buf)));
+  } else {
+    s.append(" from ");
+    s.append(inet_ntop(AF_INET, &remote_ipv4, buf, sizeof(buf)));
+    s.append("/" + std::to_string(__builtin_popcount(remote_ipv4_mask.s_addr)));
+    s.append(" to ");
+    s.append(inet_ntop(AF_INET, &ue_ipv4, buf, sizeof(buf)));
+    s.append("/" + std::to_string(__builtin_popcount(ue_ipv4_mask.s_addr)));
+  }
+  return s;
+}
+
+//------------------------------------------------------------------------------
+void sdf_classifier::add_exact(
+    const int index, const sdf_filter_rule& f, const uint16_t remote_port,
+    const bool remote_port_any, const uint16_t ue_port,
+    const bool ue_port_any) {
+  tuple_key_t mask = {};
+  mask.remote_ipv4 = f.remote_ipv4_mask.s_addr;
+  mask.ue_ipv4     = f.ue_ipv4_mask.s_addr;
+  mask.remote_port = (remote_port_any) ? 0 : 0xFFFF;
+  mask.ue_port     = (ue_port_any) ? 0 : 0xFFFF;
+  mask.proto       = (f.any_proto) ? 0 : 0xFF;
+
+  tuple_key_t key = {};
+  key.remote_ipv4 = f.remote_ipv4.s_addr & mask.remote_ipv4;
+  key.ue_ipv4     = f.ue_ipv4.s_addr & mask.ue_ipv4;
+  key.remote_port = remote_port & mask.remote_port;
+  key.ue_port     = ue_port & mask.ue_port;
+  key.proto       = f.proto & mask.proto;
+
+  for (auto& t : tuples_) {
+    if (t.mask == mask) {
+      // Keep the first (best) rule for a given key
+      t.rules.emplace(key, index);
+      return;
+    }
+  }
+  // Rules are added by increasing index, tuples stay sorted by min_index
+  tuple_t t   = {};
+  t.mask      = mask;
+  t.min_index = index;
+  t.rules.emplace(key, index);
+  tuples_.push_back(std::move(t));
+}
+//------------------------------------------------------------------------------
+void sdf_classifier::insert(const int index, const sdf_filter_rule& filter) {
+  std::vector<std::pair<uint16_t, bool>> remote_ports = {};
+  std::vector<std::pair<uint16_t, bool>> ue_ports     = {};
+  if ((not expand_ports(
+          filter.remote_ports, SDF_CLASSIFIER_MAX_PORT_RANGE_EXPANSION,
+          remote_ports)) ||
+      (not expand_ports(
+          filter.ue_ports, SDF_CLASSIFIER_MAX_PORT_RANGE_EXPANSION,
+          ue_ports))) {
+    linear_.push_back(std::make_pair(index, filter));
+    return;
+  }
+  for (const auto& rp : remote_ports) {
+    for (const auto& up : ue_ports) {
+      add_exact(index, filter, rp.first, rp.second, up.first, up.second);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+void sdf_classifier::add(const int index, const sdf_filter_rule* const filter) {
+  if (match_all_ >= 0) {
+    // Shadowed by a rule of higher precedence matching everything
+    return;
+  }
+  if (filter == nullptr) {
+    match_all_ = index;
+    return;
+  }
+  if (filter->family == AF_INET6) {
+    // Never matches an IPv4 packet
+    return;
+  }
+  if (tuple_search_) {
+    insert(index, *filter);
+    return;
+  }
+  linear_.push_back(std::make_pair(index, *filter));
+  if (linear_.size() > SDF_CLASSIFIER_MAX_LINEAR_RULES) {
+    // Too many filters for a linear search, switch to tuple space search
+    std::vector<std::pair<int, sdf_filter_rule>> filters = {};
+    filters.swap(linear_);
+    tuple_search_ = true;
+    for (const auto& f : filters) {
+      insert(f.first, f.second);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+int sdf_classifier::classify(const sdf_flow_key_t& key) const {
+  int best = (match_all_ >= 0) ? match_all_ : INT_MAX;
+  for (const auto& t : tuples_) {
+    if (t.min_index >= best) break;
+    if ((not key.has_ports) && (t.mask.remote_port || t.mask.ue_port)) {
+      continue;
+    }
+    tuple_key_t k = {};
+    k.remote_ipv4 = key.remote_ipv4.s_addr & t.mask.remote_ipv4;
+    k.ue_ipv4     = key.ue_ipv4.s_addr & t.mask.ue_ipv4;
+    k.remote_port = key.remote_port & t.mask.remote_port;
+    k.ue_port     = key.ue_port & t.mask.ue_port;
+    k.proto       = key.proto & t.mask.proto;
+    auto it       = t.rules.find(k);
+    if ((it != t.rules.end()) && (it->second < best)) {
+      best = it->second;
+    }
+  }
+  for (const auto& l : linear_) {
+    if (l.first >= best) break;
+    if (l.second.match(key)) {
+      best = l.first;
+      break;
+    }
+  }
+  return (best == INT_MAX) ? -1 : best;
+}
+//------------------------------------------------------------------------------
+void sdf_classifier::add6(
+    const int index, const sdf_filter_rule* const filter) {
+  if (match_all6_ >= 0) {
+    return;
+  }
+  if (filter == nullptr) {
+    match_all6_ = index;
+    return;
+  }
+  if (filter->family == AF_INET) {
+    // Never matches an IPv6 packet
+    return;
+  }
+  linear6_.push_back(std::make_pair(index, *filter));
+}
+//------------------------------------------------------------------------------
+int sdf_classifier::classify(const sdf_flow_key6_t& key) const {
+  for (const auto& l : linear6_) {
+    if ((match_all6_ >= 0) && (l.first >= match_all6_)) break;
+    if (l.second.match(key)) {
+      return l.first;
+    }
+  }
+  return match_all6_;
+}
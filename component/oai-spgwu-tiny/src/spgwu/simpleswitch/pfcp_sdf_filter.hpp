@@ -0,0 +1,206 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_sdf_filter.hpp
+   \brief SDF filters (IPFilterRule flow descriptions) compiled for the packet
+          path, and the per UE packet classifier built on them
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_SDF_FILTER_HPP_SEEN
+#define FILE_PFCP_SDF_FILTER_HPP_SEEN
+
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pfcp {
+
+// 5-tuple of a packet seen from the UE: UE side and remote side
+typedef struct sdf_flow_key_s {
+  uint8_t proto;
+  // false for protocols without ports and for non first fragments
+  bool has_ports;
+  struct in_addr ue_ipv4;      // network byte order
+  struct in_addr remote_ipv4;  // network byte order
+  uint16_t ue_port;            // host byte order
+  uint16_t remote_port;        // host byte order
+} sdf_flow_key_t;
+
+// Fill key from an IPv4 packet, UL packets are sent by the UE
+bool sdf_flow_key_from_ipv4(
+    const struct iphdr* const iph, const std::size_t num_bytes,
+    const bool uplink, sdf_flow_key_t& key);
+
+typedef struct sdf_flow_key6_s {
+  // Upper layer protocol, after the extension headers
+  uint8_t proto;
+  bool has_ports;
+  struct in6_addr ue_ipv6;
+  struct in6_addr remote_ipv6;
+  uint16_t ue_port;      // host byte order
+  uint16_t remote_port;  // host byte order
+} sdf_flow_key6_t;
+
+// Fill key from an IPv6 packet, UL packets are sent by the UE
+bool sdf_flow_key_from_ipv6(
+    const struct ipv6hdr* const ip6h, const std::size_t num_bytes,
+    const bool uplink, sdf_flow_key6_t& key);
+
+typedef struct sdf_port_range_s {
+  uint16_t low;
+  uint16_t high;
+} sdf_port_range_t;
+
+// Flow description of an SDF filter, IPFilterRule syntax (TS 29.212 5.4.2):
+//   permit out <proto> from <remote> [ports] to <UE> [ports]
+// The direction "out" is the DL one, for UL packets source and destination
+// are swapped, so the rule is stored from the UE point of view.
+class sdf_filter_rule {
+ public:
+  bool any_proto;
+  uint8_t proto;
+  // AF_INET or AF_INET6 if an address is given, else AF_UNSPEC (any family)
+  int family;
+  struct in_addr remote_ipv4;
+  struct in_addr remote_ipv4_mask;
+  struct in_addr ue_ipv4;
+  struct in_addr ue_ipv4_mask;
+  struct in6_addr remote_ipv6;
+  struct in6_addr remote_ipv6_mask;
+  struct in6_addr ue_ipv6;
+  struct in6_addr ue_ipv6_mask;
+  // Empty means any port
+  std::vector<sdf_port_range_t> remote_ports;
+  std::vector<sdf_port_range_t> ue_ports;
+
+  sdf_filter_rule()
+      : any_proto(true),
+        proto(0),
+        family(AF_UNSPEC),
+        remote_ipv4(),
+        remote_ipv4_mask(),
+        ue_ipv4(),
+        ue_ipv4_mask(),
+        remote_ipv6(),
+        remote_ipv6_mask(),
+        ue_ipv6(),
+        ue_ipv6_mask(),
+        remote_ports(),
+        ue_ports() {}
+
+  // Returns false and a reason in error if flow_description is not valid
+  bool parse(const std::string& flow_description, std::string& error);
+  bool match(const sdf_flow_key_t& key) const;
+  bool match(const sdf_flow_key6_t& key) const;
+  // Restrict the UE side to one IPv4 address if no address was given
+  void set_ue_ipv4_if_any(const struct in_addr& addr);
+  // Restrict the UE side to one IPv6 prefix if no address was given
+  void set_ue_ipv6_prefix_if_any(
+      const struct in6_addr& prefix, const int prefix_len);
+  std::string to_string() const;
+};
+
+// Finds the first matching rule (lowest index) among the SDF filters of the
+// PDRs reachable by one key, by tuple space search: filters are grouped by
+// the set of fields they look at (prefix lengths, protocol, port or any
+// port), each group is one exact match hash lookup on the masked packet key.
+// Port ranges that cannot be expanded are matched linearly, as are all the
+// filters while there are only a few of them (cheaper).
+// IPv6 filters are kept apart and always matched linearly, an entry keyed by
+// a UE /64 prefix or a TEID seldom has more than a few of them.
+class sdf_classifier {
+ private:
+#define SDF_CLASSIFIER_MAX_PORT_RANGE_EXPANSION 16
+#define SDF_CLASSIFIER_MAX_LINEAR_RULES 8
+
+  typedef struct tuple_key_s {
+    uint32_t remote_ipv4;
+    uint32_t ue_ipv4;
+    uint16_t remote_port;
+    uint16_t ue_port;
+    uint8_t proto;
+
+    bool operator==(const struct tuple_key_s& k) const {
+      return (remote_ipv4 == k.remote_ipv4) && (ue_ipv4 == k.ue_ipv4) &&
+             (remote_port == k.remote_port) && (ue_port == k.ue_port) &&
+             (proto == k.proto);
+    }
+  } tuple_key_t;
+
+  struct tuple_key_hash {
+    std::size_t operator()(const tuple_key_t& k) const {
+      uint64_t h = ((uint64_t) k.remote_ipv4 << 32) ^ k.ue_ipv4;
+      h ^= ((uint64_t) k.remote_port << 40) ^ ((uint64_t) k.ue_port << 16) ^
+           k.proto;
+      return (std::size_t)(h * 0x9E3779B97F4A7C15ULL >> 16);
+    }
+  };
+
+  typedef struct tuple_s {
+    tuple_key_t mask;
+    // Lowest rule index of the tuple, to skip it when a better rule matched
+    int min_index;
+    std::unordered_map<tuple_key_t, int, tuple_key_hash> rules;
+  } tuple_t;
+
+  std::vector<tuple_t> tuples_;
+  std::vector<std::pair<int, sdf_filter_rule>> linear_;
+  // false while all the filters are in linear_
+  bool tuple_search_;
+  // Index of the first rule matching every packet, -1 if none
+  int match_all_;
+  std::vector<std::pair<int, sdf_filter_rule>> linear6_;
+  int match_all6_;
+
+  void insert(const int index, const sdf_filter_rule& filter);
+  void add_exact(
+      const int index, const sdf_filter_rule& f, const uint16_t remote_port,
+      const bool remote_port_any, const uint16_t ue_port,
+      const bool ue_port_any);
+
+ public:
+  sdf_classifier()
+      : tuples_(),
+        linear_(),
+        tuple_search_(false),
+        match_all_(-1),
+        linear6_(),
+        match_all6_(-1) {}
+
+  // Rules must be added by increasing index, filter nullptr matches all.
+  // add() is for IPv4 packets, add6() for IPv6 packets.
+  void add(const int index, const sdf_filter_rule* const filter);
+  void add6(const int index, const sdf_filter_rule* const filter);
+  // Index of the first rule matching key, -1 if none
+  int classify(const sdf_flow_key_t& key) const;
+  int classify(const sdf_flow_key6_t& key) const;
+  std::size_t num_tuples() const { return tuples_.size(); }
+};
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_SDF_FILTER_HPP_SEEN */
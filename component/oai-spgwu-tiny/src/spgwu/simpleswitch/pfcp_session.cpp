@@ -28,10 +28,14 @@
 #include "pfcp_session.hpp"
 #include "pfcp_switch.hpp"
 #include "logger.hpp"
+#include "spgwu_config.hpp"
+
+#include <algorithm>
 
 using namespace pfcp;
 
 extern spgwu::pfcp_switch* pfcp_switch_inst;
+extern spgwu::spgwu_config spgwu_cfg;
 
 //------------------------------------------------------------------------------
 bool pfcp_session::get(
@@ -56,6 +60,28 @@ bool pfcp_session::get(
   return false;
 }
 //------------------------------------------------------------------------------
+bool pfcp_session::get(
+    const pfcp::qer_id_t& qer_id, std::shared_ptr<pfcp::pfcp_qer>& qer) const {
+  for (auto it : qers) {
+    if (it->qer_id.qer_id == qer_id.qer_id) {
+      qer = it;
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::get(
+    const pfcp::urr_id_t& urr_id, std::shared_ptr<pfcp::pfcp_urr>& urr) const {
+  for (auto it : urrs) {
+    if (it->urr_id.urr_id == urr_id.urr_id) {
+      urr = it;
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
 void pfcp_session::add(std::shared_ptr<pfcp::pfcp_far> far) {
   Logger::spgwu_sx().info("pfcp_session::add(far) seid " SEID_FMT " ", seid);
   fars.push_back(far);
@@ -66,6 +92,16 @@ void pfcp_session::add(std::shared_ptr<pfcp::pfcp_pdr> pdr) {
   pdrs.push_back(pdr);
 }
 //------------------------------------------------------------------------------
+void pfcp_session::add(std::shared_ptr<pfcp::pfcp_qer> qer) {
+  Logger::spgwu_sx().info("pfcp_session::add(qer) seid " SEID_FMT " ", seid);
+  qers.push_back(qer);
+}
+//------------------------------------------------------------------------------
+void pfcp_session::add(std::shared_ptr<pfcp::pfcp_urr> urr) {
+  Logger::spgwu_sx().info("pfcp_session::add(urr) seid " SEID_FMT " ", seid);
+  urrs.push_back(urr);
+}
+//------------------------------------------------------------------------------
 bool pfcp_session::remove(const pfcp::far_id_t& far_id, uint8_t& cause_value) {
   for (std::vector<std::shared_ptr<pfcp::pfcp_far>>::iterator it = fars.begin();
        it != fars.end(); ++it) {
@@ -86,6 +122,10 @@ bool pfcp_session::remove(const pfcp::pdr_id_t& pdr_id, uint8_t& cause_value) {
     if ((*it)->pdr_id.rule_id == pdr_id.rule_id) {
       Logger::spgwu_sx().info(
           "pfcp_session::remove(pdr) seid " SEID_FMT " ", seid);
+      if (((*it)->pdi.first) && ((*it)->pdi.second.local_fteid.first)) {
+        pfcp_switch_inst->free_teid_s1u(
+            (*it)->pdi.second.local_fteid.second.teid);
+      }
       pdrs.erase(it);
       return true;
     }
@@ -94,6 +134,254 @@ bool pfcp_session::remove(const pfcp::pdr_id_t& pdr_id, uint8_t& cause_value) {
   return false;
 }
 //------------------------------------------------------------------------------
+bool pfcp_session::remove(const pfcp::qer_id_t& qer_id, uint8_t& cause_value) {
+  for (std::vector<std::shared_ptr<pfcp::pfcp_qer>>::iterator it = qers.begin();
+       it != qers.end(); ++it) {
+    if ((*it)->qer_id.qer_id == qer_id.qer_id) {
+      trace_counters(*it->get());
+      qers.erase(it);
+      return true;
+    }
+  }
+  cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;  //??
+  return false;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::remove(const pfcp::urr_id_t& urr_id, uint8_t& cause_value) {
+  for (std::vector<std::shared_ptr<pfcp::pfcp_urr>>::iterator it = urrs.begin();
+       it != urrs.end(); ++it) {
+    if ((*it)->urr_id.urr_id == urr_id.urr_id) {
+      Logger::spgwu_sx().info(
+          "pfcp_session::remove(urr) seid " SEID_FMT " ", seid);
+      urrs.erase(it);
+      return true;
+    }
+  }
+  cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;  //??
+  return false;
+}
+//------------------------------------------------------------------------------
+void pfcp_session::get_fast_path_keys(
+    std::vector<teid_t>& teids, std::vector<uint32_t>& ue_ipv4s,
+    std::vector<uint64_t>& ue_ipv6_prefixes) const {
+  teids.clear();
+  ue_ipv4s.clear();
+  ue_ipv6_prefixes.clear();
+  for (auto it : pdrs) {
+    if ((not it->pdi.first) || (not it->pdi.second.source_interface.first)) {
+      continue;
+    }
+    const pfcp::pdi& pdi = it->pdi.second;
+    if (pdi.source_interface.second.interface_value == INTERFACE_VALUE_ACCESS) {
+      if (pdi.local_fteid.first) {
+        teids.push_back(pdi.local_fteid.second.teid);
+      }
+    } else if (
+        (pdi.source_interface.second.interface_value == INTERFACE_VALUE_CORE) &&
+        (pdi.ue_ip_address.first)) {
+      if (pdi.ue_ip_address.second.v4) {
+        ue_ipv4s.push_back(
+            be32toh(pdi.ue_ip_address.second.ipv4_address.s_addr));
+      }
+      if (pdi.ue_ip_address.second.v6) {
+        ue_ipv6_prefixes.push_back(pfcp::fast_path_ipv6_prefix_key(
+            pdi.ue_ip_address.second.ipv6_address));
+      }
+    }
+  }
+  std::sort(teids.begin(), teids.end());
+  teids.erase(std::unique(teids.begin(), teids.end()), teids.end());
+  std::sort(ue_ipv4s.begin(), ue_ipv4s.end());
+  ue_ipv4s.erase(std::unique(ue_ipv4s.begin(), ue_ipv4s.end()), ue_ipv4s.end());
+  std::sort(ue_ipv6_prefixes.begin(), ue_ipv6_prefixes.end());
+  ue_ipv6_prefixes.erase(
+      std::unique(ue_ipv6_prefixes.begin(), ue_ipv6_prefixes.end()),
+      ue_ipv6_prefixes.end());
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::check_qer_ids(
+    const std::vector<pfcp::qer_id_t>& qer_ids) const {
+  if (qer_ids.size() > PFCP_FAST_PATH_MAX_QERS) {
+    Logger::spgwu_sx().info(
+        "More than %d QERs in a PDR! Rejecting PFCP_XXX_REQUEST",
+        PFCP_FAST_PATH_MAX_QERS);
+    return false;
+  }
+  for (const auto& qer_id : qer_ids) {
+    std::shared_ptr<pfcp::pfcp_qer> qer = {};
+    if (not get(qer_id, qer)) {
+      Logger::spgwu_sx().info(
+          "Unknown QER id %u in a PDR! Rejecting PFCP_XXX_REQUEST",
+          qer_id.qer_id);
+      return false;
+    }
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+pfcp::fast_path_entry* pfcp_session::compile_fast_path(
+    const fast_path_key_e key_type, const uint64_t key) const {
+  const bool access            = (key_type == FAST_PATH_KEY_UL_TEID);
+  pfcp::fast_path_entry* entry = new pfcp::fast_path_entry();
+  entry->up_seid               = seid;
+  entry->cp_fseid              = cp_fseid;
+  for (auto it : pdrs) {
+    const pfcp::pdi& pdi               = it->pdi.second;
+    const pfcp::ue_ip_address_t& ue_ip = pdi.ue_ip_address.second;
+    if (key_type == FAST_PATH_KEY_UL_TEID) {
+      if ((not pdi.local_fteid.first) || (pdi.local_fteid.second.teid != key)) {
+        continue;
+      }
+    } else if (key_type == FAST_PATH_KEY_DL_UE_IPV4) {
+      if ((not pdi.ue_ip_address.first) || (not ue_ip.v4) ||
+          (be32toh(ue_ip.ipv4_address.s_addr) != key)) {
+        continue;
+      }
+    } else {
+      if ((not pdi.ue_ip_address.first) || (not ue_ip.v6) ||
+          (pfcp::fast_path_ipv6_prefix_key(ue_ip.ipv6_address) != key)) {
+        continue;
+      }
+    }
+    pfcp::fast_path_rule_t rule = {};
+    if (not it->compile(rule, access)) {
+      continue;
+    }
+    std::shared_ptr<pfcp::pfcp_far> far = {};
+    if ((not it->far_id.first) || (not get(it->far_id.second.far_id, far))) {
+      Logger::spgwu_sx().warn(
+          "PDR id %4x seid " SEID_FMT " has no FAR, not switched",
+          it->pdr_id.rule_id, seid);
+      continue;
+    }
+    far->compile(rule.action);
+    // Checked when the PDR was created or updated, a QER removed since then
+    // leaves the PDR unmatched rather than not enforced
+    if (not check_qer_ids(it->qer_ids)) {
+      Logger::spgwu_sx().warn(
+          "PDR id %4x seid " SEID_FMT " has QERs that cannot be enforced, not "
+          "switched",
+          it->pdr_id.rule_id, seid);
+      continue;
+    }
+    for (auto qer_id : it->qer_ids) {
+      std::shared_ptr<pfcp::pfcp_qer> qer = {};
+      get(qer_id, qer);
+      rule.qers[rule.num_qers++] = qer.get();
+      entry->qers.push_back(qer);
+    }
+    std::shared_ptr<pfcp::pfcp_urr> urr = {};
+    if ((it->urr_id.first) && (get(it->urr_id.second, urr))) {
+      rule.urr = urr.get();
+      entry->urrs.push_back(urr);
+    }
+    entry->rules.push_back(rule);
+    entry->pdrs.push_back(it);
+  }
+  entry->sort_rules();
+  // The UE IP address of the PDI restricts the UE side of the SDF filter, a
+  // PDR with a UE IP address of one family does not match the other family
+  for (int i = 0; i < (int) entry->rules.size(); i++) {
+    const pfcp::fast_path_rule_t& rule = entry->rules[i];
+    const auto& sdf                    = rule.pdr->sdf_rule;
+    const bool any_ue_ip =
+        (not rule.match_ue_ipv4) && (not rule.match_ue_ipv6_prefix);
+    if ((rule.match_ue_ipv4) || (any_ue_ip)) {
+      pfcp::sdf_filter_rule filter = (sdf.first) ? sdf.second :
+                                                   pfcp::sdf_filter_rule();
+      if (rule.match_ue_ipv4) filter.set_ue_ipv4_if_any(rule.ue_ipv4);
+      entry->classifier.add(
+          i, ((sdf.first) || (rule.match_ue_ipv4)) ? &filter : nullptr);
+    }
+    if ((rule.match_ue_ipv6_prefix) || (any_ue_ip)) {
+      pfcp::sdf_filter_rule filter = (sdf.first) ? sdf.second :
+                                                   pfcp::sdf_filter_rule();
+      if (rule.match_ue_ipv6_prefix) {
+        filter.set_ue_ipv6_prefix_if_any(rule.ue_ipv6_prefix, 64);
+      }
+      entry->classifier.add6(
+          i, ((sdf.first) || (rule.match_ue_ipv6_prefix)) ? &filter : nullptr);
+    }
+  }
+  return entry;
+}
+//------------------------------------------------------------------------------
+pfcp::fast_path_entry* pfcp_session::compile_ul_fast_path(
+    const teid_t teid) const {
+  return compile_fast_path(FAST_PATH_KEY_UL_TEID, teid);
+}
+//------------------------------------------------------------------------------
+pfcp::fast_path_entry* pfcp_session::compile_dl_fast_path(
+    const uint32_t ue_ipv4) const {
+  return compile_fast_path(FAST_PATH_KEY_DL_UE_IPV4, ue_ipv4);
+}
+//------------------------------------------------------------------------------
+pfcp::fast_path_entry* pfcp_session::compile_dl6_fast_path(
+    const uint64_t ue_ipv6_prefix) const {
+  return compile_fast_path(FAST_PATH_KEY_DL_UE_IPV6_PREFIX, ue_ipv6_prefix);
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::get_kernel_gtp_tunnel(
+    pfcp::kernel_gtp_tunnel_t& tunnel) const {
+  if ((pdrs.size() != 2) || (qers.size()) || (urrs.size())) {
+    return false;
+  }
+  tunnel               = {};
+  struct in_addr ul_ue = {};
+  bool ul              = false;
+  bool dl              = false;
+  for (auto it : pdrs) {
+    const pfcp::pdi& pdi = it->pdi.second;
+    if ((not pdi.source_interface.first) || (it->sdf_rule.first) ||
+        (it->qer_ids.size()) || (it->urr_id.first)) {
+      return false;
+    }
+    const uint8_t source = pdi.source_interface.second.interface_value;
+    const bool access    = (source == INTERFACE_VALUE_ACCESS);
+    if ((not access) && (source != INTERFACE_VALUE_CORE)) {
+      return false;
+    }
+    // Same checks as the packet workers, the gtp module only knows IPv4 UEs
+    pfcp::fast_path_rule_t rule         = {};
+    std::shared_ptr<pfcp::pfcp_far> far = {};
+    if ((not it->compile(rule, access)) || (not rule.match_ue_ipv4) ||
+        (rule.match_ue_ipv6_prefix) || (not it->far_id.first) ||
+        (not get(it->far_id.second.far_id, far)) ||
+        (far->duplicating_parameters.first)) {
+      return false;
+    }
+    far->compile(rule.action);
+    const pfcp::fast_path_action_t& action = rule.action;
+    if ((not action.forw) || (action.drop) || (action.buff) || (action.nocp)) {
+      return false;
+    }
+    if (access) {
+      if ((ul) || (not pdi.local_fteid.first) ||
+          (action.destination_interface != INTERFACE_VALUE_CORE) ||
+          (action.outer_header_creation_description)) {
+        return false;
+      }
+      ul           = true;
+      ul_ue        = rule.ue_ipv4;
+      tunnel.i_tei = pdi.local_fteid.second.teid;
+    } else {
+      if ((dl) || (action.destination_interface != INTERFACE_VALUE_ACCESS) ||
+          (action.outer_header_creation_description !=
+           OUTER_HEADER_CREATION_GTPU_UDP_IPV4) ||
+          (not action.peer_ipv4.s_addr)) {
+        return false;
+      }
+      dl              = true;
+      tunnel.ue_ipv4  = rule.ue_ipv4;
+      tunnel.enb_ipv4 = action.peer_ipv4;
+      tunnel.o_tei    = action.teid;
+    }
+  }
+  // The gtp module drops the UL packets not sent by the UE address, as the
+  // UL PDR does
+  return (ul) && (dl) && (ul_ue.s_addr == tunnel.ue_ipv4.s_addr);
+}
+//------------------------------------------------------------------------------
 bool pfcp_session::update(
     const pfcp::update_far& update, uint8_t& cause_value) {
   std::shared_ptr<pfcp::pfcp_far> far = {};
@@ -111,6 +399,10 @@ bool pfcp_session::update(
     const pfcp::update_pdr& update, uint8_t& cause_value) {
   std::shared_ptr<pfcp::pfcp_pdr> pdr = {};
   if (get(update.pdr_id.rule_id, pdr)) {
+    if (not check_qer_ids(update.qer_ids)) {
+      cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+      return false;
+    }
     if (pdr->update(update, cause_value)) {
       return true;
     }
@@ -120,6 +412,151 @@ bool pfcp_session::update(
   return false;
 }
 //------------------------------------------------------------------------------
+bool pfcp_session::update(
+    const pfcp::update_qer& update, uint8_t& cause_value) {
+  std::shared_ptr<pfcp::pfcp_qer> qer = {};
+  if ((update.qer_id.first) && (get(update.qer_id.second, qer))) {
+    if (qer->update(update, cause_value)) {
+      return true;
+    }
+    return false;
+  }
+  cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+  return false;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::update(
+    const pfcp::update_urr& update, uint8_t& cause_value) {
+  std::shared_ptr<pfcp::pfcp_urr> urr = {};
+  if ((update.urr_id.first) && (get(update.urr_id.second, urr))) {
+    if (urr->update(update, cause_value)) {
+      return true;
+    }
+    return false;
+  }
+  cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+  return false;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::update(
+    const pfcp::update_bar_within_pfcp_session_modification_request& update,
+    uint8_t& cause_value) {
+  if ((bar.first) && (update.bar_id.first) &&
+      (bar.second.bar_id.second.bar_id == update.bar_id.second.bar_id)) {
+    if (update.downlink_data_notification_delay.first) {
+      bar.second.downlink_data_notification_delay =
+          update.downlink_data_notification_delay;
+    }
+    if (update.suggested_buffering_packets_count.first) {
+      bar.second.suggested_buffering_packets_count =
+          update.suggested_buffering_packets_count;
+    }
+    return true;
+  }
+  cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+  return false;
+}
+//------------------------------------------------------------------------------
+uint32_t pfcp_session::get_dl_buffer_max_packets(
+    const pfcp::pfcp_far& far) const {
+  if ((far.bar_id.first) && (bar.first) &&
+      (bar.second.bar_id.second.bar_id == far.bar_id.second.bar_id) &&
+      (bar.second.suggested_buffering_packets_count.first) &&
+      (bar.second.suggested_buffering_packets_count.second
+           .packets_count_value)) {
+    return bar.second.suggested_buffering_packets_count.second
+        .packets_count_value;
+  }
+  return spgwu_cfg.dl_buffer_default_packets;
+}
+//------------------------------------------------------------------------------
+void pfcp_session::apply_dl_buffering() {
+  for (auto pdr : pdrs) {
+    std::shared_ptr<pfcp::pfcp_far> far = {};
+    if ((not pdr->far_id.first) || (not get(pdr->far_id.second.far_id, far))) {
+      continue;
+    }
+    pfcp::fast_path_action_t action = {};
+    far->compile(action);
+    if (action.buff) {
+      pdr->dl_buffer.hold(get_dl_buffer_max_packets(*far));
+    } else {
+      const uint32_t num_packets = pdr->dl_buffer.size();
+      pdr->dl_buffer.release(action);
+      if (num_packets) {
+        Logger::spgwu_sx().info(
+            "PDR id %4x seid " SEID_FMT ": %u buffered DL packets %s",
+            pdr->pdr_id.rule_id, seid, num_packets,
+            (action.forw) ? "forwarded" : "discarded");
+      }
+      // Notify the CP function again when the FAR will buffer again
+      pdr->notified_cp = false;
+    }
+  }
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::create(
+    const pfcp::create_qer& cr_qer, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not cr_qer.qer_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_QER_ID;
+    return false;
+  }
+  if (not cr_qer.gate_status.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_GATE_STATUS;
+    return false;
+  }
+  pfcp_qer* qer                  = new pfcp_qer(cr_qer);
+  std::shared_ptr<pfcp_qer> sqer = std::shared_ptr<pfcp_qer>(qer);
+  add(sqer);
+  return true;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::create(
+    const pfcp::create_urr& cr_urr, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not cr_urr.urr_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_URR_ID;
+    return false;
+  }
+  if (not cr_urr.measurement_method.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_MEASUREMENT_METHOD;
+    return false;
+  }
+  if (not cr_urr.reporting_triggers.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_REPORTING_TRIGGERS;
+    return false;
+  }
+  pfcp_urr* urr                  = new pfcp_urr(cr_urr);
+  std::shared_ptr<pfcp_urr> surr = std::shared_ptr<pfcp_urr>(urr);
+  add(surr);
+  return true;
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::create(
+    const pfcp::create_bar& cr_bar, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not cr_bar.bar_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_BAR_ID;
+    return false;
+  }
+  bar.first  = true;
+  bar.second = cr_bar;
+  return true;
+}
+//------------------------------------------------------------------------------
 bool pfcp_session::create(
     const pfcp::create_far& cr_far, pfcp::cause_t& cause,
     uint16_t& offending_ie) {
@@ -150,6 +587,17 @@ bool pfcp_session::create(
       offending_ie      = PFCP_IE_DUPLICATING_PARAMETERS;
       return false;
     }
+    // The packet workers do not duplicate
+    cause.cause_value = CAUSE_VALUE_SERVICE_NOT_SUPPORTED;
+    offending_ie      = PFCP_IE_DUPLICATING_PARAMETERS;
+    return false;
+  }
+  if ((cr_far.forwarding_parameters.first) &&
+      (not pfcp_far::supported(
+          cr_far.forwarding_parameters.second.outer_header_creation))) {
+    cause.cause_value = CAUSE_VALUE_SERVICE_NOT_SUPPORTED;
+    offending_ie      = PFCP_IE_OUTER_HEADER_CREATION;
+    return false;
   }
   pfcp_far* far                  = new pfcp_far(cr_far);
   std::shared_ptr<pfcp_far> sfar = std::shared_ptr<pfcp_far>(far);
@@ -159,7 +607,8 @@ bool pfcp_session::create(
 //------------------------------------------------------------------------------
 bool pfcp_session::create(
     const pfcp::create_pdr& cr_pdr, pfcp::cause_t& cause,
-    uint16_t& offending_ie, pfcp::fteid_t& allocated_fteid) {
+    uint16_t& offending_ie, pfcp::fteid_t& allocated_fteid,
+    const bool restored) {
   if (not cr_pdr.pdr_id.first) {
     // should be caught in lower layer
     cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
@@ -178,6 +627,12 @@ bool pfcp_session::create(
     offending_ie      = PFCP_IE_PRECEDENCE;
     return false;
   }
+  // Before any F-TEID is allocated
+  if (not check_qer_ids(cr_pdr.qer_ids)) {
+    cause.cause_value = CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+    offending_ie      = PFCP_IE_QER_ID;
+    return false;
+  }
   const pdi& pdi = cr_pdr.pdi.second;
   if (not pdi.source_interface.first) {
     // should be caught in lower layer
@@ -200,6 +655,18 @@ bool pfcp_session::create(
     return false;
   }
 
+  std::pair<bool, pfcp::sdf_filter_rule> sdf_rule = {};
+  std::string error                               = {};
+  if (not pfcp_pdr::compile_sdf_filter(pdi, sdf_rule, error)) {
+    cause.cause_value = CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+    offending_ie      = PFCP_IE_SDF_FILTER;
+    Logger::spgwu_sx().info(
+        "Bad SDF filter flow description \"%s\", %s! Rejecting "
+        "PFCP_XXX_REQUEST",
+        pdi.sdf_filter.second.flow_description.c_str(), error.c_str());
+    return false;
+  }
+
   // source interface of the incoming packet
   if (pdi.source_interface.second.interface_value == INTERFACE_VALUE_ACCESS) {
     // Uplink traffic
@@ -211,8 +678,21 @@ bool pfcp_session::create(
     const pfcp::fteid_t& local_fteid = pdi.local_fteid.second;
     allocated_fteid                  = {};
     if (local_fteid.ch) {
-      // TODO if (local_fteid.choose_id) {
       allocated_fteid = pfcp_switch_inst->generate_fteid_s1u();
+      if (not allocated_fteid.teid) {
+        // TEID space exhausted, 0 is the TEID of the GTP-U signalling
+        cause.cause_value = CAUSE_VALUE_NO_RESOURCES_AVAILABLE;
+        Logger::spgwu_sx().info(
+            "No S1-U TEID left! Rejecting PFCP_XXX_REQUEST");
+        return false;
+      }
+    } else if (restored) {
+      if (not pfcp_switch_inst->reserve_teid_s1u(local_fteid.teid)) {
+        cause.cause_value = CAUSE_VALUE_NO_RESOURCES_AVAILABLE;
+        Logger::spgwu_sx().info(
+            "Restored F-TEID 0x%x already in use!", local_fteid.teid);
+        return false;
+      }
     } else {
       cause.cause_value = CAUSE_VALUE_REQUEST_REJECTED;
       Logger::spgwu_sx().info(
@@ -224,32 +704,23 @@ bool pfcp_session::create(
     if (local_fteid.ch) {
       pdr->pdi.second.set(allocated_fteid);
     }
+    pdr->sdf_rule = sdf_rule;
 
     std::shared_ptr<pfcp_pdr> spdr = std::shared_ptr<pfcp_pdr>(pdr);
-    if (pfcp_switch_inst->create_packet_in_access(
-            spdr, allocated_fteid, cause.cause_value)) {
-      pdr->set(get_up_seid());
-      add(spdr);
-    } else {
-      cause.cause_value = CAUSE_VALUE_REQUEST_REJECTED;
-      Logger::spgwu_sx().info(
-          "Could not create_packet_in_access ! Rejecting "
-          "PFCP_SESSION_ESTABLISHMENT_REQUEST");
-      return false;
-    }
+    pdr->set(get_up_seid());
+    add(spdr);
   } else if (
       pdi.source_interface.second.interface_value == INTERFACE_VALUE_CORE) {
     pfcp_pdr* pdr                  = new pfcp_pdr(cr_pdr);
     std::shared_ptr<pfcp_pdr> spdr = std::shared_ptr<pfcp_pdr>(pdr);
     pdr->set(get_up_seid());
-    if ((pdi.ue_ip_address.first) && (pdi.ue_ip_address.second.v4)) {
-      pfcp_switch_inst->add_pfcp_dl_pdr_by_ue_ip(
-          be32toh(pdi.ue_ip_address.second.ipv4_address.s_addr), spdr);
-    } else {
+    pdr->sdf_rule = sdf_rule;
+    if (not((pdi.ue_ip_address.first) && ((pdi.ue_ip_address.second.v4) ||
+                                          (pdi.ue_ip_address.second.v6)))) {
       cause.cause_value = CAUSE_VALUE_REQUEST_REJECTED;
       Logger::spgwu_sx().info(
-          "Could not create_packet_in_access, cause accept only IPv4 UE IP "
-          "address! Rejecting PFCP_XXX_REQUEST");
+          "Could not create_packet_in_core, cause no UE IP address! Rejecting "
+          "PFCP_XXX_REQUEST");
       return false;
     }
     add(spdr);
@@ -287,29 +758,67 @@ bool pfcp_session::remove(
   return remove(rm_pdr.pdr_id.second, cause.cause_value);
 }
 //------------------------------------------------------------------------------
+bool pfcp_session::remove(
+    const pfcp::remove_qer& rm_qer, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not rm_qer.qer_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_QER_ID;
+    return false;
+  }
+  return remove(rm_qer.qer_id.second, cause.cause_value);
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::remove(
+    const pfcp::remove_urr& rm_urr, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not rm_urr.urr_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_URR_ID;
+    return false;
+  }
+  return remove(rm_urr.urr_id.second, cause.cause_value);
+}
+//------------------------------------------------------------------------------
+bool pfcp_session::remove(
+    const pfcp::remove_bar& rm_bar, pfcp::cause_t& cause,
+    uint16_t& offending_ie) {
+  if (not rm_bar.bar_id.first) {
+    // should be caught in lower layer
+    cause.cause_value = CAUSE_VALUE_MANDATORY_IE_MISSING;
+    offending_ie      = PFCP_IE_BAR_ID;
+    return false;
+  }
+  if ((bar.first) &&
+      (bar.second.bar_id.second.bar_id == rm_bar.bar_id.second.bar_id)) {
+    bar = {};
+    return true;
+  }
+  cause.cause_value = pfcp::CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE;
+  return false;
+}
+//------------------------------------------------------------------------------
+void pfcp_session::trace_counters(const pfcp::pfcp_qer& qer) const {
+  pfcp::qer_counters_t counters = {};
+  qer.get_counters(counters);
+  Logger::spgwu_sx().info(
+      "seid " SEID_FMT " QER id %u dropped %" PRIu64 " (gate) %" PRIu64
+      " (MBR), marked %" PRIu64 " (GBR)",
+      seid, qer.qer_id.qer_id, counters.dropped_gate, counters.dropped_mbr,
+      counters.marked);
+}
+//------------------------------------------------------------------------------
 void pfcp_session::cleanup() {
-  for (std::vector<std::shared_ptr<pfcp::pfcp_pdr>>::iterator it = pdrs.begin();
-       it != pdrs.end(); ++it) {
-    if (((*it)->pdi.first) && ((*it)->pdi.second.source_interface.first)) {
-      if ((*it)->pdi.second.source_interface.second.interface_value ==
-          INTERFACE_VALUE_ACCESS) {
-        if ((*it)->pdi.second.local_fteid.first) {
-          pfcp_switch_inst->remove_pfcp_ul_pdrs_by_up_teid(
-              (*it)->pdi.second.local_fteid.second.teid);
-        }
-      } else if (
-          (*it)->pdi.second.source_interface.second.interface_value ==
-          INTERFACE_VALUE_CORE) {
-        if (((*it)->pdi.second.ue_ip_address.first) &&
-            ((*it)->pdi.second.ue_ip_address.second.v4)) {
-          pfcp_switch_inst->remove_pfcp_dl_pdrs_by_ue_ip(be32toh(
-              (*it)->pdi.second.ue_ip_address.second.ipv4_address.s_addr));
-        }
-      }
-    }
+  for (auto qer : qers) {
+    trace_counters(*qer.get());
   }
   fars.clear();
   pdrs.clear();
+  qers.clear();
+  urrs.clear();
+  bar = {};
 }
 
 //------------------------------------------------------------------------------
@@ -477,6 +986,11 @@ std::string pfcp_session::to_string() const {
           s.append(
               fmt::format(":{:08x}", pdr->pdi.second.local_fteid.second.teid));
         } break;
+        case OUTER_HEADER_REMOVAL_GTPU_UDP_IP: {
+          s.append("|GTPU_UDP_IP  ");
+          s.append(
+              fmt::format(":{:08x}", pdr->pdi.second.local_fteid.second.teid));
+        } break;
         case OUTER_HEADER_REMOVAL_UDP_IPV4: {
           s.append("|UDP_IPV4     ");
           s.append(9, ' ');
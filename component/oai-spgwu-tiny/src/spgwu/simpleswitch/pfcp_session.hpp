@@ -30,31 +30,103 @@
 
 #include "3gpp_29.244.h"
 #include "msg_pfcp.hpp"
+#include "pfcp_fast_path.hpp"
 #include "pfcp_far.hpp"
 #include "pfcp_pdr.hpp"
+#include "pfcp_qer.hpp"
+#include "pfcp_urr.hpp"
 
 namespace pfcp {
 
 #define PFCP
 
+// Default bearer the Linux gtp module can switch instead of the packet
+// workers (spgwu::gtp_mod_kernel): G-PDUs of the S1-U TEID i_tei are
+// decapsulated, packets to the UE address are encapsulated with the eNB TEID
+// o_tei. Addresses in network byte order.
+typedef struct kernel_gtp_tunnel_s {
+  struct in_addr ue_ipv4;
+  struct in_addr enb_ipv4;
+  teid_t i_tei;
+  teid_t o_tei;
+
+  bool operator==(const struct kernel_gtp_tunnel_s& t) const {
+    return (ue_ipv4.s_addr == t.ue_ipv4.s_addr) &&
+           (enb_ipv4.s_addr == t.enb_ipv4.s_addr) && (i_tei == t.i_tei) &&
+           (o_tei == t.o_tei);
+  }
+} kernel_gtp_tunnel_t;
+
 class pfcp_session {
  private:
   void add(std::shared_ptr<pfcp::pfcp_far>);
   void add(std::shared_ptr<pfcp::pfcp_pdr>);
+  void add(std::shared_ptr<pfcp::pfcp_qer>);
+  void add(std::shared_ptr<pfcp::pfcp_urr>);
 
   bool remove(const pfcp::far_id_t& far_id, uint8_t& cause_value);
   bool remove(const pfcp::pdr_id_t& pdr_id, uint8_t& cause_value);
+  bool remove(const pfcp::qer_id_t& qer_id, uint8_t& cause_value);
+  bool remove(const pfcp::urr_id_t& urr_id, uint8_t& cause_value);
+
+  // Log the drops and marks of a QER being removed
+  void trace_counters(const pfcp::pfcp_qer& qer) const;
+
+  // Packets buffered for a PDR whose FAR is far
+  uint32_t get_dl_buffer_max_packets(const pfcp::pfcp_far& far) const;
+
+  // Key of a fast path entry
+  enum fast_path_key_e {
+    FAST_PATH_KEY_UL_TEID,
+    FAST_PATH_KEY_DL_UE_IPV4,
+    FAST_PATH_KEY_DL_UE_IPV6_PREFIX
+  };
+  pfcp::fast_path_entry* compile_fast_path(
+      const fast_path_key_e key_type, const uint64_t key) const;
 
  public:
   pfcp::fseid_t cp_fseid;
   uint64_t seid;  // User plane
+  pfcp::node_id_t cp_node_id;
 
-  // TO DO better than this :(sooner the better)  when inserting or removing new
-  // PDRs, FARS, should not conflict with switching operations
+  // Only used by the control path, the packet workers read the compiled
+  // fast path entries (pfcp::fast_path_entry)
   std::vector<std::shared_ptr<pfcp::pfcp_pdr>> pdrs;
   std::vector<std::shared_ptr<pfcp::pfcp_far>> fars;
-
-  pfcp_session() : cp_fseid(), seid(0), pdrs(), fars() {
+  // The QERs shared by all the PDRs (e.g. APN-AMBR) police the session
+  std::vector<std::shared_ptr<pfcp::pfcp_qer>> qers;
+  std::vector<std::shared_ptr<pfcp::pfcp_urr>> urrs;
+  // Buffering Action Rule, at most one per session
+  std::pair<bool, pfcp::create_bar> bar;
+
+  // Keys of the fast path entries currently published by the switch for this
+  // session, only used by the control path
+  std::vector<teid_t> fast_path_teids;
+  std::vector<uint32_t> fast_path_ue_ipv4s;
+  std::vector<uint64_t> fast_path_ue_ipv6_prefixes;
+
+  // Last state saved to the session snapshot (pfcp::session_snapshot), only
+  // used by the control path
+  std::shared_ptr<const std::string> snapshot_record;
+
+  // Tunnel currently installed in the Linux gtp module for this session, the
+  // fast path entries stay published, only used by the control path
+  std::pair<bool, pfcp::kernel_gtp_tunnel_t> kernel_gtp_tunnel;
+
+  pfcp_session()
+      : cp_fseid(),
+        seid(0),
+        cp_node_id(),
+        pdrs(),
+        fars(),
+        qers(),
+        urrs(),
+        bar(),
+        fast_path_teids(),
+        fast_path_ue_ipv4s(),
+        fast_path_ue_ipv6_prefixes(),
+        snapshot_record(),
+        kernel_gtp_tunnel() {
     pdrs.reserve(8);
     fars.reserve(8);
   }
@@ -64,7 +136,19 @@ class pfcp_session {
   }
 
   pfcp_session(const pfcp_session& c)
-      : cp_fseid(c.cp_fseid), seid(c.seid), pdrs(c.pdrs), fars(c.fars) {}
+      : cp_fseid(c.cp_fseid),
+        seid(c.seid),
+        cp_node_id(c.cp_node_id),
+        pdrs(c.pdrs),
+        fars(c.fars),
+        qers(c.qers),
+        urrs(c.urrs),
+        bar(c.bar),
+        fast_path_teids(c.fast_path_teids),
+        fast_path_ue_ipv4s(c.fast_path_ue_ipv4s),
+        fast_path_ue_ipv6_prefixes(c.fast_path_ue_ipv6_prefixes),
+        snapshot_record(c.snapshot_record),
+        kernel_gtp_tunnel(c.kernel_gtp_tunnel) {}
 
   virtual ~pfcp_session() {
     cleanup();
@@ -78,16 +162,57 @@ class pfcp_session {
   uint64_t get_up_seid() const { return seid; };
   bool get(const uint32_t, std::shared_ptr<pfcp::pfcp_far>&) const;
   bool get(const uint16_t, std::shared_ptr<pfcp::pfcp_pdr>&) const;
+  bool get(const pfcp::qer_id_t&, std::shared_ptr<pfcp::pfcp_qer>&) const;
+  bool get(const pfcp::urr_id_t&, std::shared_ptr<pfcp::pfcp_urr>&) const;
+  // Return false if a QER id is unknown or if there are more QERs than the
+  // fast path enforces per rule
+  bool check_qer_ids(const std::vector<pfcp::qer_id_t>& qer_ids) const;
+
+  // Keys (UL S1-U TEIDs, DL UE IPv4 addresses and UE IPv6 /64 prefixes in
+  // host byte order) the packet path must be able to reach this session with
+  void get_fast_path_keys(
+      std::vector<teid_t>& teids, std::vector<uint32_t>& ue_ipv4s,
+      std::vector<uint64_t>& ue_ipv6_prefixes) const;
+  pfcp::fast_path_entry* compile_ul_fast_path(const teid_t teid) const;
+  pfcp::fast_path_entry* compile_dl_fast_path(const uint32_t ue_ipv4) const;
+  pfcp::fast_path_entry* compile_dl6_fast_path(
+      const uint64_t ue_ipv6_prefix) const;
+  // Return false unless the session is one IPv4 default bearer the Linux gtp
+  // module switches as the packet workers would: one UL and one DL PDR
+  // matching the UE address, no SDF filter, no QER, no URR, FARs forwarding
+  // without buffering nor duplication
+  bool get_kernel_gtp_tunnel(pfcp::kernel_gtp_tunnel_t& tunnel) const;
+
+  // Control path, before publishing the fast path: hold the DL packets of the
+  // PDRs whose FAR buffers, send or discard the packets held for the others
+  void apply_dl_buffering();
 
   bool update(const pfcp::update_far& update, uint8_t& cause_value);
   bool update(const pfcp::update_pdr& update, uint8_t& cause_value);
+  bool update(const pfcp::update_qer& update, uint8_t& cause_value);
+  bool update(const pfcp::update_urr& update, uint8_t& cause_value);
+  bool update(
+      const pfcp::update_bar_within_pfcp_session_modification_request& update,
+      uint8_t& cause_value);
 
   bool create(
       const pfcp::create_far& cr_far, pfcp::cause_t& cause,
       uint16_t& offending_ie);
+  // A restored PDR (session snapshot) keeps the F-TEID allocated before the
+  // restart
   bool create(
       const pfcp::create_pdr& cr_pdr, pfcp::cause_t& cause,
-      uint16_t& offending_ie, pfcp::fteid_t& allocated_fteid);
+      uint16_t& offending_ie, pfcp::fteid_t& allocated_fteid,
+      const bool restored = false);
+  bool create(
+      const pfcp::create_qer& cr_qer, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
+  bool create(
+      const pfcp::create_urr& cr_urr, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
+  bool create(
+      const pfcp::create_bar& cr_bar, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
 
   bool remove(
       const pfcp::remove_far& rm_far, pfcp::cause_t& cause,
@@ -95,6 +220,15 @@ class pfcp_session {
   bool remove(
       const pfcp::remove_pdr& rm_pdr, pfcp::cause_t& cause,
       uint16_t& offending_ie);
+  bool remove(
+      const pfcp::remove_qer& rm_qer, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
+  bool remove(
+      const pfcp::remove_urr& rm_urr, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
+  bool remove(
+      const pfcp::remove_bar& rm_bar, pfcp::cause_t& cause,
+      uint16_t& offending_ie);
 };
 }  // namespace pfcp
 #endif
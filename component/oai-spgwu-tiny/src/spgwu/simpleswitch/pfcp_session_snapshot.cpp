@@ -0,0 +1,554 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_session_snapshot.cpp
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_session_snapshot.hpp"
+#include "logger.hpp"
+#include "pfcp_session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pfcp;
+
+// Records are gathered in a buffer of this size before being written
+#define PFCP_SESSION_SNAPSHOT_WRITE_BUFFER_SIZE (1 << 20)
+
+namespace {
+
+typedef struct mapped_file_s {
+  void* addr;
+  std::size_t size;
+} mapped_file_t;
+
+bool write_all(const int fd, const char* buffer, std::size_t size) {
+  while (size) {
+    const ssize_t n = ::write(fd, buffer, size);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    buffer += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Map a snapshot or a journal, check its header
+bool map_file(
+    const std::string& path, const char* const magic, mapped_file_t& file) {
+  file          = {nullptr, 0};
+  const int fd  = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st = {};
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      Logger::pfcp_switch().warn(
+          "Cannot open %s: %s", path.c_str(), strerror(errno));
+    }
+    return false;
+  }
+  if ((fstat(fd, &st) < 0) ||
+      ((std::size_t) st.st_size < sizeof(session_snapshot_header_t))) {
+    ::close(fd);
+    Logger::pfcp_switch().warn("%s: no header", path.c_str());
+    return false;
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    Logger::pfcp_switch().warn(
+        "Cannot map %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  file = {addr, (std::size_t) st.st_size};
+  const session_snapshot_header_t* h =
+      static_cast<const session_snapshot_header_t*>(addr);
+  if ((memcmp(h->magic, magic, sizeof(h->magic))) ||
+      (h->version != PFCP_SESSION_SNAPSHOT_VERSION) ||
+      (h->header_size < sizeof(session_snapshot_header_t)) ||
+      (h->header_size > file.size)) {
+    Logger::pfcp_switch().warn(
+        "%s: not a %s file of version %u", path.c_str(), magic,
+        PFCP_SESSION_SNAPSHOT_VERSION);
+    munmap(file.addr, file.size);
+    file = {nullptr, 0};
+    return false;
+  }
+  madvise(file.addr, file.size, MADV_WILLNEED);
+  return true;
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+session_snapshot::session_snapshot(const std::string& path)
+    : path_(path),
+      journal_lock_(),
+      journal_fd_(-1),
+      generation_(0),
+      oldest_generation_(0),
+      cp_rts_(),
+      writer_(),
+      writing_(false) {}
+//------------------------------------------------------------------------------
+session_snapshot::~session_snapshot() {
+  if (writer_.joinable()) writer_.join();
+  if (journal_fd_ >= 0) ::close(journal_fd_);
+}
+//------------------------------------------------------------------------------
+std::string session_snapshot::journal_path(const uint64_t generation) const {
+  return path_ + PFCP_SESSION_JOURNAL_SUFFIX + std::to_string(generation);
+}
+//------------------------------------------------------------------------------
+void session_snapshot::list_journals(std::vector<uint64_t>& generations) const {
+  const std::size_t slash = path_.rfind('/');
+  const std::string dir =
+      (slash == std::string::npos) ? "." : path_.substr(0, slash + 1);
+  const std::string prefix =
+      ((slash == std::string::npos) ? path_ : path_.substr(slash + 1)) +
+      PFCP_SESSION_JOURNAL_SUFFIX;
+  DIR* d = opendir(dir.c_str());
+  if (not d) return;
+  while (struct dirent* e = readdir(d)) {
+    if (strncmp(e->d_name, prefix.c_str(), prefix.size())) continue;
+    const char* digits = e->d_name + prefix.size();
+    char* end          = nullptr;
+    const uint64_t g   = strtoull(digits, &end, 10);
+    if ((end != digits) && (*end == 0)) {
+      generations.push_back(g);
+    }
+  }
+  closedir(d);
+  std::sort(generations.begin(), generations.end());
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::open_journal() {
+  if (journal_fd_ >= 0) ::close(journal_fd_);
+  const std::string path = journal_path(generation_);
+  journal_fd_            = ::open(
+      path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+      0600);
+  if (journal_fd_ < 0) {
+    Logger::pfcp_switch().error(
+        "Cannot create %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+  session_snapshot_header_t h = {};
+  memcpy(h.magic, PFCP_SESSION_JOURNAL_MAGIC, sizeof(h.magic));
+  h.version     = PFCP_SESSION_SNAPSHOT_VERSION;
+  h.header_size = sizeof(h);
+  h.generation  = generation_;
+  append(reinterpret_cast<const char*>(&h), sizeof(h));
+  return journal_fd_ >= 0;
+}
+//------------------------------------------------------------------------------
+void session_snapshot::append(const char* record, const std::size_t length) {
+  if (journal_fd_ < 0) return;
+  // One write per record, a crash can only tear the last one
+  if (::write(journal_fd_, record, length) != (ssize_t) length) {
+    // The next records would follow a torn one, stop until the next snapshot
+    Logger::pfcp_switch().error(
+        "Cannot append to %s: %s, journal stopped until the next snapshot",
+        journal_path(generation_).c_str(), strerror(errno));
+    ::close(journal_fd_);
+    journal_fd_ = -1;
+  }
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::encode(pfcp::pfcp_msg& msg, std::string& record) {
+  record.resize((std::size_t) msg.get_message_length() + 4);
+  return msg.dump_to(&record[0], record.size()) == record.size();
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::encode(
+    const pfcp::pfcp_session& session, std::string& record) {
+  pfcp::pfcp_session_establishment_request ies = {};
+  ies.set(session.cp_node_id);
+  ies.set(session.cp_fseid);
+  for (const auto& far : session.fars) {
+    pfcp::create_far cr_far = {};
+    cr_far.set(far->far_id);
+    cr_far.set(far->apply_action);
+    if (far->forwarding_parameters.first) {
+      cr_far.set(far->forwarding_parameters.second);
+    }
+    if (far->duplicating_parameters.first) {
+      cr_far.set(far->duplicating_parameters.second);
+    }
+    if (far->bar_id.first) cr_far.set(far->bar_id.second);
+    ies.set(cr_far);
+  }
+  for (const auto& urr : session.urrs) {
+    pfcp::create_urr cr_urr = {};
+    cr_urr.set(urr->urr_id);
+    cr_urr.set(urr->measurement_method);
+    cr_urr.set(urr->reporting_triggers);
+    if (urr->measurement_period.first) {
+      cr_urr.set(urr->measurement_period.second);
+    }
+    if (urr->volume_threshold.first) cr_urr.set(urr->volume_threshold.second);
+    if (urr->time_threshold.first) cr_urr.set(urr->time_threshold.second);
+    ies.set(cr_urr);
+  }
+  for (const auto& qer : session.qers) {
+    pfcp::create_qer cr_qer = {};
+    cr_qer.set(qer->qer_id);
+    if (qer->qer_correlation_id.first) {
+      cr_qer.set(qer->qer_correlation_id.second);
+    }
+    cr_qer.set(qer->gate_status);
+    if (qer->maximum_bitrate.first) cr_qer.set(qer->maximum_bitrate.second);
+    if (qer->guaranteed_bitrate.first) {
+      cr_qer.set(qer->guaranteed_bitrate.second);
+    }
+    ies.set(cr_qer);
+  }
+  if (session.bar.first) ies.set(session.bar.second);
+  for (const auto& pdr : session.pdrs) {
+    pfcp::create_pdr cr_pdr = {};
+    cr_pdr.set(pdr->pdr_id);
+    if (pdr->precedence.first) cr_pdr.set(pdr->precedence.second);
+    if (pdr->pdi.first) cr_pdr.set(pdr->pdi.second);
+    if (pdr->outer_header_removal.first) {
+      cr_pdr.set(pdr->outer_header_removal.second);
+    }
+    if (pdr->far_id.first) cr_pdr.set(pdr->far_id.second);
+    if (pdr->urr_id.first) cr_pdr.set(pdr->urr_id.second);
+    for (const auto& qer_id : pdr->qer_ids) {
+      cr_pdr.set(qer_id);
+    }
+    if (pdr->activate_predefined_rules.first) {
+      cr_pdr.set(pdr->activate_predefined_rules.second);
+    }
+    ies.set(cr_pdr);
+  }
+  pfcp::pfcp_msg msg(ies);
+  msg.set_seid(session.seid);
+  return encode(msg, record);
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::scan(
+    const char* records, std::size_t size,
+    std::unordered_map<uint64_t, std::pair<const char*, std::size_t>>&
+        sessions) {
+  while (size) {
+    // Header: flags, type, length, SEID if the S flag is set
+    uint16_t ns_length = 0;
+    if (size < 4) return false;
+    memcpy(&ns_length, records + 2, sizeof(ns_length));
+    const std::size_t length = 4 + (std::size_t) be16toh(ns_length);
+    if ((length > size) || (length < PFCP_MSG_HEADER_MIN_SIZE)) return false;
+    uint64_t seid = 0;
+    if ((records[0] & 0x01) && (length >= PFCP_MSG_HEADER_MIN_SIZE + 8)) {
+      memcpy(&seid, records + 4, sizeof(seid));
+      seid = be64toh(seid);
+    }
+    switch ((uint8_t) records[1]) {
+      case PFCP_SESSION_ESTABLISHMENT_REQUEST:
+        sessions[seid] = std::make_pair(records, length);
+        break;
+      case PFCP_SESSION_DELETION_REQUEST:
+        sessions.erase(seid);
+        break;
+      case PFCP_ASSOCIATION_SETUP_RESPONSE:
+        try {
+          pfcp::pfcp_msg msg = {};
+          msg.load_from(records, length);
+          pfcp::pfcp_association_setup_response a = {};
+          msg.to_core_type(a);
+          pfcp::node_id_t node_id         = {};
+          pfcp::recovery_time_stamp_t rts = {};
+          if (a.get(node_id) && a.get(rts)) {
+            cp_rts_[node_id] = rts.recovery_time_stamp;
+          }
+        } catch (std::exception& e) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+    records += length;
+    size -= length;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::load(uint64_t& up_rts, const restore_cb_t& restore) {
+  const auto start = std::chrono::steady_clock::now();
+  mapped_file_t snapshot = {};
+  if (not map_file(path_, PFCP_SESSION_SNAPSHOT_MAGIC, snapshot)) {
+    Logger::pfcp_switch().info(
+        "No usable session snapshot %s, the CP functions restore the "
+        "sessions",
+        path_.c_str());
+    return false;
+  }
+  const session_snapshot_header_t* h =
+      static_cast<const session_snapshot_header_t*>(snapshot.addr);
+  std::unordered_map<uint64_t, std::pair<const char*, std::size_t>> sessions =
+      {};
+  sessions.reserve(h->num_records);
+  if ((h->records_size > snapshot.size - h->header_size) ||
+      (not scan(
+          static_cast<const char*>(snapshot.addr) + h->header_size,
+          h->records_size, sessions))) {
+    Logger::pfcp_switch().warn(
+        "Session snapshot %s is corrupted, the CP functions restore the "
+        "sessions",
+        path_.c_str());
+    munmap(snapshot.addr, snapshot.size);
+    cp_rts_.clear();
+    return false;
+  }
+  up_rts             = h->up_recovery_time_stamp;
+  generation_        = h->generation;
+  oldest_generation_ = h->generation;
+
+  // Changes made after the snapshot
+  std::vector<mapped_file_t> journals = {};
+  std::vector<uint64_t> generations   = {};
+  list_journals(generations);
+  for (auto g : generations) {
+    if (g < h->generation) {
+      // Left by a crash once the snapshot covering it was written
+      ::unlink(journal_path(g).c_str());
+      continue;
+    }
+    mapped_file_t journal = {};
+    if (not map_file(journal_path(g), PFCP_SESSION_JOURNAL_MAGIC, journal)) {
+      continue;
+    }
+    journals.push_back(journal);
+    const session_snapshot_header_t* jh =
+        static_cast<const session_snapshot_header_t*>(journal.addr);
+    if (not scan(
+            static_cast<const char*>(journal.addr) + jh->header_size,
+            journal.size - jh->header_size, sessions)) {
+      Logger::pfcp_switch().warn(
+          "Journal %s ends with a torn record", journal_path(g).c_str());
+    }
+    generation_ = std::max(generation_, g);
+  }
+
+  std::size_t num_restored = 0;
+  std::size_t num_dropped  = 0;
+  for (const auto& it : sessions) {
+    try {
+      pfcp::pfcp_msg msg = {};
+      msg.load_from(it.second.first, it.second.second);
+      pfcp::pfcp_session_establishment_request ies = {};
+      msg.to_core_type(ies);
+      pfcp::node_id_t node_id         = {};
+      pfcp::recovery_time_stamp_t rts = {};
+      if (ies.get(node_id)) {
+        auto cp = cp_rts_.find(node_id);
+        if (cp != cp_rts_.end()) rts.recovery_time_stamp = cp->second;
+      }
+      std::shared_ptr<const std::string> record =
+          std::make_shared<const std::string>(
+              it.second.first, it.second.second);
+      if (restore(ies, it.first, rts, record)) {
+        num_restored++;
+      } else {
+        num_dropped++;
+      }
+    } catch (std::exception& e) {
+      num_dropped++;
+    }
+  }
+  for (auto& journal : journals) {
+    munmap(journal.addr, journal.size);
+  }
+  munmap(snapshot.addr, snapshot.size);
+  Logger::pfcp_switch().info(
+      "Restored %zu PFCP sessions from %s and %zu journals in %" PRId64
+      " ms, %zu not restored",
+      num_restored, path_.c_str(), journals.size(),
+      (int64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count(),
+      num_dropped);
+  return true;
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::start(const bool loaded, const uint64_t up_rts) {
+  std::unique_lock<std::mutex> l(journal_lock_);
+  if (loaded) {
+    // The journals loaded stay until a snapshot covers them
+    generation_++;
+    return open_journal();
+  }
+  std::vector<uint64_t> generations = {};
+  list_journals(generations);
+  for (auto g : generations) {
+    ::unlink(journal_path(g).c_str());
+  }
+  generation_        = 1;
+  oldest_generation_ = 1;
+  write(generation_, up_rts, {});
+  return open_journal();
+}
+//------------------------------------------------------------------------------
+void session_snapshot::journal(const std::string& record) {
+  std::unique_lock<std::mutex> l(journal_lock_);
+  append(record.data(), record.size());
+}
+//------------------------------------------------------------------------------
+void session_snapshot::journal_delete(const uint64_t up_seid) {
+  pfcp::pfcp_session_deletion_request ies = {};
+  pfcp::pfcp_msg msg(ies);
+  msg.set_seid(up_seid);
+  std::string record = {};
+  if (encode(msg, record)) {
+    std::unique_lock<std::mutex> l(journal_lock_);
+    append(record.data(), record.size());
+  }
+}
+//------------------------------------------------------------------------------
+void session_snapshot::journal_association(
+    const pfcp::node_id_t& node_id, const pfcp::recovery_time_stamp_t& cp_rts) {
+  pfcp::pfcp_association_setup_response ies = {};
+  ies.set(node_id);
+  ies.set(cp_rts);
+  pfcp::pfcp_msg msg(ies);
+  std::string record = {};
+  if (encode(msg, record)) {
+    std::unique_lock<std::mutex> l(journal_lock_);
+    cp_rts_[node_id] = cp_rts.recovery_time_stamp;
+    append(record.data(), record.size());
+  }
+}
+//------------------------------------------------------------------------------
+bool session_snapshot::save(
+    std::vector<std::shared_ptr<const std::string>>& records,
+    const uint64_t up_rts) {
+  if (writing_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  if (writer_.joinable()) writer_.join();
+  uint64_t generation = 0;
+  {
+    std::unique_lock<std::mutex> l(journal_lock_);
+    for (const auto& it : cp_rts_) {
+      pfcp::pfcp_association_setup_response ies = {};
+      pfcp::recovery_time_stamp_t rts           = {};
+      rts.recovery_time_stamp                   = it.second;
+      ies.set(it.first);
+      ies.set(rts);
+      pfcp::pfcp_msg msg(ies);
+      std::shared_ptr<std::string> record = std::make_shared<std::string>();
+      if (encode(msg, *record)) {
+        records.push_back(record);
+      }
+    }
+    // The changes made from now on go to the journal of the new snapshot
+    generation_++;
+    open_journal();
+    generation = generation_;
+  }
+  writing_.store(true, std::memory_order_release);
+  writer_ = std::thread(
+      [this, generation, up_rts](
+          std::vector<std::shared_ptr<const std::string>> records) {
+        write(generation, up_rts, records);
+        writing_.store(false, std::memory_order_release);
+      },
+      std::move(records));
+  return true;
+}
+//------------------------------------------------------------------------------
+void session_snapshot::write(
+    const uint64_t generation, const uint64_t up_rts,
+    const std::vector<std::shared_ptr<const std::string>>& records) {
+  const auto start      = std::chrono::steady_clock::now();
+  const std::string tmp = path_ + ".tmp";
+  const int fd =
+      ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    Logger::pfcp_switch().error(
+        "Cannot create %s: %s", tmp.c_str(), strerror(errno));
+    return;
+  }
+  session_snapshot_header_t h = {};
+  memcpy(h.magic, PFCP_SESSION_SNAPSHOT_MAGIC, sizeof(h.magic));
+  h.version                = PFCP_SESSION_SNAPSHOT_VERSION;
+  h.header_size            = sizeof(h);
+  h.generation             = generation;
+  h.up_recovery_time_stamp = up_rts;
+  h.num_records            = records.size();
+  for (const auto& r : records) {
+    h.records_size += r->size();
+  }
+  std::string buffer = {};
+  buffer.reserve(PFCP_SESSION_SNAPSHOT_WRITE_BUFFER_SIZE);
+  buffer.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  bool ok = true;
+  for (const auto& r : records) {
+    if (buffer.size() + r->size() > PFCP_SESSION_SNAPSHOT_WRITE_BUFFER_SIZE) {
+      ok = ok && write_all(fd, buffer.data(), buffer.size());
+      buffer.clear();
+    }
+    buffer.append(*r);
+  }
+  ok = ok && write_all(fd, buffer.data(), buffer.size());
+  ok = ok && (fsync(fd) == 0);
+  ::close(fd);
+  // The snapshot replaces the previous one once it is complete on disk
+  ok = ok && (rename(tmp.c_str(), path_.c_str()) == 0);
+  if (not ok) {
+    Logger::pfcp_switch().error(
+        "Cannot write session snapshot %s: %s", path_.c_str(),
+        strerror(errno));
+    ::unlink(tmp.c_str());
+    return;
+  }
+  const std::size_t slash = path_.rfind('/');
+  const int dir_fd        = ::open(
+      (slash == std::string::npos) ? "." : path_.substr(0, slash + 1).c_str(),
+      O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    ::close(dir_fd);
+  }
+  for (; oldest_generation_ < generation; oldest_generation_++) {
+    ::unlink(journal_path(oldest_generation_).c_str());
+  }
+  Logger::pfcp_switch().info(
+      "Session snapshot %s: %zu records, %" PRIu64 " bytes in %" PRId64 " ms",
+      path_.c_str(), records.size(), h.records_size,
+      (int64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_session_snapshot.hpp
+   \brief PFCP sessions of the switch saved to a file, restored at startup
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_SESSION_SNAPSHOT_HPP_SEEN
+#define FILE_PFCP_SESSION_SNAPSHOT_HPP_SEEN
+
+#include "3gpp_29.244.hpp"
+#include "msg_pfcp.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pfcp {
+
+class pfcp_session;
+
+// Every record is a PFCP message, encoded and decoded by the PFCP stack:
+// - a session is a session establishment request whose SEID is the UP SEID,
+//   its PDRs carry the F-TEIDs allocated by the switch,
+// - a deleted session is a session deletion request,
+// - the recovery time stamp of a CP function is an association setup
+//   response.
+// A snapshot is a header followed by the records of all the sessions, it is
+// mapped in memory and decoded in place at startup. The changes made after
+// a snapshot are appended to a journal: the snapshot of generation g is
+// completed by the journals of generation g and above, replayed in order
+// (the last record of a session wins). Integers of the header are in host
+// byte order, the file is not meant to move to another host.
+#define PFCP_SESSION_SNAPSHOT_VERSION 1
+#define PFCP_SESSION_SNAPSHOT_MAGIC "SPGWUSS"
+#define PFCP_SESSION_JOURNAL_MAGIC "SPGWUSJ"
+#define PFCP_SESSION_JOURNAL_SUFFIX ".journal."
+
+typedef struct session_snapshot_header_s {
+  char magic[8];
+  uint32_t version;
+  // Records start here, a later version may extend the header
+  uint32_t header_size;
+  uint64_t generation;
+  // Of the SPGW-U, kept across the restarts if the sessions are restored
+  uint64_t up_recovery_time_stamp;
+  // 0 in a journal, its records go up to the end of the file
+  uint64_t num_records;
+  uint64_t records_size;
+} session_snapshot_header_t;
+
+class session_snapshot {
+ public:
+  // A session to restore, its CP function had this recovery time stamp when
+  // it was last saved. Return false if the session is not restored.
+  typedef std::function<bool(
+      const pfcp::pfcp_session_establishment_request& session,
+      const uint64_t up_seid, const pfcp::recovery_time_stamp_t& cp_rts,
+      const std::shared_ptr<const std::string>& record)>
+      restore_cb_t;
+
+ private:
+  const std::string path_;
+
+  // Journal of the current generation, appended by the control path (the
+  // sessions) and by the Sx task (the associations)
+  std::mutex journal_lock_;
+  int journal_fd_;
+  uint64_t generation_;
+  // Oldest journal not covered by a written snapshot
+  uint64_t oldest_generation_;
+  // Last recovery time stamp of each CP function
+  std::unordered_map<pfcp::node_id_t, uint32_t> cp_rts_;
+
+  std::thread writer_;
+  std::atomic<bool> writing_;
+
+  std::string journal_path(const uint64_t generation) const;
+  // Generations of the journals found next to the snapshot
+  void list_journals(std::vector<uint64_t>& generations) const;
+  bool open_journal();
+  void append(const char* record, const std::size_t length);
+
+  static bool encode(pfcp::pfcp_msg& msg, std::string& record);
+  // Index the records of a mapped file by UP SEID, stop at a torn record
+  // (crash while appending to a journal), return false in that case
+  bool scan(
+      const char* records, std::size_t size,
+      std::unordered_map<uint64_t, std::pair<const char*, std::size_t>>&
+          sessions);
+  // Write the snapshot of generation, remove the journals it covers
+  void write(
+      const uint64_t generation, const uint64_t up_rts,
+      const std::vector<std::shared_ptr<const std::string>>& records);
+
+ public:
+  explicit session_snapshot(const std::string& path);
+  session_snapshot(const session_snapshot&) = delete;
+  void operator=(const session_snapshot&) = delete;
+  ~session_snapshot();
+
+  // Encode the current state of a session
+  static bool encode(const pfcp::pfcp_session& session, std::string& record);
+
+  // Restore the sessions of the snapshot and of its journals, return false
+  // if there is no usable snapshot (nothing restored). up_rts is the
+  // recovery time stamp saved in the snapshot.
+  bool load(uint64_t& up_rts, const restore_cb_t& restore);
+  // Start journaling, after load(). Without a usable snapshot the old
+  // journals are removed and an empty snapshot is written first.
+  bool start(const bool loaded, const uint64_t up_rts);
+
+  // Control path, after a change of a session
+  void journal(const std::string& record);
+  void journal_delete(const uint64_t up_seid);
+  // Sx task, on association setup
+  void journal_association(
+      const pfcp::node_id_t& node_id,
+      const pfcp::recovery_time_stamp_t& cp_rts);
+
+  // Control path: start a new journal and write the snapshot of the sessions
+  // in the background. Return false if the previous snapshot is still being
+  // written.
+  bool save(
+      std::vector<std::shared_ptr<const std::string>>& records,
+      const uint64_t up_rts);
+};
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_SESSION_SNAPSHOT_HPP_SEEN */
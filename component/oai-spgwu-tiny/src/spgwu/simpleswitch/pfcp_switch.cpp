@@ -27,16 +27,21 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+#include "async_shell_cmd.hpp"
 #include "common_defs.h"
+#include "datapath_stats.hpp"
 #include "itti.hpp"
 #include "logger.hpp"
 #include "pfcp_switch.hpp"
 #include "spgwu_config.hpp"
 #include "spgwu_pfcp_association.hpp"
 #include "spgwu_s1u.hpp"
+#include "spgwu_sx.hpp"
 
 #include <algorithm>
+#include <ctime>
 #include <fstream>  // std::ifstream
+#include <inttypes.h>
 #include <sched.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -46,6 +51,9 @@
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
 #include <linux/if_tun.h>
+#include <linux/bpf.h>
+#include <poll.h>
+#include <sys/syscall.h>
 #include <stdexcept>
 #include <net/ethernet.h>
 
@@ -55,94 +63,307 @@ using namespace spgwu;
 using namespace std;
 
 extern itti_mw* itti_inst;
+extern util::async_shell_cmd* async_shell_cmd_inst;
 extern spgwu_config spgwu_cfg;
 extern spgwu_s1u* spgwu_s1u_inst;
+extern spgwu_sx* spgwu_sx_inst;
 extern pfcp_switch* pfcp_switch_inst;
 
-//------------------------------------------------------------------------------
-void pfcp_switch::pdn_worker(
-    const int id, const util::thread_sched_params& sched_params) {
-  uint64_t count      = 0;
-  iovec_q_item_t* iov = nullptr;
-
-  sched_params.apply(TASK_NONE, Logger::udp());
-  while (1) {
-    work_pool_->blockingRead(iov);
-    ++count;
-    // std::cout << "DL worker " << id << " count " << count << std::endl;
-    // exit thread
-    if (iov->msg_iov.iov_base) {
-      pfcp_session_look_up_pack_in_core(
-          (const char*) iov->msg_iov.iov_base, iov->msg_iov.iov_len);
-      free_pool_->write(iov);
-    } else {
-      free(iov);
-      std::cout << "exit DL w" << id << " " << count << std::endl;
-      while (work_pool_->readIfNotEmpty(iov)) {
-        free(iov);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      }
-      return;
-    }
-    iov = nullptr;
-  }
-}
 //------------------------------------------------------------------------------
 void pfcp_switch::pdn_read_loop(
-    int sock_r, const util::thread_sched_params& sched_params) {
-  uint64_t count      = 0;
-  uint64_t errors     = 0;
-  iovec_q_item_t* iov = nullptr;
-  // struct sockaddr_in   sin = {};
+    const int id, int sock_r, const util::thread_sched_params& sched_params) {
+  uint64_t count  = 0;
+  uint64_t errors = 0;
+  // Packets are read in util::packet_pool buffers, a G-PDU is batched for
+  // S1-U without copy. Without pool buffer left, the packet is read in the
+  // spare buffer and the batch copies it. Both have room in front of the IP
+  // packet for the GTP-U encapsulation.
+  util::packet_pool& pool  = util::packet_pool::get_instance();
+  util::packet_buf_t* pbuf = nullptr;
+  char* spare_alloc        = (char*) calloc(1, PFCP_SWITCH_RECV_BUFFER_SIZE);
+  char* spare              = &spare_alloc[ROOM_FOR_GTPV1U_G_PDU];
+  struct pollfd pfd        = {};
+  pfd.fd                   = sock_r;
+  pfd.events               = POLLIN;
+  datapath_stats& stats    = datapath_stats::get_instance();
+  // With TUN offload, a TCP superpacket continues in big, copied there to be
+  // linear if it does not fit in the first buffer
+  char* big_alloc =
+      (tun_offload_) ?
+          (char*) malloc(ROOM_FOR_GTPV1U_G_PDU + TUN_OFFLOAD_MAX_PACKET_SIZE) :
+          nullptr;
+  if ((not spare_alloc) || ((tun_offload_) && (not big_alloc))) {
+    Logger::pfcp_switch().error(
+        "Could not allocate the read buffers of TUN queue %d", id);
+    exit(EXIT_FAILURE);
+  }
+  char* big         = (big_alloc) ? big_alloc + ROOM_FOR_GTPV1U_G_PDU : nullptr;
+  tun_vnet_hdr_t vh = {};
 
   sched_params.apply(TASK_NONE, Logger::pfcp_switch());
+  util::qsbr& qsbr = util::qsbr::get_instance();
+  if (not qsbr.register_thread()) {
+    // Unseen by the grace periods, it would switch with freed entries
+    Logger::pfcp_switch().error(
+        "Too many packet workers, could not register TUN queue %d reader", id);
+    exit(EXIT_FAILURE);
+  }
 
   while (1) {
-    if (!iov) {
-      free_pool_->blockingRead(iov);
-    }
-    // iov->msg.msg_name = &sin;
-    // iov->msg.msg_namelen = sizeof(sin);
-    // iov->msg.msg_iovlen = 1;
-    // iov->msg.msg_flags = 0;
-    iov->msg_iov.iov_len = PFCP_SWITCH_RECV_BUFFER_SIZE - ROOM_FOR_GTPV1U_G_PDU;
-    // iov->msg.msg_control = nullptr;      /* Set to NULL if not needed  */
-    // iov->msg.msg_controllen = 0;
-    // exit thread
-    if (iov->msg_iov.iov_base == nullptr) {
-      free(iov);
-      while (work_pool_->readIfNotEmpty(iov)) {
-        free(iov);
-      }
-      std::cout << "exit d" << count << std::endl;
-      return;
-    }
-    ssize_t nread;
-    if ((nread = read(sock_r, iov->msg_iov.iov_base, iov->msg_iov.iov_len)) >
-        0) {
+    if (not pbuf) pbuf = pool.alloc();
+    char* recv_buffer      = (pbuf) ? pbuf->data() : spare;
+    const std::size_t room =
+        (pbuf) ? pool.data_room() :
+                 PFCP_SWITCH_RECV_BUFFER_SIZE - ROOM_FOR_GTPV1U_G_PDU;
+    // Preceded by a virtio header with TUN offload
+    ssize_t nread = (tun_offload_) ?
+                        read_pdn_offload(sock_r, vh, recv_buffer, room, big) :
+                        read(sock_r, recv_buffer, room);
+    if ((nread > 0) && (tun_offload_) &&
+        (vh.gso_type != TUN_VNET_HDR_GSO_NONE)) {
+      ++count;
+      switch_pdn_superpacket(vh, recv_buffer, nread);
+      qsbr.quiescent_state();
+    } else if (nread > 0) {
       ++count;
-      // std::cout << "pdn" << count << " " << nread << " bytes" << std::endl;
-      iov->msg_iov.iov_len = nread;
-      work_pool_->write(iov);
-      iov = nullptr;
+      stats.received(DATAPATH_DL, nread);
+      if ((tun_offload_) &&
+          (not tun_offload_complete_csum(recv_buffer, nread, vh))) {
+        stats.dropped(DATAPATH_DROP_MALFORMED);
+        continue;
+      }
+      // A packet bigger than the pool buffer (TUN MTU) was read in big
+      util::packet_buf_t* const in =
+          ((pbuf) && (recv_buffer == pbuf->data())) ? pbuf : nullptr;
+      if (in) in->len = nread;
+      // Run to completion, no hand-off to other threads
+      pfcp_session_look_up_pack_in_core(recv_buffer, nread, in);
+      if ((pbuf) && (pbuf->refcnt > 1)) {
+        // Left to the TX batch, read the next packet in another buffer
+        pool.release(pbuf);
+        pbuf = nullptr;
+      }
+      qsbr.quiescent_state();
+    } else if ((nread < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+      // Nothing more to process for now, send the pending G-PDUs
+      spgwu_s1u_inst->flush_g_pdus();
+      qsbr.thread_offline();
+      poll(&pfd, 1, -1);
+      qsbr.thread_online();
+    } else if ((nread < 0) && (errno == EINTR)) {
+      continue;
     } else {
       ++errors;
       Logger::pfcp_switch().error(
-          "recvmsg failed rc=%d:%s nb_errors %d", nread, strerror(errno),
-          errors);
+          "read TUN queue %d failed rc=%d:%s nb_errors %d", id, nread,
+          strerror(errno), errors);
       std::this_thread::sleep_for(std::chrono::milliseconds(1000));
       exit(0);
     }
   }
 }
 //------------------------------------------------------------------------------
-void pfcp_switch::send_to_core(char* const ip_packet, const ssize_t len) {
+ssize_t pfcp_switch::read_pdn_offload(
+    const int sock_r, tun_vnet_hdr_t& vh, char*& packet,
+    const std::size_t room, char* const big) {
+  struct iovec iov[3] = {};
+  iov[0].iov_base     = &vh;
+  iov[0].iov_len      = sizeof(vh);
+  iov[1].iov_base     = packet;
+  iov[1].iov_len      = room;
+  iov[2].iov_base     = &big[room];
+  iov[2].iov_len      = TUN_OFFLOAD_MAX_PACKET_SIZE - room;
+  ssize_t nread       = readv(sock_r, iov, 3);
+  if (nread < (ssize_t) sizeof(vh)) return (nread < 0) ? nread : 0;
+  nread -= sizeof(vh);
+  if (nread > room) {
+    memcpy(big, packet, room);
+    packet = big;
+  }
+  return nread;
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::switch_pdn_superpacket(
+    const tun_vnet_hdr_t& vh, char* const packet, const std::size_t len) {
+  datapath_stats& stats = datapath_stats::get_instance();
+  tun_gso_segmenter gso;
+  if (not gso.init(packet, len, vh)) {
+    stats.dropped(DATAPATH_DROP_MALFORMED);
+    return;
+  }
+  // A segment overwrites the tail of the previous one, they are copied in
+  // the TX batch (no pool buffer)
+  std::size_t seg_len = 0;
+  while (char* seg = gso.next(seg_len)) {
+    stats.received(DATAPATH_DL, seg_len);
+    pfcp_session_look_up_pack_in_core(seg, seg_len);
+  }
+}
+//------------------------------------------------------------------------------
+bool pfcp_switch::is_pdn_ipv4_address(const uint32_t addr_be) const {
+  for (auto& pdn : spgwu_cfg.pdns) {
+    if ((pdn.prefix_ipv4) &&
+        ((addr_be & pdn.network_mask_ipv4_be) == pdn.network_ipv4.s_addr)) {
+      return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+bool pfcp_switch::is_pdn_ipv6_address(const struct in6_addr& addr) const {
+  for (auto& pdn : spgwu_cfg.pdns) {
+    if (pdn.prefix_ipv6 <= 0) continue;
+    int bits = pdn.prefix_ipv6;
+    for (int i = 0; (i < 16) && (bits > 0); i++, bits -= 8) {
+      uint8_t mask = (bits >= 8) ? 0xFF : (uint8_t)(0xFF00 >> bits);
+      if ((addr.s6_addr[i] & mask) != (pdn.network_ipv6.s6_addr[i] & mask)) {
+        break;
+      }
+      if (bits <= 8) return true;
+    }
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::pdn_ring_loop(
+    packet_ring* ring, const util::thread_sched_params& sched_params) {
+  sched_params.apply(TASK_NONE, Logger::pfcp_switch());
+  if (not util::qsbr::get_instance().register_thread()) {
+    Logger::pfcp_switch().error(
+        "Too many packet workers, could not register SGi ring reader");
+    exit(EXIT_FAILURE);
+  }
+  // Frames are switched in the ring, GTP-U header written in the headroom
+  datapath_stats& stats = datapath_stats::get_instance();
+  ring->read_loop(
+      [this, &stats](char* l3_packet, const std::size_t num_bytes) {
+        struct iphdr* iph = (struct iphdr*) l3_packet;
+        if ((num_bytes >= sizeof(struct iphdr)) && (iph->version == 4) &&
+            (is_pdn_ipv4_address(iph->daddr))) {
+          stats.received(DATAPATH_DL, num_bytes);
+          pfcp_session_look_up_pack_in_core(l3_packet, num_bytes);
+        } else if (
+            (num_bytes >= sizeof(struct ipv6hdr)) && (iph->version == 6) &&
+            (is_pdn_ipv6_address(((struct ipv6hdr*) l3_packet)->daddr))) {
+          stats.received(DATAPATH_DL, num_bytes);
+          pfcp_session_look_up_pack_in_core(l3_packet, num_bytes);
+        }
+      },
+      []() { spgwu_s1u_inst->flush_g_pdus(); });
+}
+//------------------------------------------------------------------------------
+bool pfcp_switch::start_pdn_rings() {
+  if (spgwu_cfg.snat) {
+    // Frames are captured before netfilter, DL traffic would still carry the
+    // SNAT address as destination
+    Logger::pfcp_switch().warn(
+        "SGi IO_BACKEND TPACKET_V3 is not compatible with SNAT, using TUN");
+    return false;
+  }
+  const uint16_t fanout_group_id = (getpid() + 1) & 0xFFFF;
+  unsigned int num_rings =
+      std::max(1u, spgwu_cfg.sgi.thread_rd_sched_params.thread_pool_size);
+  try {
+    for (int i = 0; i < num_rings; i++) {
+      pdn_rings_.push_back(std::unique_ptr<packet_ring>(new packet_ring(
+          spgwu_cfg.sgi.if_name, fanout_group_id, ROOM_FOR_GTPV1U_G_PDU)));
+    }
+  } catch (std::system_error& e) {
+    Logger::pfcp_switch().error(
+        "Could not set SGi packet rings (%s), using TUN", e.what());
+    pdn_rings_.clear();
+    return false;
+  }
+  for (auto& ring : pdn_rings_) {
+    std::thread t = thread(
+        &pfcp_switch::pdn_ring_loop, this, ring.get(),
+        spgwu_cfg.sgi.thread_rd_sched_params);
+    t.detach();
+    threads_.push_back(std::move(t));
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+int pfcp_switch::tun_queue() {
+  // Each sender thread writes in its own TUN queue
+  thread_local int sock_q = -1;
+  if (sock_q < 0) {
+    sock_q = socks_r.size() ?
+                 socks_r[tx_queue_rr_.fetch_add(1) % socks_r.size()] :
+                 sock_w;
+  }
+  return sock_q;
+}
+//------------------------------------------------------------------------------
+bool pfcp_switch::write_to_core(
+    const struct iovec* const iov, const int iovcnt,
+    const unsigned int num_packets) {
   ssize_t bytes_sent;
-  // Logger::pfcp_switch().trace( "pfcp_switch::send_to_core %d bytes ", len);
-  if ((bytes_sent = write(sock_w, ip_packet, len)) < 0) {
+  const int sock_q = tun_queue();
+  if ((bytes_sent = writev(sock_q, iov, iovcnt)) >= 0) {
+    return true;
+  } else if (
+      (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS)) {
+    for (unsigned int i = 0; i < num_packets; i++) {
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_QUEUE_FULL);
+    }
+  } else {
     Logger::pfcp_switch().error(
-        "write fd %d failed rc=%d:%s", sock_w, bytes_sent, strerror(errno));
+        "write fd %d failed rc=%d:%s", sock_q, bytes_sent, strerror(errno));
   }
+  return false;
+}
+//------------------------------------------------------------------------------
+// UL superpacket of a packet worker, flushed before it waits for packets
+static tun_gro* thread_tun_gro() {
+  if (util::qsbr::reader_id() < 0) return nullptr;
+  thread_local std::unique_ptr<tun_gro> gro(new tun_gro());
+  return gro.get();
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::send_to_core(char* const ip_packet, const ssize_t len) {
+  datapath_stats& stats = datapath_stats::get_instance();
+  struct iovec iov[2]   = {};
+  if (not tun_offload_) {
+    iov[0].iov_base = ip_packet;
+    iov[0].iov_len  = len;
+    if (write_to_core(iov, 1, 1)) stats.forwarded(DATAPATH_UL, len);
+    return;
+  }
+  // Counted as forwarded once merged, as dropped if the superpacket write
+  // fails
+  tun_gro* gro = thread_tun_gro();
+  if (gro) {
+    if (gro->merge(ip_packet, len)) {
+      stats.forwarded(DATAPATH_UL, len);
+      return;
+    }
+    // Not the next segment of the pending superpacket
+    flush_to_core();
+    if (gro->merge(ip_packet, len)) {
+      stats.forwarded(DATAPATH_UL, len);
+      return;
+    }
+  }
+  // Written alone, nothing for the kernel to do
+  tun_vnet_hdr_t vh = {};
+  iov[0].iov_base   = &vh;
+  iov[0].iov_len    = sizeof(vh);
+  iov[1].iov_base   = ip_packet;
+  iov[1].iov_len    = len;
+  if (write_to_core(iov, 2, 1)) stats.forwarded(DATAPATH_UL, len);
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::flush_to_core() {
+  if (not tun_offload_) return;
+  tun_gro* gro = thread_tun_gro();
+  if ((not gro) || (gro->empty())) return;
+  const unsigned int num_packets = gro->segments();
+  struct iovec iov               = {};
+  std::size_t len                = 0;
+  iov.iov_base                   = (void*) gro->finish(len);
+  iov.iov_len                    = len;
+  write_to_core(&iov, 1, num_packets);
 }
 //------------------------------------------------------------------------------
 int pfcp_switch::create_pdn_socket(
@@ -252,7 +473,8 @@ int pfcp_switch::create_pdn_socket(const char* const ifname) {
   return RETURNerror;
 }
 //------------------------------------------------------------------------------
-int pfcp_switch::tun_open(char* devname, int flags) {
+int pfcp_switch::tun_open(
+    char* devname, int flags, const bool multi_queue, const bool vnet_hdr) {
   struct ifreq ifr;
   int fd, err;
   if ((fd = open("/dev/net/tun", flags)) == -1) {
@@ -261,6 +483,10 @@ int pfcp_switch::tun_open(char* devname, int flags) {
   }
   memset(&ifr, 0, sizeof(ifr));
   ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  // Every open of a multi queue TUN attaches a new queue
+  if (multi_queue) ifr.ifr_flags |= IFF_MULTI_QUEUE;
+  // Device wide, the same for all the queues
+  if (vnet_hdr) ifr.ifr_flags |= IFF_VNET_HDR;
   strncpy(ifr.ifr_name, devname, IFNAMSIZ);  // devname = tunX
 
   if ((err = ioctl(fd, TUNSETIFF, (void*) &ifr)) == -1) {
@@ -271,6 +497,61 @@ int pfcp_switch::tun_open(char* devname, int flags) {
   return fd;
 }
 //------------------------------------------------------------------------------
+int pfcp_switch::attach_pdn_steering_ebpf(int fd) {
+  // Select the TUN queue on the UE address, the program returns a hash and
+  // the kernel takes it modulo the number of queues. The packet starts at the
+  // IP header: IPv4 destination address, or the low 32 bits of the IPv6
+  // destination /64 prefix.
+  struct bpf_insn prog[8] = {};
+  // r6 = r1 (skb), needed by BPF_LD_ABS
+  prog[0].code    = BPF_ALU64 | BPF_MOV | BPF_X;
+  prog[0].dst_reg = BPF_REG_6;
+  prog[0].src_reg = BPF_REG_1;
+  // r0 = ip version
+  prog[1].code    = BPF_LD | BPF_B | BPF_ABS;
+  prog[1].imm     = 0;
+  prog[2].code    = BPF_ALU64 | BPF_RSH | BPF_K;
+  prog[2].dst_reg = BPF_REG_0;
+  prog[2].imm     = 4;
+  prog[3].code    = BPF_JMP | BPF_JEQ | BPF_K;
+  prog[3].dst_reg = BPF_REG_0;
+  prog[3].off     = 2;
+  prog[3].imm     = 6;
+  // IPv4: r0 = daddr
+  prog[4].code    = BPF_LD | BPF_W | BPF_ABS;
+  prog[4].imm     = offsetof(struct iphdr, daddr);
+  prog[5].code    = BPF_JMP | BPF_JA;
+  prog[5].off     = 1;
+  // IPv6: r0 = daddr[4..7]
+  prog[6].code    = BPF_LD | BPF_W | BPF_ABS;
+  prog[6].imm     = offsetof(struct ipv6hdr, daddr) + 4;
+  prog[7].code    = BPF_JMP | BPF_EXIT;
+
+  char license[]      = "GPL";
+  union bpf_attr attr = {};
+  attr.prog_type      = BPF_PROG_TYPE_SOCKET_FILTER;
+  attr.insns          = (uint64_t)(uintptr_t) prog;
+  attr.insn_cnt       = sizeof(prog) / sizeof(prog[0]);
+  attr.license        = (uint64_t)(uintptr_t) license;
+  int prog_fd         = syscall(__NR_bpf, BPF_PROG_LOAD, &attr, sizeof(attr));
+  if (prog_fd < 0) {
+    Logger::pfcp_switch().warn(
+        "Could not load TUN steering program (%s), using flow hash",
+        strerror(errno));
+    return RETURNerror;
+  }
+  if (ioctl(fd, TUNSETSTEERINGEBPF, &prog_fd) < 0) {
+    Logger::pfcp_switch().warn(
+        "ioctl TUNSETSTEERINGEBPF failed (%s), using flow hash",
+        strerror(errno));
+    close(prog_fd);
+    return RETURNerror;
+  }
+  // The TUN device keeps a reference on the program
+  close(prog_fd);
+  return RETURNok;
+}
+//------------------------------------------------------------------------------
 void pfcp_switch::setup_pdn_interfaces() {
   std::string cmd = {};
   int rc          = 0;
@@ -282,14 +563,12 @@ void pfcp_switch::setup_pdn_interfaces() {
     pdn_cfg_t it = spgwu_cfg.pdns[index];
     int sock_r   = 0;
 
-    cmd = fmt::format("ip tuntap add mode tun dev tun{}", index);
+    cmd = fmt::format("ip tuntap add mode tun multi_queue dev tun{}", index);
     rc  = system((const char*) cmd.c_str());
 
     cmd = fmt::format("ip link set dev tun{} up", index);
     rc  = system((const char*) cmd.c_str());
 
-    cmd = fmt::format("ethtool -K tun{0} tx-checksum-ip-generic off;", index);
-    rc  = system((const char*) cmd.c_str());
     if (it.prefix_ipv4) {
       struct in_addr address4 = {};
       address4.s_addr         = it.network_ipv4.s_addr + be32toh(1);
@@ -340,20 +619,68 @@ void pfcp_switch::setup_pdn_interfaces() {
     // index); rc = system ((const char*)cmd.c_str());
 
     cmd = fmt::format("tun{}", index);
-    if ((sock_r = tun_open((char*) cmd.c_str(), O_RDWR)) == RETURNerror) {
-      Logger::pfcp_switch().error("Could not set PDN interface read socket");
-      sleep(2);
-      exit(EXIT_FAILURE);
+    bool multi_queue = true;
+    for (int q = 0; q < num_threads_; q++) {
+      if ((sock_r = tun_open(
+               (char*) cmd.c_str(), O_RDWR, multi_queue, tun_offload_)) ==
+          RETURNerror) {
+        if ((q == 0) && (multi_queue)) {
+          // tun device created without multi_queue support, single pipeline
+          Logger::pfcp_switch().warn(
+              "Could not open %s with multiple queues, using one",
+              cmd.c_str());
+          multi_queue  = false;
+          num_threads_ = 1;
+          q--;
+          continue;
+        }
+        Logger::pfcp_switch().error("Could not set PDN interface read socket");
+        sleep(2);
+        exit(EXIT_FAILURE);
+      }
+      if ((q == 0) && (tun_offload_) &&
+          (ioctl(
+               sock_r, TUNSETOFFLOAD,
+               TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6) == -1)) {
+        Logger::pfcp_switch().warn(
+            "ioctl TUNSETOFFLOAD failed on %s (%s), TUN offload disabled",
+            cmd.c_str(), strerror(errno));
+        close(sock_r);
+        tun_offload_ = false;
+        q--;
+        continue;
+      }
+      socks_r.push_back(sock_r);
+    }
+    sock_w = socks_r[0];
+    if (not tun_offload_) {
+      // Checksums computed by the kernel before the packets are read
+      cmd = fmt::format("ethtool -K tun{0} tx-checksum-ip-generic off;", index);
+      rc  = system((const char*) cmd.c_str());
+    }
+    if ((multi_queue) && (num_threads_ > 1)) {
+      attach_pdn_steering_ebpf(sock_w);
     }
 
-    sock_w = sock_r;
-
-    std::thread t = thread(
-        &pfcp_switch::pdn_read_loop, this, sock_r,
-        spgwu_cfg.sgi.thread_rd_sched_params);
-    t.detach();
-    threads_.push_back(std::move(t));
-    socks_r.push_back(sock_r);
+    // The TUN stays the UL path to the core, and the DL path when SGi frames
+    // are not read from packet rings
+    if ((spgwu_cfg.sgi.io_backend != PACKET_IO_BACKEND_TPACKET_V3) ||
+        (not start_pdn_rings())) {
+      for (int q = 0; q < socks_r.size(); q++) {
+        fcntl(socks_r[q], F_SETFL, fcntl(socks_r[q], F_GETFL) | O_NONBLOCK);
+        // One core per pipeline, starting from the configured one
+        util::thread_sched_params sched_params =
+            spgwu_cfg.sgi.thread_rd_sched_params;
+        if (sched_params.cpu_id >= 0) {
+          sched_params.cpu_id =
+              (sched_params.cpu_id + q) % std::thread::hardware_concurrency();
+        }
+        std::thread t = thread(
+            &pfcp_switch::pdn_read_loop, this, q, socks_r[q], sched_params);
+        t.detach();
+        threads_.push_back(std::move(t));
+      }
+    }
   }
 
   rc = system("/sbin/sysctl -w net.ipv4.conf.all.forwarding=1");
@@ -377,44 +704,379 @@ pfcp::fteid_t pfcp_switch::generate_fteid_s1u() {
   return fteid;
 }
 //------------------------------------------------------------------------------
+void pfcp_switch::free_teids_s1u(const pfcp::pfcp_session& session) {
+  std::vector<teid_t> teids              = {};
+  std::vector<uint32_t> ue_ipv4s         = {};
+  std::vector<uint64_t> ue_ipv6_prefixes = {};
+  session.get_fast_path_keys(teids, ue_ipv4s, ue_ipv6_prefixes);
+  for (auto teid : teids) {
+    free_teid_s1u(teid);
+  }
+}
+//------------------------------------------------------------------------------
 pfcp_switch::pfcp_switch()
     : seid_generator_(),
-      teid_s1u_generator_(),
-      ue_ipv4_hbo2pfcp_pdr(PFCP_SWITCH_MAX_PDRS),
-      ul_s1u_teid2pfcp_pdr(PFCP_SWITCH_MAX_PDRS),
-      up_seid2pfcp_sessions(PFCP_SWITCH_MAX_SESSIONS),
-      threads_(16),
-      socks_r(16),
-      sock_w(0) {
-  num_threads_   = 8;
-  int num_blocks = num_threads_ * 16;
-  free_pool_     = new folly::MPMCQueue<iovec_q_item_t*>(num_blocks);
-  work_pool_     = new folly::MPMCQueue<iovec_q_item_t*>(num_blocks);
-
-  recv_buffer_alloc_ = (char*) calloc(num_blocks, PFCP_SWITCH_RECV_BUFFER_SIZE);
-
-  for (int i = 0; i < num_blocks; i++) {
-    iovec_q_item_s* v = (iovec_q_item_s*) calloc(1, sizeof(iovec_q_item_s));
-    v->msg_iov.iov_base =
-        (void*) ((uintptr_t) calloc(1, PFCP_SWITCH_RECV_BUFFER_SIZE) + (uintptr_t) ROOM_FOR_GTPV1U_G_PDU);
-    v->msg_iov.iov_len = PFCP_SWITCH_RECV_BUFFER_SIZE - ROOM_FOR_GTPV1U_G_PDU;
-    v->msg.msg_iovlen  = 1;
-    v->msg.msg_flags   = 0;
-    v->msg.msg_control = nullptr;
-    v->msg.msg_controllen = 0;
-    free_pool_->blockingWrite(v);
-  }
-  for (int i = 0; i < num_threads_; i++) {
-    std::thread t = std::thread(
-        &pfcp_switch::pdn_worker, this, i,
-        spgwu_cfg.sgi.thread_rd_sched_params);
-    threads_.push_back(std::move(t));
-  }
+      teid_s1u_generator_(PFCP_SWITCH_TEID_ID_BITS, spgwu_cfg.teid_node_id),
+      ue_ipv4_hbo2fast_path(spgwu_cfg.max_pfcp_sessions),
+      ue_ipv6_prefix2fast_path(spgwu_cfg.max_pfcp_sessions),
+      ul_s1u_teid2fast_path(
+          spgwu_cfg.max_pfcp_sessions * PFCP_SWITCH_MAX_TEIDS_PER_SESSION),
+      up_seid2pfcp_sessions(),
+      threads_(),
+      socks_r(),
+      sock_w(0),
+      tun_offload_(spgwu_cfg.tun_offload),
+      tx_queue_rr_(0) {
+  num_threads_ =
+      std::max(1u, spgwu_cfg.sgi.thread_rd_sched_params.thread_pool_size);
   timer_min_commit_interval_id = 0;
   timer_max_commit_interval_id = 0;
+  timer_usage_reporting_id     = 0;
+  timer_session_snapshot_id    = 0;
+  timer_stats_id               = 0;
   cp_fseid2pfcp_sessions = {}, sock_w = -1;
+  cp_fseid2pfcp_sessions.reserve(spgwu_cfg.max_pfcp_sessions);
+  up_seid2pfcp_sessions.reserve(spgwu_cfg.max_pfcp_sessions);
+  Logger::pfcp_switch().info(
+      "Switching tables: %zu TEIDs (%zu slots), %zu UE IPv4 (%zu slots), %zu "
+      "UE IPv6 prefixes (%zu slots)",
+      ul_s1u_teid2fast_path.max_entries(), ul_s1u_teid2fast_path.capacity(),
+      ue_ipv4_hbo2fast_path.max_entries(), ue_ipv4_hbo2fast_path.capacity(),
+      ue_ipv6_prefix2fast_path.max_entries(),
+      ue_ipv6_prefix2fast_path.capacity());
+  pfcp::dl_buffer_pool::get_instance().set_max_size(
+      (std::size_t) spgwu_cfg.dl_buffer_max_size_mb << 20);
+  Logger::pfcp_switch().info(
+      "DL buffering: %zu packets at most",
+      pfcp::dl_buffer_pool::get_instance().get_max_slots());
   pdn_if_index = -1;
   setup_pdn_interfaces();
+  if (spgwu_cfg.gtp_kernel_offload) {
+    start_gtp_kernel_offload();
+  }
+  restore_pfcp_sessions();
+  start_timer_usage_reporting();
+  if (spgwu_cfg.stats_file.size()) {
+    start_timer_stats();
+  }
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::restore_pfcp_sessions() {
+  if (spgwu_cfg.session_snapshot_file.empty()) return;
+  session_snapshot_ = std::unique_ptr<pfcp::session_snapshot>(
+      new pfcp::session_snapshot(spgwu_cfg.session_snapshot_file));
+  uint64_t up_rts   = 0;
+  const bool loaded = session_snapshot_->load(
+      up_rts, [this](
+                  const pfcp::pfcp_session_establishment_request& ies,
+                  const uint64_t up_seid,
+                  const pfcp::recovery_time_stamp_t& cp_rts,
+                  const std::shared_ptr<const std::string>& record) {
+        return restore_pfcp_session(ies, up_seid, cp_rts, record);
+      });
+  if (loaded) {
+    // The CP functions keep their sessions if they see the same SPGW-U
+    spgwu_sx_inst->set_recovery_time_stamp(up_rts);
+  }
+  if (not session_snapshot_->start(
+          loaded, spgwu_sx_inst->get_recovery_time_stamp())) {
+    Logger::pfcp_switch().error("PFCP sessions are not saved");
+    session_snapshot_.reset();
+    return;
+  }
+  start_timer_session_snapshot();
+}
+//------------------------------------------------------------------------------
+bool pfcp_switch::restore_pfcp_session(
+    const pfcp::pfcp_session_establishment_request& ies,
+    const uint64_t up_seid, const pfcp::recovery_time_stamp_t& cp_rts,
+    const std::shared_ptr<const std::string>& record) {
+  pfcp::fseid_t fseid     = {};
+  pfcp::node_id_t node_id = {};
+  if ((not ies.get(fseid)) || (not ies.get(node_id)) ||
+      (up_seid2pfcp_sessions.count(up_seid)) ||
+      (cp_fseid2pfcp_sessions.count(fseid))) {
+    return false;
+  }
+  std::shared_ptr<pfcp::pfcp_session> s =
+      std::make_shared<pfcp::pfcp_session>(fseid, up_seid);
+  pfcp::cause_t cause   = {};
+  cause.cause_value     = CAUSE_VALUE_REQUEST_ACCEPTED;
+  uint16_t offending_ie = 0;
+  bool created          = true;
+  for (const auto& it : ies.create_fars) {
+    created = created && s->create(it, cause, offending_ie);
+  }
+  for (const auto& it : ies.create_urrs) {
+    created = created && s->create(it, cause, offending_ie);
+  }
+  for (const auto& it : ies.create_qers) {
+    created = created && s->create(it, cause, offending_ie);
+  }
+  if (ies.create_bar.first) {
+    created = created && s->create(ies.create_bar.second, cause, offending_ie);
+  }
+  for (const auto& it : ies.create_pdrs) {
+    pfcp::fteid_t fteid = {};
+    created = created && s->create(it, cause, offending_ie, fteid, true);
+  }
+  if (not created) {
+    // Also the TEIDs reserved by the PDRs restored before the failure
+    free_teids_s1u(*s);
+    s->cleanup();
+    return false;
+  }
+  s->cp_node_id      = node_id;
+  s->snapshot_record = record;
+  add_pfcp_session_by_cp_fseid(fseid, s);
+  add_pfcp_session_by_up_seid(up_seid, s);
+  seid_generator_.reserve_uid(up_seid);
+  if ((not commit_fast_path(*s)) ||
+      (not pfcp_associations::get_instance().restore_session(
+          node_id, cp_rts, fseid))) {
+    remove_pfcp_session(s);
+    return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::save_pfcp_session(pfcp::pfcp_session& session) {
+  if (not session_snapshot_) return;
+  std::shared_ptr<std::string> record = std::make_shared<std::string>();
+  if (not pfcp::session_snapshot::encode(session, *record)) {
+    Logger::pfcp_switch().error(
+        "Cannot save PFCP session SEID 0x%" PRIx64, session.seid);
+    return;
+  }
+  session_snapshot_->journal(*record);
+  session.snapshot_record = record;
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::start_timer_session_snapshot() {
+  timer_session_snapshot_id = itti_inst->timer_setup(
+      spgwu_cfg.session_snapshot_interval_sec, 0, TASK_SPGWU_APP,
+      TASK_SPGWU_PFCP_SWITCH_SESSION_SNAPSHOT);
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::time_out_session_snapshot(const uint32_t timer_id) {
+  std::vector<std::shared_ptr<const std::string>> records = {};
+  records.reserve(up_seid2pfcp_sessions.size());
+  for (const auto& it : up_seid2pfcp_sessions) {
+    if (it.second->snapshot_record) {
+      records.push_back(it.second->snapshot_record);
+    }
+  }
+  if (not session_snapshot_->save(
+          records, spgwu_sx_inst->get_recovery_time_stamp())) {
+    Logger::pfcp_switch().warn(
+        "Previous session snapshot still being written, snapshot skipped");
+  }
+  start_timer_session_snapshot();
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::start_timer_stats() {
+  timer_stats_id = itti_inst->timer_setup(
+      spgwu_cfg.stats_interval_sec, 0, TASK_SPGWU_APP,
+      TASK_SPGWU_PFCP_SWITCH_STATS);
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::time_out_stats(const uint32_t timer_id) {
+  std::vector<datapath_metric_t> metrics = {};
+  metrics.push_back(
+      {"spgwu_pfcp_sessions", "", "gauge", "PFCP sessions",
+       (double) up_seid2pfcp_sessions.size()});
+  const std::pair<const char*, const fast_path_table_t*> tables[] = {
+      {"ul_teid", &ul_s1u_teid2fast_path},
+      {"ue_ipv4", &ue_ipv4_hbo2fast_path},
+      {"ue_ipv6_prefix", &ue_ipv6_prefix2fast_path}};
+  for (const auto& t : tables) {
+    metrics.push_back(
+        {"spgwu_fast_path_entries", fmt::format("table=\"{}\"", t.first),
+         "gauge", "Entries of the switching tables",
+         (double) t.second->size()});
+  }
+  for (const auto& t : tables) {
+    metrics.push_back(
+        {"spgwu_fast_path_max_entries", fmt::format("table=\"{}\"", t.first),
+         "gauge", "Capacity of the switching tables",
+         (double) t.second->max_entries()});
+  }
+  metrics.push_back(
+      {"spgwu_qsbr_retired", "", "gauge",
+       "Replaced fast path entries not yet freed",
+       (double) util::qsbr::get_instance().pending()});
+
+  std::size_t used_slots = 0;
+  std::size_t max_slots  = 0;
+  pfcp::dl_buffer_pool::get_instance().get_occupancy(used_slots, max_slots);
+  metrics.push_back(
+      {"spgwu_dl_buffer_slots", "", "gauge",
+       "DL buffer slots holding a packet", (double) used_slots});
+  metrics.push_back(
+      {"spgwu_dl_buffer_max_slots", "", "gauge", "DL buffer slots at most",
+       (double) max_slots});
+  pfcp::dl_buffer_counters_t dl = {};
+  pfcp::dl_buffer_pool::get_instance().get_counters(dl);
+  const std::pair<const char*, uint64_t> dl_events[] = {
+      {"buffered", dl.buffered},
+      {"forwarded", dl.forwarded},
+      {"dropped_buffer_full", dl.dropped_buffer_full},
+      {"evicted", dl.evicted},
+      {"dropped", dl.dropped}};
+  for (const auto& e : dl_events) {
+    metrics.push_back(
+        {"spgwu_dl_buffer_packets_total", fmt::format("event=\"{}\"", e.first),
+         "counter", "DL packets of idle UEs", (double) e.second});
+  }
+
+  // Metrics of a family are consecutive, one per NUMA node
+  std::vector<util::packet_pool_counters_t> pool = {};
+  util::packet_pool::get_instance().get_counters(pool);
+  const struct {
+    const char* family;
+    const char* type;
+    const char* help;
+    uint64_t util::packet_pool_counters_t::*value;
+  } pool_families[] = {
+      {"spgwu_packet_pool_buffers", "gauge", "Packet buffers of the NUMA node",
+       &util::packet_pool_counters_t::buffers},
+      {"spgwu_packet_pool_free_buffers", "gauge",
+       "Packet buffers not in use, caches of the workers included",
+       &util::packet_pool_counters_t::free},
+      {"spgwu_packet_pool_allocs_total", "counter",
+       "Packet buffer allocations", &util::packet_pool_counters_t::allocs},
+      {"spgwu_packet_pool_cache_hits_total", "counter",
+       "Packet buffer allocations served by the cache of a worker",
+       &util::packet_pool_counters_t::cache_hits},
+      {"spgwu_packet_pool_exhausted_total", "counter",
+       "Packet buffer allocations failed, no buffer left",
+       &util::packet_pool_counters_t::exhausted}};
+  for (const auto& f : pool_families) {
+    for (const auto& n : pool) {
+      metrics.push_back(
+          {f.family, fmt::format("node=\"{}\"", n.node), f.type, f.help,
+           (double) (n.*f.value)});
+    }
+  }
+  for (const auto& n : pool) {
+    metrics.push_back(
+        {"spgwu_packet_pool_hugepages", fmt::format("node=\"{}\"", n.node),
+         "gauge", "1 if the packet buffers are on hugepages",
+         (double) n.hugepages});
+  }
+
+  udp_io_counters_t io = {};
+  spgwu_s1u_inst->get_io_counters(io);
+  metrics.push_back(
+      {"spgwu_s1u_datagrams_total", "direction=\"rx\"", "counter",
+       "S1-U datagrams", (double) io.rx_packets});
+  metrics.push_back(
+      {"spgwu_s1u_datagrams_total", "direction=\"tx\"", "counter",
+       "S1-U datagrams", (double) io.tx_packets});
+  metrics.push_back(
+      {"spgwu_s1u_syscalls_total", "direction=\"rx\"", "counter",
+       "S1-U receive and send system calls", (double) io.rx_syscalls});
+  metrics.push_back(
+      {"spgwu_s1u_syscalls_total", "direction=\"tx\"", "counter",
+       "S1-U receive and send system calls", (double) io.tx_syscalls});
+  metrics.push_back(
+      {"spgwu_s1u_tx_dropped_total", "", "counter",
+       "S1-U datagrams not sent, the send system call failed",
+       (double) io.tx_dropped});
+
+  // Traffic of each path: the packet workers and the gtp module
+  uint64_t packets[DATAPATH_DIRECTIONS] = {};
+  uint64_t bytes[DATAPATH_DIRECTIONS]   = {};
+  datapath_stats::get_instance().read_forwarded(packets, bytes);
+  gtp_mod_kernel_counters_t gtp = {};
+  gtp_kernel_.get_counters(gtp);
+  const struct {
+    const char* labels;
+    uint64_t packets;
+    uint64_t bytes;
+  } paths[] = {
+      {"path=\"userspace\",direction=\"ul\"", packets[DATAPATH_UL],
+       bytes[DATAPATH_UL]},
+      {"path=\"userspace\",direction=\"dl\"", packets[DATAPATH_DL],
+       bytes[DATAPATH_DL]},
+      {"path=\"kernel\",direction=\"ul\"", gtp.rx_packets, gtp.rx_bytes},
+      {"path=\"kernel\",direction=\"dl\"", gtp.tx_packets, gtp.tx_bytes}};
+  for (const auto& p : paths) {
+    metrics.push_back(
+        {"spgwu_path_packets_total", p.labels, "counter",
+         "Packets forwarded by the packet workers and by the gtp module",
+         (double) p.packets});
+  }
+  for (const auto& p : paths) {
+    metrics.push_back(
+        {"spgwu_path_bytes_total", p.labels, "counter",
+         "Bytes forwarded by the packet workers (IP) and by the gtp module "
+         "(device counters)",
+         (double) p.bytes});
+  }
+  metrics.push_back(
+      {"spgwu_gtp_kernel_sessions", "", "gauge",
+       "PFCP sessions switched by the gtp module", (double) gtp.tunnels});
+  const std::pair<const char*, uint64_t> gtp_events[] = {
+      {"offloaded", gtp.tunnels_added},
+      {"returned", gtp.tunnels_deleted},
+      {"failed", gtp.failures}};
+  for (const auto& e : gtp_events) {
+    metrics.push_back(
+        {"spgwu_gtp_kernel_migrations_total",
+         fmt::format("event=\"{}\"", e.first), "counter",
+         "Sessions moved to the gtp module and back to the packet workers",
+         (double) e.second});
+  }
+
+  // Formatted here, the file is written by the async command task
+  const std::string text =
+      datapath_stats::get_instance().to_prometheus(metrics) +
+      itti_inst->to_prometheus("spgwu");
+  const std::string path = spgwu_cfg.stats_file;
+  async_shell_cmd_inst->run_job(
+      TASK_SPGWU_APP, false, __FILE__, __LINE__, "write " + path,
+      [text, path]() {
+        return datapath_stats::write_file(path, text) ? RETURNok :
+                                                        RETURNerror;
+      });
+  start_timer_stats();
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::notify_association(
+    const pfcp::node_id_t& node_id, const pfcp::recovery_time_stamp_t& cp_rts) {
+  if (session_snapshot_) {
+    session_snapshot_->journal_association(node_id, cp_rts);
+  }
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::start_timer_usage_reporting() {
+  timer_usage_reporting_id = itti_inst->timer_setup(
+      PFCP_SWITCH_USAGE_REPORTING_INTERVAL_SECONDS, 0, TASK_SPGWU_APP,
+      TASK_SPGWU_PFCP_SWITCH_USAGE_REPORTING);
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::time_out_usage_reporting(const uint32_t timer_id) {
+  const std::time_t now = std::time(nullptr);
+  for (const auto& it : up_seid2pfcp_sessions) {
+    const pfcp::pfcp_session& session = *it.second.get();
+    for (auto urr : session.urrs) {
+      pfcp::usage_report_trigger_t trigger = {};
+      if (not urr->check_triggers(now, trigger)) {
+        continue;
+      }
+      pfcp::usage_report_within_pfcp_session_report_request usage_report = {};
+      urr->report(now, trigger, usage_report);
+
+      pfcp::pfcp_session_report_request h = {};
+      pfcp::report_type_t report          = {};
+      report.usar                         = 1;
+      h.set(report);
+      h.set(usage_report);
+      spgwu_sx_inst->send_sx_msg(session.cp_fseid, h);
+    }
+  }
+  start_timer_usage_reporting();
 }
 //------------------------------------------------------------------------------
 bool pfcp_switch::get_pfcp_session_by_cp_fseid(
@@ -434,7 +1096,7 @@ bool pfcp_switch::get_pfcp_session_by_cp_fseid(
 bool pfcp_switch::get_pfcp_session_by_up_seid(
     const uint64_t cp_seid,
     std::shared_ptr<pfcp::pfcp_session>& session) const {
-  folly::AtomicHashMap<
+  std::unordered_map<
       uint64_t, std::shared_ptr<pfcp::pfcp_session>>::const_iterator sit =
       up_seid2pfcp_sessions.find(cp_seid);
   if (sit == up_seid2pfcp_sessions.end()) {
@@ -445,32 +1107,9 @@ bool pfcp_switch::get_pfcp_session_by_up_seid(
   }
 }
 //------------------------------------------------------------------------------
-bool pfcp_switch::get_pfcp_ul_pdrs_by_up_teid(
-    const teid_t teid,
-    std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>& pdrs) const {
-  folly::AtomicHashMap<
-      teid_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>::
-      const_iterator pit = ul_s1u_teid2pfcp_pdr.find(teid);
-  if (pit == ul_s1u_teid2pfcp_pdr.end())
-    return false;
-  else {
-    pdrs = pit->second;
-    return true;
-  }
-}
-//------------------------------------------------------------------------------
-bool pfcp_switch::get_pfcp_dl_pdrs_by_ue_ip(
-    const uint32_t ue_ip,
-    std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>& pdrs) const {
-  folly::AtomicHashMap<
-      uint32_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>::
-      const_iterator pit = ue_ipv4_hbo2pfcp_pdr.find(ue_ip);
-  if (pit == ue_ipv4_hbo2pfcp_pdr.end())
-    return false;
-  else {
-    pdrs = pit->second;
-    return true;
-  }
+const pfcp::fast_path_entry* pfcp_switch::get_fast_path_entry(
+    const fast_path_table_t& table, const uint64_t key) const {
+  return table.find(key);
 }
 //------------------------------------------------------------------------------
 void pfcp_switch::add_pfcp_session_by_cp_fseid(
@@ -487,9 +1126,14 @@ void pfcp_switch::add_pfcp_session_by_up_seid(
 //------------------------------------------------------------------------------
 void pfcp_switch::remove_pfcp_session(
     std::shared_ptr<pfcp::pfcp_session>& session) {
+  withdraw_fast_path(*session.get());
+  free_teids_s1u(*session.get());
   session->cleanup();
   cp_fseid2pfcp_sessions.erase(session->cp_fseid);
   up_seid2pfcp_sessions.erase(session->seid);
+  if (session_snapshot_) {
+    session_snapshot_->journal_delete(session->seid);
+  }
 }
 //------------------------------------------------------------------------------
 void pfcp_switch::remove_pfcp_session(const pfcp::fseid_t& cp_fseid) {
@@ -500,76 +1144,161 @@ void pfcp_switch::remove_pfcp_session(const pfcp::fseid_t& cp_fseid) {
 }
 
 //------------------------------------------------------------------------------
-void pfcp_switch::add_pfcp_ul_pdr_by_up_teid(
-    const teid_t teid, std::shared_ptr<pfcp::pfcp_pdr>& pdr) {
-  folly::AtomicHashMap<
-      teid_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>::
-      const_iterator pit = ul_s1u_teid2pfcp_pdr.find(teid);
-  if (pit == ul_s1u_teid2pfcp_pdr.end()) {
-    std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>> pdrs =
-        std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>(
-            new std::vector<std::shared_ptr<pfcp::pfcp_pdr>>());
-    pdrs->push_back(pdr);
-    std::pair<
-        teid_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>
-        entry(teid, pdrs);
-    // Logger::pfcp_switch().info( "add_pfcp_ul_pdr_by_up_teid tunnel " TEID_FMT
-    // " ", teid);
-    ul_s1u_teid2pfcp_pdr.insert(entry);
-  } else {
-    // sort by precedence
-    // const std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>&
-    // spdrs = pit->second;
-    std::vector<std::shared_ptr<pfcp::pfcp_pdr>>* pdrs = pit->second.get();
-    for (std::vector<std::shared_ptr<pfcp::pfcp_pdr>>::iterator it =
-             pdrs->begin();
-         it < pdrs->end(); ++it) {
-      if (*(it->get()) < *(pdr.get())) {
-        pit->second->insert(it, pdr);
-        return;
-      }
+bool pfcp_switch::publish_fast_path_entry(
+    fast_path_table_t& table, const uint64_t key,
+    pfcp::fast_path_entry* entry) {
+  pfcp::fast_path_entry* old = nullptr;
+  if (entry) {
+    if (not table.set(key, entry, old)) {
+      Logger::pfcp_switch().error(
+          "Switching table full (%zu entries), cannot switch key %" PRIx64,
+          table.size(), key);
+      delete entry;
+      return false;
     }
+  } else {
+    old = table.erase(key);
+  }
+  // Workers may still be reading the previous entry, do not free it now
+  if (old) {
+    util::qsbr::get_instance().retire(old);
   }
+  return true;
 }
 //------------------------------------------------------------------------------
-void pfcp_switch::remove_pfcp_ul_pdrs_by_up_teid(const teid_t teid) {
-  ul_s1u_teid2pfcp_pdr.erase(teid);
+void pfcp_switch::reclaim_fast_path_entries() {
+  // Retired entries that are still referenced are freed on a next request
+  util::qsbr::get_instance().reclaim();
 }
-
 //------------------------------------------------------------------------------
-void pfcp_switch::add_pfcp_dl_pdr_by_ue_ip(
-    const uint32_t ue_ip, std::shared_ptr<pfcp::pfcp_pdr>& pdr) {
-  folly::AtomicHashMap<
-      uint32_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>::
-      const_iterator pit = ue_ipv4_hbo2pfcp_pdr.find(ue_ip);
-  if (pit == ue_ipv4_hbo2pfcp_pdr.end()) {
-    std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>> pdrs =
-        std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>(
-            new std::vector<std::shared_ptr<pfcp::pfcp_pdr>>());
-    pdrs->push_back(pdr);
-    std::pair<
-        uint32_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>
-        entry(ue_ip, pdrs);
-    ue_ipv4_hbo2pfcp_pdr.insert(entry);
-    // Logger::pfcp_switch().info( "add_pfcp_dl_pdr_by_ue_ip UE IP %8x", ue_ip);
-  } else {
-    // sort by precedence
-    // const std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>&
-    // spdrs = pit->second;
-    std::vector<std::shared_ptr<pfcp::pfcp_pdr>>* pdrs = pit->second.get();
-    for (std::vector<std::shared_ptr<pfcp::pfcp_pdr>>::iterator it =
-             pdrs->begin();
-         it < pdrs->end(); ++it) {
-      if (*(it->get()) < *(pdr.get())) {
-        pit->second->insert(it, pdr);
-        return;
-      }
+bool pfcp_switch::commit_fast_path(pfcp::pfcp_session& session) {
+  // Packets buffered while the FAR was buffering leave before the ones
+  // switched by the new entries
+  session.apply_dl_buffering();
+
+  std::vector<teid_t> teids              = {};
+  std::vector<uint32_t> ue_ipv4s         = {};
+  std::vector<uint64_t> ue_ipv6_prefixes = {};
+  session.get_fast_path_keys(teids, ue_ipv4s, ue_ipv6_prefixes);
+
+  for (auto teid : session.fast_path_teids) {
+    if (not std::binary_search(teids.begin(), teids.end(), teid)) {
+      publish_fast_path_entry(ul_s1u_teid2fast_path, teid, nullptr);
+    }
+  }
+  for (auto ue_ipv4 : session.fast_path_ue_ipv4s) {
+    if (not std::binary_search(ue_ipv4s.begin(), ue_ipv4s.end(), ue_ipv4)) {
+      publish_fast_path_entry(ue_ipv4_hbo2fast_path, ue_ipv4, nullptr);
+    }
+  }
+  for (auto prefix : session.fast_path_ue_ipv6_prefixes) {
+    if (not std::binary_search(
+            ue_ipv6_prefixes.begin(), ue_ipv6_prefixes.end(), prefix)) {
+      publish_fast_path_entry(ue_ipv6_prefix2fast_path, prefix, nullptr);
+    }
+  }
+  bool published = true;
+  session.fast_path_teids.clear();
+  session.fast_path_ue_ipv4s.clear();
+  session.fast_path_ue_ipv6_prefixes.clear();
+  for (auto teid : teids) {
+    if (publish_fast_path_entry(
+            ul_s1u_teid2fast_path, teid, session.compile_ul_fast_path(teid))) {
+      session.fast_path_teids.push_back(teid);
+    } else {
+      published = false;
     }
   }
+  for (auto ue_ipv4 : ue_ipv4s) {
+    if (publish_fast_path_entry(
+            ue_ipv4_hbo2fast_path, ue_ipv4,
+            session.compile_dl_fast_path(ue_ipv4))) {
+      session.fast_path_ue_ipv4s.push_back(ue_ipv4);
+    } else {
+      published = false;
+    }
+  }
+  for (auto prefix : ue_ipv6_prefixes) {
+    if (publish_fast_path_entry(
+            ue_ipv6_prefix2fast_path, prefix,
+            session.compile_dl6_fast_path(prefix))) {
+      session.fast_path_ue_ipv6_prefixes.push_back(prefix);
+    } else {
+      published = false;
+    }
+  }
+  reclaim_fast_path_entries();
+  update_kernel_gtp(session, published);
+  return published;
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::withdraw_fast_path(pfcp::pfcp_session& session) {
+  update_kernel_gtp(session, false);
+  for (auto teid : session.fast_path_teids) {
+    publish_fast_path_entry(ul_s1u_teid2fast_path, teid, nullptr);
+  }
+  for (auto ue_ipv4 : session.fast_path_ue_ipv4s) {
+    publish_fast_path_entry(ue_ipv4_hbo2fast_path, ue_ipv4, nullptr);
+  }
+  for (auto prefix : session.fast_path_ue_ipv6_prefixes) {
+    publish_fast_path_entry(ue_ipv6_prefix2fast_path, prefix, nullptr);
+  }
+  const bool published = (session.fast_path_teids.size()) ||
+                         (session.fast_path_ue_ipv4s.size()) ||
+                         (session.fast_path_ue_ipv6_prefixes.size());
+  session.fast_path_teids.clear();
+  session.fast_path_ue_ipv4s.clear();
+  session.fast_path_ue_ipv6_prefixes.clear();
+  if (published) {
+    // Workers still switching with the old entries may add to the URR and
+    // QER counters until their next quiescent state
+    util::qsbr::get_instance().synchronize();
+  }
+  reclaim_fast_path_entries();
 }
 //------------------------------------------------------------------------------
-void pfcp_switch::remove_pfcp_dl_pdrs_by_ue_ip(const uint32_t ue_ip) {
-  ue_ipv4_hbo2pfcp_pdr.erase(ue_ip);
+void pfcp_switch::start_gtp_kernel_offload() {
+  // The packets read from packet rings would be switched twice
+  if (pdn_rings_.size()) {
+    Logger::pfcp_switch().warn(
+        "GTP kernel offload is not compatible with SGi IO_BACKEND "
+        "TPACKET_V3, not used");
+    return;
+  }
+  if ((not spgwu_cfg.s1_up.addr4.s_addr) ||
+      (spgwu_cfg.s1_up.port != gtpv1u::default_port)) {
+    Logger::pfcp_switch().warn(
+        "GTP kernel offload needs an IPv4 S1-U address and port %u, not used",
+        gtpv1u::default_port);
+    return;
+  }
+  std::vector<int> sockets = {};
+  spgwu_s1u_inst->get_receive_sockets(sockets);
+  if (sockets.empty()) {
+    Logger::pfcp_switch().warn(
+        "GTP kernel offload is not compatible with S1-U IO_BACKEND "
+        "TPACKET_V3, not used");
+    return;
+  }
+  gtp_kernel_.init(sockets);
+}
+//------------------------------------------------------------------------------
+void pfcp_switch::update_kernel_gtp(
+    pfcp::pfcp_session& session, const bool offload) {
+  if (not gtp_kernel_.enabled()) return;
+  pfcp::kernel_gtp_tunnel_t tunnel = {};
+  const bool eligible = (offload) && (session.get_kernel_gtp_tunnel(tunnel));
+  if (session.kernel_gtp_tunnel.first) {
+    if ((eligible) && (session.kernel_gtp_tunnel.second == tunnel)) return;
+    // The fast path entries are up to date, the packets of the tunnel are
+    // switched by the workers as soon as the module no longer knows it. A
+    // changed tunnel (e.g. new eNB) is deleted, then added again.
+    gtp_kernel_.del(session.kernel_gtp_tunnel.second);
+    session.kernel_gtp_tunnel.first = false;
+  }
+  if ((eligible) && (gtp_kernel_.add(tunnel))) {
+    session.kernel_gtp_tunnel = std::make_pair(true, tunnel);
+  }
 }
 //------------------------------------------------------------------------------
 std::string pfcp_switch::to_string() const {
@@ -580,15 +1309,6 @@ std::string pfcp_switch::to_string() const {
   return s;
 }
 
-//------------------------------------------------------------------------------
-bool pfcp_switch::create_packet_in_access(
-    std::shared_ptr<pfcp::pfcp_pdr>& pdr, const pfcp::fteid_t& in,
-    uint8_t& cause) {
-  cause = CAUSE_VALUE_REQUEST_ACCEPTED;
-  add_pfcp_ul_pdr_by_up_teid(in.teid, pdr);
-  return true;
-}
-
 //------------------------------------------------------------------------------
 void pfcp_switch::handle_pfcp_session_establishment_request(
     std::shared_ptr<itti_sxab_session_establishment_request> sreq,
@@ -608,12 +1328,48 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
       for (auto it : req->pfcp_ies.create_fars) {
         create_far& cr_far = it;
         if (not session->create(cr_far, cause, offending_ie.offending_ie)) {
+          free_teids_s1u(*session);
           session->cleanup();
           delete session;
           break;
         }
       }
 
+      if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+        for (auto it : req->pfcp_ies.create_urrs) {
+          create_urr& cr_urr = it;
+          if (not session->create(cr_urr, cause, offending_ie.offending_ie)) {
+            free_teids_s1u(*session);
+            session->cleanup();
+            delete session;
+            break;
+          }
+        }
+      }
+
+      if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+        for (auto it : req->pfcp_ies.create_qers) {
+          create_qer& cr_qer = it;
+          if (not session->create(cr_qer, cause, offending_ie.offending_ie)) {
+            free_teids_s1u(*session);
+            session->cleanup();
+            delete session;
+            break;
+          }
+        }
+      }
+
+      if ((cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) &&
+          (req->pfcp_ies.create_bar.first)) {
+        if (not session->create(
+                req->pfcp_ies.create_bar.second, cause,
+                offending_ie.offending_ie)) {
+          free_teids_s1u(*session);
+          session->cleanup();
+          delete session;
+        }
+      }
+
       if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
         //--------------------------------
         // Process PDR to be created
@@ -627,6 +1383,7 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
             // should be caught in lower layer
             cause.cause_value         = CAUSE_VALUE_MANDATORY_IE_MISSING;
             offending_ie.offending_ie = PFCP_IE_FAR_ID;
+            free_teids_s1u(*session);
             session->cleanup();
             delete session;
             break;
@@ -637,6 +1394,7 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
             // should be caught in lower layer
             cause.cause_value         = CAUSE_VALUE_MANDATORY_IE_MISSING;
             offending_ie.offending_ie = PFCP_IE_CREATE_FAR;
+            free_teids_s1u(*session);
             session->cleanup();
             delete session;
             break;
@@ -644,11 +1402,21 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
 
           if (not session->create(
                   cr_pdr, cause, offending_ie.offending_ie, allocated_fteid)) {
+            free_teids_s1u(*session);
             session->cleanup();
             delete session;
-            if (cause.cause_value == CAUSE_VALUE_CONDITIONAL_IE_MISSING) {
+            if ((cause.cause_value == CAUSE_VALUE_CONDITIONAL_IE_MISSING) ||
+                (cause.cause_value ==
+                 CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE)) {
               resp->pfcp_ies.set(offending_ie);
             }
+            if (cause.cause_value ==
+                CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE) {
+              failed_rule_id_t failed_rule = {};
+              failed_rule.rule_id_type     = FAILED_RULE_ID_TYPE_PDR;
+              failed_rule.rule_id_value    = cr_pdr.pdr_id.second.rule_id;
+              resp->pfcp_ies.set(failed_rule);
+            }
             resp->pfcp_ies.set(cause);
             break;
           }
@@ -663,6 +1431,13 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
         s = std::shared_ptr<pfcp_session>(session);
         add_pfcp_session_by_cp_fseid(fseid, s);
         add_pfcp_session_by_up_seid(session->seid, s);
+        if (not commit_fast_path(*session)) {
+          remove_pfcp_session(s);
+          cause.cause_value = CAUSE_VALUE_NO_RESOURCES_AVAILABLE;
+        }
+      }
+
+      if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
         // start_timer_min_commit_interval();
         // start_timer_max_commit_interval();
 
@@ -675,6 +1450,8 @@ void pfcp_switch::handle_pfcp_session_establishment_request(
         pfcp::node_id_t node_id = {};
         req->pfcp_ies.get(node_id);
         pfcp_associations::get_instance().notify_add_session(node_id, fseid);
+        session->cp_node_id = node_id;
+        save_pfcp_session(*session);
       }
     } else {
       cause.cause_value = CAUSE_VALUE_REQUEST_REJECTED;
@@ -774,6 +1551,42 @@ void pfcp_switch::handle_pfcp_session_modification_request(
       }
     }
 
+    if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+      for (auto it : req->pfcp_ies.remove_urrs) {
+        remove_urr& urr = it;
+        if (not session->remove(urr, cause, offending_ie.offending_ie)) {
+          if (cause.cause_value ==
+              CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE) {
+            failed_rule.rule_id_type  = FAILED_RULE_ID_TYPE_URR;
+            failed_rule.rule_id_value = urr.urr_id.second.urr_id;
+            resp->pfcp_ies.set(failed_rule);
+            break;
+          }
+        }
+      }
+    }
+
+    if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+      for (auto it : req->pfcp_ies.remove_qers) {
+        remove_qer& qer = it;
+        if (not session->remove(qer, cause, offending_ie.offending_ie)) {
+          if (cause.cause_value ==
+              CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE) {
+            failed_rule.rule_id_type  = FAILED_RULE_ID_TYPE_QER;
+            failed_rule.rule_id_value = qer.qer_id.second.qer_id;
+            resp->pfcp_ies.set(failed_rule);
+            break;
+          }
+        }
+      }
+    }
+
+    if ((cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) &&
+        (req->pfcp_ies.remove_bar.first)) {
+      session->remove(
+          req->pfcp_ies.remove_bar.second, cause, offending_ie.offending_ie);
+    }
+
     if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
       for (auto it : req->pfcp_ies.create_fars) {
         create_far& cr_far = it;
@@ -783,6 +1596,30 @@ void pfcp_switch::handle_pfcp_session_modification_request(
       }
     }
 
+    if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+      for (auto it : req->pfcp_ies.create_urrs) {
+        create_urr& cr_urr = it;
+        if (not session->create(cr_urr, cause, offending_ie.offending_ie)) {
+          break;
+        }
+      }
+    }
+
+    if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
+      for (auto it : req->pfcp_ies.create_qers) {
+        create_qer& cr_qer = it;
+        if (not session->create(cr_qer, cause, offending_ie.offending_ie)) {
+          break;
+        }
+      }
+    }
+
+    if ((cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) &&
+        (req->pfcp_ies.create_bar.first)) {
+      session->create(
+          req->pfcp_ies.create_bar.second, cause, offending_ie.offending_ie);
+    }
+
     if (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED) {
       for (auto it : req->pfcp_ies.create_pdrs) {
         create_pdr& cr_pdr = it;
@@ -806,9 +1643,17 @@ void pfcp_switch::handle_pfcp_session_modification_request(
         pfcp::fteid_t allocated_fteid = {};
         if (not session->create(
                 cr_pdr, cause, offending_ie.offending_ie, allocated_fteid)) {
-          if (cause.cause_value == CAUSE_VALUE_CONDITIONAL_IE_MISSING) {
+          if ((cause.cause_value == CAUSE_VALUE_CONDITIONAL_IE_MISSING) ||
+              (cause.cause_value ==
+               CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE)) {
             resp->pfcp_ies.set(offending_ie);
           }
+          if (cause.cause_value ==
+              CAUSE_VALUE_RULE_CREATION_MODIFICATION_FAILURE) {
+            failed_rule.rule_id_type  = FAILED_RULE_ID_TYPE_PDR;
+            failed_rule.rule_id_value = cr_pdr.pdr_id.second.rule_id;
+            resp->pfcp_ies.set(failed_rule);
+          }
           resp->pfcp_ies.set(cause);
           break;
         }
@@ -826,6 +1671,7 @@ void pfcp_switch::handle_pfcp_session_modification_request(
         update_pdr& pdr     = it;
         uint8_t cause_value = CAUSE_VALUE_REQUEST_ACCEPTED;
         if (not session->update(pdr, cause_value)) {
+          cause.cause_value            = cause_value;
           failed_rule_id_t failed_rule = {};
           failed_rule.rule_id_type     = FAILED_RULE_ID_TYPE_PDR;
           failed_rule.rule_id_value    = pdr.pdr_id.rule_id;
@@ -843,7 +1689,46 @@ void pfcp_switch::handle_pfcp_session_modification_request(
           resp->pfcp_ies.set(failed_rule);
         }
       }
+      for (auto it : req->pfcp_ies.update_urrs) {
+        update_urr& urr     = it;
+        uint8_t cause_value = CAUSE_VALUE_REQUEST_ACCEPTED;
+        if (not session->update(urr, cause_value)) {
+          cause.cause_value            = cause_value;
+          failed_rule_id_t failed_rule = {};
+          failed_rule.rule_id_type     = FAILED_RULE_ID_TYPE_URR;
+          failed_rule.rule_id_value    = urr.urr_id.second.urr_id;
+          resp->pfcp_ies.set(failed_rule);
+        }
+      }
+      for (auto it : req->pfcp_ies.update_qers) {
+        update_qer& qer     = it;
+        uint8_t cause_value = CAUSE_VALUE_REQUEST_ACCEPTED;
+        if (not session->update(qer, cause_value)) {
+          cause.cause_value            = cause_value;
+          failed_rule_id_t failed_rule = {};
+          failed_rule.rule_id_type     = FAILED_RULE_ID_TYPE_QER;
+          failed_rule.rule_id_value    = qer.qer_id.second.qer_id;
+          resp->pfcp_ies.set(failed_rule);
+        }
+      }
+      if (req->pfcp_ies.update_bar.first) {
+        uint8_t cause_value = CAUSE_VALUE_REQUEST_ACCEPTED;
+        if (not session->update(req->pfcp_ies.update_bar.second, cause_value)) {
+          cause.cause_value            = cause_value;
+          failed_rule_id_t failed_rule = {};
+          failed_rule.rule_id_type     = FAILED_RULE_ID_TYPE_BAR;
+          failed_rule.rule_id_value =
+              req->pfcp_ies.update_bar.second.bar_id.second.bar_id;
+          resp->pfcp_ies.set(failed_rule);
+        }
+      }
+    }
+    // Whatever has been applied, the fast path must reflect it
+    if ((not commit_fast_path(*session)) &&
+        (cause.cause_value == CAUSE_VALUE_REQUEST_ACCEPTED)) {
+      cause.cause_value = CAUSE_VALUE_NO_RESOURCES_AVAILABLE;
     }
+    save_pfcp_session(*session);
   }
   resp->pfcp_ies.set(cause);
   if ((cause.cause_value == CAUSE_VALUE_MANDATORY_IE_MISSING) ||
@@ -898,6 +1783,17 @@ void pfcp_switch::handle_pfcp_session_deletion_request(
     cause.cause_value = CAUSE_VALUE_SESSION_CONTEXT_NOT_FOUND;
   } else {
     resp->seid = s->cp_fseid.seid;
+    // Final usage of the URRs, once no packet worker can add to them
+    withdraw_fast_path(*s.get());
+    const std::time_t now = std::time(nullptr);
+    for (auto urr : s->urrs) {
+      pfcp::usage_report_within_pfcp_session_deletion_response usage_report =
+          {};
+      pfcp::usage_report_trigger_t trigger = {};
+      trigger.termr                        = 1;
+      urr->report(now, trigger, usage_report);
+      resp->pfcp_ies.set(usage_report);
+    }
     remove_pfcp_session(s);
   }
   pfcp_associations::get_instance().notify_del_session(fseid);
@@ -935,42 +1831,78 @@ void pfcp_switch::handle_pfcp_session_deletion_request(
 #endif
 }
 //------------------------------------------------------------------------------
+void pfcp_switch::apply_fast_path_rule(
+    const pfcp::fast_path_entry& entry, const pfcp::fast_path_rule_t& rule,
+    char* const ip_packet, const std::size_t num_bytes,
+    util::packet_buf_t* const pbuf) {
+  const pfcp::fast_path_action_t& action = rule.action;
+  for (int i = 0; i < rule.num_qers; i++) {
+    if (not rule.qers[i]->enforce(rule.uplink, num_bytes)) {
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_QER);
+      return;
+    }
+  }
+  if (rule.urr) {
+    rule.urr->counters.count(rule.uplink, num_bytes);
+  }
+  if (action.forw) {
+    if (action.destination_interface == INTERFACE_VALUE_ACCESS) {
+      switch (action.outer_header_creation_description) {
+        case OUTER_HEADER_CREATION_GTPU_UDP_IPV4:
+          spgwu_s1u_inst->send_g_pdu(
+              action.peer_ipv4, action.peer_port, action.teid, ip_packet,
+              num_bytes, pbuf);
+          datapath_stats::get_instance().forwarded(DATAPATH_DL, num_bytes);
+          break;
+        case OUTER_HEADER_CREATION_GTPU_UDP_IPV6:
+          spgwu_s1u_inst->send_g_pdu(
+              action.peer_ipv6, action.peer_port, action.teid, ip_packet,
+              num_bytes, pbuf);
+          datapath_stats::get_instance().forwarded(DATAPATH_DL, num_bytes);
+          break;
+        default:
+          // Other outer headers are refused at FAR creation/modification
+          datapath_stats::get_instance().dropped(
+              DATAPATH_DROP_NO_OUTER_HEADER);
+      }
+    } else if (action.destination_interface == INTERFACE_VALUE_CORE) {
+      bool to_core = false;
+      if (((struct iphdr*) ip_packet)->version == 4) {
+        to_core = no_internal_loop((struct iphdr*) ip_packet, num_bytes);
+      } else {
+        to_core = no_internal_loop((struct ipv6hdr*) ip_packet, num_bytes);
+      }
+      if (to_core) {
+        send_to_core(ip_packet, num_bytes);
+      }
+    }
+  } else if (action.drop) {
+    datapath_stats::get_instance().dropped(DATAPATH_DROP_FAR_DROP);
+  } else if (action.buff) {
+    rule.pdr->buffering_requested(ip_packet, num_bytes);
+  }
+  if (action.nocp) {
+    rule.pdr->notify_cp_requested(entry.cp_fseid);
+  }
+}
+//------------------------------------------------------------------------------
 void pfcp_switch::pfcp_session_look_up_pack_in_access(
     struct iphdr* const iph, const std::size_t num_bytes,
     const endpoint& r_endpoint, const uint32_t tunnel_id) {
   if (!spgwu_cfg.nsf.bypass_ul_pfcp_rules) {
-    std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>> pdrs = {};
-    if (get_pfcp_ul_pdrs_by_up_teid(tunnel_id, pdrs)) {
-      bool nocp = false;
-      bool buff = false;
-      for (std::vector<std::shared_ptr<pfcp::pfcp_pdr>>::iterator it_pdr =
-               pdrs->begin();
-           it_pdr < pdrs->end(); ++it_pdr) {
-        if ((*it_pdr)->look_up_pack_in_access(
-                iph, num_bytes, r_endpoint, tunnel_id)) {
-          std::shared_ptr<pfcp::pfcp_session> ssession = {};
-          uint64_t lseid                               = 0;
-          if ((*it_pdr)->get(lseid)) {
-            if (get_pfcp_session_by_up_seid(lseid, ssession)) {
-              pfcp::far_id_t far_id = {};
-              if ((*it_pdr)->get(far_id)) {
-                std::shared_ptr<pfcp::pfcp_far> sfar = {};
-                if (ssession->get(far_id.far_id, sfar)) {
-                  sfar->apply_forwarding_rules(iph, num_bytes, nocp, buff);
-                }
-              }
-            }
-          }
-          return;
-        } else {
-          Logger::pfcp_switch().info(
-              "pfcp_session_look_up_pack_in_access failed PDR id %4x ",
-              (*it_pdr)->pdr_id.rule_id);
-        }
+    const pfcp::fast_path_entry* entry =
+        get_fast_path_entry(ul_s1u_teid2fast_path, tunnel_id);
+    if (entry) {
+      const pfcp::fast_path_rule_t* rule =
+          entry->classify(iph, num_bytes, true);
+      if (rule) {
+        apply_fast_path_rule(
+            *entry, *rule, reinterpret_cast<char*>(iph), num_bytes);
+      } else {
+        datapath_stats::get_instance().dropped(DATAPATH_DROP_PDR_MISS);
       }
     } else {
-      // Logger::pfcp_switch().info( "pfcp_session_look_up_pack_in_access tunnel
-      // " TEID_FMT " not found", tunnel_id);
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_UNKNOWN_TEID);
       spgwu_s1u_inst->report_error_indication(r_endpoint, tunnel_id);
     }
   } else {
@@ -993,80 +1925,88 @@ bool pfcp_switch::no_internal_loop(
   return true;
 }
 //------------------------------------------------------------------------------
+bool pfcp_switch::no_internal_loop(
+    struct ipv6hdr* const ip6h, const std::size_t num_bytes) {
+  if (is_pdn_ipv6_address(ip6h->daddr)) {
+    // UE to UE
+    pfcp_session_look_up_pack_in_core((const char*) ip6h, num_bytes);
+    return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
 void pfcp_switch::pfcp_session_look_up_pack_in_access(
     struct ipv6hdr* const ip6h, const std::size_t num_bytes,
     const endpoint& r_endpoint, const uint32_t tunnel_id) {
-  // TODO
+  if (!spgwu_cfg.nsf.bypass_ul_pfcp_rules) {
+    const pfcp::fast_path_entry* entry =
+        get_fast_path_entry(ul_s1u_teid2fast_path, tunnel_id);
+    if (entry) {
+      // The source address of the UE is checked against its /64 prefix
+      const pfcp::fast_path_rule_t* rule =
+          entry->classify(ip6h, num_bytes, true);
+      if (rule) {
+        apply_fast_path_rule(
+            *entry, *rule, reinterpret_cast<char*>(ip6h), num_bytes);
+      } else {
+        datapath_stats::get_instance().dropped(DATAPATH_DROP_PDR_MISS);
+      }
+    } else {
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_UNKNOWN_TEID);
+      spgwu_s1u_inst->report_error_indication(r_endpoint, tunnel_id);
+    }
+  } else {
+    if (no_internal_loop(ip6h, num_bytes)) {
+      pfcp_switch_inst->send_to_core(
+          reinterpret_cast<char* const>(ip6h), num_bytes);
+    }
+  }
 }
 //------------------------------------------------------------------------------
 void pfcp_switch::pfcp_session_look_up_pack_in_core(
-    const char* buffer, const std::size_t num_bytes) {
+    const char* buffer, const std::size_t num_bytes,
+    util::packet_buf_t* const pbuf) {
   // Logger::pfcp_switch().info( "pfcp_session_look_up_pack_in_core %d bytes",
   // num_bytes);
   struct iphdr* iph = (struct iphdr*) buffer;
-  std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>> pdrs;
   if (iph->version == 4) {
     uint32_t ue_ip = be32toh(iph->daddr);
-    if (get_pfcp_dl_pdrs_by_ue_ip(ue_ip, pdrs)) {
-      bool nocp = false;
-      bool buff = false;
-      for (std::vector<std::shared_ptr<pfcp::pfcp_pdr>>::iterator it =
-               pdrs->begin();
-           it < pdrs->end(); ++it) {
-        if ((*it)->look_up_pack_in_core(iph, num_bytes)) {
-          std::shared_ptr<pfcp::pfcp_session> ssession = {};
-          uint64_t lseid                               = 0;
-          if ((*it)->get(lseid)) {
-            if (get_pfcp_session_by_up_seid(lseid, ssession)) {
-              pfcp::far_id_t far_id = {};
-              if ((*it)->get(far_id)) {
-                std::shared_ptr<pfcp::pfcp_far> sfar = {};
-                //#if TRACE_IS_ON
-                //                Logger::pfcp_switch().trace(
-                //                "pfcp_session_look_up_pack_in_core %d bytes,
-                //                far id %08X", num_bytes, far_id);
-                //#endif
-                if (ssession->get(far_id.far_id, sfar)) {
-                  //#if TRACE_IS_ON
-                  //                  Logger::pfcp_switch().trace(
-                  //                  "pfcp_session_look_up_pack_in_core %d
-                  //                  bytes, got far, far id %08X", num_bytes,
-                  //                  far_id);
-                  //#endif
-                  sfar->apply_forwarding_rules(iph, num_bytes, nocp, buff);
-                  if (buff) {
-                    //#if TRACE_IS_ON
-                    //                    Logger::pfcp_switch().trace(
-                    //                    "Buffering %d bytes, far id %08X",
-                    //                    num_bytes, far_id);
-                    //#endif
-                    (*it)->buffering_requested(buffer, num_bytes);
-                  }
-                  if (nocp) {
-                    //#if TRACE_IS_ON
-                    //                    Logger::pfcp_switch().trace( "Notify
-                    //                    CP %d bytes, far id %08X", num_bytes,
-                    //                    far_id);
-                    //#endif
-                    (*it)->notify_cp_requested(ssession);
-                  }
-                }
-              }
-            }
-          }
-          return;
-        } else {
-          Logger::pfcp_switch().info(
-              "look_up_pack_in_core failed PDR id %4x ", (*it)->pdr_id.rule_id);
-        }
+    const pfcp::fast_path_entry* entry =
+        get_fast_path_entry(ue_ipv4_hbo2fast_path, ue_ip);
+    if (entry) {
+      const pfcp::fast_path_rule_t* rule =
+          entry->classify(iph, num_bytes, false);
+      if (rule) {
+        apply_fast_path_rule(
+            *entry, *rule, const_cast<char*>(buffer), num_bytes, pbuf);
+      } else {
+        datapath_stats::get_instance().dropped(DATAPATH_DROP_PDR_MISS);
       }
     } else {
-      Logger::pfcp_switch().info(
-          "pfcp_session_look_up_pack_in_core UE IP %8x not found", ue_ip);
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_UNKNOWN_UE_IP);
     }
   } else if (iph->version == 6) {
-    // TODO;
+    struct ipv6hdr* ip6h = (struct ipv6hdr*) buffer;
+    if (num_bytes < sizeof(struct ipv6hdr)) {
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_MALFORMED);
+      return;
+    }
+    uint64_t prefix = pfcp::fast_path_ipv6_prefix_key(ip6h->daddr);
+    const pfcp::fast_path_entry* entry =
+        get_fast_path_entry(ue_ipv6_prefix2fast_path, prefix);
+    if (entry) {
+      const pfcp::fast_path_rule_t* rule =
+          entry->classify(ip6h, num_bytes, false);
+      if (rule) {
+        apply_fast_path_rule(
+            *entry, *rule, const_cast<char*>(buffer), num_bytes, pbuf);
+      } else {
+        datapath_stats::get_instance().dropped(DATAPATH_DROP_PDR_MISS);
+      }
+    } else {
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_UNKNOWN_UE_IP);
+    }
   } else {
-    Logger::pfcp_switch().info("Unknown IP version %d packet", iph->version);
+    datapath_stats::get_instance().dropped(DATAPATH_DROP_MALFORMED);
   }
 }
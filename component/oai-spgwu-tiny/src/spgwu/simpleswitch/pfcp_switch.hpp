@@ -32,85 +32,136 @@
 #include "itti.hpp"
 #include "itti_msg_sxab.hpp"
 #include "msg_pfcp.hpp"
+#include "packet_pool.hpp"
+#include "packet_ring.hpp"
+#include "pfcp_fast_path.hpp"
+#include "fixed_hash_table.hpp"
+#include "gtp_mod_kernel.hpp"
 #include "pfcp_session.hpp"
+#include "pfcp_session_snapshot.hpp"
+#include "qsbr.hpp"
 #include "uint_generator.hpp"
 #include "thread_sched.hpp"
+#include "tun_offload.hpp"
 
-#include <folly/AtomicHashMap.h>
-#include <folly/MPMCQueue.h>
+#include <atomic>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <unordered_map>
 #include <memory>
 #include <netinet/in.h>
+#include <sys/uio.h>
 #include <thread>
 #include <vector>
 
 namespace spgwu {
 
-// Have to be tuned for sdt situations
-#define PFCP_SWITCH_MAX_SESSIONS 128
-#define PFCP_SWITCH_MAX_PDRS 128
+// UL TEIDs switched per session (default bearer and dedicated bearers), with
+// MAX_PFCP_SESSIONS it sizes the S1-U TEID table
+#define PFCP_SWITCH_MAX_TEIDS_PER_SESSION 4
 
-typedef struct iovec_q_item_s {
-  struct iovec msg_iov;
-  struct msghdr msg;
-} iovec_q_item_t;
+typedef util::fixed_hash_table<pfcp::fast_path_entry> fast_path_table_t;
 
 class pfcp_switch {
  private:
-  // Very unoptimized
 #define PFCP_SWITCH_RECV_BUFFER_SIZE 2048
 #define ROOM_FOR_GTPV1U_G_PDU 64
-  folly::MPMCQueue<iovec_q_item_t*>* free_pool_;
-  folly::MPMCQueue<iovec_q_item_t*>* work_pool_;
+  // One SGi pipeline per TUN queue, each one reads and switches to completion
   uint32_t num_threads_;
-  char* recv_buffer_alloc_;
-  char recv_buffer_[PFCP_SWITCH_RECV_BUFFER_SIZE];
   std::vector<std::thread> threads_;
+  // TUN queues, sock_w is the first one
   std::vector<int> socks_r;
   int sock_w;
+  // TUN opened with IFF_VNET_HDR, see tun_offload.hpp
+  bool tun_offload_;
+  // Round robin of the UL sender threads on the TUN queues
+  std::atomic<uint32_t> tx_queue_rr_;
+  // SGi TPACKET_V3 rings, when used they replace the TUN readers
+  std::vector<std::unique_ptr<packet_ring>> pdn_rings_;
   // std::string                               gw_mac_address;
   int pdn_if_index;
 
-  util::uint_generator<uint64_t> seid_generator_;
-  util::uint_generator<teid_t> teid_s1u_generator_;
+  util::uint_block_generator<uint64_t> seid_generator_;
+// The upper 8 bits of the S1-U TEIDs are the TEID_NODE_ID of the config
+#define PFCP_SWITCH_TEID_ID_BITS 24
+  util::uint_bitmap_generator<teid_t> teid_s1u_generator_;
 
 #define TASK_SPGWU_PFCP_SWITCH_MAX_COMMIT_INTERVAL (0)
 #define TASK_SPGWU_PFCP_SWITCH_MIN_COMMIT_INTERVAL (1)
+#define TASK_SPGWU_PFCP_SWITCH_USAGE_REPORTING (2)
+#define TASK_SPGWU_PFCP_SWITCH_SESSION_SNAPSHOT (3)
+#define TASK_SPGWU_PFCP_SWITCH_STATS (4)
 
 #define PFCP_SWITCH_MAX_COMMIT_INTERVAL_MILLISECONDS 200
 #define PFCP_SWITCH_MIN_COMMIT_INTERVAL_MILLISECONDS 50
+// URR volume, time and periodic triggers are evaluated at this pace
+#define PFCP_SWITCH_USAGE_REPORTING_INTERVAL_SECONDS 1
 
   // switching_data_per_cpu_socket             switching_data[];
+  // Sessions, only used by the control path
   std::unordered_map<pfcp::fseid_t, std::shared_ptr<pfcp::pfcp_session>>
       cp_fseid2pfcp_sessions;
-  folly::AtomicHashMap<uint64_t, std::shared_ptr<pfcp::pfcp_session>>
+  std::unordered_map<uint64_t, std::shared_ptr<pfcp::pfcp_session>>
       up_seid2pfcp_sessions;
-  folly::AtomicHashMap<
-      teid_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>
-      ul_s1u_teid2pfcp_pdr;
-  folly::AtomicHashMap<
-      uint32_t, std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>>
-      ue_ipv4_hbo2pfcp_pdr;
+  // Switching tables of the packet workers, they only hold compiled entries.
+  // Entries are replaced with one atomic store, the replaced ones are freed
+  // when all the packet workers went through a quiescent state (util::qsbr).
+  fast_path_table_t ul_s1u_teid2fast_path;
+  fast_path_table_t ue_ipv4_hbo2fast_path;
+  // Keyed by the /64 prefix of the UE (pfcp::fast_path_ipv6_prefix_key)
+  fast_path_table_t ue_ipv6_prefix2fast_path;
+
+  // Null if the sessions are not saved (no SESSION_SNAPSHOT_FILE)
+  std::unique_ptr<pfcp::session_snapshot> session_snapshot_;
+
+  // Simple default bearers also switched by the Linux gtp module, not
+  // enabled unless GTP_KERNEL_OFFLOAD
+  gtp_mod_kernel gtp_kernel_;
 
   // moodycamel::ConcurrentQueue<pfcp::pfcp_session*> create_session_q;
 
-  void pdn_worker(const int id, const util::thread_sched_params& sched_params);
-  void pdn_read_loop(int sock_r, const util::thread_sched_params& sched_params);
+  void pdn_read_loop(
+      const int id, int sock_r, const util::thread_sched_params& sched_params);
+  // Read a packet with its virtio header: in packet if it fits in room,
+  // otherwise linear in big, then packet points to big
+  ssize_t read_pdn_offload(
+      const int sock_r, tun_vnet_hdr_t& vh, char*& packet,
+      const std::size_t room, char* const big);
+  // Segments of a TCP superpacket switched one after the other
+  void switch_pdn_superpacket(
+      const tun_vnet_hdr_t& vh, char* const packet, const std::size_t len);
+  void pdn_ring_loop(
+      packet_ring* ring, const util::thread_sched_params& sched_params);
+  bool start_pdn_rings();
+  bool is_pdn_ipv4_address(const uint32_t addr_be) const;
+  bool is_pdn_ipv6_address(const struct in6_addr& addr) const;
   int create_pdn_socket(
       const char* const ifname, const bool promisc, int& if_index);
   int create_pdn_socket(const char* const ifname);
-  int tun_open(char* devname, int flags);
+  int tun_open(
+      char* devname, int flags, const bool multi_queue, const bool vnet_hdr);
+  int attach_pdn_steering_ebpf(int fd);
+  // TUN queue of the calling thread
+  int tun_queue();
+  // num_packets are dropped if the TUN queue is full
+  bool write_to_core(
+      const struct iovec* const iov, const int iovcnt,
+      const unsigned int num_packets);
   void setup_pdn_interfaces();
 
   timer_id_t timer_max_commit_interval_id;
   timer_id_t timer_min_commit_interval_id;
+  timer_id_t timer_usage_reporting_id;
+  timer_id_t timer_session_snapshot_id;
+  timer_id_t timer_stats_id;
 
   void stop_timer_min_commit_interval();
   void start_timer_min_commit_interval();
   void stop_timer_max_commit_interval();
   void start_timer_max_commit_interval();
+  void start_timer_usage_reporting();
+  void start_timer_session_snapshot();
+  void start_timer_stats();
 
   void commit_changes();
 
@@ -118,22 +169,46 @@ class pfcp_switch {
       const pfcp::fseid_t&, std::shared_ptr<pfcp::pfcp_session>&) const;
   bool get_pfcp_session_by_up_seid(
       const uint64_t, std::shared_ptr<pfcp::pfcp_session>&) const;
-  bool get_pfcp_ul_pdrs_by_up_teid(
-      const teid_t,
-      std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>&) const;
-  bool get_pfcp_dl_pdrs_by_ue_ip(
-      const uint32_t,
-      std::shared_ptr<std::vector<std::shared_ptr<pfcp::pfcp_pdr>>>&) const;
+  const pfcp::fast_path_entry* get_fast_path_entry(
+      const fast_path_table_t& table, const uint64_t key) const;
 
   void add_pfcp_session_by_cp_fseid(
       const pfcp::fseid_t&, std::shared_ptr<pfcp::pfcp_session>&);
   void add_pfcp_session_by_up_seid(
       const uint64_t, std::shared_ptr<pfcp::pfcp_session>&);
-  void add_pfcp_ul_pdr_by_up_teid(
-      const teid_t teid, std::shared_ptr<pfcp::pfcp_pdr>&);
 
   void remove_pfcp_session(std::shared_ptr<pfcp::pfcp_session>&);
 
+  // Rebuild the sessions of the snapshot before any Sx exchange, the SPGW-U
+  // then keeps its recovery time stamp
+  void restore_pfcp_sessions();
+  bool restore_pfcp_session(
+      const pfcp::pfcp_session_establishment_request& ies,
+      const uint64_t up_seid, const pfcp::recovery_time_stamp_t& cp_rts,
+      const std::shared_ptr<const std::string>& record);
+  // Journal the state of a session after a change
+  void save_pfcp_session(pfcp::pfcp_session& session);
+
+  // Control path: (re)compile the fast path entries of a session and publish
+  // them, or unlink them all and wait until no worker still uses them
+  bool commit_fast_path(pfcp::pfcp_session& session);
+  void withdraw_fast_path(pfcp::pfcp_session& session);
+  // Control path: move the session to the gtp module if it can switch it
+  // (offload, fast path entries published) or back to the packet workers
+  void start_gtp_kernel_offload();
+  void update_kernel_gtp(pfcp::pfcp_session& session, const bool offload);
+  bool publish_fast_path_entry(
+      fast_path_table_t& table, const uint64_t key,
+      pfcp::fast_path_entry* entry);
+  void reclaim_fast_path_entries();
+
+  // ip_packet is an IPv4 or an IPv6 packet, in pbuf if it was read in a
+  // util::packet_pool buffer
+  void apply_fast_path_rule(
+      const pfcp::fast_path_entry& entry, const pfcp::fast_path_rule_t& rule,
+      char* const ip_packet, const std::size_t num_bytes,
+      util::packet_buf_t* const pbuf = nullptr);
+
   uint64_t generate_seid() { return seid_generator_.get_uid(); };
 
   teid_t generate_teid_s1u() { return teid_s1u_generator_.get_uid(); };
@@ -143,13 +218,16 @@ class pfcp_switch {
   pfcp_switch(pfcp_switch const&) = delete;
   void operator=(pfcp_switch const&) = delete;
 
-  void add_pfcp_dl_pdr_by_ue_ip(
-      const uint32_t ue_ip, std::shared_ptr<pfcp::pfcp_pdr>&);
-
   pfcp::fteid_t generate_fteid_s1u();
-  bool create_packet_in_access(
-      std::shared_ptr<pfcp::pfcp_pdr>& pdr, const pfcp::fteid_t& in,
-      uint8_t& cause);
+  void free_teid_s1u(const teid_t teid) {
+    teid_s1u_generator_.free_uid(teid);
+  };
+  bool reserve_teid_s1u(const teid_t teid) {
+    return teid_s1u_generator_.reserve_uid(teid);
+  };
+  // Control path: the TEIDs of the PDRs of a session removed or rejected,
+  // before its cleanup()
+  void free_teids_s1u(const pfcp::pfcp_session& session);
 
   void pfcp_session_look_up_pack_in_access(
       struct iphdr* const iph, const std::size_t num_bytes,
@@ -166,11 +244,19 @@ class pfcp_switch {
   // void pfcp_session_look_up(struct ethhdr* const ethh, const std::size_t
   // num_bytes);
 
+  // A G-PDU sent from pbuf holds a reference on it, see
+  // udp_server::batch_send_to()
   void pfcp_session_look_up_pack_in_core(
-      const char* buffer, const std::size_t num_bytes);
+      const char* buffer, const std::size_t num_bytes,
+      util::packet_buf_t* const pbuf = nullptr);
 
   bool no_internal_loop(struct iphdr* const iph, const std::size_t num_bytes);
+  bool no_internal_loop(
+      struct ipv6hdr* const ip6h, const std::size_t num_bytes);
   void send_to_core(char* const ip_packet, const ssize_t len);
+  // Packet workers: write the UL superpacket coalesced by send_to_core(),
+  // before waiting for more packets
+  void flush_to_core();
 
   void handle_pfcp_session_establishment_request(
       std::shared_ptr<itti_sxab_session_establishment_request> sreq,
@@ -184,10 +270,22 @@ class pfcp_switch {
 
   void time_out_min_commit_interval(const uint32_t timer_id);
   void time_out_max_commit_interval(const uint32_t timer_id);
+  // Control path: sums the per worker counters of the URRs, sends a usage
+  // report to the CP function for each URR whose reporting triggers are met
+  void time_out_usage_reporting(const uint32_t timer_id);
+  // Control path: the sessions are saved to the snapshot file by a
+  // background thread, the journal restarts
+  void time_out_session_snapshot(const uint32_t timer_id);
+  // Control path: the packet path statistics and the occupancy of the tables
+  // and pools are written to STATS_FILE by the async command task
+  void time_out_stats(const uint32_t timer_id);
+
+  // Sx task: recovery time stamp of a CP function on association setup
+  void notify_association(
+      const pfcp::node_id_t& node_id,
+      const pfcp::recovery_time_stamp_t& cp_rts);
 
   void remove_pfcp_session(const pfcp::fseid_t& cp_fseid);
-  void remove_pfcp_ul_pdrs_by_up_teid(const teid_t);
-  void remove_pfcp_dl_pdrs_by_ue_ip(const uint32_t);
 
   std::string to_string() const;
 };
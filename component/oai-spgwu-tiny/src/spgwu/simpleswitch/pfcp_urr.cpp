@@ -0,0 +1,145 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_urr.cpp
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_urr.hpp"
+
+using namespace pfcp;
+
+//------------------------------------------------------------------------------
+urr_counters::urr_counters()
+    : num_workers_(util::qsbr::get_instance().num_reader_ids()),
+      workers_(new urr_worker_counters_t[num_workers_]),
+      others_() {
+  for (std::size_t i = 0; i < num_workers_; i++) {
+    workers_[i].ul_bytes.store(0, std::memory_order_relaxed);
+    workers_[i].ul_packets.store(0, std::memory_order_relaxed);
+    workers_[i].dl_bytes.store(0, std::memory_order_relaxed);
+    workers_[i].dl_packets.store(0, std::memory_order_relaxed);
+  }
+  others_.ul_bytes.store(0, std::memory_order_relaxed);
+  others_.ul_packets.store(0, std::memory_order_relaxed);
+  others_.dl_bytes.store(0, std::memory_order_relaxed);
+  others_.dl_packets.store(0, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+void urr_counters::read(urr_usage_t& usage) const {
+  usage.ul_bytes   = others_.ul_bytes.load(std::memory_order_relaxed);
+  usage.ul_packets = others_.ul_packets.load(std::memory_order_relaxed);
+  usage.dl_bytes   = others_.dl_bytes.load(std::memory_order_relaxed);
+  usage.dl_packets = others_.dl_packets.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < num_workers_; i++) {
+    const urr_worker_counters_t& c = workers_[i];
+    usage.ul_bytes += c.ul_bytes.load(std::memory_order_relaxed);
+    usage.ul_packets += c.ul_packets.load(std::memory_order_relaxed);
+    usage.dl_bytes += c.dl_bytes.load(std::memory_order_relaxed);
+    usage.dl_packets += c.dl_packets.load(std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+pfcp_urr::pfcp_urr(const pfcp::create_urr& c)
+    : ur_seqn(0),
+      start_time(std::time(nullptr)),
+      next_period(0),
+      reported(),
+      urr_id(c.urr_id.second),
+      measurement_method(c.measurement_method.second),
+      reporting_triggers(c.reporting_triggers.second),
+      measurement_period(c.measurement_period),
+      volume_threshold(c.volume_threshold),
+      time_threshold(c.time_threshold),
+      counters() {
+  if (measurement_period.first) {
+    next_period = start_time + measurement_period.second.measurement_period;
+  }
+}
+//------------------------------------------------------------------------------
+bool pfcp_urr::update(const pfcp::update_urr& update, uint8_t& cause_value) {
+  if (update.measurement_method.first) {
+    measurement_method = update.measurement_method.second;
+  }
+  if (update.reporting_triggers.first) {
+    reporting_triggers = update.reporting_triggers.second;
+  }
+  if (update.measurement_period.first) {
+    measurement_period = update.measurement_period;
+    next_period =
+        std::time(nullptr) + measurement_period.second.measurement_period;
+  }
+  if (update.volume_threshold.first) {
+    volume_threshold = update.volume_threshold;
+  }
+  if (update.time_threshold.first) {
+    time_threshold = update.time_threshold;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+void pfcp_urr::take_usage(const std::time_t now, urr_usage_t& usage) {
+  urr_usage_t total = {};
+  counters.read(total);
+  usage.ul_bytes   = total.ul_bytes - reported.ul_bytes;
+  usage.ul_packets = total.ul_packets - reported.ul_packets;
+  usage.dl_bytes   = total.dl_bytes - reported.dl_bytes;
+  usage.dl_packets = total.dl_packets - reported.dl_packets;
+  reported         = total;
+  start_time       = now;
+}
+//------------------------------------------------------------------------------
+bool pfcp_urr::check_triggers(
+    const std::time_t now, pfcp::usage_report_trigger_t& trigger) {
+  trigger  = {};
+  bool met = false;
+  if (reporting_triggers.volth && volume_threshold.first) {
+    const pfcp::volume_threshold_t& t = volume_threshold.second;
+    urr_usage_t total                 = {};
+    counters.read(total);
+    const uint64_t ul = total.ul_bytes - reported.ul_bytes;
+    const uint64_t dl = total.dl_bytes - reported.dl_bytes;
+    if ((t.tovol && (ul + dl >= t.total_volume)) ||
+        (t.ulvol && (ul >= t.uplink_volume)) ||
+        (t.dlvol && (dl >= t.downlink_volume))) {
+      trigger.volth = 1;
+      met           = true;
+    }
+  }
+  if (reporting_triggers.timth && time_threshold.first &&
+      (now - start_time >= time_threshold.second.time_threshold)) {
+    trigger.timth = 1;
+    met           = true;
+  }
+  if (reporting_triggers.perio && measurement_period.first &&
+      measurement_period.second.measurement_period && (now >= next_period)) {
+    // Periods missed (e.g. the control path was busy) are not reported twice
+    while (next_period <= now) {
+      next_period += measurement_period.second.measurement_period;
+    }
+    trigger.perio = 1;
+    met           = true;
+  }
+  return met;
+}
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_urr.hpp
+   \brief Usage Reporting Rules, usage counted by the packet workers
+   \author  Lionel GAUTHIER
+   \date 2019
+   \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_URR_HPP_SEEN
+#define FILE_PFCP_URR_HPP_SEEN
+
+#include "msg_pfcp.hpp"
+#include "qsbr.hpp"
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+
+namespace pfcp {
+
+#define PFCP_URR_CACHE_LINE_SIZE 64
+// Seconds from 1900 (NTP, PFCP time stamps) to 1970 (UNIX)
+#define PFCP_URR_NTP_UNIX_OFFSET 2208988800UL
+
+// Usage counted by one packet worker. Only this worker writes it, with plain
+// loads and stores: no locked instruction, no cache line shared with other
+// workers.
+typedef struct alignas(PFCP_URR_CACHE_LINE_SIZE) urr_worker_counters_s {
+  std::atomic<uint64_t> ul_bytes;
+  std::atomic<uint64_t> ul_packets;
+  std::atomic<uint64_t> dl_bytes;
+  std::atomic<uint64_t> dl_packets;
+} urr_worker_counters_t;
+
+typedef struct urr_usage_s {
+  uint64_t ul_bytes;
+  uint64_t ul_packets;
+  uint64_t dl_bytes;
+  uint64_t dl_packets;
+} urr_usage_t;
+
+class urr_counters {
+ private:
+  // One slot per packet worker registered in util::qsbr when the URR was
+  // created
+  std::size_t num_workers_;
+  std::unique_ptr<urr_worker_counters_t[]> workers_;
+  // Other threads and workers registered later, shared, atomic additions
+  urr_worker_counters_t others_;
+
+  static inline void add(std::atomic<uint64_t>& c, const uint64_t n) {
+    c.store(
+        c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+ public:
+  urr_counters();
+  urr_counters(const urr_counters&) = delete;
+  void operator=(const urr_counters&) = delete;
+
+  // Packet workers
+  void count(const bool uplink, const std::size_t num_bytes) {
+    const int id = util::qsbr::reader_id();
+    if ((id >= 0) && ((std::size_t) id < num_workers_)) {
+      urr_worker_counters_t& c = workers_[id];
+      if (uplink) {
+        add(c.ul_bytes, num_bytes);
+        add(c.ul_packets, 1);
+      } else {
+        add(c.dl_bytes, num_bytes);
+        add(c.dl_packets, 1);
+      }
+    } else if (uplink) {
+      others_.ul_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+      others_.ul_packets.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      others_.dl_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+      others_.dl_packets.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Control path: sum of all the workers since the creation
+  void read(urr_usage_t& usage) const;
+};
+
+class pfcp_urr {
+ private:
+  // Measurement state, only used by the control path
+  uint32_t ur_seqn;
+  // Start of the current measurement (since the last report)
+  std::time_t start_time;
+  std::time_t next_period;
+  // Counters when the current measurement started
+  urr_usage_t reported;
+
+  void take_usage(const std::time_t now, urr_usage_t& usage);
+
+ public:
+  pfcp::urr_id_t urr_id;
+  pfcp::measurement_method_t measurement_method;
+  pfcp::reporting_triggers_t reporting_triggers;
+  std::pair<bool, pfcp::measurement_period_t> measurement_period;
+  std::pair<bool, pfcp::volume_threshold_t> volume_threshold;
+  std::pair<bool, pfcp::time_threshold_t> time_threshold;
+
+  // Written by the packet workers, the fast path entries point to it
+  urr_counters counters;
+
+  explicit pfcp_urr(const pfcp::create_urr& c);
+  pfcp_urr(const pfcp_urr&) = delete;
+  void operator=(const pfcp_urr&) = delete;
+
+  bool update(const pfcp::update_urr& update, uint8_t& cause_value);
+
+  // Control path: the reporting triggers met since the last report
+  bool check_triggers(
+      const std::time_t now, pfcp::usage_report_trigger_t& trigger);
+
+  // Control path: usage since the last report, a new measurement starts.
+  // T is one of the usage_report_within_* containers.
+  template <class T>
+  void report(
+      const std::time_t now, const pfcp::usage_report_trigger_t& trigger,
+      T& usage_report) {
+    const std::time_t start = start_time;
+    urr_usage_t usage       = {};
+    take_usage(now, usage);
+
+    pfcp::ur_seqn_t seqn           = {};
+    seqn.ur_seqn                   = ur_seqn++;
+    pfcp::start_time_t start_stamp = {};
+    start_stamp.start_time = (uint32_t)(start + PFCP_URR_NTP_UNIX_OFFSET);
+    pfcp::end_time_t end_stamp = {};
+    end_stamp.end_time         = (uint32_t)(now + PFCP_URR_NTP_UNIX_OFFSET);
+
+    usage_report.set(urr_id);
+    usage_report.set(seqn);
+    usage_report.set(trigger);
+    usage_report.set(start_stamp);
+    usage_report.set(end_stamp);
+    if (measurement_method.volum) {
+      pfcp::volume_measurement_t volume = {};
+      volume.tovol                      = 1;
+      volume.ulvol                      = 1;
+      volume.dlvol                      = 1;
+      volume.uplink_volume              = usage.ul_bytes;
+      volume.downlink_volume            = usage.dl_bytes;
+      volume.total_volume               = usage.ul_bytes + usage.dl_bytes;
+      usage_report.set(volume);
+    }
+    if (measurement_method.durat) {
+      pfcp::duration_measurement_t duration = {};
+      duration.duration                     = (uint32_t)(now - start);
+      usage_report.set(duration);
+    }
+  }
+};
+}  // namespace pfcp
+
+#endif /* FILE_PFCP_URR_HPP_SEEN */
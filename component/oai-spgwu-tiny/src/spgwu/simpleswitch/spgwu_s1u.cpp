@@ -28,6 +28,7 @@
 #include "3gpp_conversions.hpp"
 #include "common_defs.h"
 #include "conversions.hpp"
+#include "datapath_stats.hpp"
 #include "gtpu.h"
 #include "itti.hpp"
 #include "logger.hpp"
@@ -101,13 +102,21 @@ void spgwu_s1u_task(void* args_p) {
 spgwu_s1u::spgwu_s1u()
     : gtpu_l4_stack(
           spgwu_cfg.s1_up.addr4, spgwu_cfg.s1_up.port,
-          spgwu_cfg.s1_up.thread_rd_sched_params) {
+          spgwu_cfg.s1_up.thread_rd_sched_params, spgwu_cfg.s1_up.io_backend,
+          spgwu_cfg.s1_up.if_name) {
   Logger::spgwu_s1u().startup("Starting...");
   if (itti_inst->create_task(
           TASK_SPGWU_S1U, spgwu_s1u_task, &spgwu_cfg.itti.s1u_sched_params)) {
     Logger::spgwu_s1u().error("Cannot create task TASK_SPGWU_S1U");
     throw std::runtime_error("Cannot create task TASK_SPGWU_S1U");
   }
+  // IPv6 GTP-U peers (eNB F-TEID with an IPv6 address)
+  if ((spgwu_cfg.s1_up.addr4.s_addr) &&
+      (not IN6_IS_ADDR_UNSPECIFIED(&spgwu_cfg.s1_up.addr6))) {
+    start_ipv6(
+        spgwu_cfg.s1_up.addr6, spgwu_cfg.s1_up.port,
+        spgwu_cfg.s1_up.thread_rd_sched_params);
+  }
   Logger::spgwu_s1u().startup("Started");
 }
 //------------------------------------------------------------------------------
@@ -115,7 +124,6 @@ void spgwu_s1u::handle_receive(
     char* recv_buffer, const std::size_t bytes_transferred,
     const endpoint& r_endpoint) {
 #define GTPU_MESSAGE_FLAGS_POS_IN_UDP_PAYLOAD 0
-  // auto start = std::chrono::high_resolution_clock::now();
   struct gtpuhdr* gtpuh = (struct gtpuhdr*) &recv_buffer[0];
 
   if (gtpuh->version == 1) {
@@ -129,6 +137,7 @@ void spgwu_s1u::handle_receive(
         gtp_payload_length -= 4;
       }
       uint32_t tunnel_id = be32toh(gtpuh->teid);
+      datapath_stats::get_instance().received(DATAPATH_UL, gtp_payload_length);
 
       struct iphdr* iph = (struct iphdr*) &recv_buffer[gtp_payload_offset];
       if (iph->version == 4) {
@@ -138,7 +147,7 @@ void spgwu_s1u::handle_receive(
         pfcp_switch_inst->pfcp_session_look_up_pack_in_access(
             (struct ipv6hdr*) iph, gtp_payload_length, r_endpoint, tunnel_id);
       } else {
-        Logger::spgwu_s1u().trace("Unknown GTPU_G_PDU packet");
+        datapath_stats::get_instance().dropped(DATAPATH_DROP_MALFORMED);
       }
     } else {
       // Logger::spgwu_s1u().info( "handle_receive(%d bytes)",
@@ -163,12 +172,13 @@ void spgwu_s1u::handle_receive(
       pfcp_switch_inst->pfcp_session_look_up_pack_in_access(
           (struct ipv6hdr*) iph, bytes_transferred, r_endpoint);
     } else {
-      Logger::spgwu_s1u().trace("Unknown IPX packet");
+      datapath_stats::get_instance().dropped(DATAPATH_DROP_MALFORMED);
     }
   }
-  // auto stop = std::chrono::high_resolution_clock::now();
-  // auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop
-  // - start); cout << "UL took "  << duration.count() << std::endl;
+}
+//------------------------------------------------------------------------------
+void spgwu_s1u::handle_receive_end() {
+  if (pfcp_switch_inst) pfcp_switch_inst->flush_to_core();
 }
 //------------------------------------------------------------------------------
 void spgwu_s1u::handle_receive_gtpv1u_msg(
@@ -194,7 +204,7 @@ void spgwu_s1u::handle_receive_gtpv1u_msg(
 void spgwu_s1u::send_g_pdu(
     const struct in_addr& peer_addr, const uint16_t peer_udp_port,
     const uint32_t tunnel_id, const char* send_buffer,
-    const ssize_t num_bytes) {
+    const ssize_t num_bytes, util::packet_buf_t* const pbuf) {
   // Logger::spgwu_s1u().info( "spgwu_s1u::send_g_pdu() TEID " TEID_FMT " %d
   // bytes", num_bytes);
   struct sockaddr_in peer_sock_addr;
@@ -202,20 +212,21 @@ void spgwu_s1u::send_g_pdu(
   peer_sock_addr.sin_addr   = peer_addr;
   peer_sock_addr.sin_port   = htobe16(peer_udp_port);
   gtpu_l4_stack::send_g_pdu(
-      peer_sock_addr, (teid_t) tunnel_id, send_buffer, num_bytes);
+      peer_sock_addr, (teid_t) tunnel_id, send_buffer, num_bytes, pbuf);
 }
 //------------------------------------------------------------------------------
 void spgwu_s1u::send_g_pdu(
     const struct in6_addr& peer_addr, const uint16_t peer_udp_port,
     const uint32_t tunnel_id, const char* send_buffer,
-    const ssize_t num_bytes) {
+    const ssize_t num_bytes, util::packet_buf_t* const pbuf) {
   struct sockaddr_in6 peer_sock_addr;
   peer_sock_addr.sin6_family   = AF_INET6;
   peer_sock_addr.sin6_addr     = peer_addr;
   peer_sock_addr.sin6_port     = htobe16(peer_udp_port);
   peer_sock_addr.sin6_flowinfo = 0;
   peer_sock_addr.sin6_scope_id = 0;
-  gtpu_l4_stack::send_g_pdu(peer_sock_addr, tunnel_id, send_buffer, num_bytes);
+  gtpu_l4_stack::send_g_pdu(
+      peer_sock_addr, tunnel_id, send_buffer, num_bytes, pbuf);
 }
 //------------------------------------------------------------------------------
 void spgwu_s1u::handle_receive_echo_request(
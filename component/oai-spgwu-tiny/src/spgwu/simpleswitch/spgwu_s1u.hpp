@@ -72,15 +72,17 @@ class spgwu_s1u : public gtpv1u::gtpu_l4_stack {
   void handle_receive(
       char* recv_buffer, const std::size_t bytes_transferred,
       const endpoint& r_endpoint);
+  // Write the UL packets coalesced for the TUN
+  void handle_receive_end();
 
   void send_g_pdu(
       const struct in_addr& peer_addr, const uint16_t peer_udp_port,
       const uint32_t tunnel_id, const char* send_buffer,
-      const ssize_t num_bytes);
+      const ssize_t num_bytes, util::packet_buf_t* const pbuf = nullptr);
   void send_g_pdu(
       const struct in6_addr& peer_addr, const uint16_t peer_udp_port,
       const uint32_t tunnel_id, const char* send_buffer,
-      const ssize_t num_bytes);
+      const ssize_t num_bytes, util::packet_buf_t* const pbuf = nullptr);
 
   void time_out_itti_event(const uint32_t timer_id);
   void report_error_indication(
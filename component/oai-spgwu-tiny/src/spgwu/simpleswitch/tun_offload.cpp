@@ -0,0 +1,312 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file tun_offload.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "tun_offload.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <linux/ipv6.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+
+using namespace spgwu;
+
+// TCP flags, byte 13 of the header
+#define TUN_OFFLOAD_TCP_FLAGS_OFFSET 13
+#define TUN_OFFLOAD_TCP_FIN 0x01
+#define TUN_OFFLOAD_TCP_PSH 0x08
+#define TUN_OFFLOAD_TCP_ACK 0x10
+#define TUN_OFFLOAD_TCP_CWR 0x80
+
+//------------------------------------------------------------------------------
+// One's complement sum of the 16 bits words of the buffer, read in host byte
+// order: once folded it is in network byte order
+static uint64_t csum_partial(
+    const void* buffer, std::size_t len, uint64_t sum) {
+  const char* p = (const char*) buffer;
+  uint32_t w32  = 0;
+  for (; len >= sizeof(w32); p += sizeof(w32), len -= sizeof(w32)) {
+    memcpy(&w32, p, sizeof(w32));
+    sum += w32;
+  }
+  uint16_t w16 = 0;
+  if (len >= sizeof(w16)) {
+    memcpy(&w16, p, sizeof(w16));
+    sum += w16;
+    p += sizeof(w16);
+    len -= sizeof(w16);
+  }
+  if (len) {
+    w16 = 0;
+    memcpy(&w16, p, 1);
+    sum += w16;
+  }
+  return sum;
+}
+//------------------------------------------------------------------------------
+static uint16_t csum_fold(uint64_t sum) {
+  while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+  return (uint16_t) sum;
+}
+//------------------------------------------------------------------------------
+static uint16_t ipv4_header_csum(const struct iphdr* const iph) {
+  return (uint16_t) ~csum_fold(csum_partial(iph, iph->ihl << 2, 0));
+}
+//------------------------------------------------------------------------------
+// TCP pseudo header of an IPv4 or IPv6 packet
+static uint64_t pseudo_header_sum(
+    const char* const l3_packet, const std::size_t l4_len) {
+  const struct iphdr* iph = (const struct iphdr*) l3_packet;
+  if (iph->version == 4) {
+    return csum_partial(&iph->saddr, 2 * sizeof(iph->saddr), 0) +
+           htons(IPPROTO_TCP) + htons(l4_len);
+  }
+  const struct ipv6hdr* ip6h = (const struct ipv6hdr*) l3_packet;
+  return csum_partial(&ip6h->saddr, 2 * sizeof(ip6h->saddr), 0) +
+         htonl(l4_len) + htonl(IPPROTO_TCP);
+}
+//------------------------------------------------------------------------------
+bool spgwu::tun_offload_complete_csum(
+    char* const packet, const std::size_t len,
+    const tun_vnet_hdr_t& vh) {
+  if (not(vh.flags & TUN_VNET_HDR_F_NEEDS_CSUM)) return true;
+  const std::size_t start  = vh.csum_start;
+  const std::size_t offset = start + vh.csum_offset;
+  if ((start >= len) || (offset + sizeof(uint16_t) > len)) return false;
+  uint16_t csum = ~csum_fold(csum_partial(&packet[start], len - start, 0));
+  // As the kernel does, 0 means no checksum in UDP
+  if (csum == 0) csum = 0xFFFF;
+  memcpy(&packet[offset], &csum, sizeof(csum));
+  return true;
+}
+//------------------------------------------------------------------------------
+bool tun_gso_segmenter::init(
+    char* const packet, const std::size_t len,
+    const tun_vnet_hdr_t& vh) {
+  const struct iphdr* iph = (const struct iphdr*) packet;
+  const int gso_type      = vh.gso_type & ~TUN_VNET_HDR_GSO_ECN;
+  if ((gso_type == TUN_VNET_HDR_GSO_TCPV4) &&
+      (len >= sizeof(struct iphdr)) && (iph->version == 4) &&
+      (iph->ihl >= 5) && (iph->protocol == IPPROTO_TCP)) {
+    l3_len_ = iph->ihl << 2;
+  } else if (
+      (gso_type == TUN_VNET_HDR_GSO_TCPV6) &&
+      (len >= sizeof(struct ipv6hdr)) && (iph->version == 6) &&
+      (((const struct ipv6hdr*) packet)->nexthdr == IPPROTO_TCP)) {
+    l3_len_ = sizeof(struct ipv6hdr);
+  } else {
+    return false;
+  }
+  if (len < l3_len_ + sizeof(struct tcphdr)) return false;
+  const struct tcphdr* th = (const struct tcphdr*) &packet[l3_len_];
+  hdr_len_                = l3_len_ + (th->doff << 2);
+  if ((th->doff < 5) || (len <= hdr_len_) || (vh.gso_size == 0) ||
+      (hdr_len_ > sizeof(template_))) {
+    return false;
+  }
+  memcpy(template_, packet, hdr_len_);
+  packet_ = packet;
+  len_    = len;
+  mss_    = vh.gso_size;
+  offset_ = hdr_len_;
+  seg_    = 0;
+  return true;
+}
+//------------------------------------------------------------------------------
+char* tun_gso_segmenter::next(std::size_t& seg_len) {
+  if (offset_ >= len_) return nullptr;
+  const std::size_t payload = std::min(mss_, len_ - offset_);
+  const bool last           = (offset_ + payload == len_);
+  char* seg                 = &packet_[offset_ - hdr_len_];
+  if (seg_) memcpy(seg, template_, hdr_len_);
+  seg_len = hdr_len_ + payload;
+
+  struct tcphdr* th        = (struct tcphdr*) &seg[l3_len_];
+  const struct tcphdr* tth = (const struct tcphdr*) &template_[l3_len_];
+  th->seq        = htonl(ntohl(tth->seq) + (uint32_t)(offset_ - hdr_len_));
+  uint8_t& flags = ((uint8_t*) th)[TUN_OFFLOAD_TCP_FLAGS_OFFSET];
+  if (not last) flags &= ~(TUN_OFFLOAD_TCP_FIN | TUN_OFFLOAD_TCP_PSH);
+  if (seg_) flags &= ~TUN_OFFLOAD_TCP_CWR;
+
+  struct iphdr* iph = (struct iphdr*) seg;
+  if (iph->version == 4) {
+    const struct iphdr* tiph = (const struct iphdr*) template_;
+    iph->tot_len             = htons(seg_len);
+    iph->id                  = htons(ntohs(tiph->id) + seg_);
+    iph->check               = 0;
+    iph->check               = ipv4_header_csum(iph);
+  } else {
+    ((struct ipv6hdr*) seg)->payload_len = htons(seg_len - l3_len_);
+  }
+  const std::size_t l4_len = seg_len - l3_len_;
+  th->check                = 0;
+  th->check                = ~csum_fold(
+      csum_partial(th, l4_len, pseudo_header_sum(seg, l4_len)));
+
+  offset_ += payload;
+  seg_++;
+  return seg;
+}
+//------------------------------------------------------------------------------
+tun_gro::tun_gro()
+    : buf_((char*) malloc(TUN_GRO_HEADROOM + TUN_OFFLOAD_MAX_PACKET_SIZE)),
+      sp_(&buf_[TUN_GRO_HEADROOM]),
+      len_(0),
+      l3_len_(0),
+      hdr_len_(0),
+      mss_(0),
+      next_seq_(0),
+      segs_(0),
+      closed_(false) {}
+//------------------------------------------------------------------------------
+tun_gro::~tun_gro() { free(buf_); }
+//------------------------------------------------------------------------------
+bool tun_gro::merge(const char* const packet, const std::size_t len) {
+  const struct iphdr* iph = (const struct iphdr*) packet;
+  std::size_t l3_len      = 0;
+  if ((len >= sizeof(struct iphdr)) && (iph->version == 4)) {
+    // No IP option, no fragment
+    if ((iph->ihl != 5) || (iph->protocol != IPPROTO_TCP) ||
+        (iph->frag_off & htons(IP_MF | IP_OFFMASK)) ||
+        (ntohs(iph->tot_len) != len) || (ipv4_header_csum(iph))) {
+      return false;
+    }
+    l3_len = sizeof(struct iphdr);
+  } else if ((len >= sizeof(struct ipv6hdr)) && (iph->version == 6)) {
+    const struct ipv6hdr* ip6h = (const struct ipv6hdr*) packet;
+    if ((ip6h->nexthdr != IPPROTO_TCP) ||
+        (ntohs(ip6h->payload_len) + sizeof(struct ipv6hdr) != len)) {
+      return false;
+    }
+    l3_len = sizeof(struct ipv6hdr);
+  } else {
+    return false;
+  }
+  if (len < l3_len + sizeof(struct tcphdr)) return false;
+  const struct tcphdr* th   = (const struct tcphdr*) &packet[l3_len];
+  const std::size_t hdr_len = l3_len + (th->doff << 2);
+  const uint8_t flags = ((const uint8_t*) th)[TUN_OFFLOAD_TCP_FLAGS_OFFSET];
+  // Data with ACK and maybe PSH only, pure ACKs are not merged
+  if ((th->doff < 5) || (len <= hdr_len) ||
+      ((flags & ~TUN_OFFLOAD_TCP_PSH) != TUN_OFFLOAD_TCP_ACK)) {
+    return false;
+  }
+  const std::size_t payload = len - hdr_len;
+  char* const sp            = sp_;
+
+  if (segs_) {
+    const struct tcphdr* sth = (const struct tcphdr*) &sp[l3_len_];
+    if ((closed_) || (hdr_len != hdr_len_) || (l3_len != l3_len_) ||
+        (payload > mss_) || (segs_ >= TUN_OFFLOAD_MAX_SEGMENTS) ||
+        (len_ + payload > TUN_OFFLOAD_MAX_PACKET_SIZE) ||
+        (ntohl(th->seq) != next_seq_) || (th->ack_seq != sth->ack_seq) ||
+        (memcmp(th, sth, 2 * sizeof(th->source))) ||
+        (memcmp(
+            &packet[l3_len + sizeof(struct tcphdr)],
+            &sp[l3_len + sizeof(struct tcphdr)],
+            hdr_len - l3_len - sizeof(struct tcphdr)))) {
+      return false;
+    }
+    if (l3_len == sizeof(struct iphdr)) {
+      const struct iphdr* siph = (const struct iphdr*) sp;
+      if ((iph->tos != siph->tos) || (iph->ttl != siph->ttl) ||
+          ((iph->frag_off ^ siph->frag_off) & htons(IP_DF)) ||
+          (iph->saddr != siph->saddr) || (iph->daddr != siph->daddr)) {
+        return false;
+      }
+    } else {
+      const struct ipv6hdr* ip6h  = (const struct ipv6hdr*) packet;
+      const struct ipv6hdr* sip6h = (const struct ipv6hdr*) sp;
+      // Version, traffic class, flow label
+      if ((memcmp(ip6h, sip6h, sizeof(uint32_t))) ||
+          (ip6h->hop_limit != sip6h->hop_limit) ||
+          (memcmp(&ip6h->saddr, &sip6h->saddr, 2 * sizeof(ip6h->saddr)))) {
+        return false;
+      }
+    }
+  }
+  // The kernel fills the checksum of the superpacket, a corrupted segment
+  // must not get a valid one
+  if (csum_fold(csum_partial(
+          th, len - l3_len, pseudo_header_sum(packet, len - l3_len))) !=
+      0xFFFF) {
+    return false;
+  }
+
+  if (segs_ == 0) {
+    memcpy(sp, packet, len);
+    len_     = len;
+    l3_len_  = l3_len;
+    hdr_len_ = hdr_len;
+    mss_     = payload;
+    closed_  = false;
+  } else {
+    memcpy(&sp[len_], &packet[hdr_len], payload);
+    len_ += payload;
+    if (flags & TUN_OFFLOAD_TCP_PSH) {
+      sp[l3_len_ + TUN_OFFLOAD_TCP_FLAGS_OFFSET] |= TUN_OFFLOAD_TCP_PSH;
+    }
+  }
+  next_seq_ = ntohl(th->seq) + payload;
+  segs_++;
+  if ((flags & TUN_OFFLOAD_TCP_PSH) || (payload < mss_)) closed_ = true;
+  return true;
+}
+//------------------------------------------------------------------------------
+const char* tun_gro::finish(std::size_t& len) {
+  char* const sp     = sp_;
+  tun_vnet_hdr_t* vh = (tun_vnet_hdr_t*) &sp[-TUN_OFFLOAD_VNET_HDR_SIZE];
+  memset(vh, 0, sizeof(*vh));
+  if (segs_ > 1) {
+    const std::size_t l4_len = len_ - l3_len_;
+    vh->flags                = TUN_VNET_HDR_F_NEEDS_CSUM;
+    vh->hdr_len              = hdr_len_;
+    vh->gso_size             = mss_;
+    vh->csum_start           = l3_len_;
+    vh->csum_offset          = offsetof(struct tcphdr, check);
+    struct iphdr* iph        = (struct iphdr*) sp;
+    if (iph->version == 4) {
+      vh->gso_type = TUN_VNET_HDR_GSO_TCPV4;
+      iph->tot_len = htons(len_);
+      iph->check   = 0;
+      iph->check   = ipv4_header_csum(iph);
+    } else {
+      vh->gso_type = TUN_VNET_HDR_GSO_TCPV6;
+      ((struct ipv6hdr*) sp)->payload_len = htons(l4_len);
+    }
+    // Partial checksum: pseudo header only, not complemented
+    ((struct tcphdr*) &sp[l3_len_])->check =
+        csum_fold(pseudo_header_sum(sp, l4_len));
+  }
+  len   = TUN_OFFLOAD_VNET_HDR_SIZE + len_;
+  segs_ = 0;
+  len_  = 0;
+  return (const char*) vh;
+}
@@ -0,0 +1,148 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file tun_offload.hpp
+  \brief TCP segmentation and coalescing of the packets exchanged with a TUN
+         opened with IFF_VNET_HDR
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_TUN_OFFLOAD_HPP_SEEN
+#define FILE_TUN_OFFLOAD_HPP_SEEN
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spgwu {
+
+// Every packet read from or written to the TUN is preceded by a virtio net
+// header (host byte order). With TUNSETOFFLOAD the kernel hands over TCP
+// superpackets of up to 64 KB (GSO) and packets whose checksum is left to
+// complete, and it takes the same from us.
+// struct virtio_net_hdr, linux/virtio_net.h does not compile in C++
+typedef struct tun_vnet_hdr_s {
+  uint8_t flags;
+  uint8_t gso_type;
+  uint16_t hdr_len;
+  uint16_t gso_size;
+  uint16_t csum_start;
+  uint16_t csum_offset;
+} tun_vnet_hdr_t;
+
+#define TUN_VNET_HDR_F_NEEDS_CSUM 1
+#define TUN_VNET_HDR_GSO_NONE 0
+#define TUN_VNET_HDR_GSO_TCPV4 1
+#define TUN_VNET_HDR_GSO_TCPV6 4
+#define TUN_VNET_HDR_GSO_ECN 0x80
+
+#define TUN_OFFLOAD_VNET_HDR_SIZE sizeof(tun_vnet_hdr_t)
+#define TUN_OFFLOAD_MAX_PACKET_SIZE 65535
+// Segments coalesced in one UL superpacket at most, as Linux GRO
+#define TUN_OFFLOAD_MAX_SEGMENTS 64
+
+// Fill the checksum the kernel left to us (TUN_VNET_HDR_F_NEEDS_CSUM), the
+// pseudo header sum is already in place. Return false if out of the packet.
+bool tun_offload_complete_csum(
+    char* const packet, const std::size_t len, const tun_vnet_hdr_t& vh);
+
+// DL: cuts a TCP superpacket read from the TUN in segments of gso_size bytes
+// of payload, in place, front to back. The IP and TCP headers of the
+// superpacket are saved, and written again in front of the payload of each
+// segment, over the tail of the previous one: a segment must be consumed
+// (copied or sent) before next() is called.
+class tun_gso_segmenter {
+ private:
+#define TUN_GSO_MAX_HEADER_SIZE 120
+  char* packet_;
+  std::size_t len_;
+  // IP header, IP and TCP headers
+  std::size_t l3_len_;
+  std::size_t hdr_len_;
+  std::size_t mss_;
+  // Payload of the next segment
+  std::size_t offset_;
+  unsigned int seg_;
+  char template_[TUN_GSO_MAX_HEADER_SIZE];
+
+ public:
+  tun_gso_segmenter()
+      : packet_(nullptr),
+        len_(0),
+        l3_len_(0),
+        hdr_len_(0),
+        mss_(0),
+        offset_(0),
+        seg_(0) {}
+  tun_gso_segmenter(const tun_gso_segmenter&) = delete;
+  void operator=(const tun_gso_segmenter&) = delete;
+
+  // Return false if not a TCP over IPv4 or IPv6 (no extension header)
+  // superpacket
+  bool init(
+      char* const packet, const std::size_t len,
+      const tun_vnet_hdr_t& vh);
+  // Next segment with its headers and checksums, nullptr after the last one
+  char* next(std::size_t& seg_len);
+};
+
+// UL: coalesces the consecutive segments of a TCP flow in one superpacket,
+// written to the TUN with a GSO virtio header, the kernel segments it again
+// if needed on its way out of SGi. As with Linux GRO, a segment is merged if
+// it has the addresses, ports, ack number, IP and TCP options of the first
+// one, only carries ACK (and PSH that closes the superpacket) and follows the
+// previous one. All the segments but the last one have the size of the first
+// one. The packets are copied, the caller keeps its buffers.
+class tun_gro {
+ private:
+#define TUN_GRO_HEADROOM 16
+  char* buf_;
+  // Superpacket, aligned in buf_, preceded by its virtio header
+  char* sp_;
+  std::size_t len_;
+  std::size_t l3_len_;
+  std::size_t hdr_len_;
+  std::size_t mss_;
+  uint32_t next_seq_;
+  unsigned int segs_;
+  // PSH or short segment merged, nothing can follow
+  bool closed_;
+
+ public:
+  tun_gro();
+  tun_gro(const tun_gro&) = delete;
+  void operator=(const tun_gro&) = delete;
+  ~tun_gro();
+
+  bool empty() const { return segs_ == 0; }
+  unsigned int segments() const { return segs_; }
+
+  // Merge the packet, or start a superpacket with it if empty. Return false
+  // if it cannot be merged: the caller writes the pending superpacket first
+  // and tries again, then writes the packet alone.
+  bool merge(const char* const packet, const std::size_t len);
+  // Virtio header and superpacket to write, then empty
+  const char* finish(std::size_t& len);
+};
+
+}  // namespace spgwu
+#endif /* FILE_TUN_OFFLOAD_HPP_SEEN */
@@ -28,12 +28,14 @@
 #include "conversions.hpp"
 #include "itti.hpp"
 #include "logger.hpp"
+#include "packet_pool.hpp"
 #include "pfcp_switch.hpp"
 #include "spgwu_app.hpp"
 #include "spgwu_config.hpp"
 #include "spgwu_s1u.hpp"
 #include "spgwu_sx.hpp"
 
+#include <inttypes.h>
 #include <stdexcept>
 
 using namespace pfcp;
@@ -105,6 +107,15 @@ void spgwu_app_task(void* args_p) {
             case TASK_SPGWU_PFCP_SWITCH_MAX_COMMIT_INTERVAL:
               // pfcp_switch_inst->time_out_max_commit_interval(to->timer_id);
               break;
+            case TASK_SPGWU_PFCP_SWITCH_USAGE_REPORTING:
+              pfcp_switch_inst->time_out_usage_reporting(to->timer_id);
+              break;
+            case TASK_SPGWU_PFCP_SWITCH_SESSION_SNAPSHOT:
+              pfcp_switch_inst->time_out_session_snapshot(to->timer_id);
+              break;
+            case TASK_SPGWU_PFCP_SWITCH_STATS:
+              pfcp_switch_inst->time_out_stats(to->timer_id);
+              break;
             default:;
           }
         }
@@ -145,6 +156,22 @@ spgwu_app::spgwu_app(const std::string& config_file) {
     Logger::spgwu_app().error("Cannot create SPGWU_SX: %s", e.what());
     throw;
   }
+  // Before the S1-U and SGi packet workers start
+  util::packet_pool& pool = util::packet_pool::get_instance();
+  if (pool.init(
+          spgwu_cfg.packet_pool_buffers, spgwu_cfg.packet_headroom,
+          spgwu_cfg.packet_tailroom, spgwu_cfg.packet_pool_hugepages)) {
+    std::vector<util::packet_pool_counters_t> nodes = {};
+    pool.get_counters(nodes);
+    for (auto& n : nodes) {
+      Logger::spgwu_app().info(
+          "Packet pool: %" PRIu64 " buffers on NUMA node %d, %s pages",
+          n.buffers, n.node, (n.hugepages) ? "huge" : "normal");
+    }
+  } else {
+    Logger::spgwu_app().error(
+        "Could not map the packet pool, the G-PDUs sent on S1-U are copied");
+  }
   try {
     spgwu_s1u_inst = new spgwu_s1u();
   } catch (std::exception& e) {
@@ -157,6 +184,8 @@ spgwu_app::spgwu_app(const std::string& config_file) {
     Logger::spgwu_app().error("Cannot create PFCP_SWITCH: %s", e.what());
     throw;
   }
+  // The switch restored its sessions and the recovery time stamp
+  spgwu_sx_inst->start_associations();
   Logger::spgwu_app().startup("Started");
 }
 
@@ -33,6 +33,7 @@
 #include "get_gateway_netlink.hpp"
 #include "if.hpp"
 #include "logger.hpp"
+#include "qsbr.hpp"
 #include "spgwu_config.hpp"
 #include "string.hpp"
 
@@ -40,6 +41,7 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
@@ -146,13 +148,40 @@ int spgwu_config::load_thread_sched_params(
   }
 
   try {
-    thread_sched_params_cfg.lookupValue(
-        SPGWU_CONFIG_STRING_THREAD_POOL_SIZE, cfg.thread_pool_size);
+    if (not thread_sched_params_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_THREAD_POOL_SIZE, cfg.thread_pool_size)) {
+      // Name used in the configuration files we ship
+      thread_sched_params_cfg.lookupValue(
+          SPGWU_CONFIG_STRING_POOL_SIZE, cfg.thread_pool_size);
+    }
     Logger::spgwu_app().info("THREAD_POOL_SIZE : %d", cfg.thread_pool_size);
   } catch (const SettingNotFoundException& nfex) {
     Logger::spgwu_app().info(
         "%s : %s, using defaults", nfex.what(), nfex.getPath());
   }
+
+  try {
+    thread_sched_params_cfg.lookupValue(
+        SPGWU_CONFIG_STRING_IO_BATCH_SIZE, cfg.io_batch_size);
+    if ((cfg.io_batch_size < 1) ||
+        (cfg.io_batch_size > UDP_MAX_IO_BATCH_SIZE)) {
+      Logger::spgwu_app().error(
+          "io_batch_size: %u, must be in interval [1..%d] in config file",
+          cfg.io_batch_size, UDP_MAX_IO_BATCH_SIZE);
+      return RETURNerror;
+    }
+  } catch (const SettingNotFoundException& nfex) {
+    Logger::spgwu_app().info(
+        "%s : %s, using defaults", nfex.what(), nfex.getPath());
+  }
+
+  try {
+    thread_sched_params_cfg.lookupValue(
+        SPGWU_CONFIG_STRING_IO_FLUSH_DEADLINE_US, cfg.io_flush_deadline_us);
+  } catch (const SettingNotFoundException& nfex) {
+    Logger::spgwu_app().info(
+        "%s : %s, using defaults", nfex.what(), nfex.getPath());
+  }
   return RETURNok;
 }
 //------------------------------------------------------------------------------
@@ -248,7 +277,39 @@ int spgwu_config::load_interface(const Setting& if_cfg, interface_cfg_t& cfg) {
           ntohs(cfg.addr4.s_addr) &
           0xFFFFFFFF << (32 - std::stoi(util::trim(words.at(1)))));
     }
+    address = {};
+    if (if_cfg.lookupValue(SPGWU_CONFIG_STRING_IPV6_ADDRESS, address)) {
+      util::trim(address);
+      if ((not address.empty()) &&
+          (inet_pton(AF_INET6, address.c_str(), &cfg.addr6) != 1)) {
+        Logger::spgwu_app().error(
+            "Bad value " SPGWU_CONFIG_STRING_IPV6_ADDRESS
+            " = %s in config file",
+            address.c_str());
+        return RETURNerror;
+      }
+    }
     if_cfg.lookupValue(SPGWU_CONFIG_STRING_PORT, cfg.port);
+    std::string io_backend = {};
+    if (if_cfg.lookupValue(SPGWU_CONFIG_STRING_IO_BACKEND, io_backend)) {
+      util::trim(io_backend);
+      if (boost::iequals(io_backend, "SOCKET")) {
+        cfg.io_backend = PACKET_IO_BACKEND_SOCKET;
+      } else if (boost::iequals(io_backend, "TPACKET_V3")) {
+        cfg.io_backend = PACKET_IO_BACKEND_TPACKET_V3;
+      } else if (boost::iequals(io_backend, "AF_XDP")) {
+        Logger::spgwu_app().warn(
+            "IO_BACKEND AF_XDP not available in this build, using TPACKET_V3 "
+            "on %s",
+            cfg.if_name.c_str());
+        cfg.io_backend = PACKET_IO_BACKEND_TPACKET_V3;
+      } else {
+        Logger::spgwu_app().error(
+            "Bad value " SPGWU_CONFIG_STRING_IO_BACKEND " = %s in config file",
+            io_backend.c_str());
+        return RETURNerror;
+      }
+    }
     try {
       const Setting& sched_params_cfg =
           if_cfg[SPGWU_CONFIG_STRING_SCHED_PARAMS];
@@ -329,6 +390,21 @@ int spgwu_config::load(const string& config_file) {
     const Setting& sgi_cfg = nw_if_cfg[SPGWU_CONFIG_STRING_INTERFACE_SGI];
     load_interface(sgi_cfg, sgi);
 
+    // Each S1-U shard or ring (IPv4 and IPv6 sockets) and each SGi TUN queue
+    // or ring is a QSBR reader
+    unsigned int num_readers =
+        std::max(1u, s1_up.thread_rd_sched_params.thread_pool_size);
+    if ((s1_up.addr4.s_addr) && (not IN6_IS_ADDR_UNSPECIFIED(&s1_up.addr6))) {
+      num_readers *= 2;
+    }
+    num_readers += std::max(1u, sgi.thread_rd_sched_params.thread_pool_size);
+    if (num_readers > QSBR_MAX_READERS) {
+      Logger::spgwu_app().error(
+          "%u S1-U and SGi packet workers, more than %d", num_readers,
+          QSBR_MAX_READERS);
+      throw("CONFIG: too many packet workers in " SPGWU_CONFIG_STRING_POOL_SIZE);
+    }
+
     if ((boost::iequals(sgi.if_name, "none")) ||
         (boost::iequals(sgi.if_name, "default_gateway"))) {
       if (util::get_gateway_and_iface(gateway, sgi.if_name)) {
@@ -453,6 +529,92 @@ int spgwu_config::load(const string& config_file) {
         snat = true;
       }
     }
+
+    tun_offload = false;
+    if (spgwu_cfg.lookupValue(SPGWU_CONFIG_STRING_TUN_OFFLOAD, astring)) {
+      tun_offload = boost::iequals(astring, "yes");
+    }
+
+    gtp_kernel_offload = false;
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_GTP_KERNEL_OFFLOAD, astring)) {
+      gtp_kernel_offload = boost::iequals(astring, "yes");
+    }
+
+    unsigned int max_sessions = 0;
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_MAX_PFCP_SESSIONS, max_sessions)) {
+      if (max_sessions == 0) {
+        Logger::spgwu_app().error(
+            "%s must be > 0", SPGWU_CONFIG_STRING_MAX_PFCP_SESSIONS);
+        return RETURNerror;
+      }
+      max_pfcp_sessions = max_sessions;
+    }
+    unsigned int node_id = 0;
+    if (spgwu_cfg.lookupValue(SPGWU_CONFIG_STRING_TEID_NODE_ID, node_id)) {
+      if (node_id > 255) {
+        Logger::spgwu_app().error(
+            "%s must be in [0..255]", SPGWU_CONFIG_STRING_TEID_NODE_ID);
+        return RETURNerror;
+      }
+      teid_node_id = node_id;
+    }
+    spgwu_cfg.lookupValue(
+        SPGWU_CONFIG_STRING_DL_BUFFER_MAX_SIZE_MB, dl_buffer_max_size_mb);
+    spgwu_cfg.lookupValue(
+        SPGWU_CONFIG_STRING_DL_BUFFER_DEFAULT_PACKETS,
+        dl_buffer_default_packets);
+    spgwu_cfg.lookupValue(
+        SPGWU_CONFIG_STRING_SESSION_SNAPSHOT_FILE, session_snapshot_file);
+    unsigned int snapshot_interval = 0;
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_SESSION_SNAPSHOT_INTERVAL, snapshot_interval)) {
+      if (snapshot_interval == 0) {
+        Logger::spgwu_app().error(
+            "%s must be > 0", SPGWU_CONFIG_STRING_SESSION_SNAPSHOT_INTERVAL);
+        return RETURNerror;
+      }
+      session_snapshot_interval_sec = snapshot_interval;
+    }
+    spgwu_cfg.lookupValue(SPGWU_CONFIG_STRING_STATS_FILE, stats_file);
+    unsigned int stats_interval = 0;
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_STATS_INTERVAL, stats_interval)) {
+      if (stats_interval == 0) {
+        Logger::spgwu_app().error(
+            "%s must be > 0", SPGWU_CONFIG_STRING_STATS_INTERVAL);
+        return RETURNerror;
+      }
+      stats_interval_sec = stats_interval;
+    }
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_PACKET_POOL_BUFFERS, packet_pool_buffers)) {
+      if (packet_pool_buffers == 0) {
+        Logger::spgwu_app().error(
+            "%s must be > 0", SPGWU_CONFIG_STRING_PACKET_POOL_BUFFERS);
+        return RETURNerror;
+      }
+    }
+    astring = {};
+    if (spgwu_cfg.lookupValue(
+            SPGWU_CONFIG_STRING_PACKET_POOL_HUGEPAGES, astring)) {
+      packet_pool_hugepages = boost::iequals(astring, "yes");
+    }
+    spgwu_cfg.lookupValue(SPGWU_CONFIG_STRING_PACKET_HEADROOM, packet_headroom);
+    if ((packet_headroom < PACKET_POOL_MIN_HEADROOM) ||
+        (packet_headroom > 1024)) {
+      Logger::spgwu_app().error(
+          "%s must be in [%d..1024]", SPGWU_CONFIG_STRING_PACKET_HEADROOM,
+          PACKET_POOL_MIN_HEADROOM);
+      return RETURNerror;
+    }
+    spgwu_cfg.lookupValue(SPGWU_CONFIG_STRING_PACKET_TAILROOM, packet_tailroom);
+    if (packet_tailroom > 1024) {
+      Logger::spgwu_app().error(
+          "%s must be in [0..1024]", SPGWU_CONFIG_STRING_PACKET_TAILROOM);
+      return RETURNerror;
+    }
     const Setting& spgwc_list_cfg = spgwu_cfg[SPGWU_CONFIG_STRING_SPGWC_LIST];
     count                         = spgwc_list_cfg.getLength();
     for (int i = 0; i < count; i++) {
@@ -537,7 +699,12 @@ void spgwu_config::display() {
       "    ipv4.addr ........: %s", inet_ntoa(s1_up.addr4));
   Logger::spgwu_app().info(
       "    ipv4.mask ........: %s", inet_ntoa(s1_up.network4));
+  Logger::spgwu_app().info(
+      "    ipv6.addr ........: %s", conv::toString(s1_up.addr6).c_str());
   Logger::spgwu_app().info("    mtu ..............: %d", s1_up.mtu);
+  Logger::spgwu_app().info(
+      "    I/O backend ......: %s",
+      packet_io_backend_to_string(s1_up.io_backend));
   Logger::spgwu_app().info("    port .............: %d", s1_up.port);
   Logger::spgwu_app().info("    Reader thread:");
   Logger::spgwu_app().info(
@@ -550,6 +717,11 @@ void spgwu_config::display() {
   Logger::spgwu_app().info(
       "      thread pool size: %d",
       s1_up.thread_rd_sched_params.thread_pool_size);
+  Logger::spgwu_app().info(
+      "      I/O batch size..: %u", s1_up.thread_rd_sched_params.io_batch_size);
+  Logger::spgwu_app().info(
+      "      I/O flush (us)..: %u",
+      s1_up.thread_rd_sched_params.io_flush_deadline_us);
   Logger::spgwu_app().info("- SXA-SXB:");
   Logger::spgwu_app().info("    iface ............: %s", sx.if_name.c_str());
   Logger::spgwu_app().info("    ipv4.addr ........: %s", inet_ntoa(sx.addr4));
@@ -575,6 +747,9 @@ void spgwu_config::display() {
   Logger::spgwu_app().info(
       "    ipv4.mask ........: %s", inet_ntoa(sgi.network4));
   Logger::spgwu_app().info("    mtu ..............: %d", sgi.mtu);
+  Logger::spgwu_app().info(
+      "    I/O backend ......: %s",
+      packet_io_backend_to_string(sgi.io_backend));
   Logger::spgwu_app().info("    gateway ..........: %s", gateway.c_str());
   Logger::spgwu_app().info("    Reader thread:");
   Logger::spgwu_app().info(
@@ -586,8 +761,31 @@ void spgwu_config::display() {
   Logger::spgwu_app().info(
       "      thread pool size: %d",
       sgi.thread_rd_sched_params.thread_pool_size);
+  Logger::spgwu_app().info("- Max PFCP sessions: %u", max_pfcp_sessions);
+  Logger::spgwu_app().info("- TEID node id: %u", teid_node_id);
+  Logger::spgwu_app().info(
+      "- DL buffering: %u MB, %u packets per PDR by default",
+      dl_buffer_max_size_mb, dl_buffer_default_packets);
+  if (session_snapshot_file.size()) {
+    Logger::spgwu_app().info(
+        "- Session snapshot: %s every %u s", session_snapshot_file.c_str(),
+        session_snapshot_interval_sec);
+  }
+  if (stats_file.size()) {
+    Logger::spgwu_app().info(
+        "- Statistics: %s every %u s", stats_file.c_str(), stats_interval_sec);
+  }
+  Logger::spgwu_app().info(
+      "- Packet pool: %u buffers per NUMA node, hugepages %s, headroom %u, "
+      "tailroom %u",
+      packet_pool_buffers, (packet_pool_hugepages) ? "yes" : "no",
+      packet_headroom, packet_tailroom);
   Logger::spgwu_app().info("- PDN networks:");
   Logger::spgwu_app().info("    SNAT .............: %s", (snat) ? "yes" : "no");
+  Logger::spgwu_app().info(
+      "    TUN offload ......: %s", (tun_offload) ? "yes" : "no");
+  Logger::spgwu_app().info(
+      "    GTP kernel offload: %s", (gtp_kernel_offload) ? "yes" : "no");
   int i = 1;
   for (auto it : pdns) {
     if (it.prefix_ipv4) {
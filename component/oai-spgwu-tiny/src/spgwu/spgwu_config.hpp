@@ -31,6 +31,7 @@
 
 #include "3gpp_29.244.h"
 #include "gtpv1u.hpp"
+#include "packet_pool.hpp"
 #include "pfcp.hpp"
 #include "thread_sched.hpp"
 #include <libconfig.h++>
@@ -48,12 +49,17 @@ namespace spgwu {
 #define SPGWU_CONFIG_STRING_INTERFACES "INTERFACES"
 #define SPGWU_CONFIG_STRING_INTERFACE_NAME "INTERFACE_NAME"
 #define SPGWU_CONFIG_STRING_IPV4_ADDRESS "IPV4_ADDRESS"
+#define SPGWU_CONFIG_STRING_IPV6_ADDRESS "IPV6_ADDRESS"
 #define SPGWU_CONFIG_STRING_PORT "PORT"
+#define SPGWU_CONFIG_STRING_IO_BACKEND "IO_BACKEND"
 #define SPGWU_CONFIG_STRING_SCHED_PARAMS "SCHED_PARAMS"
 #define SPGWU_CONFIG_STRING_THREAD_RD_CPU_ID "CPU_ID"
 #define SPGWU_CONFIG_STRING_THREAD_RD_SCHED_POLICY "SCHED_POLICY"
 #define SPGWU_CONFIG_STRING_THREAD_RD_SCHED_PRIORITY "SCHED_PRIORITY"
 #define SPGWU_CONFIG_STRING_THREAD_POOL_SIZE "THREAD_POOL_SIZE"
+#define SPGWU_CONFIG_STRING_POOL_SIZE "POOL_SIZE"
+#define SPGWU_CONFIG_STRING_IO_BATCH_SIZE "IO_BATCH_SIZE"
+#define SPGWU_CONFIG_STRING_IO_FLUSH_DEADLINE_US "IO_FLUSH_DEADLINE_US"
 #define SPGWU_CONFIG_STRING_INTERFACE_SGI "SGI"
 #define SPGWU_CONFIG_STRING_INTERFACE_SX "SX"
 #define SPGWU_CONFIG_STRING_INTERFACE_S1U_S12_S4_UP "S1U_S12_S4_UP"
@@ -62,7 +68,21 @@ namespace spgwu {
 #define SPGWU_CONFIG_STRING_NETWORK_IPV6 "NETWORK_IPV6"
 #define SPGWU_CONFIG_STRING_ADDRESS_PREFIX_DELIMITER "/"
 #define SPGWU_CONFIG_STRING_SNAT "SNAT"
+#define SPGWU_CONFIG_STRING_TUN_OFFLOAD "TUN_OFFLOAD"
+#define SPGWU_CONFIG_STRING_GTP_KERNEL_OFFLOAD "GTP_KERNEL_OFFLOAD"
 #define SPGWU_CONFIG_STRING_MAX_PFCP_SESSIONS "MAX_PFCP_SESSIONS"
+#define SPGWU_CONFIG_STRING_TEID_NODE_ID "TEID_NODE_ID"
+#define SPGWU_CONFIG_STRING_DL_BUFFER_MAX_SIZE_MB "DL_BUFFER_MAX_SIZE_MB"
+#define SPGWU_CONFIG_STRING_DL_BUFFER_DEFAULT_PACKETS "DL_BUFFER_DEFAULT_PACKETS"
+#define SPGWU_CONFIG_STRING_SESSION_SNAPSHOT_FILE "SESSION_SNAPSHOT_FILE"
+#define SPGWU_CONFIG_STRING_SESSION_SNAPSHOT_INTERVAL                          \
+  "SESSION_SNAPSHOT_INTERVAL"
+#define SPGWU_CONFIG_STRING_STATS_FILE "STATS_FILE"
+#define SPGWU_CONFIG_STRING_STATS_INTERVAL "STATS_INTERVAL"
+#define SPGWU_CONFIG_STRING_PACKET_POOL_BUFFERS "PACKET_POOL_BUFFERS"
+#define SPGWU_CONFIG_STRING_PACKET_POOL_HUGEPAGES "PACKET_POOL_HUGEPAGES"
+#define SPGWU_CONFIG_STRING_PACKET_HEADROOM "PACKET_HEADROOM"
+#define SPGWU_CONFIG_STRING_PACKET_TAILROOM "PACKET_TAILROOM"
 #define SPGWU_CONFIG_STRING_SPGWC_LIST "SPGW-C_LIST"
 #define SPGWU_CONFIG_STRING_ITTI_TASKS "ITTI_TASKS"
 #define SPGWU_CONFIG_STRING_ITTI_TIMER_SCHED_PARAMS "ITTI_TIMER_SCHED_PARAMS"
@@ -83,6 +103,7 @@ typedef struct interface_cfg_s {
   struct in6_addr addr6;
   unsigned int mtu;
   unsigned int port;
+  packet_io_backend_t io_backend;
   util::thread_sched_params thread_rd_sched_params;
 } interface_cfg_t;
 
@@ -130,8 +151,31 @@ class spgwu_config {
   std::string gateway;
 
   uint32_t max_pfcp_sessions;
+  // Upper bits of the S1-U TEIDs, distinct for each SPGW-U of a SPGW-C
+  uint32_t teid_node_id;
+  // DL packets of idle UEs: memory shared by all the buffers, and packets
+  // buffered per PDR when the BAR does not suggest a number
+  uint32_t dl_buffer_max_size_mb;
+  uint32_t dl_buffer_default_packets;
+  // PFCP sessions saved to this file and restored at startup, none if empty
+  std::string session_snapshot_file;
+  uint32_t session_snapshot_interval_sec;
+  // Packet path statistics written to this file, none if empty
+  std::string stats_file;
+  uint32_t stats_interval_sec;
+  // Buffers of the S1-U and SGi packets (util::packet_pool), per NUMA node
+  uint32_t packet_pool_buffers;
+  bool packet_pool_hugepages;
+  uint32_t packet_headroom;
+  uint32_t packet_tailroom;
 
   bool snat;
+  // TUN opened with IFF_VNET_HDR: TCP superpackets read from and written to
+  // the kernel, segmented and coalesced by the packet workers
+  bool tun_offload;
+  // Default bearers without QoS enforcement, usage reporting nor buffering
+  // switched by the Linux gtp module, see spgwu::gtp_mod_kernel
+  bool gtp_kernel_offload;
   std::vector<pdn_cfg_t> pdns;
   std::vector<pfcp::node_id_t> spgwcs;
 
@@ -147,8 +191,21 @@ class spgwu_config {
         pdns(),
         spgwcs(),
         max_pfcp_sessions(100),
+        teid_node_id(0),
+        dl_buffer_max_size_mb(16),
+        dl_buffer_default_packets(64),
+        session_snapshot_file(),
+        session_snapshot_interval_sec(60),
+        stats_file(),
+        stats_interval_sec(10),
+        packet_pool_buffers(PACKET_POOL_DEFAULT_BUFFERS),
+        packet_pool_hugepages(true),
+        packet_headroom(PACKET_POOL_DEFAULT_HEADROOM),
+        packet_tailroom(PACKET_POOL_DEFAULT_TAILROOM),
         nsf(),
-        snat(false) {
+        snat(false),
+        tun_offload(false),
+        gtp_kernel_offload(false) {
     itti.itti_timer_sched_params.sched_priority = 85;
     itti.s1u_sched_params.sched_priority        = 84;
     itti.sx_sched_params.sched_priority         = 84;
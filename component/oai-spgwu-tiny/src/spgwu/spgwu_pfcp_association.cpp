@@ -28,13 +28,17 @@
 #include "common_defs.h"
 #include "logger.hpp"
 #include "pfcp_switch.hpp"
+#include "spgwu_config.hpp"
 #include "spgwu_pfcp_association.hpp"
 #include "spgwu_sx.hpp"
 
+#include <algorithm>
+
 using namespace spgwu;
 using namespace std;
 
 extern itti_mw* itti_inst;
+extern spgwu_config spgwu_cfg;
 extern pfcp_switch* pfcp_switch_inst;
 extern spgwu_sx* spgwu_sx_inst;
 
@@ -73,6 +77,7 @@ bool pfcp_associations::add_association(
     pfcp::recovery_time_stamp_t& recovery_time_stamp) {
   std::shared_ptr<pfcp_association> sa = {};
   if (remove_peer_candidate_node(node_id, sa)) {
+    reconcile_restored_sessions(sa, recovery_time_stamp);
     sa->recovery_time_stamp  = recovery_time_stamp;
     sa->function_features    = {};
     std::size_t hash_node_id = std::hash<pfcp::node_id_t>{}(node_id);
@@ -88,6 +93,7 @@ bool pfcp_associations::add_association(
     pfcp::cp_function_features_s& function_features) {
   std::shared_ptr<pfcp_association> sa = {};
   if (remove_peer_candidate_node(node_id, sa)) {
+    reconcile_restored_sessions(sa, recovery_time_stamp);
     sa->recovery_time_stamp = recovery_time_stamp;
     sa->set(function_features);
     std::size_t hash_node_id = std::hash<pfcp::node_id_t>{}(node_id);
@@ -98,6 +104,42 @@ bool pfcp_associations::add_association(
   return false;
 }
 //------------------------------------------------------------------------------
+void pfcp_associations::reconcile_restored_sessions(
+    std::shared_ptr<pfcp_association>& sa,
+    const pfcp::recovery_time_stamp_t& recovery_time_stamp) {
+  pfcp_switch_inst->notify_association(sa->node_id, recovery_time_stamp);
+  if ((sa->recovery_time_stamp == recovery_time_stamp) ||
+      (sa->sessions.empty())) {
+    return;
+  }
+  Logger::spgwu_sx().info(
+      "CP function restarted, deleting its %zu restored sessions",
+      sa->sessions.size());
+  sa->del_sessions();
+}
+//------------------------------------------------------------------------------
+bool pfcp_associations::restore_session(
+    const pfcp::node_id_t& node_id,
+    const pfcp::recovery_time_stamp_t& recovery_time_stamp,
+    const pfcp::fseid_t& cp_fseid) {
+  if (std::find(spgwu_cfg.spgwcs.begin(), spgwu_cfg.spgwcs.end(), node_id) ==
+      spgwu_cfg.spgwcs.end()) {
+    return false;
+  }
+  for (auto it : restored_associations) {
+    if (it->node_id == node_id) {
+      it->notify_add_session(cp_fseid);
+      return true;
+    }
+  }
+  pfcp::recovery_time_stamp_t rts = recovery_time_stamp;
+  std::shared_ptr<pfcp_association> sa =
+      std::make_shared<pfcp_association>(node_id, rts);
+  sa->notify_add_session(cp_fseid);
+  restored_associations.push_back(sa);
+  return true;
+}
+//------------------------------------------------------------------------------
 bool pfcp_associations::get_association(
     const pfcp::node_id_t& node_id,
     std::shared_ptr<pfcp_association>& sa) const {
@@ -152,6 +194,16 @@ bool pfcp_associations::add_peer_candidate_node(
       break;
     }
   }
+  for (std::vector<std::shared_ptr<pfcp_association>>::iterator it =
+           restored_associations.begin();
+       it < restored_associations.end(); ++it) {
+    if ((*it)->node_id == node_id) {
+      // Its sessions are reconciled when the association is set up
+      pending_associations.push_back(*it);
+      restored_associations.erase(it);
+      return true;
+    }
+  }
   pfcp_association* association = new pfcp_association(node_id);
   std::shared_ptr<pfcp_association> s =
       std::shared_ptr<pfcp_association>(association);
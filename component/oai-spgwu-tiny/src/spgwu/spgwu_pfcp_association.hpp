@@ -34,6 +34,7 @@
 #include <folly/AtomicHashMap.h>
 #include <folly/AtomicLinkedList.h>
 #include <mutex>
+#include <set>
 #include <vector>
 
 namespace spgwu {
@@ -119,14 +120,24 @@ class pfcp_association {
 class pfcp_associations {
  private:
   std::vector<std::shared_ptr<pfcp_association>> pending_associations;
+  // Sessions restored from the session snapshot, per CP function, until the
+  // association is set up again
+  std::vector<std::shared_ptr<pfcp_association>> restored_associations;
   folly::AtomicHashMap<int32_t, std::shared_ptr<pfcp_association>> associations;
 
   pfcp_associations()
-      : associations(PFCP_MAX_ASSOCIATIONS), pending_associations(){};
+      : associations(PFCP_MAX_ASSOCIATIONS),
+        pending_associations(),
+        restored_associations(){};
   void trigger_heartbeat_request_procedure(
       std::shared_ptr<pfcp_association>& s);
   bool remove_peer_candidate_node(
       pfcp::node_id_t& node_id, std::shared_ptr<pfcp_association>& s);
+  // The sessions restored for a CP function are kept if it did not restart
+  // (same recovery time stamp), else they are deleted
+  void reconcile_restored_sessions(
+      std::shared_ptr<pfcp_association>& sa,
+      const pfcp::recovery_time_stamp_t& recovery_time_stamp);
 
  public:
   static pfcp_associations& get_instance() {
@@ -156,6 +167,12 @@ class pfcp_associations {
   void notify_del_session(const pfcp::fseid_t& cp_fseid);
 
   bool add_peer_candidate_node(const pfcp::node_id_t& node_id);
+  // Startup, before the associations: return false if the CP function is not
+  // configured any more
+  bool restore_session(
+      const pfcp::node_id_t& node_id,
+      const pfcp::recovery_time_stamp_t& recovery_time_stamp,
+      const pfcp::fseid_t& cp_fseid);
 
   void restore_sx_sessions(const pfcp::node_id_t& node_id);
 
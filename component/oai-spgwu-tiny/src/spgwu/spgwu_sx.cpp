@@ -243,13 +243,15 @@ spgwu_sx::spgwu_sx()
     Logger::spgwu_sx().error("Cannot create task TASK_SPGWU_SX");
     throw std::runtime_error("Cannot create task TASK_SPGWU_SX");
   }
-
+  Logger::spgwu_sx().startup("Started");
+}
+//------------------------------------------------------------------------------
+void spgwu_sx::start_associations() {
   for (std::vector<pfcp::node_id_t>::const_iterator it =
            spgwu_cfg.spgwcs.begin();
        it != spgwu_cfg.spgwcs.end(); ++it) {
     start_association(*it);
   }
-  Logger::spgwu_sx().startup("Started");
 }
 
 //------------------------------------------------------------------------------
@@ -632,12 +634,10 @@ void spgwu_sx::handle_receive(
     const endpoint& remote_endpoint) {
   Logger::spgwu_sx().info("handle_receive(%d bytes)", bytes_transferred);
   // std::cout << string_to_hex(recv_buffer, bytes_transferred) << std::endl;
-  std::istringstream iss(std::istringstream::binary);
-  iss.rdbuf()->pubsetbuf(recv_buffer, bytes_transferred);
   pfcp_msg msg    = {};
   msg.remote_port = remote_endpoint.port();
   try {
-    msg.load_from(iss);
+    msg.load_from(recv_buffer, bytes_transferred);
     handle_receive_pfcp_msg(msg, remote_endpoint);
   } catch (pfcp_exception& e) {
     Logger::spgwu_sx().info("handle_receive exception %s", e.what());
@@ -57,6 +57,14 @@ class spgwu_sx : public pfcp::pfcp_l4_stack {
   spgwu_sx(spgwu_sx const&) = delete;
   void operator=(spgwu_sx const&) = delete;
 
+  // Once the PFCP sessions are restored, the recovery time stamp is the one
+  // of the restored sessions
+  void start_associations();
+  uint64_t get_recovery_time_stamp() const { return recovery_time_stamp; }
+  void set_recovery_time_stamp(const uint64_t rts) {
+    recovery_time_stamp = rts;
+  }
+
   void handle_itti_msg(itti_sxab_heartbeat_request& s){};
   void handle_itti_msg(itti_sxab_heartbeat_response& s){};
   void handle_itti_msg(itti_sxab_association_setup_request& s){};
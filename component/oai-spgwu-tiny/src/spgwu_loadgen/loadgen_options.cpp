@@ -0,0 +1,314 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file loadgen_options.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "loadgen_options.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <iostream>
+#include <stdexcept>
+#include <stdlib.h>
+
+using namespace loadgen;
+
+enum loadgen_option_e {
+  OPTION_SX_NETNS = 256,
+  OPTION_S1U_NETNS,
+  OPTION_SGI_NETNS,
+  OPTION_CP_ADDR,
+  OPTION_ENB_ADDR,
+  OPTION_SGI_ADDR,
+  OPTION_UL_PORT,
+  OPTION_DL_PORT,
+  OPTION_UE_NETWORK,
+  OPTION_WINDOW,
+  OPTION_UL_RATE,
+  OPTION_DL_RATE,
+  OPTION_TX_THREADS,
+  OPTION_RX_THREADS,
+  OPTION_BATCH,
+  OPTION_WARMUP,
+  OPTION_INTERVAL,
+  OPTION_DRAIN,
+  OPTION_CSV,
+  OPTION_LABEL
+};
+
+//------------------------------------------------------------------------------
+static bool parse_ipv4(const char* s, struct in_addr& a) {
+  return inet_pton(AF_INET, s, &a) == 1;
+}
+//------------------------------------------------------------------------------
+static bool parse_uint(
+    const char* s, uint64_t& v, const uint64_t min, const uint64_t max) {
+  char* end = nullptr;
+  errno     = 0;
+  v         = strtoull(s, &end, 10);
+  return (errno == 0) && (end != s) && (*end == '\0') && (v >= min) &&
+         (v <= max);
+}
+//------------------------------------------------------------------------------
+loadgen_options::loadgen_options()
+    : sx_netns(),
+      s1u_netns(),
+      sgi_netns(),
+      cp_addr(),
+      enb_addr(),
+      sgi_addr(),
+      ul_port(5001),
+      dl_port(5002),
+      ue_network(),
+      ue_prefix_len(0),
+      sessions(100),
+      window(64),
+      ul_rate(10000),
+      dl_rate(10000),
+      packet_size(512),
+      tx_threads(1),
+      rx_threads(1),
+      batch(32),
+      warmup_sec(1),
+      duration_sec(10),
+      interval_sec(1),
+      drain_ms(500),
+      csv_file(),
+      label(),
+      log_stdout(false) {}
+//------------------------------------------------------------------------------
+void loadgen_options::help() {
+  std::cout
+      << std::endl
+      << "Usage:  spgwu_loadgen  [OPTIONS]..." << std::endl
+      << "Emulates a SPGW-C on Sx and eNBs on S1-U, sinks and sources the SGi "
+         "traffic,"
+      << std::endl
+      << "reports the throughput, loss and one way latency of the SPGW-U."
+      << std::endl
+      << "  -h, --help                   Print help and exit" << std::endl
+      << "      --cp-addr ip             SPGW-C address on Sx (mandatory)"
+      << std::endl
+      << "      --enb-addr ip            eNB address on S1-U (mandatory)"
+      << std::endl
+      << "      --sgi-addr ip            Server address on SGi (mandatory)"
+      << std::endl
+      << "      --ue-network cidr        PDN network of the SPGW-U "
+         "(mandatory)"
+      << std::endl
+      << "      --sx-netns name          Network namespace of the Sx socket"
+      << std::endl
+      << "      --s1u-netns name         Network namespace of the S1-U sockets"
+      << std::endl
+      << "      --sgi-netns name         Network namespace of the SGi sockets"
+      << std::endl
+      << "      --ul-port port           UDP port of the UL sink (5001)"
+      << std::endl
+      << "      --dl-port port           UDP port of the DL traffic on the "
+         "UEs (5002)"
+      << std::endl
+      << "  -n, --sessions n             PFCP sessions, one UE each (100)"
+      << std::endl
+      << "      --window n               Max session establishments pending "
+         "(64)"
+      << std::endl
+      << "      --ul-rate pps            UL packets per second, 0 for none "
+         "(10000)"
+      << std::endl
+      << "      --dl-rate pps            DL packets per second, 0 for none "
+         "(10000)"
+      << std::endl
+      << "  -s, --size bytes             Size of the UE IP packets (512)"
+      << std::endl
+      << "      --tx-threads n           Sender threads per direction (1)"
+      << std::endl
+      << "      --rx-threads n           Receiver threads per direction (1)"
+      << std::endl
+      << "      --batch n                Packets per sendmmsg/recvmmsg (32)"
+      << std::endl
+      << "      --warmup s               Seconds not measured first (1)"
+      << std::endl
+      << "  -d, --duration s             Seconds measured (10)" << std::endl
+      << "      --interval s             Seconds between two reports (1)"
+      << std::endl
+      << "      --drain ms               Wait for the packets in flight (500)"
+      << std::endl
+      << "      --csv filename           Append the results to this file"
+      << std::endl
+      << "      --label string           First column of the results (none)"
+      << std::endl
+      << "  -o, --stdoutlog              Send the application logs to "
+         "STDOUT fd."
+      << std::endl;
+}
+//------------------------------------------------------------------------------
+bool loadgen_options::parse(int argc, char** argv) {
+  struct option long_options[] = {
+      {"help", no_argument, NULL, 'h'},
+      {"sx-netns", required_argument, NULL, OPTION_SX_NETNS},
+      {"s1u-netns", required_argument, NULL, OPTION_S1U_NETNS},
+      {"sgi-netns", required_argument, NULL, OPTION_SGI_NETNS},
+      {"cp-addr", required_argument, NULL, OPTION_CP_ADDR},
+      {"enb-addr", required_argument, NULL, OPTION_ENB_ADDR},
+      {"sgi-addr", required_argument, NULL, OPTION_SGI_ADDR},
+      {"ul-port", required_argument, NULL, OPTION_UL_PORT},
+      {"dl-port", required_argument, NULL, OPTION_DL_PORT},
+      {"ue-network", required_argument, NULL, OPTION_UE_NETWORK},
+      {"sessions", required_argument, NULL, 'n'},
+      {"window", required_argument, NULL, OPTION_WINDOW},
+      {"ul-rate", required_argument, NULL, OPTION_UL_RATE},
+      {"dl-rate", required_argument, NULL, OPTION_DL_RATE},
+      {"size", required_argument, NULL, 's'},
+      {"tx-threads", required_argument, NULL, OPTION_TX_THREADS},
+      {"rx-threads", required_argument, NULL, OPTION_RX_THREADS},
+      {"batch", required_argument, NULL, OPTION_BATCH},
+      {"warmup", required_argument, NULL, OPTION_WARMUP},
+      {"duration", required_argument, NULL, 'd'},
+      {"interval", required_argument, NULL, OPTION_INTERVAL},
+      {"drain", required_argument, NULL, OPTION_DRAIN},
+      {"csv", required_argument, NULL, OPTION_CSV},
+      {"label", required_argument, NULL, OPTION_LABEL},
+      {"stdoutlog", no_argument, NULL, 'o'},
+      {NULL, 0, NULL, 0}};
+
+  bool cp = false, enb = false, sgi = false, ue = false;
+  int c;
+  int option_index = 0;
+  uint64_t v       = 0;
+  bool result      = true;
+  while (result) {
+    c = getopt_long(argc, argv, "hn:s:d:o", long_options, &option_index);
+    if (c == -1) break;  // Exit from the loop.
+
+    switch (c) {
+      case 'h':
+        help();
+        exit(0);
+      case OPTION_SX_NETNS:
+        sx_netns = optarg;
+        break;
+      case OPTION_S1U_NETNS:
+        s1u_netns = optarg;
+        break;
+      case OPTION_SGI_NETNS:
+        sgi_netns = optarg;
+        break;
+      case OPTION_CP_ADDR:
+        result = cp = parse_ipv4(optarg, cp_addr);
+        break;
+      case OPTION_ENB_ADDR:
+        result = enb = parse_ipv4(optarg, enb_addr);
+        break;
+      case OPTION_SGI_ADDR:
+        result = sgi = parse_ipv4(optarg, sgi_addr);
+        break;
+      case OPTION_UL_PORT:
+        if ((result = parse_uint(optarg, v, 1, UINT16_MAX))) ul_port = v;
+        break;
+      case OPTION_DL_PORT:
+        if ((result = parse_uint(optarg, v, 1, UINT16_MAX))) dl_port = v;
+        break;
+      case OPTION_UE_NETWORK: {
+        std::string s(optarg);
+        const std::size_t slash = s.find('/');
+        result = ue = (slash != std::string::npos) &&
+                      parse_ipv4(s.substr(0, slash).c_str(), ue_network) &&
+                      parse_uint(s.c_str() + slash + 1, v, 8, 30);
+        ue_prefix_len = v;
+      } break;
+      case 'n':
+        if ((result = parse_uint(optarg, v, 1, UINT32_MAX))) sessions = v;
+        break;
+      case OPTION_WINDOW:
+        if ((result = parse_uint(optarg, v, 1, 65536))) window = v;
+        break;
+      case OPTION_UL_RATE:
+        result = parse_uint(optarg, ul_rate, 0, UINT32_MAX);
+        break;
+      case OPTION_DL_RATE:
+        result = parse_uint(optarg, dl_rate, 0, UINT32_MAX);
+        break;
+      case 's':
+        // UDP payload fits the probe, GTP-U packet fits a 9000 bytes MTU
+        if ((result = parse_uint(optarg, v, 52, 8900))) packet_size = v;
+        break;
+      case OPTION_TX_THREADS:
+        if ((result = parse_uint(optarg, v, 1, 64))) tx_threads = v;
+        break;
+      case OPTION_RX_THREADS:
+        if ((result = parse_uint(optarg, v, 1, 64))) rx_threads = v;
+        break;
+      case OPTION_BATCH:
+        if ((result = parse_uint(optarg, v, 1, 1024))) batch = v;
+        break;
+      case OPTION_WARMUP:
+        if ((result = parse_uint(optarg, v, 0, 3600))) warmup_sec = v;
+        break;
+      case 'd':
+        if ((result = parse_uint(optarg, v, 1, 86400))) duration_sec = v;
+        break;
+      case OPTION_INTERVAL:
+        if ((result = parse_uint(optarg, v, 1, 3600))) interval_sec = v;
+        break;
+      case OPTION_DRAIN:
+        if ((result = parse_uint(optarg, v, 0, 60000))) drain_ms = v;
+        break;
+      case OPTION_CSV:
+        csv_file = optarg;
+        break;
+      case OPTION_LABEL:
+        label = optarg;
+        break;
+      case 'o':
+        log_stdout = true;
+        break;
+      default:
+        result = false;
+    }
+    if (not result) {
+      std::cout << "Bad option " << argv[optind - 1] << std::endl;
+    }
+  }
+  if (result && not(cp && enb && sgi && ue)) {
+    std::cout << "Options --cp-addr --enb-addr --sgi-addr --ue-network are "
+                 "mandatory"
+              << std::endl;
+    result = false;
+  }
+  // Host addresses of the PDN network, less the network, TUN and broadcast
+  // addresses
+  if (result && (sessions > (1ULL << (32 - ue_prefix_len)) - 3)) {
+    std::cout << "Too many sessions for the UE network /"
+              << (int) ue_prefix_len << std::endl;
+    result = false;
+  }
+  if (result && (optind < argc)) {
+    std::cout << "Unexpected argument " << argv[optind] << std::endl;
+    result = false;
+  }
+  return result;
+}
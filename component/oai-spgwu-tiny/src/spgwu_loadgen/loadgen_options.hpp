@@ -0,0 +1,93 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file loadgen_options.hpp
+  \brief Command line of the SPGW-U load generator
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_LOADGEN_OPTIONS_HPP_SEEN
+#define FILE_LOADGEN_OPTIONS_HPP_SEEN
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string>
+
+namespace loadgen {
+
+class loadgen_options {
+ public:
+  // Network namespaces (ip netns) of the Sx, S1-U and SGi sockets, empty for
+  // the namespace of the process
+  std::string sx_netns;
+  std::string s1u_netns;
+  std::string sgi_netns;
+  // SPGW-C address on Sx, the SPGW-U must list it in SPGW-C_LIST
+  struct in_addr cp_addr;
+  // eNB address on S1-U
+  struct in_addr enb_addr;
+  // Server address on SGi, sinks the UL traffic and sources the DL traffic
+  struct in_addr sgi_addr;
+  uint16_t ul_port;
+  uint16_t dl_port;
+  // UE addresses are taken from the PDN network of the SPGW-U, starting at
+  // its 2nd host address (the 1st one is the TUN address)
+  struct in_addr ue_network;
+  uint8_t ue_prefix_len;
+
+  uint32_t sessions;
+  // Max session establishment requests waiting for a response
+  uint32_t window;
+
+  // Packets per second, 0 to disable a direction
+  uint64_t ul_rate;
+  uint64_t dl_rate;
+  // Size of the UE IP packets (GTP-U payload)
+  uint32_t packet_size;
+  uint32_t tx_threads;
+  uint32_t rx_threads;
+  // Max packets per sendmmsg/recvmmsg call
+  uint32_t batch;
+
+  // Packets sent during the warmup are not measured
+  uint32_t warmup_sec;
+  uint32_t duration_sec;
+  uint32_t interval_sec;
+  // Time given to the packets in flight after the last one is sent
+  uint32_t drain_ms;
+
+  // Scripted mode: a line of results is appended to this file
+  std::string csv_file;
+  // First column of the line, to tell the runs apart (git commit...)
+  std::string label;
+  bool log_stdout;
+
+  loadgen_options();
+
+  bool parse(int argc, char** argv);
+  static void help();
+};
+
+}  // namespace loadgen
+
+#endif /* FILE_LOADGEN_OPTIONS_HPP_SEEN */
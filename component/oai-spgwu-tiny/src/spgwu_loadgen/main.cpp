@@ -0,0 +1,105 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file main.cpp
+  \brief Load generator and benchmark of the SPGW-U: emulates a SPGW-C on Sx,
+         eNBs on S1-U and a server on SGi
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "loadgen_options.hpp"
+#include "logger.hpp"
+#include "sx_peer.hpp"
+#include "traffic.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <iostream>
+#include <signal.h>
+#include <vector>
+
+using namespace loadgen;
+
+// Time given to the SPGW-U to start and set up its association
+#define LOADGEN_ASSOCIATION_TIMEOUT_SEC 30
+// Max time without any Sx response while establishing or releasing
+#define LOADGEN_SX_TIMEOUT_SEC 10
+
+static std::atomic<bool> stop(false);
+
+//------------------------------------------------------------------------------
+static void loadgen_signal_handler(int s) {
+  stop.store(true);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  loadgen_options opt;
+  if (not opt.parse(argc, argv)) {
+    loadgen_options::help();
+    return 1;
+  }
+
+  Logger::init("spgwu_loadgen", opt.log_stdout, false);
+
+  struct sigaction sa = {};
+  sa.sa_handler       = loadgen_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  // UE addresses from the 2nd host address of the PDN network, the eNB
+  // TEIDs and the CP SEIDs from 1
+  std::vector<session_t> sessions(opt.sessions);
+  const uint32_t network = ntohl(opt.ue_network.s_addr) &
+                           (0xFFFFFFFF << (32 - opt.ue_prefix_len));
+  for (uint32_t i = 0; i < opt.sessions; i++) {
+    sessions[i]                = {};
+    sessions[i].cp_seid        = i + 1;
+    sessions[i].ue_ipv4.s_addr = htonl(network + 2 + i);
+    sessions[i].enb_teid       = i + 1;
+  }
+
+  sx_peer sx;
+  if ((not sx.open(opt.sx_netns, opt.cp_addr)) ||
+      (not sx.associate(LOADGEN_ASSOCIATION_TIMEOUT_SEC))) {
+    std::cout << "No Sx association with the SPGW-U" << std::endl;
+    return 1;
+  }
+  const uint32_t established =
+      sx.establish(sessions, opt.enb_addr, opt.window, LOADGEN_SX_TIMEOUT_SEC);
+  std::cout << established << "/" << opt.sessions << " sessions established"
+            << std::endl;
+
+  int rc = (established == opt.sessions) ? 0 : 1;
+  if (established && (not stop.load())) {
+    traffic t(opt, sessions, stop);
+    if (t.open()) {
+      t.run();
+      t.report();
+    } else {
+      rc = 1;
+    }
+  }
+  sx.release(sessions, opt.window, LOADGEN_SX_TIMEOUT_SEC);
+  return rc;
+}
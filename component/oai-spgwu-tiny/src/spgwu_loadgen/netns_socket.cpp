@@ -0,0 +1,112 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file netns_socket.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "netns_socket.hpp"
+#include "conversions.hpp"
+#include "logger.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define NETNS_RUN_DIR "/var/run/netns/"
+// Room for the bursts of the SPGW-U between two recvmmsg
+#define NETNS_SOCKET_BUFFER_SIZE (16 * 1024 * 1024)
+
+//------------------------------------------------------------------------------
+static int udp_socket(
+    const struct in_addr& address, const uint16_t port, const bool reuse_port) {
+  int sd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sd < 0) {
+    Logger::system().error("socket() failed: %s", strerror(errno));
+    return -1;
+  }
+  const int one  = 1;
+  const int size = NETNS_SOCKET_BUFFER_SIZE;
+  if (reuse_port) {
+    setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+  }
+  // SO_*BUFFORCE ignores rmem_max/wmem_max, needs CAP_NET_ADMIN
+  if (setsockopt(sd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0) {
+    setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  }
+  if (setsockopt(sd, SOL_SOCKET, SO_SNDBUFFORCE, &size, sizeof(size)) < 0) {
+    setsockopt(sd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  }
+  struct sockaddr_in addr = {};
+  addr.sin_family         = AF_INET;
+  addr.sin_addr           = address;
+  addr.sin_port           = htons(port);
+  if (bind(sd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+    Logger::system().error(
+        "bind(%s:%d) failed: %s", conv::toString(address).c_str(), port,
+        strerror(errno));
+    close(sd);
+    return -1;
+  }
+  return sd;
+}
+//------------------------------------------------------------------------------
+int loadgen::netns_udp_socket(
+    const std::string& netns, const struct in_addr& address,
+    const uint16_t port, const bool reuse_port) {
+  if (netns.empty()) return udp_socket(address, port, reuse_port);
+
+  const std::string path = NETNS_RUN_DIR + netns;
+  int self               = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC);
+  int target             = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if ((self < 0) || (target < 0)) {
+    Logger::system().error(
+        "Cannot open network namespace %s: %s", path.c_str(), strerror(errno));
+    if (self >= 0) close(self);
+    if (target >= 0) close(target);
+    return -1;
+  }
+  int sd = -1;
+  // setns() only moves the calling thread
+  if (setns(target, CLONE_NEWNET) < 0) {
+    Logger::system().error(
+        "Cannot enter network namespace %s: %s", netns.c_str(),
+        strerror(errno));
+  } else {
+    sd = udp_socket(address, port, reuse_port);
+    if (setns(self, CLONE_NEWNET) < 0) {
+      Logger::system().error(
+          "Cannot return to the network namespace of the process: %s",
+          strerror(errno));
+      if (sd >= 0) close(sd);
+      sd = -1;
+    }
+  }
+  close(self);
+  close(target);
+  return sd;
+}
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file netns_socket.hpp
+  \brief UDP sockets of the load generator, in the network namespaces of the
+         emulated nodes
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_NETNS_SOCKET_HPP_SEEN
+#define FILE_NETNS_SOCKET_HPP_SEEN
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include <string>
+
+namespace loadgen {
+
+// Open a UDP socket in the network namespace netns (a name given to ip netns
+// add, empty for the namespace of the process) and bind it to address:port.
+// A socket stays in the namespace it was created in, so a single process
+// emulates nodes on both sides of the SPGW-U. Several sockets bound with
+// reuse_port share the datagrams of the same address and port.
+// Return the socket, -1 on error (logged).
+int netns_udp_socket(
+    const std::string& netns, const struct in_addr& address,
+    const uint16_t port, const bool reuse_port);
+
+}  // namespace loadgen
+
+#endif /* FILE_NETNS_SOCKET_HPP_SEEN */
@@ -0,0 +1,414 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file sx_peer.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "sx_peer.hpp"
+#include "conversions.hpp"
+#include "logger.hpp"
+#include "netns_socket.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace loadgen;
+
+#define SX_PEER_RECV_TIMEOUT_MS 100
+#define SX_PEER_MSG_MAX_SIZE 4096
+
+// PDR and FAR ids of the default bearer
+#define SX_PEER_UL_RULE_ID 1
+#define SX_PEER_DL_RULE_ID 2
+
+//------------------------------------------------------------------------------
+static void build_session_establishment_request(
+    const session_t& s, const struct in_addr& cp_addr,
+    const struct in_addr& enb_addr,
+    pfcp::pfcp_session_establishment_request& ies) {
+  pfcp::node_id_t node_id       = {};
+  node_id.node_id_type          = pfcp::NODE_ID_TYPE_IPV4_ADDRESS;
+  node_id.u1.ipv4_address       = cp_addr;
+  pfcp::fseid_t cp_fseid        = {};
+  cp_fseid.v4                   = 1;
+  cp_fseid.seid                 = s.cp_seid;
+  cp_fseid.ipv4_address         = cp_addr;
+  pfcp::ue_ip_address_t ue_ip   = {};
+  ue_ip.v4                      = 1;
+  ue_ip.ipv4_address            = s.ue_ipv4;
+  pfcp::precedence_t precedence = {.precedence = 1};
+  ies.set(node_id);
+  ies.set(cp_fseid);
+
+  // UL: F-TEID allocated by the SPGW-U, decapsulated, to the core
+  pfcp::create_far ul_far                 = {};
+  pfcp::far_id_t ul_far_id                = {};
+  pfcp::apply_action_t apply_action       = {};
+  pfcp::forwarding_parameters ul_fwd      = {};
+  pfcp::destination_interface_t ul_dst_if = {};
+  ul_far_id.far_id                        = SX_PEER_UL_RULE_ID;
+  apply_action.forw                       = 1;
+  ul_dst_if.interface_value               = pfcp::INTERFACE_VALUE_CORE;
+  ul_fwd.set(ul_dst_if);
+  ul_far.set(ul_far_id);
+  ul_far.set(apply_action);
+  ul_far.set(ul_fwd);
+
+  pfcp::create_pdr ul_pdr              = {};
+  pfcp::pdr_id_t ul_pdr_id             = {};
+  pfcp::pdi ul_pdi                     = {};
+  pfcp::source_interface_t ul_src_if   = {};
+  pfcp::fteid_t local_fteid            = {};
+  pfcp::outer_header_removal_t ohr     = {};
+  ul_pdr_id.rule_id                    = SX_PEER_UL_RULE_ID;
+  ul_src_if.interface_value            = pfcp::INTERFACE_VALUE_ACCESS;
+  local_fteid.ch                       = 1;
+  ohr.outer_header_removal_description = OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4;
+  ul_pdi.set(ul_src_if);
+  ul_pdi.set(local_fteid);
+  ul_pdi.set(ue_ip);
+  ul_pdr.set(ul_pdr_id);
+  ul_pdr.set(precedence);
+  ul_pdr.set(ul_pdi);
+  ul_pdr.set(ohr);
+  ul_pdr.set(ul_far_id);
+
+  // DL: UE address, encapsulated to the eNB
+  pfcp::create_far dl_far                 = {};
+  pfcp::far_id_t dl_far_id                = {};
+  pfcp::forwarding_parameters dl_fwd      = {};
+  pfcp::destination_interface_t dl_dst_if = {};
+  pfcp::outer_header_creation_t ohc       = {};
+  dl_far_id.far_id                        = SX_PEER_DL_RULE_ID;
+  dl_dst_if.interface_value               = pfcp::INTERFACE_VALUE_ACCESS;
+  ohc.teid                                = s.enb_teid;
+  ohc.ipv4_address                        = enb_addr;
+  ohc.outer_header_creation_description =
+      pfcp::OUTER_HEADER_CREATION_GTPU_UDP_IPV4;
+  dl_fwd.set(dl_dst_if);
+  dl_fwd.set(ohc);
+  dl_far.set(dl_far_id);
+  dl_far.set(apply_action);
+  dl_far.set(dl_fwd);
+
+  pfcp::create_pdr dl_pdr            = {};
+  pfcp::pdr_id_t dl_pdr_id           = {};
+  pfcp::pdi dl_pdi                   = {};
+  pfcp::source_interface_t dl_src_if = {};
+  dl_pdr_id.rule_id                  = SX_PEER_DL_RULE_ID;
+  dl_src_if.interface_value          = pfcp::INTERFACE_VALUE_CORE;
+  dl_pdi.set(dl_src_if);
+  dl_pdi.set(ue_ip);
+  dl_pdr.set(dl_pdr_id);
+  dl_pdr.set(precedence);
+  dl_pdr.set(dl_pdi);
+  dl_pdr.set(dl_far_id);
+
+  ies.set(ul_pdr);
+  ies.set(ul_far);
+  ies.set(dl_pdr);
+  ies.set(dl_far);
+}
+//------------------------------------------------------------------------------
+sx_peer::sx_peer()
+    : sd_(-1),
+      cp_addr_(),
+      up_(),
+      recovery_time_stamp_(),
+      running_(false),
+      thread_(),
+      m_(),
+      cv_(),
+      sequence_number_(0),
+      pending_(),
+      sessions_(nullptr) {
+  // Same origin as the SPGW-U (RFC 5905 era 1)
+  std::tm tm_epoch       = {0};
+  tm_epoch.tm_year       = 2036 - 1900;
+  tm_epoch.tm_mon        = 2 - 1;
+  tm_epoch.tm_mday       = 8;
+  std::time_t time_epoch = std::mktime(&tm_epoch);
+  recovery_time_stamp_.recovery_time_stamp =
+      (uint32_t)(std::time(nullptr) - time_epoch);
+}
+//------------------------------------------------------------------------------
+sx_peer::~sx_peer() {
+  running_.store(false, std::memory_order_release);
+  if (thread_.joinable()) thread_.join();
+  if (sd_ >= 0) close(sd_);
+}
+//------------------------------------------------------------------------------
+bool sx_peer::open(const std::string& netns, const struct in_addr& cp_addr) {
+  cp_addr_ = cp_addr;
+  sd_      = netns_udp_socket(netns, cp_addr, SX_PEER_PFCP_PORT, false);
+  if (sd_ < 0) return false;
+  struct timeval tv = {.tv_sec  = 0,
+                       .tv_usec = SX_PEER_RECV_TIMEOUT_MS * 1000};
+  setsockopt(sd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  return true;
+}
+//------------------------------------------------------------------------------
+bool sx_peer::send(pfcp::pfcp_msg& msg) {
+  char buffer[SX_PEER_MSG_MAX_SIZE];
+  const std::size_t length = msg.dump_to(buffer, sizeof(buffer));
+  if (sendto(sd_, buffer, length, 0, (struct sockaddr*) &up_, sizeof(up_)) !=
+      (ssize_t) length) {
+    Logger::pgwc_sx().error("Sx sendto() failed: %s", strerror(errno));
+    return false;
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+bool sx_peer::wait_pending(
+    std::unique_lock<std::mutex>& l, const std::size_t max_pending,
+    const uint32_t timeout_sec) {
+  return cv_.wait_for(l, std::chrono::seconds(timeout_sec), [&] {
+    return pending_.size() <= max_pending;
+  });
+}
+//------------------------------------------------------------------------------
+void sx_peer::send_request(pfcp::pfcp_msg& msg, const uint32_t session_index) {
+  std::unique_lock<std::mutex> l(m_);
+  sequence_number_ = (sequence_number_ + 1) & 0x00FFFFFF;
+  if (not sequence_number_) sequence_number_ = 1;
+  const uint32_t sequence_number = sequence_number_;
+  msg.set_sequence_number(sequence_number);
+  pending_[sequence_number] = session_index;
+  l.unlock();
+  if (not send(msg)) {
+    l.lock();
+    pending_.erase(sequence_number);
+  }
+}
+//------------------------------------------------------------------------------
+bool sx_peer::associate(const uint32_t timeout_sec) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+  char buffer[SX_PEER_MSG_MAX_SIZE];
+  while (std::chrono::steady_clock::now() < deadline) {
+    struct sockaddr_in from = {};
+    socklen_t from_len      = sizeof(from);
+    const ssize_t length    = recvfrom(
+        sd_, buffer, sizeof(buffer), 0, (struct sockaddr*) &from, &from_len);
+    if (length <= 0) continue;
+    pfcp::pfcp_msg msg = {};
+    try {
+      msg.load_from(buffer, length);
+    } catch (pfcp::pfcp_exception& e) {
+      continue;
+    }
+    if (msg.get_message_type() != PFCP_ASSOCIATION_SETUP_REQUEST) continue;
+
+    up_ = from;
+    pfcp::pfcp_association_setup_response ies = {};
+    pfcp::node_id_t node_id                   = {};
+    pfcp::cause_t cause = {.cause_value = pfcp::CAUSE_VALUE_REQUEST_ACCEPTED};
+    node_id.node_id_type    = pfcp::NODE_ID_TYPE_IPV4_ADDRESS;
+    node_id.u1.ipv4_address = cp_addr_;
+    ies.set(node_id);
+    ies.set(cause);
+    ies.set(recovery_time_stamp_);
+    pfcp::pfcp_msg resp(ies);
+    resp.set_sequence_number(msg.get_sequence_number());
+    if (not send(resp)) return false;
+    Logger::pgwc_sx().info(
+        "Association set up with SPGW-U %s",
+        conv::toString(from.sin_addr).c_str());
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&sx_peer::run, this);
+    return true;
+  }
+  Logger::pgwc_sx().error(
+      "No association setup request from the SPGW-U after %d s", timeout_sec);
+  return false;
+}
+//------------------------------------------------------------------------------
+uint32_t sx_peer::establish(
+    std::vector<session_t>& sessions, const struct in_addr& enb_addr,
+    const uint32_t window, const uint32_t timeout_sec) {
+  const auto start = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> l(m_);
+    sessions_ = &sessions;
+  }
+  for (uint32_t i = 0; i < sessions.size(); i++) {
+    {
+      std::unique_lock<std::mutex> l(m_);
+      if (not wait_pending(l, window - 1, timeout_sec)) break;
+    }
+    pfcp::pfcp_session_establishment_request ies = {};
+    build_session_establishment_request(sessions[i], cp_addr_, enb_addr, ies);
+    pfcp::pfcp_msg msg(ies);
+    msg.set_seid(0);
+    send_request(msg, i);
+  }
+  std::unique_lock<std::mutex> l(m_);
+  if (not wait_pending(l, 0, timeout_sec)) {
+    Logger::pgwc_sx().error(
+        "%d session establishment requests not answered", pending_.size());
+    pending_.clear();
+  }
+  uint32_t established = 0;
+  for (const auto& s : sessions) {
+    if (s.established) established++;
+  }
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  Logger::pgwc_sx().info(
+      "%d/%d sessions established in %d ms", established, sessions.size(), ms);
+  return established;
+}
+//------------------------------------------------------------------------------
+void sx_peer::release(
+    std::vector<session_t>& sessions, const uint32_t window,
+    const uint32_t timeout_sec) {
+  for (uint32_t i = 0; i < sessions.size(); i++) {
+    if (not sessions[i].established) continue;
+    {
+      std::unique_lock<std::mutex> l(m_);
+      if (not wait_pending(l, window - 1, timeout_sec)) break;
+    }
+    pfcp::pfcp_session_deletion_request ies = {};
+    pfcp::pfcp_msg msg(ies);
+    msg.set_seid(sessions[i].up_seid);
+    send_request(msg, i);
+  }
+  std::unique_lock<std::mutex> l(m_);
+  if (not wait_pending(l, 0, timeout_sec)) {
+    Logger::pgwc_sx().warn(
+        "%d session deletion requests not answered", pending_.size());
+    pending_.clear();
+  }
+}
+//------------------------------------------------------------------------------
+void sx_peer::handle_session_establishment_response(pfcp::pfcp_msg& msg) {
+  pfcp::pfcp_session_establishment_response ies = {};
+  msg.to_core_type(ies);
+  pfcp::cause_t cause    = {};
+  pfcp::fseid_t up_fseid = {};
+  pfcp::fteid_t fteid    = {};
+  bool ok = ies.get(cause) && (cause.cause_value ==
+                               pfcp::CAUSE_VALUE_REQUEST_ACCEPTED) &&
+            ies.get(up_fseid);
+  bool has_fteid = false;
+  for (const auto& cr_pdr : ies.created_pdrs) {
+    if (cr_pdr.get(fteid)) has_fteid = true;
+  }
+
+  std::unique_lock<std::mutex> l(m_);
+  auto it = pending_.find(msg.get_sequence_number());
+  if (it == pending_.end()) return;
+  session_t& s = (*sessions_)[it->second];
+  pending_.erase(it);
+  if (ok && has_fteid) {
+    s.up_seid     = up_fseid.seid;
+    s.sgw_teid    = fteid.teid;
+    s.sgw_ipv4    = fteid.ipv4_address;
+    s.established = true;
+  } else {
+    Logger::pgwc_sx().warn(
+        "Session of UE %s not established, cause %d",
+        conv::toString(s.ue_ipv4).c_str(), cause.cause_value);
+  }
+  l.unlock();
+  cv_.notify_all();
+}
+//------------------------------------------------------------------------------
+void sx_peer::handle_session_response(pfcp::pfcp_msg& msg) {
+  std::unique_lock<std::mutex> l(m_);
+  auto it = pending_.find(msg.get_sequence_number());
+  if (it == pending_.end()) return;
+  (*sessions_)[it->second].established = false;
+  pending_.erase(it);
+  l.unlock();
+  cv_.notify_all();
+}
+//------------------------------------------------------------------------------
+void sx_peer::handle_session_report_request(pfcp::pfcp_msg& msg) {
+  // CP SEID: index of the session + 1
+  uint64_t up_seid = 0;
+  {
+    std::unique_lock<std::mutex> l(m_);
+    if ((sessions_) && (msg.get_seid()) &&
+        (msg.get_seid() <= sessions_->size())) {
+      up_seid = (*sessions_)[msg.get_seid() - 1].up_seid;
+    }
+  }
+  pfcp::pfcp_session_report_response ies = {};
+  pfcp::cause_t cause = {.cause_value = pfcp::CAUSE_VALUE_REQUEST_ACCEPTED};
+  ies.set(cause);
+  pfcp::pfcp_msg resp(ies);
+  resp.set_seid(up_seid);
+  resp.set_sequence_number(msg.get_sequence_number());
+  send(resp);
+}
+//------------------------------------------------------------------------------
+void sx_peer::handle_receive(const char* buffer, const std::size_t length) {
+  pfcp::pfcp_msg msg = {};
+  try {
+    msg.load_from(buffer, length);
+    switch (msg.get_message_type()) {
+      case PFCP_HEARTBEAT_REQUEST: {
+        pfcp::pfcp_heartbeat_response ies = {};
+        ies.set(recovery_time_stamp_);
+        pfcp::pfcp_msg resp(ies);
+        resp.set_sequence_number(msg.get_sequence_number());
+        send(resp);
+      } break;
+      case PFCP_ASSOCIATION_SETUP_REQUEST:
+        Logger::pgwc_sx().error(
+            "The SPGW-U restarted, its sessions and the results are lost");
+        break;
+      case PFCP_SESSION_ESTABLISHMENT_RESPONSE:
+        handle_session_establishment_response(msg);
+        break;
+      case PFCP_SESSION_DELETION_RESPONSE:
+        handle_session_response(msg);
+        break;
+      case PFCP_SESSION_REPORT_REQUEST:
+        handle_session_report_request(msg);
+        break;
+      default:
+        Logger::pgwc_sx().trace(
+            "Ignored PFCP message type %d", msg.get_message_type());
+    }
+  } catch (pfcp::pfcp_exception& e) {
+    Logger::pgwc_sx().warn("Bad PFCP message: %s", e.what());
+  }
+}
+//------------------------------------------------------------------------------
+void sx_peer::run() {
+  char buffer[SX_PEER_MSG_MAX_SIZE];
+  while (running_.load(std::memory_order_acquire)) {
+    const ssize_t length = recv(sd_, buffer, sizeof(buffer), 0);
+    if (length > 0) handle_receive(buffer, length);
+  }
+}
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file sx_peer.hpp
+  \brief SPGW-C emulated on Sx by the load generator
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_SX_PEER_HPP_SEEN
+#define FILE_SX_PEER_HPP_SEEN
+
+#include "3gpp_29.244.hpp"
+#include "msg_pfcp.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace loadgen {
+
+typedef struct session_s {
+  // Chosen by the load generator
+  uint64_t cp_seid;
+  struct in_addr ue_ipv4;
+  uint32_t enb_teid;
+  // Allocated by the SPGW-U
+  uint64_t up_seid;
+  uint32_t sgw_teid;
+  struct in_addr sgw_ipv4;
+  bool established;
+} session_t;
+
+// Answers the association setup and the heartbeats of the SPGW-U, then
+// establishes a session per UE with a default bearer: an UL PDR matching the
+// F-TEID allocated by the SPGW-U, forwarding to the core, a DL PDR matching
+// the UE address, forwarding to the eNB F-TEID chosen here.
+// Requests are sent by the caller, everything received is handled by a
+// thread of the peer.
+class sx_peer {
+ private:
+#define SX_PEER_PFCP_PORT 8805
+
+  int sd_;
+  struct in_addr cp_addr_;
+  struct sockaddr_in up_;
+  pfcp::recovery_time_stamp_t recovery_time_stamp_;
+
+  std::atomic<bool> running_;
+  std::thread thread_;
+
+  std::mutex m_;
+  std::condition_variable cv_;
+  uint32_t sequence_number_;
+  // Sequence number of the pending requests, index of their session
+  std::unordered_map<uint32_t, uint32_t> pending_;
+  std::vector<session_t>* sessions_;
+
+  bool send(pfcp::pfcp_msg& msg);
+  void send_request(pfcp::pfcp_msg& msg, const uint32_t session_index);
+  // Wait until at most max_pending requests are pending, false on timeout
+  bool wait_pending(
+      std::unique_lock<std::mutex>& l, const std::size_t max_pending,
+      const uint32_t timeout_sec);
+
+  void handle_receive(const char* buffer, const std::size_t length);
+  void handle_session_establishment_response(pfcp::pfcp_msg& msg);
+  void handle_session_response(pfcp::pfcp_msg& msg);
+  void handle_session_report_request(pfcp::pfcp_msg& msg);
+  void run();
+
+ public:
+  sx_peer();
+  sx_peer(const sx_peer&) = delete;
+  void operator=(const sx_peer&) = delete;
+  ~sx_peer();
+
+  bool open(const std::string& netns, const struct in_addr& cp_addr);
+  // Wait for the association setup request of the SPGW-U and accept it
+  bool associate(const uint32_t timeout_sec);
+  // Return the number of sessions established
+  uint32_t establish(
+      std::vector<session_t>& sessions, const struct in_addr& enb_addr,
+      const uint32_t window, const uint32_t timeout_sec);
+  void release(
+      std::vector<session_t>& sessions, const uint32_t window,
+      const uint32_t timeout_sec);
+};
+
+}  // namespace loadgen
+
+#endif /* FILE_SX_PEER_HPP_SEEN */
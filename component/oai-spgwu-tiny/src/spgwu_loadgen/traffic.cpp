@@ -0,0 +1,503 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file traffic.cpp
+  \brief
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "traffic.hpp"
+#include "3gpp_29.281.h"
+#include "gtpu.h"
+#include "logger.hpp"
+#include "netns_socket.hpp"
+#include "tsc.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <errno.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace loadgen;
+
+#define TRAFFIC_GTPU_PORT 2152
+#define TRAFFIC_GTPU_HEADER_SIZE 8
+#define TRAFFIC_IPV4_UDP_HEADER_SIZE                                           \
+  (sizeof(struct iphdr) + sizeof(struct udphdr))
+// Receivers wake up this often to see the end of the run
+#define TRAFFIC_RECV_TIMEOUT_MS 100
+#define TRAFFIC_RECV_BUFFER_SIZE 9216
+
+//------------------------------------------------------------------------------
+// Counters are only written by their worker, the report reads them
+static inline void add(std::atomic<uint64_t>& c, const uint64_t n) {
+  c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+static uint16_t ipv4_checksum(const struct iphdr* ip) {
+  const uint16_t* w = (const uint16_t*) ip;
+  uint32_t sum      = 0;
+  for (unsigned int i = 0; i < ip->ihl * 2; i++) {
+    sum += w[i];
+  }
+  while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t) ~sum;
+}
+//------------------------------------------------------------------------------
+// Offset of the T-PDU in a G-PDU, 0 if not a G-PDU
+static std::size_t gtpu_payload_offset(const char* p, const std::size_t len) {
+  if (len < TRAFFIC_GTPU_HEADER_SIZE) return 0;
+  const struct gtpuhdr* h = (const struct gtpuhdr*) p;
+  if ((h->version != 1) || (h->message_type != GTPU_G_PDU)) return 0;
+  std::size_t offset = TRAFFIC_GTPU_HEADER_SIZE;
+  if (h->e || h->s || h->pn) {
+    // Sequence number, N-PDU number, next extension header type
+    offset += 4;
+    uint8_t next = (offset <= len) ? (uint8_t) p[offset - 1] : 0;
+    // Each extension header: length in 4 octets units, ..., next type
+    while (h->e && next && (offset < len)) {
+      const std::size_t ext_len = 4 * (uint8_t) p[offset];
+      if ((not ext_len) || (offset + ext_len > len)) return 0;
+      offset += ext_len;
+      next = (uint8_t) p[offset - 1];
+    }
+  }
+  return (offset < len) ? offset : 0;
+}
+//------------------------------------------------------------------------------
+traffic::traffic(
+    const loadgen_options& opt, const std::vector<session_t>& sessions,
+    std::atomic<bool>& stop)
+    : opt_(opt),
+      sessions_(sessions),
+      stop_(stop),
+      ul_(),
+      dl_(),
+      hz_(util::tsc::hz()),
+      start_tsc_(0),
+      end_tsc_(0),
+      last_tsc_(0),
+      receiving_(false) {
+  ul_.name  = "UL";
+  ul_.magic = TRAFFIC_PROBE_MAGIC_UL;
+  ul_.rate  = opt.ul_rate;
+  dl_.name  = "DL";
+  dl_.magic = TRAFFIC_PROBE_MAGIC_DL;
+  dl_.rate  = opt.dl_rate;
+}
+//------------------------------------------------------------------------------
+traffic::~traffic() {
+  receiving_.store(false);
+  for (auto d : {&ul_, &dl_}) {
+    for (auto& w : d->senders) {
+      if (w->thread.joinable()) w->thread.join();
+      close(w->sd);
+    }
+    for (auto& w : d->receivers) {
+      if (w->thread.joinable()) w->thread.join();
+      close(w->sd);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+bool traffic::open(
+    direction_t& d, const std::string& tx_netns, const struct in_addr& tx_addr,
+    const std::string& rx_netns, const struct in_addr& rx_addr,
+    const uint16_t rx_port) {
+  if (not d.rate) return true;
+  std::vector<uint32_t> established = {};
+  for (uint32_t i = 0; i < sessions_.size(); i++) {
+    if (sessions_[i].established) established.push_back(i);
+  }
+  const uint32_t num_senders =
+      std::min(opt_.tx_threads, (uint32_t) established.size());
+  for (uint32_t t = 0; t < num_senders; t++) {
+    std::unique_ptr<worker_t> w(new worker_t());
+    w->sd = netns_udp_socket(tx_netns, tx_addr, 0, false);
+    if (w->sd < 0) return false;
+    for (uint32_t i = t; i < established.size(); i += num_senders) {
+      w->sessions.push_back(established[i]);
+    }
+    d.senders.push_back(std::move(w));
+  }
+  struct timeval tv = {.tv_sec  = 0,
+                       .tv_usec = TRAFFIC_RECV_TIMEOUT_MS * 1000};
+  for (uint32_t t = 0; t < opt_.rx_threads; t++) {
+    std::unique_ptr<worker_t> w(new worker_t());
+    w->sd = netns_udp_socket(rx_netns, rx_addr, rx_port, true);
+    if (w->sd < 0) return false;
+    setsockopt(w->sd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    d.receivers.push_back(std::move(w));
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+bool traffic::open() {
+  return open(
+             ul_, opt_.s1u_netns, opt_.enb_addr, opt_.sgi_netns,
+             opt_.sgi_addr, opt_.ul_port) &&
+         open(
+             dl_, opt_.sgi_netns, opt_.sgi_addr, opt_.s1u_netns,
+             opt_.enb_addr, TRAFFIC_GTPU_PORT);
+}
+//------------------------------------------------------------------------------
+void traffic::send(direction_t& d, worker_t& w) {
+  const bool ul          = (&d == &ul_);
+  const std::size_t n    = w.sessions.size();
+  const std::size_t size = opt_.packet_size;
+  // UL: GTP-U, IPv4, UDP headers then probe, prebuilt for each session.
+  // DL: probe only, the kernel adds the IPv4 and UDP headers.
+  const std::size_t headers =
+      ul ? TRAFFIC_GTPU_HEADER_SIZE + TRAFFIC_IPV4_UDP_HEADER_SIZE : 0;
+  const std::size_t length = ul ? TRAFFIC_GTPU_HEADER_SIZE + size :
+                                  size - TRAFFIC_IPV4_UDP_HEADER_SIZE;
+  std::vector<char> templates(n * headers);
+  std::vector<struct sockaddr_in> dests(n);
+  for (std::size_t i = 0; i < n; i++) {
+    const session_t& s  = sessions_[w.sessions[i]];
+    dests[i].sin_family = AF_INET;
+    dests[i].sin_addr   = ul ? s.sgw_ipv4 : s.ue_ipv4;
+    dests[i].sin_port   = htons(ul ? TRAFFIC_GTPU_PORT : opt_.dl_port);
+    if (not ul) continue;
+    char* p              = &templates[i * headers];
+    struct gtpuhdr* gtpu = (struct gtpuhdr*) p;
+    struct iphdr* ip     = (struct iphdr*) (p + TRAFFIC_GTPU_HEADER_SIZE);
+    struct udphdr* udp   = (struct udphdr*) (ip + 1);
+    gtpu->version        = 1;
+    gtpu->pt             = 1;
+    gtpu->message_type   = GTPU_G_PDU;
+    gtpu->message_length = htons(size);
+    gtpu->teid           = htonl(s.sgw_teid);
+    ip->version          = 4;
+    ip->ihl              = sizeof(struct iphdr) / 4;
+    ip->tot_len          = htons(size);
+    ip->frag_off         = htons(IP_DF);
+    ip->ttl              = 64;
+    ip->protocol         = IPPROTO_UDP;
+    ip->saddr            = s.ue_ipv4.s_addr;
+    ip->daddr            = opt_.sgi_addr.s_addr;
+    ip->check            = ipv4_checksum(ip);
+    udp->source          = htons(opt_.dl_port);
+    udp->dest            = htons(opt_.ul_port);
+    udp->len             = htons(size - sizeof(struct iphdr));
+  }
+
+  const uint32_t batch = opt_.batch;
+  std::vector<char> buffer(batch * length, 0);
+  std::vector<struct iovec> iov(batch);
+  std::vector<struct mmsghdr> msgs(batch);
+  for (uint32_t k = 0; k < batch; k++) {
+    iov[k].iov_base                = &buffer[k * length];
+    iov[k].iov_len                 = length;
+    msgs[k].msg_hdr.msg_iov        = &iov[k];
+    msgs[k].msg_hdr.msg_iovlen     = 1;
+    msgs[k].msg_hdr.msg_namelen    = sizeof(struct sockaddr_in);
+    msgs[k].msg_hdr.msg_control    = nullptr;
+    msgs[k].msg_hdr.msg_controllen = 0;
+  }
+
+  // Share of the rate of this thread, a batch is sent every batch_ticks. A
+  // late sender catches up for 1 ms at most.
+  const double rate        = (double) d.rate / d.senders.size();
+  const double batch_ticks = batch * (double) hz_ / rate;
+  const double max_lag     = hz_ / 1000.0;
+  const uint64_t spin      = hz_ / 10000;
+  double deadline          = (double) util::tsc::now();
+  std::size_t next         = 0;
+  uint64_t sequence        = 0;
+  counters_t& c            = w.counters;
+  while (not stop_.load(std::memory_order_relaxed)) {
+    uint64_t now = util::tsc::now();
+    if (now >= end_tsc_) break;
+    if ((double) now < deadline) {
+      const uint64_t wait = (uint64_t)(deadline - now);
+      if (wait > spin) {
+        std::this_thread::sleep_for(
+            std::chrono::nanoseconds((wait - spin / 2) * 1000000000 / hz_));
+      }
+      continue;
+    }
+    if ((double) now - deadline > max_lag) deadline = (double) now;
+    deadline += batch_ticks;
+
+    probe_t probe = {
+        .magic = d.magic, .session = 0, .sequence = 0, .tx_tsc = now};
+    for (uint32_t k = 0; k < batch; k++) {
+      const std::size_t i = next;
+      next                = (next + 1 == n) ? 0 : next + 1;
+      char* p             = &buffer[k * length];
+      if (ul) memcpy(p, &templates[i * headers], headers);
+      probe.session  = w.sessions[i];
+      probe.sequence = sequence++;
+      memcpy(p + headers, &probe, sizeof(probe));
+      msgs[k].msg_hdr.msg_name = &dests[i];
+    }
+    const int sent = sendmmsg(w.sd, &msgs[0], batch, 0);
+    if (sent < 0) {
+      add(c.errors, 1);
+      continue;
+    }
+    add(c.packets, sent);
+    if (now >= start_tsc_) {
+      add(c.measured, sent);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+void traffic::receive(direction_t& d, worker_t& w) {
+  // DL: G-PDUs from the SPGW-U. UL: UDP payloads, the IPv4 and UDP headers
+  // were removed by the kernel.
+  const bool dl        = (&d == &dl_);
+  const uint32_t batch = opt_.batch;
+  std::vector<char> buffer(batch * TRAFFIC_RECV_BUFFER_SIZE);
+  std::vector<struct iovec> iov(batch);
+  std::vector<struct mmsghdr> msgs(batch);
+  for (uint32_t k = 0; k < batch; k++) {
+    iov[k].iov_base            = &buffer[k * TRAFFIC_RECV_BUFFER_SIZE];
+    iov[k].iov_len             = TRAFFIC_RECV_BUFFER_SIZE;
+    msgs[k].msg_hdr.msg_iov    = &iov[k];
+    msgs[k].msg_hdr.msg_iovlen = 1;
+  }
+  counters_t& c = w.counters;
+  while (receiving_.load(std::memory_order_relaxed)) {
+    const int received =
+        recvmmsg(w.sd, &msgs[0], batch, MSG_WAITFORONE, nullptr);
+    if (received <= 0) continue;
+    const uint64_t now     = util::tsc::now();
+    uint64_t measured      = 0;
+    uint64_t measured_size = 0;
+    uint64_t errors        = 0;
+    for (int k = 0; k < received; k++) {
+      const char* p   = &buffer[k * TRAFFIC_RECV_BUFFER_SIZE];
+      std::size_t len = msgs[k].msg_len;
+      // Size of the UE IP packet
+      std::size_t ip_len = len + TRAFFIC_IPV4_UDP_HEADER_SIZE;
+      if (dl) {
+        const std::size_t offset = gtpu_payload_offset(p, len);
+        const struct iphdr* ip   = (const struct iphdr*) (p + offset);
+        if ((not offset) || (offset + TRAFFIC_IPV4_UDP_HEADER_SIZE > len) ||
+            (ip->version != 4) ||
+            (offset + ip->ihl * 4 + sizeof(struct udphdr) > len)) {
+          errors++;
+          continue;
+        }
+        ip_len = len - offset;
+        p += offset + ip->ihl * 4 + sizeof(struct udphdr);
+        len -= offset + ip->ihl * 4 + sizeof(struct udphdr);
+      }
+      probe_t probe = {};
+      if (len < sizeof(probe)) {
+        errors++;
+        continue;
+      }
+      memcpy(&probe, p, sizeof(probe));
+      if (probe.magic != d.magic) {
+        errors++;
+        continue;
+      }
+      if ((probe.tx_tsc >= start_tsc_) && (probe.tx_tsc < end_tsc_)) {
+        measured++;
+        measured_size += ip_len;
+        w.latency.record(now > probe.tx_tsc ? now - probe.tx_tsc : 0);
+      }
+    }
+    add(c.packets, received);
+    add(c.measured, measured);
+    add(c.measured_bytes, measured_size);
+    add(c.errors, errors);
+  }
+}
+//------------------------------------------------------------------------------
+void traffic::sum(const direction_t& d, uint64_t& tx, uint64_t& rx) const {
+  tx = 0;
+  rx = 0;
+  for (const auto& w : d.senders) {
+    tx += w->counters.packets.load(std::memory_order_relaxed);
+  }
+  for (const auto& w : d.receivers) {
+    rx += w->counters.packets.load(std::memory_order_relaxed);
+  }
+}
+//------------------------------------------------------------------------------
+void traffic::run() {
+  const uint64_t now = util::tsc::now();
+  start_tsc_         = now + opt_.warmup_sec * hz_;
+  end_tsc_           = start_tsc_ + opt_.duration_sec * hz_;
+  receiving_.store(true);
+  for (auto d : {&ul_, &dl_}) {
+    for (auto& w : d->receivers) {
+      w->thread = std::thread(
+          &traffic::receive, this, std::ref(*d), std::ref(*w));
+    }
+    for (auto& w : d->senders) {
+      w->thread = std::thread(
+          &traffic::send, this, std::ref(*d), std::ref(*w));
+    }
+  }
+
+  auto last     = std::chrono::steady_clock::now();
+  const auto t0 = last;
+  uint64_t ul_tx = 0, ul_rx = 0, dl_tx = 0, dl_rx = 0;
+  while ((util::tsc::now() < end_tsc_) && (not stop_.load())) {
+    const auto next = last + std::chrono::seconds(opt_.interval_sec);
+    while ((std::chrono::steady_clock::now() < next) && (not stop_.load()) &&
+           (util::tsc::now() < end_tsc_)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const double interval =
+        std::max(std::chrono::duration<double>(now - last).count(), 0.001);
+    last = now;
+    uint64_t ul_tx2, ul_rx2, dl_tx2, dl_rx2;
+    sum(ul_, ul_tx2, ul_rx2);
+    sum(dl_, dl_tx2, dl_rx2);
+    std::cout << std::fixed << std::setprecision(1) << std::setw(7)
+              << std::chrono::duration<double>(now - t0).count()
+              << " s  UL tx " << std::setw(9)
+              << (uint64_t)((ul_tx2 - ul_tx) / interval) << " pps rx "
+              << std::setw(9) << (uint64_t)((ul_rx2 - ul_rx) / interval)
+              << " pps  DL tx " << std::setw(9)
+              << (uint64_t)((dl_tx2 - dl_tx) / interval) << " pps rx "
+              << std::setw(9) << (uint64_t)((dl_rx2 - dl_rx) / interval)
+              << " pps" << (util::tsc::now() < start_tsc_ ? "  (warmup)" : "")
+              << std::endl;
+    ul_tx = ul_tx2;
+    ul_rx = ul_rx2;
+    dl_tx = dl_tx2;
+    dl_rx = dl_rx2;
+  }
+
+  for (auto d : {&ul_, &dl_}) {
+    for (auto& w : d->senders) {
+      if (w->thread.joinable()) w->thread.join();
+    }
+  }
+  // Stopped before the end, only what was sent is measured
+  last_tsc_ = std::min(end_tsc_, std::max(util::tsc::now(), start_tsc_));
+  std::this_thread::sleep_for(std::chrono::milliseconds(opt_.drain_ms));
+  receiving_.store(false);
+  for (auto d : {&ul_, &dl_}) {
+    for (auto& w : d->receivers) {
+      if (w->thread.joinable()) w->thread.join();
+    }
+  }
+}
+//------------------------------------------------------------------------------
+void traffic::results(direction_t& d, direction_results_t& r) const {
+  util::latency_histogram latency;
+  r = {};
+  for (const auto& w : d.senders) {
+    r.tx_packets += w->counters.measured.load();
+  }
+  for (const auto& w : d.receivers) {
+    r.rx_packets += w->counters.measured.load();
+    r.rx_bytes += w->counters.measured_bytes.load();
+    latency.merge(w->latency);
+  }
+  const double us_per_tick = 1000000.0 / hz_;
+  r.p50_us                 = latency.percentile(50) * us_per_tick;
+  r.p99_us                 = latency.percentile(99) * us_per_tick;
+  r.p999_us                = latency.percentile(99.9) * us_per_tick;
+  r.max_us                 = latency.max() * us_per_tick;
+}
+//------------------------------------------------------------------------------
+void traffic::write_csv(
+    const direction_results_t& ul, const direction_results_t& dl) const {
+  std::ifstream exists(opt_.csv_file);
+  const bool header = (not exists.good()) || (exists.peek() == EOF);
+  exists.close();
+  std::ofstream csv(opt_.csv_file, std::ios::app);
+  if (not csv.good()) {
+    Logger::system().error("Cannot write %s", opt_.csv_file.c_str());
+    return;
+  }
+  if (header) {
+    csv << "label,time,sessions,packet_size,duration_s";
+    for (auto name : {"ul", "dl"}) {
+      csv << "," << name << "_rate," << name << "_tx," << name << "_rx,"
+          << name << "_loss_pct," << name << "_pps," << name << "_gbps,"
+          << name << "_p50_us," << name << "_p99_us," << name << "_p999_us,"
+          << name << "_max_us";
+    }
+    csv << std::endl;
+  }
+  const double duration = (double) (last_tsc_ - start_tsc_) / hz_;
+  const std::time_t now = std::time(nullptr);
+  char time[32];
+  std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  csv << opt_.label << "," << time << "," << opt_.sessions << ","
+      << opt_.packet_size << "," << std::fixed << std::setprecision(3)
+      << duration;
+  for (auto r : {std::make_pair(opt_.ul_rate, &ul),
+                 std::make_pair(opt_.dl_rate, &dl)}) {
+    const direction_results_t& d = *r.second;
+    const double loss =
+        d.tx_packets ? 100.0 * ((double) d.tx_packets - d.rx_packets) /
+                           d.tx_packets
+                     : 0;
+    csv << "," << r.first << "," << d.tx_packets << "," << d.rx_packets << ","
+        << loss << "," << (duration > 0 ? d.rx_packets / duration : 0) << ","
+        << (duration > 0 ? d.rx_bytes * 8 / duration / 1e9 : 0) << ","
+        << d.p50_us << "," << d.p99_us << "," << d.p999_us << "," << d.max_us;
+  }
+  csv << std::endl;
+}
+//------------------------------------------------------------------------------
+void traffic::report() {
+  direction_results_t ul = {};
+  direction_results_t dl = {};
+  results(ul_, ul);
+  results(dl_, dl);
+  const double duration = (double) (last_tsc_ - start_tsc_) / hz_;
+  for (auto r : {std::make_pair(&ul_, &ul), std::make_pair(&dl_, &dl)}) {
+    const direction_results_t& d = *r.second;
+    if (not r.first->rate) continue;
+    const double loss =
+        d.tx_packets ? 100.0 * ((double) d.tx_packets - d.rx_packets) /
+                           d.tx_packets
+                     : 0;
+    uint64_t errors = 0;
+    for (const auto& w : r.first->senders) errors += w->counters.errors.load();
+    for (const auto& w : r.first->receivers) {
+      errors += w->counters.errors.load();
+    }
+    std::cout << std::fixed << std::setprecision(3) << r.first->name
+              << ": sent " << d.tx_packets << " received " << d.rx_packets
+              << " loss " << loss << "% errors " << errors << std::endl
+              << r.first->name << ": "
+              << (duration > 0 ? (uint64_t)(d.rx_packets / duration) : 0)
+              << " pps "
+              << (duration > 0 ? d.rx_bytes * 8 / duration / 1e9 : 0)
+              << " Gbit/s" << std::setprecision(1) << "  latency us p50 "
+              << d.p50_us << " p99 " << d.p99_us << " p99.9 " << d.p999_us
+              << " max " << d.max_us << std::endl;
+  }
+  if (not opt_.csv_file.empty()) write_csv(ul, dl);
+}
@@ -0,0 +1,145 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file traffic.hpp
+  \brief GTP-U and SGi traffic of the load generator, measured
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_TRAFFIC_HPP_SEEN
+#define FILE_TRAFFIC_HPP_SEEN
+
+#include "latency_histogram.hpp"
+#include "loadgen_options.hpp"
+#include "sx_peer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace loadgen {
+
+#define TRAFFIC_PROBE_MAGIC_UL 0x4c47554c
+#define TRAFFIC_PROBE_MAGIC_DL 0x4c47444c
+
+// First bytes of the UDP payload of every packet sent, in host byte order:
+// sender and receivers are the same process
+typedef struct probe_s {
+  uint32_t magic;
+  uint32_t session;
+  uint64_t sequence;
+  // util::tsc::now() when sent
+  uint64_t tx_tsc;
+} probe_t;
+
+typedef struct direction_results_s {
+  uint64_t tx_packets;
+  uint64_t rx_packets;
+  // Of the UE IP packets
+  uint64_t rx_bytes;
+  // Latency in microseconds
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  double max_us;
+} direction_results_t;
+
+// UL: the eNBs send G-PDUs to the S1-U F-TEIDs of the sessions, the SGi
+// server receives the UE packets.
+// DL: the SGi server sends UDP packets to the UEs, the eNBs receive them as
+// G-PDUs.
+// Each sender thread paces its own share of the rate over its own share of
+// the sessions. The packets are measured if they are sent between the end of
+// the warmup and the end of the run: a packet not received before the end
+// of the drain is lost, the latency is the time between the sendmmsg and the
+// recvmmsg of the packet, on the CPU time stamp counter.
+class traffic {
+ private:
+  typedef struct alignas(64) counters_s {
+    std::atomic<uint64_t> packets;
+    std::atomic<uint64_t> measured;
+    std::atomic<uint64_t> measured_bytes;
+    std::atomic<uint64_t> errors;
+  } counters_t;
+
+  typedef struct worker_s {
+    int sd;
+    std::thread thread;
+    counters_t counters;
+    // Receivers only, read once the thread is joined
+    util::latency_histogram latency;
+    // Senders only, index of the sessions in sessions_
+    std::vector<uint32_t> sessions;
+  } worker_t;
+
+  typedef struct direction_s {
+    const char* name;
+    uint32_t magic;
+    uint64_t rate;
+    std::vector<std::unique_ptr<worker_t>> senders;
+    std::vector<std::unique_ptr<worker_t>> receivers;
+  } direction_t;
+
+  const loadgen_options& opt_;
+  const std::vector<session_t>& sessions_;
+  std::atomic<bool>& stop_;
+  direction_t ul_;
+  direction_t dl_;
+  uint64_t hz_;
+  // Packets sent in [start_tsc_, end_tsc_) are measured
+  uint64_t start_tsc_;
+  uint64_t end_tsc_;
+  // End of the measurement, before end_tsc_ if stopped
+  uint64_t last_tsc_;
+  std::atomic<bool> receiving_;
+
+  bool open(
+      direction_t& d, const std::string& tx_netns,
+      const struct in_addr& tx_addr, const std::string& rx_netns,
+      const struct in_addr& rx_addr, const uint16_t rx_port);
+  void send(direction_t& d, worker_t& w);
+  void receive(direction_t& d, worker_t& w);
+  void sum(const direction_t& d, uint64_t& tx, uint64_t& rx) const;
+  void results(direction_t& d, direction_results_t& r) const;
+  void write_csv(
+      const direction_results_t& ul, const direction_results_t& dl) const;
+
+ public:
+  traffic(
+      const loadgen_options& opt, const std::vector<session_t>& sessions,
+      std::atomic<bool>& stop);
+  traffic(const traffic&) = delete;
+  void operator=(const traffic&) = delete;
+  ~traffic();
+
+  bool open();
+  // Send and receive for warmup + duration + drain, report every interval
+  void run();
+  // Results of the run, also appended to the CSV file
+  void report();
+};
+
+}  // namespace loadgen
+
+#endif /* FILE_TRAFFIC_HPP_SEEN */
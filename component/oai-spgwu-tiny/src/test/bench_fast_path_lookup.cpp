@@ -0,0 +1,256 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_fast_path_lookup.cpp
+  \brief Per packet cost of the switch lookups, IPv4 against IPv6, for
+  IPv4v6 sessions as pfcp_session compiles them: DL by UE IPv4 address or
+  UE /64 prefix, UL by S1-U TEID with the UE source address checked, each
+  followed by the classification of the entry. 1 out of 8 UL IPv6 packets
+  has a source out of the UE prefix and must not match.
+  Usage: bench_fast_path_lookup [packets per run, default 10000000]
+  [sessions, default 100000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "fixed_hash_table.hpp"
+#include "pfcp_fast_path.hpp"
+#include "qsbr.hpp"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <linux/udp.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace pfcp;
+
+// Distinct packets replayed, over random sessions
+#define BENCH_NUM_PACKETS 4096
+#define BENCH_PACKET_SIZE 128
+#define BENCH_UE_IPV4_HBO 0x0C000000
+// 2001:db8::/32, one /64 per session
+#define BENCH_UE_IPV6_PREFIX 0x20010DB800000000ULL
+
+typedef util::fixed_hash_table<fast_path_entry> table_t;
+
+typedef struct bench_packet_s {
+  uint32_t teid;
+  // Session the packet belongs to, -1 if it must not match
+  int session;
+  uint8_t bytes[BENCH_PACKET_SIZE];
+} bench_packet_t;
+
+//------------------------------------------------------------------------------
+static struct in_addr ue_ipv4(const uint32_t session) {
+  struct in_addr a;
+  a.s_addr = htobe32(BENCH_UE_IPV4_HBO + session);
+  return a;
+}
+//------------------------------------------------------------------------------
+static struct in6_addr ue_ipv6(const uint32_t session, const uint64_t iid) {
+  struct in6_addr a;
+  const uint64_t prefix = htobe64(BENCH_UE_IPV6_PREFIX + session);
+  const uint64_t low    = htobe64(iid);
+  memcpy(a.s6_addr, &prefix, sizeof(prefix));
+  memcpy(a.s6_addr + 8, &low, sizeof(low));
+  return a;
+}
+//------------------------------------------------------------------------------
+// One PDR per entry, forwarding, with the UE addresses of an IPv4v6 PDN
+static fast_path_entry* build_entry(const uint32_t session, const bool ul) {
+  fast_path_entry* entry    = new fast_path_entry();
+  fast_path_rule_t rule     = {};
+  rule.precedence           = 255;
+  rule.pdr_id               = ul ? 1 : 2;
+  rule.match_ue_ipv4        = true;
+  rule.ue_ipv4              = ue_ipv4(session);
+  rule.match_ue_ipv6_prefix = true;
+  rule.ue_ipv6_prefix       = ue_ipv6(session, 0);
+  rule.uplink               = ul;
+  rule.action.forw          = true;
+  rule.action.destination_interface =
+      ul ? INTERFACE_VALUE_CORE : INTERFACE_VALUE_ACCESS;
+  entry->up_seid = session + 1;
+  entry->rules.push_back(rule);
+  sdf_filter_rule filter = {};
+  filter.set_ue_ipv4_if_any(rule.ue_ipv4);
+  entry->classifier.add(0, &filter);
+  sdf_filter_rule filter6 = {};
+  filter6.set_ue_ipv6_prefix_if_any(rule.ue_ipv6_prefix, 64);
+  entry->classifier.add6(0, &filter6);
+  return entry;
+}
+//------------------------------------------------------------------------------
+static void build_udp(uint8_t* const l4, const std::size_t len) {
+  struct udphdr* udp = (struct udphdr*) l4;
+  udp->source        = htobe16(2152);
+  udp->dest          = htobe16(5001);
+  udp->len           = htobe16(len);
+}
+//------------------------------------------------------------------------------
+static void build_packets(
+    const uint32_t num_sessions, const bool ipv6, const bool ul,
+    std::vector<bench_packet_t>& packets) {
+  std::mt19937 rng(num_sessions + 2 * ipv6 + ul);
+  struct in_addr server   = {};
+  struct in6_addr server6 = {};
+  inet_pton(AF_INET, "192.168.0.1", &server);
+  inet_pton(AF_INET6, "2001:db8:ffff::1", &server6);
+  packets.assign(BENCH_NUM_PACKETS, bench_packet_t());
+  for (auto& p : packets) {
+    const uint32_t s = rng() % num_sessions;
+    p.teid           = s + 1;
+    p.session        = s;
+    memset(p.bytes, 0, sizeof(p.bytes));
+    if (ipv6) {
+      struct ipv6hdr* ip6h = (struct ipv6hdr*) p.bytes;
+      ip6h->version        = 6;
+      ip6h->payload_len    = htobe16(BENCH_PACKET_SIZE - sizeof(*ip6h));
+      ip6h->nexthdr        = IPPROTO_UDP;
+      ip6h->hop_limit      = 64;
+      // The UE picks its interface identifier, a spoofing one its prefix too
+      const bool spoofed = ul && ((rng() % 8) == 0);
+      const uint32_t ue_session =
+          spoofed ? (s + 1 + rng() % (num_sessions - 1)) % num_sessions : s;
+      const struct in6_addr ue = ue_ipv6(ue_session, rng());
+      ip6h->saddr              = ul ? ue : server6;
+      ip6h->daddr              = ul ? server6 : ue;
+      if (spoofed) p.session = -1;
+      build_udp(
+          p.bytes + sizeof(*ip6h), BENCH_PACKET_SIZE - sizeof(*ip6h));
+    } else {
+      struct iphdr* iph = (struct iphdr*) p.bytes;
+      iph->version      = 4;
+      iph->ihl          = 5;
+      iph->tot_len      = htobe16(BENCH_PACKET_SIZE);
+      iph->ttl          = 64;
+      iph->protocol     = IPPROTO_UDP;
+      iph->saddr        = ul ? ue_ipv4(s).s_addr : server.s_addr;
+      iph->daddr        = ul ? server.s_addr : ue_ipv4(s).s_addr;
+      build_udp(p.bytes + sizeof(*iph), BENCH_PACKET_SIZE - sizeof(*iph));
+    }
+  }
+}
+//------------------------------------------------------------------------------
+// As pfcp_session_look_up_pack_in_core() and _in_access() up to the rule
+static const fast_path_rule_t* look_up(
+    const table_t& dl4, const table_t& dl6, const table_t& ul,
+    const bench_packet_t& p, const bool uplink) {
+  const struct iphdr* iph      = (const struct iphdr*) p.bytes;
+  const struct ipv6hdr* ip6h   = (const struct ipv6hdr*) p.bytes;
+  const fast_path_entry* entry = nullptr;
+  if (uplink) {
+    entry = ul.find(p.teid);
+  } else if (iph->version == 4) {
+    entry = dl4.find(be32toh(iph->daddr));
+  } else {
+    entry = dl6.find(fast_path_ipv6_prefix_key(ip6h->daddr));
+  }
+  if (not entry) return nullptr;
+  if (iph->version == 4) {
+    return entry->classify(iph, sizeof(p.bytes), uplink);
+  }
+  return entry->classify(ip6h, sizeof(p.bytes), uplink);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_packets =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10000000;
+  const uint32_t num_sessions =
+      (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100000;
+  if (num_sessions < 2) {
+    std::cout << "At least 2 sessions" << std::endl;
+    return EXIT_FAILURE;
+  }
+  util::qsbr& q = util::qsbr::get_instance();
+  q.register_thread();
+
+  table_t dl4(num_sessions);
+  table_t dl6(num_sessions);
+  table_t ul(num_sessions);
+  std::vector<std::unique_ptr<fast_path_entry>> entries = {};
+  for (uint32_t s = 0; s < num_sessions; s++) {
+    fast_path_entry* old = nullptr;
+    fast_path_entry* dl  = build_entry(s, false);
+    fast_path_entry* up  = build_entry(s, true);
+    entries.emplace_back(dl);
+    entries.emplace_back(up);
+    if ((not dl4.set(BENCH_UE_IPV4_HBO + s, dl, old)) ||
+        (not dl6.set(BENCH_UE_IPV6_PREFIX + s, dl, old)) ||
+        (not ul.set(s + 1, up, old))) {
+      std::cout << "Table full at " << s << " sessions" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << num_sessions << " IPv4v6 sessions, " << BENCH_PACKET_SIZE
+            << " byte packets" << std::endl;
+  double ns_ipv4 = 0;
+  for (const bool uplink : {false, true}) {
+    for (const bool ipv6 : {false, true}) {
+      std::vector<bench_packet_t> packets = {};
+      build_packets(num_sessions, ipv6, uplink, packets);
+      // Each packet matches the rule of its session, or nothing
+      uint64_t matched = 0;
+      for (const auto& p : packets) {
+        const fast_path_rule_t* rule = look_up(dl4, dl6, ul, p, uplink);
+        const fast_path_rule_t* expected =
+            (p.session < 0) ? nullptr :
+                              &entries[2 * p.session + uplink]->rules[0];
+        if (rule != expected) {
+          std::cout << (uplink ? "UL " : "DL ") << (ipv6 ? "IPv6" : "IPv4")
+                    << " packet of session " << p.session
+                    << " classified wrong" << std::endl;
+          return EXIT_FAILURE;
+        }
+        matched += (rule != nullptr);
+      }
+
+      uint64_t sum    = 0;
+      const auto from = std::chrono::steady_clock::now();
+      for (uint64_t n = 0; n < num_packets; n++) {
+        const fast_path_rule_t* rule =
+            look_up(dl4, dl6, ul, packets[n % BENCH_NUM_PACKETS], uplink);
+        if (rule) sum += rule->pdr_id;
+        // As a worker after each packet burst
+        if ((n & 63) == 0) q.quiescent_state();
+      }
+      const double seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - from)
+                                 .count();
+      const double ns = seconds * 1e9 / num_packets;
+      if (not ipv6) ns_ipv4 = ns;
+      std::cout << (uplink ? "UL " : "DL ") << (ipv6 ? "IPv6" : "IPv4")
+                << ", " << (100 * matched / BENCH_NUM_PACKETS)
+                << "% matched: " << (num_packets / seconds / 1e6)
+                << " Mpps, " << ns << " ns/packet";
+      if (ipv6) std::cout << ", x" << (ns / ns_ipv4) << " IPv4";
+      std::cout << " (checksum " << sum << ")" << std::endl;
+    }
+  }
+  q.unregister_thread();
+  return 0;
+}
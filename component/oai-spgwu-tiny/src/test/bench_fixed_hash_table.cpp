@@ -0,0 +1,161 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_fixed_hash_table.cpp
+  \brief Lookups per second of the switching tables: util::fixed_hash_table
+  against the folly::AtomicHashMap it replaced (created with
+  PFCP_SWITCH_MAX_PDRS entries and grown by insertions, with the entry
+  loaded with acquire as the workers did), by 1 and 4 reader threads
+  Usage: bench_fixed_hash_table [lookups per thread, default 10000000]
+  [entries, default 100000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "fixed_hash_table.hpp"
+#include "qsbr.hpp"
+
+#include <folly/AtomicHashMap.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace util;
+
+// Initial size of the AtomicHashMaps of the switch before the fixed tables
+#define BENCH_OLD_INITIAL_SIZE 128
+// Keys looked up, replayed, 1 out of 8 is not in the table
+#define BENCH_NUM_KEYS 65536
+
+typedef struct bench_entry_s {
+  uint64_t key;
+} bench_entry_t;
+
+typedef folly::AtomicHashMap<uint32_t, bench_entry_t*> old_table_t;
+
+//------------------------------------------------------------------------------
+static void build_keys(
+    const uint32_t num_entries, std::vector<uint32_t>& teids,
+    std::vector<uint32_t>& lookups) {
+  std::mt19937 rng(num_entries);
+  // Distinct TEIDs, 0 and the AtomicHashMap reserved keys excluded
+  std::unordered_set<uint32_t> used = {};
+  teids.clear();
+  while (teids.size() < num_entries) {
+    const uint32_t teid = 1 + (rng() % 0xFFFFFEFF);
+    if (used.insert(teid).second) teids.push_back(teid);
+  }
+  lookups.resize(BENCH_NUM_KEYS);
+  for (auto& k : lookups) {
+    k = ((rng() % 8) == 0) ? 0xFFFFFF00 + (rng() % 64) :
+                             teids[rng() % num_entries];
+  }
+}
+//------------------------------------------------------------------------------
+// Returns the lookups per second of all the threads
+template <class F>
+static double run_threads(
+    const int num_threads, const uint64_t num_lookups,
+    const std::vector<uint32_t>& lookups, F lookup) {
+  std::vector<std::thread> threads = {};
+  std::atomic<uint64_t> checksum(0);
+  const auto from = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    threads.push_back(std::thread([&, t]() {
+      qsbr& q = qsbr::get_instance();
+      q.register_thread();
+      uint64_t sum = 0;
+      for (uint64_t n = 0; n < num_lookups; n++) {
+        const bench_entry_t* e =
+            lookup(lookups[(n + t * 7919) % BENCH_NUM_KEYS]);
+        if (e) sum += e->key;
+        // As a worker after each packet burst
+        if ((n & 63) == 0) q.quiescent_state();
+      }
+      checksum += sum;
+      q.unregister_thread();
+    }));
+  }
+  for (auto& t : threads) t.join();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+  if (checksum.load() == 0) std::cout << "(no hit)" << std::endl;
+  return num_threads * num_lookups / seconds;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_lookups =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10000000;
+  const uint32_t num_entries =
+      (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100000;
+  std::vector<uint32_t> teids   = {};
+  std::vector<uint32_t> lookups = {};
+  build_keys(num_entries, teids, lookups);
+
+  std::vector<bench_entry_t> entries(num_entries);
+  fixed_hash_table<bench_entry_t> table(num_entries);
+  old_table_t old_table(BENCH_OLD_INITIAL_SIZE);
+  bench_entry_t* replaced = nullptr;
+  for (uint32_t i = 0; i < num_entries; i++) {
+    entries[i].key = teids[i];
+    table.set(teids[i], &entries[i], replaced);
+    old_table.insert(std::make_pair(teids[i], &entries[i]));
+  }
+
+  // Both tables must agree
+  for (const auto k : lookups) {
+    old_table_t::const_iterator it = old_table.find(k);
+    const bench_entry_t* expected =
+        (it == old_table.end()) ? nullptr : it->second;
+    if (table.find(k) != expected) {
+      std::cout << "Tables disagree on key " << k << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const int readers[] = {1, 4};
+  for (const int num_threads : readers) {
+    const double old_rate = run_threads(
+        num_threads, num_lookups, lookups,
+        [&old_table](const uint32_t k) -> const bench_entry_t* {
+          old_table_t::const_iterator it = old_table.find(k);
+          if (it == old_table.end()) return nullptr;
+          return __atomic_load_n(&it->second, __ATOMIC_ACQUIRE);
+        });
+    const double new_rate = run_threads(
+        num_threads, num_lookups, lookups,
+        [&table](const uint32_t k) -> const bench_entry_t* {
+          return table.find(k);
+        });
+    std::cout << num_entries << " entries, " << num_threads << " reader(s): "
+              << "AtomicHashMap " << (old_rate / 1e6) << " M lookups/s ("
+              << (num_threads * 1e9 / old_rate) << " ns/lookup), "
+              << "fixed_hash_table " << (new_rate / 1e6) << " M lookups/s ("
+              << (num_threads * 1e9 / new_rate) << " ns/lookup)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_pfcp_codec.cpp
+  \brief PFCP msgs/s and heap allocations per message, string stream decoding
+  into heap IEs and string stream encoding (as handle_receive() and
+  send_response() did) against in place decoding into arena IEs and encoding
+  into the send buffer
+  Usage: bench_pfcp_codec [messages, default 1000000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_test_msgs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+using namespace pfcp;
+
+// Larger than any of the messages, PFCP_MSG_MAX_SIZE is for the UDP socket
+#define BENCH_BUFFER_SIZE 4096
+
+// Every heap allocation of the process, the benchmark is single threaded
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (not p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { free(p); }
+
+typedef struct bench_result_s {
+  double msgs_per_s;
+  double allocs_per_msg;
+} bench_result_t;
+
+//------------------------------------------------------------------------------
+template <class F>
+static bench_result_t run(const uint64_t num_msgs, F one_msg) {
+  uint64_t checksum     = 0;
+  const uint64_t allocs = allocations.load();
+  const auto from       = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; n < num_msgs; n++) checksum += one_msg();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+  if (checksum == 0) std::cout << "(empty messages)" << std::endl;
+  return {num_msgs / seconds,
+          (double) (allocations.load() - allocs) / num_msgs};
+}
+//------------------------------------------------------------------------------
+static void print(
+    const char* what, const bench_result_t& before,
+    const bench_result_t& after) {
+  std::cout << "  " << what << (uint64_t) before.msgs_per_s << " -> "
+            << (uint64_t) after.msgs_per_s << " msgs/s, "
+            << before.allocs_per_msg << " -> " << after.allocs_per_msg
+            << " allocs/msg" << std::endl;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_msgs =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+  pfcp_session_establishment_request ser = {};
+  build_session_establishment_request(ser);
+  pfcp_msg request(ser);
+  request.set_sequence_number(1);
+  char recv_buffer[BENCH_BUFFER_SIZE];
+  const std::size_t size = request.dump_to(recv_buffer, sizeof(recv_buffer));
+
+  auto stream_decode = [&recv_buffer, size](pfcp_msg& msg) {
+    std::istringstream iss(std::istringstream::binary);
+    iss.rdbuf()->pubsetbuf(recv_buffer, size);
+    msg.load_from(iss);
+  };
+
+  const bench_result_t decode_before = run(num_msgs, [&]() {
+    pfcp_msg msg = {};
+    stream_decode(msg);
+    return msg.ies.size();
+  });
+  const bench_result_t decode_after = run(num_msgs, [&]() {
+    pfcp_msg msg = {};
+    msg.load_from(recv_buffer, size);
+    return msg.ies.size();
+  });
+
+  const bench_result_t core_before = run(num_msgs, [&]() {
+    pfcp_msg msg = {};
+    stream_decode(msg);
+    pfcp_session_establishment_request core = {};
+    msg.to_core_type(core);
+    return core.create_pdrs.size();
+  });
+  const bench_result_t core_after = run(num_msgs, [&]() {
+    pfcp_msg msg = {};
+    msg.load_from(recv_buffer, size);
+    pfcp_session_establishment_request core = {};
+    msg.to_core_type(core);
+    return core.create_pdrs.size();
+  });
+
+  pfcp_session_establishment_response sep = {};
+  build_session_establishment_response(sep);
+  const bench_result_t encode_before = run(num_msgs, [&]() {
+    pfcp_msg msg(sep);
+    msg.set_seid(0x0102030405060708);
+    std::ostringstream oss(std::ostringstream::binary);
+    msg.dump_to(oss);
+    std::string bstream = oss.str();
+    return bstream.length();
+  });
+  const bench_result_t encode_after = run(num_msgs, [&]() {
+    pfcp_arena::scope arena_scope;
+    pfcp_msg msg(sep);
+    msg.set_seid(0x0102030405060708);
+    char send_buffer[BENCH_BUFFER_SIZE];
+    return msg.dump_to(send_buffer, sizeof(send_buffer));
+  });
+
+  std::cout << "Session establishment request of " << size << " bytes, "
+            << num_msgs << " messages, before -> after:" << std::endl;
+  print("decode                 ", decode_before, decode_after);
+  print("decode + to_core_type  ", core_before, core_after);
+  print("encode response        ", encode_before, encode_after);
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_sdf_classifier.cpp
+  \brief Packets per second of the SDF classification of a UE (flow key
+  extraction and classifier lookup) with 1, 8 and 64 SDF filters
+  Usage: bench_sdf_classifier [packets per run, default 10000000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_sdf_filter.hpp"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+using namespace pfcp;
+
+// Distinct packets replayed, enough to defeat the branch predictor
+#define BENCH_NUM_PACKETS 4096
+#define BENCH_PACKET_SIZE 64
+
+//------------------------------------------------------------------------------
+// Filter i: UDP or TCP from a remote /16, /24 or /32 and one port or a small
+// range, so that 64 filters spread over a few tuples
+static std::string flow_description(const int i) {
+  const char* const prefix_lengths[] = {"/24", "/32", "/16"};
+  const std::string proto            = (i % 2) ? "17" : "6";
+  const std::string remote =
+      "10." + std::to_string(i) + ".7.9" + prefix_lengths[i % 3];
+  const std::string ports = (i % 4) ? std::to_string(1000 + i) :
+                                      std::to_string(1000 + i) + "-" +
+                                          std::to_string(1003 + i);
+  return "permit out " + proto + " from " + remote + " " + ports +
+         " to assigned";
+}
+//------------------------------------------------------------------------------
+// DL packets of the UE, 3 out of 4 match a random filter, the others none
+static void build_packets(
+    const int num_rules, std::vector<std::vector<uint8_t>>& packets) {
+  std::mt19937 rng(num_rules);
+  packets.assign(
+      BENCH_NUM_PACKETS, std::vector<uint8_t>(BENCH_PACKET_SIZE, 0));
+  for (auto& p : packets) {
+    const int i       = rng() % num_rules;
+    const bool hit    = (rng() % 4) != 0;
+    struct iphdr* iph = (struct iphdr*) p.data();
+    iph->version      = 4;
+    iph->ihl          = 5;
+    iph->tot_len      = htobe16(BENCH_PACKET_SIZE);
+    iph->protocol     = (i % 2) ? IPPROTO_UDP : IPPROTO_TCP;
+    iph->saddr        = htobe32((10 << 24) | (i << 16) | (7 << 8) | 9);
+    inet_pton(AF_INET, "12.1.1.2", &iph->daddr);
+    const uint16_t ports[2] = {
+        htobe16((hit) ? 1000 + i : 999), htobe16(30000 + rng() % 1000)};
+    memcpy(p.data() + 20, ports, sizeof(ports));
+  }
+}
+//------------------------------------------------------------------------------
+static void run(const int num_rules, const uint64_t num_packets) {
+  struct in_addr ue = {};
+  inet_pton(AF_INET, "12.1.1.2", &ue);
+  std::vector<sdf_filter_rule> rules(num_rules);
+  sdf_classifier classifier = {};
+  for (int i = 0; i < num_rules; i++) {
+    std::string error = {};
+    if (not rules[i].parse(flow_description(i), error)) {
+      std::cout << "Bad filter " << flow_description(i) << ": " << error
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    rules[i].set_ue_ipv4_if_any(ue);
+    classifier.add(i, &rules[i]);
+  }
+  std::vector<std::vector<uint8_t>> packets = {};
+  build_packets(num_rules, packets);
+
+  // The classifier must agree with a scan of the filters
+  uint64_t matched = 0;
+  for (const auto& p : packets) {
+    sdf_flow_key_t k = {};
+    sdf_flow_key_from_ipv4(
+        (const struct iphdr*) p.data(), p.size(), false, k);
+    int expected = -1;
+    for (int i = 0; i < num_rules; i++) {
+      if (rules[i].match(k)) {
+        expected = i;
+        break;
+      }
+    }
+    if (classifier.classify(k) != expected) {
+      std::cout << "Classifier and scan disagree with " << num_rules
+                << " filters" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    matched += (expected >= 0);
+  }
+
+  int64_t sum     = 0;
+  const auto from = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; n < num_packets; n++) {
+    const auto& p    = packets[n % BENCH_NUM_PACKETS];
+    sdf_flow_key_t k = {};
+    sdf_flow_key_from_ipv4(
+        (const struct iphdr*) p.data(), p.size(), false, k);
+    sum += classifier.classify(k);
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - from)
+                             .count();
+  std::cout << num_rules << " filters, "
+            << ((classifier.num_tuples()) ? "tuple space search" : "linear")
+            << " (" << classifier.num_tuples() << " tuples), "
+            << (100 * matched / BENCH_NUM_PACKETS) << "% matched: "
+            << (num_packets / seconds / 1e6) << " Mpps, "
+            << (seconds * 1e9 / num_packets) << " ns/packet"
+            << " (checksum " << sum << ")" << std::endl;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_packets =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10000000;
+  const int rules_per_ue[] = {1, 8, 64};
+  for (const int num_rules : rules_per_ue) {
+    run(num_rules, num_packets);
+  }
+  return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_timing_wheel.cpp
+  \brief ITTI timer arm, cancel and expire rates: the timers by id and
+  timing wheel of itti_mw against the std::set ordered by expiry it replaced,
+  whose removal scanned the set for the id. Timers run from 1 ms to 30 s as
+  the PFCP and GTPv2-C retransmission and heartbeat timers, half of them are
+  cancelled, the others expire. The timer thread, its lock and the time-out
+  messages are left out, they are the same for both.
+  Usage: bench_timing_wheel [timers, default 100000]
+  [cancels timed on the set, default 2000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "timing_wheel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#define BENCH_MAX_DELAY_TICKS 30000
+#define BENCH_NS_PER_TICK 1000000
+
+// itti_timer before the timing wheel: ordered on time_out only
+struct old_timer {
+  uint64_t id;
+  uint64_t time_out;
+  bool operator<(const old_timer& t) const { return time_out < t.time_out; }
+};
+
+// itti_timer with the timing wheel
+struct new_timer {
+  uint64_t id;
+  uint64_t expiry;
+  uint64_t wheel_timer;
+};
+
+//------------------------------------------------------------------------------
+static double seconds_since(
+    const std::chrono::steady_clock::time_point& from) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+      .count();
+}
+//------------------------------------------------------------------------------
+static void print_rate(const char* what, const double seconds, uint64_t n) {
+  std::cout << "  " << what << ": " << (seconds * 1e9 / n) << " ns/timer ("
+            << (n / seconds / 1e6) << " M/s)" << std::endl;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_timers =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 100000;
+  const uint64_t num_old_cancels = std::min(
+      num_timers / 2,
+      (argc > 2) ? (uint64_t) strtoull(argv[2], nullptr, 10) : 2000);
+  if ((num_timers < 2) || (num_old_cancels == 0)) {
+    std::cout << "At least 2 timers" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937_64 rng(num_timers);
+  std::vector<uint64_t> delays(num_timers);
+  for (auto& d : delays) d = 1 + rng() % BENCH_MAX_DELAY_TICKS;
+  // Every other timer is cancelled, in random order
+  std::vector<uint64_t> cancelled = {};
+  for (uint64_t id = 0; id < num_timers; id += 2) cancelled.push_back(id);
+  std::shuffle(cancelled.begin(), cancelled.end(), rng);
+
+  std::cout << num_timers << " timers, " << cancelled.size() << " cancelled"
+            << std::endl;
+
+  // std::set, time_out in ns as system_clock gave it
+  std::set<old_timer> old_timers = {};
+  auto from                      = std::chrono::steady_clock::now();
+  for (uint64_t id = 0; id < num_timers; id++) {
+    old_timers.insert(
+        {id, delays[id] * BENCH_NS_PER_TICK + rng() % BENCH_NS_PER_TICK});
+  }
+  const double old_arm_s = seconds_since(from);
+  // Timers lost to an equal time_out are not found, as timer_remove() did
+  uint64_t old_found = 0;
+  from               = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; n < num_old_cancels; n++) {
+    for (auto it = old_timers.begin(); it != old_timers.end(); ++it) {
+      if (it->id == cancelled[n]) {
+        old_timers.erase(it);
+        old_found++;
+        break;
+      }
+    }
+  }
+  const double old_cancel_s = seconds_since(from);
+  const uint64_t old_left   = old_timers.size();
+  uint64_t old_expired      = 0;
+  from                      = std::chrono::steady_clock::now();
+  for (uint64_t tick = 1; tick <= BENCH_MAX_DELAY_TICKS; tick++) {
+    while ((old_timers.size()) &&
+           (old_timers.begin()->time_out <= tick * BENCH_NS_PER_TICK)) {
+      old_timers.erase(old_timers.begin());
+      old_expired++;
+    }
+  }
+  const double old_expire_s = seconds_since(from);
+
+  // Timers by id and timing wheel, time in ticks
+  std::unordered_map<uint64_t, new_timer> new_timers = {};
+  util::timing_wheel wheel(0);
+  from = std::chrono::steady_clock::now();
+  for (uint64_t id = 0; id < num_timers; id++) {
+    new_timer t   = {id, delays[id], 0};
+    t.wheel_timer = wheel.start(t.expiry, t.id);
+    new_timers.insert(std::make_pair(t.id, t));
+  }
+  const double new_arm_s = seconds_since(from);
+  uint64_t new_found     = 0;
+  from                   = std::chrono::steady_clock::now();
+  for (auto id : cancelled) {
+    auto it = new_timers.find(id);
+    if (it != new_timers.end()) {
+      new_found += wheel.stop(it->second.wheel_timer);
+      new_timers.erase(it);
+    }
+  }
+  const double new_cancel_s = seconds_since(from);
+  std::vector<uint64_t> expired = {};
+  uint64_t new_expired          = 0;
+  bool on_time                  = true;
+  from                          = std::chrono::steady_clock::now();
+  for (uint64_t tick = 1; tick <= BENCH_MAX_DELAY_TICKS; tick++) {
+    wheel.advance(tick, expired);
+    for (auto id : expired) {
+      auto it = new_timers.find(id);
+      if (it == new_timers.end()) {
+        on_time = false;
+        continue;
+      }
+      on_time &= (it->second.expiry == tick);
+      new_timers.erase(it);
+      new_expired++;
+    }
+    expired.clear();
+  }
+  const double new_expire_s = seconds_since(from);
+
+  std::cout << "std::set, linear search on removal:" << std::endl;
+  print_rate("arm", old_arm_s, num_timers);
+  print_rate("cancel", old_cancel_s, num_old_cancels);
+  print_rate("expire", old_expire_s, old_left);
+  std::cout << "timers by id, timing wheel:" << std::endl;
+  print_rate("arm", new_arm_s, num_timers);
+  print_rate("cancel", new_cancel_s, cancelled.size());
+  print_rate("expire", new_expire_s, new_expired);
+  std::cout << "old: " << (num_timers - old_left - old_found)
+            << " timer(s) lost to an equal time_out, " << old_expired
+            << " expired" << std::endl;
+
+  if ((new_found != cancelled.size()) ||
+      (new_expired != num_timers - cancelled.size()) || (not on_time) ||
+      (wheel.size() != 0) || (new_timers.size() != 0)) {
+    std::cout << "Timing wheel: " << new_found << " cancelled, "
+              << new_expired << " expired, "
+              << (on_time ? "on time" : "not on time") << ", " << wheel.size()
+              << " left" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_uint_generator.cpp
+  \brief Id generators under contention of 16 threads: the mutex generator
+  (per session PDR/FAR ids) as reference, the block generator (SEIDs), the
+  bitmap generator (S1-U TEIDs, get and free with 64 ids held per thread)
+  and the transaction id singleton
+  Usage: bench_uint_generator [ids per thread, default 1000000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "uint_generator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace util;
+
+#define BENCH_THREADS 16
+#define BENCH_HELD_IDS 64
+
+//------------------------------------------------------------------------------
+// ns per id, all the threads start together
+template <class F>
+static double run(const uint64_t num_ids, F get_ids) {
+  std::vector<std::thread> threads = {};
+  std::atomic<int> ready(0);
+  std::atomic<bool> go(false);
+  std::atomic<uint64_t> checksum(0);
+  for (int t = 0; t < BENCH_THREADS; t++) {
+    threads.push_back(std::thread([&]() {
+      ready++;
+      while (not go.load()) std::this_thread::yield();
+      checksum += get_ids(num_ids);
+    }));
+  }
+  while (ready.load() < BENCH_THREADS) std::this_thread::yield();
+  const auto from = std::chrono::steady_clock::now();
+  go              = true;
+  for (auto& t : threads) t.join();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+          .count();
+  if (checksum.load() == 0) std::cout << "(no id)" << std::endl;
+  return seconds * 1e9 / (BENCH_THREADS * num_ids);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_ids =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+  uint_generator<uint64_t> locked;
+  const double locked_ns = run(num_ids, [&locked](const uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      const uint64_t id = locked.get_uid();
+      locked.free_uid(id);
+      sum += id;
+    }
+    return sum;
+  });
+
+  uint_block_generator<uint64_t> seids;
+  const double block_ns = run(num_ids, [&seids](const uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++) sum += seids.get_uid();
+    return sum;
+  });
+
+  // 24 bits of TEIDs as the S1-U, each thread keeps a few sessions open
+  uint_bitmap_generator<uint32_t> teids(24, 1);
+  const double bitmap_ns = run(num_ids, [&teids](const uint64_t n) {
+    uint32_t held[BENCH_HELD_IDS] = {};
+    uint64_t sum                  = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      uint32_t& slot = held[i % BENCH_HELD_IDS];
+      if (slot) teids.free_uid(slot);
+      slot = teids.get_uid();
+      sum += slot;
+    }
+    for (auto id : held) teids.free_uid(id);
+    return sum;
+  });
+
+  const double trxn_ns = run(num_ids, [](const uint64_t n) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      sum += uint_uid_generator<uint64_t>::get_instance().get_uid();
+    }
+    return sum;
+  });
+
+  std::cout << BENCH_THREADS << " threads, " << num_ids
+            << " ids per thread:" << std::endl
+            << "  mutex get+free   " << locked_ns << " ns/id" << std::endl
+            << "  SEID block       " << block_ns << " ns/id" << std::endl
+            << "  TEID bitmap      " << bitmap_ns << " ns/id (get+free)"
+            << std::endl
+            << "  transaction id   " << trxn_ns << " ns/id" << std::endl;
+  return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file bench_urr_counters.cpp
+  \brief URR counter overhead, CPU time per packet: packet workers all counting on the
+  same URR, with the per worker slots of urr_counters and, as reference, with
+  shared atomic counters. The usage read by the control path while the
+  workers count must add up to the packets counted.
+  Usage: bench_urr_counters [packets per worker, default 100000000]
+  [workers, default 4]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_urr.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace pfcp;
+
+// Packet sizes cycled through by the workers, UL and DL alternately
+static const uint16_t bench_packet_sizes[] = {64, 1400, 576, 1500, 40, 1200};
+#define BENCH_NUM_PACKET_SIZES \
+  (sizeof(bench_packet_sizes) / sizeof(bench_packet_sizes[0]))
+
+// What a URR without per worker slots would do
+typedef struct shared_counters_s {
+  std::atomic<uint64_t> ul_bytes;
+  std::atomic<uint64_t> ul_packets;
+  std::atomic<uint64_t> dl_bytes;
+  std::atomic<uint64_t> dl_packets;
+} shared_counters_t;
+
+//------------------------------------------------------------------------------
+static double thread_cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+//------------------------------------------------------------------------------
+// CPU ns per packet of the workers, whatever the number of cores. The
+// workers are registered in util::qsbr as the switch threads are. The control
+// path reads the usage while the workers count.
+template <class F>
+static double run(
+    const int num_workers, const uint64_t num_packets, F count_packet,
+    std::function<uint64_t()> read_packets, uint64_t& reads) {
+  std::vector<std::thread> workers = {};
+  std::atomic<int> ready(0);
+  std::atomic<int> done(0);
+  std::atomic<bool> go(false);
+  std::atomic<uint64_t> cpu_ns(0);
+  for (int w = 0; w < num_workers; w++) {
+    workers.push_back(std::thread([&]() {
+      util::qsbr::get_instance().register_thread();
+      ready++;
+      while (not go.load()) std::this_thread::yield();
+      const double from = thread_cpu_ns();
+      for (uint64_t n = 0; n < num_packets; n++) {
+        count_packet(
+            (n & 1) == 0, bench_packet_sizes[n % BENCH_NUM_PACKET_SIZES]);
+      }
+      cpu_ns += (uint64_t)(thread_cpu_ns() - from);
+      util::qsbr::get_instance().unregister_thread();
+      done++;
+    }));
+  }
+  while (ready.load() < num_workers) std::this_thread::yield();
+  go            = true;
+  uint64_t last = 0;
+  reads         = 0;
+  while (done.load() < num_workers) {
+    const uint64_t packets = read_packets();
+    if (packets < last) {
+      std::cout << "Usage went backwards" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    last = packets;
+    reads++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (auto& w : workers) w.join();
+  return (double) cpu_ns.load() / (num_packets * num_workers);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint64_t num_packets =
+      (argc > 1) ? strtoull(argv[1], nullptr, 10) : 100000000;
+  const int num_workers = (argc > 2) ? atoi(argv[2]) : 4;
+
+
+  uint64_t expected_bytes = 0;
+  for (uint64_t n = 0; n < num_packets; n++) {
+    expected_bytes += bench_packet_sizes[n % BENCH_NUM_PACKET_SIZES];
+  }
+  expected_bytes *= num_workers;
+  const uint64_t expected_packets = num_packets * num_workers;
+
+  // Packet loop alone, it registers the workers: the counters created next
+  // have a slot for each of them, the later runs reuse the same reader ids
+  uint64_t reads        = 0;
+  const double empty_ns = run(
+      num_workers, num_packets,
+      [](const bool uplink, const std::size_t num_bytes) {
+        asm volatile("" : : "r"(num_bytes) : "memory");
+      },
+      []() { return (uint64_t) 0; }, reads);
+
+  urr_counters counters;
+  const double slots_ns = run(
+      num_workers, num_packets,
+      [&counters](const bool uplink, const std::size_t num_bytes) {
+        counters.count(uplink, num_bytes);
+      },
+      [&counters]() {
+        urr_usage_t usage = {};
+        counters.read(usage);
+        return usage.ul_packets + usage.dl_packets;
+      },
+      reads);
+  const uint64_t slots_reads = reads;
+
+  shared_counters_t shared = {};
+  const double shared_ns   = run(
+      num_workers, num_packets,
+      [&shared](const bool uplink, const std::size_t num_bytes) {
+        if (uplink) {
+          shared.ul_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+          shared.ul_packets.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          shared.dl_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+          shared.dl_packets.fetch_add(1, std::memory_order_relaxed);
+        }
+      },
+      [&shared]() {
+        return shared.ul_packets.load(std::memory_order_relaxed) +
+               shared.dl_packets.load(std::memory_order_relaxed);
+      },
+      reads);
+
+  urr_usage_t usage = {};
+  counters.read(usage);
+  if ((usage.ul_packets + usage.dl_packets != expected_packets) ||
+      (usage.ul_bytes + usage.dl_bytes != expected_bytes) ||
+      (shared.ul_packets + shared.dl_packets != expected_packets) ||
+      (shared.ul_bytes + shared.dl_bytes != expected_bytes)) {
+    std::cout << "Usage does not match the packets counted" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << num_workers << " workers on one URR, " << num_packets
+            << " packets per worker, "
+            << std::thread::hardware_concurrency() << " CPUs:" << std::endl
+            << "  packet loop alone       " << empty_ns << " ns/packet"
+            << std::endl
+            << "  per worker slots        " << slots_ns << " ns/packet ("
+            << (slots_ns - empty_ns) << " ns of counting, " << slots_reads
+            << " reads)" << std::endl
+            << "  shared atomic counters  " << shared_ns << " ns/packet ("
+            << (shared_ns - empty_ns) << " ns of counting)" << std::endl;
+  return 0;
+}
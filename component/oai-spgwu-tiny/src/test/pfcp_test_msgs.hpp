@@ -0,0 +1,165 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pfcp_test_msgs.hpp
+  \brief Sx messages of an attach as the SPGW-C sends them, for the PFCP
+  codec test and benchmark
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#ifndef FILE_PFCP_TEST_MSGS_HPP_SEEN
+#define FILE_PFCP_TEST_MSGS_HPP_SEEN
+
+#include "3gpp_29.244.hpp"
+#include "msg_pfcp.hpp"
+
+#include <arpa/inet.h>
+
+//------------------------------------------------------------------------------
+// 2 PDRs (UL with local F-TEID, DL on the UE address), 2 FARs (the DL one
+// with an outer header), a volume URR and a QER
+inline void build_session_establishment_request(
+    pfcp::pfcp_session_establishment_request& ser) {
+  pfcp::node_id_t node_id = {};
+  node_id.node_id_type    = pfcp::NODE_ID_TYPE_IPV4_ADDRESS;
+  inet_pton(AF_INET, "192.168.160.100", &node_id.u1.ipv4_address);
+  ser.set(node_id);
+  pfcp::fseid_t cp_fseid = {};
+  cp_fseid.v4            = 1;
+  cp_fseid.seid          = 0x0102030405060708;
+  cp_fseid.ipv4_address  = node_id.u1.ipv4_address;
+  ser.set(cp_fseid);
+
+  pfcp::ue_ip_address_t ue_ip_address = {};
+  ue_ip_address.v4                    = 1;
+  inet_pton(AF_INET, "12.1.1.2", &ue_ip_address.ipv4_address);
+
+  for (uint16_t i = 1; i <= 2; i++) {
+    const bool ul = (i == 1);
+    pfcp::create_far create_far                           = {};
+    pfcp::far_id_t far_id                                 = {};
+    pfcp::apply_action_t apply_action                     = {};
+    pfcp::forwarding_parameters forwarding_parameters     = {};
+    pfcp::destination_interface_t destination_interface = {};
+    far_id.far_id                                         = i;
+    apply_action.forw                                     = 1;
+    destination_interface.interface_value =
+        (ul) ? pfcp::INTERFACE_VALUE_CORE : pfcp::INTERFACE_VALUE_ACCESS;
+    forwarding_parameters.set(destination_interface);
+    if (not ul) {
+      pfcp::outer_header_creation_t outer_header_creation = {};
+      outer_header_creation.outer_header_creation_description =
+          pfcp::OUTER_HEADER_CREATION_GTPU_UDP_IPV4;
+      outer_header_creation.teid = 0xA0000001;
+      inet_pton(
+          AF_INET, "192.168.248.120", &outer_header_creation.ipv4_address);
+      forwarding_parameters.set(outer_header_creation);
+    }
+    create_far.set(far_id);
+    create_far.set(apply_action);
+    create_far.set(forwarding_parameters);
+
+    pfcp::create_pdr create_pdr               = {};
+    pfcp::pdr_id_t pdr_id                     = {};
+    pfcp::precedence_t precedence             = {};
+    pfcp::pdi pdi                             = {};
+    pfcp::source_interface_t source_interface = {};
+    pdr_id.rule_id                            = i;
+    precedence.precedence                     = 255;
+    source_interface.interface_value =
+        (ul) ? pfcp::INTERFACE_VALUE_ACCESS : pfcp::INTERFACE_VALUE_CORE;
+    pdi.set(source_interface);
+    pdi.set(ue_ip_address);
+    if (ul) {
+      pfcp::fteid_t local_fteid = {};
+      local_fteid.ch            = 1;
+      pdi.set(local_fteid);
+    }
+    create_pdr.set(pdr_id);
+    create_pdr.set(precedence);
+    create_pdr.set(pdi);
+    if (ul) {
+      pfcp::outer_header_removal_t outer_header_removal = {};
+      outer_header_removal.outer_header_removal_description =
+          OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4;
+      create_pdr.set(outer_header_removal);
+    }
+    create_pdr.set(far_id);
+    ser.set(create_pdr);
+    ser.set(create_far);
+  }
+
+  pfcp::create_urr create_urr                 = {};
+  pfcp::urr_id_t urr_id                       = {};
+  pfcp::measurement_method_t measurement_method = {};
+  pfcp::reporting_triggers_t reporting_triggers = {};
+  urr_id.urr_id                               = 1;
+  measurement_method.volum                    = 1;
+  reporting_triggers.volth                    = 1;
+  create_urr.set(urr_id);
+  create_urr.set(measurement_method);
+  create_urr.set(reporting_triggers);
+  ser.set(create_urr);
+
+  pfcp::create_qer create_qer = {};
+  pfcp::qer_id_t qer_id       = {};
+  pfcp::gate_status_t gate_status = {};
+  pfcp::mbr_t mbr                 = {};
+  qer_id.qer_id                   = 1;
+  gate_status.ul_gate             = pfcp::OPEN;
+  gate_status.dl_gate             = pfcp::OPEN;
+  mbr.ul_mbr                      = 50000;
+  mbr.dl_mbr                      = 100000;
+  create_qer.set(qer_id);
+  create_qer.set(gate_status);
+  create_qer.set(mbr);
+  ser.set(create_qer);
+}
+//------------------------------------------------------------------------------
+// Accepted, with the S1-U F-TEID chosen by the SPGW-U
+inline void build_session_establishment_response(
+    pfcp::pfcp_session_establishment_response& sep) {
+  pfcp::node_id_t node_id = {};
+  node_id.node_id_type    = pfcp::NODE_ID_TYPE_IPV4_ADDRESS;
+  inet_pton(AF_INET, "192.168.160.101", &node_id.u1.ipv4_address);
+  sep.set(node_id);
+  pfcp::cause_t cause = {};
+  cause.cause_value   = pfcp::CAUSE_VALUE_REQUEST_ACCEPTED;
+  sep.set(cause);
+  pfcp::fseid_t up_fseid = {};
+  up_fseid.v4            = 1;
+  up_fseid.seid          = 0x1122334455667788;
+  up_fseid.ipv4_address  = node_id.u1.ipv4_address;
+  sep.set(up_fseid);
+  pfcp::created_pdr created_pdr = {};
+  pfcp::pdr_id_t pdr_id         = {};
+  pfcp::fteid_t local_fteid     = {};
+  pdr_id.rule_id                = 1;
+  local_fteid.v4                = 1;
+  local_fteid.teid              = 0x01000101;
+  inet_pton(AF_INET, "192.168.248.159", &local_fteid.ipv4_address);
+  created_pdr.set(pdr_id);
+  created_pdr.set(local_fteid);
+  sep.set(created_pdr);
+}
+
+#endif /* FILE_PFCP_TEST_MSGS_HPP_SEEN */
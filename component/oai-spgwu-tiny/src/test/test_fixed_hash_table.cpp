@@ -0,0 +1,246 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_fixed_hash_table.cpp
+  \brief Switching table: tombstones, compaction, and the retire of the
+  compacted arrays and of the erased values while util::qsbr readers look up
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "fixed_hash_table.hpp"
+#include "qsbr.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace util;
+
+#define TEST_READERS 4
+
+typedef struct test_value_s {
+  uint64_t key;
+  // Cleared by the deleter, a reader seeing it cleared read a freed value
+  std::atomic<bool> alive;
+} test_value_t;
+
+static std::atomic<int> failures(0);
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+static test_value_t* new_value(const uint64_t key) {
+  test_value_t* v = new test_value_t();
+  v->key          = key;
+  v->alive.store(true);
+  return v;
+}
+//------------------------------------------------------------------------------
+static void retire_value(test_value_t* v) {
+  if (v) {
+    qsbr::get_instance().retire([v]() {
+      v->alive.store(false);
+      delete v;
+    });
+  }
+}
+//------------------------------------------------------------------------------
+static void test_basic() {
+  fixed_hash_table<test_value_t> table(100);
+  check(table.capacity() == 256, "basic, capacity for a load factor 1/2");
+  test_value_t* old = nullptr;
+  std::vector<test_value_t*> values = {};
+  for (uint64_t k = 0; k < 100; k++) {
+    values.push_back(new_value(k));
+    check(table.set(k, values.back(), old), "basic, set");
+    check(old == nullptr, "basic, nothing replaced");
+  }
+  test_value_t* extra = new_value(100);
+  check(not table.set(100, extra, old), "basic, max_entries reached");
+  check(
+      not table.set(FIXED_HASH_TABLE_EMPTY_KEY, extra, old),
+      "basic, empty key reserved");
+  check(
+      not table.set(FIXED_HASH_TABLE_TOMBSTONE_KEY, extra, old),
+      "basic, tombstone key reserved");
+  check(table.set(7, extra, old), "basic, replace");
+  check((old == values[7]) && (table.find(7) == extra), "basic, replaced");
+  check(table.size() == 100, "basic, size after replace");
+  for (uint64_t k = 0; k < 100; k++) {
+    test_value_t* v = table.find(k);
+    check(v && (v->key == ((k == 7) ? 100 : k)), "basic, find");
+  }
+  check(table.find(1000) == nullptr, "basic, missing key");
+
+  // Tombstones are skipped by lookups and reused by insertions
+  check(table.erase(3) == values[3], "basic, erase");
+  check(table.erase(3) == nullptr, "basic, erase twice");
+  check(table.find(3) == nullptr, "basic, erased not found");
+  check(table.tombstones() == 1, "basic, one tombstone");
+  check(table.set(3, values[3], old), "basic, set again");
+  check(table.tombstones() == 0, "basic, tombstone reused");
+  check(table.find(3) == values[3], "basic, found again");
+  for (auto v : values) delete v;
+  delete extra;
+}
+//------------------------------------------------------------------------------
+static void test_compaction() {
+  // Churn of distinct keys: tombstones pile up until the table compacts
+  fixed_hash_table<test_value_t> table(64);
+  std::vector<test_value_t*> values = {};
+  test_value_t* old                 = nullptr;
+  for (uint64_t k = 0; k < 32; k++) {
+    values.push_back(new_value(k));
+    table.set(k, values.back(), old);
+  }
+  uint64_t next = 1000;
+  for (int n = 0; n < 1000; n++) {
+    test_value_t* v = new_value(next);
+    check(table.set(next, v, old), "compaction, set");
+    check(table.erase(next) == v, "compaction, erase");
+    delete v;
+    next += 7;
+    check(
+        4 * (table.size() + table.tombstones()) <= 3 * table.capacity(),
+        "compaction, 3/4 of the slots at most not empty");
+  }
+  check(table.compactions() > 0, "compaction, compacted");
+  check(table.size() == 32, "compaction, size");
+  for (uint64_t k = 0; k < 32; k++) {
+    check(table.find(k) == values[k], "compaction, live entries kept");
+  }
+  qsbr::get_instance().reclaim();
+  check(qsbr::get_instance().pending() == 0, "compaction, arrays freed");
+  for (auto v : values) delete v;
+}
+//------------------------------------------------------------------------------
+// One writer churns (insert, replace, erase) and compacts the table,
+// retiring the arrays and the values, while readers look up stable keys
+// (always present) and churned keys (present or not).
+static void test_concurrent_readers() {
+#define TEST_STABLE_KEYS 1000
+#define TEST_CHURN_KEYS 2000
+#define TEST_CHURN_BASE 1000000
+  // The new key is inserted before the oldest one is erased
+  fixed_hash_table<test_value_t> table(TEST_STABLE_KEYS + TEST_CHURN_KEYS + 1);
+  // Last churned key inserted, readers look up the keys up to it
+  std::atomic<uint64_t> next_key(TEST_CHURN_BASE);
+  test_value_t* old = nullptr;
+  for (uint64_t k = 0; k < TEST_STABLE_KEYS; k++) {
+    table.set(k, new_value(k), old);
+  }
+  std::atomic<bool> running(true);
+  std::atomic<uint64_t> lookups(0);
+  std::vector<std::thread> readers = {};
+  for (int r = 0; r < TEST_READERS; r++) {
+    readers.push_back(std::thread([&, r]() {
+      qsbr& q = qsbr::get_instance();
+      check(q.register_thread(), "concurrent, reader registered");
+      std::mt19937_64 rng(r);
+      uint64_t n = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 256; i++, n++) {
+          const uint64_t stable = rng() % TEST_STABLE_KEYS;
+          test_value_t* v       = table.find(stable);
+          if ((not v) || (v->key != stable) || (not v->alive.load())) {
+            check(false, "concurrent, stable key " + std::to_string(stable));
+          }
+          const uint64_t churn =
+              TEST_CHURN_BASE + rng() % (next_key.load() - TEST_CHURN_BASE + 1);
+          v = table.find(churn);
+          if ((v) && ((v->key != churn) || (not v->alive.load()))) {
+            check(false, "concurrent, churned key " + std::to_string(churn));
+          }
+        }
+        q.quiescent_state();
+        // Sometimes offline, as a worker blocked in a system call
+        if ((n & 0xFFFF) == 0) {
+          q.thread_offline();
+          std::this_thread::yield();
+          q.thread_online();
+        }
+      }
+      lookups += n;
+      q.unregister_thread();
+    }));
+  }
+
+  // Sliding window of churned keys: the new key is inserted, the oldest one
+  // erased and a random one of the window replaced, the tombstones left by
+  // distinct keys pile up and the table compacts
+  std::mt19937_64 rng(42);
+  const auto until =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+  uint64_t ops = 0;
+  while (std::chrono::steady_clock::now() < until) {
+    for (int i = 0; i < 1000; i++, ops++) {
+      const uint64_t k = next_key.load() + 1;
+      if (not table.set(k, new_value(k), old)) {
+        check(false, "concurrent, set " + std::to_string(k));
+      }
+      next_key = k;
+      if (k >= TEST_CHURN_BASE + TEST_CHURN_KEYS) {
+        retire_value(table.erase(k - TEST_CHURN_KEYS));
+        const uint64_t r = k - rng() % TEST_CHURN_KEYS;
+        if (table.set(r, new_value(r), old)) {
+          retire_value(old);
+        }
+      }
+    }
+    qsbr::get_instance().reclaim();
+  }
+  running = false;
+  for (auto& t : readers) t.join();
+  check(table.compactions() > 0, "concurrent, compacted");
+  for (uint64_t k = 0; k < TEST_STABLE_KEYS; k++) {
+    retire_value(table.erase(k));
+  }
+  for (uint64_t k = TEST_CHURN_BASE; k <= next_key.load(); k++) {
+    retire_value(table.erase(k));
+  }
+  check(table.size() == 0, "concurrent, all erased");
+  qsbr::get_instance().reclaim();
+  check(qsbr::get_instance().pending() == 0, "concurrent, all freed");
+  std::cout << ops << " writes, " << table.compactions() << " compactions, "
+            << lookups.load() << " lookups by " << TEST_READERS << " readers"
+            << std::endl;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  test_basic();
+  test_compaction();
+  test_concurrent_readers();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_fixed_hash_table passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_pfcp_codec.cpp
+  \brief PFCP codec round trip: a message decoded in place into arena IEs
+  has the same IEs as one decoded from a string stream into heap IEs, and
+  encoding into a send buffer gives the bytes of the string stream encoding
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "logger.hpp"
+#include "pfcp_test_msgs.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace pfcp;
+
+static int failures = 0;
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+// Encoding before the send buffer
+static std::string stream_encode(pfcp_msg& msg) {
+  std::ostringstream oss(std::ostringstream::binary);
+  msg.dump_to(oss);
+  return oss.str();
+}
+//------------------------------------------------------------------------------
+// Decoding before the arena: copy in a string stream, IEs from the heap
+static void stream_decode(const std::string& bytes, pfcp_msg& msg) {
+  std::istringstream iss(bytes);
+  msg.load_from(iss);
+}
+//------------------------------------------------------------------------------
+static std::string ie_bytes(const std::shared_ptr<pfcp_ie>& ie) {
+  std::ostringstream oss(std::ostringstream::binary);
+  ie->dump_to(oss);
+  return oss.str();
+}
+//------------------------------------------------------------------------------
+static bool same_ies(pfcp_msg& a, pfcp_msg& b) {
+  if ((a.get_message_type() != b.get_message_type()) ||
+      (a.get_message_length() != b.get_message_length()) ||
+      (a.get_seid() != b.get_seid()) ||
+      (a.get_sequence_number() != b.get_sequence_number()) ||
+      (a.ies.size() != b.ies.size())) {
+    return false;
+  }
+  for (size_t i = 0; i < a.ies.size(); i++) {
+    if ((a.ies[i]->tlv.get_type() != b.ies[i]->tlv.get_type()) ||
+        (a.ies[i]->tlv.get_length() != b.ies[i]->tlv.get_length()) ||
+        (ie_bytes(a.ies[i]) != ie_bytes(b.ies[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// Encoded both ways, decoded both ways, then the core type of each decoded
+// message is encoded again
+template <class CORE>
+static void test_round_trip(
+    const std::string& name, const CORE& ies, const uint64_t seid) {
+  pfcp_msg msg(ies);
+  msg.set_seid(seid);
+  msg.set_sequence_number(0x123456);
+  const std::string bytes = stream_encode(msg);
+  check(
+      bytes.size() == msg.get_message_length() + 4u,
+      name + ", length precomputed");
+
+  char buffer[4096];
+  const std::size_t size = msg.dump_to(buffer, sizeof(buffer));
+  check(
+      (size == bytes.size()) && (std::string(buffer, size) == bytes),
+      name + ", send buffer encoding");
+  check(
+      msg.dump_to(buffer, bytes.size() - 1) == 0,
+      name + ", send buffer too small");
+
+  pfcp_msg from_stream = {};
+  stream_decode(bytes, from_stream);
+  pfcp_msg in_place = {};
+  in_place.load_from(bytes.data(), bytes.size());
+  check(same_ies(from_stream, in_place), name + ", same IEs");
+  check(stream_encode(in_place) == bytes, name + ", in place re-encoded");
+
+  CORE core_from_stream = {};
+  from_stream.to_core_type(core_from_stream);
+  CORE core_in_place = {};
+  in_place.to_core_type(core_in_place);
+  pfcp_msg again_from_stream(core_from_stream);
+  pfcp_msg again_in_place(core_in_place);
+  again_from_stream.set_seid(seid);
+  again_in_place.set_seid(seid);
+  again_from_stream.set_sequence_number(0x123456);
+  again_in_place.set_sequence_number(0x123456);
+  check(
+      stream_encode(again_from_stream) == bytes,
+      name + ", core type from stream decoding re-encoded");
+  check(
+      stream_encode(again_in_place) == bytes,
+      name + ", core type from in place decoding re-encoded");
+}
+//------------------------------------------------------------------------------
+// Arena IEs outlive their scope, the next messages decoded by the thread and
+// the thread itself
+static void test_arena_lifetime() {
+  pfcp_session_establishment_request ser = {};
+  build_session_establishment_request(ser);
+  pfcp_msg msg(ser);
+  const std::string bytes = stream_encode(msg);
+
+  pfcp_msg first = {};
+  first.load_from(bytes.data(), bytes.size());
+  for (int i = 0; i < 1000; i++) {
+    pfcp_msg next = {};
+    next.load_from(bytes.data(), bytes.size());
+  }
+  check(stream_encode(first) == bytes, "arena, kept while others decoded");
+
+  // Decoded by a thread, released by another one, as an ITTI message
+  pfcp_msg* moved = new pfcp_msg();
+  std::thread decoder(
+      [&bytes, moved]() { moved->load_from(bytes.data(), bytes.size()); });
+  decoder.join();
+  check(stream_encode(*moved) == bytes, "arena, decoder thread gone");
+  std::thread releaser([moved]() { delete moved; });
+  releaser.join();
+
+  // More IEs than the arena holds: the rest comes from the heap
+  std::vector<pfcp_msg> many(PFCP_ARENA_SIZE / bytes.size() + 10);
+  for (auto& m : many) m.load_from(bytes.data(), bytes.size());
+  bool all_same = true;
+  for (auto& m : many) all_same &= (stream_encode(m) == bytes);
+  check(all_same, "arena, full, heap fallback");
+}
+//------------------------------------------------------------------------------
+static void test_malformed() {
+  pfcp_session_establishment_request ser = {};
+  build_session_establishment_request(ser);
+  pfcp_msg msg(ser);
+  msg.set_seid(1);
+  const std::string bytes = stream_encode(msg);
+  // Cut inside the last IE, and a length shorter than the IEs
+  for (const std::size_t cut : {bytes.size() - 3, (std::size_t) 20}) {
+    bool from_stream_thrown = false;
+    bool in_place_thrown    = false;
+    try {
+      pfcp_msg m = {};
+      stream_decode(bytes.substr(0, cut), m);
+    } catch (std::exception& e) {
+      from_stream_thrown = true;
+    }
+    try {
+      pfcp_msg m = {};
+      m.load_from(bytes.data(), cut);
+    } catch (std::exception& e) {
+      in_place_thrown = true;
+    }
+    check(
+        from_stream_thrown == in_place_thrown,
+        "malformed, same outcome cut at " + std::to_string(cut));
+    check(in_place_thrown, "malformed, rejected cut at " + std::to_string(cut));
+  }
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  // Malformed messages are logged, no sink
+  Logger::init("test_pfcp_codec", false, false);
+  pfcp_session_establishment_request ser = {};
+  build_session_establishment_request(ser);
+  test_round_trip("session establishment request", ser, 0);
+  pfcp_session_establishment_response sep = {};
+  build_session_establishment_response(sep);
+  test_round_trip("session establishment response", sep, 0x0102030405060708);
+  pfcp_heartbeat_request hbr = {};
+  recovery_time_stamp_t r    = {};
+  r.recovery_time_stamp      = 0xE0E0E0E0;
+  hbr.set(r);
+  test_round_trip("heartbeat request", hbr, 0);
+  test_arena_lifetime();
+  test_malformed();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_pfcp_codec passed" << std::endl;
+  return 0;
+}
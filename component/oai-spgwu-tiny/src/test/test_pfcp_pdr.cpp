@@ -0,0 +1,140 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*! \file test_pfcp_pdr.cpp
+  \brief Compilation of the UL PDRs into fast path rules, per S1-U transport
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "async_shell_cmd.hpp"
+#include "itti.hpp"
+#include "pfcp_pdr.hpp"
+#include "pfcp_switch.hpp"
+#include "spgwu_app.hpp"
+#include "spgwu_config.hpp"
+
+#include <arpa/inet.h>
+#include <boost/asio.hpp>
+#include <iostream>
+
+using namespace spgwu;
+using namespace util;
+
+// Referenced by the libraries, defined by main.cpp in the SPGW-U
+itti_mw* itti_inst                    = nullptr;
+async_shell_cmd* async_shell_cmd_inst = nullptr;
+pfcp_switch* pfcp_switch_inst         = nullptr;
+spgwu_app* spgwu_app_inst             = nullptr;
+spgwu_config spgwu_cfg;
+boost::asio::io_service io_service;
+
+static int failures = 0;
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const char* what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+static void set_ul_pdr(
+    pfcp::pfcp_pdr& pdr, const uint8_t outer_header_removal_description) {
+  pdr.pdr_id.rule_id                    = 1;
+  pdr.pdi.first                         = true;
+  pdr.pdi.second.source_interface.first = true;
+  pdr.pdi.second.source_interface.second.interface_value =
+      pfcp::INTERFACE_VALUE_ACCESS;
+  pdr.pdi.second.local_fteid.first       = true;
+  pdr.pdi.second.local_fteid.second      = {};
+  pdr.pdi.second.local_fteid.second.teid = 0x00000101;
+  pdr.pdi.second.ue_ip_address.first     = true;
+  pdr.pdi.second.ue_ip_address.second    = {};
+  pdr.pdi.second.ue_ip_address.second.v4 = 1;
+  inet_pton(
+      AF_INET, "12.1.1.2", &pdr.pdi.second.ue_ip_address.second.ipv4_address);
+  pdr.outer_header_removal.first = true;
+  pdr.outer_header_removal.second.outer_header_removal_description =
+      outer_header_removal_description;
+}
+//------------------------------------------------------------------------------
+static void test_ul_pdr_s1u_ipv4() {
+  pfcp::pfcp_pdr pdr(1);
+  set_ul_pdr(pdr, OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4);
+  pdr.pdi.second.local_fteid.second.v4 = 1;
+  inet_pton(
+      AF_INET, "192.168.248.159",
+      &pdr.pdi.second.local_fteid.second.ipv4_address);
+  pfcp::fast_path_rule_t rule = {};
+  check(pdr.compile(rule, true), "UL PDR, GTP-U/UDP/IPv4 S1-U compiled");
+  check(rule.uplink, "UL PDR, GTP-U/UDP/IPv4 S1-U rule is uplink");
+  check(rule.match_ue_ipv4, "UL PDR, GTP-U/UDP/IPv4 S1-U matches the UE");
+}
+//------------------------------------------------------------------------------
+static void test_ul_pdr_s1u_ipv6() {
+  pfcp::pfcp_pdr pdr(1);
+  set_ul_pdr(pdr, OUTER_HEADER_REMOVAL_GTPU_UDP_IPV6);
+  pdr.pdi.second.local_fteid.second.v6 = 1;
+  inet_pton(
+      AF_INET6, "2001:db8::159",
+      &pdr.pdi.second.local_fteid.second.ipv6_address);
+  pfcp::fast_path_rule_t rule = {};
+  check(pdr.compile(rule, true), "UL PDR, GTP-U/UDP/IPv6 S1-U compiled");
+  check(rule.uplink, "UL PDR, GTP-U/UDP/IPv6 S1-U rule is uplink");
+  check(rule.match_ue_ipv4, "UL PDR, GTP-U/UDP/IPv6 S1-U matches the UE");
+  check(
+      rule.ue_ipv4.s_addr ==
+          pdr.pdi.second.ue_ip_address.second.ipv4_address.s_addr,
+      "UL PDR, GTP-U/UDP/IPv6 S1-U UE address");
+}
+//------------------------------------------------------------------------------
+static void test_ul_pdr_s1u_ip() {
+  pfcp::pfcp_pdr pdr(1);
+  set_ul_pdr(pdr, OUTER_HEADER_REMOVAL_GTPU_UDP_IP);
+  pdr.pdi.second.local_fteid.second.v6 = 1;
+  pfcp::fast_path_rule_t rule = {};
+  check(pdr.compile(rule, true), "UL PDR, GTP-U/UDP/IP S1-U compiled");
+}
+//------------------------------------------------------------------------------
+static void test_ul_pdr_not_gtpu() {
+  // Not a G-PDU, switched by the slow path
+  pfcp::pfcp_pdr pdr(1);
+  set_ul_pdr(pdr, OUTER_HEADER_REMOVAL_UDP_IPV6);
+  pfcp::fast_path_rule_t rule = {};
+  check(not pdr.compile(rule, true), "UL PDR, UDP/IPv6 not compiled");
+  pdr.outer_header_removal.first = false;
+  check(not pdr.compile(rule, true), "UL PDR, no outer header removal");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  test_ul_pdr_s1u_ipv4();
+  test_ul_pdr_s1u_ipv6();
+  test_ul_pdr_s1u_ip();
+  test_ul_pdr_not_gtpu();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_pfcp_pdr passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_sdf_classifier.cpp
+  \brief SDF filter classifier: precedence, linear to tuple space search
+  switch, port range expansion, packets without ports
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "pfcp_sdf_filter.hpp"
+
+#include <arpa/inet.h>
+#include <iostream>
+
+using namespace pfcp;
+
+static int failures = 0;
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+static sdf_filter_rule parse(const std::string& flow_description) {
+  sdf_filter_rule rule = {};
+  std::string error    = {};
+  check(
+      rule.parse(flow_description, error),
+      "parse \"" + flow_description + "\" " + error);
+  return rule;
+}
+//------------------------------------------------------------------------------
+static sdf_flow_key_t key(
+    const uint8_t proto, const char* remote, const uint16_t remote_port,
+    const char* ue, const uint16_t ue_port) {
+  sdf_flow_key_t k = {};
+  k.proto          = proto;
+  k.has_ports      = true;
+  inet_pton(AF_INET, remote, &k.remote_ipv4);
+  inet_pton(AF_INET, ue, &k.ue_ipv4);
+  k.remote_port = remote_port;
+  k.ue_port     = ue_port;
+  return k;
+}
+//------------------------------------------------------------------------------
+// First matching rule by a plain scan, what the classifier must return
+static int reference(
+    const std::vector<sdf_filter_rule>& rules, const sdf_flow_key_t& k) {
+  for (std::size_t i = 0; i < rules.size(); i++) {
+    if (rules[i].match(k)) return i;
+  }
+  return -1;
+}
+//------------------------------------------------------------------------------
+static void test_precedence() {
+  // Broad rules of higher precedence shadow specific rules added after them,
+  // in linear mode and in tuple space search mode
+  std::vector<sdf_filter_rule> rules = {};
+  rules.push_back(parse("permit out 6 from 10.0.0.0/8 to assigned 80"));
+  rules.push_back(parse("permit out 6 from 10.1.2.3 to assigned 80"));
+  rules.push_back(parse("permit out 17 from any to assigned"));
+  rules.push_back(parse("permit out 17 from 10.1.2.3 53 to assigned"));
+  rules.push_back(parse("permit out ip from 192.168.0.0/16 to assigned"));
+  const sdf_flow_key_t keys[] = {
+      key(IPPROTO_TCP, "10.1.2.3", 40000, "12.1.1.2", 80),
+      key(IPPROTO_TCP, "10.9.9.9", 40000, "12.1.1.2", 80),
+      key(IPPROTO_TCP, "10.1.2.3", 40000, "12.1.1.2", 443),
+      key(IPPROTO_UDP, "10.1.2.3", 53, "12.1.1.2", 5000),
+      key(IPPROTO_TCP, "192.168.1.1", 22, "12.1.1.2", 5000),
+      key(IPPROTO_ICMP, "192.168.1.1", 0, "12.1.1.2", 0)};
+  const int expected[] = {0, 0, -1, 2, 4, 4};
+
+  sdf_classifier linear = {};
+  for (std::size_t i = 0; i < rules.size(); i++) linear.add(i, &rules[i]);
+  check(linear.num_tuples() == 0, "precedence, linear mode");
+  for (std::size_t i = 0; i < sizeof(expected) / sizeof(int); i++) {
+    check(
+        linear.classify(keys[i]) == expected[i],
+        "precedence, linear mode, key " + std::to_string(i));
+  }
+
+  // Same rules padded with never matching ones to force the tuples
+  std::vector<sdf_filter_rule> padded = rules;
+  while (padded.size() <= SDF_CLASSIFIER_MAX_LINEAR_RULES) {
+    padded.push_back(parse("permit out 47 from 172.16.0.1 to assigned"));
+  }
+  sdf_classifier tuples = {};
+  for (std::size_t i = 0; i < padded.size(); i++) tuples.add(i, &padded[i]);
+  check(tuples.num_tuples() > 0, "precedence, tuple space search mode");
+  for (std::size_t i = 0; i < sizeof(expected) / sizeof(int); i++) {
+    check(
+        tuples.classify(keys[i]) == expected[i],
+        "precedence, tuple mode, key " + std::to_string(i));
+  }
+}
+//------------------------------------------------------------------------------
+static void test_linear_to_tuple_switch() {
+  std::vector<sdf_filter_rule> rules = {};
+  for (int i = 0; i <= SDF_CLASSIFIER_MAX_LINEAR_RULES; i++) {
+    rules.push_back(parse(
+        "permit out 17 from 10.0." + std::to_string(i) + ".0/24 to assigned " +
+        std::to_string(1000 + i)));
+  }
+  std::vector<sdf_flow_key_t> keys = {};
+  for (int i = 0; i <= SDF_CLASSIFIER_MAX_LINEAR_RULES + 1; i++) {
+    const std::string remote = "10.0." + std::to_string(i) + ".7";
+    keys.push_back(key(IPPROTO_UDP, remote.c_str(), 9, "12.1.1.2", 1000 + i));
+    keys.push_back(key(IPPROTO_UDP, remote.c_str(), 9, "12.1.1.2", 999));
+  }
+
+  sdf_classifier c = {};
+  for (int i = 0; i < SDF_CLASSIFIER_MAX_LINEAR_RULES; i++) {
+    c.add(i, &rules[i]);
+  }
+  check(c.num_tuples() == 0, "switch, linear up to the limit");
+  std::vector<sdf_filter_rule> added(
+      rules.begin(), rules.begin() + SDF_CLASSIFIER_MAX_LINEAR_RULES);
+  for (std::size_t k = 0; k < keys.size(); k++) {
+    check(
+        c.classify(keys[k]) == reference(added, keys[k]),
+        "switch, linear result, key " + std::to_string(k));
+  }
+
+  c.add(SDF_CLASSIFIER_MAX_LINEAR_RULES, &rules.back());
+  check(c.num_tuples() > 0, "switch, tuples past the limit");
+  for (std::size_t k = 0; k < keys.size(); k++) {
+    check(
+        c.classify(keys[k]) == reference(rules, keys[k]),
+        "switch, tuple result, key " + std::to_string(k));
+  }
+}
+//------------------------------------------------------------------------------
+static void test_port_ranges() {
+  std::vector<sdf_filter_rule> rules = {};
+  // Expanded into exact ports
+  rules.push_back(parse("permit out 17 from any 1000-1003 to assigned"));
+  // Too wide to be expanded, matched linearly
+  rules.push_back(parse("permit out 17 from any 2000-2999 to assigned"));
+  // Lists of ports and ranges
+  rules.push_back(parse("permit out 6 from any to assigned 80,443,8000-8001"));
+  while (rules.size() <= SDF_CLASSIFIER_MAX_LINEAR_RULES) {
+    rules.push_back(parse("permit out 47 from 172.16.0.1 to assigned"));
+  }
+  sdf_classifier c = {};
+  for (std::size_t i = 0; i < rules.size(); i++) c.add(i, &rules[i]);
+  check(c.num_tuples() > 0, "port ranges, tuple space search mode");
+
+  const struct {
+    uint8_t proto;
+    uint16_t remote_port;
+    uint16_t ue_port;
+    int expected;
+  } cases[] = {{IPPROTO_UDP, 999, 5000, -1},  {IPPROTO_UDP, 1000, 5000, 0},
+               {IPPROTO_UDP, 1003, 5000, 0},  {IPPROTO_UDP, 1004, 5000, -1},
+               {IPPROTO_UDP, 2000, 5000, 1},  {IPPROTO_UDP, 2500, 5000, 1},
+               {IPPROTO_UDP, 3000, 5000, -1}, {IPPROTO_TCP, 5000, 80, 2},
+               {IPPROTO_TCP, 5000, 443, 2},   {IPPROTO_TCP, 5000, 8001, 2},
+               {IPPROTO_TCP, 5000, 8002, -1}, {IPPROTO_TCP, 1000, 5000, -1}};
+  for (const auto& t : cases) {
+    const sdf_flow_key_t k =
+        key(t.proto, "10.1.2.3", t.remote_port, "12.1.1.2", t.ue_port);
+    check(
+        c.classify(k) == t.expected,
+        "port ranges, proto " + std::to_string(t.proto) + " ports " +
+            std::to_string(t.remote_port) + ">" + std::to_string(t.ue_port));
+    check(
+        c.classify(k) == reference(rules, k),
+        "port ranges, same as a scan, ports " + std::to_string(t.remote_port) +
+            ">" + std::to_string(t.ue_port));
+  }
+}
+//------------------------------------------------------------------------------
+static void test_no_ports() {
+  // Non first fragments and protocols without ports only match the rules
+  // that do not look at ports
+  std::vector<sdf_filter_rule> rules = {};
+  rules.push_back(parse("permit out 17 from any 53 to assigned"));
+  rules.push_back(parse("permit out 17 from any 1000-1003 to assigned"));
+  rules.push_back(parse("permit out 17 from any 2000-2999 to assigned"));
+  rules.push_back(parse("permit out 17 from 10.0.0.0/8 to assigned"));
+  while (rules.size() <= SDF_CLASSIFIER_MAX_LINEAR_RULES) {
+    rules.push_back(parse("permit out 47 from 172.16.0.1 to assigned"));
+  }
+  sdf_classifier linear = {};
+  for (int i = 0; i < 4; i++) linear.add(i, &rules[i]);
+  sdf_classifier tuples = {};
+  for (std::size_t i = 0; i < rules.size(); i++) tuples.add(i, &rules[i]);
+
+  const uint16_t ports[] = {53, 1001, 2500};
+  for (const uint16_t port : ports) {
+    sdf_flow_key_t k = key(IPPROTO_UDP, "10.1.2.3", port, "12.1.1.2", 5000);
+    check(
+        linear.classify(k) < 3, "no ports, first fragment matches on ports");
+    // Fragment: no ports parsed, the values left in the key are meaningless
+    k.has_ports = false;
+    check(linear.classify(k) == 3, "no ports, linear, fragment");
+    check(tuples.classify(k) == 3, "no ports, tuples, fragment");
+  }
+  sdf_flow_key_t k = key(IPPROTO_UDP, "11.1.2.3", 53, "12.1.1.2", 5000);
+  k.has_ports      = false;
+  check(linear.classify(k) == -1, "no ports, linear, no rule left");
+  check(tuples.classify(k) == -1, "no ports, tuples, no rule left");
+
+  // From a packet: second fragment of a UDP datagram
+  uint8_t packet[28] = {};
+  struct iphdr* iph  = (struct iphdr*) packet;
+  iph->version       = 4;
+  iph->ihl           = 5;
+  iph->protocol      = IPPROTO_UDP;
+  iph->frag_off      = htobe16(185);
+  inet_pton(AF_INET, "10.1.2.3", &iph->saddr);
+  inet_pton(AF_INET, "12.1.1.2", &iph->daddr);
+  packet[20] = 0;
+  packet[21] = 53;
+  sdf_flow_key_t f = {};
+  check(
+      sdf_flow_key_from_ipv4(iph, sizeof(packet), false, f),
+      "no ports, fragment key");
+  check(not f.has_ports, "no ports, fragment has no ports");
+  check(tuples.classify(f) == 3, "no ports, fragment classified");
+  iph->frag_off = 0;
+  check(
+      sdf_flow_key_from_ipv4(iph, sizeof(packet), false, f),
+      "no ports, first fragment key");
+  check(f.has_ports && (f.remote_port == 53), "no ports, first fragment port");
+  check(tuples.classify(f) == 0, "no ports, first fragment classified");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  test_precedence();
+  test_linear_to_tuple_switch();
+  test_port_ranges();
+  test_no_ports();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_sdf_classifier passed" << std::endl;
+  return 0;
+}
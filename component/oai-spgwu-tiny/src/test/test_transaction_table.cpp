@@ -0,0 +1,209 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_transaction_table.cpp
+  \brief Stress of the Sx/GTPv2-C transaction table: more than 100k
+  outstanding transactions inserted, answered and looked up by concurrent
+  threads, then retransmitted, given up and cleaned up by the timer thread
+  Usage: test_transaction_table [outstanding transactions, default 160000]
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "transaction_table.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace util;
+
+#define TEST_THREADS 8
+
+typedef struct test_proc_s {
+  uint32_t seq_num;
+  uint8_t retry_count;
+} test_proc_t;
+
+static std::atomic<int> failures(0);
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+static double elapsed_s(const std::chrono::steady_clock::time_point& from) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - from)
+      .count();
+}
+//------------------------------------------------------------------------------
+// Polls until cond holds, the timer thread may lag on a loaded machine
+template <class F>
+static bool wait_for(F cond, const int timeout_ms) {
+  const auto until =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (not cond()) {
+    if (std::chrono::steady_clock::now() > until) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+//------------------------------------------------------------------------------
+// Each thread inserts its share of transactions, the requests sent (even
+// sequence numbers) are retried, then answers every other one it inserted
+// and looks up the others, while the other threads do the same.
+static void test_concurrent(const uint32_t num_trxns) {
+  transaction_table<test_proc_t> table;
+  table.start(
+      60000, 3, [](const test_proc_t&) {}, [](const test_proc_t&) {},
+      []() {});
+
+  const uint32_t per_thread = num_trxns / TEST_THREADS;
+  std::vector<std::thread> threads = {};
+  const auto from                  = std::chrono::steady_clock::now();
+  for (int t = 0; t < TEST_THREADS; t++) {
+    threads.push_back(std::thread([&table, t, per_thread]() {
+      for (uint32_t i = 0; i < per_thread; i++) {
+        const uint32_t seq_num = i * TEST_THREADS + t;
+        const uint64_t trxn_id = ((uint64_t) t << 32) | i;
+        if (not table.insert(
+                seq_num, trxn_id, test_proc_t{seq_num, 0}, (seq_num % 2) == 0,
+                60000)) {
+          check(false, "concurrent, insert " + std::to_string(seq_num));
+        }
+      }
+    }));
+  }
+  for (auto& t : threads) t.join();
+  const double insert_s = elapsed_s(from);
+  check(
+      table.size() == per_thread * TEST_THREADS,
+      "concurrent, all transactions outstanding");
+  check(
+      not table.insert(1, 0xFFFFFFFFFFULL, test_proc_t{1, 0}, true, 60000),
+      "concurrent, sequence number already pending");
+
+  threads.clear();
+  const auto from2 = std::chrono::steady_clock::now();
+  for (int t = 0; t < TEST_THREADS; t++) {
+    threads.push_back(std::thread([&table, t, per_thread]() {
+      for (uint32_t i = 0; i < per_thread; i++) {
+        const uint64_t trxn_id = ((uint64_t) t << 32) | i;
+        uint32_t seq_num       = 0;
+        if ((not table.find_seq_num(trxn_id, seq_num)) ||
+            (seq_num != i * TEST_THREADS + t)) {
+          check(false, "concurrent, find " + std::to_string(trxn_id));
+          continue;
+        }
+        if (i % 2) {
+          table.erase(trxn_id, seq_num);
+        } else {
+          bool found = false;
+          table.update(seq_num, [&](test_proc_t& p, bool& stop_retry) {
+            found      = (p.seq_num == seq_num);
+            stop_retry = true;
+          });
+          check(found, "concurrent, update " + std::to_string(seq_num));
+        }
+      }
+    }));
+  }
+  for (auto& t : threads) t.join();
+  const double answer_s = elapsed_s(from2);
+  check(
+      table.size() == per_thread * TEST_THREADS - per_thread / 2 * TEST_THREADS,
+      "concurrent, answered transactions erased");
+  uint32_t seq_num = 0;
+  check(not table.find_seq_num(1, seq_num), "concurrent, erased not found");
+  check(table.find_seq_num(2, seq_num), "concurrent, pending found");
+
+  std::cout << per_thread * TEST_THREADS << " transactions by "
+            << TEST_THREADS << " threads: "
+            << (per_thread * TEST_THREADS / insert_s / 1e6)
+            << " M inserts/s, "
+            << (per_thread * TEST_THREADS / answer_s / 1e6)
+            << " M lookups+answers/s" << std::endl;
+}
+//------------------------------------------------------------------------------
+// Outstanding requests not answered: retransmitted once (max_retries 1),
+// then given up, then removed when their lifetime expires
+static void test_timers(const uint32_t num_trxns) {
+  std::atomic<uint32_t> retransmitted(0);
+  std::atomic<uint32_t> given_up(0);
+  std::atomic<uint32_t> bad_retry_count(0);
+  transaction_table<test_proc_t> table;
+  table.start(
+      300, 1,
+      [&](const test_proc_t& p) {
+        if (p.retry_count != 1) bad_retry_count++;
+        retransmitted++;
+      },
+      [&](const test_proc_t& p) { given_up++; }, []() {});
+
+  // Even: request sent, retried; odd: request received, never retried.
+  // One out of 4 is answered (retry stopped) right away.
+  uint32_t expected = 0;
+  for (uint32_t seq_num = 0; seq_num < num_trxns; seq_num++) {
+    const bool retry = (seq_num % 2) == 0;
+    table.insert(seq_num, seq_num, test_proc_t{seq_num, 0}, retry, 2000);
+    if ((seq_num % 4) == 0) {
+      table.update(seq_num, [](test_proc_t&, bool& stop_retry) {
+        stop_retry = true;
+      });
+    } else if (retry) {
+      expected++;
+    }
+  }
+  check(table.size() == num_trxns, "timers, all transactions outstanding");
+  check(
+      wait_for([&]() { return given_up.load() >= expected; }, 10000),
+      "timers, unanswered requests given up");
+  check(
+      retransmitted.load() == expected,
+      "timers, retransmitted once, " + std::to_string(retransmitted.load()) +
+          " for " + std::to_string(expected));
+  check(given_up.load() == expected, "timers, given up once");
+  check(bad_retry_count.load() == 0, "timers, retry count");
+  check(
+      wait_for([&]() { return table.size() == 0; }, 10000),
+      "timers, all transactions cleaned up");
+  uint32_t seq_num = 0;
+  check(
+      not table.find_seq_num(num_trxns - 1, seq_num),
+      "timers, transaction ids cleaned up");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  const uint32_t num_trxns =
+      (argc > 1) ? strtoul(argv[1], nullptr, 10) : 160000;
+  test_concurrent(num_trxns);
+  test_timers(num_trxns);
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_transaction_table passed" << std::endl;
+  return 0;
+}
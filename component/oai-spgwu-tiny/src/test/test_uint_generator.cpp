@@ -0,0 +1,231 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file test_uint_generator.cpp
+  \brief Id generators: uniqueness of the block (SEIDs, transaction ids) and
+  bitmap (TEIDs) generators under concurrent threads, exhaustion, reuse of
+  freed ids, reservation of restored ids and node prefix
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "uint_generator.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace util;
+
+#define TEST_THREADS 16
+
+static std::atomic<int> failures(0);
+
+//------------------------------------------------------------------------------
+static void check(const bool condition, const std::string& what) {
+  if (not condition) {
+    std::cout << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+//------------------------------------------------------------------------------
+template <class UINT>
+static bool all_distinct(std::vector<UINT> ids) {
+  std::sort(ids.begin(), ids.end());
+  return std::adjacent_find(ids.begin(), ids.end()) == ids.end();
+}
+//------------------------------------------------------------------------------
+static void test_uint_generator() {
+  uint_generator<uint16_t> g;
+  check(g.get_uid() == 1, "uint_generator, first id");
+  check(g.get_uid() == 2, "uint_generator, second id");
+  g.free_uid(1);
+  check(g.get_uid() == 3, "uint_generator, counter not rewound");
+}
+//------------------------------------------------------------------------------
+static void test_block_generator() {
+  uint_block_generator<uint64_t> g;
+  std::vector<std::vector<uint64_t>> ids(TEST_THREADS);
+  std::vector<std::thread> threads = {};
+  for (int t = 0; t < TEST_THREADS; t++) {
+    threads.push_back(std::thread([&g, &ids, t]() {
+      // More than one block per thread
+      for (int i = 0; i < 3 * UINT_GENERATOR_BLOCK_SIZE + 7; i++) {
+        ids[t].push_back(g.get_uid());
+      }
+    }));
+  }
+  for (auto& t : threads) t.join();
+  std::vector<uint64_t> all = {};
+  for (auto& v : ids) all.insert(all.end(), v.begin(), v.end());
+  check(all_distinct(all), "block, ids distinct between threads");
+  check(
+      std::find(all.begin(), all.end(), 0) == all.end(), "block, 0 not given");
+
+  // A thread switching between generators gets distinct ids of each
+  uint_block_generator<uint64_t> g1;
+  uint_block_generator<uint64_t> g2;
+  std::vector<uint64_t> ids1 = {};
+  std::vector<uint64_t> ids2 = {};
+  for (int i = 0; i < 2 * UINT_GENERATOR_BLOCK_SIZE; i++) {
+    ids1.push_back(g1.get_uid());
+    ids2.push_back(g2.get_uid());
+  }
+  check(all_distinct(ids1), "block, switching, first generator");
+  check(all_distinct(ids2), "block, switching, second generator");
+
+  // Restored ids are not given again by the next blocks
+  uint_block_generator<uint64_t> g3;
+  g3.reserve_uid(100000);
+  std::vector<uint64_t> ids3 = {};
+  std::thread t3([&g3, &ids3]() {
+    for (int i = 0; i < 10; i++) ids3.push_back(g3.get_uid());
+  });
+  t3.join();
+  check(
+      *std::min_element(ids3.begin(), ids3.end()) > 100000,
+      "block, ids after the reserved one");
+  g3.reserve_uid(5);
+  std::thread t4([&g3, &ids3]() { ids3.push_back(g3.get_uid()); });
+  t4.join();
+  check(ids3.back() > 100000, "block, reserve does not go back");
+}
+//------------------------------------------------------------------------------
+static void test_bitmap_exhaustion() {
+  // 2^12 ids, 0 excluded, taken by all the threads until none is left
+#define TEST_ID_BITS 12
+  const uint32_t node = 0x5A;
+  uint_bitmap_generator<uint32_t> g(TEST_ID_BITS, node);
+  std::vector<std::vector<uint32_t>> ids(TEST_THREADS);
+  std::vector<std::thread> threads = {};
+  for (int t = 0; t < TEST_THREADS; t++) {
+    threads.push_back(std::thread([&g, &ids, t]() {
+      uint32_t id = 0;
+      while ((id = g.get_uid())) ids[t].push_back(id);
+    }));
+  }
+  for (auto& t : threads) t.join();
+  std::vector<uint32_t> all = {};
+  for (auto& v : ids) all.insert(all.end(), v.begin(), v.end());
+  check(
+      all.size() == (1 << TEST_ID_BITS) - 1,
+      "bitmap, all the ids given, " + std::to_string(all.size()));
+  check(all_distinct(all), "bitmap, ids distinct between threads");
+  bool prefixed = true;
+  for (auto id : all) {
+    prefixed &= ((id >> TEST_ID_BITS) == node) &&
+                ((id & ((1 << TEST_ID_BITS) - 1)) != 0);
+  }
+  check(prefixed, "bitmap, node prefix and no 0 id");
+  check(g.get_uid() == 0, "bitmap, exhausted");
+
+  // Freed ids, and only them, are given again
+  std::vector<uint32_t> freed = {};
+  for (size_t i = 0; i < all.size(); i += 97) {
+    freed.push_back(all[i]);
+    g.free_uid(all[i]);
+  }
+  std::vector<uint32_t> again = {};
+  uint32_t id                 = 0;
+  while ((id = g.get_uid())) again.push_back(id);
+  std::sort(freed.begin(), freed.end());
+  std::sort(again.begin(), again.end());
+  check(again == freed, "bitmap, freed ids given again");
+  g.free_uid(0x11 << TEST_ID_BITS | 1);
+  check(g.get_uid() == 0, "bitmap, id of another node not freed");
+}
+//------------------------------------------------------------------------------
+static void test_bitmap_reserve() {
+  const uint32_t node = 3;
+  uint_bitmap_generator<uint32_t> g(TEST_ID_BITS, node);
+  const uint32_t restored = (node << TEST_ID_BITS) | 2;
+  check(g.reserve_uid(restored), "bitmap, restored id reserved");
+  check(not g.reserve_uid(restored), "bitmap, restored id already given");
+  check(not g.reserve_uid(node << TEST_ID_BITS), "bitmap, 0 id not reserved");
+  check(
+      not g.reserve_uid((node + 1) << TEST_ID_BITS | 2),
+      "bitmap, id of another node not reserved");
+  uint32_t id = 0;
+  bool seen   = false;
+  while ((id = g.get_uid())) seen |= (id == restored);
+  check(not seen, "bitmap, reserved id not given");
+
+  // A freed id does not come back at once, the cursor goes round first
+  uint_bitmap_generator<uint32_t> g2(TEST_ID_BITS, node);
+  const uint32_t first = g2.get_uid();
+  g2.free_uid(first);
+  check(g2.get_uid() != first, "bitmap, freed id not given at once");
+}
+//------------------------------------------------------------------------------
+// Threads get and free ids concurrently, an id is never held by two of them
+static void test_bitmap_churn() {
+  uint_bitmap_generator<uint32_t> g(TEST_ID_BITS, 0);
+  std::unique_ptr<std::atomic<int>[]> holder(
+      new std::atomic<int>[1 << TEST_ID_BITS]());
+  std::vector<std::thread> threads = {};
+  for (int t = 0; t < TEST_THREADS; t++) {
+    threads.push_back(std::thread([&g, &holder, t]() {
+      std::vector<uint32_t> held = {};
+      for (int i = 0; i < 20000; i++) {
+        if ((held.size() < 128) && ((i % 3) != 2)) {
+          const uint32_t id = g.get_uid();
+          if (not id) continue;
+          int expected = 0;
+          if (not holder[id].compare_exchange_strong(expected, t + 1)) {
+            check(false, "churn, id " + std::to_string(id) + " held twice");
+          }
+          held.push_back(id);
+        } else if (held.size()) {
+          const uint32_t id = held[i % held.size()];
+          held[i % held.size()] = held.back();
+          held.pop_back();
+          holder[id] = 0;
+          g.free_uid(id);
+        }
+      }
+      for (auto id : held) {
+        holder[id] = 0;
+        g.free_uid(id);
+      }
+    }));
+  }
+  for (auto& t : threads) t.join();
+  uint32_t n  = 0;
+  uint32_t id = 0;
+  while ((id = g.get_uid())) n++;
+  check(n == (1 << TEST_ID_BITS) - 1, "churn, all the ids freed");
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv) {
+  test_uint_generator();
+  test_block_generator();
+  test_bitmap_exhaustion();
+  test_bitmap_reserve();
+  test_bitmap_churn();
+  if (failures) {
+    std::cout << failures << " check(s) failed" << std::endl;
+    return 1;
+  }
+  std::cout << "test_uint_generator passed" << std::endl;
+  return 0;
+}
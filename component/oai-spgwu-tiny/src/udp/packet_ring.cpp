@@ -0,0 +1,239 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file packet_ring.cpp
+  \brief  AF_PACKET TPACKET_V3 mmap'ed RX ring
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+
+#include "packet_ring.hpp"
+#include "logger.hpp"
+#include "qsbr.hpp"
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <system_error>
+
+//------------------------------------------------------------------------------
+const char* packet_io_backend_to_string(const packet_io_backend_t b) {
+  switch (b) {
+    case PACKET_IO_BACKEND_SOCKET:
+      return "SOCKET";
+    case PACKET_IO_BACKEND_TPACKET_V3:
+      return "TPACKET_V3";
+    default:
+      return "UNKNOWN";
+  }
+}
+//------------------------------------------------------------------------------
+packet_ring::packet_ring(
+    const std::string& if_name, const uint16_t fanout_group_id,
+    const unsigned int headroom)
+    : fd_(-1),
+      map_(nullptr),
+      map_size_(0),
+      blocks_(),
+      running_(true),
+      if_name_(if_name),
+      rx_packets_(0),
+      rx_polls_(0),
+      rx_drops_(0) {
+  if ((fd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) < 0) {
+    Logger::udp().error(
+        "packet_ring socket creation failed (%s)", strerror(errno));
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring socket creation failed");
+  }
+
+  int version = TPACKET_V3;
+  if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) <
+      0) {
+    Logger::udp().error(
+        "packet_ring %s TPACKET_V3 not supported (%s)", if_name.c_str(),
+        strerror(errno));
+    close(fd_);
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring TPACKET_V3 failed");
+  }
+
+  // Room for the GTP-U encapsulation in front of the network header
+  if (setsockopt(
+          fd_, SOL_PACKET, PACKET_RESERVE, &headroom, sizeof(headroom)) < 0) {
+    Logger::udp().warn(
+        "packet_ring %s PACKET_RESERVE %u failed (%s)", if_name.c_str(),
+        headroom, strerror(errno));
+  }
+
+#ifdef PACKET_IGNORE_OUTGOING
+  int ignore_outgoing = 1;
+  if (setsockopt(
+          fd_, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignore_outgoing,
+          sizeof(ignore_outgoing)) < 0) {
+    Logger::udp().warn(
+        "packet_ring %s PACKET_IGNORE_OUTGOING failed (%s)", if_name.c_str(),
+        strerror(errno));
+  }
+#endif
+
+  struct tpacket_req3 req = {};
+  req.tp_block_size       = PACKET_RING_BLOCK_SIZE;
+  req.tp_block_nr         = PACKET_RING_NUM_BLOCKS;
+  req.tp_frame_size       = PACKET_RING_FRAME_SIZE;
+  req.tp_frame_nr =
+      (PACKET_RING_BLOCK_SIZE / PACKET_RING_FRAME_SIZE) * PACKET_RING_NUM_BLOCKS;
+  req.tp_retire_blk_tov   = PACKET_RING_BLOCK_TIMEOUT_MS;
+  req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+  if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+    Logger::udp().error(
+        "packet_ring %s PACKET_RX_RING failed (%s)", if_name.c_str(),
+        strerror(errno));
+    close(fd_);
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring PACKET_RX_RING failed");
+  }
+
+  map_size_ = (size_t) req.tp_block_size * req.tp_block_nr;
+  map_      = (uint8_t*) mmap(
+      nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
+      fd_, 0);
+  if (map_ == MAP_FAILED) {
+    // MAP_LOCKED may fail because of RLIMIT_MEMLOCK, retry without
+    map_ = (uint8_t*) mmap(
+        nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (map_ == MAP_FAILED) {
+    Logger::udp().error(
+        "packet_ring %s mmap failed (%s)", if_name.c_str(), strerror(errno));
+    close(fd_);
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring mmap failed");
+  }
+  for (unsigned int i = 0; i < req.tp_block_nr; i++) {
+    struct iovec block = {};
+    block.iov_base     = map_ + (i * req.tp_block_size);
+    block.iov_len      = req.tp_block_size;
+    blocks_.push_back(block);
+  }
+
+  struct sockaddr_ll sll = {};
+  sll.sll_family         = AF_PACKET;
+  sll.sll_protocol       = htons(ETH_P_ALL);
+  sll.sll_ifindex        = if_nametoindex(if_name.c_str());
+  if ((sll.sll_ifindex == 0) ||
+      (bind(fd_, (struct sockaddr*) &sll, sizeof(sll)) < 0)) {
+    Logger::udp().error(
+        "packet_ring bind to %s failed (%s)", if_name.c_str(), strerror(errno));
+    munmap(map_, map_size_);
+    close(fd_);
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring bind failed");
+  }
+
+  int fanout = fanout_group_id |
+               ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+  if (setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0) {
+    Logger::udp().error(
+        "packet_ring %s PACKET_FANOUT group %u failed (%s)", if_name.c_str(),
+        fanout_group_id, strerror(errno));
+    munmap(map_, map_size_);
+    close(fd_);
+    throw std::system_error(
+        errno, std::generic_category(), "packet_ring PACKET_FANOUT failed");
+  }
+  Logger::udp().info(
+      "packet_ring TPACKET_V3 on %s: %u blocks of %u bytes, fanout group %u",
+      if_name.c_str(), req.tp_block_nr, req.tp_block_size, fanout_group_id);
+}
+//------------------------------------------------------------------------------
+packet_ring::~packet_ring() {
+  if (map_) munmap(map_, map_size_);
+  if (fd_ >= 0) close(fd_);
+}
+//------------------------------------------------------------------------------
+void packet_ring::read_loop(
+    const packet_ring_handler_t& handler,
+    const packet_ring_idle_handler_t& idle_handler) {
+  unsigned int block_num = 0;
+  struct pollfd pfd      = {};
+  pfd.fd                 = fd_;
+  pfd.events             = POLLIN | POLLERR;
+
+  while (running_) {
+    struct tpacket_block_desc* pbd =
+        (struct tpacket_block_desc*) blocks_[block_num].iov_base;
+
+    if ((__atomic_load_n(&pbd->hdr.bh1.block_status, __ATOMIC_ACQUIRE) &
+         TP_STATUS_USER) == 0) {
+      if (idle_handler) idle_handler();
+      pfd.revents = 0;
+      util::qsbr::get_instance().thread_offline();
+      poll(&pfd, 1, PACKET_RING_POLL_TIMEOUT_MS);
+      util::qsbr::get_instance().thread_online();
+      rx_polls_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    uint32_t num_pkts = pbd->hdr.bh1.num_pkts;
+    struct tpacket3_hdr* ppd =
+        (struct tpacket3_hdr*) ((uint8_t*) pbd +
+                                pbd->hdr.bh1.offset_to_first_pkt);
+    for (uint32_t i = 0; i < num_pkts; i++) {
+      // PACKET_IGNORE_OUTGOING is not applied to fanout groups on all kernels
+      struct sockaddr_ll* sll =
+          (struct sockaddr_ll*) ((uint8_t*) ppd +
+                                 TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+      // Truncated frames cannot be forwarded
+      if ((sll->sll_pkttype != PACKET_OUTGOING) &&
+          (ppd->tp_snaplen == ppd->tp_len) && (ppd->tp_net >= ppd->tp_mac)) {
+        handler(
+            (char*) ppd + ppd->tp_net,
+            ppd->tp_snaplen - (ppd->tp_net - ppd->tp_mac));
+      }
+      ppd = (struct tpacket3_hdr*) ((uint8_t*) ppd + ppd->tp_next_offset);
+    }
+    rx_packets_.fetch_add(num_pkts, std::memory_order_relaxed);
+    // Give the block back to the kernel
+    __atomic_store_n(
+        &pbd->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block_num = (block_num + 1) % blocks_.size();
+    util::qsbr::get_instance().quiescent_state();
+  }
+}
+//------------------------------------------------------------------------------
+uint64_t packet_ring::get_rx_drops() {
+  struct tpacket_stats_v3 stats = {};
+  socklen_t len                 = sizeof(stats);
+  // Kernel counters are reset on read
+  if (getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+    rx_drops_ += stats.tp_drops;
+  }
+  return rx_drops_;
+}
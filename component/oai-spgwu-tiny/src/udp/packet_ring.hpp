@@ -0,0 +1,101 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the OAI Public License, Version 1.1  (the "License"); you may not use this
+ * file except in compliance with the License. You may obtain a copy of the
+ * License at
+ *
+ *      http://www.openairinterface.org/?page_id=698
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file packet_ring.hpp
+  \brief  AF_PACKET TPACKET_V3 mmap'ed RX ring
+  \author Lionel Gauthier
+  \company Eurecom
+  \email: lionel.gauthier@eurecom.fr
+*/
+#ifndef FILE_PACKET_RING_HPP_SEEN
+#define FILE_PACKET_RING_HPP_SEEN
+
+#include <linux/if_packet.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef enum packet_io_backend_e {
+  // Kernel sockets (UDP socket on S1-U, TUN fd on SGi)
+  PACKET_IO_BACKEND_SOCKET = 0,
+  // AF_PACKET TPACKET_V3 mmap'ed RX ring bound to the interface
+  PACKET_IO_BACKEND_TPACKET_V3
+} packet_io_backend_t;
+
+const char* packet_io_backend_to_string(const packet_io_backend_t b);
+
+// Ring geometry: 64 blocks of 1 MB, frames are packed in blocks by the kernel
+#define PACKET_RING_BLOCK_SIZE (1 << 20)
+#define PACKET_RING_NUM_BLOCKS 64
+#define PACKET_RING_FRAME_SIZE 2048
+// A block is retired to user space after this delay even if not full
+#define PACKET_RING_BLOCK_TIMEOUT_MS 1
+#define PACKET_RING_POLL_TIMEOUT_MS 100
+
+// Called with a pointer on the network header of a frame located in the ring
+// and the length of the packet starting at this header. The handler may modify
+// the packet in place and may write up to the ring headroom bytes before it.
+typedef std::function<void(char* l3_packet, const std::size_t num_bytes)>
+    packet_ring_handler_t;
+// Called before the reader thread sleeps waiting for the next block
+typedef std::function<void()> packet_ring_idle_handler_t;
+
+class packet_ring {
+ public:
+  // Rings created with the same fanout_group_id on the same interface share
+  // the received traffic, flows are kept on the same ring (PACKET_FANOUT_HASH).
+  // headroom is the room reserved in front of every frame.
+  packet_ring(
+      const std::string& if_name, const uint16_t fanout_group_id,
+      const unsigned int headroom);
+  packet_ring(packet_ring const&) = delete;
+  void operator=(packet_ring const&) = delete;
+  ~packet_ring();
+
+  // Deliver frames to handler until stop() is called
+  void read_loop(
+      const packet_ring_handler_t& handler,
+      const packet_ring_idle_handler_t& idle_handler);
+  void stop() { running_ = false; };
+
+  uint64_t get_rx_packets() const { return rx_packets_; };
+  // Number of polls on the ring, equivalent of RX syscalls
+  uint64_t get_rx_polls() const { return rx_polls_; };
+  // Frames dropped by the kernel because the ring was full
+  uint64_t get_rx_drops();
+
+ private:
+  int fd_;
+  uint8_t* map_;
+  size_t map_size_;
+  std::vector<struct iovec> blocks_;
+  std::atomic<bool> running_;
+  std::string if_name_;
+  std::atomic<uint64_t> rx_packets_;
+  std::atomic<uint64_t> rx_polls_;
+  uint64_t rx_drops_;
+};
+
+#endif /* FILE_PACKET_RING_HPP_SEEN */
@@ -27,9 +27,18 @@
 */
 
 #include "udp.hpp"
+#include "qsbr.hpp"
+
+#include <linux/filter.h>
+#include <linux/ipv6.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <unistd.h>
 
 #include <cstdlib>
 
+std::atomic<unsigned int> udp_server::next_id_(0);
+
 //------------------------------------------------------------------------------
 void udp_application::handle_receive(
     char* recv_buffer, const std::size_t bytes_transferred,
@@ -58,64 +67,318 @@ static std::string string_to_hex(const std::string& input) {
   return output;
 }
 //------------------------------------------------------------------------------
-void udp_server::udp_worker_loop(
+void udp_server::alloc_shard_buffers(const int id, udp_shard_t& shard) {
+  if (shard.packet_pool) {
+    util::packet_pool& pool = util::packet_pool::get_instance();
+    for (auto& item : shard.items) {
+      item.pbuf = pool.alloc();
+      if (not item.pbuf) break;
+      item.buffer = item.pbuf->data();
+    }
+    if (shard.items.back().pbuf) {
+      shard.recv_buffer_size = pool.data_room();
+      return;
+    }
+    Logger::udp().error(
+        "Packet pool exhausted, shard %d allocates its own buffers", id);
+    for (auto& item : shard.items) {
+      if (item.pbuf) pool.release(item.pbuf);
+      item.pbuf = nullptr;
+    }
+    shard.packet_pool = false;
+  }
+  shard.recv_buffer_size = UDP_RECV_BUFFER_SIZE;
+  shard.recv_buffer_alloc =
+      (char*) calloc(shard.items.size(), UDP_RECV_BUFFER_SIZE);
+  for (int b = 0; b < shard.items.size(); b++) {
+    shard.items[b].buffer = &shard.recv_buffer_alloc[b * UDP_RECV_BUFFER_SIZE];
+  }
+}
+//------------------------------------------------------------------------------
+void udp_server::udp_shard_loop(
     const int id, const util::thread_sched_params& sched_params) {
-  uint64_t count              = 0;
-  udp_packet_q_item_t* worker = nullptr;
+  udp_shard_t& shard                         = shards_[id];
+  struct mmsghdr msgs[UDP_MAX_IO_BATCH_SIZE] = {};
+  struct iovec iovs[UDP_MAX_IO_BATCH_SIZE]   = {};
 
   sched_params.apply(TASK_NONE, Logger::udp());
-  while (1) {
-    work_pool_->blockingRead(worker);
-    ++count;
-    // std::cout << "w" << id << " " << count << std::endl;
-    // exit thread
-    if (worker->buffer) {
-      app_->handle_receive(worker->buffer, worker->size, worker->r_endpoint);
-      free_pool_->write(worker);
-    } else {
-      free(worker);
-      // std::cout << "exit w" << id << " " << count << std::endl;
-      while (work_pool_->readIfNotEmpty(worker)) {
-        free(worker);
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  util::qsbr& qsbr = util::qsbr::get_instance();
+  if (not qsbr.register_thread()) {
+    // Unseen by the grace periods, it would switch with freed entries
+    Logger::udp().error("Too many packet workers, shard %d not registered", id);
+    exit(EXIT_FAILURE);
+  }
+  alloc_shard_buffers(id, shard);
+
+  while (running_) {
+    for (unsigned int i = 0; i < io_batch_size_; i++) {
+      udp_packet_q_item_t& item      = shard.items[i];
+      iovs[i].iov_base               = item.buffer;
+      iovs[i].iov_len                = shard.recv_buffer_size;
+      msgs[i].msg_hdr.msg_name       = &item.r_endpoint.addr_storage;
+      msgs[i].msg_hdr.msg_namelen    = sizeof(struct sockaddr_storage);
+      msgs[i].msg_hdr.msg_iov        = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen     = 1;
+      msgs[i].msg_hdr.msg_control    = nullptr;
+      msgs[i].msg_hdr.msg_controllen = 0;
+      msgs[i].msg_hdr.msg_flags      = 0;
+      msgs[i].msg_len                = 0;
+    }
+    // Block for the first datagram only, then take what is already queued.
+    // No reference on shared data is held while blocked.
+    qsbr.thread_offline();
+    int num_msgs =
+        recvmmsg(shard.socket, msgs, io_batch_size_, MSG_WAITFORONE, nullptr);
+    qsbr.thread_online();
+    if (not running_) {
+      break;
+    }
+    rx_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    if (num_msgs < 0) {
+      if (errno != EINTR) {
+        Logger::udp().error(
+            "Recvmmsg failed on shard %d %s\n", id, strerror(errno));
       }
-      return;
+      continue;
+    }
+    rx_packets_.fetch_add(num_msgs, std::memory_order_relaxed);
+    // Run to completion, no hand-off to other threads
+    for (int i = 0; i < num_msgs; i++) {
+      if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        Logger::udp().trace(
+            "Dropped datagram bigger than %zu bytes on shard %d",
+            shard.recv_buffer_size, id);
+        continue;
+      }
+      udp_packet_q_item_t& item        = shard.items[i];
+      item.size                        = msgs[i].msg_len;
+      item.r_endpoint.addr_storage_len = msgs[i].msg_hdr.msg_namelen;
+      app_->handle_receive(item.buffer, item.size, item.r_endpoint);
     }
-    worker = nullptr;
+    app_->handle_receive_end();
+    flush_send_batch();
   }
 }
-
 //------------------------------------------------------------------------------
-void udp_server::udp_read_loop(const util::thread_sched_params& sched_params) {
-  uint64_t count              = 0;
-  udp_packet_q_item_t* worker = nullptr;
+void udp_server::handle_ring_packet(
+    char* l3_packet, const std::size_t num_bytes) {
+  struct udphdr* udph = nullptr;
+  std::size_t l3_len  = 0;
+  endpoint r_endpoint;
+
+  struct iphdr* iph = (struct iphdr*) l3_packet;
+  if ((num_bytes >= sizeof(struct iphdr)) && (iph->version == 4)) {
+    l3_len = iph->ihl << 2;
+    if ((sa_family != AF_INET) || (iph->protocol != IPPROTO_UDP) ||
+        (num_bytes < l3_len + sizeof(struct udphdr))) {
+      return;
+    }
+    if ((local_addr4_.s_addr != INADDR_ANY) &&
+        (iph->daddr != local_addr4_.s_addr)) {
+      return;
+    }
+    // No reassembly on this path
+    if (iph->frag_off & htons(IP_MF | IP_OFFMASK)) {
+      Logger::udp().trace("Dropped IPv4 fragment received on packet ring");
+      return;
+    }
+    udph = (struct udphdr*) &l3_packet[l3_len];
+    if (udph->dest != htons(port_)) {
+      return;
+    }
+    struct in_addr saddr = {};
+    saddr.s_addr         = iph->saddr;
+    r_endpoint           = endpoint(saddr, ntohs(udph->source));
+  } else if ((num_bytes >= sizeof(struct ipv6hdr)) && (iph->version == 6)) {
+    struct ipv6hdr* ip6h = (struct ipv6hdr*) l3_packet;
+    l3_len               = sizeof(struct ipv6hdr);
+    // Extension headers are not walked
+    if ((sa_family != AF_INET6) || (ip6h->nexthdr != IPPROTO_UDP) ||
+        (num_bytes < l3_len + sizeof(struct udphdr))) {
+      return;
+    }
+    if ((!IN6_IS_ADDR_UNSPECIFIED(&local_addr6_)) &&
+        (memcmp(&ip6h->daddr, &local_addr6_, sizeof(struct in6_addr)))) {
+      return;
+    }
+    udph = (struct udphdr*) &l3_packet[l3_len];
+    if (udph->dest != htons(port_)) {
+      return;
+    }
+    struct in6_addr saddr6 = {};
+    memcpy(&saddr6, &ip6h->saddr, sizeof(struct in6_addr));
+    r_endpoint = endpoint(saddr6, ntohs(udph->source));
+  } else {
+    return;
+  }
 
+  std::size_t udp_len = ntohs(udph->len);
+  if ((udp_len < sizeof(struct udphdr)) || (l3_len + udp_len > num_bytes)) {
+    return;
+  }
+  rx_packets_.fetch_add(1, std::memory_order_relaxed);
+  app_->handle_receive(
+      (char*) udph + sizeof(struct udphdr), udp_len - sizeof(struct udphdr),
+      r_endpoint);
+}
+//------------------------------------------------------------------------------
+void udp_server::packet_ring_loop(
+    packet_ring* ring, const util::thread_sched_params& sched_params) {
   sched_params.apply(TASK_NONE, Logger::udp());
+  if (not util::qsbr::get_instance().register_thread()) {
+    Logger::udp().error("Too many packet workers, ring not registered");
+    exit(EXIT_FAILURE);
+  }
+  ring->read_loop(
+      [this](char* l3_packet, const std::size_t num_bytes) {
+        handle_ring_packet(l3_packet, num_bytes);
+      },
+      [this]() {
+        app_->handle_receive_end();
+        flush_send_batch();
+      });
+}
+//------------------------------------------------------------------------------
+udp_send_batch_t* udp_server::get_send_batch(const bool create) {
+  // One batch per (sender thread, udp_server), no locking needed
+  thread_local std::unique_ptr<udp_send_batch_t>
+      batches[UDP_MAX_BATCHED_SERVERS];
+  udp_send_batch_t* batch = batches[id_].get();
+  if ((batch) || (not create)) {
+    return batch;
+  }
+  batches[id_].reset(new udp_send_batch_t());
+  return batches[id_].get();
+}
+//------------------------------------------------------------------------------
+void udp_server::queue_in_send_batch(
+    const char* send_buffer, const ssize_t num_bytes,
+    const struct sockaddr* r_endpoint, const socklen_t r_endpoint_len,
+    util::packet_buf_t* const pbuf) {
+  udp_send_batch_t* batch = get_send_batch(true);
+  if (batch->count == 0) {
+    batch->first_queued = std::chrono::steady_clock::now();
+  }
+  unsigned int i = batch->count++;
+  if (pbuf) {
+    util::packet_pool::hold(pbuf);
+    batch->pbufs[i]         = pbuf;
+    batch->iovs[i].iov_base = const_cast<char*>(send_buffer);
+  } else {
+    memcpy(batch->buffers[i], send_buffer, num_bytes);
+    batch->iovs[i].iov_base = batch->buffers[i];
+  }
+  memcpy(&batch->addrs[i], r_endpoint, r_endpoint_len);
+  batch->iovs[i].iov_len                = num_bytes;
+  batch->msgs[i].msg_hdr.msg_name       = &batch->addrs[i];
+  batch->msgs[i].msg_hdr.msg_namelen    = r_endpoint_len;
+  batch->msgs[i].msg_hdr.msg_iov        = &batch->iovs[i];
+  batch->msgs[i].msg_hdr.msg_iovlen     = 1;
+  batch->msgs[i].msg_hdr.msg_control    = nullptr;
+  batch->msgs[i].msg_hdr.msg_controllen = 0;
+  batch->msgs[i].msg_hdr.msg_flags      = 0;
 
-  while (1) {
-    free_pool_->blockingRead(worker);
-    ++count;
-    // std::cout << "d" << count << std::endl;
-    // exit thread
-    if (worker->buffer == nullptr) {
-      free(worker);
-      while (work_pool_->readIfNotEmpty(worker)) {
-        free(worker);
-      }
-      // std::cout << "exit d" << count << std::endl;
-      return;
+  // Without a deadline, the batch waits for the end of the receive burst
+  if ((batch->count >= io_batch_size_) ||
+      ((io_flush_deadline_.count()) &&
+       ((std::chrono::steady_clock::now() - batch->first_queued) >=
+        io_flush_deadline_))) {
+    flush_send_batch(*batch);
+  }
+}
+//------------------------------------------------------------------------------
+void udp_server::batch_send_to(
+    const char* send_buffer, const ssize_t num_bytes,
+    const struct sockaddr_in& r_endpoint, util::packet_buf_t* const pbuf) {
+  if ((io_batch_size_ <= 1) || (id_ >= UDP_MAX_BATCHED_SERVERS) ||
+      ((not pbuf) && (num_bytes > UDP_SEND_BATCH_BUFFER_SIZE))) {
+    flush_send_batch();
+    async_send_to(send_buffer, num_bytes, r_endpoint);
+    return;
+  }
+  queue_in_send_batch(
+      send_buffer, num_bytes, (const struct sockaddr*) &r_endpoint,
+      sizeof(struct sockaddr_in), pbuf);
+}
+//------------------------------------------------------------------------------
+void udp_server::batch_send_to(
+    const char* send_buffer, const ssize_t num_bytes,
+    const struct sockaddr_in6& r_endpoint, util::packet_buf_t* const pbuf) {
+  if ((io_batch_size_ <= 1) || (id_ >= UDP_MAX_BATCHED_SERVERS) ||
+      ((not pbuf) && (num_bytes > UDP_SEND_BATCH_BUFFER_SIZE))) {
+    flush_send_batch();
+    async_send_to(send_buffer, num_bytes, r_endpoint);
+    return;
+  }
+  queue_in_send_batch(
+      send_buffer, num_bytes, (const struct sockaddr*) &r_endpoint,
+      sizeof(struct sockaddr_in6), pbuf);
+}
+//------------------------------------------------------------------------------
+void udp_server::flush_send_batch() {
+  if (id_ >= UDP_MAX_BATCHED_SERVERS) {
+    return;
+  }
+  udp_send_batch_t* batch = get_send_batch(false);
+  if ((batch) && (batch->count)) {
+    flush_send_batch(*batch);
+  }
+}
+//------------------------------------------------------------------------------
+void udp_server::flush_send_batch(udp_send_batch_t& batch) {
+  unsigned int sent = 0;
+  while (sent < batch.count) {
+    int rc = sendmmsg(socket_, &batch.msgs[sent], batch.count - sent, 0);
+    tx_syscalls_.fetch_add(1, std::memory_order_relaxed);
+    if (rc <= 0) {
+      // Do not retry, drop what remains in the batch
+      tx_dropped(batch.count - sent, errno);
+      break;
     }
-    worker->r_endpoint.addr_storage_len = sizeof(struct sockaddr_storage);
-    if ((worker->size = recvfrom(
-             socket_, worker->buffer, UDP_RECV_BUFFER_SIZE, 0,
-             (struct sockaddr*) &worker->r_endpoint.addr_storage,
-             &worker->r_endpoint.addr_storage_len)) > 0) {
-      work_pool_->write(worker);
-    } else {
-      Logger::udp().error("Recvfrom failed %s\n", strerror(errno));
-      free_pool_->write(worker);
+    tx_packets_.fetch_add(rc, std::memory_order_relaxed);
+    sent += rc;
+  }
+  for (unsigned int i = 0; i < batch.count; i++) {
+    if (batch.pbufs[i]) {
+      util::packet_pool::get_instance().release(batch.pbufs[i]);
+      batch.pbufs[i] = nullptr;
     }
-    worker = nullptr;
+  }
+  batch.count = 0;
+}
+//------------------------------------------------------------------------------
+void udp_server::tx_dropped(const unsigned int num_datagrams, const int err) {
+  const uint64_t total =
+      tx_dropped_.fetch_add(num_datagrams, std::memory_order_relaxed) +
+      num_datagrams;
+  const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  int64_t last = tx_drop_logged_.load(std::memory_order_relaxed);
+  if ((now > last) && (tx_drop_logged_.compare_exchange_strong(
+                          last, now, std::memory_order_relaxed))) {
+    Logger::udp().error(
+        "udp_server port %" PRIu16 " send failed(%d:%s), %" PRIu64
+        " datagrams dropped so far",
+        port_, err, strerror(err), total);
+  }
+}
+//------------------------------------------------------------------------------
+void udp_server::get_io_counters(udp_io_counters_t& counters) const {
+  counters.rx_syscalls = rx_syscalls_.load(std::memory_order_relaxed);
+  for (auto& ring : rings_) {
+    counters.rx_syscalls += ring->get_rx_polls();
+  }
+  counters.rx_packets  = rx_packets_.load(std::memory_order_relaxed);
+  counters.tx_syscalls = tx_syscalls_.load(std::memory_order_relaxed);
+  counters.tx_packets  = tx_packets_.load(std::memory_order_relaxed);
+  counters.tx_dropped  = tx_dropped_.load(std::memory_order_relaxed);
+}
+//------------------------------------------------------------------------------
+void udp_server::get_receive_sockets(std::vector<int>& sockets) const {
+  sockets.clear();
+  for (const auto& shard : shards_) {
+    sockets.push_back(shard.socket);
   }
 }
 //------------------------------------------------------------------------------
@@ -144,6 +407,13 @@ int udp_server::create_socket(
       "Creating new listen socket on address %s and port %" PRIu16 "\n",
       ipv4.c_str(), port);
 
+  // Receive shards bind their own socket to the same address and port
+  int option_on = 1;
+  if (setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &option_on, sizeof(option_on)) <
+      0) {
+    Logger::udp().warn("Set SO_REUSEPORT failed (%s)\n", strerror(errno));
+  }
+
   if (bind(sd, (struct sockaddr*) &addr, sizeof(struct sockaddr_in)) < 0) {
     /*
      * Bind failed
@@ -154,7 +424,8 @@ int udp_server::create_socket(
     close(sd);
     return errno;
   }
-  sa_family = AF_INET;
+  sa_family    = AF_INET;
+  local_addr4_ = address;
   return sd;
 }
 //------------------------------------------------------------------------------
@@ -183,6 +454,13 @@ int udp_server::create_socket(
       "Creating new listen socket on address %s and port %" PRIu16 "\n",
       ipv6.c_str(), port);
 
+  // Receive shards bind their own socket to the same address and port
+  int option_on = 1;
+  if (setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &option_on, sizeof(option_on)) <
+      0) {
+    Logger::udp().warn("Set SO_REUSEPORT failed (%s)\n", strerror(errno));
+  }
+
   if (bind(sd, (struct sockaddr*) &addr, sizeof(struct sockaddr_in6)) < 0) {
     /*
      * Bind failed
@@ -193,7 +471,8 @@ int udp_server::create_socket(
     close(sd);
     return errno;
   }
-  sa_family = AF_INET6;
+  sa_family    = AF_INET6;
+  local_addr6_ = address;
   return sd;
 }
 //------------------------------------------------------------------------------
@@ -215,40 +494,133 @@ int udp_server::create_socket(const char* address, const uint16_t port_num) {
   }
 }
 //------------------------------------------------------------------------------
+int udp_server::attach_reuseport_steering(
+    const int steering_key_offset, const unsigned int num_shards) {
+  // The program runs with the UDP payload at offset 0, it returns the index
+  // of the socket in the SO_REUSEPORT group, that is the shard id.
+  struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, (uint32_t) steering_key_offset),
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, num_shards),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  struct sock_fprog prog = {};
+  prog.len               = sizeof(code) / sizeof(code[0]);
+  prog.filter            = code;
+  if (setsockopt(
+          socket_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) <
+      0) {
+    Logger::udp().warn(
+        "Set SO_ATTACH_REUSEPORT_CBPF failed (%s), using kernel hash\n",
+        strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+//------------------------------------------------------------------------------
 void udp_server::start_receive(
-    udp_application* app, const util::thread_sched_params& sched_params) {
-  num_threads_   = sched_params.thread_pool_size;
-  int num_blocks = num_threads_ * 16;
-  app_           = app;
-  Logger::udp().trace("udp_server::start_receive");
-  free_pool_         = new folly::MPMCQueue<udp_packet_q_item_t*>(num_blocks);
-  work_pool_         = new folly::MPMCQueue<udp_packet_q_item_t*>(num_blocks);
-  recv_buffer_alloc_ = (char*) calloc(num_blocks, UDP_RECV_BUFFER_SIZE);
-  // udp_packet_q_item_alloc_ = (udp_packet_q_item_t*)calloc(1,
-  // sizeof(udp_packet_q_item_t)*num_blocks);
-  for (int i = 0; i < num_blocks; i++) {
-    udp_packet_q_item_t* p =
-        (udp_packet_q_item_t*) calloc(1, sizeof(udp_packet_q_item_t));
-    p->buffer = &recv_buffer_alloc_[i * UDP_RECV_BUFFER_SIZE];
-    free_pool_->blockingWrite(p);
-  }
-  for (int i = 0; i < num_threads_; i++) {
-    std::thread t =
-        std::thread(&udp_server::udp_worker_loop, this, i, sched_params);
+    udp_application* app, const util::thread_sched_params& sched_params,
+    const int steering_key_offset, const bool packet_pool) {
+  unsigned int num_shards = std::max(1u, sched_params.thread_pool_size);
+  // An ephemeral port cannot be shared
+  if (port_ == 0) {
+    num_shards = 1;
+  }
+  io_batch_size_ = std::max(1u, sched_params.io_batch_size);
+  io_batch_size_ =
+      std::min(io_batch_size_, (unsigned int) UDP_MAX_IO_BATCH_SIZE);
+  io_flush_deadline_ =
+      std::chrono::microseconds(sched_params.io_flush_deadline_us);
+  app_     = app;
+  running_ = true;
+  Logger::udp().trace("udp_server::start_receive %u shards", num_shards);
+
+  for (int i = 0; i < num_shards; i++) {
+    udp_shard_t shard = {};
+    if (i == 0) {
+      shard.socket = socket_;
+    } else if (sa_family == AF_INET6) {
+      shard.socket = create_socket(local_addr6_, port_);
+    } else {
+      shard.socket = create_socket(local_addr4_, port_);
+    }
+    if (shard.socket <= 0) {
+      Logger::udp().error(
+          "udp_server::start_receive could not create shard %d socket, "
+          "running with %d shards",
+          i, i);
+      break;
+    }
+    shard.packet_pool =
+        (packet_pool) && (util::packet_pool::get_instance().initialized());
+    // Buffers allocated by the shard thread
+    shard.items.resize(io_batch_size_);
+    shards_.push_back(shard);
+  }
+  if ((steering_key_offset >= 0) && (shards_.size() > 1)) {
+    attach_reuseport_steering(steering_key_offset, shards_.size());
+  }
+
+  for (int i = 0; i < shards_.size(); i++) {
+    // One core per shard, starting from the configured one
+    util::thread_sched_params shard_sched_params = sched_params;
+    if (sched_params.cpu_id >= 0) {
+      shard_sched_params.cpu_id =
+          (sched_params.cpu_id + i) % std::thread::hardware_concurrency();
+    }
+    std::thread t = std::thread(
+        &udp_server::udp_shard_loop, this, i, shard_sched_params);
+    t.detach();
+    threads_.push_back(std::move(t));
+  }
+}
+//------------------------------------------------------------------------------
+void udp_server::start_receive_packet_ring(
+    udp_application* app, const std::string& if_name,
+    const util::thread_sched_params& sched_params) {
+  unsigned int num_rings = std::max(1u, sched_params.thread_pool_size);
+  io_batch_size_         = std::max(1u, sched_params.io_batch_size);
+  io_batch_size_ =
+      std::min(io_batch_size_, (unsigned int) UDP_MAX_IO_BATCH_SIZE);
+  io_flush_deadline_ =
+      std::chrono::microseconds(sched_params.io_flush_deadline_us);
+  app_ = app;
+  Logger::udp().trace(
+      "udp_server::start_receive_packet_ring(%s)", if_name.c_str());
+
+  // The socket is not read anymore, keep its receive queue small
+  int rcvbuf = 0;
+  setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  const uint16_t fanout_group_id = (getpid() + port_) & 0xFFFF;
+  for (int i = 0; i < num_rings; i++) {
+    rings_.push_back(std::unique_ptr<packet_ring>(
+        new packet_ring(if_name, fanout_group_id, 0)));
+    std::thread t = std::thread(
+        &udp_server::packet_ring_loop, this, rings_.back().get(),
+        sched_params);
+    t.detach();
     threads_.push_back(std::move(t));
   }
-  std::thread t = std::thread(&udp_server::udp_read_loop, this, sched_params);
-  t.detach();
-  threads_.push_back(std::move(t));
 }
 //------------------------------------------------------------------------------
 void udp_server::stop(void) {
-  for (int i = 0; i < num_threads_; i++) {
-    udp_packet_q_item_t* p =
-        (udp_packet_q_item_t*) calloc(1, sizeof(udp_packet_q_item_t));
-    work_pool_->blockingWrite(p);
-  }
-  udp_packet_q_item_t* p =
-      (udp_packet_q_item_t*) calloc(1, sizeof(udp_packet_q_item_t));
-  free_pool_->blockingWrite(p);
+  udp_io_counters_t c = {};
+  get_io_counters(c);
+  Logger::udp().info(
+      "udp_server port %" PRIu16 " rx %" PRIu64 " packets in %" PRIu64
+      " syscalls, tx %" PRIu64 " packets in %" PRIu64 " syscalls, %" PRIu64
+      " dropped",
+      port_, c.rx_packets, c.rx_syscalls, c.tx_packets, c.tx_syscalls,
+      c.tx_dropped);
+  for (auto& ring : rings_) {
+    Logger::udp().info(
+        "udp_server port %" PRIu16 " packet ring dropped %" PRIu64 " frames",
+        port_, ring->get_rx_drops());
+    ring->stop();
+  }
+  running_ = false;
+  // Wake up the shard threads blocked in recvmmsg
+  for (auto& shard : shards_) {
+    shutdown(shard.socket, SHUT_RD);
+  }
 }
@@ -31,13 +31,16 @@
 #include "conversions.hpp"
 #include "endpoint.hpp"
 #include "itti.hpp"
+#include "packet_pool.hpp"
+#include "packet_ring.hpp"
 #include "thread_sched.hpp"
 
-#include <folly/MPMCQueue.h>
 #include <arpa/inet.h>
 #include <inttypes.h>
 #include <sys/socket.h>
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -53,6 +56,9 @@ class udp_application {
   virtual void handle_receive(
       char* recv_buffer, const std::size_t bytes_transferred,
       const endpoint& r_endpoint);
+  // The datagrams read so far were handled, called by the receive thread
+  // before it waits for more
+  virtual void handle_receive_end() {}
   virtual void start_receive(
       udp_application* gtp_stack,
       const util::thread_sched_params& sched_params);
@@ -61,19 +67,68 @@ class udp_server;
 
 typedef struct udp_packet_q_item_s {
   char* buffer;
+  // If buffer is in a buffer of util::packet_pool
+  util::packet_buf_t* pbuf;
   endpoint r_endpoint;
   size_t size;
 } udp_packet_q_item_t;
 
+// One receive pipeline: its own SO_REUSEPORT socket, its own buffers and one
+// thread that processes what it reads to completion
+typedef struct udp_shard_s {
+  int socket;
+  // Buffers of util::packet_pool if requested, allocated by the shard thread
+  // on its NUMA node, otherwise allocated here
+  bool packet_pool;
+  char* recv_buffer_alloc;
+  std::size_t recv_buffer_size;
+  std::vector<udp_packet_q_item_t> items;
+} udp_shard_t;
+
+// Upper bound for recvmmsg/sendmmsg batches (IO_BATCH_SIZE in config)
+#define UDP_MAX_IO_BATCH_SIZE 64
+// Datagrams bigger than this bypass the TX batch and are sent at once
+#define UDP_SEND_BATCH_BUFFER_SIZE 2048
+// udp_servers that get a TX batch per sender thread, the others send at once
+#define UDP_MAX_BATCHED_SERVERS 8
+
+// Outgoing datagrams of one sender thread, flushed with a single sendmmsg.
+// A datagram in a util::packet_pool buffer is not copied, the batch holds a
+// reference on the buffer until sent.
+typedef struct udp_send_batch_s {
+  struct mmsghdr msgs[UDP_MAX_IO_BATCH_SIZE];
+  struct iovec iovs[UDP_MAX_IO_BATCH_SIZE];
+  struct sockaddr_storage addrs[UDP_MAX_IO_BATCH_SIZE];
+  util::packet_buf_t* pbufs[UDP_MAX_IO_BATCH_SIZE];
+  char buffers[UDP_MAX_IO_BATCH_SIZE][UDP_SEND_BATCH_BUFFER_SIZE];
+  unsigned int count;
+  std::chrono::steady_clock::time_point first_queued;
+} udp_send_batch_t;
+
+typedef struct udp_io_counters_s {
+  uint64_t rx_syscalls;
+  uint64_t rx_packets;
+  uint64_t tx_syscalls;
+  uint64_t tx_packets;
+  uint64_t tx_dropped;
+} udp_io_counters_t;
+
 class udp_server {
 #define UDP_RECV_BUFFER_SIZE 8192
  public:
   udp_server(const struct in_addr& address, const uint16_t port_num)
       : app_(nullptr),
         port_(port_num),
-        num_threads_(1),
-        free_pool_(nullptr),
-        work_pool_(nullptr) {
+        running_(false),
+        io_batch_size_(1),
+        io_flush_deadline_(0),
+        rx_syscalls_(0),
+        rx_packets_(0),
+        tx_syscalls_(0),
+        tx_packets_(0),
+        tx_dropped_(0),
+        tx_drop_logged_(-1),
+        id_(next_id_.fetch_add(1)) {
     socket_ = create_socket(address, port_);
     if (socket_ > 0) {
       Logger::udp().debug(
@@ -93,8 +148,16 @@ class udp_server {
   udp_server(const struct in6_addr& address, const uint16_t port_num)
       : app_(nullptr),
         port_(port_num),
-        free_pool_(nullptr),
-        work_pool_(nullptr) {
+        running_(false),
+        io_batch_size_(1),
+        io_flush_deadline_(0),
+        rx_syscalls_(0),
+        rx_packets_(0),
+        tx_syscalls_(0),
+        tx_packets_(0),
+        tx_dropped_(0),
+        tx_drop_logged_(-1),
+        id_(next_id_.fetch_add(1)) {
     socket_ = create_socket(address, port_);
     if (socket_ > 0) {
       Logger::udp().debug(
@@ -114,8 +177,16 @@ class udp_server {
   udp_server(const char* address, const uint16_t port_num)
       : app_(nullptr),
         port_(port_num),
-        free_pool_(nullptr),
-        work_pool_(nullptr) {
+        running_(false),
+        io_batch_size_(1),
+        io_flush_deadline_(0),
+        rx_syscalls_(0),
+        rx_packets_(0),
+        tx_syscalls_(0),
+        tx_packets_(0),
+        tx_dropped_(0),
+        tx_drop_logged_(-1),
+        id_(next_id_.fetch_add(1)) {
     socket_ = create_socket(address, port_);
     if (socket_ > 0) {
       Logger::udp().debug("udp_server::udp_server(%s:%d)", address, port_);
@@ -128,16 +199,17 @@ class udp_server {
   }
 
   ~udp_server() {
+    for (auto& shard : shards_) {
+      if (shard.socket != socket_) close(shard.socket);
+      free(shard.recv_buffer_alloc);
+      for (auto& item : shard.items) {
+        if (item.pbuf) util::packet_pool::get_instance().release(item.pbuf);
+      }
+    }
     close(socket_);
-    // TODO delete/release elements in  the pool
-    delete free_pool_;
-    delete work_pool_;
-    free(recv_buffer_alloc_);
-    // free(udp_packet_q_item_alloc_);
   }
 
-  void udp_read_loop(const util::thread_sched_params& thread_sched_params);
-  void udp_worker_loop(
+  void udp_shard_loop(
       const int id, const util::thread_sched_params& sched_params);
 
   void async_send_to(
@@ -147,8 +219,11 @@ class udp_server {
         socket_, send_buffer, num_bytes, 0,
         (struct sockaddr*) &r_endpoint.addr_storage,
         r_endpoint.addr_storage_len);
+    tx_syscalls_.fetch_add(1, std::memory_order_relaxed);
     if (bytes_written != num_bytes) {
-      Logger::udp().error("sendto failed(%d:%s)\n", errno, strerror(errno));
+      tx_dropped(1, errno);
+    } else {
+      tx_packets_.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
@@ -158,8 +233,11 @@ class udp_server {
     ssize_t bytes_written = sendto(
         socket_, send_buffer, num_bytes, 0, (struct sockaddr*) &r_endpoint,
         sizeof(struct sockaddr_in));
+    tx_syscalls_.fetch_add(1, std::memory_order_relaxed);
     if (bytes_written != num_bytes) {
-      Logger::udp().error("sendto failed(%d:%s)\n", errno, strerror(errno));
+      tx_dropped(1, errno);
+    } else {
+      tx_packets_.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
@@ -169,13 +247,50 @@ class udp_server {
     ssize_t bytes_written = sendto(
         socket_, send_buffer, num_bytes, 0, (struct sockaddr*) &r_endpoint,
         sizeof(struct sockaddr_in6));
+    tx_syscalls_.fetch_add(1, std::memory_order_relaxed);
     if (bytes_written != num_bytes) {
-      Logger::udp().error("sendto failed(%d:%s)\n", errno, strerror(errno));
+      tx_dropped(1, errno);
+    } else {
+      tx_packets_.fetch_add(1, std::memory_order_relaxed);
     }
   }
 
+  // Queue a datagram in the TX batch of the calling thread, the batch is
+  // flushed with sendmmsg when full or when its flush deadline expired.
+  // Without batching (io_batch_size == 1) it is equivalent to async_send_to.
+  // If send_buffer is in pbuf, the batch holds a reference on pbuf instead
+  // of copying the datagram: the caller must not write in pbuf anymore if
+  // it is still referenced (refcnt > 1) after the call.
+  void batch_send_to(
+      const char* send_buffer, const ssize_t num_bytes,
+      const struct sockaddr_in& r_endpoint,
+      util::packet_buf_t* const pbuf = nullptr);
+  void batch_send_to(
+      const char* send_buffer, const ssize_t num_bytes,
+      const struct sockaddr_in6& r_endpoint,
+      util::packet_buf_t* const pbuf = nullptr);
+  // Flush the TX batch of the calling thread, to be called before blocking
+  void flush_send_batch();
+
+  void get_io_counters(udp_io_counters_t& counters) const;
+  // Sockets of the receive shards, the first one also sends. None if the
+  // datagrams are read from packet rings.
+  void get_receive_sockets(std::vector<int>& sockets) const;
+
+  // Start thread_pool_size receive shards. If steering_key_offset >= 0,
+  // datagrams are steered to shard (32-bit word at this offset in the UDP
+  // payload) % shards, otherwise the kernel SO_REUSEPORT hash is used.
+  // With packet_pool, datagrams are read in util::packet_pool buffers if the
+  // pool is initialized, they are then at most PACKET_POOL_DATA_ROOM bytes.
   void start_receive(
       udp_application* gtp_stack,
+      const util::thread_sched_params& sched_params,
+      const int steering_key_offset = -1, const bool packet_pool = false);
+  // Receive from TPACKET_V3 rings bound to if_name instead of the socket, one
+  // ring and one run-to-completion thread per thread_pool_size. The socket is
+  // still used for sending.
+  void start_receive_packet_ring(
+      udp_application* gtp_stack, const std::string& if_name,
       const util::thread_sched_params& sched_params);
   void stop(void);
 
@@ -190,17 +305,51 @@ class udp_server {
       const char*, /*buffer*/
       const int& /*error*/, std::size_t /*bytes_transferred*/) {}
 
-  // Should be in non swapable memory
-  folly::MPMCQueue<udp_packet_q_item_t*>* free_pool_;
-  folly::MPMCQueue<udp_packet_q_item_t*>* work_pool_;
-  uint32_t num_threads_;
-  char* recv_buffer_alloc_;
-  // udp_packet_q_item_t *udp_packet_q_item_alloc_;
+  void packet_ring_loop(
+      packet_ring* ring, const util::thread_sched_params& sched_params);
+  void handle_ring_packet(char* l3_packet, const std::size_t num_bytes);
+
+  udp_send_batch_t* get_send_batch(const bool create);
+  void queue_in_send_batch(
+      const char* send_buffer, const ssize_t num_bytes,
+      const struct sockaddr* r_endpoint, const socklen_t r_endpoint_len,
+      util::packet_buf_t* const pbuf);
+  // By the shard thread, from util::packet_pool if requested and if it has
+  // enough buffers left
+  void alloc_shard_buffers(const int id, udp_shard_t& shard);
+  void flush_send_batch(udp_send_batch_t& batch);
+  // Count datagrams that could not be sent, log at most once per second
+  void tx_dropped(const unsigned int num_datagrams, const int err);
+
+  int attach_reuseport_steering(
+      const int steering_key_offset, const unsigned int num_shards);
+
+  std::vector<udp_shard_t> shards_;
+  std::atomic<bool> running_;
   udp_application* app_;
   std::vector<std::thread> threads_;
   int socket_;
   uint16_t port_;
   sa_family_t sa_family;
+  // Bound address, needed to filter what is read from packet rings
+  struct in_addr local_addr4_;
+  struct in6_addr local_addr6_;
+  std::vector<std::unique_ptr<packet_ring>> rings_;
+
+  unsigned int io_batch_size_;
+  std::chrono::microseconds io_flush_deadline_;
+  // UL (rx) and DL (tx) syscall and datagram counters
+  std::atomic<uint64_t> rx_syscalls_;
+  std::atomic<uint64_t> rx_packets_;
+  std::atomic<uint64_t> tx_syscalls_;
+  std::atomic<uint64_t> tx_packets_;
+  std::atomic<uint64_t> tx_dropped_;
+  // Second (steady clock) of the last drop log
+  std::atomic<int64_t> tx_drop_logged_;
+
+  // Index of the TX batches of this server in the per thread array
+  const unsigned int id_;
+  static std::atomic<unsigned int> next_id_;
 };
 
 #endif /* FILE_UDP_HPP_SEEN */